@@ -23,6 +23,10 @@
 
 #include <math/mat4.h>
 
+#include <vector>
+
+#include "common/NioUtils.h"
+
 using namespace utils;
 using namespace filament;
 
@@ -196,6 +200,52 @@ Java_com_google_android_filament_TransformManager_nGetWorldTransformFp64(JNIEnv*
     env->ReleaseDoubleArrayElements(outWorldTransform_, outWorldTransform, 0);
 }
 
+extern "C" JNIEXPORT jint JNICALL
+Java_com_google_android_filament_TransformManager_nSetTransforms(JNIEnv* env,
+        jclass, jlong nativeTransformManager, jintArray instances_, jobject localTransforms,
+        jint remaining, jint count) {
+    TransformManager* tm = (TransformManager*) nativeTransformManager;
+    AutoBuffer nioBuffer(env, localTransforms, count * 16);
+    size_t sizeInBytes = nioBuffer.getSize();
+    if (sizeInBytes > (remaining << nioBuffer.getShift()) ||
+            env->GetArrayLength(instances_) < count) {
+        // BufferOverflowException
+        return -1;
+    }
+    auto const* localTransforms_ =
+            static_cast<filament::math::mat4f const*>(nioBuffer.getData());
+    jint* instances = env->GetIntArrayElements(instances_, NULL);
+    std::vector<TransformManager::Instance> nativeInstances(count);
+    for (jint j = 0; j < count; j++) {
+        nativeInstances[j] = (TransformManager::Instance) instances[j];
+    }
+    env->ReleaseIntArrayElements(instances_, instances, JNI_ABORT);
+    // setTransforms() propagates once, or defers to the caller's transaction if one is open
+    tm->setTransforms(nativeInstances.data(), localTransforms_, size_t(count));
+    return 0;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_google_android_filament_TransformManager_nGetWorldTransforms(JNIEnv* env,
+        jclass, jlong nativeTransformManager, jintArray instances_, jobject outWorldTransforms,
+        jint remaining, jint count) {
+    TransformManager* tm = (TransformManager*) nativeTransformManager;
+    AutoBuffer nioBuffer(env, outWorldTransforms, count * 16, true);
+    size_t sizeInBytes = nioBuffer.getSize();
+    if (sizeInBytes > (remaining << nioBuffer.getShift()) ||
+            env->GetArrayLength(instances_) < count) {
+        // BufferOverflowException
+        return -1;
+    }
+    auto* outWorldTransforms_ = static_cast<filament::math::mat4f*>(nioBuffer.getData());
+    jint* instances = env->GetIntArrayElements(instances_, NULL);
+    for (jint j = 0; j < count; j++) {
+        outWorldTransforms_[j] = tm->getWorldTransform((TransformManager::Instance) instances[j]);
+    }
+    env->ReleaseIntArrayElements(instances_, instances, JNI_ABORT);
+    return 0;
+}
+
 extern "C" JNIEXPORT void JNICALL
 Java_com_google_android_filament_TransformManager_nOpenLocalTransformTransaction(
         JNIEnv*, jclass, jlong nativeTransformManager) {
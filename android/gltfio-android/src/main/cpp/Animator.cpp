@@ -18,6 +18,8 @@
 
 #include <gltfio/Animator.h>
 
+#include <vector>
+
 using namespace filament;
 using namespace filament::math;
 using namespace filament::gltfio;
@@ -36,6 +38,34 @@ Java_com_google_android_filament_gltfio_Animator_nUpdateBoneMatrices(JNIEnv*, jc
     animator->updateBoneMatrices();
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_google_android_filament_gltfio_Animator_nApplyAnimations(JNIEnv* env, jclass,
+        jlongArray nativeAnimators, jintArray indices_, jfloatArray times_, jint count) {
+    jlong* animators = env->GetLongArrayElements(nativeAnimators, nullptr);
+    jint* indices = env->GetIntArrayElements(indices_, nullptr);
+    jfloat* times = env->GetFloatArrayElements(times_, nullptr);
+    std::vector<Animator::AnimationState> states(count);
+    for (jint i = 0; i < count; i++) {
+        states[i] = { (Animator*) animators[i], static_cast<size_t>(indices[i]), times[i] };
+    }
+    env->ReleaseFloatArrayElements(times_, times, JNI_ABORT);
+    env->ReleaseIntArrayElements(indices_, indices, JNI_ABORT);
+    env->ReleaseLongArrayElements(nativeAnimators, animators, JNI_ABORT);
+    Animator::applyAnimations(states.data(), states.size());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_google_android_filament_gltfio_Animator_nUpdateBoneMatricesBatch(JNIEnv* env, jclass,
+        jlongArray nativeAnimators, jint count) {
+    jlong* animators = env->GetLongArrayElements(nativeAnimators, nullptr);
+    std::vector<Animator*> list(count);
+    for (jint i = 0; i < count; i++) {
+        list[i] = (Animator*) animators[i];
+    }
+    env->ReleaseLongArrayElements(nativeAnimators, animators, JNI_ABORT);
+    Animator::updateBoneMatrices(list.data(), list.size());
+}
+
 extern "C" JNIEXPORT void JNICALL
 Java_com_google_android_filament_gltfio_Animator_nApplyCrossFade(JNIEnv*, jclass, jlong nativeAnimator,
         jint previousAnimIndex, jfloat previousAnimTime, jfloat alpha) {
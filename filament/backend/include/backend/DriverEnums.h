@@ -693,6 +693,7 @@ enum class TextureUsage : uint16_t {
     BLIT_SRC            = 0x0040,            //!< Texture can be used the source of a blit()
     BLIT_DST            = 0x0080,            //!< Texture can be used the destination of a blit()
     PROTECTED           = 0x0100,            //!< Texture can be used for protected content
+    TRANSIENT_ATTACHMENT= 0x0200,            //!< Attachment content never outlives a render pass
     DEFAULT             = UPLOADABLE | SAMPLEABLE   //!< Default texture usage
 };
 
@@ -1159,6 +1160,21 @@ struct RenderPassParams {
     static constexpr uint16_t READONLY_STENCIL = 1 << 1;
 };
 
+/**
+ * Parameters of one indexed draw, as read by DriverApi::drawIndirect() from a SHADER_STORAGE
+ * buffer object. The layout matches the indirect draw commands of all backends.
+ */
+struct DrawIndexedIndirectCommand {
+    uint32_t indexCount;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    uint32_t baseInstance;
+};
+
+static_assert(sizeof(DrawIndexedIndirectCommand) == 20,
+        "DrawIndexedIndirectCommand must be tightly packed");
+
 struct PolygonOffset {
     float slope = 0;        // factor in GL-speak
     float constant = 0;     // units in GL-speak
@@ -1249,10 +1265,57 @@ enum class Workaround : uint16_t {
     DISABLE_BLIT_INTO_TEXTURE_ARRAY,
     // Multiple workarounds needed for PowerVR GPUs
     POWER_VR_SHADER_WORKAROUNDS,
+    // Color grading as a subpass of the TAA pass is slower than a separate pass on Adreno GPUs.
+    DISABLE_TAA_COLOR_GRADING_SUBPASS,
 };
 
 using StereoscopicType = backend::Platform::StereoscopicType;
 
+/**
+ * Number of state changes that the backend issued during a frame, by category, and number of
+ * the ones it skipped because they wouldn't have changed the current state.
+ */
+struct StateChangeStats {
+    enum class Category : uint8_t {
+        PROGRAM,        //!< program bindings
+        VERTEX_ARRAY,   //!< vertex array object bindings
+        TEXTURE,        //!< texture bindings, including active texture unit changes
+        SAMPLER,        //!< sampler object bindings
+        BUFFER,         //!< buffer bindings
+        FRAMEBUFFER,    //!< framebuffer bindings
+        RASTER,         //!< enables, culling, blending, depth and stencil states
+        VIEWPORT,       //!< viewport, scissor and depth range
+        UNIFORM,        //!< uniform uploads
+    };
+    static constexpr size_t CATEGORY_COUNT = size_t(Category::UNIFORM) + 1;
+
+    uint32_t issued[CATEGORY_COUNT] = {};
+    uint32_t redundant[CATEGORY_COUNT] = {};
+
+    uint32_t getIssued(Category category) const noexcept { return issued[size_t(category)]; }
+    uint32_t getRedundant(Category category) const noexcept { return redundant[size_t(category)]; }
+};
+
+/**
+ * Occupancy of the backend's handle arena. Handles are allocated from one of three pools,
+ * depending on the size of the backend object; when its pool is full, a handle is allocated on
+ * the system heap instead, which is slower.
+ */
+struct HandleAllocatorStats {
+    static constexpr size_t POOL_COUNT = 3;
+
+    struct Pool {
+        uint32_t size = 0;                  //!< size of the handles of this pool, in bytes
+        uint32_t capacity = 0;              //!< number of handles that fit in the pool
+        uint32_t count = 0;                 //!< number of handles currently in the pool
+        uint32_t highWatermark = 0;         //!< largest value of count
+        uint32_t heapCount = 0;             //!< number of handles currently on the heap
+        uint32_t heapAllocationCount = 0;   //!< total number of handles allocated on the heap
+    };
+
+    Pool pools[POOL_COUNT] = {};            //!< from the smallest to the largest handles
+};
+
 } // namespace filament::backend
 
 template<> struct utils::EnableBitMaskOperators<filament::backend::ShaderStageFlags>
@@ -96,6 +96,31 @@ public:
          * Sets the technique for stereoscopic rendering.
          */
         StereoscopicType stereoscopicType = StereoscopicType::NONE;
+
+        /**
+         * Set to `true` to create pipelines on worker threads. Draw calls that need a pipeline
+         * that isn't ready yet are skipped. Currently only honored by the Vulkan backend.
+         */
+        bool asynchronousPipelineCreation = false;
+
+        /**
+         * Number of most recently used program binaries that are loaded from the blob cache at
+         * startup. Currently only honored by the GL backend.
+         */
+        uint32_t programCachePrewarmCount = 0;
+
+        /**
+         * Number of shader compiler threads, 0 lets the backend decide. Currently only honored
+         * by the GL backend.
+         */
+        uint32_t shaderCompilerThreadCount = 0;
+
+        /**
+         * Relative number of handles in each of the three pools of the handle arena, from the
+         * pool of the smallest handles to the pool of the largest. 0 means 1. By default, each
+         * pool can hold the same number of handles.
+         */
+        uint8_t handleArenaPoolWeights[3] = { 1, 1, 1 };
     };
 
     Platform() noexcept;
@@ -207,6 +207,33 @@ public:
      */
     virtual ExtensionSet getRequiredInstanceExtensions() { return {}; }
 
+    /**
+     * An image imported from a platform-specific buffer, such as an AHardwareBuffer on Android.
+     * The memory aliases the buffer's storage, so no copy takes place. The caller owns both the
+     * image and the memory.
+     */
+    struct ExternalImage {
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        // Queue family that owns the image when it is imported, e.g. VK_QUEUE_FAMILY_FOREIGN_EXT
+        // for images produced outside of Vulkan, and the layout it was left in by that owner.
+        uint32_t queueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    };
+
+    /**
+     * Imports the given external image without copying it.
+     * Formats that can only be sampled through a sampler YCbCr conversion are not supported yet.
+     * @param externalImage  The platform-specific image, e.g. an AHardwareBuffer* on Android.
+     * @return               The imported image, whose `image` is VK_NULL_HANDLE if the platform
+     *                       or the image's format is not supported. Only Android supports
+     *                       external images.
+     */
+    virtual ExternalImage createExternalImage(void* externalImage) noexcept;
+
     /**
      * Destroy the swapchain.
      * @param handle    The handle returned by createSwapChain()
@@ -250,6 +277,17 @@ public:
      */
     VkQueue getGraphicsQueue() const noexcept;
 
+    /**
+     * @return The family index of the dedicated transfer queue, or 0xFFFFFFFF if the
+     *         device doesn't have one or the context is shared.
+     */
+    uint32_t getTransferQueueFamilyIndex() const noexcept;
+
+    /**
+     * @return The dedicated transfer queue used for uploads, or VK_NULL_HANDLE if there is none.
+     */
+    VkQueue getTransferQueue() const noexcept;
+
 private:
     static ExtensionSet getSwapchainInstanceExtensions();
 
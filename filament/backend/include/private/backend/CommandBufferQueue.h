@@ -49,6 +49,8 @@ class CommandBufferQueue {
     mutable std::vector<Range> mCommandBuffersToExecute;
     size_t mFreeSpace = 0;
     size_t mHighWatermark = 0;
+    uint64_t mFlushStallDuration = 0;
+    mutable uint64_t mWaitForCommandsDuration = 0;
     uint32_t mExitRequested = 0;
     bool mPaused = false;
 
@@ -64,8 +66,15 @@ public:
 
     size_t getCapacity() const noexcept { return mRequiredSize; }
 
+    // largest amount of memory used by commands not yet executed, in bytes
     size_t getHighWatermark() const noexcept { return mHighWatermark; }
 
+    // total time flush() blocked waiting for the consumer to free space, in nanoseconds
+    uint64_t getFlushStallDuration() const noexcept;
+
+    // total time waitForCommands() blocked waiting for commands, in nanoseconds
+    uint64_t getWaitForCommandsDuration() const noexcept;
+
     // wait for commands to be available and returns an array containing these commands
     std::vector<Range> waitForCommands() const;
 
@@ -17,6 +17,7 @@
 #ifndef TNT_FILAMENT_BACKEND_PRIVATE_HANDLEALLOCATOR_H
 #define TNT_FILAMENT_BACKEND_PRIVATE_HANDLEALLOCATOR_H
 
+#include <backend/DriverEnums.h>
 #include <backend/Handle.h>
 
 #include <utils/Allocator.h>
@@ -28,6 +29,7 @@
 
 #include <tsl/robin_map.h>
 
+#include <atomic>
 #include <cstddef>
 #include <exception>
 #include <type_traits>
@@ -49,7 +51,10 @@ namespace filament::backend {
 template<size_t P0, size_t P1, size_t P2>
 class HandleAllocator {
 public:
-    HandleAllocator(const char* name, size_t size, bool disableUseAfterFreeCheck) noexcept;
+    // poolWeights, if not null, gives the relative number of handles of each pool (see
+    // Platform::DriverConfig::handleArenaPoolWeights)
+    HandleAllocator(const char* name, size_t size, bool disableUseAfterFreeCheck,
+            uint8_t const* poolWeights = nullptr) noexcept;
     HandleAllocator(HandleAllocator const& rhs) = delete;
     HandleAllocator& operator=(HandleAllocator const& rhs) = delete;
     ~HandleAllocator();
@@ -189,6 +194,12 @@ public:
         return handle_cast<Dp>(const_cast<Handle<B>&>(handle));
     }
 
+    /*
+     * Returns the occupancy of each pool and how many of its handles went to the heap.
+     * This can be called from any thread.
+     */
+    HandleAllocatorStats getStats() const noexcept;
+
 private:
 
     template<typename D>
@@ -199,6 +210,10 @@ private:
         return P2;
     }
 
+    static constexpr size_t getPoolIndex(size_t size) noexcept {
+        return size <= P0 ? 0 : (size <= P1 ? 1 : 2);
+    }
+
     class Allocator {
         friend class HandleAllocator;
         static constexpr size_t MIN_ALIGNMENT = alignof(std::max_align_t);
@@ -212,8 +227,32 @@ private:
         Pool<P2> mPool2;
         UTILS_UNUSED_IN_RELEASE const utils::AreaPolicy::HeapArea& mArea;
         bool mUseAfterFreeCheckDisabled;
+
+        // These are only modified under the arena's lock, but they're read without it by
+        // getStats().
+        struct PoolCounters {
+            uint32_t capacity = 0;
+            std::atomic<uint32_t> count{ 0 };
+            std::atomic<uint32_t> highWatermark{ 0 };
+        };
+        PoolCounters mCounters[3];
+
+        inline void onAlloc(PoolCounters& counters) noexcept {
+            uint32_t const count = counters.count.load(std::memory_order_relaxed) + 1;
+            counters.count.store(count, std::memory_order_relaxed);
+            if (count > counters.highWatermark.load(std::memory_order_relaxed)) {
+                counters.highWatermark.store(count, std::memory_order_relaxed);
+            }
+        }
+
+        inline void onFree(PoolCounters& counters) noexcept {
+            counters.count.store(counters.count.load(std::memory_order_relaxed) - 1,
+                    std::memory_order_relaxed);
+        }
+
     public:
-        explicit Allocator(const utils::AreaPolicy::HeapArea& area, bool disableUseAfterFreeCheck);
+        Allocator(const utils::AreaPolicy::HeapArea& area, bool disableUseAfterFreeCheck,
+                uint8_t const* poolWeights);
 
         static constexpr size_t getAlignment() noexcept { return MIN_ALIGNMENT; }
 
@@ -224,6 +263,7 @@ private:
             else if (size <= mPool1.getSize()) p = mPool1.alloc(size);
             else if (size <= mPool2.getSize()) p = mPool2.alloc(size);
             if (UTILS_LIKELY(p)) {
+                onAlloc(mCounters[getPoolIndex(size)]);
                 Node const* const pNode = static_cast<Node const*>(p);
                 // we are guaranteed to have at least sizeof<Node> bytes of extra storage before
                 // the allocation address.
@@ -245,6 +285,7 @@ private:
             }
             expectedAge = (expectedAge + 1) & 0xF; // fixme
 
+            onFree(mCounters[getPoolIndex(size)]);
             if (size <= mPool0.getSize()) { mPool0.free(p); return; }
             if (size <= mPool1.getSize()) { mPool1.free(p); return; }
             if (size <= mPool2.getSize()) { mPool2.free(p); return; }
@@ -352,6 +393,9 @@ private:
     mutable utils::Mutex mLock;
     tsl::robin_map<HandleBase::HandleId, void*> mOverflowMap;
     HandleBase::HandleId mId = 0;
+    // number of handles of each pool currently on the heap, and in total, protected by mLock
+    uint32_t mHeapCount[3] = {};
+    uint32_t mHeapAllocationCount[3] = {};
     bool mUseAfterFreeCheckDisabled = false;
 };
 
@@ -16,6 +16,8 @@
 
 #include "BlobCacheKey.h"
 
+#include <utils/debug.h>
+
 #include <memory>
 
 namespace filament::backend {
@@ -41,6 +43,14 @@ BlobCacheKey::BlobCacheKey(uint64_t id,
     }
 }
 
+BlobCacheKey::BlobCacheKey(void const* data, size_t size) {
+    assert_invariant(size >= sizeof(Key));
+    Key* const pKey = (Key *)malloc(size);
+    memcpy(pKey, data, size);
+    mData.reset(pKey, ::free);
+    mSize = size;
+}
+
 BlobCacheKey::BlobCacheKey(BlobCacheKey&& rhs) noexcept
         : mData(std::move(rhs.mData)), mSize(rhs.mSize) {
     rhs.mSize = 0;
@@ -19,6 +19,11 @@
 
 #include <backend/Program.h>
 
+#include <memory>
+
+#include <stddef.h>
+#include <string.h>
+
 namespace filament::backend {
 
 class BlobCacheKey {
@@ -28,6 +33,9 @@ public:
     BlobCacheKey() noexcept;
     BlobCacheKey(uint64_t id, SpecializationConstants const& specConstants);
 
+    // Creates a key from the bytes returned by data() and size() of another key.
+    BlobCacheKey(void const* data, size_t size);
+
     BlobCacheKey(BlobCacheKey const& rhs) = default;
     BlobCacheKey& operator=(BlobCacheKey const& rhs) = default;
 
@@ -44,6 +52,10 @@ public:
 
     explicit operator bool() const noexcept { return mSize > 0; }
 
+    bool operator==(BlobCacheKey const& rhs) const noexcept {
+        return mSize == rhs.mSize && (mData == rhs.mData || !memcmp(data(), rhs.data(), mSize));
+    }
+
     void swap(BlobCacheKey& other) noexcept {
         using std::swap;
         swap(other.mSize, mSize);
@@ -27,6 +27,7 @@
 #include <utils/debug.h>
 
 #include <algorithm>
+#include <chrono>
 #include <mutex>
 #include <iterator>
 #include <utility>
@@ -114,18 +115,17 @@ void CommandBufferQueue::flush() noexcept {
 
     // wait until there is enough space in the buffer
     mFreeSpace -= used;
+    size_t const totalUsed = circularBuffer.size() - mFreeSpace;
+    mHighWatermark = std::max(mHighWatermark, totalUsed);
     if (UTILS_UNLIKELY(mFreeSpace < requiredSize)) {
 
 
 #ifndef NDEBUG
-        size_t const totalUsed = circularBuffer.size() - mFreeSpace;
         slog.d << "CommandStream used too much space (will block): "
                 << "needed space " << requiredSize << " out of " << mFreeSpace
                 << ", totalUsed=" << totalUsed << ", current=" << used
                 << ", queue size=" << mCommandBuffersToExecute.size() << " buffers"
                 << io::endl;
-
-        mHighWatermark = std::max(mHighWatermark, totalUsed);
 #endif
 
         SYSTRACE_NAME("waiting: CircularBuffer::flush()");
@@ -134,20 +134,38 @@ void CommandBufferQueue::flush() noexcept {
                 "CommandStream is full, but since the rendering thread is paused, "
                 "the buffer cannot flush and we will deadlock. Instead, abort.";
 
+        auto const start = std::chrono::steady_clock::now();
         mCondition.wait(lock, [this, requiredSize]() -> bool {
             // TODO: on macOS, we need to call pumpEvents from time to time
             return mFreeSpace >= requiredSize;
         });
+        mFlushStallDuration += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
     }
 }
 
+uint64_t CommandBufferQueue::getFlushStallDuration() const noexcept {
+    std::lock_guard<utils::Mutex> const lock(mLock);
+    return mFlushStallDuration;
+}
+
+uint64_t CommandBufferQueue::getWaitForCommandsDuration() const noexcept {
+    std::lock_guard<utils::Mutex> const lock(mLock);
+    return mWaitForCommandsDuration;
+}
+
 std::vector<CommandBufferQueue::Range> CommandBufferQueue::waitForCommands() const {
     if (!UTILS_HAS_THREADING) {
         return std::move(mCommandBuffersToExecute);
     }
     std::unique_lock<utils::Mutex> lock(mLock);
-    while ((mCommandBuffersToExecute.empty() || mPaused) && !mExitRequested) {
-        mCondition.wait(lock);
+    if ((mCommandBuffersToExecute.empty() || mPaused) && !mExitRequested) {
+        auto const start = std::chrono::steady_clock::now();
+        while ((mCommandBuffersToExecute.empty() || mPaused) && !mExitRequested) {
+            mCondition.wait(lock);
+        }
+        mWaitForCommandsDuration += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
     }
     return std::move(mCommandBuffersToExecute);
 }
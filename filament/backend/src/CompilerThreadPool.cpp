@@ -18,6 +18,7 @@
 
 #include <utils/Systrace.h>
 
+#include <algorithm>
 #include <memory>
 
 namespace filament::backend {
@@ -30,8 +31,8 @@ CompilerThreadPool::CompilerThreadPool() noexcept = default;
 
 CompilerThreadPool::~CompilerThreadPool() noexcept {
     assert_invariant(mCompilerThreads.empty());
-    assert_invariant(mQueues[0].empty());
-    assert_invariant(mQueues[1].empty());
+    assert_invariant(std::all_of(mQueues.begin(), mQueues.end(),
+            [](auto&& q) { return q.empty(); }));
 }
 
 void CompilerThreadPool::init(uint32_t threadCount,
@@ -55,7 +56,7 @@ void CompilerThreadPool::init(uint32_t threadCount,
                 });
 
                 SYSTRACE_VALUE32("CompilerThreadPool Jobs",
-                        mQueues[0].size() + mQueues[1].size());
+                        mQueues[0].size() + mQueues[1].size() + mQueues[BACKGROUND_QUEUE].size());
 
                 if (UTILS_LIKELY(!mExitRequested)) {
                     Job job;
@@ -115,6 +116,12 @@ void CompilerThreadPool::queue(CompilerPriorityQueue priorityQueue,
     mQueueCondition.notify_one();
 }
 
+void CompilerThreadPool::queueBackground(Job&& job) {
+    std::unique_lock const lock(mQueueLock);
+    mQueues[BACKGROUND_QUEUE].emplace_back(nullptr, std::move(job));
+    mQueueCondition.notify_one();
+}
+
 void CompilerThreadPool::terminate() noexcept {
     std::unique_lock lock(mQueueLock);
     mExitRequested = true;
@@ -51,6 +51,9 @@ public:
             ThreadSetup&& threadSetup, ThreadCleanup&& threadCleanup) noexcept;
     void terminate() noexcept;
     void queue(CompilerPriorityQueue priorityQueue, program_token_t const& token, Job&& job);
+    // Queues a job that only runs when there is nothing in the priority queues, e.g. to prepare
+    // programs that might be needed later. These jobs can't be dequeued.
+    void queueBackground(Job&& job);
     Job dequeue(program_token_t const& token);
 
 private:
@@ -59,7 +62,9 @@ private:
     bool mExitRequested{ false };
     utils::Mutex mQueueLock;
     utils::Condition mQueueCondition;
-    std::array<Queue, 2> mQueues;
+    // one queue per CompilerPriorityQueue, followed by the background queue
+    static constexpr size_t BACKGROUND_QUEUE = 2;
+    std::array<Queue, BACKGROUND_QUEUE + 1> mQueues;
     // lock must be held for methods below
     std::pair<Queue&, Queue::iterator> find(program_token_t const& token);
 };
@@ -40,7 +40,7 @@ using namespace utils;
 template <size_t P0, size_t P1, size_t P2>
 UTILS_NOINLINE
 HandleAllocator<P0, P1, P2>::Allocator::Allocator(AreaPolicy::HeapArea const& area,
-        bool disableUseAfterFreeCheck)
+        bool disableUseAfterFreeCheck, uint8_t const* poolWeights)
         : mArea(area),
           mUseAfterFreeCheckDisabled(disableUseAfterFreeCheck) {
 
@@ -62,23 +62,37 @@ HandleAllocator<P0, P1, P2>::Allocator::Allocator(AreaPolicy::HeapArea const& ar
     // with an age of 0.
     memset(area.data(), 0, maxHeapSize);
 
-    // size the different pools so that they can all contain the same number of handles
-    size_t const count = maxHeapSize / (P0 + P1 + P2);
+    // size the different pools so that their number of handles are in the ratio of the
+    // weights, by default they all contain the same number of handles
+    size_t const w0 = poolWeights ? std::max(poolWeights[0], uint8_t(1)) : 1;
+    size_t const w1 = poolWeights ? std::max(poolWeights[1], uint8_t(1)) : 1;
+    size_t const w2 = poolWeights ? std::max(poolWeights[2], uint8_t(1)) : 1;
+    size_t const count = maxHeapSize / (w0 * P0 + w1 * P1 + w2 * P2);
     char* const p0 = static_cast<char*>(area.begin());
-    char* const p1 = p0 + count * P0;
-    char* const p2 = p1 + count * P1;
-
-    mPool0 = Pool<P0>(p0, count * P0);
-    mPool1 = Pool<P1>(p1, count * P1);
-    mPool2 = Pool<P2>(p2, count * P2);
+    char* const p1 = p0 + count * w0 * P0;
+    char* const p2 = p1 + count * w1 * P1;
+
+    mPool0 = Pool<P0>(p0, count * w0 * P0);
+    mPool1 = Pool<P1>(p1, count * w1 * P1);
+    mPool2 = Pool<P2>(p2, count * w2 * P2);
+
+    // This matches how FreeList lays out the nodes: the first one is aligned past the
+    // per-node data, and each one takes its size rounded up to the alignment.
+    auto const capacity = [](size_t size, size_t poolSize) -> uint32_t {
+        size_t const stride = (size + MIN_ALIGNMENT - 1) & ~(MIN_ALIGNMENT - 1);
+        return poolSize > MIN_ALIGNMENT ? uint32_t((poolSize - MIN_ALIGNMENT) / stride) : 0;
+    };
+    mCounters[0].capacity = capacity(P0, count * w0 * P0);
+    mCounters[1].capacity = capacity(P1, count * w1 * P1);
+    mCounters[2].capacity = capacity(P2, count * w2 * P2);
 }
 
 // ------------------------------------------------------------------------------------------------
 
 template <size_t P0, size_t P1, size_t P2>
 HandleAllocator<P0, P1, P2>::HandleAllocator(const char* name, size_t size,
-        bool disableUseAfterFreeCheck) noexcept
-    : mHandleArena(name, size, disableUseAfterFreeCheck),
+        bool disableUseAfterFreeCheck, uint8_t const* poolWeights) noexcept
+    : mHandleArena(name, size, disableUseAfterFreeCheck, poolWeights),
       mUseAfterFreeCheckDisabled(disableUseAfterFreeCheck) {
 }
 
@@ -94,6 +108,24 @@ HandleAllocator<P0, P1, P2>::~HandleAllocator() {
     }
 }
 
+template <size_t P0, size_t P1, size_t P2>
+HandleAllocatorStats HandleAllocator<P0, P1, P2>::getStats() const noexcept {
+    HandleAllocatorStats stats;
+    size_t const sizes[3] = { P0, P1, P2 };
+    auto const& counters = mHandleArena.getAllocator().mCounters;
+    std::lock_guard lock(mLock);
+    for (size_t i = 0; i < HandleAllocatorStats::POOL_COUNT; i++) {
+        auto& pool = stats.pools[i];
+        pool.size = uint32_t(sizes[i]);
+        pool.capacity = counters[i].capacity;
+        pool.count = counters[i].count.load(std::memory_order_relaxed);
+        pool.highWatermark = counters[i].highWatermark.load(std::memory_order_relaxed);
+        pool.heapCount = mHeapCount[i];
+        pool.heapAllocationCount = mHeapAllocationCount[i];
+    }
+    return stats;
+}
+
 template <size_t P0, size_t P1, size_t P2>
 UTILS_NOINLINE
 void* HandleAllocator<P0, P1, P2>::handleToPointerSlow(HandleBase::HandleId id) const noexcept {
@@ -118,6 +150,8 @@ HandleBase::HandleId HandleAllocator<P0, P1, P2>::allocateHandleSlow(size_t size
             " for a while. Please increase FILAMENT_OPENGL_HANDLE_ARENA_SIZE_IN_MB";
 
     mOverflowMap.emplace(id, p);
+    mHeapCount[getPoolIndex(size)]++;
+    mHeapAllocationCount[getPoolIndex(size)]++;
     lock.unlock();
 
     if (UTILS_UNLIKELY(id == (HANDLE_HEAP_FLAG | 1u))) { // meaning id was zero
@@ -128,7 +162,8 @@ HandleBase::HandleId HandleAllocator<P0, P1, P2>::allocateHandleSlow(size_t size
 }
 
 template <size_t P0, size_t P1, size_t P2>
-void HandleAllocator<P0, P1, P2>::deallocateHandleSlow(HandleBase::HandleId id, size_t) noexcept {
+void HandleAllocator<P0, P1, P2>::deallocateHandleSlow(HandleBase::HandleId id,
+        size_t size) noexcept {
     assert_invariant(id & HANDLE_HEAP_FLAG);
     void* p = nullptr;
     auto& overflowMap = mOverflowMap;
@@ -138,6 +173,7 @@ void HandleAllocator<P0, P1, P2>::deallocateHandleSlow(HandleBase::HandleId id,
     if (pos != overflowMap.end()) {
         p = pos.value();
         overflowMap.erase(pos);
+        mHeapCount[getPoolIndex(size)]--;
     }
     lock.unlock();
 
@@ -116,6 +116,7 @@ struct MetalContext {
     // State caches.
     DepthStencilStateCache depthStencilStateCache;
     PipelineStateCache pipelineStateCache;
+    MetalPipelineArchive pipelineArchive;
     SamplerStateCache samplerStateCache;
     ArgumentEncoderCache argumentEncoderCache;
 
@@ -125,6 +126,11 @@ struct MetalContext {
 
     MetalSamplerGroup* samplerBindings[Program::SAMPLER_BINDING_COUNT] = {};
 
+    // Argument buffers bound to the current render pass encoder, so that draws using the same
+    // sampler groups as the previous one don't re-bind them.
+    std::array<ArgumentBufferState, Program::SAMPLER_BINDING_COUNT> vertexArgumentBuffers;
+    std::array<ArgumentBufferState, Program::SAMPLER_BINDING_COUNT> fragmentArgumentBuffers;
+
     // Keeps track of sampler groups we've finalized for the current render pass.
     tsl::robin_set<MetalSamplerGroup*> finalizedSamplerGroups;
 
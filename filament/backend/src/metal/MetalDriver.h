@@ -138,6 +138,7 @@ private:
             Handle<HwVertexBuffer> vbh, Handle<HwIndexBuffer> ibh);
 
     void finalizeSamplerGroup(MetalSamplerGroup* sg);
+    void bindBuffersForDraw();
     void enumerateBoundBuffers(BufferObjectBinding bindingType,
             const std::function<void(const BufferState&, MetalBuffer*, uint32_t)>& f);
 
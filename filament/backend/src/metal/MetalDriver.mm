@@ -102,7 +102,8 @@ MetalDriver::MetalDriver(MetalPlatform* platform, const Platform::DriverConfig&
           mContext(new MetalContext(driverConfig.textureUseAfterFreePoolSize)),
           mHandleAllocator("Handles",
                   driverConfig.handleArenaSize,
-                  driverConfig.disableHandleUseAfterFreeCheck),
+                  driverConfig.disableHandleUseAfterFreeCheck,
+                  driverConfig.handleArenaPoolWeights),
           mStereoscopicType(driverConfig.stereoscopicType) {
     mContext->driver = this;
 
@@ -167,6 +168,8 @@ MetalDriver::MetalDriver(MetalPlatform* platform, const Platform::DriverConfig&
 
     mContext->commandQueue = mPlatform.createCommandQueue(mContext->device);
     mContext->pipelineStateCache.setDevice(mContext->device);
+    mContext->pipelineArchive.initialize(mContext->device, mPlatform);
+    mContext->pipelineStateCache.getCreator().archive = &mContext->pipelineArchive;
     mContext->depthStencilStateCache.setDevice(mContext->device);
     mContext->samplerStateCache.setDevice(mContext->device);
     mContext->argumentEncoderCache.setDevice(mContext->device);
@@ -262,6 +265,7 @@ void MetalDriver::endFrame(uint32_t frameId) {
     submitPendingCommands(mContext);
 
     mContext->bufferPool->gc();
+    mContext->pipelineArchive.gc();
 
     // If we acquired a drawable for this frame, ensure that we release it here.
     if (mContext->currentDrawSwapChain) {
@@ -666,6 +670,7 @@ void MetalDriver::terminate() {
     MetalExternalImage::shutdown(*mContext);
     mContext->blitter->shutdown();
     mContext->shaderCompiler->terminate();
+    mContext->pipelineArchive.terminate();
 }
 
 ShaderModel MetalDriver::getShaderModel() const noexcept {
@@ -829,6 +834,12 @@ bool MetalDriver::isProtectedTexturesSupported() {
     return false;
 }
 
+bool MetalDriver::isIndirectDrawSupported() {
+    // Indexed indirect draws require the MTLGPUFamilyApple3 or MTLGPUFamilyMac1 feature sets.
+    return mContext->highestSupportedGpuFamily.apple >= 3 ||
+           mContext->highestSupportedGpuFamily.mac   >= 1;
+}
+
 bool MetalDriver::isWorkaroundNeeded(Workaround workaround) {
     switch (workaround) {
         case Workaround::SPLIT_EASU:
@@ -847,6 +858,14 @@ bool MetalDriver::isWorkaroundNeeded(Workaround workaround) {
     return false;
 }
 
+StateChangeStats MetalDriver::getStateChangeStats() {
+    return {};
+}
+
+HandleAllocatorStats MetalDriver::getHandleAllocatorStats() {
+    return mHandleAllocator.getStats();
+}
+
 FeatureLevel MetalDriver::getFeatureLevel() {
     // FEATURE_LEVEL_3 requires >= 31 textures, which all Metal devices support. However, older
     // Metal devices only support 16 unique samplers. We could get around this in the future by
@@ -1109,6 +1128,8 @@ void MetalDriver::beginRenderPass(Handle<HwRenderTarget> rth,
     mContext->currentPolygonOffset = {0.0f, 0.0f};
 
     mContext->finalizedSamplerGroups.clear();
+    mContext->vertexArgumentBuffers = {};
+    mContext->fragmentArgumentBuffers = {};
 
     for (auto& pc : mContext->currentPushConstants) {
         pc.clear();
@@ -1643,13 +1664,14 @@ void MetalDriver::finalizeSamplerGroup(MetalSamplerGroup* samplerGroup) {
     // render pass.
     samplerGroup->useResources(mContext->currentRenderPassEncoder);
 
-    // useResources won't retain references to the textures, so we need to do so manually.
-    for (id<MTLTexture> texture : samplerGroup->textures) {
-        const void* retainedTexture = CFBridgingRetain(texture);
-        [cmdBuffer addCompletedHandler:^(id<MTLCommandBuffer> cb) {
-            CFBridgingRelease(retainedTexture);
-        }];
-    }
+    // useResources won't retain references to the textures, so we need to do so manually. A single
+    // completion handler keeps all of them alive, rather than one handler per texture.
+    NSArray<id<MTLTexture>>* retainedTextures =
+            [NSArray arrayWithObjects:samplerGroup->textures.data()
+                                count:samplerGroup->textures.size()];
+    [cmdBuffer addCompletedHandler:^(id<MTLCommandBuffer> cb) {
+        (void) retainedTextures;
+    }];
 }
 
 void MetalDriver::bindPipeline(PipelineState const& ps) {
@@ -1812,15 +1834,25 @@ void MetalDriver::bindPipeline(PipelineState const& ps) {
 
         assert_invariant(samplerGroup->getArgumentBuffer());
 
-        if (uint8_t(stageFlags) & uint8_t(ShaderStageFlags::VERTEX)) {
-            [mContext->currentRenderPassEncoder setVertexBuffer:samplerGroup->getArgumentBuffer()
-                                                         offset:samplerGroup->getArgumentBufferOffset()
+        // The argument buffer only changes when the sampler group is mutated, so consecutive
+        // draws using the same material instance skip the bindings entirely.
+        ArgumentBufferState const argumentBuffer {
+            .buffer = samplerGroup->getArgumentBuffer(),
+            .offset = samplerGroup->getArgumentBufferOffset()
+        };
+        if ((uint8_t(stageFlags) & uint8_t(ShaderStageFlags::VERTEX)) &&
+                mContext->vertexArgumentBuffers[s] != argumentBuffer) {
+            [mContext->currentRenderPassEncoder setVertexBuffer:argumentBuffer.buffer
+                                                         offset:argumentBuffer.offset
                                                         atIndex:(SAMPLER_GROUP_BINDING_START + s)];
+            mContext->vertexArgumentBuffers[s] = argumentBuffer;
         }
-        if (uint8_t(stageFlags) & uint8_t(ShaderStageFlags::FRAGMENT)) {
-            [mContext->currentRenderPassEncoder setFragmentBuffer:samplerGroup->getArgumentBuffer()
-                                                           offset:samplerGroup->getArgumentBufferOffset()
+        if ((uint8_t(stageFlags) & uint8_t(ShaderStageFlags::FRAGMENT)) &&
+                mContext->fragmentArgumentBuffers[s] != argumentBuffer) {
+            [mContext->currentRenderPassEncoder setFragmentBuffer:argumentBuffer.buffer
+                                                           offset:argumentBuffer.offset
                                                           atIndex:(SAMPLER_GROUP_BINDING_START + s)];
+            mContext->fragmentArgumentBuffers[s] = argumentBuffer;
         }
     }
 }
@@ -1862,10 +1894,7 @@ void MetalDriver::bindRenderPrimitive(Handle<HwRenderPrimitive> rph) {
                                                atIndex:ZERO_VERTEX_BUFFER_BINDING];
 }
 
-void MetalDriver::draw2(uint32_t indexOffset, uint32_t indexCount, uint32_t instanceCount) {
-    FILAMENT_CHECK_PRECONDITION(mContext->currentRenderPassEncoder != nullptr)
-            << "draw() without a valid command encoder.";
-
+void MetalDriver::bindBuffersForDraw() {
     // Bind uniform buffers.
     MetalBuffer* uniformsToBind[Program::UNIFORM_BINDING_COUNT] = { nil };
     NSUInteger offsets[Program::UNIFORM_BINDING_COUNT] = { 0 };
@@ -1887,6 +1916,13 @@ void MetalDriver::draw2(uint32_t indexOffset, uint32_t indexCount, uint32_t inst
             pushConstants.setBytes(mContext->currentRenderPassEncoder, static_cast<ShaderStage>(i));
         }
     }
+}
+
+void MetalDriver::draw2(uint32_t indexOffset, uint32_t indexCount, uint32_t instanceCount) {
+    FILAMENT_CHECK_PRECONDITION(mContext->currentRenderPassEncoder != nullptr)
+            << "draw() without a valid command encoder.";
+
+    bindBuffersForDraw();
 
     auto primitive = handle_cast<MetalRenderPrimitive>(mContext->currentRenderPrimitive);
 
@@ -1912,6 +1948,38 @@ void MetalDriver::draw(PipelineState ps, Handle<HwRenderPrimitive> rph,
     draw2(indexOffset, indexCount, instanceCount);
 }
 
+void MetalDriver::drawIndirect(Handle<HwBufferObject> boh,
+        uint32_t byteOffset, uint32_t drawCount, uint32_t stride) {
+    FILAMENT_CHECK_PRECONDITION(mContext->currentRenderPassEncoder != nullptr)
+            << "drawIndirect() without a valid command encoder.";
+    assert_invariant(isIndirectDrawSupported());
+
+    bindBuffersForDraw();
+
+    auto primitive = handle_cast<MetalRenderPrimitive>(mContext->currentRenderPrimitive);
+    auto* bo = handle_cast<MetalBufferObject>(boh);
+    assert_invariant(byteOffset + (drawCount ? drawCount - 1 : 0) * stride +
+            sizeof(DrawIndexedIndirectCommand) <= bo->byteCount);
+
+    MetalIndexBuffer* indexBuffer = primitive->indexBuffer;
+
+    id<MTLCommandBuffer> cmdBuffer = getPendingCommandBuffer(mContext);
+    id<MTLBuffer> metalIndexBuffer = indexBuffer->buffer.getGpuBufferForDraw(cmdBuffer);
+    id<MTLBuffer> metalIndirectBuffer = bo->getBuffer()->getGpuBufferForDraw(cmdBuffer);
+
+    // MTLDrawIndexedPrimitivesIndirectArguments has the layout of DrawIndexedIndirectCommand,
+    // the index buffer offset is given by its indexStart field.
+    for (uint32_t i = 0; i < drawCount; i++) {
+        [mContext->currentRenderPassEncoder
+                drawIndexedPrimitives:getMetalPrimitiveType(primitive->type)
+                            indexType:getIndexType(indexBuffer->elementSize)
+                          indexBuffer:metalIndexBuffer
+                    indexBufferOffset:0
+                       indirectBuffer:metalIndirectBuffer
+                 indirectBufferOffset:byteOffset + i * stride];
+    }
+}
+
 void MetalDriver::dispatchCompute(Handle<HwProgram> program, math::uint3 workGroupCount) {
     FILAMENT_CHECK_PRECONDITION(!isInRenderPass(mContext))
             << "dispatchCompute must be called outside of a render pass.";
@@ -552,6 +552,13 @@ MetalTexture::MetalTexture(MetalContext& context, SamplerType target, uint8_t le
             descriptor.sampleCount = multisampled ? samples : 1;
             descriptor.usage = getMetalTextureUsage(usage);
             descriptor.storageMode = MTLStorageModePrivate;
+            // transient attachments never leave tile memory, they don't need a backing store
+            if (any(usage & TextureUsage::TRANSIENT_ATTACHMENT) &&
+                    context.supportsMemorylessRenderTargets) {
+                if (@available(macOS 11.0, *)) {
+                    descriptor.storageMode = MTLStorageModeMemoryless;
+                }
+            }
             texture = [context.device newTextureWithDescriptor:descriptor];
             FILAMENT_CHECK_POSTCONDITION(texture != nil)
                     << "Could not create Metal texture. Out of memory?";
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TNT_FILAMENT_BACKEND_METAL_METALPIPELINEARCHIVE_H
+#define TNT_FILAMENT_BACKEND_METAL_METALPIPELINEARCHIVE_H
+
+#include <backend/Platform.h>
+
+#include <Metal/Metal.h>
+
+#include <string>
+
+#include <stdint.h>
+
+namespace filament::backend {
+
+// Compiled render pipelines are recorded in an MTLBinaryArchive, which is persisted through the
+// Platform's blob cache. On the next launch, pipeline states found in the archive are loaded
+// instead of being compiled for the GPU, which removes most of the stutter of the first frames.
+//
+// MTLBinaryArchive only exists on iOS 14 and macOS 11, this class does nothing on older systems
+// or when the Platform doesn't implement the blob cache.
+class MetalPipelineArchive {
+public:
+    // Number of frames between two serializations of the archive to the blob cache, if new
+    // pipelines were added in the meantime. The archive is also serialized on termination, but
+    // applications are often killed before that happens.
+    static constexpr uint32_t SAVE_INTERVAL = 1000;
+
+    MetalPipelineArchive() noexcept = default;
+
+    MetalPipelineArchive(MetalPipelineArchive const& rhs) = delete;
+    MetalPipelineArchive& operator=(MetalPipelineArchive const& rhs) = delete;
+
+    // Creates the archive, seeded with the data that the platform's blob cache has for this
+    // device and OS version, if any.
+    void initialize(id<MTLDevice> device, Platform& platform) noexcept;
+
+    // Serializes the archive a last time and releases it.
+    void terminate() noexcept;
+
+    // Must be called once per frame, serializes the archive every SAVE_INTERVAL frames.
+    void gc() noexcept;
+
+    // Makes the pipeline described by descriptor look up the archive before compiling its
+    // functions. Must be called before the pipeline state is created.
+    void prepareDescriptor(MTLRenderPipelineDescriptor* descriptor) const noexcept;
+
+    // Records the pipeline described by descriptor in the archive, once its state was created.
+    void addRenderPipeline(MTLRenderPipelineDescriptor* descriptor) noexcept;
+
+private:
+    void save() noexcept;
+
+    id mArchive = nil;   // id<MTLBinaryArchive>
+    Platform* mPlatform = nullptr;
+    std::string mBlobKey;
+    NSURL* mSeedUrl = nil;
+    uint32_t mFrame = 0;
+    uint32_t mLastSaveFrame = 0;
+    bool mDirty = false;
+};
+
+} // namespace filament::backend
+
+#endif // TNT_FILAMENT_BACKEND_METAL_METALPIPELINEARCHIVE_H
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "MetalPipelineArchive.h"
+
+#include <utils/Log.h>
+#include <utils/debug.h>
+
+namespace filament::backend {
+
+static NSURL* createTemporaryUrl() noexcept {
+    NSString* name = [NSString stringWithFormat:@"filament-%@.metallib", NSUUID.UUID.UUIDString];
+    return [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:name]];
+}
+
+void MetalPipelineArchive::initialize(id<MTLDevice> device, Platform& platform) noexcept {
+    assert_invariant(mArchive == nil);
+    mPlatform = &platform;
+    if (!platform.hasInsertBlobFunc() && !platform.hasRetrieveBlobFunc()) {
+        return;
+    }
+
+    if (@available(iOS 14, macOS 11, *)) {
+        // The compiled pipelines are specific to the GPU and to the version of the OS, which
+        // ships the Metal compiler.
+        mBlobKey = std::string("MTLBinaryArchive|") + device.name.UTF8String + "|" +
+                NSProcessInfo.processInfo.operatingSystemVersionString.UTF8String;
+
+        // An archive can only be created from a file, so the cached data is copied to a
+        // temporary one, which must exist for as long as the archive does.
+        MTLBinaryArchiveDescriptor* descriptor = [MTLBinaryArchiveDescriptor new];
+        if (platform.hasRetrieveBlobFunc()) {
+            size_t size = platform.retrieveBlob(mBlobKey.data(), mBlobKey.size(), nullptr, 0);
+            if (size > 0) {
+                NSMutableData* data = [NSMutableData dataWithLength:size];
+                size = platform.retrieveBlob(mBlobKey.data(), mBlobKey.size(),
+                        data.mutableBytes, data.length);
+                NSURL* url = createTemporaryUrl();
+                if (size == data.length && [data writeToURL:url atomically:NO]) {
+                    mSeedUrl = url;
+                    descriptor.url = url;
+                }
+            }
+        }
+
+        NSError* error = nil;
+        mArchive = [device newBinaryArchiveWithDescriptor:descriptor error:&error];
+        if (mArchive == nil && descriptor.url != nil) {
+            // the cached data is not usable, start from an empty archive
+            descriptor.url = nil;
+            mArchive = [device newBinaryArchiveWithDescriptor:descriptor error:&error];
+        }
+        if (mArchive == nil) {
+            utils::slog.w << "Could not create Metal binary archive: "
+                    << (error ? error.localizedDescription.UTF8String : "unknown error")
+                    << utils::io::endl;
+        }
+    }
+}
+
+void MetalPipelineArchive::terminate() noexcept {
+    save();
+    mArchive = nil;
+    if (mSeedUrl) {
+        [NSFileManager.defaultManager removeItemAtURL:mSeedUrl error:nil];
+        mSeedUrl = nil;
+    }
+}
+
+void MetalPipelineArchive::gc() noexcept {
+    ++mFrame;
+    if (mDirty && mFrame - mLastSaveFrame >= SAVE_INTERVAL) {
+        save();
+    }
+}
+
+void MetalPipelineArchive::prepareDescriptor(
+        MTLRenderPipelineDescriptor* descriptor) const noexcept {
+    if (@available(iOS 14, macOS 11, *)) {
+        if (mArchive) {
+            descriptor.binaryArchives = @[ mArchive ];
+        }
+    }
+}
+
+void MetalPipelineArchive::addRenderPipeline(MTLRenderPipelineDescriptor* descriptor) noexcept {
+    if (@available(iOS 14, macOS 11, *)) {
+        if (mArchive) {
+            id<MTLBinaryArchive> archive = mArchive;
+            // This is a no-op if the pipeline was loaded from the archive in the first place.
+            NSError* error = nil;
+            if ([archive addRenderPipelineFunctionsWithDescriptor:descriptor error:&error]) {
+                mDirty = true;
+            }
+        }
+    }
+}
+
+void MetalPipelineArchive::save() noexcept {
+    if (!mDirty || !mPlatform || !mPlatform->hasInsertBlobFunc()) {
+        return;
+    }
+    mDirty = false;
+    mLastSaveFrame = mFrame;
+
+    if (@available(iOS 14, macOS 11, *)) {
+        id<MTLBinaryArchive> archive = mArchive;
+        NSURL* url = createTemporaryUrl();
+        NSError* error = nil;
+        if ([archive serializeToURL:url error:&error]) {
+            NSData* data = [NSData dataWithContentsOfURL:url];
+            if (data.length) {
+                mPlatform->insertBlob(mBlobKey.data(), mBlobKey.size(), data.bytes, data.length);
+            }
+        } else {
+            utils::slog.w << "Could not serialize Metal binary archive: "
+                    << (error ? error.localizedDescription.UTF8String : "unknown error")
+                    << utils::io::endl;
+        }
+        [NSFileManager.defaultManager removeItemAtURL:url error:nil];
+    }
+}
+
+} // namespace filament::backend
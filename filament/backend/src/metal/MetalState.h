@@ -19,6 +19,8 @@
 
 #include <Metal/Metal.h>
 
+#include "MetalPipelineArchive.h"
+
 #include "private/backend/Driver.h"
 #include "backend/Program.h"
 
@@ -172,6 +174,8 @@ public:
 
     void setDevice(id<MTLDevice> device) noexcept { mDevice = device; }
 
+    StateCreator& getCreator() noexcept { return creator; }
+
     MetalType getOrCreateState(const StateType& state) noexcept {
         assert_invariant(mDevice);
 
@@ -282,6 +286,9 @@ static_assert(sizeof(MetalPipelineState) == 696, "MetalPipelineState unexpected
 struct PipelineStateCreator {
     id<MTLRenderPipelineState> operator()(id<MTLDevice> device, const MetalPipelineState& state)
             noexcept;
+
+    // Where compiled pipelines are looked up and recorded, if set.
+    MetalPipelineArchive* archive = nullptr;
 };
 
 using PipelineStateTracker = StateTracker<MetalPipelineState>;
@@ -356,6 +363,20 @@ struct BufferState {
     bool bound = false;                   // 1 byte
 };
 
+// The argument buffer bound to a sampler group binding of the render pass encoder.
+struct ArgumentBufferState {
+    id<MTLBuffer> buffer = nil;
+    NSUInteger offset = 0;
+
+    bool operator==(const ArgumentBufferState& rhs) const noexcept {
+        return this->buffer == rhs.buffer && this->offset == rhs.offset;
+    }
+
+    bool operator!=(const ArgumentBufferState& rhs) const noexcept {
+        return !operator==(rhs);
+    }
+};
+
 // Sampler states
 
 struct SamplerState {
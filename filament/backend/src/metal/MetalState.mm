@@ -87,6 +87,10 @@ id<MTLRenderPipelineState> PipelineStateCreator::operator()(id<MTLDevice> device
     // MSAA
     descriptor.rasterSampleCount = state.sampleCount;
 
+    if (archive) {
+        archive->prepareDescriptor(descriptor);
+    }
+
     NSError* error = nullptr;
     id<MTLRenderPipelineState> pipeline = [device newRenderPipelineStateWithDescriptor:descriptor
                                                                                  error:&error];
@@ -102,6 +106,10 @@ id<MTLRenderPipelineState> PipelineStateCreator::operator()(id<MTLDevice> device
     }
     FILAMENT_CHECK_POSTCONDITION(error == nil) << "Could not create Metal pipeline state.";
 
+    if (archive) {
+        archive->addRenderPipeline(descriptor);
+    }
+
     return pipeline;
 }
 
@@ -202,10 +202,22 @@ bool NoopDriver::isProtectedTexturesSupported() {
     return true;
 }
 
+bool NoopDriver::isIndirectDrawSupported() {
+    return true;
+}
+
 bool NoopDriver::isWorkaroundNeeded(Workaround) {
     return false;
 }
 
+StateChangeStats NoopDriver::getStateChangeStats() {
+    return {};
+}
+
+HandleAllocatorStats NoopDriver::getHandleAllocatorStats() {
+    return {};
+}
+
 FeatureLevel NoopDriver::getFeatureLevel() {
     return FeatureLevel::FEATURE_LEVEL_1;
 }
@@ -372,6 +384,10 @@ void NoopDriver::draw(PipelineState pipelineState, Handle<HwRenderPrimitive> rph
         uint32_t indexOffset, uint32_t indexCount, uint32_t instanceCount) {
 }
 
+void NoopDriver::drawIndirect(Handle<HwBufferObject> boh,
+        uint32_t byteOffset, uint32_t drawCount, uint32_t stride) {
+}
+
 void NoopDriver::dispatchCompute(Handle<HwProgram> program, math::uint3 workGroupCount) {
 }
 
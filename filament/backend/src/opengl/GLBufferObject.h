@@ -27,6 +27,18 @@
 
 namespace filament::backend {
 
+// Storage of a uniform buffer that is orphaned every frame, used when the GL supports persistent
+// mappings. It holds REGION_COUNT copies of the buffer, which are used in turn and written
+// directly through a coherent mapping. A fence tells when the GPU is done with each region.
+struct GLStreamRing {
+    static constexpr uint32_t REGION_COUNT = 3;
+    uint8_t* data = nullptr;    // mapping of the whole storage
+    uint32_t stride = 0;        // distance between two regions, aligned for binding
+    uint32_t region = 0;        // region currently in use
+    GLsync fences[REGION_COUNT] = {};
+    uint32_t getOffset() const noexcept { return region * stride; }
+};
+
 struct GLBufferObject : public HwBufferObject {
     using HwBufferObject::HwBufferObject;
     GLBufferObject(uint32_t size,
@@ -44,6 +56,7 @@ struct GLBufferObject : public HwBufferObject {
     BufferUsage usage;
     BufferObjectBinding bindingType;
     uint16_t age = 0;
+    uint16_t stream = 0;    // 1 + the index of its GLStreamRing in OpenGLDriver, or 0
 };
 
 } // namespace filament::backend
@@ -22,6 +22,15 @@
 #include <backend/Program.h>
 
 #include <utils/Systrace.h>
+#include <utils/debug.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <string.h>
 
 namespace filament::backend {
 
@@ -35,7 +44,7 @@ OpenGLBlobCache::OpenGLBlobCache(OpenGLContext& gl) noexcept
 }
 
 GLuint OpenGLBlobCache::retrieve(BlobCacheKey* outKey, Platform& platform,
-        Program const& program) const noexcept {
+        Program const& program) noexcept {
     SYSTRACE_CALL();
     if (!mCachingSupported || !platform.hasRetrieveBlobFunc()) {
         // the key is never updated in that case
@@ -47,6 +56,45 @@ GLuint OpenGLBlobCache::retrieve(BlobCacheKey* outKey, Platform& platform,
 #ifndef FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2
     BlobCacheKey key{ program.getCacheId(), program.getSpecializationConstants() };
 
+    bool prewarmed = false;
+    if (mMaxUsageCount) {
+        std::string const name = toString(key);
+        auto const now = mUsage.find(name);
+        if (now == mUsage.end() || now->second != mRun) {
+            mUsage[name] = mRun;
+            mUsageDirty = true;
+        }
+
+        std::unique_lock lock(mPrewarmLock);
+        auto pos = mPrewarmedPrograms.find(name);
+        if (pos != mPrewarmedPrograms.end()) {
+            // if the program is being loaded, it's quicker to wait for it
+            mPrewarmCondition.wait(lock, [&pos]() {
+                return pos->second.state != PrewarmState::LOADING;
+            });
+            prewarmed = pos->second.state == PrewarmState::READY;
+            programId = pos->second.program;
+            mPrewarmedPrograms.erase(pos);
+        }
+    }
+
+    if (!prewarmed) {
+        programId = load(key, platform);
+    }
+
+    if (UTILS_LIKELY(outKey)) {
+        using std::swap;
+        swap(*outKey, key);
+    }
+#endif
+
+    return programId;
+}
+
+GLuint OpenGLBlobCache::load(BlobCacheKey const& key, Platform& platform) const noexcept {
+    GLuint programId = 0;
+
+#ifndef FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2
     // FIXME: use a static buffer to avoid systematic allocation
     // always attempt with 64 KiB
     constexpr size_t DEFAULT_BLOB_SIZE = 65536;
@@ -78,11 +126,6 @@ GLuint OpenGLBlobCache::retrieve(BlobCacheKey* outKey, Platform& platform,
             programId = 0;
         }
     }
-
-    if (UTILS_LIKELY(outKey)) {
-        using std::swap;
-        swap(*outKey, key);
-    }
 #endif
 
     return programId;
@@ -122,4 +165,151 @@ void OpenGLBlobCache::insert(Platform& platform,
 #endif
 }
 
+namespace {
+
+// The usage record is stored in the blob cache under this key, which can't be confused with the
+// key of a program since those are much shorter.
+constexpr char const USAGE_KEY[] = "filament.OpenGLBlobCache.usage.v1";
+
+struct UsageHeader {
+    uint32_t run;
+    uint32_t count;
+};
+
+// Each entry is followed by the bytes of its key.
+struct UsageEntry {
+    uint32_t run;
+    uint32_t size;
+};
+
+} // anonymous namespace
+
+std::vector<BlobCacheKey> OpenGLBlobCache::loadUsage(Platform& platform, size_t maxCount) {
+    SYSTRACE_CALL();
+    std::vector<BlobCacheKey> keys;
+    if (!mCachingSupported || !platform.hasRetrieveBlobFunc() || !platform.hasInsertBlobFunc() ||
+            !maxCount) {
+        return keys;
+    }
+
+    mMaxUsageCount = maxCount;
+
+    std::vector<char> record;
+    size_t size = platform.retrieveBlob(USAGE_KEY, sizeof(USAGE_KEY), nullptr, 0);
+    if (size >= sizeof(UsageHeader)) {
+        record.resize(size);
+        size = platform.retrieveBlob(USAGE_KEY, sizeof(USAGE_KEY), record.data(), record.size());
+    }
+    if (size < sizeof(UsageHeader) || size > record.size()) {
+        // there is no valid record yet
+        return keys;
+    }
+
+    UsageHeader header;
+    memcpy(&header, record.data(), sizeof(header));
+    mRun = header.run + 1;
+
+    std::vector<std::pair<uint32_t, BlobCacheKey>> entries;
+    size_t offset = sizeof(header);
+    for (uint32_t i = 0; i < header.count && offset + sizeof(UsageEntry) <= size; i++) {
+        UsageEntry entry;
+        memcpy(&entry, record.data() + offset, sizeof(entry));
+        offset += sizeof(entry);
+        if (!entry.size || entry.size > size - offset) {
+            // the record is truncated
+            break;
+        }
+        BlobCacheKey key{ record.data() + offset, entry.size };
+        offset += entry.size;
+        mUsage[toString(key)] = entry.run;
+        entries.emplace_back(entry.run, std::move(key));
+    }
+
+    // the record is written sorted, but don't rely on it
+    std::stable_sort(entries.begin(), entries.end(), [](auto const& lhs, auto const& rhs) {
+        return lhs.first > rhs.first;
+    });
+    entries.resize(std::min(entries.size(), maxCount));
+
+    std::unique_lock const lock(mPrewarmLock);
+    keys.reserve(entries.size());
+    for (auto& entry: entries) {
+        mPrewarmedPrograms[toString(entry.second)] = {};
+        keys.push_back(std::move(entry.second));
+    }
+    return keys;
+}
+
+void OpenGLBlobCache::prewarm(Platform& platform, BlobCacheKey const& key) noexcept {
+    SYSTRACE_CALL();
+    std::string const name = toString(key);
+    std::unique_lock lock(mPrewarmLock);
+    auto pos = mPrewarmedPrograms.find(name);
+    if (pos == mPrewarmedPrograms.end() || pos->second.state != PrewarmState::QUEUED) {
+        // the program was retrieved already
+        return;
+    }
+    pos->second.state = PrewarmState::LOADING;
+    lock.unlock();
+
+    GLuint const program = load(key, platform);
+#ifndef FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2
+    if (program) {
+        // make sure the program is ready by the time it is retrieved
+        GLint status = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+    }
+#endif
+
+    lock.lock();
+    // the entry can't have been removed while it was LOADING
+    pos = mPrewarmedPrograms.find(name);
+    assert_invariant(pos != mPrewarmedPrograms.end());
+    pos->second = { PrewarmState::READY, program };
+    mPrewarmCondition.notify_all();
+}
+
+void OpenGLBlobCache::saveUsage(Platform& platform) noexcept {
+    if (!mUsageDirty) {
+        return;
+    }
+    SYSTRACE_CALL();
+    mUsageDirty = false;
+
+    // keep the most recently used keys only
+    std::vector<decltype(mUsage)::const_iterator> entries;
+    entries.reserve(mUsage.size());
+    for (auto it = mUsage.cbegin(); it != mUsage.cend(); ++it) {
+        entries.push_back(it);
+    }
+    std::sort(entries.begin(), entries.end(), [](auto const& lhs, auto const& rhs) {
+        return lhs->second > rhs->second;
+    });
+    entries.resize(std::min(entries.size(), mMaxUsageCount));
+
+    UsageHeader const header{ mRun, uint32_t(entries.size()) };
+    std::vector<char> record(sizeof(header));
+    memcpy(record.data(), &header, sizeof(header));
+    for (auto const& it: entries) {
+        UsageEntry const entry{ it->second, uint32_t(it->first.size()) };
+        size_t const offset = record.size();
+        record.resize(offset + sizeof(entry) + entry.size);
+        memcpy(record.data() + offset, &entry, sizeof(entry));
+        memcpy(record.data() + offset + sizeof(entry), it->first.data(), entry.size);
+    }
+
+    platform.insertBlob(USAGE_KEY, sizeof(USAGE_KEY), record.data(), record.size());
+}
+
+void OpenGLBlobCache::terminate() noexcept {
+    std::unique_lock const lock(mPrewarmLock);
+    for (auto const& [name, prewarmed]: mPrewarmedPrograms) {
+        assert_invariant(prewarmed.state != PrewarmState::LOADING);
+        if (prewarmed.program) {
+            glDeleteProgram(prewarmed.program);
+        }
+    }
+    mPrewarmedPrograms.clear();
+}
+
 } // namespace filament::backend
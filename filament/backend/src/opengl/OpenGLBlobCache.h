@@ -21,6 +21,16 @@
 
 #include "BlobCacheKey.h"
 
+#include <utils/Condition.h>
+#include <utils/Mutex.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
 namespace filament::backend {
 
 class Platform;
@@ -31,15 +41,57 @@ class OpenGLBlobCache {
 public:
     explicit OpenGLBlobCache(OpenGLContext& gl) noexcept;
 
+    // Returns the program of the given key that was loaded by prewarm(), or loads it from the
+    // blob cache. This also records that the program was used.
     GLuint retrieve(BlobCacheKey* key, Platform& platform,
-            Program const& program) const noexcept;
+            Program const& program) noexcept;
 
     void insert(Platform& platform,
             BlobCacheKey const& key, GLuint program) noexcept;
 
+    // Enables the usage record, and returns the keys of up to maxCount programs that were used
+    // most recently by previous runs, most recent first. These keys must then be given to
+    // prewarm().
+    std::vector<BlobCacheKey> loadUsage(Platform& platform, size_t maxCount);
+
+    // Loads the program of the given key from the blob cache, unless retrieve() was called for
+    // it already. This is meant to be called on a thread that has a shared context.
+    void prewarm(Platform& platform, BlobCacheKey const& key) noexcept;
+
+    // Writes the usage record to the blob cache if it changed.
+    void saveUsage(Platform& platform) noexcept;
+
+    // Destroys the prewarmed programs that were never retrieved. No prewarm() call must be
+    // running or be made after this.
+    void terminate() noexcept;
+
 private:
     struct Blob;
+
+    GLuint load(BlobCacheKey const& key, Platform& platform) const noexcept;
+
+    static std::string toString(BlobCacheKey const& key) {
+        return { static_cast<char const*>(key.data()), key.size() };
+    }
+
     bool mCachingSupported = false;
+
+    // Programs that are loaded ahead of time by prewarm(), protected by mPrewarmLock.
+    enum class PrewarmState : uint8_t { QUEUED, LOADING, READY };
+    struct PrewarmedProgram {
+        PrewarmState state = PrewarmState::QUEUED;
+        GLuint program = 0;
+    };
+    mutable utils::Mutex mPrewarmLock;
+    utils::Condition mPrewarmCondition;
+    std::unordered_map<std::string, PrewarmedProgram> mPrewarmedPrograms;
+
+    // The usage record maps each key to the index of the last run that used it. This is only
+    // accessed from the main thread.
+    std::unordered_map<std::string, uint32_t> mUsage;
+    size_t mMaxUsageCount = 0;
+    uint32_t mRun = 0;
+    bool mUsageDirty = false;
 };
 
 } // namespace filament::backend
@@ -394,9 +394,11 @@ void OpenGLContext::initProcs(Procs* procs,
     procs->getQueryObjectuiv = glGetQueryObjectuiv;
 #   ifdef BACKEND_OPENGL_VERSION_GL
     procs->getQueryObjectui64v = glGetQueryObjectui64v; // only core in GL
+    procs->queryCounter = glQueryCounter;               // core in GL 3.3
 #   elif defined(GL_EXT_disjoint_timer_query)
 #       ifndef __EMSCRIPTEN__
             procs->getQueryObjectui64v = glGetQueryObjectui64vEXT;
+            procs->queryCounter = glQueryCounterEXT;
 #       endif
 #   endif // BACKEND_OPENGL_VERSION_GL
 
@@ -432,6 +434,7 @@ void OpenGLContext::initProcs(Procs* procs,
         procs->endQuery = glEndQueryEXT;
         procs->getQueryObjectuiv = glGetQueryObjectuivEXT;
         procs->getQueryObjectui64v = glGetQueryObjectui64vEXT;
+        procs->queryCounter = glQueryCounterEXT;
 
         procs->invalidateFramebuffer = glDiscardFramebufferEXT;
 
@@ -479,6 +482,9 @@ void OpenGLContext::initBugs(Bugs* bugs, Extensions const& exts,
             // initialize the non-used uniform array for Adreno drivers.
             bugs->enable_initialize_non_used_uniform_array = true;
 
+            // color grading as a subpass of TAA is slower than as its own pass
+            bugs->disable_taa_color_grading_subpass = true;
+
             int maj, min, driverMajor, driverMinor;
             int const c = sscanf(version, "OpenGL ES %d.%d V@%d.%d", // NOLINT(cert-err34-c)
                     &maj, &min, &driverMajor, &driverMinor);
@@ -668,6 +674,7 @@ void OpenGLContext::initExtensionsGLES(Extensions* ext, GLint major, GLint minor
     using namespace std::literals;
     ext->APPLE_color_buffer_packed_float = exts.has("GL_APPLE_color_buffer_packed_float"sv);
 #ifndef __EMSCRIPTEN__
+    ext->EXT_buffer_storage = exts.has("GL_EXT_buffer_storage"sv);
     ext->EXT_clip_control = exts.has("GL_EXT_clip_control"sv);
 #endif
     ext->EXT_clip_cull_distance = exts.has("GL_EXT_clip_cull_distance"sv);
@@ -742,6 +749,7 @@ void OpenGLContext::initExtensionsGL(Extensions* ext, GLint major, GLint minor)
     using namespace std::literals;
     ext->APPLE_color_buffer_packed_float = true;  // Assumes core profile.
     ext->ARB_shading_language_packing = exts.has("GL_ARB_shading_language_packing"sv);
+    ext->EXT_buffer_storage = exts.has("GL_ARB_buffer_storage"sv);
     ext->EXT_color_buffer_float = true;  // Assumes core profile.
     ext->EXT_color_buffer_half_float = true;  // Assumes core profile.
     ext->EXT_clip_cull_distance = true;
@@ -784,6 +792,10 @@ void OpenGLContext::initExtensionsGL(Extensions* ext, GLint major, GLint minor)
         ext->EXT_discard_framebuffer = true;
         ext->KHR_debug = true;
     }
+    // OpenGL 4.4 implies EXT_buffer_storage
+    if (major > 4 || (major == 4 && minor >= 4)) {
+        ext->EXT_buffer_storage = true;
+    }
     // OpenGL 4.5 implies EXT_clip_control
     if (major > 4 || (major == 4 && minor >= 5)) {
         ext->EXT_clip_control = true;
@@ -812,24 +824,25 @@ void OpenGLContext::unbindFramebuffer(GLenum target) noexcept {
 
 void OpenGLContext::bindFramebufferResolved(GLenum target, GLuint buffer) noexcept {
     switch (target) {
-        case GL_FRAMEBUFFER:
-            if (state.draw_fbo != buffer || state.read_fbo != buffer) {
+        case GL_FRAMEBUFFER: {
+            bool const changed = state.draw_fbo != buffer || state.read_fbo != buffer;
+            if (changed) {
                 state.draw_fbo = state.read_fbo = buffer;
                 glBindFramebuffer(target, buffer);
             }
+            countStateChange(StateChangeStats::Category::FRAMEBUFFER, changed);
             break;
+        }
 #ifndef FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2
         case GL_DRAW_FRAMEBUFFER:
-            if (state.draw_fbo != buffer) {
-                state.draw_fbo = buffer;
+            update_state(StateChangeStats::Category::FRAMEBUFFER, state.draw_fbo, buffer, [&]() {
                 glBindFramebuffer(target, buffer);
-            }
+            });
             break;
         case GL_READ_FRAMEBUFFER:
-            if (state.read_fbo != buffer) {
-                state.read_fbo = buffer;
+            update_state(StateChangeStats::Category::FRAMEBUFFER, state.read_fbo, buffer, [&]() {
                 glBindFramebuffer(target, buffer);
-            }
+            });
             break;
 #endif
         default:
@@ -843,17 +856,20 @@ void OpenGLContext::bindBuffer(GLenum target, GLuint buffer) noexcept {
         // GL_ELEMENT_ARRAY_BUFFER is a special case, where the currently bound VAO remembers
         // the index buffer, unless there are no VAO bound (see: bindVertexArray)
         assert_invariant(state.vao.p);
-        if (state.buffers.genericBinding[targetIndex] != buffer
-            || ((state.vao.p != &mDefaultVAO) && (state.vao.p->elementArray != buffer))) {
+        bool const changed = state.buffers.genericBinding[targetIndex] != buffer
+            || ((state.vao.p != &mDefaultVAO) && (state.vao.p->elementArray != buffer));
+        if (changed) {
             state.buffers.genericBinding[targetIndex] = buffer;
             if (state.vao.p != &mDefaultVAO) {
                 state.vao.p->elementArray = buffer;
             }
             glBindBuffer(target, buffer);
         }
+        countStateChange(StateChangeStats::Category::BUFFER, changed);
     } else {
         size_t const targetIndex = getIndexForBufferTarget(target);
-        update_state(state.buffers.genericBinding[targetIndex], buffer, [&]() {
+        update_state(StateChangeStats::Category::BUFFER,
+                state.buffers.genericBinding[targetIndex], buffer, [&]() {
             glBindBuffer(target, buffer);
         });
     }
@@ -911,7 +927,7 @@ void OpenGLContext::unbindTexture(
 }
 
 void OpenGLContext::unbindTextureUnit(GLuint unit) noexcept {
-    update_state(state.textures.units[unit].id, 0u, [&]() {
+    update_state(StateChangeStats::Category::TEXTURE, state.textures.units[unit].id, 0u, [&]() {
         activeTexture(unit);
         glBindTexture(state.textures.units[unit].target, 0u);
     });
@@ -939,6 +955,20 @@ void OpenGLContext::deleteBuffers(GLsizei n, const GLuint* buffers, GLenum targe
         }
     }
 
+#if !defined(FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2) && defined(BACKEND_OPENGL_LEVEL_GLES31)
+    if (target == GL_SHADER_STORAGE_BUFFER) {
+        // shader storage buffers can also be bound as the source of indirect draws
+        auto& indirectBuffer = state.buffers.genericBinding[
+                getIndexForBufferTarget(GL_DRAW_INDIRECT_BUFFER)];
+        UTILS_NOUNROLL
+        for (GLsizei i = 0; i < n; ++i) {
+            if (indirectBuffer == buffers[i]) {
+                indirectBuffer = 0;
+            }
+        }
+    }
+#endif
+
 #ifndef FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2
     assert_invariant(mFeatureLevel >= FeatureLevel::FEATURE_LEVEL_1 ||
             (target != GL_UNIFORM_BUFFER && target != GL_TRANSFORM_FEEDBACK_BUFFER));
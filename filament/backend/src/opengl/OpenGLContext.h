@@ -215,6 +215,7 @@ public:
     struct Extensions {
         bool APPLE_color_buffer_packed_float;
         bool ARB_shading_language_packing;
+        bool EXT_buffer_storage;
         bool EXT_clip_control;
         bool EXT_clip_cull_distance;
         bool EXT_color_buffer_float;
@@ -315,6 +316,9 @@ public:
         // bugs or performance issues.
         bool force_feature_level0;
 
+        // Performance degrades when color grading runs as a subpass of the TAA pass.
+        bool disable_taa_color_grading_subpass;
+
     } bugs = {};
 
     // state getters -- as needed.
@@ -425,7 +429,7 @@ public:
                     GLsizeiptr size = 0;
                 } buffers[MAX_BUFFER_BINDINGS];
             } targets[3];   // there are only 3 indexed buffer targets
-            GLuint genericBinding[7] = {};
+            GLuint genericBinding[8] = {};
         } buffers;
 
         struct {
@@ -465,6 +469,8 @@ public:
         void (* endQuery)(GLenum target);
         void (* getQueryObjectuiv)(GLuint id, GLenum pname, GLuint* params);
         void (* getQueryObjectui64v)(GLuint id, GLenum pname, GLuint64* params);
+        // null when timestamp queries are not supported
+        void (* queryCounter)(GLuint id, GLenum target);
 
         void (* invalidateFramebuffer)(GLenum target, GLsizei numAttachments, const GLenum *attachments);
 
@@ -496,6 +502,15 @@ public:
     }
 #endif
 
+    // Counts a state change that was issued, or skipped because it was redundant.
+    void countStateChange(StateChangeStats::Category category, bool issued) noexcept {
+        (issued ? mStateChangeStats.issued : mStateChangeStats.redundant)[size_t(category)]++;
+    }
+
+    // Returns the state changes counted since the last call to resetStateChangeStats().
+    StateChangeStats const& getStateChangeStats() const noexcept { return mStateChangeStats; }
+
+    void resetStateChangeStats() noexcept { mStateChangeStats = {}; }
 
 private:
     OpenGLPlatform& mPlatform;
@@ -504,6 +519,7 @@ private:
     TimerQueryFactoryInterface* mTimerQueryFactory = nullptr;
     std::vector<std::function<void(OpenGLContext&)>> mDestroyWithNormalContext;
     RenderPrimitive mDefaultVAO;
+    StateChangeStats mStateChangeStats;
     std::optional<GLuint> mDefaultFbo[2];
     std::array<
             std::tuple<GLuint, void const*, uint16_t>,
@@ -561,6 +577,9 @@ private:
             {   bugs.force_feature_level0,
                     "force_feature_level0",
                     ""},
+            {   bugs.disable_taa_color_grading_subpass,
+                    "disable_taa_color_grading_subpass",
+                    ""},
     }};
 
     // this is chosen to minimize code size
@@ -597,11 +616,14 @@ private:
             Bugs const& bugs) noexcept;
 
     template <typename T, typename F>
-    static inline void update_state(T& state, T const& expected, F functor, bool force = false) noexcept {
-        if (UTILS_UNLIKELY(force || state != expected)) {
-            state = expected;
+    inline void update_state(StateChangeStats::Category category,
+            T& current, T const& expected, F functor, bool force = false) noexcept {
+        bool const changed = force || current != expected;
+        if (UTILS_UNLIKELY(changed)) {
+            current = expected;
             functor();
         }
+        countStateChange(category, changed);
     }
 
     void setDefaultState() noexcept;
@@ -649,6 +671,9 @@ constexpr size_t OpenGLContext::getIndexForBufferTarget(GLenum target) noexcept
 #ifndef FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2
         case GL_PIXEL_PACK_BUFFER:          index = 5; break;
         case GL_PIXEL_UNPACK_BUFFER:        index = 6; break;
+#if defined(BACKEND_OPENGL_LEVEL_GLES31)
+        case GL_DRAW_INDIRECT_BUFFER:       index = 7; break;
+#endif
 #endif
         default: break;
     }
@@ -660,7 +685,7 @@ constexpr size_t OpenGLContext::getIndexForBufferTarget(GLenum target) noexcept
 
 void OpenGLContext::activeTexture(GLuint unit) noexcept {
     assert_invariant(unit < MAX_TEXTURE_UNIT_COUNT);
-    update_state(state.textures.active, unit, [&]() {
+    update_state(StateChangeStats::Category::TEXTURE, state.textures.active, unit, [&]() {
         glActiveTexture(GL_TEXTURE0 + unit);
     });
 }
@@ -669,7 +694,8 @@ void OpenGLContext::bindSampler(GLuint unit, GLuint sampler) noexcept {
     assert_invariant(unit < MAX_TEXTURE_UNIT_COUNT);
     assert_invariant(mFeatureLevel >= FeatureLevel::FEATURE_LEVEL_1);
 #ifndef FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2
-    update_state(state.textures.units[unit].sampler, sampler, [&]() {
+    update_state(StateChangeStats::Category::SAMPLER,
+            state.textures.units[unit].sampler, sampler, [&]() {
         glBindSampler(unit, sampler);
     });
 #endif
@@ -677,28 +703,28 @@ void OpenGLContext::bindSampler(GLuint unit, GLuint sampler) noexcept {
 
 void OpenGLContext::setScissor(GLint left, GLint bottom, GLsizei width, GLsizei height) noexcept {
     vec4gli const scissor(left, bottom, width, height);
-    update_state(state.window.scissor, scissor, [&]() {
+    update_state(StateChangeStats::Category::VIEWPORT, state.window.scissor, scissor, [&]() {
         glScissor(left, bottom, width, height);
     });
 }
 
 void OpenGLContext::viewport(GLint left, GLint bottom, GLsizei width, GLsizei height) noexcept {
     vec4gli const viewport(left, bottom, width, height);
-    update_state(state.window.viewport, viewport, [&]() {
+    update_state(StateChangeStats::Category::VIEWPORT, state.window.viewport, viewport, [&]() {
         glViewport(left, bottom, width, height);
     });
 }
 
 void OpenGLContext::depthRange(GLclampf near, GLclampf far) noexcept {
     vec2glf const depthRange(near, far);
-    update_state(state.window.depthRange, depthRange, [&]() {
+    update_state(StateChangeStats::Category::VIEWPORT, state.window.depthRange, depthRange, [&]() {
         glDepthRangef(near, far);
     });
 }
 
 void OpenGLContext::bindVertexArray(RenderPrimitive const* p) noexcept {
     RenderPrimitive* vao = p ? const_cast<RenderPrimitive *>(p) : &mDefaultVAO;
-    update_state(state.vao.p, vao, [&]() {
+    update_state(StateChangeStats::Category::VERTEX_ARRAY, state.vao.p, vao, [&]() {
 
         // See if we need to create a name for this VAO on the fly, this would happen if:
         // - we're not the default VAO, because its name is always 0
@@ -744,31 +770,35 @@ void OpenGLContext::bindBufferRange(GLenum target, GLuint index, GLuint buffer,
     size_t const targetIndex = getIndexForBufferTarget(target);
     // this ALSO sets the generic binding
     assert_invariant(targetIndex < sizeof(state.buffers.targets) / sizeof(*state.buffers.targets));
-    if (   state.buffers.targets[targetIndex].buffers[index].name != buffer
-           || state.buffers.targets[targetIndex].buffers[index].offset != offset
-           || state.buffers.targets[targetIndex].buffers[index].size != size) {
+    bool const changed =
+               state.buffers.targets[targetIndex].buffers[index].name != buffer
+            || state.buffers.targets[targetIndex].buffers[index].offset != offset
+            || state.buffers.targets[targetIndex].buffers[index].size != size;
+    if (changed) {
         state.buffers.targets[targetIndex].buffers[index].name = buffer;
         state.buffers.targets[targetIndex].buffers[index].offset = offset;
         state.buffers.targets[targetIndex].buffers[index].size = size;
         state.buffers.genericBinding[targetIndex] = buffer;
         glBindBufferRange(target, index, buffer, offset, size);
     }
+    countStateChange(StateChangeStats::Category::BUFFER, changed);
 #endif
 }
 
 void OpenGLContext::bindTexture(GLuint unit, GLuint target, GLuint texId) noexcept {
-    update_state(state.textures.units[unit].target, target, [&]() {
+    update_state(StateChangeStats::Category::TEXTURE,
+            state.textures.units[unit].target, target, [&]() {
         activeTexture(unit);
         glBindTexture(state.textures.units[unit].target, 0);
     });
-    update_state(state.textures.units[unit].id, texId, [&]() {
+    update_state(StateChangeStats::Category::TEXTURE, state.textures.units[unit].id, texId, [&]() {
         activeTexture(unit);
         glBindTexture(target, texId);
     }, target == GL_TEXTURE_EXTERNAL_OES);
 }
 
 void OpenGLContext::useProgram(GLuint program) noexcept {
-    update_state(state.program.use, program, [&]() {
+    update_state(StateChangeStats::Category::PROGRAM, state.program.use, program, [&]() {
         glUseProgram(program);
     });
 }
@@ -777,121 +807,139 @@ void OpenGLContext::enableVertexAttribArray(RenderPrimitive const* rp, GLuint in
     assert_invariant(rp);
     assert_invariant(index < rp->vertexAttribArray.size());
     bool const force = rp->stateVersion != state.age;
-    if (UTILS_UNLIKELY(force || !rp->vertexAttribArray[index])) {
+    bool const changed = force || !rp->vertexAttribArray[index];
+    if (UTILS_UNLIKELY(changed)) {
         rp->vertexAttribArray.set(index);
         glEnableVertexAttribArray(index);
     }
+    countStateChange(StateChangeStats::Category::VERTEX_ARRAY, changed);
 }
 
 void OpenGLContext::disableVertexAttribArray(RenderPrimitive const* rp, GLuint index) noexcept {
     assert_invariant(rp);
     assert_invariant(index < rp->vertexAttribArray.size());
     bool const force = rp->stateVersion != state.age;
-    if (UTILS_UNLIKELY(force || rp->vertexAttribArray[index])) {
+    bool const changed = force || rp->vertexAttribArray[index];
+    if (UTILS_UNLIKELY(changed)) {
         rp->vertexAttribArray.unset(index);
         glDisableVertexAttribArray(index);
     }
+    countStateChange(StateChangeStats::Category::VERTEX_ARRAY, changed);
 }
 
 void OpenGLContext::enable(GLenum cap) noexcept {
     size_t const index = getIndexForCap(cap);
-    if (UTILS_UNLIKELY(!state.enables.caps[index])) {
+    bool const changed = !state.enables.caps[index];
+    if (UTILS_UNLIKELY(changed)) {
         state.enables.caps.set(index);
         glEnable(cap);
     }
+    countStateChange(StateChangeStats::Category::RASTER, changed);
 }
 
 void OpenGLContext::disable(GLenum cap) noexcept {
     size_t const index = getIndexForCap(cap);
-    if (UTILS_UNLIKELY(state.enables.caps[index])) {
+    bool const changed = state.enables.caps[index];
+    if (UTILS_UNLIKELY(changed)) {
         state.enables.caps.unset(index);
         glDisable(cap);
     }
+    countStateChange(StateChangeStats::Category::RASTER, changed);
 }
 
 void OpenGLContext::frontFace(GLenum mode) noexcept {
-    update_state(state.raster.frontFace, mode, [&]() {
+    update_state(StateChangeStats::Category::RASTER, state.raster.frontFace, mode, [&]() {
         glFrontFace(mode);
     });
 }
 
 void OpenGLContext::cullFace(GLenum mode) noexcept {
-    update_state(state.raster.cullFace, mode, [&]() {
+    update_state(StateChangeStats::Category::RASTER, state.raster.cullFace, mode, [&]() {
         glCullFace(mode);
     });
 }
 
 void OpenGLContext::blendEquation(GLenum modeRGB, GLenum modeA) noexcept {
-    if (UTILS_UNLIKELY(
-            state.raster.blendEquationRGB != modeRGB || state.raster.blendEquationA != modeA)) {
+    bool const changed =
+            state.raster.blendEquationRGB != modeRGB || state.raster.blendEquationA != modeA;
+    if (UTILS_UNLIKELY(changed)) {
         state.raster.blendEquationRGB = modeRGB;
         state.raster.blendEquationA   = modeA;
         glBlendEquationSeparate(modeRGB, modeA);
     }
+    countStateChange(StateChangeStats::Category::RASTER, changed);
 }
 
 void OpenGLContext::blendFunction(GLenum srcRGB, GLenum srcA, GLenum dstRGB, GLenum dstA) noexcept {
-    if (UTILS_UNLIKELY(
+    bool const changed =
             state.raster.blendFunctionSrcRGB != srcRGB ||
             state.raster.blendFunctionSrcA != srcA ||
             state.raster.blendFunctionDstRGB != dstRGB ||
-            state.raster.blendFunctionDstA != dstA)) {
+            state.raster.blendFunctionDstA != dstA;
+    if (UTILS_UNLIKELY(changed)) {
         state.raster.blendFunctionSrcRGB = srcRGB;
         state.raster.blendFunctionSrcA = srcA;
         state.raster.blendFunctionDstRGB = dstRGB;
         state.raster.blendFunctionDstA = dstA;
         glBlendFuncSeparate(srcRGB, dstRGB, srcA, dstA);
     }
+    countStateChange(StateChangeStats::Category::RASTER, changed);
 }
 
 void OpenGLContext::colorMask(GLboolean flag) noexcept {
-    update_state(state.raster.colorMask, flag, [&]() {
+    update_state(StateChangeStats::Category::RASTER, state.raster.colorMask, flag, [&]() {
         glColorMask(flag, flag, flag, flag);
     });
 }
 void OpenGLContext::depthMask(GLboolean flag) noexcept {
-    update_state(state.raster.depthMask, flag, [&]() {
+    update_state(StateChangeStats::Category::RASTER, state.raster.depthMask, flag, [&]() {
         glDepthMask(flag);
     });
 }
 
 void OpenGLContext::depthFunc(GLenum func) noexcept {
-    update_state(state.raster.depthFunc, func, [&]() {
+    update_state(StateChangeStats::Category::RASTER, state.raster.depthFunc, func, [&]() {
         glDepthFunc(func);
     });
 }
 
 void OpenGLContext::stencilFuncSeparate(GLenum funcFront, GLint refFront, GLuint maskFront,
         GLenum funcBack, GLint refBack, GLuint maskBack) noexcept {
-    update_state(state.stencil.front.func, {funcFront, refFront, maskFront}, [&]() {
+    update_state(StateChangeStats::Category::RASTER,
+            state.stencil.front.func, {funcFront, refFront, maskFront}, [&]() {
         glStencilFuncSeparate(GL_FRONT, funcFront, refFront, maskFront);
     });
-    update_state(state.stencil.back.func, {funcBack, refBack, maskBack}, [&]() {
+    update_state(StateChangeStats::Category::RASTER,
+            state.stencil.back.func, {funcBack, refBack, maskBack}, [&]() {
         glStencilFuncSeparate(GL_BACK, funcBack, refBack, maskBack);
     });
 }
 
 void OpenGLContext::stencilOpSeparate(GLenum sfailFront, GLenum dpfailFront, GLenum dppassFront,
         GLenum sfailBack, GLenum dpfailBack, GLenum dppassBack) noexcept {
-    update_state(state.stencil.front.op, {sfailFront, dpfailFront, dppassFront}, [&]() {
+    update_state(StateChangeStats::Category::RASTER,
+            state.stencil.front.op, {sfailFront, dpfailFront, dppassFront}, [&]() {
         glStencilOpSeparate(GL_FRONT, sfailFront, dpfailFront, dppassFront);
     });
-    update_state(state.stencil.back.op, {sfailBack, dpfailBack, dppassBack}, [&]() {
+    update_state(StateChangeStats::Category::RASTER,
+            state.stencil.back.op, {sfailBack, dpfailBack, dppassBack}, [&]() {
         glStencilOpSeparate(GL_BACK, sfailBack, dpfailBack, dppassBack);
     });
 }
 
 void OpenGLContext::stencilMaskSeparate(GLuint maskFront, GLuint maskBack) noexcept {
-    update_state(state.stencil.front.stencilMask, maskFront, [&]() {
+    update_state(StateChangeStats::Category::RASTER,
+            state.stencil.front.stencilMask, maskFront, [&]() {
         glStencilMaskSeparate(GL_FRONT, maskFront);
     });
-    update_state(state.stencil.back.stencilMask, maskBack, [&]() {
+    update_state(StateChangeStats::Category::RASTER,
+            state.stencil.back.stencilMask, maskBack, [&]() {
         glStencilMaskSeparate(GL_BACK, maskBack);
     });
 }
 
 void OpenGLContext::polygonOffset(GLfloat factor, GLfloat units) noexcept {
-    update_state(state.polygonOffset, { factor, units }, [&]() {
+    update_state(StateChangeStats::Category::RASTER, state.polygonOffset, { factor, units }, [&]() {
         if (factor != 0 || units != 0) {
             glPolygonOffset(factor, units);
             enable(GL_POLYGON_OFFSET_FILL);
@@ -211,7 +211,8 @@ OpenGLDriver::OpenGLDriver(OpenGLPlatform* platform, const Platform::DriverConfi
           mShaderCompilerService(*this),
           mHandleAllocator("Handles",
                   driverConfig.handleArenaSize,
-                  driverConfig.disableHandleUseAfterFreeCheck),
+                  driverConfig.disableHandleUseAfterFreeCheck,
+                  driverConfig.handleArenaPoolWeights),
           mDriverConfig(driverConfig),
           mCurrentPushConstants(new(std::nothrow) PushConstantBundle{}) {
 
@@ -276,6 +277,11 @@ void OpenGLDriver::terminate() {
 
     // because we called glFinish(), all callbacks should have been executed
     assert_invariant(mGpuCommandCompleteOps.empty());
+
+    for (ReadPixelsPbo const& pbo : mReadPixelsPbos) {
+        glDeleteBuffers(1, &pbo.id);
+    }
+    mReadPixelsPbos.clear();
 #endif
 
     delete mCurrentPushConstants;
@@ -352,7 +358,8 @@ bool OpenGLDriver::useProgram(OpenGLProgram* p) noexcept {
         for (uint32_t i = 0; i < Program::UNIFORM_BINDING_COUNT; i++) {
             auto [id, buffer, age] = mContext.getEs2UniformBinding(i);
             if (buffer) {
-                p->updateUniforms(i, id, buffer, age);
+                bool const uploaded = p->updateUniforms(i, id, buffer, age);
+                mContext.countStateChange(StateChangeStats::Category::UNIFORM, uploaded);
             }
         }
         // Set the output colorspace for this program (linear or rec709). This in only relevant
@@ -1571,6 +1578,12 @@ void OpenGLDriver::destroyBufferObject(Handle<HwBufferObject> boh) {
         if (UTILS_UNLIKELY(bo->bindingType == BufferObjectBinding::UNIFORM && gl.isES2())) {
             free(bo->gl.buffer);
         } else {
+#ifndef FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2
+            if (UTILS_UNLIKELY(bo->stream)) {
+                destroyStreamRing(const_cast<GLBufferObject*>(bo));
+            }
+#endif
+            // this also unmaps the storage of stream rings
             gl.deleteBuffers(1, &bo->gl.id, bo->gl.binding);
         }
         destruct(boh, bo);
@@ -2081,6 +2094,11 @@ bool OpenGLDriver::isProtectedTexturesSupported() {
     return getContext().ext.EXT_protected_textures;
 }
 
+bool OpenGLDriver::isIndirectDrawSupported() {
+    // glDrawElementsIndirect() is core in OpenGL 4.3 and OpenGL ES 3.1
+    return mContext.isAtLeastGL<4, 3>() || mContext.isAtLeastGLES<3, 1>();
+}
+
 bool OpenGLDriver::isWorkaroundNeeded(Workaround workaround) {
     switch (workaround) {
         case Workaround::SPLIT_EASU:
@@ -2093,12 +2111,23 @@ bool OpenGLDriver::isWorkaroundNeeded(Workaround workaround) {
             return mContext.bugs.disable_blit_into_texture_array;
         case Workaround::POWER_VR_SHADER_WORKAROUNDS:
             return mContext.bugs.powervr_shader_workarounds;
+        case Workaround::DISABLE_TAA_COLOR_GRADING_SUBPASS:
+            return mContext.bugs.disable_taa_color_grading_subpass;
         default:
             return false;
     }
     return false;
 }
 
+StateChangeStats OpenGLDriver::getStateChangeStats() {
+    std::lock_guard const lock(mStateChangeStatsLock);
+    return mStateChangeStats;
+}
+
+HandleAllocatorStats OpenGLDriver::getHandleAllocatorStats() {
+    return mHandleAllocator.getStats();
+}
+
 FeatureLevel OpenGLDriver::getFeatureLevel() {
     return mContext.getFeatureLevel();
 }
@@ -2231,7 +2260,17 @@ void OpenGLDriver::updateBufferObject(
         bo->age++;
     } else {
         assert_invariant(bo->gl.id);
+        if (bo->bindingType == BufferObjectBinding::UNIFORM) {
+            gl.countStateChange(StateChangeStats::Category::UNIFORM, true);
+        }
         gl.bindBuffer(bo->gl.binding, bo->gl.id);
+#ifndef FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2
+        if (GLStreamRing const* const ring = getStreamRing(bo)) {
+            // the storage of a stream ring is immutable, but it can be updated
+            glBufferSubData(bo->gl.binding, ring->getOffset() + byteOffset,
+                    (GLsizeiptr)bd.size, bd.buffer);
+        } else
+#endif
         if (byteOffset == 0 && bd.size == bo->byteCount) {
             // it looks like it's generally faster (or not worse) to use glBufferData()
             glBufferData(bo->gl.binding, (GLsizeiptr)bd.size, bd.buffer, getBufferUsage(bo->usage));
@@ -2265,7 +2304,11 @@ void OpenGLDriver::updateBufferObjectUnsynchronized(
         assert_invariant(bo->gl.id);
         assert_invariant(bd.size + byteOffset <= bo->byteCount);
 
-        if (bo->gl.binding != GL_UNIFORM_BUFFER) {
+        if (GLStreamRing const* const ring = getStreamRing(bo)) {
+            // the mapping is coherent, the write is visible to the GPU without further ado
+            memcpy(ring->data + ring->getOffset() + byteOffset, bd.buffer, bd.size);
+            scheduleDestroy(std::move(bd));
+        } else if (bo->gl.binding != GL_UNIFORM_BUFFER) {
             // TODO: use updateBuffer() for all types of buffer? Make sure GL supports that.
             updateBufferObject(boh, std::move(bd), byteOffset);
         } else {
@@ -2305,11 +2348,108 @@ void OpenGLDriver::resetBufferObject(Handle<HwBufferObject> boh) {
         // nothing to do here
     } else {
         assert_invariant(bo->gl.id);
+#ifndef FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2
+        // Buffers that are orphaned are rewritten every frame, which is what stream rings are
+        // for. The ring replaces the buffer's storage the first time, its content is undefined
+        // after this call anyway.
+        if (GLStreamRing* const ring = getStreamRing(bo)) {
+            advanceStreamRing(*ring);
+            return;
+        }
+        if (bo->bindingType == BufferObjectBinding::UNIFORM && createStreamRing(bo)) {
+            return;
+        }
+#endif
         gl.bindBuffer(bo->gl.binding, bo->gl.id);
         glBufferData(bo->gl.binding, bo->byteCount, nullptr, getBufferUsage(bo->usage));
     }
 }
 
+#ifndef FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2
+bool OpenGLDriver::createStreamRing(GLBufferObject* bo) noexcept {
+    auto& gl = mContext;
+    if constexpr (!HAS_MAPBUFFERS) {
+        return false;
+    }
+    if (!gl.ext.EXT_buffer_storage || gl.isES2() ||
+            mStreamRings.size() - mFreeStreamRings.size() >= std::numeric_limits<uint16_t>::max()) {
+        return false;
+    }
+
+#if defined(BACKEND_OPENGL_VERSION_GL)
+    auto bufferStorage = glBufferStorage;
+    GLbitfield const mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLbitfield const storageFlags = mapFlags | GL_DYNAMIC_STORAGE_BIT;
+#elif defined(GL_EXT_buffer_storage)
+    auto bufferStorage = glBufferStorageEXT;
+    GLbitfield const mapFlags =
+            GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT_EXT | GL_MAP_COHERENT_BIT_EXT;
+    GLbitfield const storageFlags = mapFlags | GL_DYNAMIC_STORAGE_BIT_EXT;
+#else
+    return false;
+#endif
+
+#if defined(BACKEND_OPENGL_VERSION_GL) || defined(GL_EXT_buffer_storage)
+    uint32_t const alignment = std::max(GLint(1), gl.gets.uniform_buffer_offset_alignment);
+    uint32_t const stride = (bo->byteCount + alignment - 1) / alignment * alignment;
+    GLsizeiptr const size = GLsizeiptr(stride) * GLStreamRing::REGION_COUNT;
+
+    GLuint id;
+    glGenBuffers(1, &id);
+    gl.bindBuffer(bo->gl.binding, id);
+    bufferStorage(bo->gl.binding, size, nullptr, storageFlags);
+    void* const data = glMapBufferRange(bo->gl.binding, 0, size, mapFlags);
+    if (UTILS_UNLIKELY(!data)) {
+        // it's not a problem, we just keep using the regular buffer
+        gl.deleteBuffers(1, &id, bo->gl.binding);
+        (void)glGetError();
+        return false;
+    }
+
+    gl.deleteBuffers(1, &bo->gl.id, bo->gl.binding);
+    bo->gl.id = id;
+
+    GLStreamRing const ring{ .data = static_cast<uint8_t*>(data), .stride = stride };
+    if (mFreeStreamRings.empty()) {
+        mStreamRings.push_back(ring);
+        bo->stream = uint16_t(mStreamRings.size());
+    } else {
+        bo->stream = mFreeStreamRings.back();
+        mFreeStreamRings.pop_back();
+        mStreamRings[bo->stream - 1] = ring;
+    }
+    CHECK_GL_ERROR(utils::slog.e)
+    return true;
+#endif
+}
+
+void OpenGLDriver::advanceStreamRing(GLStreamRing& ring) noexcept {
+    // The GPU is done with the region we're leaving once the commands issued so far complete.
+    // Draws that come after the reset bind the next region.
+    ring.fences[ring.region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ring.region = (ring.region + 1) % GLStreamRing::REGION_COUNT;
+    if (GLsync const fence = ring.fences[ring.region]) {
+        // this only blocks when the GPU is REGION_COUNT - 1 frames behind
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, std::numeric_limits<GLuint64>::max());
+        glDeleteSync(fence);
+        ring.fences[ring.region] = nullptr;
+    }
+    CHECK_GL_ERROR(utils::slog.e)
+}
+
+void OpenGLDriver::destroyStreamRing(GLBufferObject* bo) noexcept {
+    GLStreamRing& ring = mStreamRings[bo->stream - 1];
+    for (GLsync& fence : ring.fences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+    ring = {};
+    mFreeStreamRings.push_back(bo->stream);
+    bo->stream = 0;
+}
+#endif
+
 void OpenGLDriver::updateSamplerGroup(Handle<HwSamplerGroup> sbh,
         BufferDescriptor&& data) {
     DEBUG_MARKER()
@@ -3105,6 +3245,12 @@ void OpenGLDriver::bindBufferRange(BufferObjectBinding bindingType, uint32_t ind
         assert_invariant(bindingType == BufferObjectBinding::SHADER_STORAGE ||
                          ub->gl.binding == target);
 
+#ifndef FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2
+        if (GLStreamRing const* const ring = getStreamRing(ub)) {
+            offset += ring->getOffset();
+        }
+#endif
+
         gl.bindBufferRange(target, GLuint(index), ub->gl.id, offset, size);
     }
 
@@ -3263,10 +3409,8 @@ void OpenGLDriver::readPixels(Handle<HwRenderTarget> src,
     // which we're always emulating. So if we have a resolved fbo (fbo_read), use that instead.
     gl.bindFramebuffer(GL_READ_FRAMEBUFFER, s->gl.fbo_read ? s->gl.fbo_read : s->gl.fbo);
 
-    GLuint pbo;
-    glGenBuffers(1, &pbo);
-    gl.bindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
-    glBufferData(GL_PIXEL_PACK_BUFFER, pboSize, nullptr, GL_STATIC_DRAW);
+    ReadPixelsPbo const pbo = acquireReadPixelsPbo(pboSize);
+    gl.bindBuffer(GL_PIXEL_PACK_BUFFER, pbo.id);
     glReadPixels(GLint(x), GLint(y), GLint(width), GLint(height), glFormat, glType, nullptr);
     gl.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
     CHECK_GL_ERROR(utils::slog.e)
@@ -3277,7 +3421,7 @@ void OpenGLDriver::readPixels(Handle<HwRenderTarget> src,
     whenGpuCommandsComplete([this, width, height, pbo, pboSize, pUserBuffer]() mutable {
         PixelBufferDescriptor& p = *pUserBuffer;
         auto& gl = mContext;
-        gl.bindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        gl.bindBuffer(GL_PIXEL_PACK_BUFFER, pbo.id);
         void* vaddr = nullptr;
 #if defined(__EMSCRIPTEN__)
         std::unique_ptr<uint8_t[]> clientBuffer = std::make_unique<uint8_t[]>(pboSize);
@@ -3306,7 +3450,7 @@ void OpenGLDriver::readPixels(Handle<HwRenderTarget> src,
 #endif
         }
         gl.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-        glDeleteBuffers(1, &pbo);
+        releaseReadPixelsPbo(pbo);
         scheduleDestroy(std::move(p));
         delete pUserBuffer;
         CHECK_GL_ERROR(utils::slog.e)
@@ -3314,6 +3458,39 @@ void OpenGLDriver::readPixels(Handle<HwRenderTarget> src,
 #endif
 }
 
+#ifndef FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2
+OpenGLDriver::ReadPixelsPbo OpenGLDriver::acquireReadPixelsPbo(GLsizeiptr const size) noexcept {
+    // pick the smallest pooled buffer that is large enough
+    auto best = mReadPixelsPbos.end();
+    for (auto it = mReadPixelsPbos.begin(); it != mReadPixelsPbos.end(); ++it) {
+        if (it->size >= size && (best == mReadPixelsPbos.end() || it->size < best->size)) {
+            best = it;
+        }
+    }
+    if (best != mReadPixelsPbos.end()) {
+        ReadPixelsPbo const pbo = *best;
+        mReadPixelsPbos.erase(best);
+        return pbo;
+    }
+
+    auto& gl = mContext;
+    ReadPixelsPbo pbo{ 0, size };
+    glGenBuffers(1, &pbo.id);
+    gl.bindBuffer(GL_PIXEL_PACK_BUFFER, pbo.id);
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    return pbo;
+}
+
+void OpenGLDriver::releaseReadPixelsPbo(ReadPixelsPbo const pbo) noexcept {
+    if (mReadPixelsPbos.size() >= MAX_POOLED_READ_PIXELS_PBO_COUNT) {
+        // evict the oldest buffer, it's the least likely to match the next requests
+        glDeleteBuffers(1, &mReadPixelsPbos.front().id);
+        mReadPixelsPbos.erase(mReadPixelsPbos.begin());
+    }
+    mReadPixelsPbos.push_back(pbo);
+}
+#endif
+
 void OpenGLDriver::readBufferSubData(backend::BufferObjectHandle boh,
         uint32_t offset, uint32_t size, backend::BufferDescriptor&& p) {
     UTILS_UNUSED_IN_RELEASE auto& gl = mContext;
@@ -3496,6 +3673,12 @@ void OpenGLDriver::endFrame(UTILS_UNUSED uint32_t frameId) {
     //glFinish();
     mPlatform.endFrame(frameId);
     insertEventMarker("endFrame");
+
+    {
+        std::lock_guard const lock(mStateChangeStatsLock);
+        mStateChangeStats = mContext.getStateChangeStats();
+    }
+    mContext.resetStateChangeStats();
 }
 
 void OpenGLDriver::flush(int) {
@@ -3936,6 +4119,52 @@ void OpenGLDriver::draw(PipelineState state, Handle<HwRenderPrimitive> rph,
     }
 }
 
+void OpenGLDriver::drawIndirect(Handle<HwBufferObject> boh,
+        uint32_t const byteOffset, uint32_t const drawCount, uint32_t const stride) {
+    DEBUG_MARKER()
+    GLRenderPrimitive const* const rp = mBoundRenderPrimitive;
+    if (UTILS_UNLIKELY(!rp || !mValidProgram || !drawCount)) {
+        return;
+    }
+
+#if !defined(FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2) && defined(BACKEND_OPENGL_LEVEL_GLES31)
+    assert_invariant(isIndirectDrawSupported());
+
+#if defined(__ANDROID__)
+    // on Android, GLES3.1 and above entry-points are defined in glext
+    // (this is temporary, until we phase-out API < 21)
+    using glext::glDrawElementsIndirect;
+#endif
+
+    auto& gl = mContext;
+    GLBufferObject const* const bo = handle_cast<GLBufferObject*>(boh);
+    assert_invariant(bo->bindingType == BufferObjectBinding::SHADER_STORAGE);
+    assert_invariant(byteOffset + (drawCount - 1) * stride +
+            sizeof(DrawIndexedIndirectCommand) <= bo->byteCount);
+
+    gl.bindBuffer(GL_DRAW_INDIRECT_BUFFER, bo->gl.id);
+
+#if defined(BACKEND_OPENGL_VERSION_GL)
+    glMultiDrawElementsIndirect(GLenum(rp->type), rp->gl.getIndicesType(),
+            reinterpret_cast<const void*>(uintptr_t(byteOffset)),
+            GLsizei(drawCount), GLsizei(stride));
+#else
+    // OpenGL ES doesn't have multi-draw without GL_EXT_multi_draw_indirect, and baseInstance
+    // must be zero.
+    for (uint32_t i = 0; i < drawCount; i++) {
+        glDrawElementsIndirect(GLenum(rp->type), rp->gl.getIndicesType(),
+                reinterpret_cast<const void*>(uintptr_t(byteOffset + i * stride)));
+    }
+#endif
+#endif
+
+#if FILAMENT_ENABLE_MATDBG
+    CHECK_GL_ERROR_NON_FATAL(utils::slog.e)
+#else
+    CHECK_GL_ERROR(utils::slog.e)
+#endif
+}
+
 void OpenGLDriver::dispatchCompute(Handle<HwProgram> program, math::uint3 workGroupCount) {
     getShaderCompilerService().tick();
 
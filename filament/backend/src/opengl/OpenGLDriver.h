@@ -364,6 +364,26 @@ private:
 
     void whenFrameComplete(const std::function<void()>& fn) noexcept;
     std::vector<std::function<void()>> mFrameCompleteOps;
+
+    // pixel pack buffers of completed readPixels requests, recycled for the next ones
+    static constexpr size_t MAX_POOLED_READ_PIXELS_PBO_COUNT = 4;
+    struct ReadPixelsPbo {
+        GLuint id;
+        GLsizeiptr size;
+    };
+    ReadPixelsPbo acquireReadPixelsPbo(GLsizeiptr size) noexcept;
+    void releaseReadPixelsPbo(ReadPixelsPbo pbo) noexcept;
+    std::vector<ReadPixelsPbo> mReadPixelsPbos;
+
+    // persistently mapped storage of the uniform buffers that are orphaned every frame
+    GLStreamRing* getStreamRing(GLBufferObject const* bo) noexcept {
+        return bo->stream ? &mStreamRings[bo->stream - 1] : nullptr;
+    }
+    bool createStreamRing(GLBufferObject* bo) noexcept;
+    void advanceStreamRing(GLStreamRing& ring) noexcept;
+    void destroyStreamRing(GLBufferObject* bo) noexcept;
+    std::vector<GLStreamRing> mStreamRings;
+    std::vector<uint16_t> mFreeStreamRings;
 #endif
 
     // tasks regularly executed on the main thread at until they return true
@@ -379,6 +399,10 @@ private:
     bool mRec709OutputColorspace = false;
 
     PushConstantBundle* mCurrentPushConstants = nullptr;
+
+    // state changes of the last frame, read from the user thread by getStateChangeStats()
+    std::mutex mStateChangeStatsLock;
+    StateChangeStats mStateChangeStats;
 };
 
 // ------------------------------------------------------------------------------------------------
@@ -256,14 +256,14 @@ void OpenGLProgram::updateSamplers(OpenGLDriver* const gld) const noexcept {
     CHECK_GL_ERROR(utils::slog.e)
 }
 
-void OpenGLProgram::updateUniforms(uint32_t index, GLuint id, void const* buffer, uint16_t age) noexcept {
+bool OpenGLProgram::updateUniforms(uint32_t index, GLuint id, void const* buffer, uint16_t age) noexcept {
     assert_invariant(mUniformsRecords);
     assert_invariant(buffer);
 
     // only update the uniforms if the UBO has changed since last time we updated
     UniformsRecord const& records = mUniformsRecords[index];
     if (records.id == id && records.age == age) {
-        return;
+        return false;
     }
     records.id = id;
     records.age = age;
@@ -327,6 +327,7 @@ void OpenGLProgram::updateUniforms(uint32_t index, GLuint id, void const* buffer
                 break;
         }
     }
+    return true;
 }
 
 void OpenGLProgram::setRec709ColorSpace(bool rec709) const noexcept {
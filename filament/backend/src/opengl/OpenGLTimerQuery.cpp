@@ -103,7 +103,7 @@ TimerQueryResult TimerQueryFactoryInterface::getTimerQueryValue(
 #if defined(BACKEND_OPENGL_VERSION_GL) || defined(GL_EXT_disjoint_timer_query)
 
 TimerQueryNativeFactory::TimerQueryNativeFactory(OpenGLContext& context)
-        : mContext(context) {
+        : mContext(context), mUseTimestamps(context.procs.queryCounter != nullptr) {
 }
 
 TimerQueryNativeFactory::~TimerQueryNativeFactory() = default;
@@ -113,6 +113,9 @@ void TimerQueryNativeFactory::createTimerQuery(GLTimerQuery* tq) {
 
     tq->state = std::make_shared<GLTimerQuery::State>();
     mContext.procs.genQueries(1u, &tq->state->gl.query);
+    if (mUseTimestamps) {
+        mContext.procs.genQueries(1u, &tq->state->gl.end);
+    }
     CHECK_GL_ERROR(utils::slog.e)
 }
 
@@ -120,6 +123,9 @@ void TimerQueryNativeFactory::destroyTimerQuery(GLTimerQuery* tq) {
     assert_invariant(tq->state);
 
     mContext.procs.deleteQueries(1u, &tq->state->gl.query);
+    if (mUseTimestamps) {
+        mContext.procs.deleteQueries(1u, &tq->state->gl.end);
+    }
     CHECK_GL_ERROR(utils::slog.e)
 
     tq->state.reset();
@@ -129,23 +135,34 @@ void TimerQueryNativeFactory::beginTimeElapsedQuery(GLTimerQuery* tq) {
     assert_invariant(tq->state);
 
     tq->state->elapsed.store(int64_t(TimerQueryResult::NOT_READY), std::memory_order_relaxed);
-    mContext.procs.beginQuery(GL_TIME_ELAPSED, tq->state->gl.query);
+    if (mUseTimestamps) {
+        mContext.procs.queryCounter(tq->state->gl.query, GL_TIMESTAMP);
+    } else {
+        mContext.procs.beginQuery(GL_TIME_ELAPSED, tq->state->gl.query);
+    }
     CHECK_GL_ERROR(utils::slog.e)
 }
 
 void TimerQueryNativeFactory::endTimeElapsedQuery(OpenGLDriver& driver, GLTimerQuery* tq) {
     assert_invariant(tq->state);
 
-    mContext.procs.endQuery(GL_TIME_ELAPSED);
+    if (mUseTimestamps) {
+        mContext.procs.queryCounter(tq->state->gl.end, GL_TIMESTAMP);
+    } else {
+        mContext.procs.endQuery(GL_TIME_ELAPSED);
+    }
     CHECK_GL_ERROR(utils::slog.e)
 
     std::weak_ptr<GLTimerQuery::State> const weak = tq->state;
 
-    driver.runEveryNowAndThen([&context = mContext, weak]() -> bool {
+    driver.runEveryNowAndThen([&context = mContext, weak,
+            useTimestamps = mUseTimestamps]() -> bool {
         auto state = weak.lock();
         if (state) {
+            // the end timestamp is written last, so once it's available, both are
+            GLuint const last = useTimestamps ? state->gl.end : state->gl.query;
             GLuint available = 0;
-            context.procs.getQueryObjectuiv(state->gl.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            context.procs.getQueryObjectuiv(last, GL_QUERY_RESULT_AVAILABLE, &available);
             CHECK_GL_ERROR(utils::slog.e)
             if (!available) {
                 // we need to try this one again later
@@ -154,6 +171,12 @@ void TimerQueryNativeFactory::endTimeElapsedQuery(OpenGLDriver& driver, GLTimerQ
             GLuint64 elapsedTime = 0;
             // we won't end-up here if we're on ES and don't have GL_EXT_disjoint_timer_query
             context.procs.getQueryObjectui64v(state->gl.query, GL_QUERY_RESULT, &elapsedTime);
+            if (useTimestamps) {
+                GLuint64 end = 0;
+                context.procs.getQueryObjectui64v(state->gl.end, GL_QUERY_RESULT, &end);
+                // a zero elapsed time would read as NOT_READY
+                elapsedTime = end > elapsedTime ? end - elapsedTime : 1;
+            }
             state->elapsed.store((int64_t)elapsedTime, std::memory_order_relaxed);
         } else {
             state->elapsed.store(int64_t(TimerQueryResult::ERROR), std::memory_order_relaxed);
@@ -46,6 +46,7 @@ struct GLTimerQuery : public HwTimerQuery {
     struct State {
         struct {
             GLuint query;
+            GLuint end;     // only used with timestamp queries
         } gl;
         int64_t then{};
         std::atomic<int64_t> elapsed{};
@@ -99,6 +100,9 @@ private:
     void beginTimeElapsedQuery(GLTimerQuery* query) override;
     void endTimeElapsedQuery(OpenGLDriver& driver, GLTimerQuery* query) override;
     OpenGLContext& mContext;
+    // GL_TIME_ELAPSED queries can't be nested, timestamps can. We use them when available so
+    // that e.g. the passes of a frame can be timed while the whole frame is.
+    bool const mUseTimestamps;
 };
 
 #endif
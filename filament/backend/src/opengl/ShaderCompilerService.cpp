@@ -209,6 +209,11 @@ void ShaderCompilerService::init() noexcept {
             priority = JobSystem::Priority::BACKGROUND;
         }
 
+        // the user knows best
+        if (uint32_t const count = mDriver.getDriverConfig().shaderCompilerThreadCount) {
+            poolSize = count;
+        }
+
         mShaderCompilerThreadCount = poolSize;
         mCompilerThreadPool.init(mShaderCompilerThreadCount,
                 [&platform = mDriver.mPlatform, priority]() {
@@ -223,6 +228,17 @@ void ShaderCompilerService::init() noexcept {
                     // release context and thread state
                     platform.releaseContext();
                 });
+
+        // Load the programs that were used most recently by previous runs ahead of time. They
+        // are queued in the background, so that all the programs that are requested come first.
+        auto keys = mBlobCache.loadUsage(mDriver.mPlatform,
+                mDriver.getDriverConfig().programCachePrewarmCount);
+        for (auto& key: keys) {
+            mCompilerThreadPool.queueBackground(
+                    [this, key = std::move(key)]() {
+                        mBlobCache.prewarm(mDriver.mPlatform, key);
+                    });
+        }
     }
 }
 
@@ -232,6 +248,9 @@ void ShaderCompilerService::terminate() noexcept {
     // backend thread, and if we're here, we're on the backend main thread).
     mCompilerThreadPool.terminate();
 
+    mBlobCache.saveUsage(mDriver.mPlatform);
+    mBlobCache.terminate();
+
     mRunAtNextTickOps.clear();
 
     // We could have some pending callbacks here, we need to execute them.
@@ -409,6 +428,12 @@ void ShaderCompilerService::tick() {
     if (UTILS_UNLIKELY(mMode != Mode::THREAD_POOL)) {
         executeTickOps();
     }
+
+    // The usage record of the blob cache is saved regularly, rather than only in terminate(),
+    // because applications are not always terminated cleanly.
+    if (UTILS_UNLIKELY(++mTickCount % USAGE_SAVE_INTERVAL == 0)) {
+        mBlobCache.saveUsage(mDriver.mPlatform);
+    }
 }
 
 void ShaderCompilerService::notifyWhenAllProgramsAreReady(
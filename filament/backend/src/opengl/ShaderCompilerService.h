@@ -121,6 +121,10 @@ private:
     CompilerThreadPool mCompilerThreadPool;
 
     uint32_t mShaderCompilerThreadCount = 0u;
+
+    // number of ticks between two saves of the blob cache's usage record
+    static constexpr uint32_t USAGE_SAVE_INTERVAL = 120;
+    uint32_t mTickCount = 0;
     Mode mMode = Mode::UNDEFINED; // valid after init() is called
 
     using ContainerType = std::tuple<CompilerPriorityQueue, program_token_t, Job>;
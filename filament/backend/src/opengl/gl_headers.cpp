@@ -52,6 +52,7 @@ PFNGLBEGINQUERYEXTPROC glBeginQueryEXT;
 PFNGLENDQUERYEXTPROC glEndQueryEXT;
 PFNGLGETQUERYOBJECTUIVEXTPROC glGetQueryObjectuivEXT;
 PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64vEXT;
+PFNGLQUERYCOUNTEREXTPROC glQueryCounterEXT;
 #endif
 #ifdef GL_OES_vertex_array_object
 PFNGLBINDVERTEXARRAYOESPROC glBindVertexArrayOES;
@@ -61,6 +62,9 @@ PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOES;
 #ifdef GL_EXT_clip_control
 PFNGLCLIPCONTROLEXTPROC glClipControlEXT;
 #endif
+#ifdef GL_EXT_buffer_storage
+PFNGLBUFFERSTORAGEEXTPROC glBufferStorageEXT;
+#endif
 #ifdef GL_EXT_discard_framebuffer
 PFNGLDISCARDFRAMEBUFFEREXTPROC glDiscardFramebufferEXT;
 #endif
@@ -75,6 +79,7 @@ PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC glFramebufferTextureMultiviewOVR;
 // On Android, If we want to support a build system less than ANDROID_API 21, we need to
 // use getProcAddress for ES3.1 and above entry points.
 PFNGLDISPATCHCOMPUTEPROC glDispatchCompute;
+PFNGLDRAWELEMENTSINDIRECTPROC glDrawElementsIndirect;
 #endif
 static std::once_flag sGlExtInitialized;
 #endif // __EMSCRIPTEN__
@@ -105,6 +110,7 @@ void importGLESExtensionsEntryPoints() {
     getProcAddress(glEndQueryEXT, "glEndQueryEXT");
     getProcAddress(glGetQueryObjectuivEXT, "glGetQueryObjectuivEXT");
     getProcAddress(glGetQueryObjectui64vEXT, "glGetQueryObjectui64vEXT");
+    getProcAddress(glQueryCounterEXT, "glQueryCounterEXT");
 #endif
 #if defined(GL_OES_vertex_array_object)
     getProcAddress(glBindVertexArrayOES, "glBindVertexArrayOES");
@@ -114,6 +120,9 @@ void importGLESExtensionsEntryPoints() {
 #ifdef GL_EXT_clip_control
     getProcAddress(glClipControlEXT, "glClipControlEXT");
 #endif
+#ifdef GL_EXT_buffer_storage
+    getProcAddress(glBufferStorageEXT, "glBufferStorageEXT");
+#endif
 #ifdef GL_EXT_discard_framebuffer
         getProcAddress(glDiscardFramebufferEXT, "glDiscardFramebufferEXT");
 #endif
@@ -125,6 +134,7 @@ void importGLESExtensionsEntryPoints() {
 #endif
 #if defined(__ANDROID__) && !defined(FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2)
         getProcAddress(glDispatchCompute, "glDispatchCompute");
+        getProcAddress(glDrawElementsIndirect, "glDrawElementsIndirect");
 #endif
     });
 #endif // __EMSCRIPTEN__
@@ -132,6 +132,9 @@ extern PFNGLGETDEBUGMESSAGELOGKHRPROC glGetDebugMessageLogKHR;
 #ifdef GL_EXT_clip_control
 extern PFNGLCLIPCONTROLEXTPROC glClipControlEXT;
 #endif
+#ifdef GL_EXT_buffer_storage
+extern PFNGLBUFFERSTORAGEEXTPROC glBufferStorageEXT;
+#endif
 #ifdef GL_EXT_disjoint_timer_query
 extern PFNGLGENQUERIESEXTPROC glGenQueriesEXT;
 extern PFNGLDELETEQUERIESEXTPROC glDeleteQueriesEXT;
@@ -139,6 +142,7 @@ extern PFNGLBEGINQUERYEXTPROC glBeginQueryEXT;
 extern PFNGLENDQUERYEXTPROC glEndQueryEXT;
 extern PFNGLGETQUERYOBJECTUIVEXTPROC glGetQueryObjectuivEXT;
 extern PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64vEXT;
+extern PFNGLQUERYCOUNTEREXTPROC glQueryCounterEXT;
 #endif
 #ifdef GL_OES_vertex_array_object
 extern PFNGLBINDVERTEXARRAYOESPROC glBindVertexArrayOES;
@@ -156,6 +160,7 @@ extern PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC glFramebufferTextureMultiviewOVR;
 #endif
 #if defined(__ANDROID__) && !defined(FILAMENT_SILENCE_NOT_SUPPORTED_BY_ES2)
 extern PFNGLDISPATCHCOMPUTEPROC glDispatchCompute;
+extern PFNGLDRAWELEMENTSINDIRECTPROC glDrawElementsIndirect;
 #endif
 #endif // __EMSCRIPTEN__
 } // namespace glext
@@ -168,6 +173,9 @@ using namespace glext;
 
 #ifdef GL_EXT_disjoint_timer_query
 #   define GL_TIME_ELAPSED                          GL_TIME_ELAPSED_EXT
+#   ifndef GL_TIMESTAMP
+#       define GL_TIMESTAMP                         GL_TIMESTAMP_EXT
+#   endif
 #   ifndef GL_ES_VERSION_3_0
 #       define GL_QUERY_RESULT_AVAILABLE            GL_QUERY_RESULT_AVAILABLE_EXT
 #       define GL_QUERY_RESULT                      GL_QUERY_RESULT_EXT
@@ -15,6 +15,7 @@
  */
 
 #include "VulkanBuffer.h"
+#include "VulkanConstants.h"
 #include "VulkanMemory.h"
 
 #include <utils/Panic.h>
@@ -29,9 +30,12 @@ VulkanBuffer::VulkanBuffer(VmaAllocator allocator, VulkanStagePool& stagePool,
       mStagePool(stagePool),
       mUsage(usage),
       mUpdatedBytes(0) {
-    // for now make sure that only 1 bit is set in usage
-    // (because loadFromCpu() assumes that somewhat)
-    assert_invariant(usage && !(usage & (usage - 1)));
+    // for now make sure that only 1 bit is set in usage, besides the indirect bit which only
+    // accompanies storage buffers (because loadFromCpu() assumes that somewhat)
+    VkBufferUsageFlags const mainUsage = usage & ~VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    assert_invariant(mainUsage && !(mainUsage & (mainUsage - 1)));
+    assert_invariant(mainUsage == VK_BUFFER_USAGE_STORAGE_BUFFER_BIT ||
+            !(usage & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT));
 
     // Create the VkBuffer.
     VkBufferCreateInfo bufferInfo {
@@ -48,14 +52,64 @@ VulkanBuffer::~VulkanBuffer() {
     vmaDestroyBuffer(mAllocator, mGpuBuffer, mGpuMemory);
 }
 
-void VulkanBuffer::loadFromCpu(VkCommandBuffer cmdbuf, const void* cpuData, uint32_t byteOffset,
+void VulkanBuffer::loadFromCpu(VulkanCommands& commands, const void* cpuData, uint32_t byteOffset,
         uint32_t numBytes) {
-    VulkanStage const* stage = mStagePool.acquireStage(numBytes);
-    void* mapped;
-    vmaMapMemory(mAllocator, stage->memory, &mapped);
-    memcpy(mapped, cpuData, numBytes);
-    vmaUnmapMemory(mAllocator, stage->memory);
-    vmaFlushAllocation(mAllocator, stage->memory, byteOffset, numBytes);
+    VkBuffer srcBuffer;
+    VkDeviceSize srcOffset;
+    if (numBytes <= FVK_STAGE_SEGMENT_MAX_SIZE) {
+        // small updates (uniforms, bones, morph weights...) share persistently mapped stages
+        VulkanStageSegment const segment = mStagePool.acquireStageSegment(numBytes);
+        memcpy(segment.mapped, cpuData, numBytes);
+        vmaFlushAllocation(mAllocator, segment.stage->memory, segment.offset, numBytes);
+        srcBuffer = segment.stage->buffer;
+        srcOffset = segment.offset;
+    } else {
+        VulkanStage const* stage = mStagePool.acquireStage(numBytes);
+        void* mapped;
+        vmaMapMemory(mAllocator, stage->memory, &mapped);
+        memcpy(mapped, cpuData, numBytes);
+        vmaUnmapMemory(mAllocator, stage->memory);
+        vmaFlushAllocation(mAllocator, stage->memory, 0, numBytes);
+        srcBuffer = stage->buffer;
+        srcOffset = 0;
+    }
+
+    VkCommandBuffer const cmdbuf = commands.get().buffer();
+    VkBufferCopy region {
+            .srcOffset = srcOffset,
+            .dstOffset = byteOffset,
+            .size = numBytes,
+    };
+
+    // The first upload can't conflict with any earlier command, so it is done on the dedicated
+    // transfer queue when there is one, and then handed over to the graphics queue.
+    VkCommandBuffer const transferbuf =
+            mUpdatedBytes == 0 ? commands.getTransfer() : VK_NULL_HANDLE;
+    if (transferbuf != VK_NULL_HANDLE) {
+        vkCmdCopyBuffer(transferbuf, srcBuffer, mGpuBuffer, 1, &region);
+        mUpdatedBytes = numBytes;
+
+        VkBufferMemoryBarrier barrier{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = 0,
+            .srcQueueFamilyIndex = commands.getTransferQueueFamilyIndex(),
+            .dstQueueFamilyIndex = commands.getQueueFamilyIndex(),
+            .buffer = mGpuBuffer,
+            .size = VK_WHOLE_SIZE,
+        };
+        vkCmdPipelineBarrier(transferbuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+        // The matching acquire operation, the semaphore wait takes care of the execution
+        // dependency. We use the same access masks as below.
+        auto const [dstAccessMask, dstStageMask] = getDstAccessAndStage();
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = dstAccessMask;
+        vkCmdPipelineBarrier(cmdbuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStageMask, 0, 0,
+                nullptr, 1, &barrier, 0, nullptr);
+        return;
+    }
 
     // If there was a previous update, then we need to make sure the following write is properly
     // synced with the previous read.
@@ -71,6 +125,9 @@ void VulkanBuffer::loadFromCpu(VkCommandBuffer cmdbuf, const void* cpuData, uint
         } else if (mUsage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT) {
             srcAccess = VK_ACCESS_INDEX_READ_BIT;
             srcStage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        } else if (mUsage & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT) {
+            srcAccess = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+            srcStage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
         }
 
         VkBufferMemoryBarrier barrier{
@@ -86,12 +143,7 @@ void VulkanBuffer::loadFromCpu(VkCommandBuffer cmdbuf, const void* cpuData, uint
                 &barrier, 0, nullptr);
     }
 
-    VkBufferCopy region {
-            .srcOffset = 0,
-            .dstOffset = byteOffset,
-            .size = numBytes,
-    };
-    vkCmdCopyBuffer(cmdbuf, stage->buffer, mGpuBuffer, 1, &region);
+    vkCmdCopyBuffer(cmdbuf, srcBuffer, mGpuBuffer, 1, &region);
 
     mUpdatedBytes = numBytes;
 
@@ -99,6 +151,23 @@ void VulkanBuffer::loadFromCpu(VkCommandBuffer cmdbuf, const void* cpuData, uint
     // Secondly, in case the user decides to upload another chunk (without ever using the first one)
     // we need to ensure that this upload completes first (hence
     // dstStageMask=VK_PIPELINE_STAGE_TRANSFER_BIT).
+    auto const [dstAccessMask, dstStageMask] = getDstAccessAndStage();
+
+    VkBufferMemoryBarrier barrier{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = dstAccessMask,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = mGpuBuffer,
+        .size = VK_WHOLE_SIZE,
+    };
+
+    vkCmdPipelineBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask, 0, 0, nullptr, 1,
+            &barrier, 0, nullptr);
+}
+
+std::pair<VkAccessFlags, VkPipelineStageFlags> VulkanBuffer::getDstAccessAndStage() const noexcept {
     VkAccessFlags dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
     VkPipelineStageFlags dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
 
@@ -113,21 +182,13 @@ void VulkanBuffer::loadFromCpu(VkCommandBuffer cmdbuf, const void* cpuData, uint
         dstStageMask |=
                 (VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
     } else if (mUsage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
-        // TODO: implement me
+        // TODO: implement shader reads
+        if (mUsage & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT) {
+            dstAccessMask |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+            dstStageMask |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+        }
     }
-
-    VkBufferMemoryBarrier barrier{
-        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-        .dstAccessMask = dstAccessMask,
-        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .buffer = mGpuBuffer,
-        .size = VK_WHOLE_SIZE,
-    };
-
-    vkCmdPipelineBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask, 0, 0, nullptr, 1,
-            &barrier, 0, nullptr);
+    return { dstAccessMask, dstStageMask };
 }
 
 } // namespace filament::backend
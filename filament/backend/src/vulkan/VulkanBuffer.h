@@ -17,10 +17,13 @@
 #ifndef TNT_FILAMENT_BACKEND_VULKANBUFFER_H
 #define TNT_FILAMENT_BACKEND_VULKANBUFFER_H
 
+#include "VulkanCommands.h"
 #include "VulkanContext.h"
 #include "VulkanStagePool.h"
 #include "VulkanMemory.h"
 
+#include <utility>
+
 namespace filament::backend {
 
 // Encapsulates a Vulkan buffer, its attached DeviceMemory and a staging area.
@@ -29,13 +32,19 @@ public:
     VulkanBuffer(VmaAllocator allocator, VulkanStagePool& stagePool, VkBufferUsageFlags usage,
             uint32_t numBytes);
     ~VulkanBuffer();
-    void loadFromCpu(VkCommandBuffer cmdbuf, const void* cpuData, uint32_t byteOffset,
+
+    // Records the upload into the current command buffer of the given VulkanCommands, or into its
+    // transfer command buffer for the first upload.
+    void loadFromCpu(VulkanCommands& commands, const void* cpuData, uint32_t byteOffset,
             uint32_t numBytes);
     VkBuffer getGpuBuffer() const {
         return mGpuBuffer;
     }
 
 private:
+    // The access and stages that must wait for an upload.
+    std::pair<VkAccessFlags, VkPipelineStageFlags> getDstAccessAndStage() const noexcept;
+
     VmaAllocator mAllocator;
     VulkanStagePool& mStagePool;
 
@@ -131,10 +131,14 @@ bool VulkanGroupMarkers::empty() const noexcept {
 #endif // FVK_DEBUG_GROUP_MARKERS
 
 VulkanCommands::VulkanCommands(VkDevice device, VkQueue queue, uint32_t queueFamilyIndex,
+        VkQueue transferQueue, uint32_t transferQueueFamilyIndex,
         VulkanContext* context, VulkanResourceAllocator* allocator)
     : mDevice(device),
       mQueue(queue),
       mPool(createPool(mDevice, queueFamilyIndex)),
+      mQueueFamilyIndex(queueFamilyIndex),
+      mTransferQueue(transferQueue),
+      mTransferQueueFamilyIndex(transferQueueFamilyIndex),
       mContext(context),
       mStorage(CAPACITY) {
     VkSemaphoreCreateInfo sci{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
@@ -151,6 +155,20 @@ VulkanCommands::VulkanCommands(VkDevice device, VkQueue queue, uint32_t queueFam
         mStorage[i] = std::make_unique<VulkanCommandBuffer>(allocator, mDevice, mPool);
     }
 
+    if (mTransferQueue != VK_NULL_HANDLE) {
+        mTransferPool = createPool(mDevice, mTransferQueueFamilyIndex);
+        VkCommandBufferAllocateInfo const allocateInfo = {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool = mTransferPool,
+                .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                .commandBufferCount = CAPACITY,
+        };
+        vkAllocateCommandBuffers(mDevice, &allocateInfo, mTransferBuffers);
+        for (auto& semaphore: mTransferSignals) {
+            vkCreateSemaphore(mDevice, &sci, VKALLOC, &semaphore);
+        }
+    }
+
 #if !FVK_ENABLED(FVK_DEBUG_GROUP_MARKERS)
     (void) mContext;
 #endif
@@ -166,6 +184,12 @@ void VulkanCommands::terminate() {
     for (VkFence fence: mFences) {
         vkDestroyFence(mDevice, fence, VKALLOC);
     }
+    if (mTransferPool != VK_NULL_HANDLE) {
+        vkDestroyCommandPool(mDevice, mTransferPool, VKALLOC);
+        for (VkSemaphore sema: mTransferSignals) {
+            vkDestroySemaphore(mDevice, sema, VKALLOC);
+        }
+    }
 }
 
 VulkanCommandBuffer& VulkanCommands::get() {
@@ -254,18 +278,39 @@ bool VulkanCommands::flush() {
 
     vkEndCommandBuffer(currentbuf->buffer());
 
+    // The transfer commands must be submitted first, since the command buffer waits on them.
+    VkSemaphore transferFinished = VK_NULL_HANDLE;
+    if (mTransferRecording) {
+        VkCommandBuffer const transferbuffer = mTransferBuffers[index];
+        transferFinished = mTransferSignals[index];
+        vkEndCommandBuffer(transferbuffer);
+        VkSubmitInfo const transferSubmitInfo{
+                .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                .commandBufferCount = 1,
+                .pCommandBuffers = &transferbuffer,
+                .signalSemaphoreCount = 1u,
+                .pSignalSemaphores = &transferFinished,
+        };
+        UTILS_UNUSED_IN_RELEASE VkResult const result =
+                vkQueueSubmit(mTransferQueue, 1, &transferSubmitInfo, VK_NULL_HANDLE);
+        assert_invariant(result == VK_SUCCESS);
+        mTransferRecording = false;
+    }
+
     // If the injected semaphore is an "image available" semaphore that has not yet been signaled,
     // it is sometimes fine to start executing commands anyway, as along as we stall the GPU at the
     // VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT stage. However we need to assume the worst
     // here and use VK_PIPELINE_STAGE_ALL_COMMANDS_BIT. This is a more aggressive stall, but it is
     // the only safe option because the previously submitted command buffer might have set up some
     // state that the new command buffer depends on.
-    VkPipelineStageFlags waitDestStageMasks[2] = {
+    VkPipelineStageFlags waitDestStageMasks[3] = {
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
     };
 
-    VkSemaphore signals[2] = {
+    VkSemaphore signals[3] = {
+            VK_NULL_HANDLE,
             VK_NULL_HANDLE,
             VK_NULL_HANDLE,
     };
@@ -276,6 +321,9 @@ bool VulkanCommands::flush() {
     if (mInjectedSignal) {
         signals[waitSemaphoreCount++] = mInjectedSignal;
     }
+    if (transferFinished) {
+        signals[waitSemaphoreCount++] = transferFinished;
+    }
     VkCommandBuffer const cmdbuffer = currentbuf->buffer();
     VkSubmitInfo submitInfo{
             .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
@@ -290,7 +338,7 @@ bool VulkanCommands::flush() {
 
 #if FVK_ENABLED(FVK_DEBUG_COMMAND_BUFFER)
     slog.i << "Submitting cmdbuffer=" << cmdbuffer
-           << " wait=(" << signals[0] << ", " << signals[1] << ") "
+           << " wait=(" << signals[0] << ", " << signals[1] << ", " << signals[2] << ") "
            << " signal=" << renderingFinished
            << " fence=" << currentbuf->fence->fence
            << utils::io::endl;
@@ -316,6 +364,25 @@ bool VulkanCommands::flush() {
     return true;
 }
 
+VkCommandBuffer VulkanCommands::getTransfer() {
+    if (mTransferQueue == VK_NULL_HANDLE) {
+        return VK_NULL_HANDLE;
+    }
+    // The transfer command buffer shares the slot of the current command buffer.
+    get();
+    VkCommandBuffer const transferbuffer = mTransferBuffers[mCurrentCommandBufferIndex];
+    if (!mTransferRecording) {
+        // This implicitly resets the command buffer, since the pool allows it.
+        VkCommandBufferBeginInfo const binfo{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        };
+        vkBeginCommandBuffer(transferbuffer, &binfo);
+        mTransferRecording = true;
+    }
+    return transferbuffer;
+}
+
 VkSemaphore VulkanCommands::acquireFinishedSignal() {
     VkSemaphore semaphore = mSubmissionSignal;
     mSubmissionSignal = VK_NULL_HANDLE;
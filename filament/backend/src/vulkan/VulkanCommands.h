@@ -90,6 +90,7 @@ struct VulkanCommandBuffer {
         fence.reset();
         mResourceManager.clear();
         mPipeline = VK_NULL_HANDLE;
+        mDynamicRasterState = UNDEFINED_DYNAMIC_RASTER_STATE;
     }
 
     inline void setPipeline(VkPipeline pipeline) {
@@ -100,6 +101,17 @@ struct VulkanCommandBuffer {
         return mPipeline;
     }
 
+    // The raster state last set with vkCmdSet*EXT, as packed by VulkanPipelineCache.
+    static constexpr uint32_t UNDEFINED_DYNAMIC_RASTER_STATE = 0xffffffffu;
+
+    inline void setDynamicRasterState(uint32_t state) {
+        mDynamicRasterState = state;
+    }
+
+    inline uint32_t dynamicRasterState() const {
+        return mDynamicRasterState;
+    }
+
     inline VkCommandBuffer buffer() const {
         if (fence) {
             return mBuffer;
@@ -113,6 +125,7 @@ private:
     VulkanAcquireOnlyResourceManager mResourceManager;
     VkCommandBuffer mBuffer;
     VkPipeline mPipeline;
+    uint32_t mDynamicRasterState = UNDEFINED_DYNAMIC_RASTER_STATE;
 };
 
 // Allows classes to be notified after a new command buffer has been activated.
@@ -143,6 +156,10 @@ public:
 // - Allows 1 user to listen to the most recent flush event using a "finished" VkSemaphore.
 //    - This is used to trigger presentation of the swap chain image.
 //
+// - Optionally records uploads into command buffers for a dedicated transfer queue.
+//    - Each transfer command buffer is submitted right before the current command buffer, which
+//      waits on it with a semaphore. Both are recycled together.
+//
 // - Allows off-thread queries of command buffer status.
 //    - Exposes an "updateFences" method that transfers current fence status into atomics.
 //    - Users can examine these atomic variables (see VulkanCmdFence) to determine status.
@@ -150,7 +167,10 @@ public:
 //
 class VulkanCommands {
 public:
+    // transferQueue can be VK_NULL_HANDLE, in which case getTransfer() always returns
+    // VK_NULL_HANDLE.
     VulkanCommands(VkDevice device, VkQueue queue, uint32_t queueFamilyIndex,
+            VkQueue transferQueue, uint32_t transferQueueFamilyIndex,
             VulkanContext* context, VulkanResourceAllocator* allocator);
 
     void terminate();
@@ -162,6 +182,19 @@ public:
     // If there are no outstanding commands then nothing happens and this returns false.
     bool flush();
 
+    // Returns a command buffer in the recording state for the dedicated transfer queue, or
+    // VK_NULL_HANDLE if there is none. It is submitted by the next flush(), before the current
+    // command buffer (see get()), which doesn't start executing until it has completed.
+    // Resources written by these commands must be released to the graphics queue family, and
+    // acquired by the current command buffer, which must also hold a reference to them.
+    VkCommandBuffer getTransfer();
+
+    bool hasTransferQueue() const noexcept { return mTransferQueue != VK_NULL_HANDLE; }
+
+    uint32_t getQueueFamilyIndex() const noexcept { return mQueueFamilyIndex; }
+
+    uint32_t getTransferQueueFamilyIndex() const noexcept { return mTransferQueueFamilyIndex; }
+
     // Returns the "rendering finished" semaphore for the most recent flush and removes
     // it from the existing dependency chain. This is especially useful for setting up
     // vkQueuePresentKHR.
@@ -199,6 +232,10 @@ private:
     VkDevice const mDevice;
     VkQueue const mQueue;
     VkCommandPool const mPool;
+    uint32_t const mQueueFamilyIndex;
+    VkQueue const mTransferQueue;
+    uint32_t const mTransferQueueFamilyIndex;
+    VkCommandPool mTransferPool = VK_NULL_HANDLE;
     VulkanContext const* mContext;
 
     // int8 only goes up to 127, therefore capacity must be less than that.
@@ -209,6 +246,12 @@ private:
     utils::FixedCapacityVector<std::unique_ptr<VulkanCommandBuffer>> mStorage;
     VkFence mFences[CAPACITY] = {};
     VkSemaphore mSubmissionSignals[CAPACITY] = {};
+
+    // The transfer command buffer and semaphore of each slot. They can be reused when the fence of
+    // the slot has signaled, since its command buffer waits on the transfer.
+    VkCommandBuffer mTransferBuffers[CAPACITY] = {};
+    VkSemaphore mTransferSignals[CAPACITY] = {};
+    bool mTransferRecording = false;
     uint8_t mAvailableBufferCount = CAPACITY;
     CommandBufferObserver* mObserver = nullptr;
 
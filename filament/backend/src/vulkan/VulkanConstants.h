@@ -160,4 +160,28 @@ constexpr static const int FVK_MAX_PIPELINE_AGE = 10;
 // destroying any unused pipeline object.
 static_assert(FVK_MAX_PIPELINE_AGE >= FVK_MAX_COMMAND_BUFFERS);
 
+// Number of command buffer submissions between two serializations of the VkPipelineCache to the
+// Platform's blob cache, if new pipelines were created in the meantime. The cache is also
+// serialized on termination, but applications are often killed before that happens.
+constexpr static const int FVK_PIPELINE_CACHE_SAVE_INTERVAL = 1000;
+
+// Fraction of a memory heap's budget past which the driver releases the memory it keeps around
+// for recycling, see VulkanDriver::checkMemoryBudget().
+constexpr static const double FVK_MEMORY_PRESSURE_THRESHOLD = 0.9;
+
+// Number of worker threads creating pipelines when asynchronous pipeline creation is enabled.
+constexpr static const int FVK_PIPELINE_COMPILER_THREAD_COUNT = 2;
+
+// Number of command buffer submissions after which the driver thread waits for a pipeline that is
+// still being created. This must be less than the number of frames render passes stay in the
+// VulkanFboCache after their last use, since the pending pipelines refer to them.
+constexpr static const int FVK_MAX_PENDING_PIPELINE_AGE = FVK_MAX_COMMAND_BUFFERS - 1;
+
+// Size of the persistently mapped stages that VulkanStagePool sub-allocates for small uploads,
+// and the largest upload that is sub-allocated rather than given its own stage.
+constexpr static const uint32_t FVK_STAGE_BLOCK_SIZE = 256 * 1024;
+constexpr static const uint32_t FVK_STAGE_SEGMENT_MAX_SIZE = 64 * 1024;
+constexpr static const uint32_t FVK_STAGE_SEGMENT_ALIGNMENT = 16;
+static_assert(FVK_STAGE_SEGMENT_MAX_SIZE <= FVK_STAGE_BLOCK_SIZE);
+
 #endif
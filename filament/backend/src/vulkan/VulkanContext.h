@@ -76,7 +76,7 @@ public:
 private:
     VkDevice mDevice;
     VkQueryPool mPool;
-    utils::bitset32 mUsed;
+    utils::bitset256 mUsed;
     utils::Mutex mMutex;
 };
 
@@ -135,12 +135,26 @@ public:
         return mPhysicalDeviceFeatures.shaderClipDistance == VK_TRUE;
     }
 
+    inline bool isMultiDrawIndirectSupported() const noexcept {
+        return mPhysicalDeviceFeatures.multiDrawIndirect == VK_TRUE;
+    }
+
+    inline bool isExtendedDynamicStateSupported() const noexcept {
+        return mExtendedDynamicStateSupported;
+    }
+
+    inline bool isMemoryBudgetSupported() const noexcept {
+        return mMemoryBudgetSupported;
+    }
+
 private:
     VkPhysicalDeviceMemoryProperties mMemoryProperties = {};
     VkPhysicalDeviceProperties mPhysicalDeviceProperties = {};
     VkPhysicalDeviceFeatures mPhysicalDeviceFeatures = {};
     bool mDebugMarkersSupported = false;
     bool mDebugUtilsSupported = false;
+    bool mExtendedDynamicStateSupported = false;
+    bool mMemoryBudgetSupported = false;
 
     VkFormatList mDepthStencilFormats;
     VkFormatList mBlittableDepthStencilFormats;
@@ -50,7 +50,7 @@ namespace filament::backend {
 namespace {
 
 VmaAllocator createAllocator(VkInstance instance, VkPhysicalDevice physicalDevice,
-        VkDevice device) {
+        VkDevice device, bool memoryBudgetSupported) {
     VmaAllocator allocator;
     VmaVulkanFunctions const funcs {
 #if VMA_DYNAMIC_VULKAN_FUNCTIONS
@@ -75,10 +75,14 @@ VmaAllocator createAllocator(VkInstance instance, VkPhysicalDevice physicalDevic
         .vkDestroyImage = vkDestroyImage,
         .vkCmdCopyBuffer = vkCmdCopyBuffer,
         .vkGetBufferMemoryRequirements2KHR = vkGetBufferMemoryRequirements2KHR,
-        .vkGetImageMemoryRequirements2KHR = vkGetImageMemoryRequirements2KHR
+        .vkGetImageMemoryRequirements2KHR = vkGetImageMemoryRequirements2KHR,
+        .vkGetPhysicalDeviceMemoryProperties2KHR = vkGetPhysicalDeviceMemoryProperties2KHR,
 #endif
     };
     VmaAllocatorCreateInfo const allocatorInfo {
+        // with VK_EXT_memory_budget, VMA tracks the budget the driver gives us, instead of
+        // estimating it from the heap sizes
+        .flags = memoryBudgetSupported ? VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT : 0u,
         .physicalDevice = physicalDevice,
         .device = device,
         .pVulkanFunctions = &funcs,
@@ -106,7 +110,7 @@ VulkanBufferObject* createEmptyBufferObject(VmaAllocator allocator, VulkanStageP
     VulkanBufferObject* obj =
             new VulkanBufferObject(allocator, stagePool, 1, BufferObjectBinding::UNIFORM);
     uint8_t byte = 0;
-    obj->buffer.loadFromCpu(commands->get().buffer(), &byte, 0, 1);
+    obj->buffer.loadFromCpu(*commands, &byte, 0, 1);
     return obj;
 }
 
@@ -214,13 +218,15 @@ VulkanDriver::VulkanDriver(VulkanPlatform* platform, VulkanContext const& contex
         Platform::DriverConfig const& driverConfig) noexcept
     : mPlatform(platform),
       mAllocator(createAllocator(mPlatform->getInstance(), mPlatform->getPhysicalDevice(),
-              mPlatform->getDevice())),
+              mPlatform->getDevice(), context.isMemoryBudgetSupported())),
       mContext(context),
-      mResourceAllocator(driverConfig.handleArenaSize, driverConfig.disableHandleUseAfterFreeCheck),
+      mResourceAllocator(driverConfig.handleArenaSize, driverConfig.disableHandleUseAfterFreeCheck,
+              driverConfig.handleArenaPoolWeights),
       mResourceManager(&mResourceAllocator),
       mThreadSafeResourceManager(&mResourceAllocator),
       mCommands(mPlatform->getDevice(), mPlatform->getGraphicsQueue(),
-              mPlatform->getGraphicsQueueFamilyIndex(), &mContext, &mResourceAllocator),
+              mPlatform->getGraphicsQueueFamilyIndex(), mPlatform->getTransferQueue(),
+              mPlatform->getTransferQueueFamilyIndex(), &mContext, &mResourceAllocator),
       mPipelineLayoutCache(mPlatform->getDevice(), &mResourceAllocator),
       mPipelineCache(mPlatform->getDevice(), mAllocator),
       mStagePool(mAllocator, &mCommands),
@@ -262,6 +268,9 @@ VulkanDriver::VulkanDriver(VulkanPlatform* platform, VulkanContext const& contex
     mDescriptorSetManager.setPlaceHolders(mSamplerCache.getSampler({}), mEmptyTexture,
             mEmptyBufferObject);
 
+    mPipelineCache.initialize(*mPlatform, mContext, mPlatform->getPhysicalDevice(),
+            driverConfig.asynchronousPipelineCreation);
+
     mGetPipelineFunction = [this](VulkanDescriptorSetLayoutList const& layouts, VulkanProgram* program) {
         return mPipelineLayoutCache.getLayout(layouts, program);
     };
@@ -385,9 +394,12 @@ void VulkanDriver::collectGarbage() {
     // its gc() function carrys out the *wait*.
     mCommands.gc();
     mStagePool.gc();
-    mFramebufferCache.gc();
+    // The pipeline cache must come first, since it can wait for pipelines that use render passes
+    // which are about to be evicted.
     mPipelineCache.gc();
+    mFramebufferCache.gc();
     mDescriptorSetManager.gc();
+    checkMemoryBudget();
 
 #if FVK_ENABLED(FVK_DEBUG_RESOURCE_LEAK)
     mResourceAllocator.print();
@@ -395,6 +407,41 @@ void VulkanDriver::collectGarbage() {
 
     FVK_SYSTRACE_END();
 }
+void VulkanDriver::checkMemoryBudget() noexcept {
+    // This lets VMA refresh the budget it got from the driver.
+    vmaSetCurrentFrameIndex(mAllocator, ++mMemoryBudgetFrame);
+
+    VkPhysicalDeviceMemoryProperties const* memoryProperties;
+    vmaGetMemoryProperties(mAllocator, &memoryProperties);
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(mAllocator, budgets);
+
+    bool const reportStats = mPlatform->hasDebugUpdateStatFunc();
+    bool underPressure = false;
+    for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++) {
+        VmaBudget const& budget = budgets[i];
+        underPressure = underPressure || double(budget.usage) >
+                double(budget.budget) * FVK_MEMORY_PRESSURE_THRESHOLD;
+        if (reportStats) {
+            char key[64];
+            snprintf(key, sizeof(key), "filament.vulkan.heap%u.usage", i);
+            mPlatform->debugUpdateStat(key, budget.usage);
+            snprintf(key, sizeof(key), "filament.vulkan.heap%u.budget", i);
+            mPlatform->debugUpdateStat(key, budget.budget);
+        }
+    }
+
+    if (UTILS_UNLIKELY(underPressure)) {
+        if (!mUnderMemoryPressure) {
+            utils::slog.w << "Vulkan memory usage is close to the budget, "
+                    "releasing unused staging memory." << utils::io::endl;
+        }
+        // Unused stages are kept for a few frames to be recycled, which we can't afford now.
+        mStagePool.trim();
+    }
+    mUnderMemoryPressure = underPressure;
+}
+
 void VulkanDriver::beginFrame(int64_t monotonic_clock_ns,
         int64_t refreshIntervalNs, uint32_t frameId) {
     // Do nothing.
@@ -554,6 +601,9 @@ void VulkanDriver::destroyTexture(Handle<HwTexture> th) {
         return;
     }
     auto texture = mResourceAllocator.handle_cast<VulkanTexture*>(th);
+    if (VulkanTexture* const external = texture->getExternalImage()) {
+        mResourceManager.release(external);
+    }
     mResourceManager.release(texture);
 }
 
@@ -568,6 +618,8 @@ void VulkanDriver::destroyProgram(Handle<HwProgram> ph) {
         return;
     }
     auto vkprogram = mResourceAllocator.handle_cast<VulkanProgram*>(ph);
+    // pipelines being created might use its shader modules
+    mPipelineCache.waitForPendingPipelines();
     mDescriptorSetManager.clearProgram(vkprogram);
     mResourceManager.release(vkprogram);
 }
@@ -935,6 +987,11 @@ bool VulkanDriver::isProtectedTexturesSupported() {
     return false;
 }
 
+bool VulkanDriver::isIndirectDrawSupported() {
+    // vkCmdDrawIndexedIndirect is core, only drawing several commands at once is optional
+    return true;
+}
+
 bool VulkanDriver::isWorkaroundNeeded(Workaround workaround) {
     switch (workaround) {
         case Workaround::SPLIT_EASU: {
@@ -967,12 +1024,24 @@ bool VulkanDriver::isWorkaroundNeeded(Workaround workaround) {
             return false;
         case Workaround::DISABLE_BLIT_INTO_TEXTURE_ARRAY:
             return false;
+        case Workaround::DISABLE_TAA_COLOR_GRADING_SUBPASS: {
+            auto const vendorId = mContext.getPhysicalDeviceVendorId();
+            return vendorId == 0x5143; // Qualcomm
+        }
         default:
             return false;
     }
     return false;
 }
 
+StateChangeStats VulkanDriver::getStateChangeStats() {
+    return {};
+}
+
+HandleAllocatorStats VulkanDriver::getHandleAllocatorStats() {
+    return mResourceAllocator.getStats();
+}
+
 FeatureLevel VulkanDriver::getFeatureLevel() {
     VkPhysicalDeviceLimits const& limits = mContext.getPhysicalDeviceLimits();
 
@@ -1029,7 +1098,7 @@ void VulkanDriver::updateIndexBuffer(Handle<HwIndexBuffer> ibh, BufferDescriptor
     VulkanCommandBuffer& commands = mCommands.get();
     auto ib = mResourceAllocator.handle_cast<VulkanIndexBuffer*>(ibh);
     commands.acquire(ib);
-    ib->buffer.loadFromCpu(commands.buffer(), p.buffer, byteOffset, p.size);
+    ib->buffer.loadFromCpu(mCommands, p.buffer, byteOffset, p.size);
 
     scheduleDestroy(std::move(p));
 }
@@ -1040,7 +1109,7 @@ void VulkanDriver::updateBufferObject(Handle<HwBufferObject> boh, BufferDescript
 
     auto bo = mResourceAllocator.handle_cast<VulkanBufferObject*>(boh);
     commands.acquire(bo);
-    bo->buffer.loadFromCpu(commands.buffer(), bd.buffer, byteOffset, bd.size);
+    bo->buffer.loadFromCpu(mCommands, bd.buffer, byteOffset, bd.size);
 
     scheduleDestroy(std::move(bd));
 }
@@ -1051,7 +1120,7 @@ void VulkanDriver::updateBufferObjectUnsynchronized(Handle<HwBufferObject> boh,
     auto bo = mResourceAllocator.handle_cast<VulkanBufferObject*>(boh);
     commands.acquire(bo);
     // TODO: implement unsynchronized version
-    bo->buffer.loadFromCpu(commands.buffer(), bd.buffer, byteOffset, bd.size);
+    bo->buffer.loadFromCpu(mCommands, bd.buffer, byteOffset, bd.size);
     mResourceManager.acquire(bo);
     scheduleDestroy(std::move(bd));
 }
@@ -1110,6 +1179,43 @@ TimerQueryResult VulkanDriver::getTimerQueryValue(Handle<HwTimerQuery> tqh, uint
 }
 
 void VulkanDriver::setExternalImage(Handle<HwTexture> th, void* image) {
+    auto* const texture = mResourceAllocator.handle_cast<VulkanTexture*>(th);
+    VulkanPlatform::ExternalImage const external = mPlatform->createExternalImage(image);
+    if (external.image == VK_NULL_HANDLE) {
+        return;
+    }
+
+    // The imported image gets its own ref-counted handle, so that command buffers that still
+    // sample the previous image keep it alive after it is replaced.
+    Handle<HwTexture> const eth = mResourceAllocator.allocHandle<VulkanTexture>();
+    auto* const imported = mResourceAllocator.construct<VulkanTexture>(eth, mPlatform->getDevice(),
+            mAllocator, &mCommands, external.image, external.format, 1, external.width,
+            external.height, TextureUsage::SAMPLEABLE, mStagePool, false, external.memory);
+    mResourceManager.acquire(imported);
+
+    VulkanCommandBuffer& commands = mCommands.get();
+    commands.acquire(imported);
+    VkImageSubresourceRange const range = imported->getFullViewRange();
+    if (external.queueFamilyIndex != VK_QUEUE_FAMILY_IGNORED) {
+        // The contents were produced by another owner, so they are only preserved if ownership is
+        // acquired from the layout that owner left the image in.
+        VulkanLayout const layout = external.layout == VK_IMAGE_LAYOUT_GENERAL ?
+                VulkanLayout::READ_WRITE : VulkanLayout::UNDEFINED;
+        imgutil::acquireOwnership(commands.buffer(), {
+                    .image = external.image,
+                    .oldLayout = layout,
+                    .newLayout = VulkanLayout::READ_ONLY,
+                    .subresources = range,
+                }, external.queueFamilyIndex, mPlatform->getGraphicsQueueFamilyIndex());
+        imported->setLayout(range, VulkanLayout::READ_ONLY);
+    } else {
+        imported->transitionLayout(commands.buffer(), range, VulkanLayout::READ_ONLY);
+    }
+
+    if (VulkanTexture* const previous = texture->getExternalImage()) {
+        mResourceManager.release(previous);
+    }
+    texture->setExternalImage(imported);
 }
 
 void VulkanDriver::setExternalImagePlane(Handle<HwTexture> th, void* image, uint32_t plane) {
@@ -1533,6 +1639,7 @@ void VulkanDriver::makeCurrent(Handle<HwSwapChain> drawSch, Handle<HwSwapChain>
     swapChain->acquire(resized);
 
     if (resized) {
+        mPipelineCache.waitForPendingPipelines();
         mFramebufferCache.reset();
     }
 
@@ -1853,6 +1960,9 @@ void VulkanDriver::bindPipeline(PipelineState const& pipelineState) {
             continue;
         }
         VulkanTexture* texture = mResourceAllocator.handle_cast<VulkanTexture*>(boundSampler->t);
+        if (VulkanTexture* const external = texture->getExternalImage()) {
+            texture = external;
+        }
 
         // TODO: can this uninitialized check be checked in a higher layer?
         // This fallback path is very flaky because the dummy texture might not have
@@ -1881,7 +1991,7 @@ void VulkanDriver::bindPipeline(PipelineState const& pipelineState) {
     };
 
     mPipelineCache.bindLayout(pipelineLayout);
-    mPipelineCache.bindPipeline(commands);
+    mBoundPipelineReady = mPipelineCache.bindPipeline(commands);
 
     // Since we don't statically define scissor as part of the pipeline, we need to call scissor at
     // least once. Context: VUID-vkCmdDrawIndexed-None-07832.
@@ -1924,6 +2034,12 @@ void VulkanDriver::draw2(uint32_t indexOffset, uint32_t indexCount, uint32_t ins
     FVK_SYSTRACE_CONTEXT();
     FVK_SYSTRACE_START("draw2");
 
+    // The pipeline is still being created in the background.
+    if (UTILS_UNLIKELY(!mBoundPipelineReady)) {
+        FVK_SYSTRACE_END();
+        return;
+    }
+
     VulkanCommandBuffer& commands = mCommands.get();
     VkCommandBuffer cmdbuffer = commands.buffer();
 
@@ -1950,6 +2066,41 @@ void VulkanDriver::draw(PipelineState state, Handle<HwRenderPrimitive> rph,
     draw2(indexOffset, indexCount, instanceCount);
 }
 
+void VulkanDriver::drawIndirect(Handle<HwBufferObject> boh,
+        uint32_t byteOffset, uint32_t drawCount, uint32_t stride) {
+    FVK_SYSTRACE_CONTEXT();
+    FVK_SYSTRACE_START("drawIndirect");
+
+    // The pipeline is still being created in the background.
+    if (UTILS_UNLIKELY(!mBoundPipelineReady || !drawCount)) {
+        FVK_SYSTRACE_END();
+        return;
+    }
+
+    VulkanCommandBuffer& commands = mCommands.get();
+    VkCommandBuffer cmdbuffer = commands.buffer();
+
+    auto* bo = mResourceAllocator.handle_cast<VulkanBufferObject*>(boh);
+    assert_invariant(bo->bindingType == BufferObjectBinding::SHADER_STORAGE);
+    assert_invariant(byteOffset + (drawCount - 1) * stride +
+            sizeof(DrawIndexedIndirectCommand) <= bo->byteCount);
+    commands.acquire(bo);
+
+    // Bind "dynamic" UBOs if they need to change.
+    mDescriptorSetManager.dynamicBind(&commands, {});
+
+    VkBuffer const buffer = bo->buffer.getGpuBuffer();
+    if (mContext.isMultiDrawIndirectSupported()) {
+        vkCmdDrawIndexedIndirect(cmdbuffer, buffer, byteOffset, drawCount, stride);
+    } else {
+        for (uint32_t i = 0; i < drawCount; i++) {
+            vkCmdDrawIndexedIndirect(cmdbuffer, buffer, byteOffset + i * stride, 1, 0);
+        }
+    }
+
+    FVK_SYSTRACE_END();
+}
+
 void VulkanDriver::dispatchCompute(Handle<HwProgram> program, math::uint3 workGroupCount) {
     // FIXME: implement me
 }
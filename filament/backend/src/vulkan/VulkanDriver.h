@@ -127,6 +127,12 @@ private:
 private:
     void collectGarbage();
 
+    // Publishes the memory usage and budget of each heap through Platform::debugUpdateStat(), and
+    // releases the memory of unused stages when the usage of a heap gets close to its budget.
+    void checkMemoryBudget() noexcept;
+    uint32_t mMemoryBudgetFrame = 0;
+    bool mUnderMemoryPressure = false;
+
     VulkanPlatform* mPlatform = nullptr;
     std::unique_ptr<VulkanTimestamps> mTimestamps;
 
@@ -167,6 +173,8 @@ private:
         VkPipelineLayout pipelineLayout;
     };
     BoundPipeline mBoundPipeline = {};
+    // False if the pipeline isn't available yet, in which case draw calls are skipped.
+    bool mBoundPipelineReady = true;
     RenderPassFboBundle mRenderPassFboInfo;
 
     bool const mIsSRGBSwapChainSupported;
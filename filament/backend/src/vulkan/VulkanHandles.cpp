@@ -136,6 +136,9 @@ VulkanDescriptorSetLayout::VulkanDescriptorSetLayout(VkDevice device,
       count(Count::fromLayoutBitmask(bitmask)) {}
 
 VulkanDescriptorSetLayout::~VulkanDescriptorSetLayout() {
+    if (updateTemplate != VK_NULL_HANDLE) {
+        vkDestroyDescriptorUpdateTemplate(mDevice, updateTemplate, VKALLOC);
+    }
     vkDestroyDescriptorSetLayout(mDevice, vklayout, VKALLOC);
 }
 
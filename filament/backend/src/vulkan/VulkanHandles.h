@@ -108,6 +108,9 @@ struct VulkanDescriptorSetLayout : public VulkanResource {
     VkDescriptorSetLayout const vklayout;
     Bitmask const bitmask;
 
+    // Created lazily by the descriptor set manager the first time a set of this layout is written.
+    VkDescriptorUpdateTemplate updateTemplate = VK_NULL_HANDLE;
+
     // This is a convenience struct so that we don't have to iterate through all the bits of the
     // bitmask (which correspondings to binding indices).
     struct _Bindings {
@@ -482,7 +485,7 @@ private:
     utils::Mutex mFenceMutex;
 };
 
-inline constexpr VkBufferUsageFlagBits getBufferObjectUsage(
+inline constexpr VkBufferUsageFlags getBufferObjectUsage(
         BufferObjectBinding bindingType) noexcept {
     switch(bindingType) {
         case BufferObjectBinding::VERTEX:
@@ -490,7 +493,8 @@ inline constexpr VkBufferUsageFlagBits getBufferObjectUsage(
         case BufferObjectBinding::UNIFORM:
             return VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
         case BufferObjectBinding::SHADER_STORAGE:
-            return VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            // storage buffers can also be the source of drawIndirect()
+            return VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
         // when adding more buffer-types here, make sure to update VulkanBuffer::loadFromCpu()
         // if necessary.
     }
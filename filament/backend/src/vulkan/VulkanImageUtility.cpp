@@ -154,6 +154,57 @@ void transitionLayout(VkCommandBuffer cmdbuffer,
     vkCmdPipelineBarrier(cmdbuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 }
 
+void transferOwnership(VkCommandBuffer srcCmdbuffer, VkCommandBuffer dstCmdbuffer,
+        VulkanLayoutTransition transition, uint32_t srcQueueFamilyIndex,
+        uint32_t dstQueueFamilyIndex) {
+    auto [srcAccessMask, dstAccessMask, srcStage, dstStage, oldLayout, newLayout]
+            = getVkTransition(transition);
+
+    assert_invariant(transition.image != VK_NULL_HANDLE && "No image for transition");
+    // The access masks of the destination are ignored by the release and the ones of the source
+    // are ignored by the acquire; the semaphore between the two submissions orders them.
+    VkImageMemoryBarrier barrier = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = srcAccessMask,
+            .dstAccessMask = 0,
+            .oldLayout = oldLayout,
+            .newLayout = newLayout,
+            .srcQueueFamilyIndex = srcQueueFamilyIndex,
+            .dstQueueFamilyIndex = dstQueueFamilyIndex,
+            .image = transition.image,
+            .subresourceRange = transition.subresources,
+    };
+    vkCmdPipelineBarrier(srcCmdbuffer, srcStage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0,
+            nullptr, 0, nullptr, 1, &barrier);
+
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = dstAccessMask;
+    vkCmdPipelineBarrier(dstCmdbuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage, 0, 0,
+            nullptr, 0, nullptr, 1, &barrier);
+}
+
+void acquireOwnership(VkCommandBuffer cmdbuffer, VulkanLayoutTransition transition,
+        uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex) {
+    auto [srcAccessMask, dstAccessMask, srcStage, dstStage, oldLayout, newLayout]
+            = getVkTransition(transition);
+
+    // Unlike transitionLayout(), the barrier is needed even if the layout doesn't change.
+    assert_invariant(transition.image != VK_NULL_HANDLE && "No image for transition");
+    VkImageMemoryBarrier const barrier = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = 0,
+            .dstAccessMask = dstAccessMask,
+            .oldLayout = oldLayout,
+            .newLayout = newLayout,
+            .srcQueueFamilyIndex = srcQueueFamilyIndex,
+            .dstQueueFamilyIndex = dstQueueFamilyIndex,
+            .image = transition.image,
+            .subresourceRange = transition.subresources,
+    };
+    vkCmdPipelineBarrier(cmdbuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage, 0, 0,
+            nullptr, 0, nullptr, 1, &barrier);
+}
+
 }// namespace filament::backend
 
 bool operator<(const VkImageSubresourceRange& a, const VkImageSubresourceRange& b) {
@@ -137,6 +137,18 @@ constexpr inline VkImageLayout getVkLayout(VulkanLayout layout) {
 
 void transitionLayout(VkCommandBuffer cmdbuffer, VulkanLayoutTransition transition);
 
+// Records the release half of a queue family ownership transfer into srcCmdbuffer, and the acquire
+// half into dstCmdbuffer, along with the given layout transition. The caller must ensure that
+// dstCmdbuffer is submitted after, and waits on, srcCmdbuffer.
+void transferOwnership(VkCommandBuffer srcCmdbuffer, VkCommandBuffer dstCmdbuffer,
+        VulkanLayoutTransition transition, uint32_t srcQueueFamilyIndex,
+        uint32_t dstQueueFamilyIndex);
+
+// Records the acquire half of a queue family ownership transfer whose release was done outside of
+// this device, e.g. from VK_QUEUE_FAMILY_FOREIGN_EXT, along with the given layout transition.
+void acquireOwnership(VkCommandBuffer cmdbuffer, VulkanLayoutTransition transition,
+        uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex);
+
 } // namespace imgutil
 
 } // namespace filament::backend
@@ -18,9 +18,12 @@
 #include "VulkanMemory.h"
 #include "caching/VulkanDescriptorSetManager.h"
 
+#include <utils/JobSystem.h>
 #include <utils/Log.h>
 #include <utils/Panic.h>
 
+#include <string.h>
+
 #include "VulkanConstants.h"
 #include "VulkanHandles.h"
 #include "VulkanTexture.h"
@@ -45,6 +48,100 @@ VulkanPipelineCache::~VulkanPipelineCache() {
     // be explicit about teardown order of various components.
 }
 
+VulkanPipelineCache::PendingPipeline::~PendingPipeline() = default;
+
+void VulkanPipelineCache::initialize(Platform& platform, VulkanContext const& context,
+        VkPhysicalDevice physicalDevice, bool asynchronous) noexcept {
+    assert_invariant(mPipelineCache == VK_NULL_HANDLE);
+    mPlatform = &platform;
+    mExtendedDynamicState = context.isExtendedDynamicStateSupported();
+
+    mAsynchronous = asynchronous;
+    if (asynchronous) {
+        mCompilerThreadPool.init(FVK_PIPELINE_COMPILER_THREAD_COUNT,
+                []() {
+                    utils::JobSystem::setThreadName("VulkanPipelineCompiler");
+                    // same priority as the driver thread, which sometimes waits for these
+                    utils::JobSystem::setThreadPriority(utils::JobSystem::Priority::DISPLAY);
+                },
+                []() {});
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    mBlobKey.vendorID = properties.vendorID;
+    mBlobKey.deviceID = properties.deviceID;
+    mBlobKey.driverVersion = properties.driverVersion;
+    memcpy(mBlobKey.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    std::vector<uint8_t> data;
+    if (platform.hasRetrieveBlobFunc()) {
+        // always attempt with 256 KiB first
+        data.resize(256 * 1024);
+        size_t size = platform.retrieveBlob(&mBlobKey, sizeof(mBlobKey), data.data(), data.size());
+        if (size > data.size()) {
+            // our buffer was too small, retry with the correct size
+            data.resize(size);
+            size = platform.retrieveBlob(&mBlobKey, sizeof(mBlobKey), data.data(), data.size());
+        }
+        data.resize(size <= data.size() ? size : 0);
+
+        // Drivers are supposed to ignore incompatible data, but not all of them do, so we
+        // check the header ourselves.
+        VkPipelineCacheHeaderVersionOne header;
+        if (data.size() >= sizeof(header)) {
+            memcpy(&header, data.data(), sizeof(header));
+        }
+        if (data.size() < sizeof(header) ||
+                header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+                header.vendorID != properties.vendorID ||
+                header.deviceID != properties.deviceID ||
+                memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE)) {
+            data.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo const createInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = data.size(),
+        .pInitialData = data.empty() ? nullptr : data.data(),
+    };
+    VkResult result = vkCreatePipelineCache(mDevice, &createInfo, VKALLOC, &mPipelineCache);
+    if (result != VK_SUCCESS && !data.empty()) {
+        // try again without the initial data
+        VkPipelineCacheCreateInfo const emptyCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        };
+        result = vkCreatePipelineCache(mDevice, &emptyCreateInfo, VKALLOC, &mPipelineCache);
+    }
+    if (result != VK_SUCCESS) {
+        utils::slog.w << "vkCreatePipelineCache error " << result << utils::io::endl;
+        mPipelineCache = VK_NULL_HANDLE;
+    }
+}
+
+void VulkanPipelineCache::savePipelineCache() noexcept {
+    if (mPipelineCache == VK_NULL_HANDLE || !mPipelineCacheDirty ||
+            !mPlatform->hasInsertBlobFunc()) {
+        return;
+    }
+    mPipelineCacheDirty = false;
+    mLastSaveTime = mCurrentTime;
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(mDevice, mPipelineCache, &size, nullptr) != VK_SUCCESS || !size) {
+        return;
+    }
+    std::vector<uint8_t> data(size);
+    VkResult const result = vkGetPipelineCacheData(mDevice, mPipelineCache, &size, data.data());
+    if (result == VK_SUCCESS) {
+        mPlatform->insertBlob(&mBlobKey, sizeof(mBlobKey), data.data(), size);
+    } else if (result == VK_INCOMPLETE) {
+        // a worker thread added a pipeline in the meantime, try again later
+        mPipelineCacheDirty = true;
+    }
+}
+
 void VulkanPipelineCache::bindLayout(VkPipelineLayout layout) noexcept {
     mPipelineRequirements.layout = layout;
 }
@@ -57,31 +154,130 @@ VulkanPipelineCache::PipelineCacheEntry* VulkanPipelineCache::getOrCreatePipelin
         pipeline.lastUsed = mCurrentTime;
         return &pipeline;
     }
-    auto ret = createPipeline();
-    ret->lastUsed = mCurrentTime;
+    auto ret = mAsynchronous ? getOrQueuePipeline() : createPipeline();
+    if (ret) {
+        ret->lastUsed = mCurrentTime;
+    }
     return ret;
 }
 
-void VulkanPipelineCache::bindPipeline(VulkanCommandBuffer* commands) {
+bool VulkanPipelineCache::bindPipeline(VulkanCommandBuffer* commands) {
     VkCommandBuffer const cmdbuffer = commands->buffer();
 
     PipelineCacheEntry* cacheEntry = getOrCreatePipeline();
+
+    // If the pipeline is still being created or an error occurred, let higher levels skip the
+    // draw calls.
+    assert_invariant((cacheEntry || mAsynchronous) && "Failed to create/find pipeline");
+    if (UTILS_UNLIKELY(!cacheEntry)) {
+        return false;
+    }
+
+    if (mExtendedDynamicState) {
+        bindDynamicRasterState(commands);
+    }
+
     // Check if the required pipeline is already bound.
     if (cacheEntry->handle == commands->pipeline()) {
-        return;
+        return true;
     }
 
-    // If an error occurred, allow higher levels to handle it gracefully.
-    assert_invariant(cacheEntry != nullptr && "Failed to create/find pipeline");
-
     mBoundPipeline = mPipelineRequirements;
     vkCmdBindPipeline(cmdbuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, cacheEntry->handle);
     commands->setPipeline(cacheEntry->handle);
+    return true;
+}
+
+void VulkanPipelineCache::bindDynamicRasterState(VulkanCommandBuffer* commands) noexcept {
+    DynamicRasterState const& state = mDynamicRasterState;
+    assert_invariant(state.cullMode <= 0x3u);
+    assert_invariant(uint32_t(state.frontFace) <= 0x1u);
+    assert_invariant(uint32_t(state.depthCompareOp) <= 0x7u);
+    uint32_t const packed = state.cullMode | (uint32_t(state.frontFace) << 2u) |
+            (uint32_t(state.depthWriteEnable) << 3u) | (uint32_t(state.depthCompareOp) << 4u);
+    if (packed == commands->dynamicRasterState()) {
+        return;
+    }
+    VkCommandBuffer const cmdbuffer = commands->buffer();
+    vkCmdSetCullModeEXT(cmdbuffer, state.cullMode);
+    vkCmdSetFrontFaceEXT(cmdbuffer, state.frontFace);
+    vkCmdSetDepthWriteEnableEXT(cmdbuffer, state.depthWriteEnable);
+    vkCmdSetDepthCompareOpEXT(cmdbuffer, state.depthCompareOp);
+    commands->setDynamicRasterState(packed);
 }
 
 VulkanPipelineCache::PipelineCacheEntry* VulkanPipelineCache::createPipeline() noexcept {
-    assert_invariant(mPipelineRequirements.shaders[0] && "Vertex shader is not bound.");
-    assert_invariant(mPipelineRequirements.layout && "No pipeline layout specified");
+    VkPipeline const handle = createPipelineHandle(mPipelineRequirements);
+    if (handle == VK_NULL_HANDLE) {
+        return nullptr;
+    }
+    mPipelineCacheDirty = true;
+    return &mPipelines.emplace(mPipelineRequirements,
+            PipelineCacheEntry{ handle, mCurrentTime }).first.value();
+}
+
+VulkanPipelineCache::PipelineCacheEntry* VulkanPipelineCache::getOrQueuePipeline() noexcept {
+    if (auto iter = mPendingPipelines.find(mPipelineRequirements);
+            iter != mPendingPipelines.end()) {
+        if (!iter->second->ready.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        std::shared_ptr<PendingPipeline> const pending = iter->second;
+        mPendingPipelines.erase(iter);
+        return retirePendingPipeline(*pending);
+    }
+
+    auto pending = std::make_shared<PendingPipeline>();
+    pending->key = mPipelineRequirements;
+    pending->queued = mCurrentTime;
+    mPendingPipelines.emplace(mPipelineRequirements, pending);
+    mCompilerThreadPool.queue(CompilerPriorityQueue::HIGH, pending,
+            [this, pending]() {
+                VkPipeline const handle = createPipelineHandle(pending->key);
+                std::unique_lock const lock(mPendingLock);
+                pending->handle = handle;
+                pending->ready.store(true, std::memory_order_release);
+                mPendingCondition.notify_all();
+            });
+    return nullptr;
+}
+
+VulkanPipelineCache::PipelineCacheEntry* VulkanPipelineCache::retirePendingPipeline(
+        PendingPipeline const& pending) noexcept {
+    assert_invariant(pending.ready);
+    if (pending.handle == VK_NULL_HANDLE) {
+        // the pipeline will be queued again on its next use
+        return nullptr;
+    }
+    mPipelineCacheDirty = true;
+    return &mPipelines.emplace(pending.key,
+            PipelineCacheEntry{ pending.handle, mCurrentTime }).first.value();
+}
+
+void VulkanPipelineCache::waitForPendingPipeline(
+        std::shared_ptr<PendingPipeline> const& pending) noexcept {
+    if (mCompilerThreadPool.dequeue(pending)) {
+        // the job hadn't started yet and is now canceled
+        return;
+    }
+    std::unique_lock lock(mPendingLock);
+    mPendingCondition.wait(lock, [&pending]() {
+        return pending->ready.load(std::memory_order_relaxed);
+    });
+    lock.unlock();
+    retirePendingPipeline(*pending);
+}
+
+void VulkanPipelineCache::waitForPendingPipelines() noexcept {
+    for (auto const& [key, pending]: mPendingPipelines) {
+        waitForPendingPipeline(pending);
+    }
+    mPendingPipelines.clear();
+}
+
+VkPipeline VulkanPipelineCache::createPipelineHandle(PipelineKey const& key) const noexcept {
+    assert_invariant(key.shaders[0] && "Vertex shader is not bound.");
+    assert_invariant(key.layout && "No pipeline layout specified");
 
     VkPipelineShaderStageCreateInfo shaderStages[SHADER_MODULE_COUNT];
     shaderStages[0] = VkPipelineShaderStageCreateInfo{};
@@ -102,8 +298,8 @@ VulkanPipelineCache::PipelineCacheEntry* VulkanPipelineCache::createPipeline() n
     colorBlendState.pAttachments = colorBlendAttachments;
 
     // If we reach this point, we need to create and stash a brand new pipeline object.
-    shaderStages[0].module = mPipelineRequirements.shaders[0];
-    shaderStages[1].module = mPipelineRequirements.shaders[1];
+    shaderStages[0].module = key.shaders[0];
+    shaderStages[1].module = key.shaders[1];
 
     // Expand our size-optimized structs into the proper Vk structs.
     uint32_t numVertexAttribs = 0;
@@ -111,12 +307,12 @@ VulkanPipelineCache::PipelineCacheEntry* VulkanPipelineCache::createPipeline() n
     VkVertexInputAttributeDescription vertexAttributes[VERTEX_ATTRIBUTE_COUNT];
     VkVertexInputBindingDescription vertexBuffers[VERTEX_ATTRIBUTE_COUNT];
     for (uint32_t i = 0; i < VERTEX_ATTRIBUTE_COUNT; i++) {
-        if (mPipelineRequirements.vertexAttributes[i].format > 0) {
-            vertexAttributes[numVertexAttribs] = mPipelineRequirements.vertexAttributes[i];
+        if (key.vertexAttributes[i].format > 0) {
+            vertexAttributes[numVertexAttribs] = key.vertexAttributes[i];
             numVertexAttribs++;
         }
-        if (mPipelineRequirements.vertexBuffers[i].stride > 0) {
-            vertexBuffers[numVertexBuffers] = mPipelineRequirements.vertexBuffers[i];
+        if (key.vertexBuffers[i].stride > 0) {
+            vertexBuffers[numVertexBuffers] = key.vertexBuffers[i];
             numVertexBuffers++;
         }
     }
@@ -130,7 +326,7 @@ VulkanPipelineCache::PipelineCacheEntry* VulkanPipelineCache::createPipeline() n
 
     VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = {};
     inputAssemblyState.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssemblyState.topology = (VkPrimitiveTopology) mPipelineRequirements.topology;
+    inputAssemblyState.topology = (VkPrimitiveTopology) key.topology;
 
     VkPipelineViewportStateCreateInfo viewportState = {};
     viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
@@ -140,19 +336,24 @@ VulkanPipelineCache::PipelineCacheEntry* VulkanPipelineCache::createPipeline() n
     VkDynamicState dynamicStateEnables[] = {
         VK_DYNAMIC_STATE_VIEWPORT,
         VK_DYNAMIC_STATE_SCISSOR,
+        // only with extended dynamic state
+        VK_DYNAMIC_STATE_CULL_MODE_EXT,
+        VK_DYNAMIC_STATE_FRONT_FACE_EXT,
+        VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT,
+        VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT,
     };
     VkPipelineDynamicStateCreateInfo dynamicState = {};
     dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
     dynamicState.pDynamicStates = dynamicStateEnables;
-    dynamicState.dynamicStateCount = 2;
+    dynamicState.dynamicStateCount = mExtendedDynamicState ? 6 : 2;
 
     const bool hasFragmentShader = shaderStages[1].module != VK_NULL_HANDLE;
 
     VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
     pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineCreateInfo.layout = mPipelineRequirements.layout;
-    pipelineCreateInfo.renderPass = mPipelineRequirements.renderPass;
-    pipelineCreateInfo.subpass = mPipelineRequirements.subpassIndex;
+    pipelineCreateInfo.layout = key.layout;
+    pipelineCreateInfo.renderPass = key.renderPass;
+    pipelineCreateInfo.subpass = key.subpassIndex;
     pipelineCreateInfo.stageCount = hasFragmentShader ? SHADER_MODULE_COUNT : 1;
     pipelineCreateInfo.pStages = shaderStages;
     pipelineCreateInfo.pVertexInputState = &vertexInputState;
@@ -179,7 +380,7 @@ VulkanPipelineCache::PipelineCacheEntry* VulkanPipelineCache::createPipeline() n
     };
     pipelineCreateInfo.pDepthStencilState = &vkDs;
 
-    const auto& raster = mPipelineRequirements.rasterState;
+    const auto& raster = key.rasterState;
 
     vkRaster.polygonMode = VK_POLYGON_MODE_FILL;
     vkRaster.cullMode = raster.cullMode;
@@ -209,16 +410,16 @@ VulkanPipelineCache::PipelineCacheEntry* VulkanPipelineCache::createPipeline() n
     pipelineCreateInfo.pDynamicState = &dynamicState;
 
     // Filament assumes consistent blend state across all color attachments.
-    colorBlendState.attachmentCount = mPipelineRequirements.rasterState.colorTargetCount;
+    colorBlendState.attachmentCount = key.rasterState.colorTargetCount;
     for (auto& target : colorBlendAttachments) {
-        target.blendEnable = mPipelineRequirements.rasterState.blendEnable;
-        target.srcColorBlendFactor = mPipelineRequirements.rasterState.srcColorBlendFactor;
-        target.dstColorBlendFactor = mPipelineRequirements.rasterState.dstColorBlendFactor;
-        target.colorBlendOp = (VkBlendOp) mPipelineRequirements.rasterState.colorBlendOp;
-        target.srcAlphaBlendFactor = mPipelineRequirements.rasterState.srcAlphaBlendFactor;
-        target.dstAlphaBlendFactor = mPipelineRequirements.rasterState.dstAlphaBlendFactor;
-        target.alphaBlendOp = (VkBlendOp) mPipelineRequirements.rasterState.alphaBlendOp;
-        target.colorWriteMask = mPipelineRequirements.rasterState.colorWriteMask;
+        target.blendEnable = key.rasterState.blendEnable;
+        target.srcColorBlendFactor = key.rasterState.srcColorBlendFactor;
+        target.dstColorBlendFactor = key.rasterState.dstColorBlendFactor;
+        target.colorBlendOp = (VkBlendOp) key.rasterState.colorBlendOp;
+        target.srcAlphaBlendFactor = key.rasterState.srcAlphaBlendFactor;
+        target.dstAlphaBlendFactor = key.rasterState.dstAlphaBlendFactor;
+        target.alphaBlendOp = (VkBlendOp) key.rasterState.alphaBlendOp;
+        target.colorWriteMask = key.rasterState.colorWriteMask;
     }
 
     // There are no color attachments if there is no bound fragment shader.  (e.g. shadow map gen)
@@ -227,21 +428,20 @@ VulkanPipelineCache::PipelineCacheEntry* VulkanPipelineCache::createPipeline() n
         colorBlendState.attachmentCount = 0;
     }
 
-    PipelineCacheEntry cacheEntry = {};
+    VkPipeline pipeline = VK_NULL_HANDLE;
 
     #if FVK_ENABLED(FVK_DEBUG_SHADER_MODULE)
         utils::slog.d << "vkCreateGraphicsPipelines with shaders = ("
                 << shaderStages[0].module << ", " << shaderStages[1].module << ")" << utils::io::endl;
     #endif
-    VkResult error = vkCreateGraphicsPipelines(mDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo,
-            VKALLOC, &cacheEntry.handle);
+    VkResult error = vkCreateGraphicsPipelines(mDevice, mPipelineCache, 1, &pipelineCreateInfo,
+            VKALLOC, &pipeline);
     assert_invariant(error == VK_SUCCESS);
     if (error != VK_SUCCESS) {
         utils::slog.e << "vkCreateGraphicsPipelines error " << error << utils::io::endl;
-        return nullptr;
+        return VK_NULL_HANDLE;
     }
-
-    return &mPipelines.emplace(mPipelineRequirements, cacheEntry).first.value();
+    return pipeline;
 }
 
 void VulkanPipelineCache::bindProgram(VulkanProgram* program) noexcept {
@@ -259,6 +459,20 @@ void VulkanPipelineCache::bindProgram(VulkanProgram* program) noexcept {
 
 void VulkanPipelineCache::bindRasterState(const RasterState& rasterState) noexcept {
     mPipelineRequirements.rasterState = rasterState;
+    if (mExtendedDynamicState) {
+        // These are set in bindPipeline() instead, so that they don't create new pipelines.
+        mDynamicRasterState = {
+            .cullMode = rasterState.cullMode,
+            .frontFace = rasterState.frontFace,
+            .depthWriteEnable = rasterState.depthWriteEnable,
+            .depthCompareOp = getCompareOp(rasterState.depthCompareOp),
+        };
+        RasterState& key = mPipelineRequirements.rasterState;
+        key.cullMode = VK_CULL_MODE_NONE;
+        key.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+        key.depthWriteEnable = VK_FALSE;
+        key.depthCompareOp = SamplerCompareFunc::LE;
+    }
 }
 
 void VulkanPipelineCache::bindRenderPass(VkRenderPass renderPass, int subpassIndex) noexcept {
@@ -285,11 +499,22 @@ void VulkanPipelineCache::bindVertexArray(VkVertexInputAttributeDescription cons
 }
 
 void VulkanPipelineCache::terminate() noexcept {
+    if (mAsynchronous) {
+        waitForPendingPipelines();
+        mCompilerThreadPool.terminate();
+    }
+
     for (auto& iter : mPipelines) {
         vkDestroyPipeline(mDevice, iter.second.handle, VKALLOC);
     }
     mPipelines.clear();
     mBoundPipeline = {};
+
+    savePipelineCache();
+    if (mPipelineCache != VK_NULL_HANDLE) {
+        vkDestroyPipelineCache(mDevice, mPipelineCache, VKALLOC);
+        mPipelineCache = VK_NULL_HANDLE;
+    }
 }
 
 void VulkanPipelineCache::gc() noexcept {
@@ -299,6 +524,21 @@ void VulkanPipelineCache::gc() noexcept {
     // being used by the GPU, and is therefore safe to destroy or reclaim.
     ++mCurrentTime;
 
+    // Pending pipelines refer to render passes that are only kept alive for a few frames after
+    // their last use, so we can't let their creation run for longer than that.
+    for (auto iter = mPendingPipelines.begin(); iter != mPendingPipelines.end();) {
+        if (iter->second->queued + FVK_MAX_PENDING_PIPELINE_AGE <= mCurrentTime) {
+            waitForPendingPipeline(iter->second);
+            iter = mPendingPipelines.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+
+    if (mCurrentTime - mLastSaveTime >= FVK_PIPELINE_CACHE_SAVE_INTERVAL) {
+        savePipelineCache();
+    }
+
     // The Vulkan spec says: "When a command buffer begins recording, all state in that command
     // buffer is undefined." Therefore, we need to clear all bindings at this time.
     mBoundPipeline = {};
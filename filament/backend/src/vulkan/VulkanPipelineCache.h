@@ -17,12 +17,15 @@
 #ifndef TNT_FILAMENT_BACKEND_VULKANPIPELINECACHE_H
 #define TNT_FILAMENT_BACKEND_VULKANPIPELINECACHE_H
 
+#include "CompilerThreadPool.h"
 #include "VulkanCommands.h"
+#include "VulkanContext.h"
 #include "VulkanMemory.h"
 #include "VulkanResources.h"
 #include "VulkanUtility.h"
 
 #include <backend/DriverEnums.h>
+#include <backend/Platform.h>
 #include <backend/TargetBufferInfo.h>
 
 #include "backend/Program.h"
@@ -31,9 +34,13 @@
 
 #include <utils/bitset.h>
 #include <utils/compiler.h>
+#include <utils/Condition.h>
 #include <utils/Hash.h>
+#include <utils/Mutex.h>
 
+#include <atomic>
 #include <list>
+#include <memory>
 #include <tsl/robin_map.h>
 #include <type_traits>
 #include <vector>
@@ -115,10 +122,26 @@ public:
     VulkanPipelineCache(VkDevice device, VmaAllocator allocator);
     ~VulkanPipelineCache();
 
+    // Creates the VkPipelineCache used for all pipelines, seeded with the data that the
+    // platform's blob cache has for this device, if any. The data is written back to the blob
+    // cache periodically (see gc()) and on terminate().
+    // When asynchronous is true, pipelines that are missing from the cache are created on worker
+    // threads instead of blocking bindPipeline().
+    // When the context supports extended dynamic state, the cull mode, front face, depth write and
+    // depth compare op are set dynamically rather than being part of the pipelines.
+    void initialize(Platform& platform, VulkanContext const& context,
+            VkPhysicalDevice physicalDevice, bool asynchronous) noexcept;
+
     void bindLayout(VkPipelineLayout layout) noexcept;
 
-    // Creates a new pipeline if necessary and binds it using vkCmdBindPipeline.
-    void bindPipeline(VulkanCommandBuffer* commands);
+    // Creates a new pipeline if necessary and binds it using vkCmdBindPipeline. Returns false if
+    // the pipeline isn't available, i.e. it is still being created by a worker thread or its
+    // creation failed, in which case draw calls must be skipped.
+    bool bindPipeline(VulkanCommandBuffer* commands);
+
+    // Waits until all the pipelines being created by worker threads are ready. This must be
+    // called before destroying any of the objects they refer to (shader modules, render passes).
+    void waitForPendingPipelines() noexcept;
 
     // Each of the following methods are fast and do not make Vulkan calls.
     void bindProgram(VulkanProgram* program) noexcept;
@@ -249,12 +272,74 @@ private:
 
     // These helpers all return unstable pointers that should not be stored.
     PipelineCacheEntry* createPipeline() noexcept;
+    PipelineCacheEntry* getOrQueuePipeline() noexcept;
     PipelineLayoutCacheEntry* getOrCreatePipelineLayout() noexcept;
 
+    // Creates the VkPipeline for the given key. This only uses immutable state and the
+    // internally synchronized mPipelineCache, so it can be called from any thread.
+    VkPipeline createPipelineHandle(PipelineKey const& key) const noexcept;
+
+    // Serializes mPipelineCache to the platform's blob cache.
+    void savePipelineCache() noexcept;
+
+    // Sets the dynamic part of the raster state on the given command buffer, if needed.
+    void bindDynamicRasterState(VulkanCommandBuffer* commands) noexcept;
+
+    // A pipeline being created by a worker thread. It is also the token used to cancel the job.
+    struct PendingPipeline : public ProgramToken {
+        ~PendingPipeline() override;
+        PipelineKey key = {};
+        Timestamp queued = 0;
+        VkPipeline handle = VK_NULL_HANDLE;
+        std::atomic<bool> ready{ false };
+    };
+
+    using PendingPipelineMap = tsl::robin_map<PipelineKey, std::shared_ptr<PendingPipeline>,
+            PipelineHashFn, PipelineEqual>;
+
+    // Moves a pending pipeline that is ready to mPipelines.
+    PipelineCacheEntry* retirePendingPipeline(PendingPipeline const& pending) noexcept;
+
+    // Waits for the given pending pipeline, or cancels it if its job hasn't started yet.
+    void waitForPendingPipeline(std::shared_ptr<PendingPipeline> const& pending) noexcept;
+
     // Immutable state.
     VkDevice mDevice = VK_NULL_HANDLE;
     VmaAllocator mAllocator = VK_NULL_HANDLE;
 
+    // The driver-side pipeline cache and the blob cache it's persisted to. The key identifies
+    // the device and driver, whose pipeline cache data is otherwise incompatible.
+    struct BlobKey {
+        char tag[16] = "VkPipelineCache";
+        uint32_t vendorID = 0;
+        uint32_t deviceID = 0;
+        uint32_t driverVersion = 0;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE] = {};
+    };
+    VkPipelineCache mPipelineCache = VK_NULL_HANDLE;
+    Platform* mPlatform = nullptr;
+    BlobKey mBlobKey;
+    Timestamp mLastSaveTime = 0;
+    bool mPipelineCacheDirty = false;
+
+    // Asynchronous pipeline creation, see initialize().
+    bool mAsynchronous = false;
+    CompilerThreadPool mCompilerThreadPool;
+    PendingPipelineMap mPendingPipelines;
+    utils::Mutex mPendingLock;
+    utils::Condition mPendingCondition;
+
+    // The part of the RasterState that isn't in the pipeline keys when extended dynamic state is
+    // supported.
+    struct DynamicRasterState {
+        VkCullModeFlags cullMode;
+        VkFrontFace frontFace;
+        VkBool32 depthWriteEnable;
+        VkCompareOp depthCompareOp;
+    };
+    bool mExtendedDynamicState = false;
+    DynamicRasterState mDynamicRasterState = {};
+
     // Current requirements for the pipeline layout, pipeline, and descriptor sets.
     PipelineKey mPipelineRequirements = {};
 
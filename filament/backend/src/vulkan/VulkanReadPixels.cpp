@@ -24,6 +24,8 @@
 
 #include <utils/Log.h>
 
+#include <algorithm>
+
 using namespace bluevk;
 
 namespace filament::backend {
@@ -107,53 +109,55 @@ void VulkanReadPixels::terminate() noexcept {
     if (mCommandPool == VK_NULL_HANDLE) {
         return;
     }
-    vkDestroyCommandPool(mDevice, mCommandPool, VKALLOC);
-    mDevice = VK_NULL_HANDLE;
 
+    // Shutting down the task handler returns the staging areas of the requests that completed.
     mTaskHandler->shutdown();
     mTaskHandler.reset();
+
+    for (Staging const& staging : mStagingPool) {
+        destroyStaging(staging);
+    }
+    mStagingPool.clear();
+
+    vkDestroyCommandPool(mDevice, mCommandPool, VKALLOC);
+    mDevice = VK_NULL_HANDLE;
 }
 
 VulkanReadPixels::VulkanReadPixels(VkDevice device)
     : mDevice(device) {}
 
-void VulkanReadPixels::run(VulkanRenderTarget* srcTarget, uint32_t const x, uint32_t const y,
-        uint32_t const width, uint32_t const height, uint32_t const graphicsQueueFamilyIndex,
-        PixelBufferDescriptor&& pbd, SelecteMemoryFunction const& selectMemoryFunc,
-        OnReadCompleteFunction const& readCompleteFunc) {
-    assert_invariant(mDevice != VK_NULL_HANDLE);
+VulkanReadPixels::Staging VulkanReadPixels::acquireStaging(VkFormat const format,
+        uint32_t const width, uint32_t const height,
+        SelecteMemoryFunction const& selectMemoryFunc) {
+    VkDevice const device = mDevice;
 
-    VkDevice& device = mDevice;
-
-    if (mCommandPool == VK_NULL_HANDLE) {
-        // Create a command pool if one has not been created.
-        VkCommandPoolCreateInfo createInfo = {
-                .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-                .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
-                         | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
-                .queueFamilyIndex = graphicsQueueFamilyIndex,
-        };
-        vkCreateCommandPool(device, &createInfo, VKALLOC, &mCommandPool);
-    }
-
-    // We don't create a task handler (start a thread) unless readPixels is called.
-    if (!mTaskHandler) {
-        mTaskHandler = std::make_unique<TaskHandler>();
+    {
+        std::unique_lock<std::mutex> lock(mStagingPoolMutex);
+        auto pos = std::find_if(mStagingPool.begin(), mStagingPool.end(),
+                [=](Staging const& staging) {
+                    return staging.format == format &&
+                           staging.width == width && staging.height == height;
+                });
+        if (pos != mStagingPool.end()) {
+            Staging const staging = *pos;
+            mStagingPool.erase(pos);
+            lock.unlock();
+            // The fence was signaled (and waited on) when the staging area was released.
+            vkResetFences(device, 1, &staging.fence);
+            return staging;
+        }
+        // Make room for the new staging area, which will be pooled once released.
+        while (mStagingPool.size() >= MAX_POOLED_STAGING_COUNT) {
+            destroyStaging(mStagingPool.front());
+            mStagingPool.erase(mStagingPool.begin());
+        }
     }
 
-    VkCommandPool& cmdpool = mCommandPool;
-
-    VulkanTexture* srcTexture = srcTarget->getColor(0).texture;
-    assert_invariant(srcTexture);
-    VkFormat const srcFormat = srcTexture->getVkFormat();
-    bool const swizzle
-            = srcFormat == VK_FORMAT_B8G8R8A8_UNORM || srcFormat == VK_FORMAT_B8G8R8A8_SRGB;
-
     // Create a host visible, linearly tiled image as a staging area.
     VkImageCreateInfo const imageInfo{
             .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
             .imageType = VK_IMAGE_TYPE_2D,
-            .format = srcFormat,
+            .format = format,
             .extent = {width, height, 1},
             .mipLevels = 1,
             .arrayLayers = 1,
@@ -166,12 +170,6 @@ void VulkanReadPixels::run(VulkanRenderTarget* srcTarget, uint32_t const x, uint
     VkImage stagingImage;
     vkCreateImage(device, &imageInfo, VKALLOC, &stagingImage);
 
-#if FVK_ENABLED(FVK_DEBUG_READ_PIXELS)
-    utils::slog.d << "readPixels created image=" << stagingImage
-                  << " to copy from image=" << srcTexture->getVkImage()
-                  << " src-layout=" << srcTexture->getLayout(0, 0) << utils::io::endl;
-#endif
-
     VkMemoryRequirements memReqs;
     VkDeviceMemory stagingMemory;
     vkGetImageMemoryRequirements(device, stagingImage, &memReqs);
@@ -202,15 +200,98 @@ void VulkanReadPixels::run(VulkanRenderTarget* srcTarget, uint32_t const x, uint
     vkAllocateMemory(device, &allocInfo, VKALLOC, &stagingMemory);
     vkBindImageMemory(device, stagingImage, stagingMemory, 0);
 
+    VkImageSubresource const subResource{ .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT };
+    VkSubresourceLayout subResourceLayout;
+    vkGetImageSubresourceLayout(device, stagingImage, &subResource, &subResourceLayout);
+
+    // The memory stays mapped for as long as the staging area lives.
+    uint8_t* pixels;
+    vkMapMemory(device, stagingMemory, 0, VK_WHOLE_SIZE, 0, (void**) &pixels);
+
     VkCommandBuffer cmdbuffer;
     VkCommandBufferAllocateInfo const allocateInfo{
             .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-            .commandPool = cmdpool,
+            .commandPool = mCommandPool,
             .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
             .commandBufferCount = 1,
     };
     vkAllocateCommandBuffers(device, &allocateInfo, &cmdbuffer);
 
+    VkFence fence;
+    VkFenceCreateInfo const fenceCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+    };
+    vkCreateFence(device, &fenceCreateInfo, VKALLOC, &fence);
+
+    return {
+            .format = format,
+            .width = width,
+            .height = height,
+            .image = stagingImage,
+            .memory = stagingMemory,
+            .fence = fence,
+            .cmdbuffer = cmdbuffer,
+            .pixels = pixels + subResourceLayout.offset,
+            .rowPitch = subResourceLayout.rowPitch,
+    };
+}
+
+void VulkanReadPixels::destroyStaging(Staging const& staging) noexcept {
+    VkDevice const device = mDevice;
+    vkUnmapMemory(device, staging.memory);
+    vkDestroyImage(device, staging.image, VKALLOC);
+    vkFreeMemory(device, staging.memory, VKALLOC);
+    vkDestroyFence(device, staging.fence, VKALLOC);
+    vkFreeCommandBuffers(device, mCommandPool, 1, &staging.cmdbuffer);
+}
+
+void VulkanReadPixels::releaseStaging(Staging const& staging) noexcept {
+    // Destroying the staging area here would race with the driver thread on the command pool,
+    // so excess staging areas are trimmed by acquireStaging() instead.
+    std::unique_lock<std::mutex> lock(mStagingPoolMutex);
+    mStagingPool.push_back(staging);
+}
+
+void VulkanReadPixels::run(VulkanRenderTarget* srcTarget, uint32_t const x, uint32_t const y,
+        uint32_t const width, uint32_t const height, uint32_t const graphicsQueueFamilyIndex,
+        PixelBufferDescriptor&& pbd, SelecteMemoryFunction const& selectMemoryFunc,
+        OnReadCompleteFunction const& readCompleteFunc) {
+    assert_invariant(mDevice != VK_NULL_HANDLE);
+
+    VkDevice& device = mDevice;
+
+    if (mCommandPool == VK_NULL_HANDLE) {
+        // Create a command pool if one has not been created.
+        VkCommandPoolCreateInfo createInfo = {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                .queueFamilyIndex = graphicsQueueFamilyIndex,
+        };
+        vkCreateCommandPool(device, &createInfo, VKALLOC, &mCommandPool);
+    }
+
+    // We don't create a task handler (start a thread) unless readPixels is called.
+    if (!mTaskHandler) {
+        mTaskHandler = std::make_unique<TaskHandler>();
+    }
+
+    VulkanTexture* srcTexture = srcTarget->getColor(0).texture;
+    assert_invariant(srcTexture);
+    VkFormat const srcFormat = srcTexture->getVkFormat();
+    bool const swizzle
+            = srcFormat == VK_FORMAT_B8G8R8A8_UNORM || srcFormat == VK_FORMAT_B8G8R8A8_SRGB;
+
+    Staging const staging = acquireStaging(srcFormat, width, height, selectMemoryFunc);
+    VkImage const stagingImage = staging.image;
+    VkCommandBuffer const cmdbuffer = staging.cmdbuffer;
+
+#if FVK_ENABLED(FVK_DEBUG_READ_PIXELS)
+    utils::slog.d << "readPixels using image=" << stagingImage
+                  << " to copy from image=" << srcTexture->getVkImage()
+                  << " src-layout=" << srcTexture->getLayout(0, 0) << utils::io::endl;
+#endif
+
+    // This implicitly resets the command buffer if it was recycled.
     VkCommandBufferBeginInfo const binfo{
             .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
             .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
@@ -274,11 +355,6 @@ void VulkanReadPixels::run(VulkanRenderTarget* srcTarget, uint32_t const x, uint
 
     VkQueue queue;
     vkGetDeviceQueue(device, graphicsQueueFamilyIndex, 0, &queue);
-    VkFence readCompleteFence;
-    VkFenceCreateInfo const fenceCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-    };
-    vkCreateFence(device, &fenceCreateInfo, VKALLOC, &readCompleteFence);
     VkSubmitInfo const submitInfo{
             .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
             .waitSemaphoreCount = 0,
@@ -289,46 +365,36 @@ void VulkanReadPixels::run(VulkanRenderTarget* srcTarget, uint32_t const x, uint
             .signalSemaphoreCount = 0,
             .pSignalSemaphores = VK_NULL_HANDLE,
     };
-    vkQueueSubmit(queue, 1, &submitInfo, readCompleteFence);
+    vkQueueSubmit(queue, 1, &submitInfo, staging.fence);
 
-    auto* const pUserBuffer = new PixelBufferDescriptor(std::move(pbd));
-    auto cleanPbdFunc = [pUserBuffer, readCompleteFunc]() {
-        PixelBufferDescriptor& p = *pUserBuffer;
-        readCompleteFunc(std::move(p));
-        delete pUserBuffer;
+    struct Request {
+        PixelBufferDescriptor pbd;
+        bool completed = false;
+    };
+    auto* const pRequest = new Request{ std::move(pbd) };
+    auto cleanPbdFunc = [this, pRequest, staging, readCompleteFunc]() {
+        readCompleteFunc(std::move(pRequest->pbd));
+        // The staging area can only be recycled if the GPU is done with it.
+        if (pRequest->completed) {
+            releaseStaging(staging);
+        }
+        delete pRequest;
     };
-    auto waitFenceFunc = [device, width, height, swizzle, srcFormat, stagingImage, stagingMemory,
-                                 cmdpool, cmdbuffer, pUserBuffer,
-                                 fence = readCompleteFence]() mutable {
-        VkResult status = vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+    auto waitFenceFunc = [device, width, height, swizzle, srcFormat, staging, pRequest]() {
+        VkResult status = vkWaitForFences(device, 1, &staging.fence, VK_TRUE, UINT64_MAX);
         // Fence hasn't been reached. Try waiting again.
         if (status != VK_SUCCESS) {
             utils::slog.e << "Failed to wait for readPixels fence" << utils::io::endl;
             return;
         }
+        pRequest->completed = true;
 
-        PixelBufferDescriptor& p = *pUserBuffer;
-        VkImageSubresource subResource{.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT};
-        VkSubresourceLayout subResourceLayout;
-        vkGetImageSubresourceLayout(device, stagingImage, &subResource, &subResourceLayout);
-
-        // Map image memory so that we can start copying from it.
-        uint8_t const* srcPixels;
-        vkMapMemory(device, stagingMemory, 0, VK_WHOLE_SIZE, 0, (void**) &srcPixels);
-        srcPixels += subResourceLayout.offset;
-
-        if (!DataReshaper::reshapeImage(&p, getComponentType(srcFormat),
-                    getComponentCount(srcFormat), srcPixels,
-                    static_cast<int>(subResourceLayout.rowPitch), static_cast<int>(width),
+        if (!DataReshaper::reshapeImage(&pRequest->pbd, getComponentType(srcFormat),
+                    getComponentCount(srcFormat), staging.pixels,
+                    static_cast<int>(staging.rowPitch), static_cast<int>(width),
                     static_cast<int>(height), swizzle)) {
             utils::slog.e << "Unsupported PixelDataFormat or PixelDataType" << utils::io::endl;
         }
-
-        vkUnmapMemory(device, stagingMemory);
-        vkDestroyImage(device, stagingImage, VKALLOC);
-        vkFreeMemory(device, stagingMemory, VKALLOC);
-        vkDestroyFence(device, fence, VKALLOC);
-        vkFreeCommandBuffers(device, cmdpool, 1, &cmdbuffer);
     };
     mTaskHandler->post(std::move(waitFenceFunc), std::move(cleanPbdFunc));
 }
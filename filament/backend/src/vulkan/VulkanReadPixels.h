@@ -27,6 +27,7 @@
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <vector>
 
 namespace filament::backend {
 
@@ -81,9 +82,36 @@ public:
     void runUntilComplete() noexcept;
 
 private:
+    // The staging area of a request, which is recycled for later requests of the same format and
+    // size once the pixels have been copied out of it.
+    struct Staging {
+        VkFormat format;
+        uint32_t width;
+        uint32_t height;
+        VkImage image;
+        VkDeviceMemory memory;
+        VkFence fence;
+        VkCommandBuffer cmdbuffer;
+        uint8_t const* pixels;  // persistently mapped
+        VkDeviceSize rowPitch;
+    };
+
+    // Maximum number of idle staging areas kept around.
+    static constexpr size_t MAX_POOLED_STAGING_COUNT = 4;
+
+    // These are only called from the driver thread, which owns the command pool.
+    Staging acquireStaging(VkFormat format, uint32_t width, uint32_t height,
+            SelecteMemoryFunction const& selectMemoryFunc);
+    void destroyStaging(Staging const& staging) noexcept;
+
+    // Called from the task handler thread.
+    void releaseStaging(Staging const& staging) noexcept;
+
     VkDevice mDevice = VK_NULL_HANDLE;
     VkCommandPool mCommandPool = VK_NULL_HANDLE;
     std::unique_ptr<TaskHandler> mTaskHandler;
+    std::mutex mStagingPoolMutex;
+    std::vector<Staging> mStagingPool;
 };
 
 }// namespace filament::backend
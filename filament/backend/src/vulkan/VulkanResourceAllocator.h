@@ -51,8 +51,9 @@ namespace filament::backend {
 class VulkanResourceAllocator {
 public:
     using AllocatorImpl = HandleAllocatorVK;
-    VulkanResourceAllocator(size_t arenaSize, bool disableUseAfterFreeCheck)
-        : mHandleAllocatorImpl("Handles", arenaSize, disableUseAfterFreeCheck)
+    VulkanResourceAllocator(size_t arenaSize, bool disableUseAfterFreeCheck,
+            uint8_t const* poolWeights = nullptr)
+        : mHandleAllocatorImpl("Handles", arenaSize, disableUseAfterFreeCheck, poolWeights)
 #if DEBUG_RESOURCE_LEAKS
         , mDebugOnlyResourceCount(RESOURCE_TYPE_COUNT) {
         std::memset(mDebugOnlyResourceCount.data(), 0, sizeof(size_t) * RESOURCE_TYPE_COUNT);
@@ -105,6 +106,10 @@ public:
         mHandleAllocatorImpl.deallocate(handle, obj);
     }
 
+    HandleAllocatorStats getStats() const noexcept {
+        return mHandleAllocatorImpl.getStats();
+    }
+
 private:
     AllocatorImpl mHandleAllocatorImpl;
 
@@ -27,6 +27,21 @@ static constexpr uint32_t TIME_BEFORE_EVICTION = FVK_MAX_COMMAND_BUFFERS;
 
 namespace filament::backend {
 
+namespace {
+
+// Stages are read by both the graphics queue and the dedicated transfer queue (if any), so they are
+// shared by the two queue families rather than transferred from one to the other.
+void setSharingMode(VulkanCommands const* commands, uint32_t const (&queueFamilyIndices)[2],
+        VkBufferCreateInfo& bufferInfo) {
+    if (commands->hasTransferQueue()) {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = 2;
+        bufferInfo.pQueueFamilyIndices = queueFamilyIndices;
+    }
+}
+
+} // anonymous namespace
+
 VulkanStagePool::VulkanStagePool(VmaAllocator allocator, VulkanCommands* commands)
     : mAllocator(allocator),
       mCommands(commands) {}
@@ -55,6 +70,11 @@ VulkanStage const* VulkanStagePool::acquireStage(uint32_t numBytes) {
         .size = numBytes,
         .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
     };
+    uint32_t const queueFamilyIndices[2] = {
+        mCommands->getQueueFamilyIndex(),
+        mCommands->getTransferQueueFamilyIndex(),
+    };
+    setSharingMode(mCommands, queueFamilyIndices, bufferInfo);
     VmaAllocationCreateInfo allocInfo { .usage = VMA_MEMORY_USAGE_CPU_ONLY };
     UTILS_UNUSED_IN_RELEASE VkResult result = vmaCreateBuffer(mAllocator, &bufferInfo,
             &allocInfo, &stage->buffer, &stage->memory, nullptr);
@@ -68,6 +88,66 @@ VulkanStage const* VulkanStagePool::acquireStage(uint32_t numBytes) {
     return stage;
 }
 
+VulkanStageSegment VulkanStagePool::acquireStageSegment(uint32_t numBytes) {
+    assert_invariant(numBytes <= FVK_STAGE_SEGMENT_MAX_SIZE);
+    uint32_t offset = (mCurrentBlockOffset + FVK_STAGE_SEGMENT_ALIGNMENT - 1) &
+            ~(FVK_STAGE_SEGMENT_ALIGNMENT - 1);
+    if (!mCurrentBlock.stage || offset + numBytes > FVK_STAGE_BLOCK_SIZE) {
+        retireCurrentBlock();
+        mCurrentBlock = acquireBlock();
+        offset = 0;
+    }
+    mCurrentBlockOffset = offset + numBytes;
+    return {
+        .stage = mCurrentBlock.stage,
+        .offset = offset,
+        .mapped = static_cast<uint8_t*>(mCurrentBlock.mapped) + offset,
+    };
+}
+
+VulkanStagePool::StageBlock VulkanStagePool::acquireBlock() {
+    if (!mFreeBlocks.empty()) {
+        StageBlock const block = mFreeBlocks.back();
+        mFreeBlocks.pop_back();
+        return block;
+    }
+
+    VulkanStage* stage = new VulkanStage({
+        .memory = VK_NULL_HANDLE,
+        .buffer = VK_NULL_HANDLE,
+        .capacity = FVK_STAGE_BLOCK_SIZE,
+        .lastAccessed = mCurrentFrame,
+    });
+    VkBufferCreateInfo bufferInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = FVK_STAGE_BLOCK_SIZE,
+        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+    };
+    uint32_t const queueFamilyIndices[2] = {
+        mCommands->getQueueFamilyIndex(),
+        mCommands->getTransferQueueFamilyIndex(),
+    };
+    setSharingMode(mCommands, queueFamilyIndices, bufferInfo);
+    VmaAllocationCreateInfo allocInfo {
+        .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+        .usage = VMA_MEMORY_USAGE_CPU_ONLY
+    };
+    VmaAllocationInfo info = {};
+    UTILS_UNUSED_IN_RELEASE VkResult result = vmaCreateBuffer(mAllocator, &bufferInfo,
+            &allocInfo, &stage->buffer, &stage->memory, &info);
+    assert_invariant(result == VK_SUCCESS && info.pMappedData);
+    return { stage, info.pMappedData };
+}
+
+void VulkanStagePool::retireCurrentBlock() noexcept {
+    if (mCurrentBlock.stage) {
+        mCurrentBlock.stage->lastAccessed = mCurrentFrame;
+        mUsedBlocks.push_back(mCurrentBlock);
+        mCurrentBlock = {};
+        mCurrentBlockOffset = 0;
+    }
+}
+
 VulkanStageImage const* VulkanStagePool::acquireImage(PixelDataFormat format, PixelDataType type,
         uint32_t width, uint32_t height) {
     const VkFormat vkformat = getVkFormat(format, type);
@@ -132,6 +212,10 @@ void VulkanStagePool::gc() noexcept {
     FVK_SYSTRACE_CONTEXT();
     FVK_SYSTRACE_START("stagepool::gc");
 
+    // The next frame starts sub-allocating from another block, so that the whole block can be
+    // recycled once this frame's command buffers have completed.
+    retireCurrentBlock();
+
     // If this is one of the first few frames, return early to avoid wrapping unsigned integers.
     if (++mCurrentFrame <= TIME_BEFORE_EVICTION) {
         return;
@@ -185,9 +269,53 @@ void VulkanStagePool::gc() noexcept {
             mUsedImages.insert(image);
         }
     }
+
+    // Destroy blocks that have not been used for several frames.
+    decltype(mFreeBlocks) freeBlocks;
+    freeBlocks.swap(mFreeBlocks);
+    for (auto block : freeBlocks) {
+        if (block.stage->lastAccessed < evictionTime) {
+            vmaDestroyBuffer(mAllocator, block.stage->buffer, block.stage->memory);
+            delete block.stage;
+        } else {
+            mFreeBlocks.push_back(block);
+        }
+    }
+
+    // Reclaim blocks that are no longer being used by any command buffer.
+    decltype(mUsedBlocks) usedBlocks;
+    usedBlocks.swap(mUsedBlocks);
+    for (auto block : usedBlocks) {
+        if (block.stage->lastAccessed < evictionTime) {
+            block.stage->lastAccessed = mCurrentFrame;
+            mFreeBlocks.push_back(block);
+        } else {
+            mUsedBlocks.push_back(block);
+        }
+    }
     FVK_SYSTRACE_END();
 }
 
+void VulkanStagePool::trim() noexcept {
+    for (auto pair : mFreeStages) {
+        vmaDestroyBuffer(mAllocator, pair.second->buffer, pair.second->memory);
+        delete pair.second;
+    }
+    mFreeStages.clear();
+
+    for (auto image : mFreeImages) {
+        vmaDestroyImage(mAllocator, image->image, image->memory);
+        delete image;
+    }
+    mFreeImages.clear();
+
+    for (auto block : mFreeBlocks) {
+        vmaDestroyBuffer(mAllocator, block.stage->buffer, block.stage->memory);
+        delete block.stage;
+    }
+    mFreeBlocks.clear();
+}
+
 void VulkanStagePool::terminate() noexcept {
     for (auto stage : mUsedStages) {
         vmaDestroyBuffer(mAllocator, stage->buffer, stage->memory);
@@ -212,6 +340,15 @@ void VulkanStagePool::terminate() noexcept {
         delete image;
     }
     mFreeStages.clear();
+
+    retireCurrentBlock();
+    for (auto const& blocks : { &mUsedBlocks, &mFreeBlocks }) {
+        for (auto block : *blocks) {
+            vmaDestroyBuffer(mAllocator, block.stage->buffer, block.stage->memory);
+            delete block.stage;
+        }
+        blocks->clear();
+    }
 }
 
 } // namespace filament::backend
@@ -23,6 +23,7 @@
 
 #include <map>
 #include <unordered_set>
+#include <vector>
 
 namespace filament::backend {
 
@@ -34,6 +35,13 @@ struct VulkanStage {
     mutable uint64_t lastAccessed;
 };
 
+// A sub-allocation of a persistently mapped stage, see VulkanStagePool::acquireStageSegment().
+struct VulkanStageSegment {
+    VulkanStage const* stage;
+    uint32_t offset;
+    void* mapped;
+};
+
 struct VulkanStageImage {
     VkFormat format;
     uint32_t width;
@@ -53,6 +61,12 @@ public:
     // The stage is automatically released back to the pool after TIME_BEFORE_EVICTION frames.
     VulkanStage const* acquireStage(uint32_t numBytes);
 
+    // Sub-allocates the given number of bytes from a persistently mapped stage that is shared with
+    // other uploads. This avoids an allocation and a mapping per upload, which makes it much
+    // cheaper than acquireStage() for the many small uploads of a frame. numBytes must not exceed
+    // FVK_STAGE_SEGMENT_MAX_SIZE. The segment is recycled after TIME_BEFORE_EVICTION frames.
+    VulkanStageSegment acquireStageSegment(uint32_t numBytes);
+
     // Images have VK_IMAGE_LAYOUT_GENERAL and must not be transitioned to any other layout
     VulkanStageImage const* acquireImage(PixelDataFormat format, PixelDataType type,
             uint32_t width, uint32_t height);
@@ -60,11 +74,23 @@ public:
     // Evicts old unused stages and bumps the current frame number.
     void gc() noexcept;
 
+    // Destroys all the stages that are not in use, regardless of when they were last used. This
+    // is meant to be called when memory is running low.
+    void trim() noexcept;
+
     // Destroys all unused stages and asserts that there are no stages currently in use.
     // This should be called while the context's VkDevice is still alive.
     void terminate() noexcept;
 
 private:
+    struct StageBlock {
+        VulkanStage* stage;
+        void* mapped;
+    };
+
+    StageBlock acquireBlock();
+    void retireCurrentBlock() noexcept;
+
     VmaAllocator mAllocator;
     VulkanCommands* mCommands;
 
@@ -77,6 +103,12 @@ private:
     std::unordered_set<VulkanStageImage const*> mFreeImages;
     std::unordered_set<VulkanStageImage const*> mUsedImages;
 
+    // Blocks that segments are sub-allocated from, segments are bump allocated in mCurrentBlock.
+    std::vector<StageBlock> mFreeBlocks;
+    std::vector<StageBlock> mUsedBlocks;
+    StageBlock mCurrentBlock = {};
+    uint32_t mCurrentBlockOffset = 0;
+
     // Store the current "time" (really just a frame count) and LRU eviction parameters.
     uint64_t mCurrentFrame = 0;
 };
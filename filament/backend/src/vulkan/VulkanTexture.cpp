@@ -24,13 +24,16 @@
 
 #include <utils/Panic.h>
 
+#include <algorithm>
+
 using namespace bluevk;
 
 namespace filament::backend {
 
 VulkanTexture::VulkanTexture(VkDevice device, VmaAllocator allocator, VulkanCommands* commands,
         VkImage image, VkFormat format, uint8_t samples, uint32_t width, uint32_t height,
-        TextureUsage tusage, VulkanStagePool& stagePool, bool heapAllocated)
+        TextureUsage tusage, VulkanStagePool& stagePool, bool heapAllocated,
+        VkDeviceMemory memory)
     : HwTexture(SamplerType::SAMPLER_2D, 1, samples, width, height, 1, TextureFormat::UNUSED,
             tusage),
       VulkanResource(
@@ -39,6 +42,7 @@ VulkanTexture::VulkanTexture(VkDevice device, VmaAllocator allocator, VulkanComm
       mViewType(imgutil::getViewType(target)),
       mSwizzle({}),
       mTextureImage(image),
+      mTextureImageMemory(memory),
       mFullViewRange{
               .aspectMask = getImageAspect(),
               .baseMipLevel = 0,
@@ -142,6 +146,17 @@ VulkanTexture::VulkanTexture(VkDevice device, VkPhysicalDevice physicalDevice,
         }
     }
 
+    // Transient attachments can be lazily allocated, i.e. stay in tile memory, but then they
+    // can't have any usage other than attachment.
+    constexpr VkImageUsageFlags transientUsages = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+    bool const transient = any(usage & TextureUsage::TRANSIENT_ATTACHMENT) &&
+            !((imageInfo.usage & ~blittable) & ~transientUsages);
+    if (transient) {
+        imageInfo.usage &= ~blittable;
+        imageInfo.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+    }
+
     // Constrain the sample count according to the sample count masks in VkPhysicalDeviceProperties.
     // Note that VulkanRenderTarget holds a single MSAA count, so we play it safe if this is used as
     // any kind of attachment (color or depth).
@@ -183,8 +198,15 @@ VulkanTexture::VulkanTexture(VkDevice device, VkPhysicalDevice physicalDevice,
     VkMemoryRequirements memReqs = {};
     vkGetImageMemoryRequirements(mDevice, mTextureImage, &memReqs);
 
-    uint32_t memoryTypeIndex
-            = context.selectMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    uint32_t memoryTypeIndex = VK_MAX_MEMORY_TYPES;
+    if (transient) {
+        memoryTypeIndex = context.selectMemoryType(memReqs.memoryTypeBits,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+    }
+    if (memoryTypeIndex == VK_MAX_MEMORY_TYPES) {
+        memoryTypeIndex = context.selectMemoryType(memReqs.memoryTypeBits,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
 
     FILAMENT_CHECK_POSTCONDITION(memoryTypeIndex < VK_MAX_MEMORY_TYPES)
             << "VulkanTexture: unable to find a memory type that meets requirements.";
@@ -332,6 +354,52 @@ void VulkanTexture::updateImage(const PixelBufferDescriptor& data, uint32_t widt
         nextLayout = imgutil::getDefaultLayout(this->usage);
     }
 
+    // The first upload of whole levels of a color image can't conflict with any earlier command,
+    // so it is done on the dedicated transfer queue when there is one, and then handed over to
+    // the graphics queue. Whole levels always satisfy the image transfer granularity of the queue,
+    // and transfer-only queues can't copy to depth or stencil aspects.
+    bool const isWholeLevel = xoffset == 0 && yoffset == 0 &&
+            width == std::max(1u, this->width >> miplevel) &&
+            height == std::max(1u, this->height >> miplevel) &&
+            (target != SamplerType::SAMPLER_3D ||
+                    (zoffset == 0 && depth == std::max(1u, this->depth >> miplevel)));
+    bool isUndefined = true;
+    for (uint32_t layer = transitionRange.baseArrayLayer,
+            end = layer + transitionRange.layerCount; layer < end; layer++) {
+        isUndefined = isUndefined && getLayout(layer, miplevel) == VulkanLayout::UNDEFINED;
+    }
+    VkCommandBuffer const transferbuf =
+            isWholeLevel && isUndefined && transitionRange.aspectMask == VK_IMAGE_ASPECT_COLOR_BIT
+                    ? mCommands->getTransfer() : VK_NULL_HANDLE;
+    if (transferbuf != VK_NULL_HANDLE) {
+        // The previous contents are discarded, and nothing needs to wait for.
+        VkImageMemoryBarrier const barrier = {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = 0,
+                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .newLayout = newVkLayout,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = mTextureImage,
+                .subresourceRange = transitionRange,
+        };
+        vkCmdPipelineBarrier(transferbuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        vkCmdCopyBufferToImage(transferbuf, stage->buffer, mTextureImage, newVkLayout, 1,
+                &copyRegion);
+
+        imgutil::transferOwnership(transferbuf, cmdbuf, {
+                    .image = mTextureImage,
+                    .oldLayout = newLayout,
+                    .newLayout = nextLayout,
+                    .subresources = transitionRange,
+                }, mCommands->getTransferQueueFamilyIndex(), mCommands->getQueueFamilyIndex());
+        setLayout(transitionRange, nextLayout);
+        return;
+    }
+
     transitionLayout(cmdbuf, transitionRange, newLayout);
 
     vkCmdCopyBufferToImage(cmdbuf, stage->buffer, mTextureImage, newVkLayout, 1, &copyRegion);
@@ -40,9 +40,12 @@ struct VulkanTexture : public HwTexture, VulkanResource {
 
     // Specialized constructor for internally created textures (e.g. from a swap chain)
     // The texture will never destroy the given VkImage, but it does manages its subresources.
+    // If memory is given (e.g. for an imported external image), the texture takes ownership of
+    // both the image and the memory.
     VulkanTexture(VkDevice device, VmaAllocator allocator, VulkanCommands* commands, VkImage image,
             VkFormat format, uint8_t samples, uint32_t width, uint32_t height, TextureUsage tusage,
-            VulkanStagePool& stagePool, bool heapAllocated = false);
+            VulkanStagePool& stagePool, bool heapAllocated = false,
+            VkDeviceMemory memory = VK_NULL_HANDLE);
 
     ~VulkanTexture();
 
@@ -92,6 +95,16 @@ struct VulkanTexture : public HwTexture, VulkanResource {
         return mSidecarMSAA.get();
     }
 
+    // For SAMPLER_EXTERNAL textures, the texture that wraps the most recently imported external
+    // image. It is sampled in place of this texture. Its lifetime is managed by the driver.
+    void setExternalImage(VulkanTexture* image) {
+        mExternalImage = image;
+    }
+
+    VulkanTexture* getExternalImage() const {
+        return mExternalImage;
+    }
+
     void transitionLayout(VkCommandBuffer commands, const VkImageSubresourceRange& range,
             VulkanLayout newLayout);
 
@@ -140,6 +153,7 @@ private:
 
     // The texture with the sidecar owns the sidecar.
     std::unique_ptr<VulkanTexture> mSidecarMSAA;
+    VulkanTexture* mExternalImage = nullptr;
     const VkFormat mVkFormat;
     const VkImageViewType mViewType;
     const VkComponentMapping mSwizzle;
@@ -822,39 +822,11 @@ public:
 
             switch (i) {
                 case UBO_SET_ID: {
-                    for (uint8_t binding: layout->bindings.ubo) {
-                        auto const& [info, ubo] = mUboMap[binding];
-                        descriptorWrites[nwrites++] = {
-                                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                                .pNext = nullptr,
-                                .dstSet = vkSet,
-                                .dstBinding = binding,
-                                .descriptorCount = 1,
-                                .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                                .pBufferInfo = ubo ? &info : &mPlaceHolderBufferInfo,
-                        };
-                        if (ubo) {
-                            set->resources.acquire(ubo);
-                        }
-                    }
+                    writeUboSet(set, layout);
                     break;
                 }
                 case SAMPLER_SET_ID: {
-                    for (uint8_t binding: layout->bindings.sampler) {
-                        auto const& [info, texture] = mSamplerMap[binding];
-                        descriptorWrites[nwrites++] = {
-                                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                                .pNext = nullptr,
-                                .dstSet = vkSet,
-                                .dstBinding = binding,
-                                .descriptorCount = 1,
-                                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                                .pImageInfo = texture ? &info : &mPlaceHolderImageInfo,
-                        };
-                        if (texture) {
-                            set->resources.acquire(texture);
-                        }
-                    }
+                    writeSamplerSet(set, layout);
                     break;
                 }
                 case INPUT_ATTACHMENT_SET_ID: {
@@ -928,27 +900,7 @@ public:
         VkDescriptorSet const vkSet = set->vkSet;
 
         if (!cached) {
-            VkWriteDescriptorSet descriptorWrites[MAX_UBO_BINDING];
-            uint8_t nwrites = 0;
-
-            for (uint8_t binding: layout->bindings.ubo) {
-                auto const& [info, ubo] = mUboMap[binding];
-                descriptorWrites[nwrites++] = {
-                        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                        .pNext = nullptr,
-                        .dstSet = vkSet,
-                        .dstBinding = binding,
-                        .descriptorCount = 1,
-                        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                        .pBufferInfo = ubo ? &info : &mPlaceHolderBufferInfo,
-                };
-                if (ubo) {
-                    set->resources.acquire(ubo);
-                }
-            }
-            if (nwrites > 0) {
-                vkUpdateDescriptorSets(mDevice, nwrites, descriptorWrites, 0, nullptr);
-            }
+            writeUboSet(set, layout);
         }
         commands->acquire(set);
 
@@ -1055,29 +1007,123 @@ public:
 
     inline void gc() {
         mDescriptorSetCache.gc();
+        mLastUboSet = {};
+        mLastSamplerSet = {};
+        mLastInputAttachmentSet = {};
     }
 
 private:
+    // The set that was last returned by getSet() for a given kind of key.
+    template<typename Key>
+    struct LastSet {
+        Key key = {};
+        VulkanDescriptorSet* set = nullptr;
+    };
+
     inline std::pair<VulkanDescriptorSet*, bool> getSet(uint8_t const setIndex,
             VulkanDescriptorSetLayout* layout) {
         switch (setIndex) {
             case UBO_SET_ID: {
                 auto key = UBOKey::key(mUboMap, layout);
-                return mDescriptorSetCache.get(key, layout);
+                return getSet(key, layout, mLastUboSet);
             }
             case SAMPLER_SET_ID: {
                 auto key = SamplerKey::key(mSamplerMap, layout);
-                return mDescriptorSetCache.get(key, layout);
+                return getSet(key, layout, mLastSamplerSet);
             }
             case INPUT_ATTACHMENT_SET_ID: {
                 auto key = InputAttachmentKey::key(mInputAttachment.second, layout);
-                return mDescriptorSetCache.get(key, layout);
+                return getSet(key, layout, mLastInputAttachmentSet);
             }
             default:
                 PANIC_POSTCONDITION("Invalid set-id=%d", setIndex);
         }
     }
 
+    // Consecutive draws very often use the same resources, in which case we return the same set
+    // without hashing the key or updating the LRU. Sets are only evicted in gc(), which also
+    // forgets the last sets, so the set is always still in the cache.
+    template<typename Key>
+    inline std::pair<VulkanDescriptorSet*, bool> getSet(Key const& key,
+            VulkanDescriptorSetLayout* layout, LastSet<Key>& last) {
+        if (last.set && typename Key::Equal()(last.key, key)) {
+            return { last.set, true };
+        }
+        auto const result = mDescriptorSetCache.get(key, layout);
+        last = { key, result.first };
+        return result;
+    }
+
+    // UBO and sampler sets are written through an update template that is built once per layout.
+    // The template reads the descriptor infos from a packed array, so writing a new set is one call
+    // instead of assembling a VkWriteDescriptorSet per binding.
+    VkDescriptorUpdateTemplate getUpdateTemplate(uint8_t setID, VulkanDescriptorSetLayout* layout) {
+        if (layout->updateTemplate != VK_NULL_HANDLE) {
+            return layout->updateTemplate;
+        }
+
+        bool const isUbo = setID == UBO_SET_ID;
+        auto const& bindings = isUbo ? layout->bindings.ubo : layout->bindings.sampler;
+        size_t const stride = isUbo ? sizeof(VkDescriptorBufferInfo) : sizeof(VkDescriptorImageInfo);
+        assert_invariant(!bindings.empty());
+
+        VkDescriptorUpdateTemplateEntry entries[MAX_SAMPLER_BINDING];
+        uint32_t count = 0;
+        for (uint8_t binding: bindings) {
+            entries[count] = {
+                    .dstBinding = binding,
+                    .dstArrayElement = 0,
+                    .descriptorCount = 1,
+                    .descriptorType = isUbo ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
+                                            : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                    .offset = count * stride,
+                    .stride = stride,
+            };
+            count++;
+        }
+
+        VkDescriptorUpdateTemplateCreateInfo const info{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+                .descriptorUpdateEntryCount = count,
+                .pDescriptorUpdateEntries = entries,
+                .templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+                .descriptorSetLayout = layout->vklayout,
+        };
+        VkResult const result = vkCreateDescriptorUpdateTemplate(mDevice, &info, VKALLOC,
+                &layout->updateTemplate);
+        FILAMENT_CHECK_POSTCONDITION(result == VK_SUCCESS)
+                << "Unable to create descriptor update template, error=" << result;
+        return layout->updateTemplate;
+    }
+
+    void writeUboSet(VulkanDescriptorSet* set, VulkanDescriptorSetLayout* layout) {
+        VkDescriptorBufferInfo infos[MAX_UBO_BINDING];
+        uint8_t count = 0;
+        for (uint8_t binding: layout->bindings.ubo) {
+            auto const& [info, ubo] = mUboMap[binding];
+            infos[count++] = ubo ? info : mPlaceHolderBufferInfo;
+            if (ubo) {
+                set->resources.acquire(ubo);
+            }
+        }
+        vkUpdateDescriptorSetWithTemplate(mDevice, set->vkSet,
+                getUpdateTemplate(UBO_SET_ID, layout), infos);
+    }
+
+    void writeSamplerSet(VulkanDescriptorSet* set, VulkanDescriptorSetLayout* layout) {
+        VkDescriptorImageInfo infos[MAX_SAMPLER_BINDING];
+        uint8_t count = 0;
+        for (uint8_t binding: layout->bindings.sampler) {
+            auto const& [info, texture] = mSamplerMap[binding];
+            infos[count++] = texture ? info : mPlaceHolderImageInfo;
+            if (texture) {
+                set->resources.acquire(texture);
+            }
+        }
+        vkUpdateDescriptorSetWithTemplate(mDevice, set->vkSet,
+                getUpdateTemplate(SAMPLER_SET_ID, layout), infos);
+    }
+
     inline Handle<VulkanDescriptorSetLayout> getPlaceHolderLayout(uint8_t setID) {
         if (mPlaceholderLayout[setID]) {
             return mPlaceholderLayout[setID];
@@ -1134,6 +1180,9 @@ private:
     std::unordered_map<VulkanProgram*, VulkanDescriptorSetLayoutList> mLayoutStash;
     BoundState mBoundState;
     VulkanDescriptorSetLayoutList mPlaceholderLayout = {};
+    LastSet<UBOKey> mLastUboSet;
+    LastSet<SamplerKey> mLastSamplerSet;
+    LastSet<InputAttachmentKey> mLastInputAttachmentSet;
 };
 
 VulkanDescriptorSetManager::VulkanDescriptorSetManager(VkDevice device,
@@ -192,6 +192,12 @@ ExtensionSet getDeviceExtensions(VkPhysicalDevice device) {
             VK_KHR_MAINTENANCE1_EXTENSION_NAME,
             VK_KHR_MAINTENANCE2_EXTENSION_NAME,
             VK_KHR_MAINTENANCE3_EXTENSION_NAME,
+            VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME,
+            VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+#if defined(__ANDROID__)
+            VK_ANDROID_EXTERNAL_MEMORY_ANDROID_HARDWARE_BUFFER_EXTENSION_NAME,
+            VK_EXT_QUEUE_FAMILY_FOREIGN_EXTENSION_NAME,
+#endif
     };
     ExtensionSet exts;
     // Identify supported physical device extensions
@@ -288,9 +294,9 @@ VkInstance createInstance(ExtensionSet const& requiredExts) {
 
 VkDevice createLogicalDevice(VkPhysicalDevice physicalDevice,
         VkPhysicalDeviceFeatures const& features, uint32_t graphicsQueueFamilyIndex,
-        ExtensionSet const& deviceExtensions) {
+        uint32_t transferQueueFamilyIndex, ExtensionSet const& deviceExtensions) {
     VkDevice device;
-    VkDeviceQueueCreateInfo deviceQueueCreateInfo[1] = {};
+    VkDeviceQueueCreateInfo deviceQueueCreateInfo[2] = {};
     const float queuePriority[] = {1.0f};
     VkDeviceCreateInfo deviceCreateInfo = {};
     FixedCapacityVector<const char*> requestExtensions;
@@ -305,13 +311,21 @@ VkDevice createLogicalDevice(VkPhysicalDevice physicalDevice,
     deviceQueueCreateInfo->queueFamilyIndex = graphicsQueueFamilyIndex;
     deviceQueueCreateInfo->queueCount = 1;
     deviceQueueCreateInfo->pQueuePriorities = &queuePriority[0];
+    uint32_t queueCreateInfoCount = 1;
+    if (transferQueueFamilyIndex != INVALID_VK_INDEX) {
+        deviceQueueCreateInfo[1] = deviceQueueCreateInfo[0];
+        deviceQueueCreateInfo[1].queueFamilyIndex = transferQueueFamilyIndex;
+        queueCreateInfoCount++;
+    }
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    deviceCreateInfo.queueCreateInfoCount = 1;
+    deviceCreateInfo.queueCreateInfoCount = queueCreateInfoCount;
     deviceCreateInfo.pQueueCreateInfos = deviceQueueCreateInfo;
 
     // We could simply enable all supported features, but since that may have performance
     // consequences let's just enable the features we need.
     VkPhysicalDeviceFeatures enabledFeatures{
+            .multiDrawIndirect = features.multiDrawIndirect,
+            .drawIndirectFirstInstance = features.drawIndirectFirstInstance,
             .samplerAnisotropy = features.samplerAnisotropy,
             .textureCompressionETC2 = features.textureCompressionETC2,
             .textureCompressionBC = features.textureCompressionBC,
@@ -332,6 +346,16 @@ VkDevice createLogicalDevice(VkPhysicalDevice physicalDevice,
         deviceCreateInfo.pNext = &portability;
     }
 
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicState = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT,
+            .pNext = nullptr,
+            .extendedDynamicState = VK_TRUE,
+    };
+    if (setContains(deviceExtensions, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)) {
+        extendedDynamicState.pNext = const_cast<void*>(deviceCreateInfo.pNext);
+        deviceCreateInfo.pNext = &extendedDynamicState;
+    }
+
     VkResult result = vkCreateDevice(physicalDevice, &deviceCreateInfo, VKALLOC, &device);
     FILAMENT_CHECK_POSTCONDITION(result == VK_SUCCESS) << "vkCreateDevice error=" << result << ".";
 
@@ -361,6 +385,28 @@ std::tuple<ExtensionSet, ExtensionSet> pruneExtensions(VkPhysicalDevice device,
     }
 #endif
 
+    // The extended dynamic state extension can be advertised without the feature being supported.
+    if (setContains(newDeviceExts, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)) {
+        VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicState = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT,
+        };
+        VkPhysicalDeviceFeatures2 features = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext = &extendedDynamicState,
+        };
+        if (vkGetPhysicalDeviceFeatures2KHR) {
+            vkGetPhysicalDeviceFeatures2KHR(device, &features);
+        }
+        if (!extendedDynamicState.extendedDynamicState) {
+            newDeviceExts.erase(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+        }
+    }
+
+    // VMA queries the memory budget with vkGetPhysicalDeviceMemoryProperties2KHR.
+    if (!setContains(newInstExts, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)) {
+        newDeviceExts.erase(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
     return std::tuple(newInstExts, newDeviceExts);
 }
 
@@ -390,6 +436,22 @@ uint32_t identifyGraphicsQueueFamilyIndex(VkPhysicalDevice physicalDevice) {
     return graphicsQueueFamilyIndex;
 }
 
+// Returns a family of queues that only support transfers, which typically map to the DMA engines
+// of discrete GPUs, or INVALID_VK_INDEX if there is none.
+uint32_t identifyTransferQueueFamilyIndex(VkPhysicalDevice physicalDevice) {
+    const FixedCapacityVector<VkQueueFamilyProperties> queueFamiliesProperties
+            = getPhysicalDeviceQueueFamilyPropertiesHelper(physicalDevice);
+    constexpr VkQueueFlags GRAPHICS_OR_COMPUTE = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+    for (uint32_t j = 0; j < queueFamiliesProperties.size(); ++j) {
+        VkQueueFamilyProperties props = queueFamiliesProperties[j];
+        if (props.queueCount != 0 && (props.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+                !(props.queueFlags & GRAPHICS_OR_COMPUTE)) {
+            return j;
+        }
+    }
+    return INVALID_VK_INDEX;
+}
+
 // Provide a preference ordering of device types.
 // Enum based on:
 // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPhysicalDeviceType.html
@@ -554,6 +616,8 @@ struct VulkanPlatformPrivate {
     uint32_t mGraphicsQueueFamilyIndex = INVALID_VK_INDEX;
     uint32_t mGraphicsQueueIndex = INVALID_VK_INDEX;
     VkQueue mGraphicsQueue = VK_NULL_HANDLE;
+    uint32_t mTransferQueueFamilyIndex = INVALID_VK_INDEX;
+    VkQueue mTransferQueue = VK_NULL_HANDLE;
     VulkanContext mContext = {};
 
     // We use a map to both map a handle (i.e. SwapChainPtr) to the concrete type and also to
@@ -689,11 +753,17 @@ Driver* VulkanPlatform::createDriver(void* sharedContext,
                 = pruneExtensions(mImpl->mPhysicalDevice, instExts, deviceExts);
         instExts = prunedInstExts;
         deviceExts = prunedDeviceExts;
+
+        // Uploads are recorded on a dedicated transfer queue when there is one. We don't know
+        // which queues the client has created with a shared context, so this is only done when
+        // we create the device ourselves.
+        mImpl->mTransferQueueFamilyIndex = identifyTransferQueueFamilyIndex(mImpl->mPhysicalDevice);
     }
 
     mImpl->mDevice
             = mImpl->mDevice == VK_NULL_HANDLE ? createLogicalDevice(mImpl->mPhysicalDevice,
-                      context.mPhysicalDeviceFeatures, mImpl->mGraphicsQueueFamilyIndex, deviceExts)
+                      context.mPhysicalDeviceFeatures, mImpl->mGraphicsQueueFamilyIndex,
+                      mImpl->mTransferQueueFamilyIndex, deviceExts)
                                                : mImpl->mDevice;
     assert_invariant(mImpl->mDevice != VK_NULL_HANDLE);
 
@@ -701,9 +771,18 @@ Driver* VulkanPlatform::createDriver(void* sharedContext,
             &mImpl->mGraphicsQueue);
     assert_invariant(mImpl->mGraphicsQueue != VK_NULL_HANDLE);
 
+    if (mImpl->mTransferQueueFamilyIndex != INVALID_VK_INDEX) {
+        vkGetDeviceQueue(mImpl->mDevice, mImpl->mTransferQueueFamilyIndex, 0,
+                &mImpl->mTransferQueue);
+        assert_invariant(mImpl->mTransferQueue != VK_NULL_HANDLE);
+    }
+
     // Store the extension support in the context
     context.mDebugUtilsSupported = setContains(instExts, VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     context.mDebugMarkersSupported = setContains(deviceExts, VK_EXT_DEBUG_MARKER_EXTENSION_NAME);
+    context.mExtendedDynamicStateSupported =
+            setContains(deviceExts, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+    context.mMemoryBudgetSupported = setContains(deviceExts, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
 
 #ifdef NDEBUG
     // If we are in release build, we should not have turned on debug extensions
@@ -813,6 +892,14 @@ VkQueue VulkanPlatform::getGraphicsQueue() const noexcept {
     return mImpl->mGraphicsQueue;
 }
 
+uint32_t VulkanPlatform::getTransferQueueFamilyIndex() const noexcept {
+    return mImpl->mTransferQueueFamilyIndex;
+}
+
+VkQueue VulkanPlatform::getTransferQueue() const noexcept {
+    return mImpl->mTransferQueue;
+}
+
 #undef SWAPCHAIN_RET_FUNC
 
 }// namespace filament::backend
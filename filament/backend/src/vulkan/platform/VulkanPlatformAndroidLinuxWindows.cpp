@@ -20,6 +20,7 @@
 #include "vulkan/VulkanConstants.h"
 #include "vulkan/VulkanDriverFactory.h"
 
+#include <utils/Log.h>
 #include <utils/Panic.h>
 
 #include <bluevk/BlueVK.h>
@@ -35,6 +36,7 @@
 
 // Platform specific includes and defines
 #if defined(__ANDROID__)
+    #include <android/hardware_buffer.h>
     #include <android/native_window.h>
 #elif defined(__linux__) && defined(FILAMENT_SUPPORTS_WAYLAND)
     #include <dlfcn.h>
@@ -207,6 +209,120 @@ VulkanPlatform::SurfaceBundle VulkanPlatform::createVkSurfaceKHR(void* nativeWin
     return std::make_tuple(surface, extent);
 }
 
+VulkanPlatform::ExternalImage VulkanPlatform::createExternalImage(void* externalImage) noexcept {
+#if defined(__ANDROID__)
+    if (!vkGetAndroidHardwareBufferPropertiesANDROID) {
+        utils::slog.e << "VK_ANDROID_external_memory_android_hardware_buffer is not supported."
+                      << utils::io::endl;
+        return {};
+    }
+    if (__builtin_available(android 26, *)) {
+        VkDevice const device = getDevice();
+        AHardwareBuffer* const buffer = (AHardwareBuffer*) externalImage;
+        AHardwareBuffer_Desc desc;
+        AHardwareBuffer_describe(buffer, &desc);
+
+        VkAndroidHardwareBufferFormatPropertiesANDROID formatProperties = {
+                .sType = VK_STRUCTURE_TYPE_ANDROID_HARDWARE_BUFFER_FORMAT_PROPERTIES_ANDROID,
+        };
+        VkAndroidHardwareBufferPropertiesANDROID properties = {
+                .sType = VK_STRUCTURE_TYPE_ANDROID_HARDWARE_BUFFER_PROPERTIES_ANDROID,
+                .pNext = &formatProperties,
+        };
+        VkResult result = vkGetAndroidHardwareBufferPropertiesANDROID(device, buffer, &properties);
+        if (result != VK_SUCCESS || properties.memoryTypeBits == 0) {
+            utils::slog.e << "vkGetAndroidHardwareBufferPropertiesANDROID error." << utils::io::endl;
+            return {};
+        }
+
+        // An undefined format means the buffer uses an external (typically YUV) format that can
+        // only be sampled through a VkSamplerYcbcrConversion.
+        if (formatProperties.format == VK_FORMAT_UNDEFINED) {
+            utils::slog.e << "AHardwareBuffer with external format "
+                          << formatProperties.externalFormat
+                          << " needs a sampler YCbCr conversion, which is not supported yet."
+                          << utils::io::endl;
+            return {};
+        }
+
+        VkExternalMemoryImageCreateInfo const externalCreateInfo = {
+                .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO,
+                .handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_ANDROID_HARDWARE_BUFFER_BIT_ANDROID,
+        };
+        bool const isProtected = desc.usage & AHARDWAREBUFFER_USAGE_PROTECTED_CONTENT;
+        VkImageCreateInfo const imageInfo = {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                .pNext = &externalCreateInfo,
+                .flags = isProtected ? VkImageCreateFlags(VK_IMAGE_CREATE_PROTECTED_BIT) : 0u,
+                .imageType = VK_IMAGE_TYPE_2D,
+                .format = formatProperties.format,
+                .extent = { desc.width, desc.height, 1 },
+                .mipLevels = 1,
+                .arrayLayers = desc.layers,
+                .samples = VK_SAMPLE_COUNT_1_BIT,
+                .tiling = VK_IMAGE_TILING_OPTIMAL,
+                .usage = VK_IMAGE_USAGE_SAMPLED_BIT,
+                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        };
+        VkImage image;
+        result = vkCreateImage(device, &imageInfo, VKALLOC, &image);
+        if (result != VK_SUCCESS) {
+            utils::slog.e << "vkCreateImage error for an AHardwareBuffer." << utils::io::endl;
+            return {};
+        }
+
+        // AHardwareBuffer imports require a dedicated allocation.
+        VkImportAndroidHardwareBufferInfoANDROID const importInfo = {
+                .sType = VK_STRUCTURE_TYPE_IMPORT_ANDROID_HARDWARE_BUFFER_INFO_ANDROID,
+                .buffer = buffer,
+        };
+        VkMemoryDedicatedAllocateInfo const dedicatedInfo = {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+                .pNext = &importInfo,
+                .image = image,
+        };
+        VkMemoryAllocateInfo const allocInfo = {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                .pNext = &dedicatedInfo,
+                .allocationSize = properties.allocationSize,
+                .memoryTypeIndex = uint32_t(__builtin_ctz(properties.memoryTypeBits)),
+        };
+        VkDeviceMemory memory;
+        result = vkAllocateMemory(device, &allocInfo, VKALLOC, &memory);
+        if (result != VK_SUCCESS) {
+            utils::slog.e << "vkAllocateMemory error for an AHardwareBuffer." << utils::io::endl;
+            vkDestroyImage(device, image, VKALLOC);
+            return {};
+        }
+        result = vkBindImageMemory(device, image, memory, 0);
+        if (result != VK_SUCCESS) {
+            utils::slog.e << "vkBindImageMemory error for an AHardwareBuffer." << utils::io::endl;
+            vkFreeMemory(device, memory, VKALLOC);
+            vkDestroyImage(device, image, VKALLOC);
+            return {};
+        }
+        // The buffer is written by producers outside of Vulkan (camera, media codecs), which
+        // leave it in the general layout and owned by the foreign queue family.
+        return {
+                .image = image,
+                .memory = memory,
+                .format = formatProperties.format,
+                .width = desc.width,
+                .height = desc.height,
+                .queueFamilyIndex = VK_QUEUE_FAMILY_FOREIGN_EXT,
+                .layout = VK_IMAGE_LAYOUT_GENERAL,
+        };
+    }
+    utils::slog.e << "Importing an AHardwareBuffer requires API level 26." << utils::io::endl;
+    return {};
+#else
+    utils::slog.e << "External images are not supported by the Vulkan backend on this platform."
+                  << utils::io::endl;
+    return {};
+#endif
+}
+
 } // namespace filament::backend
 
 #undef LINUX_OR_FREEBSD
@@ -19,6 +19,7 @@
 #include "vulkan/VulkanConstants.h"
 #include "vulkan/VulkanDriverFactory.h"
 
+#include <utils/Log.h>
 #include <utils/Panic.h>
 
 #include <bluevk/BlueVK.h>
@@ -96,4 +97,10 @@ VulkanPlatform::SurfaceBundle VulkanPlatform::createVkSurfaceKHR(void* nativeWin
     return std::make_tuple(surface, VkExtent2D {});
 }
 
+VulkanPlatform::ExternalImage VulkanPlatform::createExternalImage(void* externalImage) noexcept {
+    utils::slog.e << "External images are not supported by the Vulkan backend on Apple platforms."
+                  << utils::io::endl;
+    return {};
+}
+
 } // namespace filament::backend
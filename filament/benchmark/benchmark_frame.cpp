@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <benchmark/benchmark.h>
+
+#include <filament/Box.h>
+#include <filament/Camera.h>
+#include <filament/Engine.h>
+#include <filament/IndexBuffer.h>
+#include <filament/LightManager.h>
+#include <filament/Material.h>
+#include <filament/RenderableManager.h>
+#include <filament/Renderer.h>
+#include <filament/Scene.h>
+#include <filament/SwapChain.h>
+#include <filament/TransformManager.h>
+#include <filament/VertexBuffer.h>
+#include <filament/View.h>
+#include <filament/Viewport.h>
+
+#include <utils/Entity.h>
+#include <utils/EntityManager.h>
+
+#include <math/mat4.h>
+#include <math/vec3.h>
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace filament;
+using namespace filament::math;
+using namespace utils;
+
+// These benchmarks measure the CPU time spent by the frontend to produce a frame, i.e. the cost of
+// Renderer::beginFrame(), Renderer::render() and Renderer::endFrame() on the main thread. They run
+// on the NOOP backend so that the driver contributes as little as possible to the measurement.
+
+class FrameFixture : public benchmark::Fixture {
+protected:
+    static constexpr uint32_t WIDTH = 1280;
+    static constexpr uint32_t HEIGHT = 720;
+
+    Engine* engine = nullptr;
+    SwapChain* swapChain = nullptr;
+    Renderer* renderer = nullptr;
+    Scene* scene = nullptr;
+    View* view = nullptr;
+    Camera* camera = nullptr;
+    VertexBuffer* vertexBuffer = nullptr;
+    IndexBuffer* indexBuffer = nullptr;
+    Entity cameraEntity;
+    std::vector<Entity> entities;
+
+public:
+    void SetUp(const benchmark::State& state) override {
+        const size_t renderableCount = size_t(state.range(0));
+        const size_t lightCount = size_t(state.range(1));
+        const bool shadows = state.range(2) != 0;
+
+        engine = Engine::Builder().backend(Engine::Backend::NOOP).build();
+        swapChain = engine->createSwapChain(WIDTH, HEIGHT);
+        renderer = engine->createRenderer();
+        scene = engine->createScene();
+        view = engine->createView();
+
+        EntityManager& em = EntityManager::get();
+        cameraEntity = em.create();
+        camera = engine->createCamera(cameraEntity);
+        camera->setProjection(45.0, double(WIDTH) / HEIGHT, 0.1, 200.0, Camera::Fov::VERTICAL);
+
+        view->setViewport({ 0, 0, WIDTH, HEIGHT });
+        view->setScene(scene);
+        view->setCamera(camera);
+        view->setShadowingEnabled(shadows);
+
+        static constexpr float3 positions[] = {{ -1, -1, 0 }, { 1, -1, 0 }, { 0, 1, 0 }};
+        static constexpr uint16_t indices[] = { 0, 1, 2 };
+
+        vertexBuffer = VertexBuffer::Builder()
+                .vertexCount(3)
+                .bufferCount(1)
+                .attribute(VertexAttribute::POSITION, 0, VertexBuffer::AttributeType::FLOAT3)
+                .build(*engine);
+        vertexBuffer->setBufferAt(*engine, 0, { positions, sizeof(positions) });
+
+        indexBuffer = IndexBuffer::Builder()
+                .indexCount(3)
+                .bufferType(IndexBuffer::IndexType::USHORT)
+                .build(*engine);
+        indexBuffer->setBuffer(*engine, { indices, sizeof(indices) });
+
+        // Renderables and lights are scattered around the camera, so that some of them are
+        // culled and the others are not.
+        std::default_random_engine gen; // NOLINT
+        std::uniform_real_distribution<float> rand(-100.0f, 100.0f);
+
+        TransformManager& tcm = engine->getTransformManager();
+        MaterialInstance* const mi = engine->getDefaultMaterial()->getDefaultInstance();
+        for (size_t i = 0; i < renderableCount; i++) {
+            Entity const entity = em.create();
+            RenderableManager::Builder(1)
+                    .boundingBox({{ 0, 0, 0 }, { 1, 1, 0.1f }})
+                    .geometry(0, RenderableManager::PrimitiveType::TRIANGLES,
+                            vertexBuffer, indexBuffer)
+                    .material(0, mi)
+                    .castShadows(shadows)
+                    .receiveShadows(shadows)
+                    .build(*engine, entity);
+            tcm.setTransform(tcm.getInstance(entity),
+                    mat4f::translation(float3{ rand(gen), rand(gen), rand(gen) }));
+            scene->addEntity(entity);
+            entities.push_back(entity);
+        }
+
+        Entity const sun = em.create();
+        LightManager::Builder(LightManager::Type::SUN)
+                .direction({ 0, -1, -0.5f })
+                .castShadows(shadows)
+                .build(*engine, sun);
+        scene->addEntity(sun);
+        entities.push_back(sun);
+
+        for (size_t i = 0; i < lightCount; i++) {
+            Entity const entity = em.create();
+            LightManager::Builder(LightManager::Type::POINT)
+                    .position({ rand(gen), rand(gen), rand(gen) })
+                    .falloff(10.0f)
+                    .intensity(10000.0f)
+                    .build(*engine, entity);
+            scene->addEntity(entity);
+            entities.push_back(entity);
+        }
+    }
+
+    void TearDown(const benchmark::State&) override {
+        EntityManager& em = EntityManager::get();
+        for (Entity const entity : entities) {
+            engine->destroy(entity);
+            em.destroy(entity);
+        }
+        entities.clear();
+        engine->destroy(indexBuffer);
+        engine->destroy(vertexBuffer);
+        engine->destroyCameraComponent(cameraEntity);
+        em.destroy(cameraEntity);
+        engine->destroy(view);
+        engine->destroy(scene);
+        engine->destroy(renderer);
+        engine->destroy(swapChain);
+        Engine::destroy(&engine);
+    }
+};
+
+BENCHMARK_DEFINE_F(FrameFixture, renderFrame)(benchmark::State& state) {
+    std::chrono::steady_clock::duration elapsed{};
+    size_t frames = 0;
+    for (auto _ : state) {
+        auto const start = std::chrono::steady_clock::now();
+        if (renderer->beginFrame(swapChain)) {
+            renderer->render(view);
+            renderer->endFrame();
+            frames++;
+        }
+        elapsed += std::chrono::steady_clock::now() - start;
+
+        // Keep the driver thread from falling behind, so that frames are not skipped.
+        state.PauseTiming();
+        engine->flushAndWait();
+        state.ResumeTiming();
+    }
+    const double milliseconds = double(
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()) / 1000.0;
+    state.counters["ms/frame"] = frames ? milliseconds / double(frames) : 0.0;
+    state.counters["skipped"] = double(state.iterations() - frames);
+}
+
+BENCHMARK_REGISTER_F(FrameFixture, renderFrame)
+        ->ArgNames({ "renderables", "lights", "shadows" })
+        ->Args({ 100, 0, 0 })
+        ->Args({ 1000, 0, 0 })
+        ->Args({ 10000, 0, 0 })
+        ->Args({ 1000, 64, 0 })
+        ->Args({ 1000, 256, 0 })
+        ->Args({ 1000, 0, 1 })
+        ->Args({ 1000, 64, 1 });
@@ -0,0 +1,537 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PerformanceCounters.h"
+
+#include <benchmark/benchmark.h>
+
+#include <filament/Camera.h>
+#include <filament/Engine.h>
+#include <filament/Renderer.h>
+#include <filament/Scene.h>
+#include <filament/SwapChain.h>
+#include <filament/View.h>
+#include <filament/Viewport.h>
+
+#include <gltfio/Animator.h>
+#include <gltfio/AssetLoader.h>
+#include <gltfio/FilamentAsset.h>
+#include <gltfio/FilamentInstance.h>
+#include <gltfio/MaterialProvider.h>
+#include <gltfio/ResourceLoader.h>
+
+#include "materials/uberarchive.h"
+
+#include <utils/EntityManager.h>
+#include <utils/NameComponentManager.h>
+
+#include <math/mat4.h>
+#include <math/quat.h>
+#include <math/vec3.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace filament;
+using namespace filament::math;
+using namespace filament::gltfio;
+using namespace utils;
+
+// ------------------------------------------------------------------------------------------------
+// Allocation tracking
+// ------------------------------------------------------------------------------------------------
+
+static std::atomic<size_t> sAllocationCount{ 0 };
+
+void* operator new(size_t size) {
+    sAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    // filament builds without exceptions, so we can't throw std::bad_alloc
+    std::abort();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Synthetic assets
+// ------------------------------------------------------------------------------------------------
+
+// Builds a binary glTF made of a chain of joints that skin a single triangle. Each joint is
+// driven by a rotation and a translation channel, and the triangle has morph targets whose
+// weights are animated as well. Animations 0 and 1 both drive the joints and the weights, so that
+// they can be cross-faded, while animation 2 only drives the weights.
+class GlbBuilder {
+public:
+    static constexpr int UNSIGNED_SHORT = 5123;
+    static constexpr int FLOAT = 5126;
+
+    size_t addAccessor(void const* data, size_t size, int componentType, size_t count,
+            char const* type, std::string const& extra = {}) {
+        const size_t offset = mBin.size();
+        mBin.resize(offset + ((size + 3) & ~size_t(3)));
+        memcpy(mBin.data() + offset, data, size);
+        append(mBufferViews, "{\"buffer\":0,\"byteOffset\":" + std::to_string(offset) +
+                ",\"byteLength\":" + std::to_string(size) + "}");
+        append(mAccessors, "{\"bufferView\":" + std::to_string(mAccessorCount) +
+                ",\"componentType\":" + std::to_string(componentType) +
+                ",\"count\":" + std::to_string(count) + ",\"type\":\"" + type + "\"" + extra + "}");
+        return mAccessorCount++;
+    }
+
+    std::vector<uint8_t> build(std::string const& json) const {
+        std::string header = "{\"asset\":{\"version\":\"2.0\"},\"buffers\":[{\"byteLength\":" +
+                std::to_string(mBin.size()) + "}],\"bufferViews\":[" + mBufferViews +
+                "],\"accessors\":[" + mAccessors + "]," + json + "}";
+        header.resize((header.size() + 3) & ~size_t(3), ' ');
+
+        std::vector<uint8_t> glb;
+        auto write = [&glb](uint32_t value) {
+            glb.insert(glb.end(), (uint8_t const*) &value, (uint8_t const*) &value + 4);
+        };
+        write(0x46546C67); // "glTF"
+        write(2);
+        write(uint32_t(12 + 8 + header.size() + 8 + mBin.size()));
+        write(uint32_t(header.size()));
+        write(0x4E4F534A); // "JSON"
+        glb.insert(glb.end(), header.begin(), header.end());
+        write(uint32_t(mBin.size()));
+        write(0x004E4942); // "BIN"
+        glb.insert(glb.end(), mBin.begin(), mBin.end());
+        return glb;
+    }
+
+    static void append(std::string& list, std::string const& item) {
+        if (!list.empty()) {
+            list += ",";
+        }
+        list += item;
+    }
+
+private:
+    std::vector<uint8_t> mBin;
+    std::string mBufferViews;
+    std::string mAccessors;
+    size_t mAccessorCount = 0;
+};
+
+static std::vector<uint8_t> createSkinnedAsset(size_t jointCount, size_t keyCount,
+        size_t morphTargetCount) {
+    constexpr int UNSIGNED_SHORT = GlbBuilder::UNSIGNED_SHORT;
+    constexpr int FLOAT = GlbBuilder::FLOAT;
+    GlbBuilder builder;
+
+    // Geometry
+    const float3 positions[3] = {{ 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }};
+    const uint16_t joints[12] = {};
+    const float4 weights[3] = {{ 1, 0, 0, 0 }, { 1, 0, 0, 0 }, { 1, 0, 0, 0 }};
+    const uint16_t indices[3] = { 0, 1, 2 };
+    std::string attributes =
+            "\"POSITION\":" + std::to_string(builder.addAccessor(positions, sizeof(positions),
+                    FLOAT, 3, "VEC3", ",\"min\":[0,0,0],\"max\":[1,1,0]")) +
+            ",\"JOINTS_0\":" + std::to_string(builder.addAccessor(joints, sizeof(joints),
+                    UNSIGNED_SHORT, 3, "VEC4")) +
+            ",\"WEIGHTS_0\":" + std::to_string(builder.addAccessor(weights, sizeof(weights),
+                    FLOAT, 3, "VEC4"));
+    const size_t indicesAccessor = builder.addAccessor(indices, sizeof(indices),
+            UNSIGNED_SHORT, 3, "SCALAR");
+
+    std::string targets;
+    std::string defaultWeights;
+    for (size_t m = 0; m < morphTargetCount; ++m) {
+        const float z = 0.1f * float(m + 1);
+        const float3 displacements[3] = {{ 0, 0, z }, { 0, 0, z }, { 0, 0, z }};
+        const std::string bounds = "[0,0," + std::to_string(z) + "]";
+        GlbBuilder::append(targets, "{\"POSITION\":" + std::to_string(builder.addAccessor(
+                displacements, sizeof(displacements), FLOAT, 3, "VEC3",
+                ",\"min\":" + bounds + ",\"max\":" + bounds)) + "}");
+        GlbBuilder::append(defaultWeights, "0");
+    }
+
+    // Skin
+    std::vector<mat4f> inverseBindMatrices(jointCount);
+    const size_t inverseBindMatricesAccessor = builder.addAccessor(inverseBindMatrices.data(),
+            jointCount * sizeof(mat4f), FLOAT, jointCount, "MAT4");
+
+    // Keyframes, shared by all samplers of a given kind.
+    std::vector<float> times(keyCount);
+    std::vector<quatf> rotations(keyCount);
+    std::vector<float3> translations(keyCount);
+    std::vector<float> morphWeights(keyCount * morphTargetCount);
+    for (size_t k = 0; k < keyCount; ++k) {
+        times[k] = float(k) / float(keyCount - 1);
+        rotations[k] = quatf::fromAxisAngle(float3{ 0, 0, 1 }, 0.1f * float(k));
+        translations[k] = { 0, 1, 0.01f * float(k) };
+        for (size_t m = 0; m < morphTargetCount; ++m) {
+            morphWeights[k * morphTargetCount + m] = 0.5f + 0.5f * std::sin(float(k + m));
+        }
+    }
+    const size_t timesAccessor = builder.addAccessor(times.data(), keyCount * sizeof(float),
+            FLOAT, keyCount, "SCALAR", ",\"min\":[0],\"max\":[1]");
+    const size_t rotationsAccessor = builder.addAccessor(rotations.data(),
+            keyCount * sizeof(quatf), FLOAT, keyCount, "VEC4");
+    const size_t translationsAccessor = builder.addAccessor(translations.data(),
+            keyCount * sizeof(float3), FLOAT, keyCount, "VEC3");
+    const size_t weightsAccessor = morphTargetCount == 0 ? 0 : builder.addAccessor(
+            morphWeights.data(), morphWeights.size() * sizeof(float), FLOAT,
+            morphWeights.size(), "SCALAR");
+
+    // Nodes: the joints form a chain, followed by the skinned mesh.
+    std::string nodes;
+    std::string skinJoints;
+    for (size_t j = 0; j < jointCount; ++j) {
+        std::string node = "{\"translation\":[0,1,0]";
+        if (j + 1 < jointCount) {
+            node += ",\"children\":[" + std::to_string(j + 1) + "]";
+        }
+        GlbBuilder::append(nodes, node + "}");
+        GlbBuilder::append(skinJoints, std::to_string(j));
+    }
+    const size_t meshNode = jointCount;
+    GlbBuilder::append(nodes, "{\"mesh\":0,\"skin\":0}");
+
+    // Animations
+    auto addSampler = [](std::string& samplers, size_t& count, size_t input, size_t output) {
+        GlbBuilder::append(samplers, "{\"input\":" + std::to_string(input) +
+                ",\"output\":" + std::to_string(output) + "}");
+        return count++;
+    };
+    auto addChannel = [](std::string& channels, size_t sampler, size_t node, char const* path) {
+        GlbBuilder::append(channels, "{\"sampler\":" + std::to_string(sampler) +
+                ",\"target\":{\"node\":" + std::to_string(node) + ",\"path\":\"" + path + "\"}}");
+    };
+    auto createAnimation = [&](bool animateJoints) {
+        std::string samplers, channels;
+        size_t samplerCount = 0;
+        if (animateJoints) {
+            for (size_t j = 0; j < jointCount; ++j) {
+                addChannel(channels, addSampler(samplers, samplerCount, timesAccessor,
+                        rotationsAccessor), j, "rotation");
+                addChannel(channels, addSampler(samplers, samplerCount, timesAccessor,
+                        translationsAccessor), j, "translation");
+            }
+        }
+        if (morphTargetCount > 0) {
+            addChannel(channels, addSampler(samplers, samplerCount, timesAccessor,
+                    weightsAccessor), meshNode, "weights");
+        }
+        return "{\"samplers\":[" + samplers + "],\"channels\":[" + channels + "]}";
+    };
+    std::string animations = createAnimation(true) + "," + createAnimation(true);
+    if (morphTargetCount > 0) {
+        animations += "," + createAnimation(false);
+    }
+
+    std::string primitive = "{\"attributes\":{" + attributes + "},\"indices\":" +
+            std::to_string(indicesAccessor);
+    std::string mesh = "{\"primitives\":[" + primitive;
+    if (morphTargetCount > 0) {
+        mesh += ",\"targets\":[" + targets + "]}],\"weights\":[" + defaultWeights + "]}";
+    } else {
+        mesh += "}]}";
+    }
+
+    return builder.build(
+            "\"scene\":0,\"scenes\":[{\"nodes\":[0," + std::to_string(meshNode) + "]}]," +
+            "\"nodes\":[" + nodes + "]," +
+            "\"meshes\":[" + mesh + "]," +
+            "\"skins\":[{\"joints\":[" + skinJoints + "],\"inverseBindMatrices\":" +
+                    std::to_string(inverseBindMatricesAccessor) + "}]," +
+            "\"animations\":[" + animations + "]");
+}
+
+// ------------------------------------------------------------------------------------------------
+// Fixture
+// ------------------------------------------------------------------------------------------------
+
+// Benchmark arguments are: the number of instances, the number of joints, the number of keys per
+// channel and the number of morph targets.
+class AnimatorFixture : public benchmark::Fixture {
+protected:
+    Engine* engine = nullptr;
+    NameComponentManager* nameManager = nullptr;
+    MaterialProvider* materialProvider = nullptr;
+    AssetLoader* assetLoader = nullptr;
+    FilamentAsset* asset = nullptr;
+    std::vector<FilamentInstance*> instances;
+    std::vector<Animator*> animators;
+    size_t jointCount = 0;
+    size_t morphTargetCount = 0;
+
+public:
+    void SetUp(const benchmark::State& state) override {
+        const size_t instanceCount = size_t(state.range(0));
+        jointCount = size_t(state.range(1));
+        morphTargetCount = size_t(state.range(3));
+        const std::vector<uint8_t> glb = createSkinnedAsset(jointCount, size_t(state.range(2)),
+                morphTargetCount);
+
+        engine = Engine::Builder().backend(Engine::Backend::NOOP).build();
+        nameManager = new NameComponentManager(EntityManager::get());
+        materialProvider = createUbershaderProvider(engine, UBERARCHIVE_DEFAULT_DATA,
+                UBERARCHIVE_DEFAULT_SIZE);
+        assetLoader = AssetLoader::create({ engine, materialProvider, nameManager });
+
+        instances.resize(instanceCount);
+        asset = assetLoader->createInstancedAsset(glb.data(), uint32_t(glb.size()),
+                instances.data(), instanceCount);
+        ResourceLoader resourceLoader({ engine, nullptr, false });
+        resourceLoader.loadResources(asset);
+
+        animators.resize(instanceCount);
+        for (size_t i = 0; i < instanceCount; ++i) {
+            animators[i] = instances[i]->getAnimator();
+        }
+    }
+
+    void TearDown(const benchmark::State&) override {
+        animators.clear();
+        instances.clear();
+        assetLoader->destroyAsset(asset);
+        materialProvider->destroyMaterials();
+        delete materialProvider;
+        AssetLoader::destroy(&assetLoader);
+        delete nameManager;
+        Engine::destroy(&engine);
+    }
+};
+
+// Accumulates the time and the number of allocations of the code under test, excluding setup
+// work that runs between measurements.
+class Measurement {
+    benchmark::State& state;
+    std::string counterName;
+    size_t itemsPerIteration;
+    std::chrono::steady_clock::duration elapsed{};
+    std::chrono::steady_clock::time_point startTime;
+    size_t allocations = 0;
+    size_t startAllocations = 0;
+
+public:
+    Measurement(benchmark::State& state, char const* itemName, size_t itemsPerIteration)
+            : state(state), counterName(std::string("ns/") + itemName),
+              itemsPerIteration(itemsPerIteration) {
+    }
+
+    void start() {
+        startAllocations = sAllocationCount.load(std::memory_order_relaxed);
+        startTime = std::chrono::steady_clock::now();
+    }
+
+    void stop() {
+        elapsed += std::chrono::steady_clock::now() - startTime;
+        allocations += sAllocationCount.load(std::memory_order_relaxed) - startAllocations;
+    }
+
+    // Must be called before PerformanceCounters goes out of scope, since it depends on the
+    // number of items processed.
+    void report() {
+        const double items = double(state.iterations()) * double(itemsPerIteration);
+        const double nanoseconds = double(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        state.SetItemsProcessed(int64_t(items));
+        state.counters[counterName] = nanoseconds / items;
+        state.counters["allocs"] = double(allocations) / double(state.iterations());
+    }
+};
+
+static float animationTime(size_t frame) {
+    return float(frame % 60) / 60.0f;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Benchmarks
+// ------------------------------------------------------------------------------------------------
+
+BENCHMARK_DEFINE_F(AnimatorFixture, applyAnimation)(benchmark::State& state) {
+    Animator* animator = animators[0];
+    Measurement measurement(state, "joint", jointCount);
+    {
+        PerformanceCounters pc(state);
+        size_t frame = 0;
+        measurement.start();
+        for (auto _ : state) {
+            animator->applyAnimation(0, animationTime(frame++));
+        }
+        measurement.stop();
+        benchmark::ClobberMemory();
+        pc.stop();
+        measurement.report();
+    }
+}
+
+BENCHMARK_DEFINE_F(AnimatorFixture, applyCrossFade)(benchmark::State& state) {
+    Animator* animator = animators[0];
+    Measurement measurement(state, "joint", jointCount);
+    {
+        PerformanceCounters pc(state);
+        size_t frame = 0;
+        measurement.start();
+        for (auto _ : state) {
+            const float time = animationTime(frame++);
+            animator->applyAnimation(1, time);
+            animator->applyCrossFade(0, time, 0.5f);
+        }
+        measurement.stop();
+        benchmark::ClobberMemory();
+        pc.stop();
+        measurement.report();
+    }
+}
+
+// Joints are counted over all instances. Animations are applied between measurements so
+// that every iteration has bones to recompute.
+BENCHMARK_DEFINE_F(AnimatorFixture, updateBoneMatrices)(benchmark::State& state) {
+    std::vector<Animator::AnimationState> states(animators.size());
+    Measurement measurement(state, "joint", jointCount * animators.size());
+    {
+        PerformanceCounters pc(state);
+        size_t frame = 0;
+        for (auto _ : state) {
+            state.PauseTiming();
+            const float time = animationTime(frame++);
+            for (size_t i = 0; i < animators.size(); ++i) {
+                states[i] = { animators[i], 0, time };
+            }
+            Animator::applyAnimations(states.data(), states.size());
+            state.ResumeTiming();
+
+            measurement.start();
+            Animator::updateBoneMatrices(animators.data(), animators.size());
+            measurement.stop();
+        }
+        benchmark::ClobberMemory();
+        pc.stop();
+        measurement.report();
+    }
+}
+
+// Items are morph targets.
+BENCHMARK_DEFINE_F(AnimatorFixture, applyMorphWeights)(benchmark::State& state) {
+    Animator* animator = animators[0];
+    Measurement measurement(state, "target", morphTargetCount);
+    {
+        PerformanceCounters pc(state);
+        size_t frame = 0;
+        measurement.start();
+        for (auto _ : state) {
+            animator->applyAnimation(2, animationTime(frame++));
+        }
+        measurement.stop();
+        benchmark::ClobberMemory();
+        pc.stop();
+        measurement.report();
+    }
+}
+
+// Items are frames. Each frame animates every instance, updates its bones and renders all of
+// them on the NOOP backend, which measures the whole CPU cost of an animated scene.
+BENCHMARK_DEFINE_F(AnimatorFixture, renderFrame)(benchmark::State& state) {
+    SwapChain* swapChain = engine->createSwapChain(1280, 720);
+    Renderer* renderer = engine->createRenderer();
+    Scene* scene = engine->createScene();
+    View* view = engine->createView();
+    Entity const cameraEntity = EntityManager::get().create();
+    Camera* camera = engine->createCamera(cameraEntity);
+    camera->setProjection(45.0, 1280.0 / 720.0, 0.1, 100.0, Camera::Fov::VERTICAL);
+    camera->lookAt({ 0, 0, 10 }, { 0, 0, 0 });
+    view->setViewport({ 0, 0, 1280, 720 });
+    view->setScene(scene);
+    view->setCamera(camera);
+    for (FilamentInstance* instance : instances) {
+        scene->addEntities(instance->getEntities(), instance->getEntityCount());
+    }
+
+    std::vector<Animator::AnimationState> states(animators.size());
+    Measurement measurement(state, "frame", 1);
+    {
+        PerformanceCounters pc(state);
+        size_t frame = 0;
+        for (auto _ : state) {
+            measurement.start();
+            const float time = animationTime(frame++);
+            for (size_t i = 0; i < animators.size(); ++i) {
+                states[i] = { animators[i], 0, time };
+            }
+            Animator::applyAnimations(states.data(), states.size());
+            Animator::updateBoneMatrices(animators.data(), animators.size());
+            if (renderer->beginFrame(swapChain)) {
+                renderer->render(view);
+                renderer->endFrame();
+            }
+            measurement.stop();
+
+            // Keep the driver thread from falling behind, so that frames are not skipped.
+            state.PauseTiming();
+            engine->flushAndWait();
+            state.ResumeTiming();
+        }
+        benchmark::ClobberMemory();
+        pc.stop();
+        measurement.report();
+    }
+
+    engine->destroyCameraComponent(cameraEntity);
+    EntityManager::get().destroy(cameraEntity);
+    engine->destroy(view);
+    engine->destroy(scene);
+    engine->destroy(renderer);
+    engine->destroy(swapChain);
+}
+
+static void jointArguments(benchmark::internal::Benchmark* b) {
+    b->ArgNames({ "instances", "joints", "keys", "targets" });
+    for (int64_t joints : { 16, 64, 256 }) {
+        for (int64_t keys : { 2, 30, 300 }) {
+            b->Args({ 1, joints, keys, 0 });
+        }
+    }
+}
+
+BENCHMARK_REGISTER_F(AnimatorFixture, applyAnimation)->Apply(jointArguments);
+
+BENCHMARK_REGISTER_F(AnimatorFixture, applyCrossFade)->Apply(jointArguments);
+
+BENCHMARK_REGISTER_F(AnimatorFixture, updateBoneMatrices)
+        ->ArgNames({ "instances", "joints", "keys", "targets" })
+        ->Args({ 1, 64, 30, 0 })
+        ->Args({ 100, 64, 30, 0 })
+        ->Args({ 1000, 64, 30, 0 });
+
+BENCHMARK_REGISTER_F(AnimatorFixture, applyMorphWeights)
+        ->ArgNames({ "instances", "joints", "keys", "targets" })
+        ->Args({ 1, 1, 30, 4 })
+        ->Args({ 1, 1, 30, 16 })
+        ->Args({ 1, 1, 30, 64 });
+
+BENCHMARK_REGISTER_F(AnimatorFixture, renderFrame)
+        ->ArgNames({ "instances", "joints", "keys", "targets" })
+        ->Args({ 1, 64, 30, 0 })
+        ->Args({ 10, 64, 30, 0 })
+        ->Args({ 100, 64, 30, 0 });
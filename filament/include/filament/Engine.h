@@ -249,6 +249,17 @@ public:
          */
         uint32_t driverHandleArenaSizeMB = 0;
 
+        /**
+         * Relative number of handles in each pool of the backend's handle arena.
+         *
+         * Backend objects are allocated from one of three pools, depending on their size, from
+         * the smallest to the largest. By default, the arena is split so that each pool can hold
+         * the same number of handles. A weight of 0 is treated as 1.
+         *
+         * Use getHandleAllocatorStats() to find out which pools run out of space.
+         */
+        uint8_t driverHandleArenaPoolWeights[3] = { 1, 1, 1 };
+
 
         /**
          * Minimum size in MiB of a low-level command buffer.
@@ -327,7 +338,9 @@ public:
         uint8_t stereoscopicEyeCount = 2;
 
         /*
-         * @deprecated This value is no longer used.
+         * Size in MiB of the cache of render targets released by previous frames. When the cache
+         * exceeds this size, its oldest entries are destroyed. Render targets used by the last
+         * frame are always kept, even if they alone exceed this size.
          */
         uint32_t resourceAllocatorCacheSizeMB = 64;
 
@@ -369,6 +382,40 @@ public:
          * it's a GLES2 context. Ignored on other backends.
          */
         bool forceGLES2Context = false;
+
+        /*
+         * When the Vulkan backend is used, setting this value to true creates the pipelines that
+         * are missing from the pipeline cache on worker threads, instead of stalling the frame
+         * that first needs them. Until its pipeline is ready, a draw call is skipped, i.e.
+         * objects using new combinations of material, render target and vertex layout may
+         * appear a few frames late. Ignored on other backends.
+         */
+        bool asynchronousPipelineCreation = false;
+
+        /*
+         * When the OpenGL backend is used with a Platform that implements the blob cache, the
+         * backend keeps track of the programs that were used most recently. At startup, the
+         * binaries of up to this many of them are loaded from the blob cache on the shader
+         * compiler threads, before materials ask for them. 0 disables this. Ignored on other
+         * backends, or when shared contexts aren't supported.
+         */
+        uint32_t programCachePrewarmCount = 0;
+
+        /*
+         * When the OpenGL backend compiles shaders on threads with shared contexts, this is the
+         * number of threads to use. 0 picks a number that suits the device, which is a single
+         * thread on most mobile GPUs. Each thread costs a GL context. Ignored on other backends.
+         */
+        uint32_t shaderCompilerThreadCount = 0;
+
+        /*
+         * Maximum number of frames that can be in flight, i.e. submitted but not finished by the
+         * GPU, before Renderer::beginFrame() starts returning false to skip frames. 1 gives the
+         * lowest input-to-photon latency, because a frame starts only once the GPU is done with
+         * the previous one, at the cost of CPU and GPU overlap. 3 lets the main thread, the
+         * driver thread and the GPU each work on a different frame. Clamped to [1, 3].
+         */
+        uint32_t maxFramesInFlight = 2;
     };
 
 
@@ -896,6 +943,118 @@ public:
       */
     void flush();
 
+    /**
+     * Statistics about the command buffer, see getCommandBufferStats().
+     */
+    struct CommandBufferStats {
+        /** Size of the command buffer in bytes, see Config::commandBufferSizeMB. */
+        size_t capacity;
+        /** Size in bytes above which a frame's commands block, see Config::minCommandBufferSizeMB. */
+        size_t minCapacity;
+        /** Largest amount of commands waiting to be executed at any one time, in bytes. */
+        size_t highWatermark;
+        /** Total time the calling thread blocked in flush() waiting for space, in nanoseconds. */
+        uint64_t flushStallDuration;
+        /** Total time the rendering thread waited for commands, in nanoseconds. */
+        uint64_t waitForCommandsDuration;
+    };
+
+    /**
+     * Returns statistics about the command buffer since the Engine was created, which can be used
+     * to pick Config::commandBufferSizeMB and Config::minCommandBufferSizeMB.
+     *
+     * Durations accumulate; the difference between the values of two calls gives the time spent
+     * in between, e.g. during a frame.
+     */
+    CommandBufferStats getCommandBufferStats() const noexcept;
+
+    /**
+     * Returns the occupancy of each pool of the backend's handle arena, along with its high
+     * watermark and how many handles were allocated on the slower system heap because the pool
+     * was full. This can be used to pick Config::driverHandleArenaSizeMB and
+     * Config::driverHandleArenaPoolWeights.
+     *
+     * This is a synchronous call to the backend.
+     */
+    backend::HandleAllocatorStats getHandleAllocatorStats() noexcept;
+
+    /**
+     * Memory used by the Engine, by category, in bytes, see getMemoryStats().
+     *
+     * GPU sizes are estimated from the dimensions and formats of the objects; backends may pad,
+     * align or compress the actual allocations. CPU sizes are the sizes of the Engine's arenas.
+     */
+    struct MemoryStats {
+        /** Storage of all Textures, including their mip levels. */
+        size_t textures;
+        /** Storage of all BufferObjects. */
+        size_t bufferObjects;
+        /** Storage of the VertexBuffers that don't use BufferObjects. */
+        size_t vertexBuffers;
+        /** Storage of all IndexBuffers. */
+        size_t indexBuffers;
+        /** Storage of all SkinningBuffers. */
+        size_t skinningBuffers;
+        /** Storage of all MorphTargetBuffers. */
+        size_t morphTargetBuffers;
+        /** Render targets kept between frames, see Config::resourceAllocatorCacheSizeMB. */
+        size_t resourceAllocatorCache;
+        /** CPU: size of the command buffer, see Config::commandBufferSizeMB. */
+        size_t commandBuffer;
+        /** CPU: size of the per-render-pass arena, see Config::perRenderPassArenaSizeMB. */
+        size_t perRenderPassArena;
+        /**
+         * CPU: largest amount of the per-render-pass arena used by a frame. When a frame needs
+         * more than perRenderPassArena, the rest is allocated on the heap for that frame only.
+         */
+        size_t perRenderPassArenaHighWatermark;
+        /**
+         * CPU: largest amount of commands recorded by a frame, see
+         * Config::perFrameCommandsSizeMB. Commands that don't fit are allocated on the heap.
+         */
+        size_t perFrameCommandsHighWatermark;
+    };
+
+    /**
+     * Returns an estimate of the memory used by the Engine's objects and arenas. Use
+     * getHandleAllocatorStats() for the backend's handle arena.
+     *
+     * This walks all the objects created by the Engine, so it shouldn't be called every frame.
+     */
+    MemoryStats getMemoryStats() const noexcept;
+
+    /**
+     * Starts or stops recording which variants of each Material are prepared for rendering.
+     * Recorded variants are kept until the Engine is destroyed, even when their Material is
+     * destroyed, and can be retrieved with getVariantManifest().
+     *
+     * Only variants that weren't compiled yet are recorded, so recording should be enabled before
+     * rendering the first frame. Variants compiled with Material::compile() are not recorded.
+     *
+     * @param enabled true to record the variants that are prepared from now on.
+     * @see getVariantManifest(), Material::compile()
+     */
+    void setVariantRecordingEnabled(bool enabled) noexcept;
+
+    /**
+     * @return true if the variants prepared for rendering are being recorded.
+     * @see setVariantRecordingEnabled()
+     */
+    bool isVariantRecordingEnabled() const noexcept;
+
+    /**
+     * Serializes the variants recorded so far into a manifest, which can be saved and given to
+     * Material::compile() in a later session, e.g. when loading a level, so that these variants
+     * are ready before they are needed. Materials are identified by the cache id of their
+     * package, so the manifest stays valid across runs, as long as the materials don't change.
+     *
+     * @param data      Where to write the manifest, or nullptr to only query its size.
+     * @param size      Size of the buffer pointed to by data, in bytes.
+     * @return The size of the manifest in bytes. Nothing is written if it is larger than size.
+     * @see setVariantRecordingEnabled(), Material::compile()
+     */
+    size_t getVariantManifest(void* UTILS_NULLABLE data, size_t size) const noexcept;
+
     /**
      * Get paused state of rendering thread.
      *
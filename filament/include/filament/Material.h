@@ -112,6 +112,17 @@ public:
          */
         Builder& package(const void* UTILS_NONNULL payload, size_t size);
 
+        /**
+         * Specifies the material data by the path of a file produced by libfilamat or by matc.
+         * The file is read by build(). Where supported, it is memory-mapped and the material keeps
+         * the mapping rather than a copy of its content, so loading it doesn't allocate.
+         *
+         * This replaces the data given to package(), and vice versa.
+         *
+         * @param path Path of the material file, copied by this call.
+         */
+        Builder& packageFile(const char* UTILS_NONNULL path);
+
         template<typename T>
         using is_supported_constant_parameter_t = typename std::enable_if<
                 std::is_same<int32_t, T>::value ||
@@ -216,6 +227,29 @@ public:
                 std::forward<utils::Invocable<void(Material* UTILS_NONNULL)>>(callback));
     }
 
+    /**
+     * Asynchronously compiles the variants of this Material that are listed in a manifest
+     * recorded by a previous session, see Engine::setVariantRecordingEnabled() and
+     * Engine::getVariantManifest(). Only the variants that were actually used are compiled,
+     * which avoids both compiling every variant and compiling them on first use.
+     *
+     * Variants that this Material doesn't have, or that the Engine doesn't support, are ignored.
+     * The callback behaves as with the other overloads of compile(), and is called even when the
+     * manifest doesn't mention this Material.
+     *
+     * @param priority      Which priority queue to use, LOW or HIGH.
+     * @param manifest      Manifest returned by Engine::getVariantManifest(). It is only read
+     *                      during this call.
+     * @param size          Size of the manifest in bytes.
+     * @param handler       Handler to dispatch the callback or nullptr for the default handler
+     * @param callback      callback called on the main thread when the compilation is done on
+     *                      by backend.
+     */
+    void compile(CompilerPriorityQueue priority,
+            void const* UTILS_NULLABLE manifest, size_t size,
+            backend::CallbackHandler* UTILS_NULLABLE handler = nullptr,
+            utils::Invocable<void(Material* UTILS_NONNULL)>&& callback = {}) noexcept;
+
     /**
      * Creates a new instance of this material. Material instances should be freed using
      * Engine::destroy(const MaterialInstance*).
@@ -158,6 +158,71 @@ public:
         setParameter<T>(name, strlen(name), values, count);
     }
 
+    /**
+     * A uniform parameter resolved by getParameterHandle(), which avoids looking the parameter
+     * up by name every time it is set.
+     *
+     * A handle is valid for all the instances of the Material it was obtained from.
+     */
+    struct ParameterHandle {
+        /** offset in bytes of the parameter in the uniform buffer */
+        uint32_t offset = UINT32_MAX;
+        /** size in bytes of the parameter in the uniform buffer, including all array elements */
+        uint32_t size = 0;
+        /** whether this handle refers to a parameter */
+        bool isValid() const noexcept { return offset != UINT32_MAX; }
+    };
+
+    /**
+     * Resolves a uniform parameter, so that it can be set with setParameter(ParameterHandle, ...)
+     * or setParameters() on any instance of this MaterialInstance's Material.
+     *
+     * @param name          Name of the parameter as defined by Material. Cannot be nullptr.
+     * @param nameLength    Length in `char` of the name parameter.
+     * @return              A handle to the parameter.
+     * @throws utils::PreConditionPanic if name doesn't exist or no-op if exceptions are disabled.
+     */
+    ParameterHandle getParameterHandle(const char* UTILS_NONNULL name, size_t nameLength) const;
+
+    /** inline helper to provide the name as a null-terminated C string */
+    inline ParameterHandle getParameterHandle(const char* UTILS_NONNULL name) const {
+        return getParameterHandle(name, strlen(name));
+    }
+
+    /**
+     * Set a uniform resolved with getParameterHandle()
+     *
+     * @param handle        A valid handle obtained from an instance of the same Material.
+     * @param value         Value of the parameter to set.
+     */
+    template<typename T, typename = is_supported_parameter_t<T>>
+    void setParameter(ParameterHandle handle, T const& value);
+
+    /**
+     * Set a uniform array resolved with getParameterHandle()
+     *
+     * @param handle        A valid handle obtained from an instance of the same Material.
+     * @param values        Array of values to set to the parameter array.
+     * @param count         Size of the array to set.
+     */
+    template<typename T, typename = is_supported_parameter_t<T>>
+    void setParameter(ParameterHandle handle, const T* UTILS_NONNULL values, size_t count);
+
+    /**
+     * Set several uniforms resolved with getParameterHandle() at once.
+     *
+     * `data` holds the values of all the parameters, one after the other in the order of
+     * `handles`. Each value takes ParameterHandle::size bytes and must already be in the layout
+     * of the uniform buffer (std140), i.e. booleans are 32-bit integers, and each row of a mat3
+     * as well as each array element is padded to 16 bytes.
+     *
+     * @param handles       Array of valid handles obtained from instances of the same Material.
+     * @param count         Number of handles.
+     * @param data          Values of the parameters.
+     */
+    void setParameters(ParameterHandle const* UTILS_NONNULL handles, size_t count,
+            void const* UTILS_NONNULL data);
+
 
     /**
      * Set a texture as the named parameter
@@ -443,7 +443,7 @@ struct TemporalAntiAliasingOptions {
     float lodBias = -1.0f;      //!< texturing lod bias (typically -1 or -2)
     float sharpness = 0.0f;     //!< post-TAA sharpen, especially useful when upscaling is true.
     bool enabled = false;       //!< enables or disables temporal anti-aliasing
-    bool upscaling = false;     //!< 4x TAA upscaling. Disables Dynamic Resolution. [BETA]
+    bool upscaling = false;     //!< 4x TAA upscaling, combined with Dynamic Resolution if enabled. [BETA]
 
     enum class BoxType : uint8_t {
         AABB,           //!< use an AABB neighborhood
@@ -486,6 +486,7 @@ struct ScreenSpaceReflectionsOptions {
     float bias = 0.01f;         //!< bias, in world units, to prevent self-intersections
     float maxDistance = 3.0f;   //!< maximum distance, in world units, to raycast
     float stride = 2.0f;        //!< stride, in texels, for samples along the ray.
+    float resolution = 1.0f;    //!< reflections resolution, 0.5 (a quarter of the pixels) or 1.0
     bool enabled = false;
 };
 
@@ -156,6 +156,12 @@ public:
          */
         static constexpr uint8_t DEFAULT_CHANNEL = 2u;
 
+        /**
+         * Maximum number of levels of detail of a Renderable
+         * @see Builder::levelOfDetail()
+         */
+        static constexpr uint8_t MAX_LEVEL_OF_DETAIL_COUNT = 8u;
+
         /**
          * Type of geometry for a Renderable
          */
@@ -596,6 +602,45 @@ public:
         Builder& instances(size_t instanceCount,
                 InstanceBuffer* UTILS_NONNULL instanceBuffer) noexcept;
 
+        /**
+         * Assigns a primitive to a level of detail. By default all primitives belong to level 0,
+         * which is the most detailed.
+         *
+         * Each frame, only the primitives of a single level are drawn, which is selected from the
+         * size of the Renderable on screen with the thresholds given to levelOfDetailScreenSizes().
+         * The primitives of a level must be contiguous, levels must be in increasing order and
+         * none can be empty.
+         *
+         * The per-primitive methods of RenderableManager (e.g. setMaterialInstanceAt()) keep
+         * addressing primitives with the index given here, whatever their level.
+         *
+         * @param primitiveIndex the primitive of interest
+         * @param level level of detail, less than MAX_LEVEL_OF_DETAIL_COUNT
+         *
+         * @return Builder reference for chaining calls.
+         *
+         * @see levelOfDetailScreenSizes
+         */
+        Builder& levelOfDetail(size_t primitiveIndex, uint8_t level) noexcept;
+
+        /**
+         * Sets the screen sizes at which the levels of detail change. The screen size is the
+         * diameter of the Renderable's bounding sphere divided by the height of the viewport, and
+         * level i + 1 is drawn instead of level i below screenSizes[i].
+         *
+         * This is required if more than one level of detail is used, in which case count must be
+         * the number of levels minus one and the sizes must be decreasing.
+         *
+         * @param screenSizes thresholds between consecutive levels of detail, copied
+         * @param count number of thresholds
+         *
+         * @return Builder reference for chaining calls.
+         *
+         * @see levelOfDetail
+         */
+        Builder& levelOfDetailScreenSizes(float const* UTILS_NONNULL screenSizes,
+                size_t count) noexcept;
+
         /**
          * Adds the Renderable component to an entity.
          *
@@ -629,6 +674,7 @@ public:
             PrimitiveType type = PrimitiveType::TRIANGLES;
             uint16_t blendOrder = 0;
             bool globalBlendOrderEnabled = false;
+            uint8_t levelOfDetail = 0;
             struct {
                 MorphTargetBuffer* UTILS_NULLABLE buffer = nullptr;
                 size_t offset = 0;
@@ -833,6 +879,12 @@ public:
      */
     size_t getPrimitiveCount(Instance instance) const noexcept;
 
+    /**
+     * Gets the immutable number of levels of detail in the given renderable.
+     * @see Builder::levelOfDetail()
+     */
+    size_t getLevelOfDetailCount(Instance instance) const noexcept;
+
     /**
      * Changes the material instance binding for the given primitive.
      *
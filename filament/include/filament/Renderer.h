@@ -21,6 +21,8 @@
 
 #include <filament/FilamentAPI.h>
 
+#include <backend/DriverEnums.h>
+
 #include <utils/compiler.h>
 
 #include <math/vec4.h>
@@ -98,6 +100,11 @@ public:
      *            This value can be computed as 1 / N, where N is the number of frames
      *            needed to reach 64% of the target scale factor.
      *            Higher values make the dynamic resolution react faster.
+     * thermalHeadroomThreshold: forecast thermal headroom, see getThermalHeadroom(), above which
+     *            additional GPU headroom is taken, so that the device heats up more slowly and
+     *            throttles later, if at all. 1 or more disables this.
+     * thermalHeadRoomRatio: additional headroom for the GPU when the thermal headroom reaches 1,
+     *            it grows linearly from 0 at thermalHeadroomThreshold.
      *
      * @see View::DynamicResolutionOptions
      * @see Renderer::DisplayInfo
@@ -108,6 +115,8 @@ public:
         float scaleRate = 1.0f / 8.0f;     //!< rate at which the system reacts to load changes
         uint8_t history = 15;              //!< history size
         uint8_t interval = 1;              //!< desired frame interval in unit of 1.0 / DisplayInfo::refreshRate
+        float thermalHeadroomThreshold = 1.0f; //!< thermal headroom above which GPU headroom is added
+        float thermalHeadRoomRatio = 0.25f;    //!< additional GPU headroom at a thermal headroom of 1
     };
 
     /**
@@ -153,6 +162,56 @@ public:
         bool discard = true;
     };
 
+    /**
+     * CPU time spent in each stage of a frame, see getFrameTimings().
+     *
+     * Stages are accumulated over all the Views rendered during the frame, and can overlap:
+     * e.g. command generation and sorting happen while the frame graph executes, and
+     * froxelization runs on a job thread in parallel with culling.
+     */
+    struct FrameTimings {
+        enum class Stage : uint8_t {
+            SCENE_PREPARE,          //!< gathering the renderables and lights of the scenes
+            CULLING,                //!< frustum and occlusion culling of the renderables
+            FROXELIZATION,          //!< assigning the lights to froxels
+            SHADOW_MAP_UPDATE,      //!< culling and setting up the shadow maps
+            COMMAND_GENERATION,     //!< generating the draw commands of the render passes
+            COMMAND_SORTING,        //!< sorting the draw commands of the render passes
+            FRAME_GRAPH_COMPILE,    //!< compiling the frame graphs
+            FRAME_GRAPH_EXECUTE,    //!< executing the frame graphs
+            /**
+             * Executing commands on the driver thread since the end of the previous frame,
+             * which mostly measures the commands of the previous frame.
+             */
+            DRIVER_EXECUTE,
+        };
+        static constexpr size_t STAGE_COUNT = size_t(Stage::DRIVER_EXECUTE) + 1;
+
+        /** Id of the frame, as given to the backend by beginFrame(). */
+        uint32_t frameId;
+
+        /** Time spent in each stage, in nanoseconds, indexed by Stage. */
+        uint64_t durations[STAGE_COUNT];
+
+        uint64_t getDuration(Stage stage) const noexcept { return durations[size_t(stage)]; }
+    };
+
+    /** Number of frames kept by the history returned by getFrameTimings(). */
+    static constexpr size_t FRAME_TIMINGS_HISTORY_SIZE = 16;
+
+    /**
+     * GPU time spent in a pass of the frame graph, see getGpuPassTimings().
+     */
+    struct GpuPassTiming {
+        /** Name of the pass, e.g. "Color Pass" or "ssao". Valid for the lifetime of the Engine. */
+        const char* name;
+        /** GPU time spent in the pass, in nanoseconds. */
+        uint64_t duration;
+    };
+
+    /** Maximum number of passes timed in a frame, see setGpuPassTimingsEnabled(). */
+    static constexpr size_t GPU_PASS_TIMINGS_MAX_COUNT = 48;
+
     /**
      * Information about the display this Renderer is associated to. This information is needed
      * to accurately compute dynamic-resolution scaling and for frame-pacing.
@@ -519,6 +578,26 @@ public:
      */
     void renderStandaloneView(View const* UTILS_NONNULL view);
 
+    /**
+     * Render several standalone Views into their associated RenderTarget.
+     *
+     * This is equivalent to calling renderStandaloneView() for each View, but the Engine is
+     * prepared only once and all the Views are rendered as part of a single backend frame,
+     * which improves throughput when many independent images are produced offscreen (e.g. with
+     * a headless platform). Views without a Scene are skipped.
+     *
+     * @param views A pointer to an array of `count` views to render. Each View must have a
+     *              RenderTarget associated to it.
+     * @param count Number of views in the array.
+     *
+     * @attention
+     * renderStandaloneViews() must be called outside of beginFrame() / endFrame().
+     *
+     * @see renderStandaloneView()
+     */
+    void renderStandaloneViews(View const* UTILS_NONNULL const* UTILS_NONNULL views,
+            size_t count);
+
 
     /**
      * Returns the time in second of the last call to beginFrame(). This value is constant for all
@@ -577,6 +656,74 @@ public:
      */
     void resetUserTime();
 
+    /**
+     * Returns the number of state changes the backend issued during the last completed frame,
+     * and how many of them were skipped because the state was already set, per category.
+     *
+     * Only the OpenGL backend tracks these, other backends return zeros. The counts are
+     * updated when the backend processes endFrame(), so they can lag behind by a few frames.
+     *
+     * @return The state change counts of the last completed frame.
+     */
+    backend::StateChangeStats getStateChangeStats() const noexcept;
+
+    /**
+     * Returns the thermal headroom the platform forecasts for the next few seconds, where 0 means
+     * no throttling and 1 means severe throttling, which reduces performance a lot.
+     *
+     * It's sampled about once a second during beginFrame(), and is the signal used by
+     * FrameRateOptions::thermalHeadroomThreshold. Applications can use it as well to reduce
+     * other costs before the device throttles, e.g. the level of detail of animations or the
+     * update rate of shadows.
+     *
+     * @return The forecast thermal headroom, or NaN if the platform doesn't provide it (only
+     *         Android 12 and later do).
+     */
+    float getThermalHeadroom() const noexcept;
+
+    /**
+     * Copies the CPU timings of the most recent frames, most recent first.
+     *
+     * The timings are always recorded, with negligible overhead, for the last
+     * FRAME_TIMINGS_HISTORY_SIZE frames that went through beginFrame() and endFrame(). They are
+     * recorded per Engine, so with several Renderers each frame holds the work done since the
+     * previous endFrame() of any of them.
+     *
+     * @param out   Array of at least count FrameTimings, where the timings are copied.
+     * @param count Maximum number of frames to copy.
+     * @return The number of frames copied, which is at most FRAME_TIMINGS_HISTORY_SIZE.
+     */
+    size_t getFrameTimings(FrameTimings* out, size_t count) const noexcept;
+
+    /**
+     * Enables or disables timing each pass of the frame graph on the GPU.
+     *
+     * When enabled, a timer query is issued around each pass of the frames rendered between
+     * beginFrame() and endFrame(), up to GPU_PASS_TIMINGS_MAX_COUNT passes per frame over all the
+     * Views. Timer queries have a cost on some GPUs, so this is disabled by default.
+     *
+     * @param enabled true to time the passes of the next frames.
+     */
+    void setGpuPassTimingsEnabled(bool enabled) noexcept;
+
+    /**
+     * @return whether the passes of the frame graph are timed on the GPU.
+     */
+    bool isGpuPassTimingsEnabled() const noexcept;
+
+    /**
+     * Copies the GPU timings of the passes of the most recent frame whose results are available,
+     * in the order the passes were executed. Results are collected asynchronously, so they are a
+     * few frames older than the frame being rendered.
+     *
+     * @param out       Array of at least count GpuPassTiming, where the timings are copied.
+     * @param count     Maximum number of passes to copy.
+     * @param frameId   If not null, receives the id of the frame the timings belong to.
+     * @return The number of passes copied, 0 if no results are available yet.
+     */
+    size_t getGpuPassTimings(GpuPassTiming* out, size_t count,
+            uint32_t* frameId = nullptr) const noexcept;
+
 protected:
     // prevent heap allocation
     ~Renderer() = default;
@@ -177,6 +177,54 @@ public:
      */
     void forEach(utils::Invocable<void(utils::Entity entity)>&& functor) const noexcept;
 
+    /**
+     * Enables or disables the culling hierarchy of the Scene.
+     *
+     * When enabled, the Scene keeps a bounding volume hierarchy of its renderables, which is
+     * used to cull them against the camera and the directional shadow map. Whole groups of
+     * renderables outside or inside the frustum are then handled at once, so the cost of culling
+     * grows much slower than the number of renderables.
+     *
+     * The hierarchy is rebuilt when renderables are added or removed, and is refit when some
+     * renderables move. It is best suited to large scenes where most renderables are static.
+     *
+     * The culling hierarchy is disabled by default.
+     *
+     * @param enabled true to enable the culling hierarchy, false otherwise.
+     */
+    void setCullingHierarchyEnabled(bool enabled) noexcept;
+
+    /**
+     * @return Whether the culling hierarchy is enabled.
+     * @see setCullingHierarchyEnabled
+     */
+    bool isCullingHierarchyEnabled() const noexcept;
+
+    /**
+     * Enables or disables sharing the preparation of renderables across Views.
+     *
+     * When enabled, the world transforms, bounding boxes and other states of the renderables are
+     * gathered only once per frame (see Renderer::beginFrame()) for all the Views rendering this
+     * Scene, as long as they have the same world origin (see Camera::setModelMatrix()) and the
+     * same shadow type. Only culling, sorting and the upload of per-renderable uniforms then
+     * remain per View, which reduces the cost of rendering a Scene from several Views.
+     *
+     * While enabled, changes made to the renderables or their transforms between calls to
+     * Renderer::render() within the same frame may not be seen by the later Views. Adding,
+     * removing or destroying entities is always seen.
+     *
+     * Sharing is disabled by default.
+     *
+     * @param enabled true to share the preparation across Views, false otherwise.
+     */
+    void setSharedPreparationEnabled(bool enabled) noexcept;
+
+    /**
+     * @return Whether the preparation of renderables is shared across Views.
+     * @see setSharedPreparationEnabled
+     */
+    bool isSharedPreparationEnabled() const noexcept;
+
 protected:
     // prevent heap allocation
     ~Scene() = default;
@@ -466,6 +466,25 @@ public:
      */
     void generateMipmaps(Engine& engine) const noexcept;
 
+    /**
+     * Restricts sampling to the mipmap levels [minLevel, maxLevel].
+     *
+     * This is intended for texture streaming: a texture can be created with all its levels,
+     * have its smallest levels uploaded first, and have its sampling clamped to the levels that
+     * are resident, lowering minLevel as more detailed levels get uploaded with setImage().
+     *
+     * By default all levels can be sampled.
+     *
+     * @param engine        Engine this texture is associated to.
+     * @param minLevel      Most detailed level that can be sampled.
+     * @param maxLevel      Least detailed level that can be sampled.
+     *
+     * @attention \p engine must be the instance passed to Builder::build()
+     * @attention \p minLevel must be less than or equal to \p maxLevel, which must be less than
+     *            getLevels().
+     */
+    void setMinMaxLevels(Engine& engine, uint8_t minLevel, uint8_t maxLevel);
+
     /**
      * Creates a reflection map from an environment map.
      *
@@ -490,6 +509,8 @@ public:
      *
      * @warning This operation is computationally intensive, especially with large environments and
      *          is currently synchronous. Expect about 1ms for a 16x16 cubemap.
+     *          IBLPrefilterContext::SpecularFilter (libs/iblprefilter) offers the same
+     *          processing on the GPU, from the same client-side buffer.
      *
      * @param engine        Reference to the filament::Engine to associate this IndirectLight with.
      * @param buffer        Client-side buffer containing the images to set.
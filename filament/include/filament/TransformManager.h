@@ -269,6 +269,39 @@ public:
      */
     void setTransform(Instance ci, const math::mat4& localTransform) noexcept;
 
+    /**
+     * Sets the local transforms of many transform components at once.
+     *
+     * This is equivalent to calling setTransform() for each component, except that world
+     * transforms are propagated through the hierarchy once, after all local transforms are set.
+     * When a local transform transaction is open, propagation is deferred until
+     * commitLocalTransformTransaction() as usual.
+     *
+     * @param instances       Instances of the transform components to set the local transform to.
+     *                        All instances must be valid and distinct.
+     * @param localTransforms The local transforms (i.e. relative to the parent), one per instance.
+     * @param count           Number of instances.
+     * @see setTransform()
+     */
+    void setTransforms(Instance const* instances, const math::mat4f* localTransforms,
+            size_t count) noexcept;
+
+    /**
+     * Sets the local transforms of many transform components at once, given as separate arrays
+     * of translations, rotations and scales. The local transform of component i is
+     * translation(translations[i]) * rotation(rotations[i]) * scaling(scales[i]).
+     *
+     * @param instances     Instances of the transform components to set the local transform to.
+     *                      All instances must be valid and distinct.
+     * @param translations  Local translations, one per instance.
+     * @param rotations     Local rotations as unit quaternions, one per instance.
+     * @param scales        Local scales, one per instance.
+     * @param count         Number of instances.
+     * @see setTransforms(Instance const*, const math::mat4f*, size_t)
+     */
+    void setTransforms(Instance const* instances, const math::float3* translations,
+            const math::quatf* rotations, const math::float3* scales, size_t count) noexcept;
+
     /**
      * Returns the local transform of a transform component.
      * @param ci The instance of the transform component to query the local transform from.
@@ -323,6 +356,10 @@ public:
      * Commits the currently open local transform transaction. When this returns, calls
      * to getWorldTransform() will return the proper value.
      *
+     * Only the world transforms of the components whose local transform was set during the
+     * transaction, and of their descendants, are recomputed. Independent hierarchies are
+     * processed in parallel.
+     *
      * @attention failing to call this method when done updating the local transform will cause
      *            a lot of rendering problems. The system never closes the transaction
      *            automatically.
@@ -333,6 +370,44 @@ public:
      */
     void commitLocalTransformTransaction() noexcept;
 
+    /**
+     * Enables or disables the transform snapshot.
+     *
+     * When the snapshot is enabled, Scene preparation (see Renderer::render()) reads the world
+     * transforms that were last published with publishSnapshot(), instead of the current ones.
+     * This allows the local transforms of the next frame to be set and committed on another
+     * thread while the current frame is being prepared.
+     *
+     * While a frame is being prepared concurrently, the other thread may only call
+     * setTransform(), setTransforms(), openLocalTransformTransaction() and
+     * commitLocalTransformTransaction(). Components must not be created or destroyed, and
+     * parents must not change. Such changes invalidate the snapshot, so that current transforms
+     * are used until the next publishSnapshot(). Cameras always use their current transform.
+     *
+     * The snapshot is disabled by default.
+     *
+     * @param enable Whether Scene preparation uses the published snapshot.
+     * @see publishSnapshot()
+     */
+    void setSnapshotEnabled(bool enable) noexcept;
+
+    /**
+     * Returns whether the transform snapshot is enabled.
+     * @see setSnapshotEnabled()
+     */
+    bool isSnapshotEnabled() const noexcept;
+
+    /**
+     * Publishes the current local and world transforms of all components to the snapshot.
+     * This must not be called while a frame is being prepared; typically it is called once the
+     * simulation of a frame is complete, before rendering it.
+     *
+     * @note If the snapshot is not enabled, this is a no-op.
+     *
+     * @see setSnapshotEnabled()
+     */
+    void publishSnapshot() noexcept;
+
 protected:
     // prevent heap allocation
     ~TransformManager() = default;
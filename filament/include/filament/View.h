@@ -714,6 +714,142 @@ public:
      */
     StereoscopicOptions const& getStereoscopicOptions() const noexcept;
 
+    /**
+     * Enables or disables occlusion culling.
+     *
+     * When enabled, the depth of recent frames is read back and used to skip the renderables
+     * that are hidden behind other renderables. This mostly benefits dense scenes, e.g. cities,
+     * where many renderables inside the frustum are hidden. The depth is rendered by the
+     * structure pass, which runs every frame while occlusion culling is enabled.
+     *
+     * Occlusion culling has one or two frames of latency: a renderable that becomes visible
+     * because an occluder moves away can appear a frame late. Renderables still cast shadows
+     * when they are occluded. Occlusion culling is not supported with stereoscopic rendering,
+     * nor at FEATURE_LEVEL_0. It is disabled by default.
+     *
+     * @param enabled true to enable occlusion culling, false otherwise.
+     */
+    void setOcclusionCullingEnabled(bool enabled) noexcept;
+
+    /**
+     * @return Whether occlusion culling is enabled.
+     * @see setOcclusionCullingEnabled
+     */
+    bool isOcclusionCullingEnabled() const noexcept;
+
+    /**
+     * Enables or disables the depth bounds of point and spot lights.
+     *
+     * When enabled, the depth of recent frames is read back, as with occlusion culling, and
+     * point and spot lights are only assigned to the froxels (the cells of the view frustum
+     * used for light culling) that contain geometry. This shortens the lists of lights
+     * evaluated when shading, and the light records uploaded each frame, when lights extend
+     * through empty space.
+     *
+     * Like occlusion culling, this has one or two frames of latency: geometry that moves
+     * quickly into an empty region can be unlit by point and spot lights for a frame. It is
+     * not supported with stereoscopic rendering, nor at FEATURE_LEVEL_0. It is disabled by
+     * default.
+     *
+     * @param enabled true to restrict lights to the froxels with geometry, false otherwise.
+     */
+    void setLightDepthBoundsEnabled(bool enabled) noexcept;
+
+    /**
+     * @return Whether the depth bounds of lights are enabled.
+     * @see setLightDepthBoundsEnabled
+     */
+    bool isLightDepthBoundsEnabled() const noexcept;
+
+    /**
+     * Enables or disables the caching of spot and point light shadow maps.
+     *
+     * When enabled, the shadow map of a spotlight, or of a point light's face, is rendered
+     * again only when the light or one of the shadow casters it sees has changed, i.e. moved,
+     * appeared or disappeared. This mostly benefits scenes with many static lights, point lights
+     * in particular render six shadow maps.
+     *
+     * Changes that don't affect the bounding box of a caster, e.g. a new material, are not
+     * detected. Shadow maps with skinned or morphed casters are always rendered.
+     *
+     * When the directional light uses stable shadows (see LightManager::ShadowOptions::stable),
+     * the first cascade is rendered every frame, and the other cascades in turn, one per frame.
+     * This means that shadows of moving casters can lag behind in the far cascades.
+     *
+     * Caching is not used with VSM shadows. It is disabled by default.
+     *
+     * @param enabled true to enable shadow caching, false otherwise.
+     */
+    void setShadowCachingEnabled(bool enabled) noexcept;
+
+    /**
+     * @return Whether shadow caching is enabled.
+     * @see setShadowCachingEnabled
+     */
+    bool isShadowCachingEnabled() const noexcept;
+
+    /**
+     * Enables or disables the adaptive resolution of spot and point light shadow maps.
+     *
+     * When enabled, the resolution of these shadow maps is chosen each frame from the size of
+     * the light's sphere of influence on screen, from LightManager::ShadowOptions::mapSize down
+     * to an eighth of it. Distant lights then use less memory and fill rate.
+     * It is disabled by default.
+     *
+     * @param enabled true to enable adaptive shadow resolution, false otherwise.
+     */
+    void setAdaptiveShadowResolutionEnabled(bool enabled) noexcept;
+
+    /**
+     * @return Whether adaptive shadow resolution is enabled.
+     * @see setAdaptiveShadowResolutionEnabled
+     */
+    bool isAdaptiveShadowResolutionEnabled() const noexcept;
+
+    /**
+     * Enables or disables the temporal sampling of screen-space ambient occlusion.
+     *
+     * When enabled together with temporal anti-aliasing, SSAO takes half as many samples per
+     * pixel, and the spiral they are placed on changes every frame. TAA's history then
+     * accumulates the samples of consecutive frames, which brings the quality close to the
+     * full sample count for about half the cost. Without TAA this has no effect.
+     * It is disabled by default.
+     *
+     * @param enabled true to enable temporal ambient occlusion sampling, false otherwise.
+     * @see setAmbientOcclusionOptions, setTemporalAntiAliasingOptions
+     */
+    void setTemporalAmbientOcclusionEnabled(bool enabled) noexcept;
+
+    /**
+     * @return Whether temporal ambient occlusion sampling is enabled.
+     * @see setTemporalAmbientOcclusionEnabled
+     */
+    bool isTemporalAmbientOcclusionEnabled() const noexcept;
+
+    /**
+     * Sets a GPU time budget for the screen-space effects of this View: screen-space reflections,
+     * depth-of-field, ambient occlusion and bloom.
+     *
+     * When the GPU time measured for the passes of these effects exceeds the budget, their quality
+     * is reduced one step at a time, in this order: screen-space reflections are disabled,
+     * depth-of-field uses fewer rings, ambient occlusion is computed at half resolution, and
+     * bloom uses fewer levels. The steps are undone, in the reverse order, once the cost is
+     * expected to remain within the budget. The options set on the View are not modified.
+     *
+     * This requires Renderer::setGpuPassTimingsEnabled(true), and has no effect otherwise.
+     * Dynamic resolution still reacts to the frame time independently.
+     *
+     * @param milliseconds GPU time budget in milliseconds, 0 to disable the budget (default).
+     * @see Renderer::setGpuPassTimingsEnabled
+     */
+    void setPostProcessingBudget(float milliseconds) noexcept;
+
+    /**
+     * @return The GPU time budget of the screen-space effects, in milliseconds, 0 if disabled.
+     * @see setPostProcessingBudget
+     */
+    float getPostProcessingBudget() const noexcept;
+
     // for debugging...
 
     //! debugging: allows to entirely disable frustum culling. (culling enabled by default).
@@ -846,6 +982,32 @@ public:
             backend::CallbackHandler* UTILS_NULLABLE handler,
             PickingQueryResultCallback UTILS_NONNULL callback) noexcept;
 
+    /** callback type used for batched picking queries. */
+    using PickingQueriesResultCallback = void(*)(PickingQueryResult const* UTILS_NONNULL results,
+            size_t count, void* UTILS_NULLABLE user);
+
+    /**
+     * Creates a batch of picking queries, e.g. for hover highlighting or rectangle selection.
+     *
+     * All the points of a batch are resolved with a single read back of the rectangle that
+     * bounds them, and a single callback, instead of a read back and a callback per point.
+     * The cost of the read back grows with the area of that rectangle, which is at the
+     * resolution of the structure pass (see AmbientOcclusionOptions::resolution).
+     *
+     * @param points    Coordinates to query in the viewport, origin at the bottom left.
+     *                  The array is copied.
+     * @param count     Number of points to query, at least one.
+     * @param handler   Handler to dispatch the callback or nullptr for the default handler.
+     * @param callback  User callback, called once when the results of all the points are
+     *                  available. The results are in the order of the points, and are only
+     *                  valid during the callback.
+     * @param user      User data given to the callback.
+     */
+    void pick(math::uint2 const* UTILS_NONNULL points, size_t count,
+            backend::CallbackHandler* UTILS_NULLABLE handler,
+            PickingQueriesResultCallback UTILS_NONNULL callback,
+            void* UTILS_NULLABLE user = nullptr) noexcept;
+
     /**
      * Set the value of material global variables. There are up-to four such variable each of
      * type float4. These variables can be read in a user Material with
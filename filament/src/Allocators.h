@@ -38,6 +38,11 @@ using LinearAllocatorArena = utils::Arena<
         utils::LockingPolicy::NoLock,
         utils::TrackingPolicy::DebugAndHighWatermark>;
 
+using PerRenderPassArena = utils::Arena<
+        utils::LinearAllocatorWithFallback,
+        utils::LockingPolicy::NoLock,
+        utils::TrackingPolicy::DebugAndHighWatermark>;
+
 #else
 
 // on Release builds, HeapAllocatorArena doesn't need a LockingPolicy because HeapAllocator is
@@ -52,9 +57,17 @@ using LinearAllocatorArena = utils::Arena<
         utils::LinearAllocator,
         utils::LockingPolicy::NoLock>;
 
+// the high watermark is tracked on release builds too, see Engine::getMemoryStats()
+using PerRenderPassArena = utils::Arena<
+        utils::LinearAllocatorWithFallback,
+        utils::LockingPolicy::NoLock,
+        utils::TrackingPolicy::HighWatermark>;
+
 #endif
 
-using RootArenaScope = utils::ArenaScope<LinearAllocatorArena>;
+// The per-render-pass arena falls back to the heap when a frame needs more than
+// Config::perRenderPassArenaSizeMB; that memory is freed when the frame's root scope ends.
+using RootArenaScope = utils::ArenaScope<PerRenderPassArena>;
 
 } // namespace filament
 
@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CullingHierarchy.h"
+
+#include <filament/Frustum.h>
+
+#include <utils/Systrace.h>
+#include <utils/debug.h>
+
+#include <math/vec4.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <stddef.h>
+#include <stdint.h>
+
+using namespace filament::math;
+
+namespace filament {
+
+void CullingHierarchy::update(Instance const* instances,
+        float3 const* center, float3 const* extent, size_t count) {
+    SYSTRACE_CALL();
+
+    if (count != mInstances.size() ||
+            !std::equal(instances, instances + count, mInstances.begin())) {
+        mInstances.assign(instances, instances + count);
+        mCenters.assign(center, center + count);
+        mExtents.assign(extent, extent + count);
+        build();
+        refit();
+        return;
+    }
+
+    size_t moved = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (UTILS_UNLIKELY(mCenters[i] != center[i] || mExtents[i] != extent[i])) {
+            mCenters[i] = center[i];
+            mExtents[i] = extent[i];
+            moved++;
+        }
+    }
+
+    if (moved) {
+        // Refitting keeps the hierarchy correct, but its nodes grow as renderables move apart,
+        // so we start over once about every renderable has moved.
+        mMovedCount += moved;
+        if (mMovedCount > count) {
+            build();
+        }
+        refit();
+    }
+}
+
+void CullingHierarchy::build() {
+    uint32_t const count = uint32_t(mInstances.size());
+    mMovedCount = 0;
+    mIndices.resize(count);
+    std::iota(mIndices.begin(), mIndices.end(), 0u);
+    mNodes.clear();
+    mNodes.reserve(2 * (count / LEAF_SIZE) + 1);
+    if (count) {
+        build(0, count);
+    }
+}
+
+uint32_t CullingHierarchy::build(uint32_t begin, uint32_t end) {
+    uint32_t const index = uint32_t(mNodes.size());
+    mNodes.push_back({ {}, begin, {}, end, 0 });
+    if (end - begin <= LEAF_SIZE) {
+        return index;
+    }
+
+    // split at the median of the box centers, along the axis where they are the most spread
+    float3 lo = mCenters[mIndices[begin]];
+    float3 hi = lo;
+    for (uint32_t i = begin + 1; i < end; i++) {
+        lo = min(lo, mCenters[mIndices[i]]);
+        hi = max(hi, mCenters[mIndices[i]]);
+    }
+    float3 const spread = hi - lo;
+    size_t const axis = spread.x >= spread.y ?
+            (spread.x >= spread.z ? 0 : 2) : (spread.y >= spread.z ? 1 : 2);
+
+    uint32_t const mid = begin + (end - begin) / 2;
+    std::nth_element(mIndices.begin() + begin, mIndices.begin() + mid, mIndices.begin() + end,
+            [this, axis](uint32_t a, uint32_t b) {
+                return mCenters[a][axis] < mCenters[b][axis];
+            });
+
+    build(begin, mid);
+    uint32_t const right = build(mid, end);
+    mNodes[index].right = right;
+    return index;
+}
+
+void CullingHierarchy::refit() noexcept {
+    // children are always stored after their parent
+    for (size_t i = mNodes.size(); i-- > 0;) {
+        Node& node = mNodes[i];
+        if (node.right) {
+            Node const& l = mNodes[i + 1];
+            Node const& r = mNodes[node.right];
+            node.min = min(l.min, r.min);
+            node.max = max(l.max, r.max);
+        } else {
+            uint32_t const first = mIndices[node.begin];
+            node.min = mCenters[first] - mExtents[first];
+            node.max = mCenters[first] + mExtents[first];
+            for (uint32_t j = node.begin + 1; j < node.end; j++) {
+                uint32_t const k = mIndices[j];
+                node.min = min(node.min, mCenters[k] - mExtents[k]);
+                node.max = max(node.max, mCenters[k] + mExtents[k]);
+            }
+        }
+    }
+}
+
+void CullingHierarchy::intersects(Culler::result_type* UTILS_RESTRICT results,
+        Frustum const& frustum, size_t bit) const noexcept {
+    SYSTRACE_CALL();
+
+    Culler::result_type const mask = Culler::result_type(1u << bit);
+    for (size_t i = 0, c = mInstances.size(); i < c; i++) {
+        results[i] &= ~mask;
+    }
+    if (mNodes.empty()) {
+        return;
+    }
+
+    float4 const* const planes = frustum.getNormalizedPlanes();
+
+    // Each entry holds a node and the planes it straddles; planes that contain a node entirely
+    // also contain its children, so they are not tested again.
+    struct Entry {
+        uint32_t node;
+        uint32_t planes;
+    };
+    // the tree is balanced, so its depth is at most about log2(count)
+    Entry stack[64];
+    size_t top = 0;
+    stack[top++] = { 0, 0x3F };
+
+    while (top) {
+        Entry const entry = stack[--top];
+        Node const& node = mNodes[entry.node];
+
+        uint32_t active = entry.planes;
+        bool outside = false;
+        for (size_t j = 0; j < 6 && !outside; j++) {
+            if (!(active & (1u << j))) {
+                continue;
+            }
+            float4 const p = planes[j];
+            // signed distances of the box corners closest to and farthest from the plane
+            float3 const closest{
+                    p.x > 0 ? node.min.x : node.max.x,
+                    p.y > 0 ? node.min.y : node.max.y,
+                    p.z > 0 ? node.min.z : node.max.z };
+            float3 const farthest{
+                    p.x > 0 ? node.max.x : node.min.x,
+                    p.y > 0 ? node.max.y : node.min.y,
+                    p.z > 0 ? node.max.z : node.min.z };
+            outside = !(dot(p.xyz, closest) + p.w < 0);
+            if (dot(p.xyz, farthest) + p.w < 0) {
+                active &= ~(1u << j);
+            }
+        }
+
+        if (outside) {
+            continue;
+        }
+
+        if (!active) {
+            for (uint32_t i = node.begin; i < node.end; i++) {
+                results[mIndices[i]] |= mask;
+            }
+            continue;
+        }
+
+        if (node.right) {
+            assert_invariant(top + 2 <= sizeof(stack) / sizeof(stack[0]));
+            stack[top++] = { node.right, active };
+            stack[top++] = { entry.node + 1, active };
+            continue;
+        }
+
+        // same test as Culler::intersects(), restricted to the planes the leaf straddles
+        for (uint32_t i = node.begin; i < node.end; i++) {
+            uint32_t const k = mIndices[i];
+            float3 const c = mCenters[k];
+            float3 const e = mExtents[k];
+            bool visible = true;
+            for (size_t j = 0; j < 6; j++) {
+                if (active & (1u << j)) {
+                    float4 const p = planes[j];
+                    float const d =
+                            p.x * c.x - std::abs(p.x) * e.x +
+                            p.y * c.y - std::abs(p.y) * e.y +
+                            p.z * c.z - std::abs(p.z) * e.z +
+                            p.w;
+                    visible = visible && d < 0;
+                }
+            }
+            if (visible) {
+                results[k] |= mask;
+            }
+        }
+    }
+}
+
+} // namespace filament
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_CULLINGHIERARCHY_H
+#define TNT_FILAMENT_CULLINGHIERARCHY_H
+
+#include "Culler.h"
+
+#include <filament/RenderableManager.h>
+
+#include <utils/EntityInstance.h>
+
+#include <math/vec3.h>
+
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+class Frustum;
+
+/*
+ * A bounding volume hierarchy over the world-space AABBs of a scene's renderables, which lets
+ * frustum culling reject (or accept) whole groups of renderables at once.
+ *
+ * The hierarchy is rebuilt only when the set of renderables changes, and is refit when some
+ * of their bounding boxes change. Because refitting doesn't improve the tree, it is also
+ * rebuilt after roughly as many boxes have moved as there are renderables. This makes it a
+ * good fit for scenes where most renderables don't move.
+ */
+class CullingHierarchy {
+public:
+    using Instance = utils::EntityInstance<RenderableManager>;
+
+    // Updates the hierarchy for the given renderables, which are indexed like the arrays
+    // passed to Culler::intersects().
+    void update(Instance const* instances,
+            math::float3 const* center, math::float3 const* extent, size_t count);
+
+    // Sets the given bit of results[i] if renderable i intersects the frustum and clears it
+    // otherwise. Exactly count results are written, where count is the value given to the
+    // last update().
+    void intersects(Culler::result_type* results, Frustum const& frustum,
+            size_t bit) const noexcept;
+
+    size_t size() const noexcept { return mInstances.size(); }
+
+private:
+    // Nodes are stored in depth-first order, so the left child of an interior node immediately
+    // follows it. Each node covers the range [begin, end) of mIndices.
+    struct Node {
+        math::float3 min;
+        uint32_t begin;
+        math::float3 max;
+        uint32_t end;
+        uint32_t right;         // index of the right child, 0 for leaves
+    };
+
+    // maximum number of renderables in a leaf
+    static constexpr uint32_t LEAF_SIZE = 4;
+
+    void build();
+    uint32_t build(uint32_t begin, uint32_t end);
+    void refit() noexcept;
+
+    std::vector<Instance> mInstances;
+    std::vector<math::float3> mCenters;
+    std::vector<math::float3> mExtents;
+    std::vector<uint32_t> mIndices;
+    std::vector<Node> mNodes;
+
+    // number of bounding boxes that changed since the last build
+    size_t mMovedCount = 0;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_CULLINGHIERARCHY_H
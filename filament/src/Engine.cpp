@@ -309,6 +309,30 @@ utils::JobSystem& Engine::getJobSystem() noexcept {
     return downcast(this)->getJobSystem();
 }
 
+Engine::CommandBufferStats Engine::getCommandBufferStats() const noexcept {
+    return downcast(this)->getCommandBufferStats();
+}
+
+backend::HandleAllocatorStats Engine::getHandleAllocatorStats() noexcept {
+    return downcast(this)->getHandleAllocatorStats();
+}
+
+Engine::MemoryStats Engine::getMemoryStats() const noexcept {
+    return downcast(this)->getMemoryStats();
+}
+
+void Engine::setVariantRecordingEnabled(bool enabled) noexcept {
+    downcast(this)->setVariantRecordingEnabled(enabled);
+}
+
+bool Engine::isVariantRecordingEnabled() const noexcept {
+    return downcast(this)->isVariantRecordingEnabled();
+}
+
+size_t Engine::getVariantManifest(void* data, size_t size) const noexcept {
+    return downcast(this)->getVariantManifest(data, size);
+}
+
 bool Engine::isPaused() const noexcept {
     FILAMENT_CHECK_PRECONDITION(UTILS_HAS_THREADING)
             << "Pause is meant for multi-threaded platforms.";
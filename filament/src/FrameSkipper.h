@@ -29,8 +29,9 @@ namespace filament {
  * outrun the GPU.
  */
 class FrameSkipper {
-    static constexpr size_t MAX_FRAME_LATENCY = 3;
 public:
+    static constexpr size_t MAX_FRAME_LATENCY = 3;
+
     /*
      * The latency parameter defines how many unfinished frames we want to accept before we start
      * dropping frames. This affects frame latency.
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TNT_FILAMENT_FRAMETIMINGS_H
+#define TNT_FILAMENT_FRAMETIMINGS_H
+
+#include <filament/Renderer.h>
+
+#include <utils/compiler.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+/*
+ * Records the CPU time of the stages of each frame, see Renderer::FrameTimings.
+ *
+ * Stages can be recorded from any thread, they are accumulated atomically until endFrame()
+ * moves them into the history. Everything else must be called from the engine thread.
+ */
+class FrameTimingsRecorder {
+public:
+    using FrameTimings = Renderer::FrameTimings;
+    using Stage = FrameTimings::Stage;
+
+    class Scope {
+    public:
+        Scope(FrameTimingsRecorder& recorder, Stage stage) noexcept
+                : mRecorder(recorder), mStage(stage),
+                  mStart(std::chrono::steady_clock::now()) {
+        }
+        ~Scope() noexcept {
+            mRecorder.add(mStage, std::chrono::steady_clock::now() - mStart);
+        }
+        Scope(Scope const&) = delete;
+        Scope& operator=(Scope const&) = delete;
+    private:
+        FrameTimingsRecorder& mRecorder;
+        Stage const mStage;
+        std::chrono::steady_clock::time_point const mStart;
+    };
+
+    void add(Stage stage, std::chrono::steady_clock::duration duration) noexcept {
+        uint64_t const ns = uint64_t(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+        mCurrent[size_t(stage)].fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    void beginFrame(uint32_t frameId) noexcept {
+        mFrameId = frameId;
+    }
+
+    void endFrame() noexcept {
+        FrameTimings& timings = mHistory[mNext];
+        timings.frameId = mFrameId;
+        for (size_t i = 0; i < FrameTimings::STAGE_COUNT; i++) {
+            timings.durations[i] = mCurrent[i].exchange(0, std::memory_order_relaxed);
+        }
+        mNext = (mNext + 1) % mHistory.size();
+        mCount = std::min(mCount + 1, mHistory.size());
+    }
+
+    size_t getHistory(FrameTimings* out, size_t count) const noexcept {
+        count = std::min(count, mCount);
+        for (size_t i = 0; i < count; i++) {
+            out[i] = mHistory[(mNext + mHistory.size() - 1 - i) % mHistory.size()];
+        }
+        return count;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, FrameTimings::STAGE_COUNT> mCurrent{};
+    std::array<FrameTimings, Renderer::FRAME_TIMINGS_HISTORY_SIZE> mHistory{};
+    size_t mNext = 0;
+    size_t mCount = 0;
+    uint32_t mFrameId = 0;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_FRAMETIMINGS_H
@@ -26,6 +26,7 @@
 #include <filament/Viewport.h>
 
 #include <utils/BinaryTreeArray.h>
+#include <utils/Hash.h>
 #include <utils/Systrace.h>
 #include <utils/debug.h>
 
@@ -36,6 +37,7 @@
 #include <algorithm>
 
 #include <stddef.h>
+#include <string.h>
 
 using namespace filament::math;
 using namespace utils;
@@ -454,6 +456,8 @@ bool Froxelizer::update() noexcept {
     }
     assert_invariant(mZLightNear >= mNear);
     mDirtyFlags = 0;
+    // the froxel layout may have changed, the previous froxel data can't be reused
+    mFroxelDataValid = false;
     return uniformsNeedUpdating;
 }
 
@@ -491,6 +495,31 @@ size_t Froxelizer::findSliceZ(float z) const noexcept {
     return size_t(clamp(s, 0, mFroxelCountZ - 1));
 }
 
+void Froxelizer::setDepthBounds(Slice<const float2> depthBounds) noexcept {
+    std::swap(mOccupiedSlices, mLastOccupiedSlices);
+    mOccupiedSlices.clear();
+    if (depthBounds.empty()) {
+        return;
+    }
+
+    assert_invariant(depthBounds.size() == size_t(mFroxelCountX) * mFroxelCountY);
+    mOccupiedSlices.resize(depthBounds.size());
+    for (size_t i = 0, c = depthBounds.size(); i < c; i++) {
+        float2 const b = depthBounds[i];
+        if (b.x < b.y) {
+            mOccupiedSlices[i] = { 1, 0 };
+            continue;
+        }
+        // The depth comes from a previous frame, so we keep one more slice on each side for
+        // geometry that moved a little since then.
+        size_t const z0 = findSliceZ(std::min(b.x, 0.0f));
+        size_t const z1 = findSliceZ(std::max(b.y, -mZLightFar));
+        mOccupiedSlices[i] = {
+                uint16_t(z0 > 0 ? z0 - 1 : 0),
+                uint16_t(std::min(z1 + 1, size_t(mFroxelCountZ - 1))) };
+    }
+}
+
 std::pair<size_t, size_t> Froxelizer::clipToIndices(float2 const& clip) const noexcept {
     // clip coordinates between [-1, 1], conversion to index between [0, count[
     // (clip + 1) * 0.5 * dimension / froxelsize
@@ -502,12 +531,18 @@ std::pair<size_t, size_t> Froxelizer::clipToIndices(float2 const& clip) const no
 
 
 void Froxelizer::commit(backend::DriverApi& driverApi) {
-    // send data to GPU
-    driverApi.updateBufferObject(mFroxelsBuffer,
-            { mFroxelBufferUser.data(), getFroxelBufferEntryCount() * 16u }, 0);
-
-    driverApi.updateBufferObject(mRecordsBuffer,
-            { mRecordBufferUser.data(), RECORD_BUFFER_ENTRY_COUNT }, 0);
+    // send data to GPU, unless the buffers already hold it
+    if (mUploadNeeded) {
+        driverApi.updateBufferObject(mFroxelsBuffer,
+                { mFroxelBufferUser.data(), getFroxelBufferEntryCount() * 16u }, 0);
+
+        // only the records referenced by the froxels are needed, rounded up to a whole uint4
+        size_t const recordsSize = std::min(RECORD_BUFFER_ENTRY_COUNT,
+                std::max(size_t(16), (size_t(mRecordBufferUsedCount) + 15u) & ~size_t(15)));
+        driverApi.updateBufferObject(mRecordsBuffer,
+                { mRecordBufferUser.data(), recordsSize }, 0);
+        mUploadNeeded = false;
+    }
 
 #ifndef NDEBUG
     mFroxelBufferUser.clear();
@@ -520,8 +555,53 @@ void Froxelizer::froxelizeLights(FEngine& engine,
         mat4f const& UTILS_RESTRICT viewMatrix,
         const FScene::LightSoa& UTILS_RESTRICT lightData) noexcept {
     // note: this is called asynchronously
-    froxelizeLoop(engine, viewMatrix, lightData);
+    SYSTRACE_CALL();
+
+    auto& lcm = engine.getLightManager();
+    auto const* UTILS_RESTRICT spheres      = lightData.data<FScene::POSITION_RADIUS>();
+    auto const* UTILS_RESTRICT directions   = lightData.data<FScene::DIRECTION>();
+    auto const* UTILS_RESTRICT instances    = lightData.data<FScene::LIGHT_INSTANCE>();
+
+    // We use minimum cone angle of 0.5 degrees because too small angles cause issues in the
+    // sphere/cone intersection test, due to floating-point precision.
+    constexpr float maxInvSin = 114.59301f;         // 1 / sin(0.5 degrees)
+    constexpr float maxCosSquared = 0.99992385f;    // cos(0.5 degrees)^2
+
+    mat3f const& vn = viewMatrix.upperLeft();
+    size_t const count = lightData.size() - FScene::DIRECTIONAL_LIGHTS_COUNT;
+    std::swap(mLightParams, mLastLightParams);
+    mLightParams.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        const size_t j = i + FScene::DIRECTIONAL_LIGHTS_COUNT;
+        FLightManager::Instance const li = instances[j];
+        LightParams& light = mLightParams[i];
+        light = {
+                .position = (viewMatrix * float4{ spheres[j].xyz, 1 }).xyz,     // to view-space
+                .cosSqr = std::min(maxCosSquared, lcm.getCosOuterSquared(li)),  // spot only
+                .axis = vn * directions[j],                                     // spot only
+                .invSin = lcm.getSinInverse(li),                                // spot only
+                .radius = spheres[j].w,
+        };
+        // infinity means "point-light"
+        if (light.invSin != std::numeric_limits<float>::infinity()) {
+            light.invSin = std::min(maxInvSin, light.invSin);
+        }
+    }
+
+    // When neither the lights nor the froxels changed since the last time, which is common
+    // with a static camera, the buffers on the GPU are already up-to-date.
+    static_assert(sizeof(LightParams) == 9 * sizeof(float), "LightParams must not be padded");
+    if (mFroxelDataValid && mOccupiedSlices == mLastOccupiedSlices &&
+            mLightParams.size() == mLastLightParams.size() &&
+            !memcmp(mLightParams.data(), mLastLightParams.data(),
+                    mLightParams.size() * sizeof(LightParams))) {
+        return;
+    }
+
+    froxelizeLoop(engine, { mLightParams.data(), mLightParams.size() });
     froxelizeAssignRecordsCompress();
+    mFroxelDataValid = true;
+    mUploadNeeded = true;
 
 #ifndef NDEBUG
     if (lightData.size()) {
@@ -548,53 +628,26 @@ void Froxelizer::froxelizeLights(FEngine& engine,
 }
 
 void Froxelizer::froxelizeLoop(FEngine& engine,
-        const mat4f& UTILS_RESTRICT viewMatrix,
-        const FScene::LightSoa& UTILS_RESTRICT lightData) noexcept {
+        Slice<const LightParams> lights) noexcept {
     SYSTRACE_CALL();
 
     Slice<FroxelThreadData> froxelThreadData = mFroxelShardedData;
     memset(froxelThreadData.data(), 0, froxelThreadData.sizeInBytes());
 
-    auto& lcm = engine.getLightManager();
-    auto const* UTILS_RESTRICT spheres      = lightData.data<FScene::POSITION_RADIUS>();
-    auto const* UTILS_RESTRICT directions   = lightData.data<FScene::DIRECTION>();
-    auto const* UTILS_RESTRICT instances    = lightData.data<FScene::LIGHT_INSTANCE>();
-
-    auto process = [ this, &froxelThreadData,
-                     spheres, directions, instances, &viewMatrix, &lcm ]
+    auto process = [ this, &froxelThreadData, lights ]
             (size_t count, size_t offset, size_t stride) {
 
         SYSTRACE_NAME("FroxelizeLoop Job");
 
         const mat4f& projection = mProjection;
-        const mat3f& vn = viewMatrix.upperLeft();
-
-        // We use minimum cone angle of 0.5 degrees because too small angles cause issues in the
-        // sphere/cone intersection test, due to floating-point precision.
-        constexpr float maxInvSin = 114.59301f;         // 1 / sin(0.5 degrees)
-        constexpr float maxCosSquared = 0.99992385f;    // cos(0.5 degrees)^2
 
         for (size_t i = offset; i < count; i += stride) {
-            const size_t j = i + FScene::DIRECTIONAL_LIGHTS_COUNT;
-            FLightManager::Instance const li = instances[j];
-            LightParams light = {
-                    .position = (viewMatrix * float4{ spheres[j].xyz, 1 }).xyz,     // to view-space
-                    .cosSqr = std::min(maxCosSquared, lcm.getCosOuterSquared(li)),  // spot only
-                    .axis = vn * directions[j],                                     // spot only
-                    .invSin = lcm.getSinInverse(li),                                // spot only
-                    .radius = spheres[j].w,
-            };
-            // infinity means "point-light"
-            if (light.invSin != std::numeric_limits<float>::infinity()) {
-                light.invSin = std::min(maxInvSin, light.invSin);
-            }
-
             const size_t group = i % GROUP_COUNT;
             const size_t bit   = i / GROUP_COUNT;
             assert_invariant(bit < LIGHT_PER_GROUP);
 
             FroxelThreadData& threadData = froxelThreadData[group];
-            froxelizePointAndSpotLight(threadData, bit, projection, light);
+            froxelizePointAndSpotLight(threadData, bit, projection, lights[i]);
         }
     };
 
@@ -606,12 +659,12 @@ void Froxelizer::froxelizeLoop(FEngine& engine,
         auto *parent = js.createJob();
         for (size_t i = 0; i < GROUP_COUNT; i++) {
             js.run(jobs::createJob(js, parent, std::cref(process),
-                    lightData.size() - FScene::DIRECTIONAL_LIGHTS_COUNT, i, GROUP_COUNT));
+                    lights.size(), i, GROUP_COUNT));
         }
         js.runAndWait(parent);
     } else {
         js.runAndWait(jobs::createJob(js, nullptr, std::cref(process),
-                lightData.size() - FScene::DIRECTIONAL_LIGHTS_COUNT, 0, 1)
+                lights.size(), 0, 1)
         );
     }
 }
@@ -641,6 +694,18 @@ void Froxelizer::froxelizeAssignRecordsCompress() noexcept {
         }
     }
 
+    // remove the lights from the froxels that don't contain any geometry
+    if (!mOccupiedSlices.empty()) {
+        size_t const columnCount = size_t(mFroxelCountX) * mFroxelCountY;
+        for (size_t j = 0, jc = mFroxelCount; j < jc; j++) {
+            ushort2 const slices = mOccupiedSlices[j % columnCount];
+            size_t const iz = j / columnCount;
+            if (iz < slices.x || iz > slices.y) {
+                records[j].lights.clear();
+            }
+        }
+    }
+
     LightRecord::bitset allLights{};
     for (size_t j = 0, jc = getFroxelBufferEntryCount(); j < jc; j++) {
         allLights |= records[j].lights;
@@ -670,6 +735,27 @@ void Froxelizer::froxelizeAssignRecordsCompress() noexcept {
     // how many froxel record entries were reused (for debugging)
     UTILS_UNUSED size_t reused = 0;
 
+    // Froxels that aren't next to each other often have the same lights (e.g. the froxels of
+    // a small light in consecutive slices), so we also retrieve the records of earlier froxels
+    // through a hash table, indexed by their light set. Each slot holds the index of the first
+    // froxel using a set of lights. This keeps the record buffer compact with many lights.
+    size_t const tableSize = size_t(1) << (log2i(std::max(mFroxelCount, 1u)) + 2u);
+    uint32_t const tableMask = uint32_t(tableSize - 1);
+    mRecordTable.resize(tableSize);
+    std::fill(mRecordTable.begin(), mRecordTable.end(), NO_RECORD);
+    auto findRecord = [table = mRecordTable.data(), tableMask, records]
+            (LightRecord::bitset const& lights) -> uint32_t& {
+        uint32_t h = hash::murmur3(reinterpret_cast<uint32_t const*>(&lights),
+                sizeof(lights) / sizeof(uint32_t), 0);
+        while (true) {
+            uint32_t& slot = table[h & tableMask];
+            if (slot == NO_RECORD || records[slot].lights == lights) {
+                return slot;
+            }
+            h++;
+        }
+    };
+
     for (size_t i = 0, c = mFroxelCount; i < c;) {
         LightRecord b = records[i];
         if (b.lights.none()) {
@@ -682,12 +768,16 @@ void Froxelizer::froxelizeAssignRecordsCompress() noexcept {
         FroxelEntry entry{ offset, uint8_t(std::min(size_t(255), b.lights.count())) };
         const size_t lightCount = entry.count();
 
-        if (UTILS_UNLIKELY(offset + lightCount >= RECORD_BUFFER_ENTRY_COUNT)) {
+        uint32_t& record = findRecord(b.lights);
+        if (record != NO_RECORD) {
+            // an earlier froxel has the same lights, use its records
+            entry.u32 = froxels[record].u32;
+        } else if (UTILS_UNLIKELY(offset + lightCount >= RECORD_BUFFER_ENTRY_COUNT)) {
 #ifndef NDEBUG
             slog.d << "out of space: " << i << ", at " << offset << io::endl;
 #endif
-            // note: instead of dropping froxels we could look for similar records we've already
-            // filed up.
+            // note: instead of dropping froxels we could look for records we've already filed
+            // up that hold a superset of these lights.
             do {
                 froxels[i] = { 0u, allLightsCount };
                 if (records[i].lights.none()) {
@@ -695,22 +785,25 @@ void Froxelizer::froxelizeAssignRecordsCompress() noexcept {
                 }
             } while(++i < c);
             goto out_of_memory;
-        }
+        } else {
+            record = uint32_t(i);
+
+            // iterate the bitfield
+            auto * const beginPoint = froxelRecords + offset;
+            b.lights.forEachSetBit([point = beginPoint, beginPoint](size_t l) mutable {
+                // make sure to keep this code branch-less
+                const size_t word = l / LIGHT_PER_GROUP;
+                const size_t bit  = l % LIGHT_PER_GROUP;
+                l = (bit * GROUP_COUNT) | (word % GROUP_COUNT);
+                *point = (RecordBufferType)l;
+                // we need to "cancel" the write operation if we have more than 255 spot or point
+                // lights (this is a limitation of the data type used to store the light counts
+                // per froxel)
+                point += (point - beginPoint < 255) ? 1 : 0;
+            });
 
-        // iterate the bitfield
-        auto * const beginPoint = froxelRecords + offset;
-        b.lights.forEachSetBit([point = beginPoint, beginPoint](size_t l) mutable {
-            // make sure to keep this code branch-less
-            const size_t word = l / LIGHT_PER_GROUP;
-            const size_t bit  = l % LIGHT_PER_GROUP;
-            l = (bit * GROUP_COUNT) | (word % GROUP_COUNT);
-            *point = (RecordBufferType)l;
-            // we need to "cancel" the write operation if we have more than 255 spot or point lights
-            // (this is a limitation of the data type used to store the light counts per froxel)
-            point += (point - beginPoint < 255) ? 1 : 0;
-        });
-
-        offset += lightCount;
+            offset += lightCount;
+        }
 
 #ifndef NDEBUG
         if (lightCount) { reused--; }
@@ -733,7 +826,7 @@ void Froxelizer::froxelizeAssignRecordsCompress() noexcept {
     }
 out_of_memory:
     // FIXME: on big-endian systems we need to change the endianness of the record buffer
-    ;
+    mRecordBufferUsedCount = offset;
 }
 
 static inline float2 project(mat4f const& p, float3 const& v) noexcept {
@@ -31,8 +31,11 @@
 #include <utils/Slice.h>
 
 #include <math/mat4.h>
+#include <math/vec2.h>
 #include <math/vec4.h>
 
+#include <vector>
+
 namespace filament {
 
 // Max number of froxels limited by:
@@ -121,6 +124,21 @@ public:
 
     float getLightFar() const noexcept { return mZLightFar; }
 
+    // size of a froxel in [0, 1] screen coordinates. valid after prepare().
+    math::float2 getFroxelSize() const noexcept {
+        return math::float2(mFroxelDimension) / math::float2{ mViewport.width, mViewport.height };
+    }
+
+    /*
+     * Restricts the lights to the froxels that contain geometry. Must be called after prepare()
+     * and before froxelizeLights().
+     *
+     * depthBounds  view-space z range {nearest, farthest} of the geometry in each column of
+     *              froxels (x + y * getFroxelCountX()), nearest < farthest when there is none.
+     *              An empty slice assigns lights to all the froxels they overlap.
+     */
+    void setDepthBounds(utils::Slice<const math::float2> depthBounds) noexcept;
+
     // update Records and Froxels texture with lights data. this is thread-safe.
     void froxelizeLights(FEngine& engine, math::mat4f const& viewMatrix,
             const FScene::LightSoa& lightData) noexcept;
@@ -195,8 +213,7 @@ private:
     inline void setProjection(const math::mat4f& projection, float near, float far) noexcept;
     bool update() noexcept;
 
-    void froxelizeLoop(FEngine& engine,
-            math::mat4f const& viewMatrix, const FScene::LightSoa& lightData) noexcept;
+    void froxelizeLoop(FEngine& engine, utils::Slice<const LightParams> lights) noexcept;
 
     void froxelizeAssignRecordsCompress() noexcept;
 
@@ -251,6 +268,23 @@ private:
     // allocations in the command stream
     utils::Slice<RecordBufferType> mRecordBufferUser;   //  16 KiB
 
+    // The view-space lights last froxelized, when they don't change and the froxel layout
+    // is the same, the froxel and record buffers of the previous frame are still valid.
+    std::vector<LightParams> mLightParams;
+    std::vector<LightParams> mLastLightParams;
+    uint32_t mRecordBufferUsedCount = 0;
+
+    // The range of occupied z-slices of each froxel column, {1, 0} when a column is empty. Empty
+    // when the froxels aren't restricted to the depth bounds, see setDepthBounds().
+    std::vector<math::ushort2> mOccupiedSlices;
+    std::vector<math::ushort2> mLastOccupiedSlices;
+
+    // hash table of the light records already written, see froxelizeAssignRecordsCompress()
+    static constexpr uint32_t NO_RECORD = 0xFFFFFFFFu;
+    std::vector<uint32_t> mRecordTable;
+    bool mFroxelDataValid = false;
+    bool mUploadNeeded = false;
+
     uint16_t mFroxelCountX = 0;
     uint16_t mFroxelCountY = 0;
     uint16_t mFroxelCountZ = 0;
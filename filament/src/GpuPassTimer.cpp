@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GpuPassTimer.h"
+
+#include <backend/DriverEnums.h>
+
+#include <utils/debug.h>
+
+#include <algorithm>
+
+namespace filament {
+
+using namespace backend;
+
+GpuPassTimer::GpuPassTimer() noexcept = default;
+
+GpuPassTimer::~GpuPassTimer() noexcept = default;
+
+void GpuPassTimer::terminate(DriverApi& driver) noexcept {
+    for (auto& frame : mFrames) {
+        for (auto& query : frame.queries) {
+            if (query) {
+                driver.destroyTimerQuery(query);
+                query.clear();
+            }
+        }
+    }
+}
+
+void GpuPassTimer::beginFrame(DriverApi& driver, uint32_t frameId) noexcept {
+    Frame& frame = mFrames[mIndex];
+    if (frame.pending) {
+        resolve(driver, frame);
+    }
+    mRecording = mEnabled;
+    if (mRecording) {
+        frame.frameId = frameId;
+        frame.count = 0;
+    }
+}
+
+void GpuPassTimer::endFrame() noexcept {
+    if (mRecording) {
+        Frame& frame = mFrames[mIndex];
+        frame.pending = frame.count > 0;
+        mIndex = (mIndex + 1) % POOL_COUNT;
+        mRecording = false;
+    }
+}
+
+void GpuPassTimer::onPassBegin(DriverApi& driver, const char* name) noexcept {
+    assert_invariant(!mInPass);
+    Frame& frame = mFrames[mIndex];
+    if (!mRecording || frame.count == MAX_PASS_COUNT) {
+        // not between beginFrame() and endFrame(), or too many passes
+        return;
+    }
+    auto& query = frame.queries[frame.count];
+    if (!query) {
+        query = driver.createTimerQuery();
+    }
+    driver.beginTimerQuery(query);
+    frame.names[frame.count] = name;
+    mInPass = true;
+}
+
+void GpuPassTimer::onPassEnd(DriverApi& driver) noexcept {
+    if (mInPass) {
+        Frame& frame = mFrames[mIndex];
+        driver.endTimerQuery(frame.queries[frame.count]);
+        frame.count++;
+        mInPass = false;
+    }
+}
+
+void GpuPassTimer::resolve(DriverApi& driver, Frame& frame) noexcept {
+    frame.pending = false;
+    std::array<GpuPassTiming, MAX_PASS_COUNT> timings; // NOLINT -- initialized below
+    for (size_t i = 0; i < frame.count; i++) {
+        uint64_t elapsed = 0;
+        if (driver.getTimerQueryValue(frame.queries[i], &elapsed) != TimerQueryResult::AVAILABLE) {
+            // keep the previous results rather than showing a partial frame
+            return;
+        }
+        timings[i] = { frame.names[i], elapsed };
+    }
+    std::copy_n(timings.begin(), frame.count, mLatest.begin());
+    mLatestCount = frame.count;
+    mLatestFrameId = frame.frameId;
+}
+
+size_t GpuPassTimer::getTimings(GpuPassTiming* out, size_t count,
+        uint32_t* frameId) const noexcept {
+    count = std::min(count, size_t(mLatestCount));
+    std::copy_n(mLatest.begin(), count, out);
+    if (frameId) {
+        *frameId = mLatestFrameId;
+    }
+    return count;
+}
+
+} // namespace filament
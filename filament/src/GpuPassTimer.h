@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_GPUPASSTIMER_H
+#define TNT_FILAMENT_GPUPASSTIMER_H
+
+#include "fg/FrameGraph.h"
+
+#include <filament/Renderer.h>
+
+#include <backend/Handle.h>
+
+#include <private/backend/DriverApi.h>
+
+#include <array>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+/*
+ * Times the passes of the frame graph on the GPU, see Renderer::getGpuPassTimings().
+ *
+ * Each frame records into one of POOL_COUNT slots holding a timer query per pass. A slot's
+ * results are read when it's about to be reused, POOL_COUNT frames later, which guarantees
+ * that the backend processed the previous use of its queries. Frames whose results are not
+ * available by then are dropped. All methods must be called from the engine thread.
+ */
+class GpuPassTimer final : public FrameGraph::PassListener {
+public:
+    using GpuPassTiming = Renderer::GpuPassTiming;
+    static constexpr size_t MAX_PASS_COUNT = Renderer::GPU_PASS_TIMINGS_MAX_COUNT;
+
+    GpuPassTimer() noexcept;
+    ~GpuPassTimer() noexcept override;
+
+    void terminate(backend::DriverApi& driver) noexcept;
+
+    void setEnabled(bool enabled) noexcept { mEnabled = enabled; }
+
+    bool isEnabled() const noexcept { return mEnabled; }
+
+    // call after the backend's beginFrame()
+    void beginFrame(backend::DriverApi& driver, uint32_t frameId) noexcept;
+
+    // call before the backend's endFrame()
+    void endFrame() noexcept;
+
+    size_t getTimings(GpuPassTiming* out, size_t count, uint32_t* frameId) const noexcept;
+
+    void onPassBegin(backend::DriverApi& driver, const char* name) noexcept override;
+    void onPassEnd(backend::DriverApi& driver) noexcept override;
+
+private:
+    static constexpr size_t POOL_COUNT = 4;
+
+    struct Frame {
+        // queries are created the first time a slot needs them, and kept
+        std::array<backend::Handle<backend::HwTimerQuery>, MAX_PASS_COUNT> queries;
+        std::array<const char*, MAX_PASS_COUNT> names{};
+        uint32_t frameId = 0;
+        uint32_t count = 0;
+        bool pending = false;
+    };
+
+    void resolve(backend::DriverApi& driver, Frame& frame) noexcept;
+
+    std::array<Frame, POOL_COUNT> mFrames;
+    std::array<GpuPassTiming, MAX_PASS_COUNT> mLatest{};
+    uint32_t mLatestCount = 0;
+    uint32_t mLatestFrameId = 0;
+    uint32_t mIndex = 0;
+    bool mEnabled = false;
+    bool mRecording = false;
+    bool mInPass = false;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_GPUPASSTIMER_H
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HwProgramFactory.h"
+
+#include <backend/DriverApiForward.h>
+#include <backend/DriverEnums.h>
+#include <backend/Handle.h>
+#include <backend/Program.h>
+
+#include <private/backend/DriverApi.h>
+
+#include <utils/CString.h>
+#include <utils/compiler.h>
+#include <utils/debug.h>
+
+#include <type_traits>
+#include <variant>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+using namespace utils;
+using namespace backend;
+
+namespace {
+
+// 64-bits FNV-1a, the whole content of the program goes through it
+class ContentHasher {
+public:
+    void bytes(void const* data, size_t size) noexcept {
+        uint8_t const* p = static_cast<uint8_t const*>(data);
+        for (size_t i = 0; i < size; i++) {
+            mHash = (mHash ^ p[i]) * 0x100000001b3ull;
+        }
+    }
+    template<typename T>
+    void value(T const& v) noexcept {
+        static_assert(std::is_trivially_copyable_v<T>);
+        bytes(&v, sizeof(v));
+    }
+    void string(CString const& s) noexcept {
+        // the length is included, so that consecutive strings can't alias each other
+        value(uint32_t(s.size()));
+        bytes(s.data(), s.size());
+    }
+    uint64_t get() const noexcept { return mHash; }
+private:
+    uint64_t mHash = 0xcbf29ce484222325ull;
+};
+
+} // anonymous namespace
+
+uint64_t HwProgramFactory::hash(Program const& program) noexcept {
+    ContentHasher h;
+    h.value(program.getShaderLanguage());
+    h.value(program.isMultiview());
+
+    for (auto const& source : program.getShadersSource()) {
+        h.value(uint32_t(source.size()));
+        h.bytes(source.data(), source.size());
+    }
+
+    for (auto const& name : program.getUniformBlockBindings()) {
+        h.string(name);
+    }
+
+    for (auto const& group : program.getSamplerGroupInfo()) {
+        h.value(group.stageFlags);
+        h.value(uint32_t(group.samplers.size()));
+        for (auto const& sampler : group.samplers) {
+            h.string(sampler.name);
+            h.value(sampler.binding);
+        }
+    }
+
+    for (auto const& uniforms : program.getBindingUniformInfo()) {
+        h.value(uint32_t(uniforms.size()));
+        for (auto const& uniform : uniforms) {
+            h.string(uniform.name);
+            h.value(uniform.offset);
+            h.value(uniform.size);
+            h.value(uniform.type);
+        }
+    }
+
+    h.value(uint32_t(program.getAttributes().size()));
+    for (auto const& [name, location] : program.getAttributes()) {
+        h.string(name);
+        h.value(location);
+    }
+
+    auto const& constants = program.getSpecializationConstants();
+    h.value(uint32_t(constants.size()));
+    for (auto const& constant : constants) {
+        h.value(constant.id);
+        h.value(uint32_t(constant.value.index()));
+        std::visit([&h](auto v) { h.value(v); }, constant.value);
+    }
+
+    for (size_t i = 0; i < Program::SHADER_TYPE_COUNT; i++) {
+        auto const& pushConstants = program.getPushConstants(ShaderStage(i));
+        h.value(uint32_t(pushConstants.size()));
+        for (auto const& constant : pushConstants) {
+            h.string(constant.name);
+            h.value(constant.type);
+        }
+    }
+
+    return h.get();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+HwProgramFactory::HwProgramFactory() {
+    mBimap.reserve(256);
+}
+
+HwProgramFactory::~HwProgramFactory() noexcept = default;
+
+void HwProgramFactory::terminate(DriverApi&) noexcept {
+    assert_invariant(mBimap.empty());
+}
+
+auto HwProgramFactory::create(DriverApi& driver, Program&& program) noexcept -> Handle {
+    // see if we already have an identical program
+    Key const key(hash(program));
+    auto pos = mBimap.find(key);
+
+    if (pos == mBimap.end()) {
+        auto handle = driver.createProgram(std::move(program));
+        mBimap.insert(key, { handle });
+        return handle;
+    }
+
+    ++(pos->first.pKey->refs);
+    return pos->second.handle;
+}
+
+void HwProgramFactory::destroy(DriverApi& driver, Handle handle) noexcept {
+    if (!handle) {
+        return;
+    }
+    // look for this handle in our map
+    auto pos = mBimap.find(Value{ handle });
+    if (--pos->second.pKey->refs == 0) {
+        mBimap.erase(pos);
+        driver.destroyProgram(handle);
+    }
+}
+
+} // namespace filament
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_HWPROGRAMFACTORY_H
+#define TNT_FILAMENT_HWPROGRAMFACTORY_H
+
+#include "Bimap.h"
+
+#include <backend/DriverApiForward.h>
+#include <backend/Handle.h>
+#include <backend/Program.h>
+
+#include <functional>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+/*
+ * Shares programs between materials. Programs are identified by a hash of their content, i.e.
+ * their shader sources, specialization constants, push constants and bindings. Materials built
+ * from the same template often produce identical programs for some of their variants, which
+ * are then compiled and linked only once.
+ *
+ * The program's name, cache id and priority don't take part in its identity; a shared program
+ * keeps those of the first material that created it.
+ */
+class HwProgramFactory {
+public:
+    using Handle = backend::ProgramHandle;
+
+    HwProgramFactory();
+    ~HwProgramFactory() noexcept;
+
+    HwProgramFactory(HwProgramFactory const& rhs) = delete;
+    HwProgramFactory(HwProgramFactory&& rhs) noexcept = delete;
+    HwProgramFactory& operator=(HwProgramFactory const& rhs) = delete;
+    HwProgramFactory& operator=(HwProgramFactory&& rhs) noexcept = delete;
+
+    void terminate(backend::DriverApi& driver) noexcept;
+
+    // Returns a program identical to the given one, creating it if needed. Each call must be
+    // matched by a call to destroy().
+    Handle create(backend::DriverApi& driver, backend::Program&& program) noexcept;
+
+    // Destroys the program once the last of its users is gone. Null handles are ignored.
+    void destroy(backend::DriverApi& driver, Handle handle) noexcept;
+
+    static uint64_t hash(backend::Program const& program) noexcept;
+
+private:
+    struct Key {
+        // The key should not be copyable, unfortunately due to how the Bimap works we have
+        // to copy-construct it once.
+        Key(Key const&) = default;
+        Key& operator=(Key const&) = delete;
+        Key& operator=(Key&&) noexcept = delete;
+        explicit Key(uint64_t hash) : hash(hash), refs(1) { }
+        uint64_t hash;          // 8 bytes
+        mutable uint32_t refs;  // 4 bytes
+        bool operator==(Key const& rhs) const noexcept {
+            return hash == rhs.hash;
+        }
+    };
+
+    struct KeyHasher {
+        size_t operator()(Key const& p) const noexcept {
+            return size_t(p.hash);
+        }
+    };
+
+    struct Value { // 4 bytes
+        Handle handle;
+    };
+
+    struct ValueHasher {
+        size_t operator()(Value const v) const noexcept {
+            return std::hash<Handle::HandleId>()(v.handle.getId());
+        }
+    };
+
+    friend bool operator==(Value const lhs, Value const rhs) noexcept {
+        return lhs.handle == rhs.handle;
+    }
+
+    Bimap<Key, Value, KeyHasher, ValueHasher> mBimap;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_HWPROGRAMFACTORY_H
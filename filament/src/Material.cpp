@@ -145,6 +145,11 @@ void Material::compile(CompilerPriorityQueue priority, UserVariantFilterMask var
     downcast(this)->compile(priority, variantFilter, handler, std::move(callback));
 }
 
+void Material::compile(CompilerPriorityQueue priority, void const* manifest, size_t size,
+        backend::CallbackHandler* handler, utils::Invocable<void(Material*)>&& callback) noexcept {
+    downcast(this)->compile(priority, manifest, size, handler, std::move(callback));
+}
+
 UserVariantFilterMask Material::getSupportedVariants() const noexcept {
     return downcast(this)->getSupportedVariants();
 }
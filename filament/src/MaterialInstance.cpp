@@ -183,6 +183,138 @@ template UTILS_PUBLIC void MaterialInstance::setParameter<mat4f>   (const char*
 
 // ------------------------------------------------------------------------------------------------
 
+// The handle versions skip the name lookup, there is nothing else to them so they're inlined
+// in each of the explicit instantiations below.
+template<typename T>
+UTILS_ALWAYS_INLINE
+inline void FMaterialInstance::setParameterImpl(ParameterHandle handle, T const& value) {
+    assert_invariant(handle.isValid());
+    assert_invariant(handle.offset + sizeof(T) <= mUniforms.getSize());
+    if constexpr (std::is_same_v<T, mat3f>) {
+        mUniforms.setUniform(handle.offset, value);
+    } else {
+        mUniforms.setUniformUntyped<sizeof(T)>(handle.offset, &value);
+    }
+}
+
+template<typename T>
+UTILS_ALWAYS_INLINE
+inline void FMaterialInstance::setParameterImpl(ParameterHandle handle,
+        const T* value, size_t count) {
+    static_assert(!std::is_same_v<T, math::mat3f>);
+    assert_invariant(handle.isValid());
+    mUniforms.setUniformArrayUntyped<sizeof(T)>(handle.offset, value, count);
+}
+
+template<typename T, typename>
+void MaterialInstance::setParameter(ParameterHandle handle, T const& value) {
+    downcast(this)->setParameterImpl(handle, value);
+}
+
+template<>
+UTILS_PUBLIC void MaterialInstance::setParameter(ParameterHandle handle, bool const& v) {
+    MaterialInstance::setParameter(handle, (uint32_t)v);
+}
+
+template<>
+UTILS_PUBLIC void MaterialInstance::setParameter(ParameterHandle handle, bool2 const& v) {
+    MaterialInstance::setParameter(handle, uint2(v));
+}
+
+template<>
+UTILS_PUBLIC void MaterialInstance::setParameter(ParameterHandle handle, bool3 const& v) {
+    MaterialInstance::setParameter(handle, uint3(v));
+}
+
+template<>
+UTILS_PUBLIC void MaterialInstance::setParameter(ParameterHandle handle, bool4 const& v) {
+    MaterialInstance::setParameter(handle, uint4(v));
+}
+
+template UTILS_PUBLIC void MaterialInstance::setParameter<float>   (ParameterHandle handle, float const&    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int32_t> (ParameterHandle handle, int32_t const&  v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint32_t>(ParameterHandle handle, uint32_t const& v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int2>    (ParameterHandle handle, int2 const&     v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int3>    (ParameterHandle handle, int3 const&     v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int4>    (ParameterHandle handle, int4 const&     v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint2>   (ParameterHandle handle, uint2 const&    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint3>   (ParameterHandle handle, uint3 const&    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint4>   (ParameterHandle handle, uint4 const&    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float2>  (ParameterHandle handle, float2 const&   v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float3>  (ParameterHandle handle, float3 const&   v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float4>  (ParameterHandle handle, float4 const&   v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<mat3f>   (ParameterHandle handle, mat3f const&    v);
+template UTILS_PUBLIC void MaterialInstance::setParameter<mat4f>   (ParameterHandle handle, mat4f const&    v);
+
+template <typename T, typename>
+void MaterialInstance::setParameter(ParameterHandle handle, const T* value, size_t count) {
+    downcast(this)->setParameterImpl(handle, value, count);
+}
+
+template<>
+UTILS_PUBLIC void MaterialInstance::setParameter(ParameterHandle handle, const bool* v, size_t c) {
+    auto* p = new uint32_t[c];
+    std::copy_n(v, c, p);
+    MaterialInstance::setParameter(handle, p, c);
+    delete [] p;
+}
+
+template<>
+UTILS_PUBLIC void MaterialInstance::setParameter(ParameterHandle handle, const bool2* v, size_t c) {
+    auto* p = new uint2[c];
+    std::copy_n(v, c, p);
+    MaterialInstance::setParameter(handle, p, c);
+    delete [] p;
+}
+
+template<>
+UTILS_PUBLIC void MaterialInstance::setParameter(ParameterHandle handle, const bool3* v, size_t c) {
+    auto* p = new uint3[c];
+    std::copy_n(v, c, p);
+    MaterialInstance::setParameter(handle, p, c);
+    delete [] p;
+}
+
+template<>
+UTILS_PUBLIC void MaterialInstance::setParameter(ParameterHandle handle, const bool4* v, size_t c) {
+    auto* p = new uint4[c];
+    std::copy_n(v, c, p);
+    MaterialInstance::setParameter(handle, p, c);
+    delete [] p;
+}
+
+template<>
+UTILS_PUBLIC void MaterialInstance::setParameter<mat3f>(ParameterHandle handle, const mat3f* v, size_t c) {
+    // pretend each mat3 is an array of 3 float3
+    MaterialInstance::setParameter(handle, reinterpret_cast<math::float3 const*>(v), c * 3);
+}
+
+template UTILS_PUBLIC void MaterialInstance::setParameter<float>   (ParameterHandle handle, const float    *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int32_t> (ParameterHandle handle, const int32_t  *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint32_t>(ParameterHandle handle, const uint32_t *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int2>    (ParameterHandle handle, const int2     *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int3>    (ParameterHandle handle, const int3     *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<int4>    (ParameterHandle handle, const int4     *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint2>   (ParameterHandle handle, const uint2    *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint3>   (ParameterHandle handle, const uint3    *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<uint4>   (ParameterHandle handle, const uint4    *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float2>  (ParameterHandle handle, const float2   *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float3>  (ParameterHandle handle, const float3   *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<float4>  (ParameterHandle handle, const float4   *v, size_t c);
+template UTILS_PUBLIC void MaterialInstance::setParameter<mat4f>   (ParameterHandle handle, const mat4f    *v, size_t c);
+
+MaterialInstance::ParameterHandle MaterialInstance::getParameterHandle(
+        const char* name, size_t nameLength) const {
+    return downcast(this)->getParameterHandle({ name, nameLength });
+}
+
+void MaterialInstance::setParameters(ParameterHandle const* handles, size_t count,
+        void const* data) {
+    downcast(this)->setParameters(handles, count, data);
+}
+
+// ------------------------------------------------------------------------------------------------
+
 Material const* MaterialInstance::getMaterial() const noexcept {
     return downcast(this)->getMaterial();
 }
@@ -34,6 +34,17 @@
 
 #include <utils/CString.h>
 
+#if !defined(WIN32) && !defined(__EMSCRIPTEN__)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    define HAS_MMAP 1
+#else
+#    define HAS_MMAP 0
+#endif
+
+#include <stdio.h>
 #include <stdlib.h>
 #include <optional>
 
@@ -69,6 +80,64 @@ MaterialParser::MaterialParserDetails::MaterialParserDetails(
       mPreferredLanguages(preferredLanguages),
       mMaterialChunk(mChunkContainer) {}
 
+MaterialParser::MaterialParserDetails::MaterialParserDetails(
+        const utils::FixedCapacityVector<ShaderLanguage>& preferredLanguages,
+        CString const& path)
+    : mManagedBuffer(path),
+      mChunkContainer(mManagedBuffer.data(), mManagedBuffer.size()),
+      mPreferredLanguages(preferredLanguages),
+      mMaterialChunk(mChunkContainer) {}
+
+MaterialParser::MaterialParserDetails::ManagedBuffer::ManagedBuffer(CString const& path) noexcept {
+#if HAS_MMAP
+    int const fd = ::open(path.c_str_safe(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            // the package is only ever read, a private read-only mapping is all we need
+            void* const data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                mStart = data;
+                mSize = size_t(st.st_size);
+                mMapped = true;
+            }
+        }
+        ::close(fd);
+    }
+    if (mMapped) {
+        return;
+    }
+#endif
+    // no mmap, or the file can't be mapped: fall back to reading it
+    FILE* const file = fopen(path.c_str_safe(), "rb");
+    if (!file) {
+        return;
+    }
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long const size = ftell(file);
+        if (size > 0 && fseek(file, 0, SEEK_SET) == 0) {
+            mStart = malloc(size_t(size));
+            if (mStart && fread(mStart, 1, size_t(size), file) == size_t(size)) {
+                mSize = size_t(size);
+            } else {
+                free(mStart);
+                mStart = nullptr;
+            }
+        }
+    }
+    fclose(file);
+}
+
+MaterialParser::MaterialParserDetails::ManagedBuffer::~ManagedBuffer() noexcept {
+#if HAS_MMAP
+    if (mMapped) {
+        munmap(mStart, mSize);
+        return;
+    }
+#endif
+    free(mStart);
+}
+
 template<typename T>
 UTILS_NOINLINE
 bool MaterialParser::MaterialParserDetails::getFromSimpleChunk(
@@ -88,6 +157,10 @@ MaterialParser::MaterialParser(utils::FixedCapacityVector<ShaderLanguage> prefer
         const void* data, size_t size)
     : mImpl(preferredLanguages, data, size) {}
 
+MaterialParser::MaterialParser(utils::FixedCapacityVector<ShaderLanguage> preferredLanguages,
+        CString const& path)
+    : mImpl(preferredLanguages, path) {}
+
 ChunkContainer& MaterialParser::getChunkContainer() noexcept {
     return mImpl.mChunkContainer;
 }
@@ -120,9 +193,18 @@ MaterialParser::ParseResult MaterialParser::parse() noexcept {
     }
 
     const auto [chosenLanguage, matTag, dictTag] = result.value();
-    if (UTILS_UNLIKELY(!DictionaryReader::unflatten(cc, dictTag, mImpl.mBlobDictionary))) {
-        return ParseResult::ERROR_OTHER;
+    if (dictTag == ChunkType::DictionaryText) {
+        if (UTILS_UNLIKELY(!DictionaryReader::unflatten(cc, dictTag, mImpl.mBlobDictionary))) {
+            return ParseResult::ERROR_OTHER;
+        }
+    } else {
+        // binary shaders are only decoded (e.g. decompressed for SPIR-V) when requested, most
+        // variants of a material are never used.
+        if (UTILS_UNLIKELY(!DictionaryReader::index(cc, dictTag, mImpl.mBlobIndex))) {
+            return ParseResult::ERROR_OTHER;
+        }
     }
+    mImpl.mDictionaryTag = dictTag;
     if (UTILS_UNLIKELY(!mImpl.mMaterialChunk.initialize(matTag))) {
         return ParseResult::ERROR_OTHER;
     }
@@ -384,8 +466,16 @@ bool MaterialParser::getReflectionMode(ReflectionMode* value) const noexcept {
 
 bool MaterialParser::getShader(ShaderContent& shader,
         ShaderModel shaderModel, Variant variant, ShaderStage stage) noexcept {
-    return mImpl.mMaterialChunk.getShader(shader,
-            mImpl.mBlobDictionary, shaderModel, variant, stage);
+    if (mImpl.mDictionaryTag == ChunkType::DictionaryText) {
+        return mImpl.mMaterialChunk.getShader(shader,
+                mImpl.mBlobDictionary, shaderModel, variant, stage);
+    }
+    uint32_t index;
+    if (!mImpl.mMaterialChunk.getBlobIndex(shaderModel, variant, stage, &index) ||
+            index >= mImpl.mBlobIndex.size()) {
+        return false;
+    }
+    return DictionaryReader::decode(mImpl.mDictionaryTag, mImpl.mBlobIndex[index], shader);
 }
 
 // ------------------------------------------------------------------------------------------------
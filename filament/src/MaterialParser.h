@@ -18,6 +18,7 @@
 #define TNT_FILAMENT_MATERIALPARSER_H
 
 #include <filaflat/ChunkContainer.h>
+#include <filaflat/DictionaryReader.h>
 #include <filaflat/MaterialChunk.h>
 
 #include <filament/MaterialEnums.h>
@@ -54,6 +55,11 @@ public:
     MaterialParser(utils::FixedCapacityVector<backend::ShaderLanguage> preferredLanguages,
             const void* data, size_t size);
 
+    // The package is read from a file, which is memory-mapped where supported so that it's never
+    // copied. Use getPackageSize() to check that the file could be read.
+    MaterialParser(utils::FixedCapacityVector<backend::ShaderLanguage> preferredLanguages,
+            utils::CString const& path);
+
     MaterialParser(MaterialParser const& rhs) noexcept = delete;
     MaterialParser& operator=(MaterialParser const& rhs) noexcept = delete;
 
@@ -135,27 +141,38 @@ public:
         return mImpl.mMaterialChunk;
     }
 
+    void const* getPackageData() const noexcept { return mImpl.mManagedBuffer.data(); }
+    size_t getPackageSize() const noexcept { return mImpl.mManagedBuffer.size(); }
+
 private:
     struct MaterialParserDetails {
         MaterialParserDetails(
                 const utils::FixedCapacityVector<backend::ShaderLanguage>& preferredLanguages,
                 const void* data, size_t size);
 
+        MaterialParserDetails(
+                const utils::FixedCapacityVector<backend::ShaderLanguage>& preferredLanguages,
+                utils::CString const& path);
+
         template<typename T>
         bool getFromSimpleChunk(filamat::ChunkType type, T* value) const noexcept;
 
     private:
         friend class MaterialParser;
 
+        // Either a copy of the package, or the mapping of a package file.
         class ManagedBuffer {
             void* mStart = nullptr;
             size_t mSize = 0;
+            bool mMapped = false;
         public:
             explicit ManagedBuffer(const void* start, size_t size)
                     : mStart(malloc(size)), mSize(size) {
                 memcpy(mStart, start, size);
             }
-            ~ManagedBuffer() noexcept { free(mStart); }
+            // empty if the file can't be read
+            explicit ManagedBuffer(utils::CString const& path) noexcept;
+            ~ManagedBuffer() noexcept;
             ManagedBuffer(ManagedBuffer const& rhs) = delete;
             ManagedBuffer& operator=(ManagedBuffer const& rhs) = delete;
             void* data() const noexcept { return mStart; }
@@ -171,7 +188,11 @@ private:
 
         // Keep MaterialChunk alive between calls to getShader to avoid reload the shader index.
         filaflat::MaterialChunk mMaterialChunk;
+        // Text dictionaries are small and hold lines shared by all shaders, they're read
+        // entirely. Binary dictionaries hold whole shaders that are decoded when requested.
         filaflat::BlobDictionary mBlobDictionary;
+        filaflat::DictionaryReader::BlobIndex mBlobIndex;
+        filamat::ChunkType mDictionaryTag = filamat::ChunkType::Unknown;
     };
 
     filaflat::ChunkContainer& getChunkContainer() noexcept;
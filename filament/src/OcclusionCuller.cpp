@@ -0,0 +1,310 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OcclusionCuller.h"
+
+#include <backend/DriverEnums.h>
+#include <backend/PixelBufferDescriptor.h>
+
+#include "private/backend/DriverApi.h"
+
+#include <utils/Systrace.h>
+#include <utils/debug.h>
+
+#include <math/vec4.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <utility>
+
+using namespace filament::math;
+
+namespace filament {
+
+using namespace backend;
+
+OcclusionCuller::OcclusionCuller()
+        : mSharedState(std::make_shared<SharedState>()) {
+}
+
+OcclusionCuller::~OcclusionCuller() noexcept = default;
+
+void OcclusionCuller::readback(DriverApi& driver, Handle<HwRenderTarget> target,
+        uint32_t width, uint32_t height, mat4 const& clipFromUserWorld) noexcept {
+    // at feature level 0 the picking buffer only has 8 bits of depth, which isn't enough
+    if (driver.getFeatureLevel() == FeatureLevel::FEATURE_LEVEL_0 ||
+            mSharedState->readbackPending) {
+        return;
+    }
+
+    struct Readback {
+        std::shared_ptr<SharedState> state;
+        std::unique_ptr<float2[]> pixels;
+        uint32_t width;
+        uint32_t height;
+        mat4 clipFromUserWorld;
+    };
+
+    size_t const count = size_t(width) * height;
+    auto* const readback = new Readback{ mSharedState, std::make_unique<float2[]>(count),
+            width, height, clipFromUserWorld };
+    mSharedState->readbackPending = true;
+
+    // The picking buffer holds the renderable's identity in its red channel and the depth in
+    // its green channel, from 1 at the near plane to 0 at infinity.
+    driver.readPixels(target, 0, 0, width, height, {
+            readback->pixels.get(), count * sizeof(float2),
+            PixelDataFormat::RG, PixelDataType::FLOAT,
+            [](void*, size_t, void* user) {
+                std::unique_ptr<Readback> const readback(static_cast<Readback*>(user));
+                Depth& depth = readback->state->depth;
+                size_t const count = size_t(readback->width) * readback->height;
+                depth.data.resize(count);
+                for (size_t i = 0; i < count; i++) {
+                    depth.data[i] = 1.0f - 2.0f * readback->pixels[i].y;
+                }
+                depth.width = readback->width;
+                depth.height = readback->height;
+                depth.clipFromUserWorld = readback->clipFromUserWorld;
+                readback->state->readbackPending = false;
+            }, readback
+    });
+}
+
+void OcclusionCuller::setDepth(float const* depth, uint32_t width, uint32_t height,
+        mat4 const& clipFromUserWorld) {
+    Depth& d = mSharedState->depth;
+    d.data.assign(depth, depth + size_t(width) * height);
+    d.width = width;
+    d.height = height;
+    d.clipFromUserWorld = clipFromUserWorld;
+}
+
+bool OcclusionCuller::prepare(mat4 const& clipFromUserWorld,
+        mat4f const& clipFromWorld) noexcept {
+    SYSTRACE_CALL();
+
+    Depth const& src = mSharedState->depth;
+    if (src.data.empty()) {
+        return false;
+    }
+
+    mClipFromWorld = clipFromWorld;
+
+    // The first level has half the resolution of the read back depth, which fills most of the
+    // holes left by the reprojection when the camera moves forward.
+    mLevels.clear();
+    uint32_t w = std::max(1u, (src.width + 1) / 2);
+    uint32_t h = std::max(1u, (src.height + 1) / 2);
+    uint32_t offset = 0;
+    while (true) {
+        mLevels.push_back({ offset, w, h });
+        offset += w * h;
+        if (w == 1 && h == 1) {
+            break;
+        }
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+    }
+    mPyramid.resize(offset);
+
+    constexpr float NO_DEPTH = -std::numeric_limits<float>::infinity();
+    constexpr float INFINITELY_FAR = std::numeric_limits<float>::infinity();
+
+    // The depth bounds of the first level start out unknown, i.e. covering the whole range.
+    // Texels where nothing was rendered become empty, unless some geometry lands there too.
+    constexpr float2 UNKNOWN_BOUNDS = { -std::numeric_limits<float>::infinity(),
+            std::numeric_limits<float>::infinity() };
+    constexpr float2 EMPTY_BOUNDS = { std::numeric_limits<float>::infinity(),
+            -std::numeric_limits<float>::infinity() };
+
+    // Phase one: reproject each texel of the read back depth, keeping the farthest depth that
+    // lands in each texel of the first level.
+    Level const& base = mLevels[0];
+    float* const UTILS_RESTRICT dst = mPyramid.data();
+    std::fill_n(dst, base.width * base.height, NO_DEPTH);
+    mBounds.assign(base.width * base.height, UNKNOWN_BOUNDS);
+    mat4f const reprojection{ clipFromUserWorld * inverse(src.clipFromUserWorld) };
+    float2 const texelSize = 2.0f / float2{ src.width, src.height };
+    for (uint32_t y = 0; y < src.height; y++) {
+        for (uint32_t x = 0; x < src.width; x++) {
+            float z = src.data[y * src.width + x];
+            // nothing was rendered there, we reproject the far plane to find where it's empty
+            bool const empty = !(z < 1.0f);
+            if (empty) {
+                z = 1.0f;
+            }
+            float2 const xy = (float2{ x, y } + 0.5f) * texelSize - 1.0f;
+            float4 const p = reprojection * float4{ xy, z, 1.0f };
+            if (!(p.w > 0.0f)) {
+                continue;
+            }
+            float3 const ndc = p.xyz / p.w;
+            if (!(ndc.x >= -1.0f && ndc.x < 1.0f && ndc.y >= -1.0f && ndc.y < 1.0f)) {
+                continue;
+            }
+            uint32_t const tx = std::min(base.width - 1,
+                    uint32_t((ndc.x * 0.5f + 0.5f) * float(base.width)));
+            uint32_t const ty = std::min(base.height - 1,
+                    uint32_t((ndc.y * 0.5f + 0.5f) * float(base.height)));
+            float2& b = mBounds[ty * base.width + tx];
+            if (empty) {
+                if (b == UNKNOWN_BOUNDS) {
+                    b = EMPTY_BOUNDS;
+                }
+                continue;
+            }
+            b = (b == UNKNOWN_BOUNDS) ? float2{ ndc.z } :
+                    float2{ std::min(b.x, ndc.z), std::max(b.y, ndc.z) };
+            float& d = dst[ty * base.width + tx];
+            d = std::max(d, ndc.z);
+        }
+    }
+    for (uint32_t i = 0, c = base.width * base.height; i < c; i++) {
+        if (dst[i] == NO_DEPTH) {
+            dst[i] = INFINITELY_FAR;
+        }
+    }
+
+    // build the rest of the pyramid, each texel holds the farthest of its (up to) 4 children
+    for (size_t level = 1; level < mLevels.size(); level++) {
+        Level const& parent = mLevels[level];
+        Level const& child = mLevels[level - 1];
+        for (uint32_t y = 0; y < parent.height; y++) {
+            uint32_t const y0 = 2 * y;
+            uint32_t const y1 = std::min(2 * y + 1, child.height - 1);
+            for (uint32_t x = 0; x < parent.width; x++) {
+                uint32_t const x0 = 2 * x;
+                uint32_t const x1 = std::min(2 * x + 1, child.width - 1);
+                dst[parent.offset + y * parent.width + x] = std::max(
+                        std::max(texel(level - 1, x0, y0), texel(level - 1, x1, y0)),
+                        std::max(texel(level - 1, x0, y1), texel(level - 1, x1, y1)));
+            }
+        }
+    }
+    return true;
+}
+
+void OcclusionCuller::getDepthBounds(float2* UTILS_RESTRICT bounds,
+        uint32_t countX, uint32_t countY, float2 tileSize,
+        mat4f const& viewFromClip) const noexcept {
+    SYSTRACE_CALL();
+    assert_invariant(!mLevels.empty());
+
+    constexpr float INF = std::numeric_limits<float>::infinity();
+
+    // view-space z of a depth, which doesn't depend on x and y for our projections
+    auto toViewSpace = [&viewFromClip](float z) {
+        float4 const p = viewFromClip * float4{ 0.0f, 0.0f, z, 1.0f };
+        return p.w != 0.0f ? p.z / p.w : -INF;
+    };
+
+    // the texels that intersect each tile
+    Level const& base = mLevels[0];
+    auto texels = [](uint32_t i, float size, uint32_t count) {
+        uint32_t const begin = uint32_t(float(i) * size * float(count));
+        uint32_t const end = uint32_t(std::ceil(float(i + 1) * size * float(count)));
+        return std::pair{ std::min(begin, count), std::min(std::max(end, begin + 1), count) };
+    };
+
+    for (uint32_t ty = 0; ty < countY; ty++) {
+        auto const [y0, y1] = texels(ty, tileSize.y, base.height);
+        for (uint32_t tx = 0; tx < countX; tx++) {
+            auto const [x0, x1] = texels(tx, tileSize.x, base.width);
+            float2 b = { INF, -INF };
+            for (uint32_t y = y0; y < y1; y++) {
+                for (uint32_t x = x0; x < x1; x++) {
+                    float2 const t = mBounds[y * base.width + x];
+                    b = float2{ std::min(b.x, t.x), std::max(b.y, t.y) };
+                }
+            }
+            float2& out = bounds[ty * countX + tx];
+            if (b.x > b.y) {
+                // no geometry in this tile
+                out = { -INF, 0.0f };
+            } else if (b.x == -INF) {
+                // some of this tile's depth is unknown
+                out = { 0.0f, -INF };
+            } else {
+                out = { toViewSpace(b.x), toViewSpace(b.y) };
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::isOccluded(float3 const& center, float3 const& extent) const noexcept {
+    assert_invariant(!mLevels.empty());
+
+    // find the screen-space rectangle and the nearest depth of the box
+    float2 lo{ std::numeric_limits<float>::max() };
+    float2 hi{ std::numeric_limits<float>::lowest() };
+    float nearest = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < 8; i++) {
+        float3 const corner = center + extent * float3{
+                (i & 1u) ? 1.0f : -1.0f, (i & 2u) ? 1.0f : -1.0f, (i & 4u) ? 1.0f : -1.0f };
+        float4 const p = mClipFromWorld * float4{ corner, 1.0f };
+        if (!(p.w > 0.0f)) {
+            // the box extends behind the camera
+            return false;
+        }
+        float3 const ndc = p.xyz / p.w;
+        lo = min(lo, ndc.xy);
+        hi = max(hi, ndc.xy);
+        nearest = std::min(nearest, ndc.z);
+    }
+
+    lo = clamp(lo * 0.5f + 0.5f, 0.0f, 1.0f);
+    hi = clamp(hi * 0.5f + 0.5f, 0.0f, 1.0f);
+    Level const& base = mLevels[0];
+    uint32_t x0 = std::min(base.width - 1, uint32_t(lo.x * float(base.width)));
+    uint32_t y0 = std::min(base.height - 1, uint32_t(lo.y * float(base.height)));
+    uint32_t x1 = std::min(base.width - 1, uint32_t(hi.x * float(base.width)));
+    uint32_t y1 = std::min(base.height - 1, uint32_t(hi.y * float(base.height)));
+
+    // pick the level where the rectangle covers at most 2x2 texels
+    size_t level = 0;
+    while (level + 1 < mLevels.size() && (x1 - x0 > 1 || y1 - y0 > 1)) {
+        x0 >>= 1u;
+        y0 >>= 1u;
+        x1 >>= 1u;
+        y1 >>= 1u;
+        level++;
+    }
+
+    float farthest = std::numeric_limits<float>::lowest();
+    for (uint32_t y = y0; y <= y1; y++) {
+        for (uint32_t x = x0; x <= x1; x++) {
+            farthest = std::max(farthest, texel(level, x, y));
+        }
+    }
+    return nearest > farthest;
+}
+
+void OcclusionCuller::intersects(Culler::result_type* UTILS_RESTRICT results,
+        float3 const* UTILS_RESTRICT center, float3 const* UTILS_RESTRICT extent,
+        size_t count, size_t bit) const noexcept {
+    SYSTRACE_CALL();
+    Culler::result_type const mask = Culler::result_type(1u << bit);
+    for (size_t i = 0; i < count; i++) {
+        if ((results[i] & mask) && isOccluded(center[i], extent[i])) {
+            results[i] &= ~mask;
+        }
+    }
+}
+
+} // namespace filament
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_OCCLUSIONCULLER_H
+#define TNT_FILAMENT_OCCLUSIONCULLER_H
+
+#include "Culler.h"
+
+#include <backend/DriverApiForward.h>
+#include <backend/Handle.h>
+
+#include <math/mat4.h>
+#include <math/vec2.h>
+#include <math/vec3.h>
+
+#include <memory>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+/*
+ * Occlusion culling against a hierarchical depth buffer (Hi-Z), on the CPU.
+ *
+ * The depth of a previous frame is read back asynchronously from the picking buffer of the
+ * structure pass (see readback()). On each frame, prepare() reprojects the latest of these
+ * depth buffers to the current camera and builds a pyramid where each texel holds the farthest
+ * depth of the texels it covers. intersects() then rejects the bounding boxes that lie entirely
+ * behind that depth.
+ *
+ * Texels that no longer have depth information after the reprojection (e.g. because they
+ * were disoccluded by the camera motion) are treated as infinitely far, so the test stays
+ * conservative for static scenes. Moving occluders can hide renderables for the one or two
+ * frames it takes for the read back depth to catch up.
+ *
+ * The same reprojected depth also gives the depth range of the geometry in screen tiles, see
+ * getDepthBounds().
+ */
+class OcclusionCuller {
+public:
+    OcclusionCuller();
+    ~OcclusionCuller() noexcept;
+
+    OcclusionCuller(OcclusionCuller const&) = delete;
+    OcclusionCuller& operator=(OcclusionCuller const&) = delete;
+
+    // Reads back the given RG32F picking target, whose depth was rendered with the given
+    // clip-from-world transform (in user world space). Only one read back is in flight at any
+    // given time, so this does nothing if the previous one hasn't completed yet.
+    void readback(backend::DriverApi& driver, backend::Handle<backend::HwRenderTarget> target,
+            uint32_t width, uint32_t height, math::mat4 const& clipFromUserWorld) noexcept;
+
+    // Phase one: builds the depth pyramid for the current camera. clipFromUserWorld is used to
+    // reproject the read back depth, while clipFromWorld is used by the occlusion test, i.e. it
+    // must transform the bounding boxes given to intersects() to clip space.
+    // Returns false if no depth is available yet.
+    bool prepare(math::mat4 const& clipFromUserWorld, math::mat4f const& clipFromWorld) noexcept;
+
+    // Phase two: clears the given bit of results[i] for each renderable that has it set and
+    // whose bounding box is occluded. prepare() must have returned true.
+    void intersects(Culler::result_type* results,
+            math::float3 const* center, math::float3 const* extent,
+            size_t count, size_t bit) const noexcept;
+
+    // Returns whether the given box is entirely behind the depth pyramid.
+    bool isOccluded(math::float3 const& center, math::float3 const& extent) const noexcept;
+
+    // Computes the view-space z range {nearest, farthest} of the geometry in each tile of a
+    // countX x countY grid, where tiles have the given size in [0, 1] screen coordinates and the
+    // grid starts at the bottom left. Tiles without geometry get an empty range, i.e.
+    // nearest < farthest, and tiles with texels that have no depth information get the
+    // whole range {0, -inf}. viewFromClip is the inverse of the projection given to prepare().
+    // prepare() must have returned true.
+    void getDepthBounds(math::float2* bounds, uint32_t countX, uint32_t countY,
+            math::float2 tileSize, math::mat4f const& viewFromClip) const noexcept;
+
+    // Low level access for tests: sets the depth otherwise obtained by readback(). Depth values
+    // are in OpenGL's normalized device coordinates, i.e. -1 at the near plane, 1 at the far
+    // plane, and the rows are stored bottom to top.
+    void setDepth(float const* depth, uint32_t width, uint32_t height,
+            math::mat4 const& clipFromUserWorld);
+
+private:
+    struct Depth {
+        std::vector<float> data;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        math::mat4 clipFromUserWorld;
+    };
+
+    // This is shared with the read back callbacks, which can outlive us.
+    struct SharedState {
+        Depth depth;
+        bool readbackPending = false;
+    };
+
+    struct Level {
+        uint32_t offset;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    float texel(size_t level, uint32_t x, uint32_t y) const noexcept {
+        Level const& l = mLevels[level];
+        return mPyramid[l.offset + y * l.width + x];
+    }
+
+    std::shared_ptr<SharedState> mSharedState;
+    std::vector<float> mPyramid;
+    std::vector<Level> mLevels;
+    // {nearest, farthest} depth of each texel of the first level, see prepare()
+    std::vector<math::float2> mBounds;
+    math::mat4f mClipFromWorld;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_OCCLUSIONCULLER_H
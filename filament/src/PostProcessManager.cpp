@@ -111,35 +111,29 @@ constexpr static float halton(unsigned int i, unsigned int b) noexcept {
 // ------------------------------------------------------------------------------------------------
 
 PostProcessManager::PostProcessMaterial::PostProcessMaterial() noexcept {
-    mMaterial = nullptr; // aliased to mData
-    mData = nullptr;
+    mMaterial = nullptr; // aliased to mInfo
+    mInfo = nullptr;
 }
 
 PostProcessManager::PostProcessMaterial::PostProcessMaterial(MaterialInfo const& info) noexcept
         : PostProcessMaterial() {
-    mData = info.data; // aliased to mMaterial
-    mSize = info.size;
-    mConstants = info.constants;
+    mInfo = &info; // aliased to mMaterial
 }
 
 PostProcessManager::PostProcessMaterial::PostProcessMaterial(
         PostProcessManager::PostProcessMaterial&& rhs) noexcept
         : PostProcessMaterial() {
     using namespace std;
-    swap(mData, rhs.mData); // aliased to mMaterial
-    swap(mSize, rhs.mSize);
+    swap(mInfo, rhs.mInfo); // aliased to mMaterial
     swap(mHasMaterial, rhs.mHasMaterial);
-    swap(mConstants, rhs.mConstants);
 }
 
 PostProcessManager::PostProcessMaterial& PostProcessManager::PostProcessMaterial::operator=(
         PostProcessManager::PostProcessMaterial&& rhs) noexcept {
     if (this != &rhs) {
         using namespace std;
-        swap(mData, rhs.mData); // aliased to mMaterial
-        swap(mSize, rhs.mSize);
+        swap(mInfo, rhs.mInfo); // aliased to mMaterial
         swap(mHasMaterial, rhs.mHasMaterial);
-        swap(mConstants, rhs.mConstants);
     }
     return *this;
 }
@@ -156,7 +150,7 @@ void PostProcessManager::PostProcessMaterial::terminate(FEngine& engine) noexcep
         mMaterial = nullptr;
         mHasMaterial = false;
     } else {
-        mData = nullptr;
+        mInfo = nullptr;
 #endif
     }
 }
@@ -165,10 +159,11 @@ UTILS_NOINLINE
 void PostProcessManager::PostProcessMaterial::loadMaterial(FEngine& engine) const noexcept {
     // TODO: After all materials using this class have been converted to the post-process material
     //       domain, load both OPAQUE and TRANSPARENT variants here.
+    MaterialInfo const* const info = mInfo;
     mHasMaterial = true;
     auto builder = Material::Builder();
-    builder.package(mData, mSize);
-    for (auto const& constant: mConstants) {
+    builder.package(info->data, info->size);
+    for (auto const& constant: info->constants) {
         std::visit([&](auto&& arg) {
             builder.constant(constant.name.data(), constant.name.size(), arg);
         }, constant.value);
@@ -329,6 +324,10 @@ void PostProcessManager::init() noexcept {
     mWorkaroundAllowReadOnlyAncillaryFeedbackLoop =
             driver.isWorkaroundNeeded(Workaround::ALLOW_READ_ONLY_ANCILLARY_FEEDBACK_LOOP);
 
+    // Registering a material only records where its package is, the material itself is created
+    // the first time it's used.
+    mMaterialRegistry.reserve(std::size(sMaterialListFeatureLevel0) + std::size(sMaterialList));
+
     #pragma nounroll
     for (auto const& info: sMaterialListFeatureLevel0) {
         registerPostProcessMaterial(info.name, info);
@@ -536,7 +535,8 @@ FrameGraphId<FrameGraphTexture> PostProcessManager::ssr(FrameGraph& fg,
         PerViewUniforms& uniforms,
         FrameGraphId<FrameGraphTexture> structure,
         ScreenSpaceReflectionsOptions const& options,
-        FrameGraphTexture::Descriptor const& desc) noexcept {
+        FrameGraphTexture::Descriptor const& desc,
+        filament::Viewport const& logicalViewport) noexcept {
 
     struct SSRPassData {
         // our output, the reflection map
@@ -593,8 +593,11 @@ FrameGraphId<FrameGraphTexture> PostProcessManager::ssr(FrameGraph& fg,
             },
             [this, projection = cameraInfo.projection,
                     userViewMatrix = cameraInfo.getUserViewMatrix(), uvFromClipMatrix, historyProjection,
-                    options, &uniforms, passBuilder = passBuilder]
+                    options, &uniforms, passBuilder = passBuilder, desc, logicalViewport]
             (FrameGraphResources const& resources, auto const& data, DriverApi& driver) mutable {
+                // the reflections can be rendered at a lower resolution than the color pass
+                uniforms.prepareViewport({ 0, 0, desc.width, desc.height }, logicalViewport);
+
                 // set structure sampler
                 uniforms.prepareStructure(data.structure ?
                         resources.getTexture(data.structure) : getOneTexture());
@@ -633,7 +636,8 @@ FrameGraphId<FrameGraphTexture> PostProcessManager::ssr(FrameGraph& fg,
 FrameGraphId<FrameGraphTexture> PostProcessManager::screenSpaceAmbientOcclusion(FrameGraph& fg,
         filament::Viewport const&, const CameraInfo& cameraInfo,
         FrameGraphId<FrameGraphTexture> depth,
-        AmbientOcclusionOptions const& options) noexcept {
+        AmbientOcclusionOptions const& options,
+        bool temporalSampling, uint32_t frameId) noexcept {
     assert_invariant(depth);
 
     const size_t levelCount = fg.getDescriptor(depth).levels;
@@ -674,6 +678,14 @@ FrameGraphId<FrameGraphTexture> PostProcessManager::screenSpaceAmbientOcclusion(
             break;
     }
 
+    if (temporalSampling) {
+        // Consecutive frames sample different turns of the spiral and TAA accumulates them, so
+        // half the samples are enough. The offset follows a low-discrepancy sequence so that
+        // any few consecutive frames cover the spiral evenly.
+        sampleCount = std::ceil(sampleCount * 0.5f);
+        spiralTurns += halton(frameId % 16u, 2);
+    }
+
     switch (options.lowPassFilter) {
         default:
         case QualityLevel::LOW:
@@ -1402,7 +1414,8 @@ FrameGraphId<FrameGraphTexture> PostProcessManager::dof(FrameGraph& fg,
         const CameraInfo& cameraInfo,
         bool translucent,
         float2 bokehScale,
-        const DepthOfFieldOptions& dofOptions) noexcept {
+        const DepthOfFieldOptions& dofOptions,
+        float2 visibleDistanceRange) noexcept {
 
     assert_invariant(depth);
 
@@ -1496,6 +1509,23 @@ FrameGraphId<FrameGraphTexture> PostProcessManager::dof(FrameGraph& fg,
     const float Ks = ((float)desc.height) / FCamera::SENSOR_SIZE;
     const float K  = dofOptions.cocScale * Ks * Kc;
 
+    /*
+     * The CoC is monotonic with the distance, so its extrema are reached at the nearest and
+     * farthest visible distances. When they're both below half a pixel, nothing would be blurred
+     * and we skip all the DoF passes. Nothing is visible before the near plane.
+     */
+    const float2 cocClamp = {
+            -(dofOptions.maxForegroundCOC ? dofOptions.maxForegroundCOC : DOF_DEFAULT_MAX_COC),
+              dofOptions.maxBackgroundCOC ? dofOptions.maxBackgroundCOC : DOF_DEFAULT_MAX_COC };
+    auto cocAtDistance = [=](float d) {
+        float const coc = std::isinf(d) ? K : K * (1.0f - focusDistance / d);
+        return std::abs(clamp(coc, cocClamp.x, cocClamp.y));
+    };
+    if (std::max(cocAtDistance(std::max(visibleDistanceRange.x, cameraInfo.zn)),
+            cocAtDistance(visibleDistanceRange.y)) < 0.5f) {
+        return input;
+    }
+
     auto const& p = cameraInfo.projection;
     const float2 cocParams = {
               K * focusDistance * p[2][3] / p[3][2],
@@ -1567,9 +1597,7 @@ FrameGraphId<FrameGraphTexture> PostProcessManager::dof(FrameGraph& fg,
                 mi->setParameter("color", color, { .filterMin = SamplerMinFilter::NEAREST });
                 mi->setParameter("depth", depth, { .filterMin = SamplerMinFilter::NEAREST });
                 mi->setParameter("cocParams", cocParams);
-                mi->setParameter("cocClamp", float2{
-                    -(dofOptions.maxForegroundCOC ? dofOptions.maxForegroundCOC : DOF_DEFAULT_MAX_COC),
-                      dofOptions.maxBackgroundCOC ? dofOptions.maxBackgroundCOC : DOF_DEFAULT_MAX_COC});
+                mi->setParameter("cocClamp", cocClamp);
                 mi->setParameter("texelSize", float2{
                         1.0f / float(colorDesc.width),
                         1.0f / float(colorDesc.height) });
@@ -3238,62 +3266,75 @@ FrameGraphId<FrameGraphTexture> PostProcessManager::resolveDepth(FrameGraph& fg,
 }
 
 FrameGraphId<FrameGraphTexture> PostProcessManager::vsmMipmapPass(FrameGraph& fg,
-        FrameGraphId<FrameGraphTexture> input, uint8_t layer, size_t level,
-        math::float4 clearColor, bool finalize) noexcept {
+        FrameGraphId<FrameGraphTexture> input, utils::bitset64 layers, size_t levels,
+        math::float4 clearColor) noexcept {
+
+    assert_invariant(levels > 1);
 
+    // One pass generates the whole mip chain of every layer, instead of one pass per layer and
+    // level. Each level is still its own render target, because it samples the level above.
     struct VsmMipData {
         FrameGraphId<FrameGraphTexture> in;
+        FixedCapacityVector<uint32_t> rt; // (levels - 1) render targets per layer
     };
 
     auto& depthMipmapPass = fg.addPass<VsmMipData>("VSM Generate Mipmap Pass",
             [&](FrameGraph::Builder& builder, auto& data) {
                 const char* name = builder.getName(input);
                 data.in = builder.sample(input);
-
-                auto out = builder.createSubresource(data.in, "Mip level", {
-                        .level = uint8_t(level + 1), .layer = layer });
-
-                out = builder.write(out, FrameGraphTexture::Usage::COLOR_ATTACHMENT);
-                builder.declareRenderPass(name, {
-                    .attachments = { .color = { out }},
-                    .clearColor = clearColor,
-                    .clearFlags = TargetBufferFlags::COLOR
+                data.rt.reserve(layers.count() * (levels - 1));
+                layers.forEachSetBit([&](size_t layer) {
+                    for (size_t level = 0; level < levels - 1; level++) {
+                        auto out = builder.createSubresource(data.in, "Mip level", {
+                                .level = uint8_t(level + 1), .layer = uint8_t(layer) });
+
+                        out = builder.write(out, FrameGraphTexture::Usage::COLOR_ATTACHMENT);
+                        data.rt.push_back(builder.declareRenderPass(name, {
+                                .attachments = { .color = { out }},
+                                .clearColor = clearColor,
+                                .clearFlags = TargetBufferFlags::COLOR
+                        }));
+                    }
                 });
             },
             [=](FrameGraphResources const& resources,
                     auto const& data, DriverApi& driver) {
 
                 auto in = resources.getTexture(data.in);
-                auto out = resources.getRenderPassInfo();
 
                 auto const& inDesc = resources.getDescriptor(data.in);
                 auto width = inDesc.width;
                 assert_invariant(width == inDesc.height);
-                int const dim = width >> (level + 1);
-
-                driver.setMinMaxLevels(in, level, level);
 
                 auto& material = getPostProcessMaterial("vsmMipmap");
-
-                // When generating shadow map mip levels, we want to preserve the 1 texel border.
-                // (note clearing never respects the scissor in Filament)
-                auto const [pipeline, _] = material.getPipelineState(mEngine);
-                backend::Viewport const scissor = { 1u, 1u, dim - 2u, dim - 2u };
-
+                auto const pipeline = material.getPipelineState(mEngine).first;
                 FMaterialInstance* const mi = material.getMaterialInstance(mEngine);
                 mi->setParameter("color", in, {
                         .filterMag = SamplerMagFilter::LINEAR,
                         .filterMin = SamplerMinFilter::LINEAR_MIPMAP_NEAREST
                 });
-                mi->setParameter("layer", uint32_t(layer));
-                mi->setParameter("uvscale", 1.0f / float(dim));
-                mi->commit(driver);
-                mi->use(driver);
-                render(out, pipeline, scissor, driver);
 
-                if (finalize) {
-                   driver.setMinMaxLevels(in, 0, level);
-                }
+                size_t rt = 0;
+                layers.forEachSetBit([&](size_t layer) {
+                    for (size_t level = 0; level < levels - 1; level++) {
+                        auto out = resources.getRenderPassInfo(data.rt[rt++]);
+                        int const dim = width >> (level + 1);
+
+                        driver.setMinMaxLevels(in, level, level);
+
+                        // When generating shadow map mip levels, we want to preserve the 1 texel
+                        // border. (note clearing never respects the scissor in Filament)
+                        backend::Viewport const scissor = { 1u, 1u, dim - 2u, dim - 2u };
+
+                        mi->setParameter("layer", uint32_t(layer));
+                        mi->setParameter("uvscale", 1.0f / float(dim));
+                        mi->commit(driver);
+                        mi->use(driver);
+                        render(out, pipeline, scissor, driver);
+                    }
+                });
+
+                driver.setMinMaxLevels(in, 0, levels - 1);
             });
 
     return depthMipmapPass->in;
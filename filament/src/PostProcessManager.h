@@ -32,11 +32,13 @@
 #include <private/filament/Variant.h>
 
 #include <utils/CString.h>
+#include <utils/bitset.h>
 #include <utils/FixedCapacityVector.h>
 
 #include <tsl/robin_map.h>
 
 #include <array>
+#include <limits>
 #include <random>
 #include <string_view>
 #include <variant>
@@ -111,13 +113,17 @@ public:
             PerViewUniforms& uniforms,
             FrameGraphId<FrameGraphTexture> structure,
             ScreenSpaceReflectionsOptions const& options,
-            FrameGraphTexture::Descriptor const& desc) noexcept;
+            FrameGraphTexture::Descriptor const& desc,
+            filament::Viewport const& logicalViewport) noexcept;
 
     // SSAO
+    // With temporalSampling, half the samples are taken, on a spiral that depends on frameId,
+    // for the TAA history to accumulate.
     FrameGraphId<FrameGraphTexture> screenSpaceAmbientOcclusion(FrameGraph& fg,
             filament::Viewport const& svp, const CameraInfo& cameraInfo,
             FrameGraphId<FrameGraphTexture> structure,
-            AmbientOcclusionOptions const& options) noexcept;
+            AmbientOcclusionOptions const& options,
+            bool temporalSampling = false, uint32_t frameId = 0) noexcept;
 
     // Gaussian mipmap
     FrameGraphId<FrameGraphTexture> generateGaussianMipmap(FrameGraph& fg,
@@ -165,7 +171,9 @@ public:
             const CameraInfo& cameraInfo,
             bool translucent,
             math::float2 bokehScale,
-            const DepthOfFieldOptions& dofOptions) noexcept;
+            const DepthOfFieldOptions& dofOptions,
+            math::float2 visibleDistanceRange = { 0.0f, std::numeric_limits<float>::infinity() }
+            ) noexcept;
 
     // Bloom
     struct BloomPassOutput {
@@ -273,10 +281,10 @@ public:
             const char* outputBufferName, FrameGraphId<FrameGraphTexture> input,
             FrameGraphTexture::Descriptor outDesc) noexcept;
 
-    // VSM shadow mipmap pass
+    // VSM shadow mipmap pass: generates all the levels of each of the given layers
     FrameGraphId<FrameGraphTexture> vsmMipmapPass(FrameGraph& fg,
-            FrameGraphId<FrameGraphTexture> input, uint8_t layer, size_t level,
-            math::float4 clearColor, bool finalize) noexcept;
+            FrameGraphId<FrameGraphTexture> input, utils::bitset64 layers, size_t levels,
+            math::float4 clearColor) noexcept;
 
     FrameGraphId<FrameGraphTexture> gaussianBlurPass(FrameGraph& fg,
             FrameGraphId<FrameGraphTexture> input,
@@ -309,7 +317,9 @@ public:
     class PostProcessMaterial {
     public:
         PostProcessMaterial() noexcept;
-        PostProcessMaterial(MaterialInfo const& info) noexcept;
+        // The MaterialInfo must outlive this object, it is only read when the material is
+        // first needed.
+        explicit PostProcessMaterial(MaterialInfo const& info) noexcept;
 
         PostProcessMaterial(PostProcessMaterial const& rhs) = delete;
         PostProcessMaterial& operator=(PostProcessMaterial const& rhs) = delete;
@@ -332,11 +342,9 @@ public:
 
         union {
             mutable FMaterial* mMaterial;
-            uint8_t const* mData;
+            MaterialInfo const* mInfo;
         };
-        uint32_t mSize{};
         mutable bool mHasMaterial{};
-        utils::FixedCapacityVector<ConstantInfo> mConstants{};
     };
 
     void registerPostProcessMaterial(std::string_view name, MaterialInfo const& info);
@@ -41,6 +41,7 @@
 
 #include <utils/compiler.h>
 #include <utils/debug.h>
+#include <utils/Hash.h>
 #include <utils/JobSystem.h>
 #include <utils/Panic.h>
 #include <utils/Slice.h>
@@ -132,15 +133,20 @@ RenderPass::RenderPass(FEngine& engine, RenderPassBuilder const& builder) noexce
     mCommandBegin = curr;
     mCommandEnd = curr + commandCount + customCommandCount;
 
-    appendCommands(engine, { curr, commandCount },
-            builder.mUboHandle,
-            builder.mVisibleRenderables,
-            builder.mCommandTypeFlags,
-            builder.mFlags,
-            builder.mVisibilityMask,
-            builder.mVariant,
-            builder.mCameraPosition,
-            builder.mCameraForwardVector);
+    {
+        FrameTimingsRecorder::Scope const timing(engine.getFrameTimingsRecorder(),
+                FrameTimingsRecorder::Stage::COMMAND_GENERATION);
+        appendCommands(engine, { curr, commandCount },
+                builder.mUboHandle,
+                builder.mVisibleRenderables,
+                builder.mCommandTypeFlags,
+                builder.mFlags | (engine.isAutomaticInstancingEnabled() ?
+                        HAS_AUTOMATIC_INSTANCING : RenderFlags(0)),
+                builder.mVisibilityMask,
+                builder.mVariant,
+                builder.mCameraPosition,
+                builder.mCameraForwardVector);
+    }
 
     if (builder.mCustomCommands.has_value()) {
         Command* p = curr + commandCount;
@@ -150,7 +156,11 @@ RenderPass::RenderPass(FEngine& engine, RenderPassBuilder const& builder) noexce
     }
 
     // sort commands once we're done adding commands
-    sortCommands(builder.mArena);
+    {
+        FrameTimingsRecorder::Scope const timing(engine.getFrameTimingsRecorder(),
+                FrameTimingsRecorder::Stage::COMMAND_SORTING);
+        sortCommands(engine, builder.mArena, builder.mSortCache);
+    }
 
     if (engine.isAutomaticInstancingEnabled()) {
         uint32_t stereoscopicEyeCount = 1;
@@ -260,10 +270,161 @@ void RenderPass::appendCustomCommand(Command* commands,
     commands->key = cmd;
 }
 
-void RenderPass::sortCommands(Arena& arena) noexcept {
+namespace {
+
+// We sort the keys along with the index of their command, which is much cheaper than
+// moving the 64 bytes commands around, and only then move each command to its place.
+struct SortItem {
+    RenderPass::CommandKey key;
+    uint32_t index;
+    bool operator<(SortItem const& rhs) const noexcept {
+        return key < rhs.key || (key == rhs.key && index < rhs.index);
+    }
+};
+
+// Below this number of commands, std::sort is faster than the radix sort.
+constexpr uint32_t RADIX_SORT_THRESHOLD = 1024;
+
+// Number of commands each job of the radix sort handles, we only go wide for large passes.
+constexpr uint32_t JOBS_PARALLEL_FOR_SORTING_COUNT = 32768;
+constexpr uint32_t RADIX_SORT_MAX_CHUNK_COUNT = 32;
+
+constexpr unsigned RADIX_BITS = 8;
+constexpr uint32_t RADIX_SIZE = 1u << RADIX_BITS;
+
+// LSD radix sort of the items by key, one byte at a time. The sort is stable, so items with the
+// same key stay ordered by index if they initially were. The items are split in chunkCount
+// chunks that are counted and scattered in parallel; histograms must hold
+// chunkCount * RADIX_SIZE entries. Returns the buffer holding the result, items or temp.
+SortItem* radixSort(JobSystem& js, SortItem* items, SortItem* temp, uint32_t count,
+        uint32_t chunkCount, uint32_t* UTILS_RESTRICT histograms) noexcept {
+    uint32_t const chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    auto forEachChunk = [&js, chunkCount](auto const& functor) {
+        if (chunkCount == 1) {
+            functor(0, 1);
+            return;
+        }
+        auto* job = jobs::parallel_for(js, nullptr, 0, chunkCount, std::cref(functor),
+                jobs::CountSplitter<1>());
+        js.runAndWait(job);
+    };
+
+    for (unsigned shift = 0; shift < 64; shift += RADIX_BITS) {
+        SortItem const* const UTILS_RESTRICT src = items;
+        SortItem* const UTILS_RESTRICT dst = temp;
+
+        forEachChunk([=](uint32_t first, uint32_t n) {
+            for (uint32_t chunk = first; chunk < first + n; chunk++) {
+                uint32_t* const UTILS_RESTRICT h = histograms + chunk * RADIX_SIZE;
+                std::fill_n(h, RADIX_SIZE, 0u);
+                for (uint32_t i = chunk * chunkSize, e = std::min(count, i + chunkSize);
+                        i < e; i++) {
+                    h[(src[i].key >> shift) & (RADIX_SIZE - 1)]++;
+                }
+            }
+        });
+
+        // Turn the histograms into the offset of each chunk's first item in each bucket. When
+        // all items fall in the same bucket, which is common for the high bits of the key, the
+        // pass would leave the order unchanged, so we skip it.
+        bool trivial = false;
+        uint32_t offset = 0;
+        for (uint32_t b = 0; b < RADIX_SIZE; b++) {
+            uint32_t const bucketBegin = offset;
+            for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+                uint32_t const n = histograms[chunk * RADIX_SIZE + b];
+                histograms[chunk * RADIX_SIZE + b] = offset;
+                offset += n;
+            }
+            trivial = trivial || (offset - bucketBegin == count);
+        }
+        if (trivial) {
+            continue;
+        }
+
+        forEachChunk([=](uint32_t first, uint32_t n) {
+            for (uint32_t chunk = first; chunk < first + n; chunk++) {
+                uint32_t* const UTILS_RESTRICT h = histograms + chunk * RADIX_SIZE;
+                for (uint32_t i = chunk * chunkSize, e = std::min(count, i + chunkSize);
+                        i < e; i++) {
+                    dst[h[(src[i].key >> shift) & (RADIX_SIZE - 1)]++] = src[i];
+                }
+            }
+        });
+        std::swap(items, temp);
+    }
+    return items;
+}
+
+} // anonymous namespace
+
+void RenderPass::sortCommands(FEngine& engine, Arena& arena, SortCache* cache) noexcept {
     SYSTRACE_NAME("sort and trim commands");
 
-    std::sort(mCommandBegin, mCommandEnd);
+    uint32_t const count = uint32_t(mCommandEnd - mCommandBegin);
+    SortItem* items = arena.alloc<SortItem>(count);
+    assert_invariant(items);
+
+    // When the commands are the same as in the previous frame, which is common when only
+    // transforms have changed, last frame's order is still sorted and we can skip the sort.
+    // Equal keys must also still be ordered by index, so that the result is exactly the one
+    // of a full sort.
+    bool sorted = false;
+    if (cache && cache->order.size() == count) {
+        uint32_t const* const order = cache->order.data();
+        for (uint32_t i = 0; i < count; i++) {
+            items[i] = { mCommandBegin[order[i]].key, order[i] };
+        }
+        sorted = std::is_sorted(items, items + count);
+    } else {
+        for (uint32_t i = 0; i < count; i++) {
+            items[i] = { mCommandBegin[i].key, i };
+        }
+    }
+
+    if (!sorted) {
+        if (count < RADIX_SORT_THRESHOLD) {
+            std::sort(items, items + count);
+        } else {
+            // the radix sort is stable, so ties stay ordered by index like with std::sort
+            for (uint32_t i = 0; i < count; i++) {
+                items[i] = { mCommandBegin[i].key, i };
+            }
+            uint32_t const chunkCount = std::clamp(count / JOBS_PARALLEL_FOR_SORTING_COUNT,
+                    1u, RADIX_SORT_MAX_CHUNK_COUNT);
+            SortItem* const temp = arena.alloc<SortItem>(count);
+            uint32_t* const histograms = arena.alloc<uint32_t>(chunkCount * RADIX_SIZE);
+            assert_invariant(temp && histograms);
+            items = radixSort(engine.getJobSystem(), items, temp, count, chunkCount, histograms);
+        }
+        if (cache) {
+            cache->order.resize(count);
+            for (uint32_t i = 0; i < count; i++) {
+                cache->order[i] = items[i].index;
+            }
+        }
+    }
+
+    // Move each command to its sorted position by following the cycles of the permutation.
+    // Each command is moved at most once, and the indices are reset as the commands land.
+    for (uint32_t i = 0; i < count; i++) {
+        if (items[i].index == i) {
+            continue;
+        }
+        Command const temp = mCommandBegin[i];
+        uint32_t j = i;
+        while (true) {
+            uint32_t const k = items[j].index;
+            items[j].index = j;
+            if (k == i) {
+                mCommandBegin[j] = temp;
+                break;
+            }
+            mCommandBegin[j] = mCommandBegin[k];
+            j = k;
+        }
+    }
 
     // find the last command
     Command const* const last = std::partition_point(mCommandBegin, mCommandEnd,
@@ -284,16 +445,24 @@ void RenderPass::execute(RenderPass const& pass,
     driver.endRenderPass();
 }
 
+RenderPass::CommandKey RenderPass::makeGeometryHash(PrimitiveInfo const& info) noexcept {
+    uint32_t const words[] = {
+            info.rph.getId(), info.vbih.getId(),
+            info.indexOffset, info.indexCount,
+            info.rasterState.u };
+    uint32_t const h = hash::murmur3(words, sizeof(words) / sizeof(words[0]), 0);
+    return makeField((h ^ (h >> 16u)) & 0xFFFFu, GEOMETRY_HASH_MASK, GEOMETRY_HASH_SHIFT);
+}
+
 void RenderPass::instanceify(FEngine& engine, Arena& arena, int32_t eyeCount) noexcept {
     SYSTRACE_NAME("instanceify");
 
     // instanceify works by scanning the **sorted** command stream, looking for repeat draw
     // commands. When one is found, it is replaced by an instanced command.
     // A "repeat" draw is one that ends-up using the same draw parameters and state.
-    // Currently, this relies somewhat on luck that "repeat draws" are found consecutively,
-    // we could improve this by including some or all of these "repeat" parameters in the
-    // sorting key (e.g. raster state, primitive handle, etc...), the key could even use a small
-    // hash of those parameters.
+    // The sort key of the commands that can be instanced holds a hash of these parameters
+    // (see makeGeometryHash()), so repeat draws are found consecutively, except for hash
+    // collisions.
 
     UTILS_UNUSED uint32_t drawCallsSavedCount = 0;
 
@@ -341,15 +510,6 @@ void RenderPass::instanceify(FEngine& engine, Arena& arena, int32_t eyeCount) no
 
             // allocate our staging buffer only if needed
             if (UTILS_UNLIKELY(!stagingBuffer)) {
-
-                // create a temporary UBO for instancing
-                size_t const count = mCommandEnd - mCommandBegin;
-                mInstancedUboHandle = BufferObjectSharedHandle{
-                        engine.getDriverApi().createBufferObject(
-                                count * sizeof(PerRenderableData) + sizeof(PerRenderableUib),
-                                BufferObjectBinding::UNIFORM, BufferUsage::STATIC),
-                        engine.getDriverApi() };
-
                 // TODO: use stream inline buffer for small sizes
                 // TODO: use a pool for larger heap buffers
                 // buffer large enough for all instances data
@@ -369,7 +529,8 @@ void RenderPass::instanceify(FEngine& engine, Arena& arena, int32_t eyeCount) no
             // make the first command instanced
             curr[0].info.instanceCount = instanceCount * eyeCount;
             curr[0].info.index = instancedPrimitiveOffset;
-            curr[0].info.boh = mInstancedUboHandle;
+            // the instancing UBO is created once we know its size, below
+            curr[0].info.boh = {};
 
             instancedPrimitiveOffset += instanceCount;
 
@@ -390,6 +551,16 @@ void RenderPass::instanceify(FEngine& engine, Arena& arena, int32_t eyeCount) no
         // we have instanced primitives
         DriverApi& driver = engine.getDriverApi();
 
+        // create a temporary UBO for instancing, just large enough for the instanced
+        // primitives. The UBO is bound at each command's offset with the size of a full
+        // PerRenderableUib.
+        mInstancedUboHandle = BufferObjectSharedHandle{
+                driver.createBufferObject(
+                        instancedPrimitiveOffset * sizeof(PerRenderableData) +
+                                sizeof(PerRenderableUib),
+                        BufferObjectBinding::UNIFORM, BufferUsage::STATIC),
+                driver };
+
         // copy our instanced ubo data
         driver.updateBufferObjectUnsynchronized(mInstancedUboHandle, {
                 stagingBuffer, sizeof(PerRenderableData) * instancedPrimitiveOffset,
@@ -406,6 +577,13 @@ void RenderPass::instanceify(FEngine& engine, Arena& arena, int32_t eyeCount) no
         });
 
         resize(arena, uint32_t(lastCommand - mCommandBegin));
+
+        // all the non-custom commands have a buffer, except the instanced ones
+        for (Command* c = firstSentinel; c != lastCommand; ++c) {
+            if ((c->key & CUSTOM_MASK) == uint64_t(CustomCommand::PASS) && !c->info.boh) {
+                c->info.boh = mInstancedUboHandle;
+            }
+        }
     }
 
     assert_invariant(stagingBuffer == nullptr);
@@ -555,6 +733,9 @@ RenderPass::Command* RenderPass::generateCommandsImpl(RenderPass::CommandTypeFla
     bool const hasInstancedStereo =
             renderFlags & IS_INSTANCED_STEREOSCOPIC;
 
+    bool const hasAutomaticInstancing =
+            renderFlags & HAS_AUTOMATIC_INSTANCING;
+
     float const cameraPositionDotCameraForward = dot(cameraPosition, cameraForward);
 
     auto const* const UTILS_RESTRICT soaWorldAABBCenter = soa.data<FScene::WORLD_AABB_CENTER>();
@@ -661,6 +842,11 @@ RenderPass::Command* RenderPass::generateCommandsImpl(RenderPass::CommandTypeFla
             cmd.info.boh = renderablesUbo;
         }
 
+        // draws that automatic instancing can merge are grouped by geometry instead of depth,
+        // see instanceify()
+        bool const groupByGeometry = hasAutomaticInstancing &&
+                !cmd.info.hasSkinning && !cmd.info.hasMorphing;
+
         const bool shadowCaster = soaVisibility[i].castShadows & hasShadowing;
         const bool writeDepthForShadowCasters = depthContainsShadowCasters & shadowCaster;
 
@@ -761,8 +947,9 @@ RenderPass::Command* RenderPass::generateCommandsImpl(RenderPass::CommandTypeFla
                     // This will bucket objects by Z, front-to-back and then sort by material
                     // in each buckets. We use the top 10 bits of the distance, which
                     // bucketizes the depth by its log2 and in 4 linear chunks in each bucket.
-                    cmd.key &= ~Z_BUCKET_MASK;
-                    cmd.key |= makeField(distanceBits >> 22u, Z_BUCKET_MASK, Z_BUCKET_SHIFT);
+                    cmd.key &= ~GEOMETRY_HASH_MASK;
+                    cmd.key |= groupByGeometry ? makeGeometryHash(cmd.info) :
+                            makeField(distanceBits >> 22u, Z_BUCKET_MASK, Z_BUCKET_SHIFT);
                 }
             } else if constexpr (isDepthPass) {
                 const RasterState rs = ma->getRasterState();
@@ -780,6 +967,11 @@ RenderPass::Command* RenderPass::generateCommandsImpl(RenderPass::CommandTypeFla
                                                    & !(filterTranslucentObjects & translucent)
                                                    & !(depthFilterAlphaMaskedObjects & rs.alphaToCoverage))
                                                   | writeDepthForShadowCasters;
+
+                if (groupByGeometry) {
+                    cmd.key &= ~GEOMETRY_HASH_MASK;
+                    cmd.key |= makeGeometryHash(cmd.info);
+                }
             }
 
             *curr = cmd;
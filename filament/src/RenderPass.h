@@ -73,9 +73,6 @@ public:
      *   0     = reserved, must be zero
      *
      *
-     * TODO: we need to add a "primitive id" in the low-bits of material-id, so that
-     *       auto-instancing can work better
-     *
      *   DEPTH command (b00)
      *   |  |  | 2| 2| 2|1| 3 | 2|  6   |   10     |               32               |
      *   +--+--+--+--+--+-+---+--+------+----------+--------------------------------+
@@ -93,6 +90,17 @@ public:
      *   | correctness        |      optimizations (truncation allowed)             |
      *
      *
+     *   DEPTH, COLOR and REFRACT commands with automatic instancing
+     *   |  | 2| 2| 2| 2|1| 3 | 2|        16         |               32               |
+     *   +--+--+--+--+--+-+---+--+-------------------+--------------------------------+
+     *   |CC|00|PP|01|00|a|ppp|00|   geometry-hash   |          material-id           |
+     *   +--+--+--+--+--+-+---+--+-------------------+--------------------------------+
+     *   | correctness        |      optimizations (truncation allowed)             |
+     *
+     *   The geometry hash replaces the Z-bucket of the commands that can be instanced, so that
+     *   identical draws end up next to each other regardless of their distance to the camera.
+     *
+     *
      *   BLENDED command (b11)
      *   | 2| 2| 2| 2| 2|1| 3 | 2|              32                |         15    |1|
      *   +--+--+--+--+--+-+---+--+--------------------------------+---------------+-+
@@ -149,6 +157,9 @@ public:
     static constexpr uint64_t Z_BUCKET_MASK                 = 0x3FF00000000llu;
     static constexpr unsigned Z_BUCKET_SHIFT                = 32;
 
+    static constexpr uint64_t GEOMETRY_HASH_MASK            = 0xFFFF00000000llu;
+    static constexpr unsigned GEOMETRY_HASH_SHIFT           = 32;
+
     static constexpr uint64_t PRIORITY_MASK                 = 0x001C000000000000llu;
     static constexpr unsigned PRIORITY_SHIFT                = 50;
 
@@ -239,6 +250,15 @@ public:
         return boolish ? value : uint64_t(0);
     }
 
+    struct PrimitiveInfo;
+
+    /*
+     * The geometry hash identifies the draws that automatic instancing can merge, i.e. the
+     * draws of the same primitive with the same raster state. Collisions only cost instancing
+     * opportunities, instanceify() always compares the draws themselves.
+     */
+    static CommandKey makeGeometryHash(PrimitiveInfo const& info) noexcept;
+
     struct PrimitiveInfo { // 56 bytes
         union {
             FMaterialInstance const* mi;
@@ -284,6 +304,7 @@ public:
     static constexpr RenderFlags HAS_SHADOWING             = 0x01;
     static constexpr RenderFlags HAS_INVERSE_FRONT_FACES   = 0x02;
     static constexpr RenderFlags IS_INSTANCED_STEREOSCOPIC = 0x04;
+    static constexpr RenderFlags HAS_AUTOMATIC_INSTANCING  = 0x08;
 
     // Arena used for commands
     using Arena = utils::Arena<
@@ -292,6 +313,13 @@ public:
             utils::TrackingPolicy::HighWatermark,
             utils::AreaPolicy::StaticArea>;
 
+    // Remembers the order of the sorted commands of a pass from one frame to the next. When the
+    // commands haven't changed, or only their payload has, this order is simply verified instead
+    // of sorting the commands again.
+    struct SortCache {
+        std::vector<uint32_t> order;
+    };
+
     // RenderPass can only be moved
     RenderPass(RenderPass&& rhs) = default;
     RenderPass& operator=(RenderPass&& rhs) = delete;  // could be supported if needed
@@ -411,7 +439,7 @@ private:
     void resize(Arena& arena, size_t count) noexcept;
 
     // sorts commands then trims sentinels
-    void sortCommands(Arena& arena) noexcept;
+    void sortCommands(FEngine& engine, Arena& arena, SortCache* cache) noexcept;
 
     // instanceify commands then trims sentinels
     void instanceify(FEngine& engine, Arena& arena, int32_t eyeCount) noexcept;
@@ -455,7 +483,7 @@ private:
     BufferObjectSharedHandle mInstancedUboHandle;
     // a vector for our custom commands
     using CustomCommandVector = std::vector<Executor::CustomCommandFn,
-            utils::STLAllocator<Executor::CustomCommandFn, LinearAllocatorArena>>;
+            utils::STLAllocator<Executor::CustomCommandFn, PerRenderPassArena>>;
     mutable CustomCommandVector mCustomCommands;
 };
 
@@ -473,6 +501,7 @@ class RenderPassBuilder {
     RenderPass::RenderFlags mFlags{};
     Variant mVariant{};
     FScene::VisibleMaskType mVisibilityMask = std::numeric_limits<FScene::VisibleMaskType>::max();
+    RenderPass::SortCache* mSortCache = nullptr;
 
     using CustomCommandRecord = std::tuple<
             uint8_t,
@@ -482,7 +511,7 @@ class RenderPassBuilder {
             RenderPass::Executor::CustomCommandFn>;
 
     using CustomCommandContainer = std::vector<CustomCommandRecord,
-            utils::STLAllocator<CustomCommandRecord, LinearAllocatorArena>>;
+            utils::STLAllocator<CustomCommandRecord, PerRenderPassArena>>;
 
     // we make this optional because it's not used often, and we don't want to have
     // to construct it by default.
@@ -544,6 +573,13 @@ public:
         return *this;
     }
 
+    // Sets a cache used to sort commands faster when they don't change from one frame to the
+    // next. The cache must outlive the RenderPass and should be used by a single pass per frame.
+    RenderPassBuilder& sortCache(RenderPass::SortCache* cache) noexcept {
+        mSortCache = cache;
+        return *this;
+    }
+
     RenderPassBuilder& customCommand(FEngine& engine,
             uint8_t channel,
             RenderPass::Pass pass,
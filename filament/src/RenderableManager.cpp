@@ -108,6 +108,10 @@ size_t RenderableManager::getPrimitiveCount(Instance instance) const noexcept {
     return downcast(this)->getPrimitiveCount(instance, 0);
 }
 
+size_t RenderableManager::getLevelOfDetailCount(Instance instance) const noexcept {
+    return downcast(this)->getLevelCount(instance);
+}
+
 void RenderableManager::setMaterialInstanceAt(Instance instance,
         size_t primitiveIndex, MaterialInstance const* materialInstance) {
     downcast(this)->setMaterialInstanceAt(instance, 0, primitiveIndex, downcast(materialInstance));
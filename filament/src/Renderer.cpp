@@ -69,6 +69,31 @@ void Renderer::resetUserTime() {
     downcast(this)->resetUserTime();
 }
 
+backend::StateChangeStats Renderer::getStateChangeStats() const noexcept {
+    return downcast(this)->getStateChangeStats();
+}
+
+float Renderer::getThermalHeadroom() const noexcept {
+    return downcast(this)->getThermalHeadroom();
+}
+
+size_t Renderer::getFrameTimings(FrameTimings* out, size_t count) const noexcept {
+    return downcast(this)->getFrameTimings(out, count);
+}
+
+void Renderer::setGpuPassTimingsEnabled(bool enabled) noexcept {
+    downcast(this)->setGpuPassTimingsEnabled(enabled);
+}
+
+bool Renderer::isGpuPassTimingsEnabled() const noexcept {
+    return downcast(this)->isGpuPassTimingsEnabled();
+}
+
+size_t Renderer::getGpuPassTimings(GpuPassTiming* out, size_t count,
+        uint32_t* frameId) const noexcept {
+    return downcast(this)->getGpuPassTimings(out, count, frameId);
+}
+
 void Renderer::setDisplayInfo(const DisplayInfo& info) noexcept {
     downcast(this)->setDisplayInfo(info);
 }
@@ -89,4 +114,8 @@ void Renderer::renderStandaloneView(View const* view) {
     downcast(this)->renderStandaloneView(downcast(view));
 }
 
+void Renderer::renderStandaloneViews(View const* const* views, size_t count) {
+    downcast(this)->renderStandaloneViews(views, count);
+}
+
 } // namespace filament
@@ -110,6 +110,7 @@ size_t ResourceAllocator::TextureKey::getSize() const noexcept {
 
 ResourceAllocator::ResourceAllocator(Engine::Config const& config, DriverApi& driverApi) noexcept
         : mCacheMaxAge(config.resourceAllocatorCacheMaxAge),
+          mCacheMaxSize(size_t(config.resourceAllocatorCacheSizeMB) << 20u),
           mBackend(driverApi) {
 }
 
@@ -158,10 +159,20 @@ backend::TextureHandle ResourceAllocator::createTexture(const char* name,
         auto& textureCache = mTextureCache;
         const TextureKey key{ name, target, levels, format, samples, width, height, depth, usage, swizzle };
         auto it = textureCache.find(key);
+        if (UTILS_UNLIKELY(it == textureCache.end())) {
+            // Passes often request the same texture with different usages, e.g. with or without
+            // SAMPLEABLE, so a texture released earlier in the frame often has all the usages we
+            // need. Reusing it keeps transient textures with disjoint lifetimes in the same memory.
+            it = textureCache.find_if([&key](auto const& entry) {
+                return entry.first.canAlias(key);
+            });
+        }
         if (UTILS_LIKELY(it != textureCache.end())) {
-            // we do, move the entry to the in-use list, and remove from the cache
+            // we do, move the entry to the in-use list, and remove from the cache; the in-use
+            // entry keeps the key the texture was created with.
             handle = it->second.handle;
             mCacheSize -= it->second.size;
+            mInUseTextures.emplace(handle, it->first);
             textureCache.erase(it);
         } else {
             // we don't, allocate a new texture and populate the in-use list
@@ -173,8 +184,8 @@ backend::TextureHandle ResourceAllocator::createTexture(const char* name,
                         target, levels, format, samples, width, height, depth, usage,
                         swizzle[0], swizzle[1], swizzle[2], swizzle[3]);
             }
+            mInUseTextures.emplace(handle, key);
         }
-        mInUseTextures.emplace(handle, key);
     } else {
         if (swizzle == defaultSwizzle) {
             handle = mBackend.createTexture(
@@ -217,6 +228,11 @@ void ResourceAllocator::gc() noexcept {
     // Purging strategy:
     //  - remove entries that are older than a certain age
     //      - remove only one entry per gc(),
+    //  - then, remove the oldest entries until the cache fits in its budget. This matters when
+    //    the sizes change every frame (e.g. dynamic resolution), as none of the entries would
+    //    be reused before they get old. Entries released during this frame are never removed
+    //    this way, otherwise a working set larger than the budget would be reallocated every
+    //    frame.
 
     auto& textureCache = mTextureCache;
     for (auto it = textureCache.begin(); it != textureCache.end();) {
@@ -229,6 +245,16 @@ void ResourceAllocator::gc() noexcept {
             ++it;
         }
     }
+
+    // entries are appended as they're released and erasing keeps the order, so the cache is
+    // sorted by age, oldest first.
+    while (mCacheSize > mCacheMaxSize) {
+        auto const oldest = textureCache.begin();
+        if (oldest == textureCache.end() || oldest->second.age >= age) {
+            break;
+        }
+        purge(oldest);
+    }
 }
 
 UTILS_NOINLINE
@@ -95,8 +95,12 @@ public:
 
     void gc() noexcept;
 
+    // size of the textures kept in the cache, in bytes
+    size_t getCacheSize() const noexcept { return mCacheSize; }
+
 private:
     size_t const mCacheMaxAge;
+    size_t const mCacheMaxSize;
 
     struct TextureKey {
         const char* name; // doesn't participate in the hash
@@ -124,6 +128,26 @@ private:
                    swizzle == other.swizzle;
         }
 
+        // Returns whether a texture created with this key can be used in place of one created
+        // with \p other, i.e. everything matches except that we may have more usage flags.
+        // Protected content must always match.
+        bool canAlias(const TextureKey& other) const noexcept {
+            using backend::TextureUsage;
+            return target == other.target &&
+                   levels == other.levels &&
+                   format == other.format &&
+                   samples == other.samples &&
+                   width == other.width &&
+                   height == other.height &&
+                   depth == other.depth &&
+                   any(usage & TextureUsage::PROTECTED) ==
+                           any(other.usage & TextureUsage::PROTECTED) &&
+                   any(usage & TextureUsage::TRANSIENT_ATTACHMENT) ==
+                           any(other.usage & TextureUsage::TRANSIENT_ATTACHMENT) &&
+                   (usage & other.usage) == other.usage &&
+                   swizzle == other.swizzle;
+        }
+
         friend size_t hash_value(TextureKey const& k) {
             size_t seed = 0;
             utils::hash::combine_fast(seed, k.target);
@@ -188,6 +212,11 @@ private:
         iterator erase(iterator it);
         const_iterator find(key_type const& key) const;
         iterator find(key_type const& key);
+        template<typename Predicate>
+        iterator find_if(Predicate&& predicate) {
+            return std::find_if(mContainer.begin(), mContainer.end(),
+                    std::forward<Predicate>(predicate));
+        }
         template<typename ... ARGS>
         void emplace(ARGS&&... args);
     };
@@ -75,4 +75,20 @@ void Scene::forEach(Invocable<void(utils::Entity)>&& functor) const noexcept {
     downcast(this)->forEach(std::move(functor));
 }
 
+void Scene::setCullingHierarchyEnabled(bool enabled) noexcept {
+    downcast(this)->setCullingHierarchyEnabled(enabled);
+}
+
+bool Scene::isCullingHierarchyEnabled() const noexcept {
+    return downcast(this)->isCullingHierarchyEnabled();
+}
+
+void Scene::setSharedPreparationEnabled(bool enabled) noexcept {
+    downcast(this)->setSharedPreparationEnabled(enabled);
+}
+
+bool Scene::isSharedPreparationEnabled() const noexcept {
+    return downcast(this)->isSharedPreparationEnabled();
+}
+
 } // namespace filament
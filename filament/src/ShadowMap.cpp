@@ -262,7 +262,7 @@ ShadowMap::ShaderParameters ShadowMap::updatePunctual(
     const mat4f Mp = mat4f::perspective(
             outerConeAngle * f::RAD_TO_DEG * 2.0f, 1.0f, nearPlane, farPlane);
 
-    assert_invariant(shadowMapInfo.textureDimension == mOptions->mapSize);
+    assert_invariant(shadowMapInfo.textureDimension == mMapSize);
 
     // Final shadow transform
     const mat4f S = math::highPrecisionMultiply(Mp, Mv);
@@ -1214,6 +1214,8 @@ ShadowMap::SceneInfo::SceneInfo(
     // computeShadowCameraDirectional() which takes this into account.
 
     // Compute scene bounds in world space, as well as the light-space and view-space near/far planes
+    // Only the receivers visible by the camera are accounted for, this fits the cascades and
+    // the light frustum to the depth range that can actually show a shadow.
     wsShadowCastersVolume = {};
     wsShadowReceiversVolume = {};
     ShadowMap::visitScene(scene, visibleLayers,
@@ -1221,7 +1223,10 @@ ShadowMap::SceneInfo::SceneInfo(
                 wsShadowCastersVolume.min = min(wsShadowCastersVolume.min, caster.min);
                 wsShadowCastersVolume.max = max(wsShadowCastersVolume.max, caster.max);
             },
-            [&](Aabb receiver, Culler::result_type) {
+            [&](Aabb receiver, Culler::result_type vis) {
+                if (!(vis & VISIBLE_RENDERABLE)) {
+                    return;
+                }
                 wsShadowReceiversVolume.min = min(wsShadowReceiversVolume.min, receiver.min);
                 wsShadowReceiversVolume.max = max(wsShadowReceiversVolume.max, receiver.max);
                 auto r = Aabb::transform(viewMatrix.upperLeft(), viewMatrix[3].xyz, receiver);
@@ -1257,6 +1262,104 @@ void ShadowMap::updateSceneInfoDirectional(mat4f const& Mv, FScene const& scene,
     );
 }
 
+void ShadowMap::cullCastersWithReceivers(mat4f const& Mv, FScene::RenderableSoa& soa,
+        uint8_t visibleLayers) noexcept {
+    SYSTRACE_CALL();
+
+    // the code below only works with affine transforms
+    assert_invariant(transpose(Mv)[3] == float4(0, 0, 0, 1));
+
+    // A caster can only affect a visible pixel if it's in front of (closer to the light than) a
+    // visible receiver it overlaps in light-space. We extrude the visible receivers toward the
+    // light by binning them into a coarse light-space grid, each cell keeps the farthest depth
+    // of the receivers that cover it; casters that are behind everything they overlap are culled.
+    constexpr size_t GRID_SIZE = 16;
+
+    using State = FRenderableManager::Visibility;
+    float3 const* const worldAABBCenter = soa.data<FScene::WORLD_AABB_CENTER>();
+    float3 const* const worldAABBExtent = soa.data<FScene::WORLD_AABB_EXTENT>();
+    uint8_t const* const layers = soa.data<FScene::LAYERS>();
+    State const* const visibility = soa.data<FScene::VISIBILITY_STATE>();
+    auto* const visibleMasks = soa.data<FScene::VISIBLE_MASK>();
+    size_t const c = soa.size();
+
+    auto lightSpaceBounds = [&](size_t i) {
+        Aabb const aabb{ worldAABBCenter[i] - worldAABBExtent[i],
+                         worldAABBCenter[i] + worldAABBExtent[i] };
+        return Aabb::transform(Mv.upperLeft(), Mv[3].xyz, aabb);
+    };
+
+    auto isVisibleReceiver = [&](size_t i) {
+        return (layers[i] & visibleLayers) && visibility[i].receiveShadows &&
+               (visibleMasks[i] & VISIBLE_RENDERABLE);
+    };
+
+    // light-space x-y bounds of the visible receivers
+    float2 lsMin{ std::numeric_limits<float>::max() };
+    float2 lsMax{ std::numeric_limits<float>::lowest() };
+    for (size_t i = 0; i < c; i++) {
+        if (isVisibleReceiver(i)) {
+            Aabb const r = lightSpaceBounds(i);
+            lsMin = min(lsMin, r.min.xy);
+            lsMax = max(lsMax, r.max.xy);
+        }
+    }
+    if (!(lsMin.x <= lsMax.x && lsMin.y <= lsMax.y)) {
+        // no visible receivers (or NaNs), there is nothing we can safely cull
+        return;
+    }
+
+    float2 const extent = lsMax - lsMin;
+    float2 const scale{
+            extent.x > 0.0f ? float(GRID_SIZE) / extent.x : 0.0f,
+            extent.y > 0.0f ? float(GRID_SIZE) / extent.y : 0.0f };
+
+    auto cell = [&](float2 p) -> int2 {
+        int2 const xy{ (p - lsMin) * scale };
+        return clamp(xy, int2{ 0 }, int2{ GRID_SIZE - 1 });
+    };
+
+    // farthest light-space depth of the receivers covering each cell
+    float lsReceiversFar[GRID_SIZE * GRID_SIZE];
+    std::fill(std::begin(lsReceiversFar), std::end(lsReceiversFar),
+            std::numeric_limits<float>::max());
+    for (size_t i = 0; i < c; i++) {
+        if (isVisibleReceiver(i)) {
+            Aabb const r = lightSpaceBounds(i);
+            int2 const lo = cell(r.min.xy);
+            int2 const hi = cell(r.max.xy);
+            for (int y = lo.y; y <= hi.y; y++) {
+                for (int x = lo.x; x <= hi.x; x++) {
+                    float& cellFar = lsReceiversFar[y * GRID_SIZE + x];
+                    cellFar = std::min(cellFar, r.min.z);
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < c; i++) {
+        if (!(visibleMasks[i] & VISIBLE_DIR_SHADOW_RENDERABLE) || !visibility[i].castShadows) {
+            continue;
+        }
+        Aabb const r = lightSpaceBounds(i);
+        bool shadowsReceiver = false;
+        if (r.max.x >= lsMin.x && r.min.x <= lsMax.x &&
+            r.max.y >= lsMin.y && r.min.y <= lsMax.y) {
+            int2 const lo = cell(r.min.xy);
+            int2 const hi = cell(r.max.xy);
+            for (int y = lo.y; y <= hi.y && !shadowsReceiver; y++) {
+                for (int x = lo.x; x <= hi.x && !shadowsReceiver; x++) {
+                    // the light looks down -z, so the caster's near is its max z
+                    shadowsReceiver = r.max.z >= lsReceiversFar[y * GRID_SIZE + x];
+                }
+            }
+        }
+        if (!shadowsReceiver) {
+            visibleMasks[i] &= ~VISIBLE_DIR_SHADOW_RENDERABLE;
+        }
+    }
+}
+
 void ShadowMap::updateSceneInfoSpot(mat4f const& Mv, FScene const& scene,
         SceneInfo& sceneInfo) {
 
@@ -1285,9 +1388,11 @@ backend::Viewport ShadowMap::getViewport() const noexcept {
     // or when shadowFar is smaller than the camera far.
     // For spot- and point-lights we also use a 1-texel border, so that bilinear filtering
     // can work properly if the shadowmap is in an atlas (and we can't rely on h/w clamp).
-    const uint32_t dim = mOptions->mapSize;
+    const uint32_t dim = mMapSize;
+    const int32_t l = mAtlasOffset.x;
+    const int32_t b = mAtlasOffset.y;
     const uint16_t border = 1u;
-    return { border, border, dim - 2u * border, dim - 2u * border };
+    return { l + border, b + border, dim - 2u * border, dim - 2u * border };
 }
 
 backend::Viewport ShadowMap::getScissor() const noexcept {
@@ -1297,14 +1402,16 @@ backend::Viewport ShadowMap::getScissor() const noexcept {
     // For spot- and point-lights we also use a 1-texel border, so that bilinear filtering
     // can work properly if the shadowmap is in an atlas (and we can't rely on h/w clamp), so we
     // don't scissor the border, so it gets filled with correct neighboring texels.
-    const uint32_t dim = mOptions->mapSize;
+    const uint32_t dim = mMapSize;
+    const int32_t l = mAtlasOffset.x;
+    const int32_t b = mAtlasOffset.y;
     const uint16_t border = 1u;
     switch (mShadowType) {
         case ShadowType::DIRECTIONAL:
-            return { border, border, dim - 2u * border, dim - 2u * border };
+            return { l + border, b + border, dim - 2u * border, dim - 2u * border };
         case ShadowType::SPOT:
         case ShadowType::POINT:
-            return { 0, 0, dim, dim };
+            return { l, b, dim, dim };
     }
 }
 
@@ -1326,9 +1433,9 @@ math::float4 ShadowMap::getClampToEdgeCoords(ShadowMapInfo const& shadowMapInfo)
     }
 
     float const texel = 1.0f / float(shadowMapInfo.atlasDimension);
-    float const dim = float(mOptions->mapSize);
-    float const l = border;
-    float const b = border;
+    float const dim = float(mMapSize);
+    float const l = float(mAtlasOffset.x) + border;
+    float const b = float(mAtlasOffset.y) + border;
     float const w = dim - 2.0f * border;
     float const h = dim - 2.0f * border;
     float4 const v = float4{ l, b, l + w, b + h } * texel;
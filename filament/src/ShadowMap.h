@@ -33,6 +33,7 @@
 #include <utils/compiler.h>
 
 #include <math/mathfwd.h>
+#include <math/vec2.h>
 #include <math/vec3.h>
 #include <math/vec4.h>
 #include <math/mat4.h>
@@ -182,11 +183,22 @@ public:
     static void updateSceneInfoSpot(const math::mat4f& Mv, FScene const& scene,
             SceneInfo& sceneInfo);
 
+    // Clears VISIBLE_DIR_SHADOW_RENDERABLE of the casters that can't shadow any receiver visible
+    // by the camera. Mv is the directional light's view matrix.
+    static void cullCastersWithReceivers(const math::mat4f& Mv, FScene::RenderableSoa& soa,
+            uint8_t visibleLayers) noexcept;
+
     LightManager::ShadowOptions const* getShadowOptions() const noexcept { return mOptions; }
     size_t getLightIndex() const { return mLightIndex; }
     uint16_t getShadowIndex() const { return mShadowIndex; }
     void setLayer(uint8_t layer) noexcept { mLayer = layer; }
     uint8_t getLayer() const noexcept { return mLayer; }
+    // where this shadow map is in its layer, and its dimension in texels
+    void setAtlasRegion(uint16_t left, uint16_t bottom, uint16_t mapSize) noexcept {
+        mAtlasOffset = { left, bottom };
+        mMapSize = mapSize;
+    }
+    uint16_t getMapSize() const noexcept { return mMapSize; }
     backend::Viewport getViewport() const noexcept;
     backend::Viewport getScissor() const noexcept;
 
@@ -357,6 +369,8 @@ private:
     uint32_t mLightIndex = 0;   // which light are we shadowing             // 4
     uint16_t mShadowIndex = 0;  // our index in the shadowMap vector        // 2
     uint8_t mLayer = 0;         // our layer in the shadowMap texture       // 1
+    uint16_t mMapSize = 0;      // our dimension in the layer               // 2
+    math::ushort2 mAtlasOffset; // our position in the layer                // 4
     ShadowType mShadowType  : 2;                                            // :2
     bool mHasVisibleShadows : 2;                                            // :2
     uint8_t mFace           : 3;                                            // :3
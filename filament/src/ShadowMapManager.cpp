@@ -15,6 +15,7 @@
  */
 
 #include "ShadowMapManager.h"
+#include "AtlasAllocator.h"
 #include "RenderPass.h"
 #include "ShadowMap.h"
 
@@ -42,6 +43,7 @@
 #include <utils/FixedCapacityVector.h>
 #include <utils/Range.h>
 #include <utils/Slice.h>
+#include <utils/bitset.h>
 #include <utils/compiler.h>
 #include <utils/debug.h>
 
@@ -50,6 +52,7 @@
 #include <math/vec4.h>
 #include <math/scalar.h>
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <new>
@@ -69,6 +72,8 @@ ShadowMapManager::ShadowMapManager(FEngine& engine) {
             &engine.debug.shadowmap.visualize_cascades);
     debugRegistry.registerProperty("d.shadowmap.tightly_bound_scene",
             &engine.debug.shadowmap.tightly_bound_scene);
+    debugRegistry.registerProperty("d.shadowmap.receivers_cull_casters",
+            &engine.debug.shadowmap.receivers_cull_casters);
 }
 
 ShadowMapManager::~ShadowMapManager() {
@@ -104,6 +109,124 @@ void ShadowMapManager::terminate(FEngine& engine) {
             std::launder(reinterpret_cast<ShadowMap*>(&entry))->terminate(engine);
         }
     }
+    destroyCachedAtlas(engine.getDriverApi());
+}
+
+FrameGraphId<FrameGraphTexture> ShadowMapManager::importCachedAtlas(FEngine& engine,
+        FrameGraph& fg, TextureAtlasRequirements const& textureRequirements) noexcept {
+    if (!isCachedAtlasValid()) {
+        DriverApi& driver = engine.getDriverApi();
+        destroyCachedAtlas(driver);
+        mCachedAtlas = driver.createTexture(SamplerType::SAMPLER_2D_ARRAY,
+                textureRequirements.levels, textureRequirements.format, 1,
+                textureRequirements.size, textureRequirements.size, textureRequirements.layers,
+                TextureUsage::DEPTH_ATTACHMENT | TextureUsage::SAMPLEABLE);
+        mCachedAtlasRequirements = textureRequirements;
+    }
+
+    return fg.import("Cached Shadowmap", {
+                    .width = textureRequirements.size, .height = textureRequirements.size,
+                    .depth = textureRequirements.layers,
+                    .levels = textureRequirements.levels,
+                    .type = SamplerType::SAMPLER_2D_ARRAY,
+                    .format = textureRequirements.format
+            },
+            FrameGraphTexture::Usage::DEPTH_ATTACHMENT | FrameGraphTexture::Usage::SAMPLEABLE,
+            FrameGraphTexture{ .handle = mCachedAtlas });
+}
+
+void ShadowMapManager::destroyCachedAtlas(DriverApi& driver) noexcept {
+    if (mCachedAtlas) {
+        driver.destroyTexture(mCachedAtlas);
+        mCachedAtlas.clear();
+    }
+    mCachedLayerKeys.fill(0);
+    for (auto& cascade : mCachedCascades) {
+        cascade.valid = false;
+    }
+}
+
+bool ShadowMapManager::isCachedAtlasValid() const noexcept {
+    TextureAtlasRequirements const& cached = mCachedAtlasRequirements;
+    TextureAtlasRequirements const& current = mTextureAtlasRequirements;
+    return mCachedAtlas &&
+            cached.size == current.size &&
+            cached.layers == current.layers &&
+            cached.levels == current.levels &&
+            cached.format == current.format;
+}
+
+bool ShadowMapManager::isCascadeReusable(mat4f const& cachedLightFromWorld,
+        mat4f const& lightFromWorld, uint16_t textureDimension,
+        uint16_t atlasDimension) noexcept {
+    // The light's orientation and the cascade's extent and depth range must not have changed...
+    constexpr float epsilon = 1e-4f;
+    for (size_t i = 0; i < 3; i++) {
+        float const delta = length(cachedLightFromWorld[i] - lightFromWorld[i]);
+        if (delta > epsilon * length(lightFromWorld[i])) {
+            return false;
+        }
+    }
+    if (std::abs(cachedLightFromWorld[3].z - lightFromWorld[3].z) >
+            epsilon * std::max(1.0f, std::abs(lightFromWorld[3].z))) {
+        return false;
+    }
+    // ...and the cascade must not have scrolled by more than 1/16th of its size. The border
+    // that scrolled into view has no shadows until the cascade is rendered again.
+    float const maxScroll = float(textureDimension) / float(atlasDimension) / 16.0f;
+    float2 const scroll = abs(cachedLightFromWorld[3].xy - lightFromWorld[3].xy);
+    return scroll.x <= maxScroll && scroll.y <= maxScroll;
+}
+
+uint64_t ShadowMapManager::computeCacheKey(ShadowMap const& shadowMap,
+        FScene::RenderableSoa const& renderableData, utils::Range<uint32_t> range,
+        FScene::LightSoa const& lightData) const noexcept {
+    // 64-bit FNV-1a, 32 bits at a time
+    uint64_t key = 0xcbf29ce484222325ull;
+    auto mix = [&key](void const* data, size_t size) {
+        uint32_t const* p = static_cast<uint32_t const*>(data);
+        for (size_t i = 0, c = size / sizeof(uint32_t); i < c; i++) {
+            key = (key ^ p[i]) * 0x100000001b3ull;
+        }
+    };
+    auto mixValue = [&mix](auto const& value) {
+        static_assert(sizeof(value) % sizeof(uint32_t) == 0);
+        mix(&value, sizeof(value));
+    };
+
+    // the light and its shadow camera, which also depends on the options of the light
+    auto const* options = shadowMap.getShadowOptions();
+    mixValue(lightData.elementAt<FScene::LIGHT_INSTANCE>(shadowMap.getLightIndex()).asValue());
+    mixValue(uint32_t(shadowMap.getFace()));
+    mixValue(mShadowUb.itemAt(0).shadows[shadowMap.getShadowIndex()].lightFromWorldMatrix);
+    mixValue(shadowMap.getViewport());
+    mixValue(options->polygonOffsetConstant);
+    mixValue(options->polygonOffsetSlope);
+
+    // the casters it sees, as of the last call to cull{Spot|Point}ShadowMap()
+    auto const* UTILS_RESTRICT instances   = renderableData.data<FScene::RENDERABLE_INSTANCE>();
+    auto const* UTILS_RESTRICT visibleMask = renderableData.data<FScene::VISIBLE_MASK>();
+    auto const* UTILS_RESTRICT visibility  = renderableData.data<FScene::VISIBILITY_STATE>();
+    auto const* UTILS_RESTRICT centers     = renderableData.data<FScene::WORLD_AABB_CENTER>();
+    auto const* UTILS_RESTRICT extents     = renderableData.data<FScene::WORLD_AABB_EXTENT>();
+    auto const* UTILS_RESTRICT primitives  = renderableData.data<FScene::PRIMITIVES>();
+    for (uint32_t i = range.first; i < range.last; i++) {
+        if (!(visibleMask[i] & VISIBLE_DYN_SHADOW_RENDERABLE)) {
+            continue;
+        }
+        if (visibility[i].skinning || visibility[i].morphing) {
+            // the geometry can change without its bounds changing
+            return 0;
+        }
+        mixValue(instances[i].asValue());
+        mixValue(centers[i]);
+        mixValue(extents[i]);
+        mixValue(uintptr_t(primitives[i].begin()));
+        mixValue(uintptr_t(primitives[i].end()));
+    }
+
+    // 0 means "not cached"
+    return key ? key : 1;
 }
 
 ShadowMapManager::ShadowTechnique ShadowMapManager::update(
@@ -144,7 +267,7 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::update(
 
     ShadowTechnique shadowTechnique = {};
 
-    calculateTextureRequirements(engine, view, lightData);
+    calculateTextureRequirements(engine, view, cameraInfo, lightData);
 
     // Compute scene-dependent values shared across all shadow maps
     ShadowMap::SceneInfo const info{ *view.getScene(), view.getVisibleLayers(), cameraInfo.view };
@@ -228,6 +351,8 @@ FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FEngine& engine, FrameG
     struct PrepareShadowPassData {
         struct ShadowPass {
             mutable RenderPass::Executor executor;
+            // whether the layer already has the content of this shadow map
+            mutable bool cached = false;
             ShadowMap* shadowMap;
             utils::Range<uint32_t> range;
             FScene::VisibleMaskType visibilityMask;
@@ -240,10 +365,21 @@ FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FEngine& engine, FrameG
 
     VsmShadowOptions const& vsmShadowOptions = view.getVsmShadowOptions();
 
+    // With caching, the atlas is owned by us, so that the shadow maps that didn't change since
+    // they were rendered can be reused. This isn't supported with VSM, which
+    // blurs and mipmaps the whole atlas.
+    bool const caching = view.isShadowCachingEnabled() && !view.hasVSM();
+    FrameGraphId<FrameGraphTexture> cachedAtlas;
+    if (caching) {
+        cachedAtlas = importCachedAtlas(engine, fg, textureRequirements);
+    } else {
+        destroyCachedAtlas(engine.getDriverApi());
+    }
+
     auto& prepareShadowPass = fg.addPass<PrepareShadowPassData>("Prepare Shadow Pass",
             [&](FrameGraph::Builder& builder, auto& data) {
                 data.passList.reserve(CONFIG_MAX_SHADOWMAPS);
-                data.shadows = builder.createTexture("Shadowmap", {
+                data.shadows = cachedAtlas ? cachedAtlas : builder.createTexture("Shadowmap", {
                         .width = textureRequirements.size, .height = textureRequirements.size,
                         .depth = textureRequirements.layers,
                         .levels = textureRequirements.levels,
@@ -261,7 +397,7 @@ FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FEngine& engine, FrameG
                         // for the directional light, we already know if it has visible shadows.
                         if (shadowMap.hasVisibleShadows()) {
                             passList.push_back({
-                                    {}, &shadowMap, directionalShadowCastersRange,
+                                    {}, false, &shadowMap, directionalShadowCastersRange,
                                     VISIBLE_DIR_SHADOW_RENDERABLE });
                         }
                     }
@@ -289,19 +425,26 @@ FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FEngine& engine, FrameG
 
                         if (shadowMap.hasVisibleShadows()) {
                             passList.push_back({
-                                    {}, &shadowMap, spotShadowCastersRange,
+                                    {}, false, &shadowMap, spotShadowCastersRange,
                                     VISIBLE_DYN_SHADOW_RENDERABLE });
                         }
                     }
                 }
 
-                assert_invariant(passList.size() <= textureRequirements.layers);
+                assert_invariant(passList.size() <= CONFIG_MAX_SHADOWMAPS);
+
+                // Shadow maps that share a layer are rendered in the same pass (see below),
+                // so we group them together.
+                std::stable_sort(passList.begin(), passList.end(),
+                        [](auto const& lhs, auto const& rhs) {
+                            return lhs.shadowMap->getLayer() < rhs.shadowMap->getLayer();
+                        });
 
                 // This pass must be declared as having a side effect because it never gets a
                 // "read" from one of its resource (only writes), so the FrameGraph culls it.
                 builder.sideEffect();
             },
-            [this, &engine, &view, vsmShadowOptions,
+            [this, &engine, &view, vsmShadowOptions, caching,
                 scene, mainCameraInfo, userTime, passBuilder = passBuilder](
                     FrameGraphResources const&, auto const& data, DriverApi& driver) mutable {
 
@@ -313,6 +456,7 @@ FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FEngine& engine, FrameG
                 // Conceptually, we could store this out-of-band.
 
                 // Generate a RenderPass for each shadow map
+                mPointLightCasters.clear();
                 for (auto const& entry : data.passList) {
                     ShadowMap const& shadowMap = *entry.shadowMap;
                     assert_invariant(shadowMap.hasVisibleShadows());
@@ -338,12 +482,36 @@ FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FEngine& engine, FrameG
                                     scene->getLightData());
                             break;
                         case ShadowType::POINT:
-                            ShadowMapManager::cullPointShadowMap(shadowMap, view,
+                            cullPointShadowMap(shadowMap, view,
                                     scene->getRenderableData(), entry.range,
                                     scene->getLightData());
                             break;
                     }
 
+                    if (caching) {
+                        uint64_t key = 0;
+                        if (shadowMap.isDirectionalShadow()) {
+                            // updateCascadeShadowMaps() decided which cascades are reused
+                            if (mReusedCascades & (1u << shadowMap.getShadowIndex())) {
+                                entry.cached = true;
+                                continue;
+                            }
+                        } else {
+                            key = computeCacheKey(shadowMap, scene->getRenderableData(),
+                                    entry.range, scene->getLightData());
+                            // this layer might have held a cascade before
+                            if (shadowMap.getLayer() < CONFIG_MAX_SHADOW_CASCADES) {
+                                mCachedCascades[shadowMap.getLayer()].valid = false;
+                            }
+                        }
+                        uint64_t& cachedKey = mCachedLayerKeys[shadowMap.getLayer()];
+                        if (key && key == cachedKey) {
+                            entry.cached = true;
+                            continue;
+                        }
+                        cachedKey = key;
+                    }
+
                     // cameraInfo only valid after calling update
                     const CameraInfo cameraInfo{ shadowMap.getCamera(), mainCameraInfo };
 
@@ -401,11 +569,25 @@ FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FEngine& engine, FrameG
         uint32_t rt{};
     };
 
+    // the layers that need VSM mipmaps
+    utils::bitset64 vsmLayers;
+    static_assert(CONFIG_MAX_SHADOW_LAYERS <= utils::bitset64::BIT_COUNT);
+
     auto const& passList = prepareShadowPass.getData().passList;
-    for (auto const& entry: passList) {
+    for (size_t first = 0, last; first < passList.size(); first = last) {
+        auto const& entry = passList[first];
         assert_invariant(entry.shadowMap->hasVisibleShadows());
 
+        // the shadow maps in [first, last) share this layer
         const uint8_t layer = entry.shadowMap->getLayer();
+        for (last = first + 1; last < passList.size(); last++) {
+            if (passList[last].shadowMap->getLayer() != layer) {
+                break;
+            }
+        }
+        // VSM and shadow caching need a layer per shadow map
+        assert_invariant(last == first + 1 || !(view.hasVSM() || caching));
+
         const auto* options = entry.shadowMap->getShadowOptions();
         const auto msaaSamples = textureRequirements.msaaSamples;
 
@@ -480,22 +662,30 @@ FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FEngine& engine, FrameG
                     // blurring.
                     data.rt = blur ? data.rt : rt;
                 },
-                [=, &engine, &entry](FrameGraphResources const& resources,
+                [=, &engine, &passList](FrameGraphResources const& resources,
                         auto const& data, DriverApi& driver) {
 
-                    // Note: we capture entry by reference here. That's actually okay because
-                    // `entry` lives in `PrepareShadowPassData` which is guaranteed to still
+                    // Note: we capture passList by reference here. That's actually okay because
+                    // it lives in `PrepareShadowPassData` which is guaranteed to still
                     // be alive when we execute here (all passes stay alive until the FrameGraph
                     // is destroyed).
-                    // It wouldn't work to capture by copy because entry.executor wouldn't be
+                    // It wouldn't work to capture by copy because the executors wouldn't be
                     // initialized, as this happens in an `execute` block.
 
+                    if (passList[first].cached) {
+                        // the layer still has this shadow map from a previous frame
+                        return;
+                    }
+
                     auto rt = resources.getRenderPassInfo(data.rt);
 
                     driver.beginRenderPass(rt.target, rt.params);
-                    entry.shadowMap->bind(driver);
-                    entry.executor.overrideScissor(entry.shadowMap->getScissor());
-                    entry.executor.execute(engine, "Shadow Pass");
+                    for (size_t i = first; i < last; i++) {
+                        auto const& entry = passList[i];
+                        entry.shadowMap->bind(driver);
+                        entry.executor.overrideScissor(entry.shadowMap->getScissor());
+                        entry.executor.execute(engine, "Shadow Pass");
+                    }
                     driver.endRenderPass();
                 });
 
@@ -515,19 +705,18 @@ FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FEngine& engine, FrameG
                         false, kernelWidth, sigma);
             }
 
-            // If the shadow texture has more than one level, mipmapping was requested, either directly
-            // or indirectly via anisotropic filtering.
-            // So generate the mipmaps for each layer
-            if (textureRequirements.levels > 1) {
-                for (size_t level = 0; level < textureRequirements.levels - 1; level++) {
-                    const bool finalize = level == textureRequirements.levels - 2;
-                    ppm.vsmMipmapPass(fg, prepareShadowPass->shadows, layer, level,
-                            vsmClearColor, finalize);
-                }
-            }
+            vsmLayers.set(layer);
         }
     }
 
+    // If the shadow texture has more than one level, mipmapping was requested, either directly
+    // or indirectly via anisotropic filtering.
+    // So generate the mipmaps of every VSM layer, all in one pass.
+    if (vsmLayers.any() && textureRequirements.levels > 1) {
+        engine.getPostProcessManager().vsmMipmapPass(fg, prepareShadowPass->shadows,
+                vsmLayers, textureRequirements.levels, vsmClearColor);
+    }
+
     return prepareShadowPass->shadows;
 }
 
@@ -614,6 +803,7 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateCascadeShadowMaps(FEng
     };
 
     bool hasVisibleShadows = false;
+    mReusedCascades = 0;
     utils::Slice<ShadowMap> cascadedShadowMaps = getCascadedShadowMap();
     if (!cascadedShadowMaps.empty()) {
         // Even if we have more than one cascade, we cull directional shadow casters against the
@@ -639,7 +829,11 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateCascadeShadowMaps(FEng
         if (hasVisibleShadows) {
             Frustum const& frustum = shadowMap.getCamera().getCullingFrustum();
             FView::cullRenderables(engine.getJobSystem(), renderableData, frustum,
-                    VISIBLE_DIR_SHADOW_RENDERABLE_BIT);
+                    VISIBLE_DIR_SHADOW_RENDERABLE_BIT, scene->getCullingHierarchy());
+            if (engine.debug.shadowmap.receivers_cull_casters) {
+                ShadowMap::cullCastersWithReceivers(MvAtOrigin, renderableData,
+                        sceneInfo.visibleLayers);
+            }
         }
     }
 
@@ -690,6 +884,18 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateCascadeShadowMaps(FEng
         // note: normalBias is set to zero for VSM
         const float normalBias = shadowMapInfo.vsm ? 0.0f : 0.5f * lcm.getShadowNormalBias(0);
 
+        // With shadow caching and stable shadows, the first cascade is rendered every frame and
+        // the others in turn, one per frame. In between, a cascade keeps the shadow map and the
+        // uniforms it was last rendered with, as long as it still covers about the same area.
+        // Stable cascades only scroll by whole texels as the camera moves, so this works well.
+        // Note that casters in the far cascades can lag behind by up to cascadeCount-1 frames.
+        const bool reuseCascades = view.isShadowCachingEnabled() && !view.hasVSM() &&
+                params.options.stable && isCachedAtlasValid();
+        size_t refreshedCascade = 0;
+        if (reuseCascades && cascadeCount > 1) {
+            refreshedCascade = 1 + mCascadeUpdateIndex++ % (cascadeCount - 1);
+        }
+
         for (size_t i = 0, c = cascadedShadowMaps.size(); i < c; i++) {
             // Compute the frustum for the directional light.
             ShadowMap& shadowMap = cascadedShadowMaps[i];
@@ -718,6 +924,18 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateCascadeShadowMaps(FEng
                 s.shadows[shadowIndex].bulbRadiusLs =
                         mSoftShadowOptions.penumbraScale * options.shadowBulbRadius / wsTexelSize;
 
+                CachedCascade& cached = mCachedCascades[i];
+                if (reuseCascades && i > 0 && i != refreshedCascade && cached.valid &&
+                        isCascadeReusable(cached.data.lightFromWorldMatrix,
+                                s.shadows[shadowIndex].lightFromWorldMatrix,
+                                shadowMapInfo.textureDimension, shadowMapInfo.atlasDimension)) {
+                    s.shadows[shadowIndex] = cached.data;
+                    mReusedCascades |= 0x1u << i;
+                } else {
+                    cached.data = s.shadows[shadowIndex];
+                    cached.valid = reuseCascades;
+                }
+
                 shadowTechnique |= ShadowTechnique::SHADOW_MAP;
                 cascadeHasVisibleShadows |= 0x1u << i;
             }
@@ -783,8 +1001,8 @@ void ShadowMapManager::prepareSpotShadowMap(ShadowMap& shadowMap, FEngine& engin
     // update the shadow map frustum/camera
     const ShadowMap::ShadowMapInfo shadowMapInfo{
             .atlasDimension      = mTextureAtlasRequirements.size,
-            .textureDimension    = uint16_t(options->mapSize),
-            .shadowDimension     = uint16_t(options->mapSize - 2u),
+            .textureDimension    = shadowMap.getMapSize(),
+            .shadowDimension     = uint16_t(shadowMap.getMapSize() - 2u),
             .textureSpaceFlipped = engine.getBackend() == Backend::METAL ||
                                    engine.getBackend() == Backend::VULKAN,
             .vsm                 = view.hasVSM()
@@ -841,16 +1059,9 @@ void ShadowMapManager::cullSpotShadowMap(ShadowMap const& shadowMap, FEngine& en
     const Frustum frustum(MpMv);
 
     // Cull shadow casters
-    float3 const* worldAABBCenter = renderableData.data<FScene::WORLD_AABB_CENTER>();
-    float3 const* worldAABBExtent = renderableData.data<FScene::WORLD_AABB_EXTENT>();
+    FView::cullRenderables(engine.getJobSystem(), renderableData, frustum,
+            VISIBLE_DYN_SHADOW_RENDERABLE_BIT, range);
     FScene::VisibleMaskType* visibleArray = renderableData.data<FScene::VISIBLE_MASK>();
-    Culler::intersects(
-            visibleArray + range.first,
-            frustum,
-            worldAABBCenter + range.first,
-            worldAABBExtent + range.first,
-            range.size(),
-            VISIBLE_DYN_SHADOW_RENDERABLE_BIT);
 
     // update their visibility mask
     uint8_t const* layers = renderableData.data<FScene::LAYERS>();
@@ -874,8 +1085,8 @@ void ShadowMapManager::preparePointShadowMap(ShadowMap& shadowMap,
     // update the shadow map frustum/camera
     const ShadowMap::ShadowMapInfo shadowMapInfo{
             .atlasDimension      = mTextureAtlasRequirements.size,
-            .textureDimension    = uint16_t(options->mapSize),
-            .shadowDimension     = uint16_t(options->mapSize), // point-lights don't have a border
+            .textureDimension    = shadowMap.getMapSize(),
+            .shadowDimension     = shadowMap.getMapSize(), // point-lights don't have a border
             .textureSpaceFlipped = engine.getBackend() == Backend::METAL ||
                                    engine.getBackend() == Backend::VULKAN,
             .vsm                 = view.hasVSM()
@@ -908,35 +1119,61 @@ void ShadowMapManager::preparePointShadowMap(ShadowMap& shadowMap,
     }
 }
 
-void ShadowMapManager::cullPointShadowMap(ShadowMap const& shadowMap, FView& view,
-        FScene::RenderableSoa& renderableData, utils::Range<uint32_t> range,
+void ShadowMapManager::cullPointShadowMap(ShadowMap const& shadowMap,
+        FView& view, FScene::RenderableSoa& renderableData, utils::Range<uint32_t> range,
         FScene::LightSoa& lightData) noexcept {
 
     const uint8_t face = shadowMap.getFace();
     const size_t lightIndex = shadowMap.getLightIndex();
 
-    // compute the frustum for this light
-    // for spotlights, we cull shadow casters first because we already know the frustum,
-    // this will help us find better near/far plane later
-    const auto position = lightData.elementAt<FScene::POSITION_RADIUS>(lightIndex).xyz;
-    const auto radius = lightData.elementAt<FScene::POSITION_RADIUS>(lightIndex).w;
+    // The six faces of a light see the same casters, which is typically a small fraction of
+    // the renderables, so we find them and cull them against all faces only once per light.
+    auto pos = std::find_if(mPointLightCasters.begin(), mPointLightCasters.end(),
+            [lightIndex](auto const& casters) { return casters.lightIndex == lightIndex; });
+    if (pos == mPointLightCasters.end()) {
+        const auto position = lightData.elementAt<FScene::POSITION_RADIUS>(lightIndex).xyz;
+        const auto radius = lightData.elementAt<FScene::POSITION_RADIUS>(lightIndex).w;
+        float3 const* worldAABBCenter = renderableData.data<FScene::WORLD_AABB_CENTER>();
+        float3 const* worldAABBExtent = renderableData.data<FScene::WORLD_AABB_EXTENT>();
+
+        pos = mPointLightCasters.insert(mPointLightCasters.end(), { lightIndex });
+        std::vector<uint32_t>& indices = pos->indices;
+        for (uint32_t i = range.first; i < range.last; i++) {
+            // distance between the light and the closest point of the box
+            float3 const d = max(abs(worldAABBCenter[i] - position) - worldAABBExtent[i], 0.0f);
+            if (dot(d, d) <= radius * radius) {
+                indices.push_back(i);
+            }
+        }
 
-    // compute shadow map frustum for culling
-    const mat4f Mv = ShadowMap::getPointLightViewMatrix(TextureCubemapFace(face), position);
-    const mat4f Mp = mat4f::perspective(90.0f, 1.0f, 0.01f, radius);
-    const Frustum frustum{ math::highPrecisionMultiply(Mp, Mv) };
+        // the culler processes multiples of Culler::MODULO elements
+        size_t const count = Culler::round(indices.size());
+        std::vector<float3> centers(count);
+        std::vector<float3> extents(count);
+        for (size_t i = 0, c = indices.size(); i < c; i++) {
+            centers[i] = worldAABBCenter[indices[i]];
+            extents[i] = worldAABBExtent[indices[i]];
+        }
+        pos->faces.resize(count);
+        for (size_t f = 0; f < 6; f++) {
+            const mat4f Mv = ShadowMap::getPointLightViewMatrix(TextureCubemapFace(f), position);
+            const mat4f Mp = mat4f::perspective(90.0f, 1.0f, 0.01f, radius);
+            const Frustum frustum{ math::highPrecisionMultiply(Mp, Mv) };
+            Culler::intersects(pos->faces.data(), frustum,
+                    centers.data(), extents.data(), indices.size(), f);
+        }
+    }
 
     // Cull shadow casters
-    float3 const* worldAABBCenter = renderableData.data<FScene::WORLD_AABB_CENTER>();
-    float3 const* worldAABBExtent = renderableData.data<FScene::WORLD_AABB_EXTENT>();
     FScene::VisibleMaskType* visibleArray = renderableData.data<FScene::VISIBLE_MASK>();
-    Culler::intersects(
-            visibleArray + range.first,
-            frustum,
-            worldAABBCenter + range.first,
-            worldAABBExtent + range.first,
-            range.size(),
-            VISIBLE_DYN_SHADOW_RENDERABLE_BIT);
+    for (uint32_t i = range.first; i < range.last; i++) {
+        visibleArray[i] &= ~VISIBLE_DYN_SHADOW_RENDERABLE;
+    }
+    for (size_t i = 0, c = pos->indices.size(); i < c; i++) {
+        if (pos->faces[i] & (1u << face)) {
+            visibleArray[pos->indices[i]] |= VISIBLE_DYN_SHADOW_RENDERABLE;
+        }
+    }
 
     // update their visibility mask
     uint8_t const* layers = renderableData.data<FScene::LAYERS>();
@@ -990,13 +1227,35 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateSpotShadowMaps(FEngine
     return shadowTechnique;
 }
 
+uint16_t ShadowMapManager::computeAdaptiveMapSize(ShadowMap const& shadowMap,
+        FScene::LightSoa const& lightData, CameraInfo const& cameraInfo,
+        uint32_t viewportHeight) noexcept {
+    // We approximate the light's footprint on screen by its sphere of influence, there is no
+    // point in having many more texels in the shadow map than pixels on screen.
+    uint32_t const mapSize = shadowMap.getShadowOptions()->mapSize;
+    float4 const sphere = lightData.elementAt<FScene::POSITION_RADIUS>(shadowMap.getLightIndex());
+    float const distance = length(sphere.xyz - cameraInfo.getPosition());
+    if (distance <= sphere.w) {
+        return uint16_t(mapSize);
+    }
+    bool const perspective = cameraInfo.projection[2].w != 0.0f;
+    float const radius = perspective ? sphere.w / distance : sphere.w;
+    float const diameter = radius * cameraInfo.projection[1].y * float(viewportHeight);
+
+    // don't go below an eighth of the requested size (or 32 texels)
+    uint32_t const minSize = std::max(mapSize / 8u, std::min(mapSize, 32u));
+    uint32_t size = minSize;
+    while (size < mapSize && float(size) < diameter) {
+        size *= 2u;
+    }
+    return uint16_t(std::min(size, mapSize));
+}
+
 void ShadowMapManager::calculateTextureRequirements(FEngine& engine, FView& view,
-        FScene::LightSoa const&) noexcept {
+        CameraInfo const& cameraInfo, FScene::LightSoa const& lightData) noexcept {
 
-    // Lay out the shadow maps. For now, we take the largest requested dimension and allocate a
-    // texture of that size. Each cascade / shadow map gets its own layer in the array texture.
-    // The directional shadow cascades start on layer 0, followed by spotlights.
-    uint8_t layer = 0;
+    // Lay out the shadow maps. The atlas is a texture array whose layers have the largest
+    // dimension in use. The directional shadow cascades come first, followed by spotlights.
     uint32_t maxDimension = 0;
     bool elvsm = false;
     for (ShadowMap& shadowMap : getCascadedShadowMap()) {
@@ -1004,16 +1263,69 @@ void ShadowMapManager::calculateTextureRequirements(FEngine& engine, FView& view
         auto const& options = shadowMap.getShadowOptions();
         maxDimension = std::max(maxDimension, options->mapSize);
         elvsm = elvsm || options->vsm.elvsm;
-        shadowMap.setLayer(layer++);
+        shadowMap.setAtlasRegion(0, 0, uint16_t(options->mapSize));
     }
     for (ShadowMap& shadowMap : getSpotShadowMaps()) {
         auto const& options = shadowMap.getShadowOptions();
-        maxDimension = std::max(maxDimension, options->mapSize);
+        uint16_t const mapSize = view.isAdaptiveShadowResolutionEnabled() ?
+                computeAdaptiveMapSize(shadowMap, lightData, cameraInfo,
+                        view.getViewport().height) :
+                uint16_t(options->mapSize);
+        maxDimension = std::max(maxDimension, uint32_t(mapSize));
         elvsm = elvsm || options->vsm.elvsm;
-        shadowMap.setLayer(layer++);
+        shadowMap.setAtlasRegion(0, 0, mapSize);
     }
 
-    const uint8_t layersNeeded = layer;
+    // Shadow maps smaller than the atlas are packed together in its layers, largest first.
+    // This isn't possible with VSM, which blurs and mipmaps whole layers, nor with shadow
+    // caching, which tracks the content of each layer. Each shadow map then gets its own layer.
+    uint8_t layersNeeded = 0;
+    if (!view.hasVSM() && !view.isShadowCachingEnabled()) {
+        // AtlasAllocator needs a power-of-two, which mapSize should already be
+        uint32_t atlasDimension = 1u;
+        while (atlasDimension < maxDimension) {
+            atlasDimension *= 2u;
+        }
+        maxDimension = atlasDimension;
+
+        utils::FixedCapacityVector<ShadowMap*> shadowMaps = utils::FixedCapacityVector<
+                ShadowMap*>::with_capacity(mDirectionalShadowMapCount + mSpotShadowMapCount);
+        for (ShadowMap& shadowMap : getCascadedShadowMap()) {
+            shadowMaps.push_back(&shadowMap);
+        }
+        for (ShadowMap& shadowMap : getSpotShadowMaps()) {
+            shadowMaps.push_back(&shadowMap);
+        }
+        std::stable_sort(shadowMaps.begin(), shadowMaps.end(),
+                [](ShadowMap const* lhs, ShadowMap const* rhs) {
+                    return lhs->getMapSize() > rhs->getMapSize();
+                });
+
+        AtlasAllocator allocator(maxDimension);
+        for (ShadowMap* shadowMap : shadowMaps) {
+            // AtlasAllocator only handles the four largest sizes, smaller shadow maps
+            // get a region that's larger than they need.
+            uint32_t const mapSize = shadowMap->getMapSize();
+            uint32_t size = maxDimension / 8u;
+            while (size < mapSize) {
+                size *= 2u;
+            }
+            AtlasAllocator::Allocation const allocation = allocator.allocate(size);
+            // we have room for a full layer for each shadow map
+            assert_invariant(allocation.layer >= 0);
+            shadowMap->setLayer(uint8_t(allocation.layer));
+            shadowMap->setAtlasRegion(uint16_t(allocation.viewport.left),
+                    uint16_t(allocation.viewport.bottom), uint16_t(mapSize));
+            layersNeeded = std::max(layersNeeded, uint8_t(allocation.layer + 1));
+        }
+    } else {
+        for (ShadowMap& shadowMap : getCascadedShadowMap()) {
+            shadowMap.setLayer(layersNeeded++);
+        }
+        for (ShadowMap& shadowMap : getSpotShadowMaps()) {
+            shadowMap.setLayer(layersNeeded++);
+        }
+    }
 
     // Generate mipmaps for VSM when anisotropy is enabled or when requested
     auto const& vsmShadowOptions = view.getVsmShadowOptions();
@@ -155,8 +155,13 @@ private:
     ShadowMapManager::ShadowTechnique updateSpotShadowMaps(FEngine& engine,
             FScene::LightSoa const& lightData) noexcept;
 
-    void calculateTextureRequirements(FEngine&, FView& view,
-            FScene::LightSoa const&) noexcept;
+    void calculateTextureRequirements(FEngine&, FView& view, CameraInfo const& cameraInfo,
+            FScene::LightSoa const& lightData) noexcept;
+
+    // Returns the dimension of a spot or point shadow map, given the light's screen coverage.
+    static uint16_t computeAdaptiveMapSize(ShadowMap const& shadowMap,
+            FScene::LightSoa const& lightData, CameraInfo const& cameraInfo,
+            uint32_t viewportHeight) noexcept;
 
     void prepareSpotShadowMap(ShadowMap& shadowMap,
             FEngine& engine, FView& view, CameraInfo const& mainCameraInfo,
@@ -171,10 +176,32 @@ private:
             FEngine& engine, FView& view, CameraInfo const& mainCameraInfo,
             FScene::LightSoa& lightData) noexcept;
 
-    static void cullPointShadowMap(ShadowMap const& shadowMap, FView& view,
+    void cullPointShadowMap(ShadowMap const& shadowMap, FView& view,
             FScene::RenderableSoa& renderableData, utils::Range<uint32_t> range,
             FScene::LightSoa& lightData) noexcept;
 
+    // Returns a key identifying the content of a spot or point shadow map, or 0 if it can't be
+    // cached. Must be called after culling.
+    uint64_t computeCacheKey(ShadowMap const& shadowMap,
+            FScene::RenderableSoa const& renderableData, utils::Range<uint32_t> range,
+            FScene::LightSoa const& lightData) const noexcept;
+
+    // Returns whether the given cascade can keep the shadow map it was rendered with, given
+    // its current light-space transform.
+    static bool isCascadeReusable(math::mat4f const& cachedLightFromWorld,
+            math::mat4f const& lightFromWorld, uint16_t textureDimension,
+            uint16_t atlasDimension) noexcept;
+
+    // Whether the cached atlas exists and matches mTextureAtlasRequirements.
+    bool isCachedAtlasValid() const noexcept;
+
+    struct TextureAtlasRequirements;
+
+    FrameGraphId<FrameGraphTexture> importCachedAtlas(FEngine& engine, FrameGraph& fg,
+            TextureAtlasRequirements const& textureRequirements) noexcept;
+
+    void destroyCachedAtlas(backend::DriverApi& driver) noexcept;
+
     static void updateSpotVisibilityMasks(
             uint8_t visibleLayers,
             uint8_t const* UTILS_RESTRICT layers,
@@ -219,8 +246,33 @@ private:
         backend::TextureFormat format = backend::TextureFormat::DEPTH16;
     } mTextureAtlasRequirements;
 
+    // With shadow caching, the atlas persists across frames, and we remember the content of
+    // each of its layers (0 when unknown), see computeCacheKey().
+    backend::Handle<backend::HwTexture> mCachedAtlas;
+    TextureAtlasRequirements mCachedAtlasRequirements;
+    std::array<uint64_t, CONFIG_MAX_SHADOW_LAYERS> mCachedLayerKeys{};
+
+    // The uniforms each cascade was last rendered with, see updateCascadeShadowMaps().
+    struct CachedCascade {
+        ShadowUib::ShadowData data;
+        bool valid = false;
+    };
+    std::array<CachedCascade, CONFIG_MAX_SHADOW_CASCADES> mCachedCascades{};
+    uint32_t mReusedCascades = 0;      // cascades not rendered this frame, one bit per cascade
+    uint32_t mCascadeUpdateIndex = 0;  // round-robin counter for the far cascades
+
     SoftShadowOptions mSoftShadowOptions;
 
+    // The shadow casters of a point light, i.e. the renderables intersecting its sphere of
+    // influence, with one bit per cubemap face they are visible from. They are culled once for
+    // the six faces of the light, and only valid while the shadow passes are prepared.
+    struct PointLightCasters {
+        size_t lightIndex;
+        std::vector<uint32_t> indices;
+        std::vector<Culler::result_type> faces;
+    };
+    std::vector<PointLightCasters> mPointLightCasters;
+
     mutable TypedUniformBuffer<ShadowUib> mShadowUb;
     backend::Handle<backend::HwBufferObject> mShadowUbh;
 
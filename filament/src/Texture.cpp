@@ -74,6 +74,10 @@ void Texture::generateMipmaps(Engine& engine) const noexcept {
     downcast(this)->generateMipmaps(downcast(engine));
 }
 
+void Texture::setMinMaxLevels(Engine& engine, uint8_t minLevel, uint8_t maxLevel) {
+    downcast(this)->setMinMaxLevels(downcast(engine), minLevel, maxLevel);
+}
+
 bool Texture::isTextureFormatSupported(Engine& engine, InternalFormat format) noexcept {
     return FTexture::isTextureFormatSupported(downcast(engine), format);
 }
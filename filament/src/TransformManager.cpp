@@ -70,6 +70,16 @@ void TransformManager::setTransform(Instance ci, const mat4& model) noexcept {
     downcast(this)->setTransform(ci, model);
 }
 
+void TransformManager::setTransforms(Instance const* instances, const mat4f* localTransforms,
+        size_t count) noexcept {
+    downcast(this)->setTransforms(instances, localTransforms, count);
+}
+
+void TransformManager::setTransforms(Instance const* instances, const float3* translations,
+        const quatf* rotations, const float3* scales, size_t count) noexcept {
+    downcast(this)->setTransforms(instances, translations, rotations, scales, count);
+}
+
 const mat4f& TransformManager::getTransform(Instance ci) const noexcept {
     return downcast(this)->getTransform(ci);
 }
@@ -111,6 +121,18 @@ void TransformManager::commitLocalTransformTransaction() noexcept {
     downcast(this)->commitLocalTransformTransaction();
 }
 
+void TransformManager::setSnapshotEnabled(bool enable) noexcept {
+    downcast(this)->setSnapshotEnabled(enable);
+}
+
+bool TransformManager::isSnapshotEnabled() const noexcept {
+    return downcast(this)->isSnapshotEnabled();
+}
+
+void TransformManager::publishSnapshot() noexcept {
+    downcast(this)->publishSnapshot();
+}
+
 TransformManager::children_iterator TransformManager::getChildrenBegin(
         TransformManager::Instance parent) const noexcept {
     return downcast(this)->getChildrenBegin(parent);
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "UniformBufferArena.h"
+
+#include <backend/BufferDescriptor.h>
+#include <backend/DriverEnums.h>
+
+#include "private/backend/DriverApi.h"
+
+#include <utils/Systrace.h>
+#include <utils/debug.h>
+
+#include <algorithm>
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace filament {
+
+using namespace backend;
+
+UniformBufferArena::UniformBufferArena() noexcept = default;
+
+UniformBufferArena::~UniformBufferArena() noexcept {
+    assert_invariant(!mHandle);
+}
+
+void UniformBufferArena::terminate(DriverApi& driver) noexcept {
+    if (mHandle) {
+        driver.destroyBufferObject(mHandle);
+        mHandle.clear();
+    }
+}
+
+UniformBufferArena::Allocation UniformBufferArena::allocate(uint32_t size) noexcept {
+    assert_invariant(size);
+    size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+    auto pos = std::find_if(mFreeList.begin(), mFreeList.end(),
+            [size](Range const& range) { return range.size >= size; });
+    if (UTILS_UNLIKELY(pos == mFreeList.end())) {
+        grow(size);
+        // after grow() the last free range is large enough
+        pos = mFreeList.end() - 1;
+        assert_invariant(pos->size >= size);
+    }
+
+    Allocation const allocation{ pos->offset, size };
+    pos->offset += size;
+    pos->size -= size;
+    if (pos->size == 0) {
+        mFreeList.erase(pos);
+    }
+    return allocation;
+}
+
+void UniformBufferArena::free(Allocation allocation) noexcept {
+    if (!allocation.size) {
+        return;
+    }
+    assert_invariant(allocation.offset + allocation.size <= mStorage.size());
+
+    // insert the range in order and merge it with its neighbours
+    auto next = std::upper_bound(mFreeList.begin(), mFreeList.end(), allocation.offset,
+            [](uint32_t offset, Range const& range) { return offset < range.offset; });
+    auto pos = mFreeList.insert(next, { allocation.offset, allocation.size });
+    if (pos + 1 != mFreeList.end() && pos->offset + pos->size == (pos + 1)->offset) {
+        pos->size += (pos + 1)->size;
+        mFreeList.erase(pos + 1);
+    }
+    if (pos != mFreeList.begin() && (pos - 1)->offset + (pos - 1)->size == pos->offset) {
+        (pos - 1)->size += pos->size;
+        mFreeList.erase(pos);
+    }
+}
+
+void UniformBufferArena::write(Allocation allocation, void const* data, uint32_t size) noexcept {
+    assert_invariant(size <= allocation.size);
+    assert_invariant(allocation.offset + allocation.size <= mStorage.size());
+    memcpy(mStorage.data() + allocation.offset, data, size);
+    mDirtyBegin = std::min(mDirtyBegin, allocation.offset);
+    mDirtyEnd = std::max(mDirtyEnd, allocation.offset + size);
+}
+
+void UniformBufferArena::commit(DriverApi& driver) noexcept {
+    uint32_t begin = mDirtyBegin;
+    uint32_t end = mDirtyEnd;
+
+    if (UTILS_UNLIKELY(mResized)) {
+        SYSTRACE_CALL();
+        // draws that were already recorded keep using the old buffer object
+        if (mHandle) {
+            driver.destroyBufferObject(mHandle);
+        }
+        mHandle = driver.createBufferObject(uint32_t(mStorage.size()),
+                BufferObjectBinding::UNIFORM, BufferUsage::DYNAMIC);
+        mResized = false;
+        begin = 0;
+        end = uint32_t(mStorage.size());
+    }
+
+    if (begin < end) {
+        uint32_t const size = end - begin;
+        void* const buffer = malloc(size);
+        memcpy(buffer, mStorage.data() + begin, size);
+        driver.updateBufferObject(mHandle, BufferDescriptor{ buffer, size,
+                [](void* buffer, size_t, void*) { ::free(buffer); } }, begin);
+    }
+
+    mDirtyBegin = UINT32_MAX;
+    mDirtyEnd = 0;
+}
+
+void UniformBufferArena::grow(uint32_t size) noexcept {
+    uint32_t const capacity = uint32_t(mStorage.size());
+
+    // space already free at the end of the arena counts toward the request
+    uint32_t tail = 0;
+    if (!mFreeList.empty() && mFreeList.back().offset + mFreeList.back().size == capacity) {
+        tail = mFreeList.back().size;
+    }
+
+    uint32_t newCapacity = std::max(MIN_CAPACITY, capacity * 2);
+    while (newCapacity - capacity + tail < size) {
+        newCapacity *= 2;
+    }
+
+    mStorage.resize(newCapacity);
+    if (tail) {
+        mFreeList.back().size += newCapacity - capacity;
+    } else {
+        mFreeList.push_back({ capacity, newCapacity - capacity });
+    }
+    mResized = true;
+}
+
+} // namespace filament
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_UNIFORMBUFFERARENA_H
+#define TNT_FILAMENT_UNIFORMBUFFERARENA_H
+
+#include <backend/DriverApiForward.h>
+#include <backend/Handle.h>
+
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+/*
+ * A single uniform buffer object shared by many small uniform blocks, e.g. the uniforms of all
+ * material instances.
+ *
+ * Each block gets a range of the buffer, aligned so that it can be bound with bindBufferRange().
+ * Writes go to a CPU copy of the buffer and commit() uploads everything that changed since the
+ * last commit with a single updateBufferObject(), instead of one per block.
+ *
+ * When it runs out of space the buffer is replaced with one twice as large, so the handle
+ * returned by getHandle() is only valid until the next commit().
+ */
+class UniformBufferArena {
+public:
+    // this is the largest uniform buffer offset alignment we can encounter
+    static constexpr uint32_t ALIGNMENT = 256;
+
+    struct Allocation {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    UniformBufferArena() noexcept;
+    ~UniformBufferArena() noexcept;
+
+    UniformBufferArena(UniformBufferArena const&) = delete;
+    UniformBufferArena& operator=(UniformBufferArena const&) = delete;
+
+    // destroys the buffer object, no allocation can be in use
+    void terminate(backend::DriverApi& driver) noexcept;
+
+    // reserves a range of at least size bytes, its content is undefined
+    Allocation allocate(uint32_t size) noexcept;
+
+    // returns a range to the arena
+    void free(Allocation allocation) noexcept;
+
+    // copies size bytes (at most allocation.size) to the given range; this is uploaded by
+    // the next commit()
+    void write(Allocation allocation, void const* data, uint32_t size) noexcept;
+
+    // the CPU copy of a range, valid until the next allocate()
+    void const* data(Allocation allocation) const noexcept {
+        return mStorage.data() + allocation.offset;
+    }
+
+    // uploads the ranges written since the last commit, creating the buffer object if needed
+    void commit(backend::DriverApi& driver) noexcept;
+
+    backend::Handle<backend::HwBufferObject> getHandle() const noexcept { return mHandle; }
+
+    // size of the buffer object in bytes
+    size_t getCapacity() const noexcept { return mStorage.size(); }
+
+private:
+    struct Range {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    static constexpr uint32_t MIN_CAPACITY = 64 * 1024;
+
+    void grow(uint32_t size) noexcept;
+
+    backend::Handle<backend::HwBufferObject> mHandle;
+    std::vector<uint8_t> mStorage;
+    // free ranges, sorted by offset and never adjacent to one another
+    std::vector<Range> mFreeList;
+    // range written since the last commit, empty when mDirtyBegin >= mDirtyEnd
+    uint32_t mDirtyBegin = UINT32_MAX;
+    uint32_t mDirtyEnd = 0;
+    // the buffer object must be (re)created with the current capacity
+    bool mResized = false;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_UNIFORMBUFFERARENA_H
@@ -55,6 +55,54 @@ bool View::isFrustumCullingEnabled() const noexcept {
     return downcast(this)->isFrustumCullingEnabled();
 }
 
+void View::setOcclusionCullingEnabled(bool enabled) noexcept {
+    downcast(this)->setOcclusionCullingEnabled(enabled);
+}
+
+bool View::isOcclusionCullingEnabled() const noexcept {
+    return downcast(this)->isOcclusionCullingEnabled();
+}
+
+void View::setLightDepthBoundsEnabled(bool enabled) noexcept {
+    downcast(this)->setLightDepthBoundsEnabled(enabled);
+}
+
+bool View::isLightDepthBoundsEnabled() const noexcept {
+    return downcast(this)->isLightDepthBoundsEnabled();
+}
+
+void View::setShadowCachingEnabled(bool enabled) noexcept {
+    downcast(this)->setShadowCachingEnabled(enabled);
+}
+
+bool View::isShadowCachingEnabled() const noexcept {
+    return downcast(this)->isShadowCachingEnabled();
+}
+
+void View::setAdaptiveShadowResolutionEnabled(bool enabled) noexcept {
+    downcast(this)->setAdaptiveShadowResolutionEnabled(enabled);
+}
+
+bool View::isAdaptiveShadowResolutionEnabled() const noexcept {
+    return downcast(this)->isAdaptiveShadowResolutionEnabled();
+}
+
+void View::setTemporalAmbientOcclusionEnabled(bool enabled) noexcept {
+    downcast(this)->setTemporalAmbientOcclusionEnabled(enabled);
+}
+
+bool View::isTemporalAmbientOcclusionEnabled() const noexcept {
+    return downcast(this)->isTemporalAmbientOcclusionEnabled();
+}
+
+void View::setPostProcessingBudget(float milliseconds) noexcept {
+    downcast(this)->setPostProcessingBudget(milliseconds);
+}
+
+float View::getPostProcessingBudget() const noexcept {
+    return downcast(this)->getPostProcessingBudget();
+}
+
 void View::setDebugCamera(Camera* camera) noexcept {
     downcast(this)->setViewingCamera(downcast(camera));
 }
@@ -300,6 +348,11 @@ View::PickingQuery& View::pick(uint32_t x, uint32_t y, backend::CallbackHandler*
     return downcast(this)->pick(x, y, handler, callback);
 }
 
+void View::pick(math::uint2 const* points, size_t count, backend::CallbackHandler* handler,
+        View::PickingQueriesResultCallback callback, void* user) noexcept {
+    downcast(this)->pick(points, count, handler, callback, user);
+}
+
 void View::setMaterialGlobal(uint32_t index, math::float4 const& value) {
     downcast(this)->setMaterialGlobal(index, value);
 }
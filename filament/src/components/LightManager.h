@@ -62,6 +62,11 @@ public:
         return mManager.getComponentCount();
     }
 
+    // changes whenever an Entity's Instance may have changed
+    uint32_t getVersion() const noexcept {
+        return mManager.getVersion();
+    }
+
     bool empty() const noexcept {
         return mManager.empty();
     }
@@ -94,6 +94,7 @@ struct RenderableManager::BuilderDetails {
     uint32_t mSkinningBufferOffset = 0;
     utils::FixedCapacityVector<math::float2> mBoneIndicesAndWeights;
     size_t mBoneIndicesAndWeightsCount = 0;
+    std::vector<float> mLevelOfDetailScreenSizes;
 
     // bone indices and weights defined for primitive index
     std::unordered_map<size_t, utils::FixedCapacityVector<
@@ -314,6 +315,20 @@ RenderableManager::Builder& RenderableManager::Builder::globalBlendOrderEnabled(
     return *this;
 }
 
+RenderableManager::Builder& RenderableManager::Builder::levelOfDetail(
+        size_t index, uint8_t level) noexcept {
+    if (index < mImpl->mEntries.size()) {
+        mImpl->mEntries[index].levelOfDetail = level;
+    }
+    return *this;
+}
+
+RenderableManager::Builder& RenderableManager::Builder::levelOfDetailScreenSizes(
+        float const* screenSizes, size_t count) noexcept {
+    mImpl->mLevelOfDetailScreenSizes.assign(screenSizes, screenSizes + count);
+    return *this;
+}
+
 UTILS_NOINLINE
 void RenderableManager::BuilderDetails::processBoneIndicesAndWights(Engine& engine, Entity entity) {
     size_t maxPairsCount = 0; //size of texture, number of bone pairs
@@ -468,6 +483,24 @@ RenderableManager::Builder::Result RenderableManager::Builder::build(Engine& eng
         mImpl->processBoneIndicesAndWights(engine, entity);
     }
 
+    uint8_t levelCount = 1;
+    for (size_t i = 0, c = mImpl->mEntries.size(); i < c; i++) {
+        uint8_t const level = mImpl->mEntries[i].levelOfDetail;
+        FILAMENT_CHECK_PRECONDITION(level < MAX_LEVEL_OF_DETAIL_COUNT)
+                << "[primitive @ " << i << "] level of detail " << +level << " >= "
+                << +MAX_LEVEL_OF_DETAIL_COUNT;
+        FILAMENT_CHECK_PRECONDITION(level == levelCount - 1 || level == levelCount)
+                << "[primitive @ " << i << "] level of detail " << +level
+                << " isn't contiguous or is out of order";
+        levelCount = level + 1;
+    }
+    FILAMENT_CHECK_PRECONDITION(mImpl->mLevelOfDetailScreenSizes.size() == levelCount - 1u)
+            << "got " << mImpl->mLevelOfDetailScreenSizes.size()
+            << " level of detail screen sizes for " << +levelCount << " levels of detail";
+    FILAMENT_CHECK_PRECONDITION(std::is_sorted(mImpl->mLevelOfDetailScreenSizes.rbegin(),
+            mImpl->mLevelOfDetailScreenSizes.rend()))
+            << "level of detail screen sizes must be decreasing";
+
     for (size_t i = 0, c = mImpl->mEntries.size(); i < c; i++) {
         auto& entry = mImpl->mEntries[i];
 
@@ -569,6 +602,19 @@ void FRenderableManager::create(
         }
         setPrimitives(ci, { rp, size_type(entryCount) });
 
+        // the builder has checked that the levels are contiguous and in increasing order
+        uint8_t const levelCount = entryCount ? entries[entryCount - 1].levelOfDetail + 1 : 1;
+        if (UTILS_UNLIKELY(levelCount > 1)) {
+            LevelsOfDetail* const lods = new LevelsOfDetail{};
+            lods->count = levelCount;
+            for (size_t i = 0; i < entryCount; ++i) {
+                lods->offsets[entries[i].levelOfDetail + 1] = uint32_t(i + 1);
+            }
+            std::copy_n(builder->mLevelOfDetailScreenSizes.data(), levelCount - 1,
+                    lods->screenSizes);
+            manager[ci].levelsOfDetail = lods;
+        }
+
         setAxisAlignedBoundingBox(ci, builder->mAABB);
         setLayerMask(ci, builder->mLayerMask);
         setPriority(ci, builder->mPriority);
@@ -698,7 +744,7 @@ void FRenderableManager::create(
                         sizeof(PerRenderableMorphingUib),
                         BufferObjectBinding::UNIFORM,
                         backend::BufferUsage::DYNAMIC),
-                .count = targetCount };
+                .count = uint16_t(targetCount) };
 
             for (size_t i = 0; i < entryCount; ++i) {
                 const auto& morphing = builder->mEntries[i].morphing;
@@ -763,6 +809,8 @@ void FRenderableManager::destroyComponent(Instance ci) noexcept {
     // See create(RenderableManager::Builder&, Entity)
     destroyComponentPrimitives(mHwRenderPrimitiveFactory, driver, manager[ci].primitives);
     destroyComponentMorphTargets(engine, manager[ci].morphTargets);
+    delete static_cast<LevelsOfDetail*>(manager[ci].levelsOfDetail);
+    manager[ci].levelsOfDetail = nullptr;
 
     // destroy the bones structures if any
     Bones const& bones = manager[ci].bones;
@@ -961,9 +1009,20 @@ void FRenderableManager::setMorphWeights(Instance instance, float const* weights
                 << "Only " << CONFIG_MAX_MORPH_TARGET_COUNT
                 << " morph targets are supported (count=" << count << ", offset=" << offset << ")";
 
-        MorphWeights const& morphWeights = mManager[instance].morphWeights;
+        MorphWeights& morphWeights = mManager[instance].morphWeights;
         if (morphWeights.handle) {
             updateMorphWeights(mEngine, morphWeights.handle, weights, count, offset);
+
+            // Trailing zero weights don't contribute, so the shader can skip their targets. The
+            // active count is only lowered when this update covers the end of the active range.
+            size_t last = count;
+            while (last > 0 && weights[last - 1] == 0.0f) {
+                last--;
+            }
+            if (offset + count >= morphWeights.activeCount) {
+                morphWeights.activeCount = uint16_t(last ? offset + last :
+                        std::min(offset, size_t(morphWeights.activeCount)));
+            }
         }
     }
 }
@@ -1040,4 +1099,23 @@ size_t FRenderableManager::getPrimitiveCount(Instance instance, uint8_t level) c
     return getRenderPrimitives(instance, level).size();
 }
 
+Slice<FRenderPrimitive> FRenderableManager::getLevelPrimitives(
+        Instance instance, uint8_t level) const noexcept {
+    Slice<FRenderPrimitive> const& primitives = getRenderPrimitives(instance, level);
+    LevelsOfDetail const* const lods = mManager[instance].levelsOfDetail;
+    if (!lods) {
+        return primitives;
+    }
+    assert_invariant(level < lods->count);
+    return { primitives.data() + lods->offsets[level],
+             lods->offsets[level + 1] - lods->offsets[level] };
+}
+
+FRenderableManager::MorphTargets const* FRenderableManager::getLevelMorphTargets(
+        Instance instance, uint8_t level) const noexcept {
+    MorphTargets const* const morphTargets = getMorphTargets(instance, level).data();
+    LevelsOfDetail const* const lods = mManager[instance].levelsOfDetail;
+    return lods ? morphTargets + lods->offsets[level] : morphTargets;
+}
+
 } // namespace filament
@@ -110,6 +110,11 @@ public:
         return mManager.getComponentCount();
     }
 
+    // changes whenever an Entity's Instance may have changed
+    uint32_t getVersion() const noexcept {
+        return mManager.getVersion();
+    }
+
     bool empty() const noexcept {
         return mManager.empty();
     }
@@ -205,7 +210,18 @@ public:
     static_assert(sizeof(InstancesInfo) == 16);
     inline InstancesInfo getInstancesInfo(Instance instance) const noexcept;
 
-    inline size_t getLevelCount(Instance) const noexcept { return 1u; }
+    inline size_t getLevelCount(Instance instance) const noexcept;
+
+    // Returns the level of detail of a renderable whose bounding sphere has the given diameter
+    // relative to the viewport height.
+    inline uint8_t getLevelOfDetail(Instance instance, float screenSize) const noexcept;
+
+    // Returns the primitives and their morph targets of the given level of detail. Unlike
+    // getRenderPrimitives() and getMorphTargets(), which always return all the primitives.
+    utils::Slice<FRenderPrimitive> getLevelPrimitives(Instance instance,
+            uint8_t level) const noexcept;
+    MorphTargets const* getLevelMorphTargets(Instance instance, uint8_t level) const noexcept;
+
     size_t getPrimitiveCount(Instance instance, uint8_t level) const noexcept;
     void setMaterialInstanceAt(Instance instance, uint8_t level,
             size_t primitiveIndex, FMaterialInstance const* materialInstance);
@@ -241,10 +257,23 @@ private:
 
     struct MorphWeights {
         backend::Handle<backend::HwBufferObject> handle;
-        uint32_t count = 0;
+        uint16_t count = 0;
+        // upper bound of one plus the index of the last non-zero weight; the vertex shader only
+        // iterates over those targets.
+        uint16_t activeCount = 0;
     };
     static_assert(sizeof(MorphWeights) == 8);
 
+    // Only allocated for renderables that have more than one level of detail.
+    struct LevelsOfDetail {
+        static constexpr size_t MAX_COUNT = RenderableManager::Builder::MAX_LEVEL_OF_DETAIL_COUNT;
+        // the primitives of level i are [offsets[i], offsets[i + 1])
+        uint32_t offsets[MAX_COUNT + 1];
+        // level i + 1 is drawn below screenSizes[i]
+        float screenSizes[MAX_COUNT - 1];
+        uint8_t count;
+    };
+
     enum {
         AABB,                   // user data
         LAYERS,                 // user data
@@ -254,7 +283,8 @@ private:
         VISIBILITY,             // user data
         PRIMITIVES,             // user data
         BONES,                  // filament data, UBO storing a pointer to the bones information
-        MORPH_TARGETS
+        MORPH_TARGETS,
+        LEVELS_OF_DETAIL        // user data
     };
 
     using Base = utils::SingleInstanceComponentManager<
@@ -266,7 +296,8 @@ private:
             Visibility,                      // VISIBILITY
             utils::Slice<FRenderPrimitive>,  // PRIMITIVES
             Bones,                           // BONES
-            utils::Slice<MorphTargets>       // MORPH_TARGETS
+            utils::Slice<MorphTargets>,      // MORPH_TARGETS
+            LevelsOfDetail*                  // LEVELS_OF_DETAIL
     >;
 
     struct Sim : public Base {
@@ -290,6 +321,7 @@ private:
                 Field<PRIMITIVES>           primitives;
                 Field<BONES>                bones;
                 Field<MORPH_TARGETS>        morphTargets;
+                Field<LEVELS_OF_DETAIL>     levelsOfDetail;
             };
         };
 
@@ -462,7 +494,7 @@ FRenderableManager::MorphingBindingInfo
 FRenderableManager::getMorphingBufferInfo(Instance instance) const noexcept {
     MorphWeights const& morphWeights = mManager[instance].morphWeights;
     utils::Slice<MorphTargets> const& morphTargets = getMorphTargets(instance, 0);
-    return { morphWeights.handle, morphWeights.count, morphTargets.data() };
+    return { morphWeights.handle, morphWeights.activeCount, morphTargets.data() };
 }
 
 FRenderableManager::InstancesInfo
@@ -490,6 +522,22 @@ utils::Slice<FRenderableManager::MorphTargets>& FRenderableManager::getMorphTarg
     return mManager[instance].morphTargets;
 }
 
+size_t FRenderableManager::getLevelCount(Instance instance) const noexcept {
+    LevelsOfDetail const* const lods = mManager[instance].levelsOfDetail;
+    return lods ? lods->count : 1u;
+}
+
+uint8_t FRenderableManager::getLevelOfDetail(Instance instance, float screenSize) const noexcept {
+    LevelsOfDetail const* const lods = mManager[instance].levelsOfDetail;
+    uint8_t level = 0;
+    if (lods) {
+        while (level < lods->count - 1 && screenSize < lods->screenSizes[level]) {
+            level++;
+        }
+    }
+    return level;
+}
+
 } // namespace filament
 
 #endif // TNT_FILAMENT_COMPONENTS_RENDERABLEMANAGER_H
@@ -16,9 +16,12 @@
 
 #include "components/TransformManager.h"
 
+#include <math/mat3.h>
 #include <math/mat4.h>
+#include <math/quat.h>
 
 #include <utils/debug.h>
+#include <utils/JobSystem.h>
 #include <filament/TransformManager.h>
 
 
@@ -29,6 +32,10 @@ namespace filament {
 
 FTransformManager::FTransformManager() noexcept = default;
 
+FTransformManager::FTransformManager(JobSystem* jobSystem) noexcept
+        : mJobSystem(jobSystem) {
+}
+
 FTransformManager::~FTransformManager() noexcept = default;
 
 void FTransformManager::terminate() noexcept {
@@ -38,8 +45,12 @@ void FTransformManager::setAccurateTranslationsEnabled(bool enable) noexcept {
     if (enable != mAccurateTranslations) {
         mAccurateTranslations = enable;
         // when enabling accurate translations, we have to recompute all world transforms
-        if (enable && !mLocalTransformTransactionOpen) {
-            computeAllWorldTransforms();
+        if (enable) {
+            if (mLocalTransformTransactionOpen) {
+                mFullUpdateNeeded = true;
+            } else {
+                computeAllWorldTransforms();
+            }
         }
     }
 }
@@ -102,10 +113,14 @@ void FTransformManager::setParent(Instance i, Instance parent) noexcept {
             removeNode(i);
             insertNode(i, parent);
             updateNodeTransform(i);
+            invalidateSnapshot();
             // Note: setParent() doesn't reorder the child after the parent in the array,
             // but that's not a problem because TransformManager doesn't rely on that.
-            // Also note that commitLocalTransformTransaction() does reorder all children after
-            // their parent, as an optimization to calculate the world transform.
+            // Also note that the next commitLocalTransformTransaction() reorders all children
+            // after their parent, as an optimization to calculate the world transform.
+            if (parent > i) {
+                mFullUpdateNeeded = true;
+            }
         }
     }
 }
@@ -154,15 +169,23 @@ void FTransformManager::destroy(Entity e) noexcept {
         Instance child = manager[i].firstChild;
         while (child) {
             manager[child].parent = 0;
+            if (UTILS_UNLIKELY(mLocalTransformTransactionOpen)) {
+                manager[child].dirty = true;
+            }
             child = manager[child].next;
         }
 
-        // 2) remove the component
+        // 2) remove the component, which moves the last one, so the snapshot is now stale
         Instance const moved = manager.removeComponent(e);
+        invalidateSnapshot();
 
         // 3) update the references to the entry now with Instance i
         if (moved != i) {
             updateNode(i);
+            // the moved node may now be sorted before its children
+            if (Instance(manager[i].firstChild)) {
+                mFullUpdateNeeded = true;
+            }
         }
     }
 }
@@ -189,8 +212,56 @@ void FTransformManager::setTransform(Instance ci, const mat4& model) noexcept {
     }
 }
 
+void FTransformManager::setTransforms(Instance const* UTILS_RESTRICT instances,
+        const mat4f* UTILS_RESTRICT localTransforms, size_t count) noexcept {
+    auto& soa = mManager.getSoA();
+    mat4f* const UTILS_RESTRICT local = soa.data<LOCAL>();
+    float3* const UTILS_RESTRICT localLo = soa.data<LOCAL_LO>();
+    bool* const UTILS_RESTRICT dirty = soa.data<DIRTY>();
+    for (size_t k = 0; k < count; k++) {
+        Instance const i = instances[k];
+        assert_invariant(i);
+        local[i] = localTransforms[k];
+        localLo[i] = {};
+        dirty[i] = true;
+    }
+    propagateTransforms();
+}
+
+void FTransformManager::setTransforms(Instance const* UTILS_RESTRICT instances,
+        const float3* UTILS_RESTRICT translations, const quatf* UTILS_RESTRICT rotations,
+        const float3* UTILS_RESTRICT scales, size_t count) noexcept {
+    auto& soa = mManager.getSoA();
+    mat4f* const UTILS_RESTRICT local = soa.data<LOCAL>();
+    float3* const UTILS_RESTRICT localLo = soa.data<LOCAL_LO>();
+    bool* const UTILS_RESTRICT dirty = soa.data<DIRTY>();
+    for (size_t k = 0; k < count; k++) {
+        Instance const i = instances[k];
+        assert_invariant(i);
+        mat3f const r{ rotations[k] };
+        local[i] = mat4f{
+                float4{ r[0] * scales[k].x, 0 },
+                float4{ r[1] * scales[k].y, 0 },
+                float4{ r[2] * scales[k].z, 0 },
+                float4{ translations[k], 1 }};
+        localLo[i] = {};
+        dirty[i] = true;
+    }
+    propagateTransforms();
+}
+
+void FTransformManager::propagateTransforms() noexcept {
+    // during a transaction, the nodes we flagged are picked up by the commit
+    if (UTILS_LIKELY(!mLocalTransformTransactionOpen)) {
+        computeDirtyWorldTransforms();
+    }
+}
+
 void FTransformManager::updateNodeTransform(Instance i) noexcept {
     if (UTILS_UNLIKELY(mLocalTransformTransactionOpen)) {
+        // Only flag the node, so that transforms of distinct nodes can be set concurrently
+        // while a transaction is open.
+        mManager[i].dirty = true;
         return;
     }
 
@@ -221,12 +292,102 @@ void FTransformManager::openLocalTransformTransaction() noexcept {
 void FTransformManager::commitLocalTransformTransaction() noexcept {
     if (mLocalTransformTransactionOpen) {
         mLocalTransformTransactionOpen = false;
-        computeAllWorldTransforms();
+        if (UTILS_UNLIKELY(mFullUpdateNeeded)) {
+            computeAllWorldTransforms();
+        } else {
+            computeDirtyWorldTransforms();
+        }
+    }
+}
+
+void FTransformManager::setSnapshotEnabled(bool enable) noexcept {
+    if (enable != mSnapshotEnabled) {
+        mSnapshotEnabled = enable;
+        mSnapshot = {};
+        if (enable) {
+            // start with the current transforms, so that the snapshot is never stale with
+            // respect to the state before it was enabled
+            publishSnapshot();
+        }
+    }
+}
+
+void FTransformManager::publishSnapshot() noexcept {
+    if (UTILS_UNLIKELY(mSnapshotEnabled)) {
+        // this includes the unused entry at index 0, so the snapshot is indexed by Instance
+        auto& soa = mManager.getSoA();
+        size_t const size = soa.size();
+        mSnapshot.local.assign(soa.data<LOCAL>(), soa.data<LOCAL>() + size);
+        mSnapshot.world.assign(soa.data<WORLD>(), soa.data<WORLD>() + size);
+        mSnapshot.worldTranslationLo.assign(soa.data<WORLD_LO>(), soa.data<WORLD_LO>() + size);
+    }
+}
+
+void FTransformManager::invalidateSnapshot() noexcept {
+    // until the next publishSnapshot(), the current transforms are used
+    mSnapshot.local.clear();
+    mSnapshot.world.clear();
+    mSnapshot.worldTranslationLo.clear();
+}
+
+void FTransformManager::computeDirtyWorldTransforms() noexcept {
+    auto& manager = mManager;
+
+    // Find the roots of the subtrees that need to be updated, i.e. the dirty nodes without any
+    // dirty ancestor. These subtrees are disjoint, and none of them contains the parent of
+    // another root, so they can be updated independently.
+    auto& roots = mDirtyRoots;
+    roots.clear();
+    for (Instance i = manager.begin(), e = manager.end(); i != e; ++i) {
+        if (UTILS_UNLIKELY(manager[i].dirty)) {
+            Instance parent = manager[i].parent;
+            while (parent && !manager[parent].dirty) {
+                parent = manager[parent].parent;
+            }
+            if (!parent) {
+                roots.push_back(i);
+            }
+        }
+    }
+
+    JobSystem* const js = mJobSystem;
+    if (js && roots.size() >= JOBS_PARALLEL_FOR_TRANSFORM_ROOTS_COUNT * 2) {
+        auto work = [this](Instance const* data, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                transformSubtree(mManager, data[i]);
+            }
+        };
+        auto* job = jobs::parallel_for(*js, nullptr, roots.data(), uint32_t(roots.size()),
+                std::cref(work), jobs::CountSplitter<JOBS_PARALLEL_FOR_TRANSFORM_ROOTS_COUNT>());
+        js->runAndWait(job);
+    } else {
+        for (Instance const root : roots) {
+            transformSubtree(manager, root);
+        }
+    }
+}
+
+void FTransformManager::transformSubtree(Sim& manager, Instance i) noexcept {
+    Instance const parent = manager[i].parent;
+    FTransformManager::computeWorldTransform(
+            manager[i].world, manager[i].worldTranslationLo,
+            manager[parent].world, manager[i].local,
+            manager[parent].worldTranslationLo, manager[i].localTranslationLo,
+            mAccurateTranslations);
+    manager[i].dirty = false;
+
+    Instance const child = manager[i].firstChild;
+    if (UTILS_UNLIKELY(child)) {
+        transformChildren(manager, child);
     }
 }
 
 void FTransformManager::computeAllWorldTransforms() noexcept {
     auto& manager = mManager;
+    mFullUpdateNeeded = false;
+
+    // nodes can be reordered below
+    invalidateSnapshot();
 
     // swapNode() below needs some temporary storage which we provide here
     const bool accurate = mAccurateTranslations;
@@ -246,6 +407,7 @@ void FTransformManager::computeAllWorldTransforms() noexcept {
                 manager[parent].world, manager[i].local,
                 manager[parent].worldTranslationLo, manager[i].localTranslationLo,
                 accurate);
+        manager[i].dirty = false;
     }
 }
 
@@ -285,6 +447,7 @@ void FTransformManager::swapNode(Instance i, Instance j) noexcept {
     std::swap(manager.elementAt<LOCAL_LO>(i), manager.elementAt<LOCAL_LO>(j));
     std::swap(manager.elementAt<WORLD>(i),    manager.elementAt<WORLD>(j));
     std::swap(manager.elementAt<WORLD_LO>(i), manager.elementAt<WORLD_LO>(j));
+    std::swap(manager.elementAt<DIRTY>(i),    manager.elementAt<DIRTY>(j));
     manager.swap(i, j); // this swaps the data relative to SingleInstanceComponentManager
 
     // now swap the linked-list references, to do that correctly we must use a temporary
@@ -381,6 +544,7 @@ void FTransformManager::transformChildren(Sim& manager, Instance i) noexcept {
                 manager[parent].world, manager[i].local,
                 manager[parent].worldTranslationLo, manager[i].localTranslationLo,
                 accurate);
+        manager[i].dirty = false;
 
         // assume we don't have a deep hierarchy
         Instance const child = manager[i].firstChild;
@@ -28,6 +28,12 @@
 
 #include <math/mat4.h>
 
+#include <vector>
+
+namespace utils {
+class JobSystem;
+} // namespace utils
+
 namespace filament {
 
 class UTILS_PRIVATE FTransformManager : public TransformManager {
@@ -35,6 +41,11 @@ public:
     using Instance = TransformManager::Instance;
 
     FTransformManager() noexcept;
+
+    // When a JobSystem is provided, independent subtrees are updated in parallel when a local
+    // transform transaction is committed.
+    explicit FTransformManager(utils::JobSystem* jobSystem) noexcept;
+
     ~FTransformManager() noexcept;
 
     // free-up all resources
@@ -57,6 +68,11 @@ public:
         return mManager.getComponentCount();
     }
 
+    // changes whenever an Entity's Instance may have changed
+    uint32_t getVersion() const noexcept {
+        return mManager.getVersion();
+    }
+
     bool empty() const noexcept {
         return mManager.empty();
     }
@@ -99,6 +115,34 @@ public:
 
     void commitLocalTransformTransaction() noexcept;
 
+    void setSnapshotEnabled(bool enable) noexcept;
+
+    bool isSnapshotEnabled() const noexcept {
+        return mSnapshotEnabled;
+    }
+
+    void publishSnapshot() noexcept;
+
+    // Variants of getTransform() and getWorldTransformAccurate() used during Scene preparation,
+    // which return the published snapshot when it is enabled. Components created since the last
+    // publishSnapshot() are not in the snapshot, and their current transforms are used instead.
+    // The same applies to all components after a change that moves instances (e.g. destroy()).
+    const math::mat4f& getPublishedTransform(Instance ci) const noexcept {
+        if (UTILS_LIKELY(!mSnapshotEnabled) || ci.asValue() >= mSnapshot.local.size()) {
+            return getTransform(ci);
+        }
+        return mSnapshot.local[ci];
+    }
+
+    math::mat4 getPublishedWorldTransformAccurate(Instance ci) const noexcept {
+        if (UTILS_LIKELY(!mSnapshotEnabled) || ci.asValue() >= mSnapshot.world.size()) {
+            return getWorldTransformAccurate(ci);
+        }
+        math::mat4 r(mSnapshot.world[ci]);
+        r[3].xyz += mSnapshot.worldTranslationLo[ci];
+        return r;
+    }
+
     void gc(utils::EntityManager& em) noexcept;
 
     utils::Slice<const math::mat4f> getWorldTransforms() const noexcept {
@@ -109,6 +153,12 @@ public:
 
     void setTransform(Instance ci, const math::mat4& model) noexcept;
 
+    void setTransforms(Instance const* instances, const math::mat4f* localTransforms,
+            size_t count) noexcept;
+
+    void setTransforms(Instance const* instances, const math::float3* translations,
+            const math::quatf* rotations, const math::float3* scales, size_t count) noexcept;
+
     const math::mat4f& getTransform(Instance ci) const noexcept {
         return mManager[ci].local;
     }
@@ -136,6 +186,9 @@ public:
 private:
     struct Sim;
 
+    // Number of subtrees updated by each job of commitLocalTransformTransaction().
+    static constexpr size_t JOBS_PARALLEL_FOR_TRANSFORM_ROOTS_COUNT = 16;
+
     void validateNode(Instance i) noexcept;
     void removeNode(Instance i) noexcept;
     void updateNode(Instance i) noexcept;
@@ -145,6 +198,10 @@ private:
     void transformChildren(Sim& manager, Instance firstChild) noexcept;
 
     void computeAllWorldTransforms() noexcept;
+    void computeDirtyWorldTransforms() noexcept;
+    void propagateTransforms() noexcept;
+    void invalidateSnapshot() noexcept;
+    void transformSubtree(Sim& manager, Instance root) noexcept;
 
     static void computeWorldTransform(math::mat4f& outWorld, math::float3& inoutWorldTranslationLo,
             math::mat4f const& pt, math::mat4f const& local,
@@ -162,6 +219,7 @@ private:
         FIRST_CHILD,    // instance to our first child
         NEXT,           // instance to our next sibling
         PREV,           // instance to our previous sibling
+        DIRTY,          // local transform changed during the current transaction
     };
 
     using Base = utils::SingleInstanceComponentManager<
@@ -172,7 +230,8 @@ private:
             Instance,       // parent
             Instance,       // firstChild
             Instance,       // next
-            Instance        // prev
+            Instance,       // prev
+            bool            // dirty
     >;
 
     struct Sim : public Base {
@@ -197,6 +256,7 @@ private:
                 Field<FIRST_CHILD>  firstChild;
                 Field<NEXT>         next;
                 Field<PREV>         prev;
+                Field<DIRTY>        dirty;
             };
         };
 
@@ -208,9 +268,21 @@ private:
         }
     };
 
+    // Copy of the transforms read by Scene preparation, indexed by Instance.
+    struct Snapshot {
+        std::vector<math::mat4f> local;
+        std::vector<math::mat4f> world;
+        std::vector<math::float3> worldTranslationLo;
+    };
+
     Sim mManager;
+    Snapshot mSnapshot;
+    utils::JobSystem* mJobSystem = nullptr;
+    std::vector<Instance> mDirtyRoots;      // scratch storage for commitLocalTransformTransaction()
     bool mLocalTransformTransactionOpen = false;
+    bool mFullUpdateNeeded = false;         // set when nodes must be sorted, or all are dirty
     bool mAccurateTranslations = false;
+    bool mSnapshotEnabled = false;
 };
 
 FILAMENT_DOWNCAST(TransformManager)
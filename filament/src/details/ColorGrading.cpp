@@ -33,10 +33,13 @@
 #include <utils/Mutex.h>
 #include <utils/Systrace.h>
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstdlib>
 #include <mutex>
 #include <tuple>
+#include <utility>
 
 namespace filament {
 
@@ -637,6 +640,95 @@ struct Config {
     ColorTransform oetf;
 };
 
+//------------------------------------------------------------------------------
+// LUT cache
+//------------------------------------------------------------------------------
+
+using ToneMapperResponse = FColorGrading::LutCache::ToneMapperResponse;
+
+// Tone mappers are opaque, so they're compared by their response to a few inputs, spread over
+// the range of the LUT and with different ratios between the channels.
+static ToneMapperResponse sampleToneMapper(ToneMapper const& toneMapper) noexcept {
+    ToneMapperResponse response;
+    for (size_t i = 0; i < response.size(); i++) {
+        float const x = std::exp2(float(i) - 10.0f);
+        response[i] = toneMapper(float3{ x, x * 0.37f, x * 2.9f });
+    }
+    return response;
+}
+
+struct FColorGrading::LutCache::Entry {
+    // a copy of the builder, without the tone mapper which is represented by its response
+    ColorGrading::Builder builder;
+    ToneMapperResponse toneMapperResponse;
+    backend::TextureHandle handle;
+    uint32_t dimension;
+    uint32_t refCount;
+    // orders the entries that are no longer used, from the least to the most recently released
+    uint32_t releaseIndex;
+};
+
+FColorGrading::LutCache::LutCache() noexcept = default;
+
+FColorGrading::LutCache::~LutCache() noexcept {
+    assert_invariant(mEntries.empty());
+}
+
+void FColorGrading::LutCache::terminate(DriverApi& driver) noexcept {
+    for (auto const& entry : mEntries) {
+        assert_invariant(!entry.refCount);
+        driver.destroyTexture(entry.handle);
+    }
+    mEntries.clear();
+}
+
+FColorGrading::LutCache::Entry* FColorGrading::findLut(LutCache& cache,
+        Builder const& builder, ToneMapperResponse const& toneMapperResponse) noexcept {
+    for (auto& entry : cache.mEntries) {
+        // BuilderDetails doesn't compare the tone mappers, and toneMapping selects the
+        // color grading color space
+        if (*entry.builder.mImpl == *builder.mImpl &&
+                entry.builder->toneMapping == builder->toneMapping &&
+                entry.toneMapperResponse == toneMapperResponse) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void FColorGrading::releaseLut(LutCache& cache, DriverApi& driver,
+        TextureHandle handle) noexcept {
+    auto& entries = cache.mEntries;
+    auto pos = std::find_if(entries.begin(), entries.end(),
+            [handle](auto const& entry) { return entry.handle == handle; });
+    assert_invariant(pos != entries.end());
+    assert_invariant(pos->refCount);
+    if (--pos->refCount) {
+        return;
+    }
+    pos->releaseIndex = ++cache.mReleaseCount;
+
+    // only keep the most recently released LUTs
+    size_t unusedCount = std::count_if(entries.begin(), entries.end(),
+            [](auto const& entry) { return !entry.refCount; });
+    while (unusedCount > LutCache::UNUSED_LUT_COUNT) {
+        auto oldest = entries.end();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (!it->refCount &&
+                    (oldest == entries.end() || it->releaseIndex < oldest->releaseIndex)) {
+                oldest = it;
+            }
+        }
+        driver.destroyTexture(oldest->handle);
+        entries.erase(oldest);
+        unusedCount--;
+    }
+}
+
+//------------------------------------------------------------------------------
+// FColorGrading
+//------------------------------------------------------------------------------
+
 // Inside the FColorGrading constructor, TSAN sporadically detects a data race on the config struct;
 // the Filament thread writes and the Job thread reads. In practice there should be no data race, so
 // we force TSAN off to silence the warning.
@@ -646,6 +738,16 @@ FColorGrading::FColorGrading(FEngine& engine, const Builder& builder) {
 
     DriverApi& driver = engine.getDriverApi();
 
+    // reuse the LUT of a color grading with the same parameters if there is one
+    LutCache& cache = engine.getColorGradingLutCache();
+    ToneMapperResponse const toneMapperResponse = sampleToneMapper(*builder->toneMapper);
+    if (LutCache::Entry* const entry = findLut(cache, builder, toneMapperResponse)) {
+        entry->refCount++;
+        mLutHandle = entry->handle;
+        mDimension = entry->dimension;
+        return;
+    }
+
     Config c;
     // This lock protects the data inside Config, which is written to by the Filament thread,
     // and read from multiple Job threads.
@@ -838,13 +940,18 @@ FColorGrading::FColorGrading(FEngine& engine, const Builder& builder) {
                     [](void* buffer, size_t, void*) { free(buffer); }
             }
     );
+
+    // the tone mapper isn't kept, it can be destroyed as soon as this color grading is built
+    Builder key{ builder };
+    key.toneMapper(nullptr);
+    cache.mEntries.push_back({ std::move(key), toneMapperResponse, mLutHandle,
+            mDimension, 1, 0 });
 }
 
 FColorGrading::~FColorGrading() noexcept = default;
 
 void FColorGrading::terminate(FEngine& engine) {
-    DriverApi& driver = engine.getDriverApi();
-    driver.destroyTexture(mLutHandle);
+    releaseLut(engine.getColorGradingLutCache(), engine.getDriverApi(), mLutHandle);
 }
 
 } //namespace filament
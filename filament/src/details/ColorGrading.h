@@ -19,6 +19,7 @@
 
 #include "downcast.h"
 
+#include <backend/DriverApiForward.h>
 #include <backend/DriverEnums.h>
 #include <backend/Handle.h>
 
@@ -26,12 +27,43 @@
 
 #include <math/mathfwd.h>
 
+#include <array>
+#include <vector>
+
 namespace filament {
 
 class FEngine;
 
 class FColorGrading : public ColorGrading {
 public:
+    /*
+     * Color gradings built with identical parameters share their LUT. The LUTs of the last few
+     * destroyed color gradings are kept, so that switching back and forth between presets doesn't
+     * generate them again. Owned by FEngine, and only used from the engine thread.
+     */
+    class LutCache {
+    public:
+        LutCache() noexcept;
+        ~LutCache() noexcept;
+
+        // destroys the remaining LUTs
+        void terminate(backend::DriverApi& driver) noexcept;
+
+        // tone mappers are compared by their output for this many inputs
+        static constexpr size_t TONE_MAPPER_SAMPLE_COUNT = 16;
+        using ToneMapperResponse = std::array<math::float3, TONE_MAPPER_SAMPLE_COUNT>;
+
+    private:
+        friend class FColorGrading;
+        struct Entry;
+
+        // number of LUTs no longer used by any color grading that are kept
+        static constexpr size_t UNUSED_LUT_COUNT = 4;
+
+        std::vector<Entry> mEntries;
+        uint32_t mReleaseCount = 0;
+    };
+
     FColorGrading(FEngine& engine, const Builder& builder);
     FColorGrading(const FColorGrading& rhs) = delete;
     FColorGrading& operator=(const FColorGrading& rhs) = delete;
@@ -46,6 +78,12 @@ public:
     uint32_t getDimension() const noexcept { return mDimension; }
 
 private:
+    static LutCache::Entry* findLut(LutCache& cache, Builder const& builder,
+            LutCache::ToneMapperResponse const& toneMapperResponse) noexcept;
+
+    static void releaseLut(LutCache& cache, backend::DriverApi& driver,
+            backend::TextureHandle handle) noexcept;
+
     backend::TextureHandle mLutHandle;
     uint32_t mDimension;
 };
@@ -16,6 +16,7 @@
 
 #include "details/Engine.h"
 
+#include "FrameSkipper.h"
 #include "MaterialParser.h"
 #include "ResourceAllocator.h"
 #include "RenderPrimitive.h"
@@ -106,6 +107,13 @@ Engine* FEngine::create(Engine::Builder const& builder) {
                 .disableHandleUseAfterFreeCheck = instance->getConfig().disableHandleUseAfterFreeCheck,
                 .forceGLES2Context = instance->getConfig().forceGLES2Context,
                 .stereoscopicType =  instance->getConfig().stereoscopicType,
+                .asynchronousPipelineCreation = instance->getConfig().asynchronousPipelineCreation,
+                .programCachePrewarmCount = instance->getConfig().programCachePrewarmCount,
+                .shaderCompilerThreadCount = instance->getConfig().shaderCompilerThreadCount,
+                .handleArenaPoolWeights = {
+                        instance->getConfig().driverHandleArenaPoolWeights[0],
+                        instance->getConfig().driverHandleArenaPoolWeights[1],
+                        instance->getConfig().driverHandleArenaPoolWeights[2] },
         };
         instance->mDriver = platform->createDriver(sharedContext, driverConfig);
 
@@ -200,7 +208,7 @@ FEngine::FEngine(Engine::Builder const& builder) :
         mPostProcessManager(*this),
         mEntityManager(EntityManager::get()),
         mRenderableManager(*this),
-        mTransformManager(),
+        mTransformManager(&mJobSystem),
         mLightManager(*this),
         mCameraManager(*this),
         mCommandBufferQueue(
@@ -488,6 +496,7 @@ void FEngine::shutdown() {
     cleanupResourceList(std::move(mScenes));
     cleanupResourceList(std::move(mSkyboxes));
     cleanupResourceList(std::move(mColorGradings));
+    mColorGradingLutCache.terminate(driver);
 
     // this must be done after Skyboxes and before materials
     destroy(mSkyboxMaterial);
@@ -505,6 +514,12 @@ void FEngine::shutdown() {
         cleanupResourceList(std::move(item.second));
     }
 
+    // this must be done after all material instances are destroyed
+    mUniformBufferArena.terminate(driver);
+
+    // this must be done after all materials are destroyed
+    mHwProgramFactory.terminate(driver);
+
     cleanupResourceListLocked(mFenceListLock, std::move(mFences));
 
     driver.destroyTexture(mDummyOneTexture);
@@ -553,11 +568,15 @@ void FEngine::prepare() {
     // prepare() is called once per Renderer frame. Ideally we would upload the content of
     // UBOs that are visible only. It's not such a big issue because the actual upload() is
     // skipped if the UBO hasn't changed. Still we could have a lot of these.
+    // Most material instances keep their uniforms in mUniformBufferArena, which is uploaded
+    // once after all of them are committed.
     FEngine::DriverApi& driver = getDriverApi();
 
+    mFrameIndex++;
+
     for (auto& materialInstanceList: mMaterialInstances) {
         materialInstanceList.second.forEach([&driver](FMaterialInstance* item) {
-            item->commit(driver);
+            item->commitDeferred(driver);
         });
     }
 
@@ -566,8 +585,10 @@ void FEngine::prepare() {
 #if FILAMENT_ENABLE_MATDBG
         material->checkProgramEdits();
 #endif
-        material->getDefaultInstance()->commit(driver);
+        material->getDefaultInstance()->commitDeferred(driver);
     });
+
+    mUniformBufferArena.commit(driver);
 }
 
 void FEngine::gc() {
@@ -680,6 +701,13 @@ int FEngine::loop() {
             .disableHandleUseAfterFreeCheck = mConfig.disableHandleUseAfterFreeCheck,
             .forceGLES2Context = mConfig.forceGLES2Context,
             .stereoscopicType =  mConfig.stereoscopicType,
+            .asynchronousPipelineCreation = mConfig.asynchronousPipelineCreation,
+            .programCachePrewarmCount = mConfig.programCachePrewarmCount,
+            .shaderCompilerThreadCount = mConfig.shaderCompilerThreadCount,
+            .handleArenaPoolWeights = {
+                    mConfig.driverHandleArenaPoolWeights[0],
+                    mConfig.driverHandleArenaPoolWeights[1],
+                    mConfig.driverHandleArenaPoolWeights[2] },
     };
     mDriver = mPlatform->createDriver(mSharedGLContext, driverConfig);
 
@@ -1208,6 +1236,8 @@ bool FEngine::execute() {
     }
 
     // execute all command buffers
+    FrameTimingsRecorder::Scope const timing(mFrameTimingsRecorder,
+            FrameTimingsRecorder::Stage::DRIVER_EXECUTE);
     auto& driver = getDriverApi();
     for (auto& item : buffers) {
         if (UTILS_LIKELY(item.begin)) {
@@ -1226,6 +1256,126 @@ void FEngine::destroy(FEngine* engine) {
     }
 }
 
+Engine::CommandBufferStats FEngine::getCommandBufferStats() const noexcept {
+    return {
+            .capacity = getCommandBufferSize(),
+            .minCapacity = getMinCommandBufferSize(),
+            .highWatermark = mCommandBufferQueue.getHighWatermark(),
+            .flushStallDuration = mCommandBufferQueue.getFlushStallDuration(),
+            .waitForCommandsDuration = mCommandBufferQueue.getWaitForCommandsDuration()
+    };
+}
+
+backend::HandleAllocatorStats FEngine::getHandleAllocatorStats() noexcept {
+    return getDriverApi().getHandleAllocatorStats();
+}
+
+Engine::MemoryStats FEngine::getMemoryStats() const noexcept {
+    MemoryStats stats{
+            .commandBuffer = getCommandBufferSize(),
+            .perRenderPassArena = getPerRenderPassArenaSize(),
+    };
+    mTextures.forEach([&stats](FTexture const* p) {
+        stats.textures += p->getStorageSize();
+    });
+    mBufferObjects.forEach([&stats](FBufferObject const* p) {
+        stats.bufferObjects += p->getByteCount();
+    });
+    mVertexBuffers.forEach([&stats](FVertexBuffer const* p) {
+        stats.vertexBuffers += p->getByteCount();
+    });
+    mIndexBuffers.forEach([&stats](FIndexBuffer const* p) {
+        stats.indexBuffers += p->getByteCount();
+    });
+    mSkinningBuffers.forEach([&stats](FSkinningBuffer const* p) {
+        stats.skinningBuffers += p->getByteCount();
+    });
+    mMorphTargetBuffers.forEach([&stats](FMorphTargetBuffer const* p) {
+        stats.morphTargetBuffers += p->getByteCount();
+    });
+    if (mResourceAllocator) {
+        stats.resourceAllocatorCache = mResourceAllocator->getCacheSize();
+    }
+    stats.perRenderPassArenaHighWatermark = mPerRenderPassArena.getListener().getHighWatermark();
+    mRenderers.forEach([&stats](FRenderer const* p) {
+        stats.perFrameCommandsHighWatermark =
+                std::max(stats.perFrameCommandsHighWatermark, p->getCommandsHighWatermark());
+    });
+    return stats;
+}
+
+// A variant manifest is a header followed by, for each material, its cache id, the number of its
+// recorded variants and their keys. All values are little-endian.
+static constexpr uint32_t VARIANT_MANIFEST_MAGIC = 0x464d5646; // 'FVMF'
+static constexpr uint32_t VARIANT_MANIFEST_VERSION = 1;
+static constexpr size_t VARIANT_MANIFEST_HEADER_SIZE = 3 * sizeof(uint32_t);
+static constexpr size_t VARIANT_MANIFEST_ENTRY_SIZE = sizeof(uint64_t) + sizeof(uint32_t);
+
+size_t FEngine::getVariantManifest(void* data, size_t size) const noexcept {
+    size_t required = VARIANT_MANIFEST_HEADER_SIZE;
+    for (auto const& [cacheId, variants] : mRecordedVariants) {
+        required += VARIANT_MANIFEST_ENTRY_SIZE + variants.count();
+    }
+    if (!data || size < required) {
+        return required;
+    }
+
+    uint8_t* p = static_cast<uint8_t*>(data);
+    auto write = [&p](auto value) {
+        memcpy(p, &value, sizeof(value));
+        p += sizeof(value);
+    };
+    write(VARIANT_MANIFEST_MAGIC);
+    write(VARIANT_MANIFEST_VERSION);
+    write(uint32_t(mRecordedVariants.size()));
+    for (auto const& [cacheId, variants] : mRecordedVariants) {
+        write(cacheId);
+        write(uint32_t(variants.count()));
+        variants.forEachSetBit([&](size_t key) {
+            write(uint8_t(key));
+        });
+    }
+    assert_invariant(p == static_cast<uint8_t*>(data) + required);
+    return required;
+}
+
+VariantList FEngine::getVariantManifestEntry(
+        void const* manifest, size_t size, uint64_t cacheId) noexcept {
+    VariantList variants;
+    uint8_t const* p = static_cast<uint8_t const*>(manifest);
+    uint8_t const* const end = p + size;
+    auto read = [&p, end](auto& value) {
+        if (size_t(end - p) < sizeof(value)) {
+            return false;
+        }
+        memcpy(&value, p, sizeof(value));
+        p += sizeof(value);
+        return true;
+    };
+
+    uint32_t magic = 0, version = 0, count = 0;
+    if (!manifest || !read(magic) || !read(version) || !read(count) ||
+            magic != VARIANT_MANIFEST_MAGIC || version != VARIANT_MANIFEST_VERSION) {
+        slog.w << "invalid variant manifest" << io::endl;
+        return variants;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t id = 0;
+        uint32_t variantCount = 0;
+        if (!read(id) || !read(variantCount) || size_t(end - p) < variantCount) {
+            slog.w << "truncated variant manifest" << io::endl;
+            return {};
+        }
+        if (id == cacheId) {
+            for (uint32_t j = 0; j < variantCount; j++) {
+                variants.set(p[j]);
+            }
+        }
+        p += variantCount;
+    }
+    return variants;
+}
+
 bool FEngine::isPaused() const noexcept {
     return mCommandBufferQueue.isPaused();
 }
@@ -1345,6 +1495,9 @@ Engine::Config Engine::BuilderDetails::validateConfig(const Config* const pConfi
     config.stereoscopicEyeCount =
             std::clamp(config.stereoscopicEyeCount, uint8_t(1), CONFIG_MAX_STEREOSCOPIC_EYES);
 
+    config.maxFramesInFlight = std::clamp(config.maxFramesInFlight,
+            uint32_t(1), uint32_t(FrameSkipper::MAX_FRAME_LATENCY));
+
     return config;
 }
 
@@ -21,8 +21,11 @@
 
 #include "Allocators.h"
 #include "DFG.h"
+#include "FrameTimings.h"
+#include "HwProgramFactory.h"
 #include "PostProcessManager.h"
 #include "ResourceList.h"
+#include "UniformBufferArena.h"
 #include "HwVertexBufferInfoFactory.h"
 
 #include "components/CameraManager.h"
@@ -47,6 +50,7 @@
 #include "private/backend/DriverApi.h"
 
 #include <private/filament/EngineEnums.h>
+#include <private/filament/Variant.h>
 #include <private/filament/BufferInterfaceBlock.h>
 
 #include <filament/ColorGrading.h>
@@ -144,7 +148,12 @@ public:
     // the per-frame Area is used by all Renderer, so they must run in sequence and
     // have freed all allocated memory when done. If this needs to change in the future,
     // we'll simply have to use separate Areas (for instance).
-    LinearAllocatorArena& getPerRenderPassArena() noexcept { return mPerRenderPassArena; }
+    PerRenderPassArena& getPerRenderPassArena() noexcept { return mPerRenderPassArena; }
+
+    FrameTimingsRecorder& getFrameTimingsRecorder() noexcept { return mFrameTimingsRecorder; }
+    FrameTimingsRecorder const& getFrameTimingsRecorder() const noexcept {
+        return mFrameTimingsRecorder;
+    }
 
     // Material IDs...
     uint32_t getMaterialId() const noexcept { return mMaterialId++; }
@@ -154,6 +163,8 @@ public:
     const FIndirectLight* getDefaultIndirectLight() const noexcept { return mDefaultIbl; }
     const FTexture* getDummyCubemap() const noexcept { return mDefaultIblTexture; }
     const FColorGrading* getDefaultColorGrading() const noexcept { return mDefaultColorGrading; }
+
+    FColorGrading::LutCache& getColorGradingLutCache() noexcept { return mColorGradingLutCache; }
     FMorphTargetBuffer* getDummyMorphTargetBuffer() const { return mDummyMorphTargetBuffer; }
 
     backend::Handle<backend::HwRenderPrimitive> getFullScreenRenderPrimitive() const noexcept {
@@ -200,6 +211,10 @@ public:
         return mPostProcessManager;
     }
 
+    HwProgramFactory& getHwProgramFactory() noexcept {
+        return mHwProgramFactory;
+    }
+
     FRenderableManager& getRenderableManager() noexcept {
         return mRenderableManager;
     }
@@ -259,6 +274,15 @@ public:
         return *mResourceAllocator;
     }
 
+    UniformBufferArena& getUniformBufferArena() noexcept {
+        return mUniformBufferArena;
+    }
+
+    // incremented by each call to prepare(), i.e. once per Renderer frame
+    uint32_t getFrameIndex() const noexcept {
+        return mFrameIndex;
+    }
+
     void* streamAlloc(size_t size, size_t alignment) noexcept;
 
     Epoch getEngineEpoch() const { return mEngineEpoch; }
@@ -349,8 +373,22 @@ public:
     void destroy(utils::Entity e);
 
     bool isPaused() const noexcept;
+
+    CommandBufferStats getCommandBufferStats() const noexcept;
+    backend::HandleAllocatorStats getHandleAllocatorStats() noexcept;
+    MemoryStats getMemoryStats() const noexcept;
     void setPaused(bool paused);
 
+    void setVariantRecordingEnabled(bool enabled) noexcept { mVariantRecordingEnabled = enabled; }
+    bool isVariantRecordingEnabled() const noexcept { return mVariantRecordingEnabled; }
+    void recordVariant(uint64_t cacheId, Variant variant) noexcept {
+        mRecordedVariants[cacheId].set(variant.key);
+    }
+    size_t getVariantManifest(void* data, size_t size) const noexcept;
+    // returns the variants of the material with the given cache id listed in a manifest
+    static VariantList getVariantManifestEntry(
+            void const* manifest, size_t size, uint64_t cacheId) noexcept;
+
     void flushAndWait();
 
     // flush the current buffer
@@ -475,6 +513,9 @@ private:
     Platform* mPlatform = nullptr;
     bool mOwnPlatform = false;
     bool mAutomaticInstancingEnabled = false;
+    bool mVariantRecordingEnabled = false;
+    // variants recorded per material cache id, see Engine::setVariantRecordingEnabled()
+    std::unordered_map<uint64_t, VariantList> mRecordedVariants;
     void* mSharedGLContext = nullptr;
     backend::Handle<backend::HwRenderPrimitive> mFullScreenTriangleRph;
     FVertexBuffer* mFullScreenTriangleVb = nullptr;
@@ -482,6 +523,7 @@ private:
     math::mat4f mUvFromClipMatrix;
 
     PostProcessManager mPostProcessManager;
+    HwProgramFactory mHwProgramFactory;
 
     utils::EntityManager& mEntityManager;
     FRenderableManager mRenderableManager;
@@ -489,6 +531,8 @@ private:
     FLightManager mLightManager;
     FCameraManager mCameraManager;
     ResourceAllocator* mResourceAllocator = nullptr;
+    UniformBufferArena mUniformBufferArena;
+    uint32_t mFrameIndex = 0;
     HwVertexBufferInfoFactory mHwVertexBufferInfoFactory;
 
     ResourceList<FBufferObject> mBufferObjects{ "BufferObject" };
@@ -528,6 +572,7 @@ private:
     uint32_t mFlushCounter = 0;
 
     RootArenaScope::Arena mPerRenderPassArena;
+    FrameTimingsRecorder mFrameTimingsRecorder;
     HeapAllocatorArena mHeapAllocator;
 
     utils::JobSystem mJobSystem;
@@ -544,6 +589,7 @@ private:
     mutable FIndirectLight* mDefaultIbl = nullptr;
 
     mutable FColorGrading* mDefaultColorGrading = nullptr;
+    FColorGrading::LutCache mColorGradingLutCache;
     FMorphTargetBuffer* mDummyMorphTargetBuffer = nullptr;
 
     mutable utils::CountDownLatch mDriverBarrier;
@@ -572,6 +618,7 @@ public:
             bool focus_shadowcasters = true;
             bool visualize_cascades = false;
             bool tightly_bound_scene = true;
+            bool receivers_cull_casters = true;
             float dzn = -1.0f;
             float dzf =  1.0f;
             float display_shadow_texture_scale = 0.25f;
@@ -40,12 +40,15 @@ public:
 
     size_t getIndexCount() const noexcept { return mIndexCount; }
 
+    size_t getByteCount() const noexcept { return mIndexCount * mIndexSize; }
+
     void setBuffer(FEngine& engine, BufferDescriptor&& buffer, uint32_t byteOffset = 0);
 
 private:
     friend class IndexBuffer;
     backend::Handle<backend::HwIndexBuffer> mHandle;
     uint32_t mIndexCount;
+    uint8_t mIndexSize;
 };
 
 FILAMENT_DOWNCAST(IndexBuffer)
@@ -24,6 +24,8 @@
 #include <math/mat3.h>
 #include <math/vec3.h>
 
+#include <string.h>
+
 namespace filament {
 
 using namespace backend;
@@ -80,14 +82,29 @@ void FInstanceBuffer::setLocalTransforms(
             << " instances, but trying to set " << count 
             << " transforms at offset " << offset << ".";
     memcpy(mLocalTransforms.data() + offset, localTransforms, sizeof(math::mat4f) * count);
+    mLocalTransformsChanged = true;
 }
 
 void FInstanceBuffer::prepare(FEngine& engine, math::mat4f rootTransform,
         const PerRenderableData& ubo, Handle<HwBufferObject> handle) {
     DriverApi& driver = engine.getDriverApi();
 
+    // The buffer object keeps its content, so there is nothing to do if neither the instances
+    // nor the renderable changed since they were last uploaded to it. This is typically the case
+    // of static instanced geometry.
+    if (!mLocalTransformsChanged && mPreparedHandle == handle &&
+            !memcmp(&mPreparedRootTransform, &rootTransform, sizeof(rootTransform)) &&
+            !memcmp(&mPreparedUbo, &ubo, sizeof(ubo))) {
+        return;
+    }
+    mLocalTransformsChanged = false;
+    mPreparedHandle = handle;
+    mPreparedRootTransform = rootTransform;
+    mPreparedUbo = ubo;
+
+    // Only the instances are uploaded, the rest of the UBO is never read.
     // TODO: allocate this staging buffer from a pool.
-    uint32_t stagingBufferSize = sizeof(PerRenderableUib);
+    uint32_t const stagingBufferSize = uint32_t(sizeof(PerRenderableData) * mInstanceCount);
     PerRenderableData* stagingBuffer = (PerRenderableData*)::malloc(stagingBufferSize);
     // TODO: consider using JobSystem to parallelize this.
     for (size_t i = 0, c = mInstanceCount; i < c; i++) {
@@ -23,6 +23,8 @@
 
 #include <backend/Handle.h>
 
+#include <private/filament/UibStructs.h>
+
 #include <math/mat4.h>
 
 #include <utils/FixedCapacityVector.h>
@@ -31,8 +33,6 @@ namespace filament {
 
 class FEngine;
 
-struct PerRenderableData;
-
 class FInstanceBuffer : public InstanceBuffer {
 public:
     FInstanceBuffer(FEngine& engine, const Builder& builder);
@@ -51,6 +51,12 @@ private:
 
     utils::FixedCapacityVector<math::mat4f> mLocalTransforms;
     size_t mInstanceCount;
+
+    // What was last uploaded by prepare(), so that unchanged instances aren't uploaded again.
+    math::mat4f mPreparedRootTransform;
+    PerRenderableData mPreparedUbo;
+    backend::Handle<backend::HwBufferObject> mPreparedHandle;
+    bool mLocalTransformsChanged = true;
 };
 
 FILAMENT_DOWNCAST(InstanceBuffer)
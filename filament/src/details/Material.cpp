@@ -68,6 +68,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 namespace filament {
 
@@ -75,11 +76,18 @@ using namespace backend;
 using namespace filaflat;
 using namespace utils;
 
-static std::unique_ptr<MaterialParser> createParser(Backend backend,
-        utils::FixedCapacityVector<ShaderLanguage> languages, const void* data, size_t size) {
-    // unique_ptr so we don't leak MaterialParser on failures below
-    auto materialParser = std::make_unique<MaterialParser>(languages, data, size);
+#if FILAMENT_ENABLE_MATDBG
+// programs rebuilt after an edit, see applyPendingEdits()
+struct FMaterial::PendingReload {
+    // null once the material is destroyed
+    FMaterial* material;
+    std::array<Handle<HwProgram>, VARIANT_COUNT> programs;
+};
+#endif
 
+static std::unique_ptr<MaterialParser> parseMaterial(Backend backend,
+        utils::FixedCapacityVector<ShaderLanguage> const& languages,
+        std::unique_ptr<MaterialParser> materialParser) {
     MaterialParser::ParseResult const materialResult = materialParser->parse();
 
     if (UTILS_UNLIKELY(materialResult == MaterialParser::ParseResult::ERROR_MISSING_BACKEND)) {
@@ -115,9 +123,25 @@ static std::unique_ptr<MaterialParser> createParser(Backend backend,
     return materialParser;
 }
 
+static std::unique_ptr<MaterialParser> createParser(Backend backend,
+        utils::FixedCapacityVector<ShaderLanguage> languages, const void* data, size_t size) {
+    // unique_ptr so we don't leak MaterialParser on failures
+    return parseMaterial(backend, languages,
+            std::make_unique<MaterialParser>(languages, data, size));
+}
+
+static std::unique_ptr<MaterialParser> createParser(Backend backend,
+        utils::FixedCapacityVector<ShaderLanguage> languages, CString const& path) {
+    auto materialParser = std::make_unique<MaterialParser>(languages, path);
+    FILAMENT_CHECK_PRECONDITION(materialParser->getPackageSize() > 0)
+            << "could not read the material package file " << path.c_str_safe();
+    return parseMaterial(backend, languages, std::move(materialParser));
+}
+
 struct Material::BuilderDetails {
     const void* mPayload = nullptr;
     size_t mSize = 0;
+    CString mPath;
     bool mDefaultMaterial = false;
     std::unordered_map<
         utils::CString,
@@ -140,6 +164,15 @@ BuilderType::Builder& BuilderType::Builder::operator=(BuilderType::Builder&& rhs
 Material::Builder& Material::Builder::package(const void* payload, size_t size) {
     mImpl->mPayload = payload;
     mImpl->mSize = size;
+    mImpl->mPath = {};
+    return *this;
+}
+
+Material::Builder& Material::Builder::packageFile(const char* path) {
+    FILAMENT_CHECK_PRECONDITION(path != nullptr) << "path cannot be null";
+    mImpl->mPayload = nullptr;
+    mImpl->mSize = 0;
+    mImpl->mPath = CString{ path };
     return *this;
 }
 
@@ -155,9 +188,11 @@ template Material::Builder& Material::Builder::constant<float>(const char*, size
 template Material::Builder& Material::Builder::constant<bool>(const char*, size_t, bool);
 
 Material* Material::Builder::build(Engine& engine) {
-    std::unique_ptr<MaterialParser> materialParser = createParser(
-        downcast(engine).getBackend(), downcast(engine).getShaderLanguage(),
-        mImpl->mPayload, mImpl->mSize);
+    std::unique_ptr<MaterialParser> materialParser = mImpl->mPath.empty() ?
+            createParser(downcast(engine).getBackend(), downcast(engine).getShaderLanguage(),
+                    mImpl->mPayload, mImpl->mSize) :
+            createParser(downcast(engine).getBackend(), downcast(engine).getShaderLanguage(),
+                    mImpl->mPath);
 
     if (!materialParser) {
         return nullptr;
@@ -303,15 +338,25 @@ FMaterial::FMaterial(FEngine& engine, const Material::Builder& builder,
     processDepthVariants(engine, parser);
 
     // we can only initialize the default instance once we're initialized ourselves
-    new(&mDefaultInstanceStorage) FMaterialInstance(engine, this);
-
+    FMaterialInstance const* const defaultInstance =
+            new(&mDefaultInstanceStorage) FMaterialInstance(engine, this);
+
+    // keep a read-only copy of the default uniforms, for the instances that don't change them
+    if (engine.getActiveFeatureLevel() > FeatureLevel::FEATURE_LEVEL_0 &&
+            !mUniformInterfaceBlock.isEmpty()) {
+        UniformBuffer const& uniforms = defaultInstance->getUniformBuffer();
+        UniformBufferArena& arena = engine.getUniformBufferArena();
+        mDefaultUniforms = arena.allocate(uint32_t(uniforms.getSize()));
+        arena.write(mDefaultUniforms, uniforms.getBuffer(), uint32_t(uniforms.getSize()));
+    }
 
 #if FILAMENT_ENABLE_MATDBG
     // Register the material with matdbg.
     matdbg::DebugServer* server = downcast(engine).debug.server;
     if (UTILS_UNLIKELY(server)) {
-        auto details = builder.mImpl;
-        mDebuggerId = server->addMaterial(mName, details->mPayload, details->mSize, this);
+        // the parser's copy (or mapping) of the package is the one that outlives the builder
+        mDebuggerId = server->addMaterial(mName, mMaterialParser->getPackageData(),
+                mMaterialParser->getPackageSize(), this);
     }
 #endif
 }
@@ -337,7 +382,7 @@ void FMaterial::invalidate(Variant::type_t variantMask, Variant::type_t variantV
                         continue;
                     }
                 }
-                driverApi.destroyProgram(cachedPrograms[k]);
+                mEngine.getHwProgramFactory().destroy(driverApi, cachedPrograms[k]);
                 cachedPrograms[k].clear();
             }
         }
@@ -356,12 +401,16 @@ void FMaterial::invalidate(Variant::type_t variantMask, Variant::type_t variantV
         auto& cachedPrograms = mCachedPrograms;
         for (size_t k = 0, n = POST_PROCESS_VARIANT_COUNT; k < n; ++k) {
             if ((k & variantMask) == variantValue) {
-                driverApi.destroyProgram(cachedPrograms[k]);
+                mEngine.getHwProgramFactory().destroy(driverApi, cachedPrograms[k]);
                 cachedPrograms[k].clear();
             }
         }
     } else if (mMaterialDomain == MaterialDomain::COMPUTE) {
-        // TODO: handle compute variants if any
+        // compute materials only have variant 0
+        if ((0 & variantMask) == variantValue) {
+            mEngine.getHwProgramFactory().destroy(mEngine.getDriverApi(), mCachedPrograms[0]);
+            mCachedPrograms[0].clear();
+        }
     }
 }
 
@@ -373,11 +422,24 @@ void FMaterial::terminate(FEngine& engine) {
     if (UTILS_UNLIKELY(server)) {
         server->removeMaterial(mDebuggerId);
     }
+
+    // programs still compiling after an edit are dropped, they will never be swapped in
+    if (UTILS_UNLIKELY(mPendingReload)) {
+        for (auto& program: mPendingReload->programs) {
+            engine.getHwProgramFactory().destroy(engine.getDriverApi(), program);
+        }
+        mPendingReload->material = nullptr;
+        mPendingReload = nullptr;
+    }
 #endif
 
     destroyPrograms(engine);
 
     getDefaultInstance()->terminate(engine);
+
+    // all instances are gone, nothing binds the default uniforms anymore
+    engine.getUniformBufferArena().free(mDefaultUniforms);
+    mDefaultUniforms = {};
 }
 
 void FMaterial::compile(CompilerPriorityQueue priority,
@@ -398,13 +460,47 @@ void FMaterial::compile(CompilerPriorityQueue priority,
                 VariantUtils::getLitVariants() : VariantUtils::getUnlitVariants();
         for (auto const variant: variants) {
             if (!variantFilter || variant == Variant::filterUserVariant(variant, variantFilter)) {
-                if (hasVariant(variant)) {
-                    prepareProgram(variant, priority);
+                if (hasVariant(variant) && !isCached(variant)) {
+                    createProgramSlow(variant, priority);
                 }
             }
         }
     }
 
+    compilePrograms(priority, handler, std::move(callback));
+}
+
+void FMaterial::compile(CompilerPriorityQueue priority,
+        void const* manifest, size_t size,
+        backend::CallbackHandler* handler,
+        utils::Invocable<void(Material*)>&& callback) noexcept {
+
+    if (UTILS_LIKELY(mEngine.getDriverApi().isParallelShaderCompileSupported())) {
+        bool const isStereoSupported = mEngine.getDriverApi().isStereoSupported();
+        VariantList const variants = FEngine::getVariantManifestEntry(manifest, size, mCacheId);
+        variants.forEachSetBit([&](size_t key) {
+            Variant const variant{ Variant::type_t(key) };
+            // the manifest may come from another device or configuration of the engine
+            if (!isStereoSupported && Variant::isStereoVariant(variant)) {
+                return;
+            }
+            if (getMaterialDomain() == MaterialDomain::SURFACE &&
+                    (variant != Variant::filterVariant(variant, isVariantLit()) ||
+                     Variant::isReserved(variant))) {
+                return;
+            }
+            if (hasVariant(variant) && !isCached(variant)) {
+                createProgramSlow(variant, priority);
+            }
+        });
+    }
+
+    compilePrograms(priority, handler, std::move(callback));
+}
+
+void FMaterial::compilePrograms(CompilerPriorityQueue priority,
+        backend::CallbackHandler* handler,
+        utils::Invocable<void(Material*)>&& callback) noexcept {
     if (callback) {
         struct Callback {
             Invocable<void(Material*)> f;
@@ -452,8 +548,9 @@ bool FMaterial::hasVariant(Variant variant) const noexcept {
             vertexVariant = fragmentVariant = variant;
             break;
         case MaterialDomain::COMPUTE:
-            // TODO: implement MaterialDomain::COMPUTE
-            return false;
+            // compute materials have a single variant
+            return variant.key == 0 && mMaterialParser->hasShader(
+                    mEngine.getShaderModel(), variant, ShaderStage::COMPUTE);
     }
     const ShaderModel sm = mEngine.getShaderModel();
     if (!mMaterialParser->hasShader(sm, vertexVariant, ShaderStage::VERTEX)) {
@@ -467,6 +564,14 @@ bool FMaterial::hasVariant(Variant variant) const noexcept {
 
 void FMaterial::prepareProgramSlow(Variant variant,
         backend::CompilerPriorityQueue priorityQueue) const noexcept {
+    if (UTILS_UNLIKELY(mEngine.isVariantRecordingEnabled())) {
+        mEngine.recordVariant(mCacheId, variant);
+    }
+    createProgramSlow(variant, priorityQueue);
+}
+
+void FMaterial::createProgramSlow(Variant variant,
+        backend::CompilerPriorityQueue priorityQueue) const noexcept {
     assert_invariant(mEngine.hasFeatureLevel(mFeatureLevel));
     switch (getMaterialDomain()) {
         case MaterialDomain::SURFACE:
@@ -476,7 +581,7 @@ void FMaterial::prepareProgramSlow(Variant variant,
             getPostProcessProgramSlow(variant, priorityQueue);
             break;
         case MaterialDomain::COMPUTE:
-            // TODO: implement MaterialDomain::COMPUTE
+            getComputeProgramSlow(variant, priorityQueue);
             break;
     }
 }
@@ -507,6 +612,30 @@ void FMaterial::getPostProcessProgramSlow(Variant variant,
     createAndCacheProgram(std::move(pb), variant);
 }
 
+void FMaterial::getComputeProgramSlow(Variant variant,
+        CompilerPriorityQueue priorityQueue) const noexcept {
+    assert_invariant(variant.key == 0);
+
+    // compute materials have no vertex shader, its scratch buffer is free
+    ShaderContent& csBuilder = mEngine.getVertexShaderContent();
+
+    UTILS_UNUSED_IN_RELEASE bool const csOK = mMaterialParser->getShader(csBuilder,
+            mEngine.getShaderModel(), variant, ShaderStage::COMPUTE);
+
+    FILAMENT_CHECK_POSTCONDITION(mEngine.getBackend() == Backend::NOOP ||
+            (csOK && !csBuilder.empty()))
+            << "The material '" << mName.c_str()
+            << "' has not been compiled to include the required GLSL or SPIR-V chunks for the "
+               "compute shader.";
+
+    Program pb;
+    pb.shader(ShaderStage::COMPUTE, csBuilder.data(), csBuilder.size());
+    setProgramInterface(pb, variant);
+    pb.pushConstants(ShaderStage::COMPUTE, mPushConstants[(uint8_t) ShaderStage::COMPUTE]);
+    pb.priorityQueue(priorityQueue);
+    createAndCacheProgram(std::move(pb), variant);
+}
+
 Program FMaterial::getProgramWithVariants(
         Variant variant,
         Variant vertexVariant,
@@ -546,12 +675,22 @@ Program FMaterial::getProgramWithVariants(
 
     Program program;
     program.shader(ShaderStage::VERTEX, vsBuilder.data(), vsBuilder.size())
-           .shader(ShaderStage::FRAGMENT, fsBuilder.data(), fsBuilder.size())
-           .shaderLanguage(mMaterialParser->getShaderLanguage())
+           .shader(ShaderStage::FRAGMENT, fsBuilder.data(), fsBuilder.size());
+    setProgramInterface(program, variant);
+
+    program.pushConstants(ShaderStage::VERTEX, mPushConstants[(uint8_t) ShaderStage::VERTEX]);
+    program.pushConstants(ShaderStage::FRAGMENT, mPushConstants[(uint8_t) ShaderStage::FRAGMENT]);
+
+    return program;
+}
+
+void FMaterial::setProgramInterface(Program& program, Variant variant) const noexcept {
+    program.shaderLanguage(mMaterialParser->getShaderLanguage())
            .uniformBlockBindings(mUniformBlockBindings)
            .diagnostics(mName,
-                    [this, variant](io::ostream& out) -> io::ostream& {
-                        return out << mName.c_str_safe()
+                    // the program may be shared with, and outlive, this material
+                    [name = mName, variant](io::ostream& out) -> io::ostream& {
+                        return out << name.c_str_safe()
                                    << ", variant=(" << io::hex << variant.key << io::dec << ")";
                     });
 
@@ -579,16 +718,12 @@ Program FMaterial::getProgramWithVariants(
 
     program.specializationConstants(mSpecializationConstants);
 
-    program.pushConstants(ShaderStage::VERTEX, mPushConstants[(uint8_t) ShaderStage::VERTEX]);
-    program.pushConstants(ShaderStage::FRAGMENT, mPushConstants[(uint8_t) ShaderStage::FRAGMENT]);
-
     program.cacheId(utils::hash::combine(size_t(mCacheId), variant.key));
-
-    return program;
 }
 
 void FMaterial::createAndCacheProgram(Program&& p, Variant variant) const noexcept {
-    auto program = mEngine.getDriverApi().createProgram(std::move(p));
+    // identical programs of different materials are created only once
+    auto program = mEngine.getHwProgramFactory().create(mEngine.getDriverApi(), std::move(p));
     assert_invariant(program);
     mCachedPrograms[variant.key] = program;
 }
@@ -641,12 +776,115 @@ size_t FMaterial::getParameters(ParameterInfo* parameters, size_t count) const n
 // Swaps in an edited version of the original package that was used to create the material. The
 // edited package was stashed in response to a debugger event. This is invoked only when the
 // Material Debugger is attached. The only editable features of a material package are the shader
-// source strings, so here we trigger a rebuild of the HwProgram objects.
+// source strings, so here we rebuild the HwProgram objects whose sources changed. They compile
+// in the background while the previous programs are still used, and replace them once they are
+// all ready. Variants that were never used simply get the new sources when they're first needed.
 void FMaterial::applyPendingEdits() noexcept {
+    if (mPendingReload) {
+        // keep the edits for later, the previous ones are still compiling
+        return;
+    }
+
     const char* name = mName.c_str();
     slog.d << "Applying edits to " << (name ? name : "(untitled)") << io::endl;
-    destroyPrograms(mEngine); // FIXME: this will not destroy the shared variants
+
+    std::unique_ptr<MaterialParser> previous = std::move(mMaterialParser);
     latchPendingEdits();
+
+    size_t const variantCount = mMaterialDomain == MaterialDomain::POST_PROCESS ?
+            POST_PROCESS_VARIANT_COUNT : VARIANT_COUNT;
+
+    // Without a custom depth shader, the depth variants of a surface material are the programs of
+    // the default material, which this material cannot rebuild. Edits that would change them are
+    // rejected as a whole, rather than leaving the depth passes with the previous sources.
+    auto const isSharedDepthVariant = [this](Variant variant) {
+        return mMaterialDomain == MaterialDomain::SURFACE && !mIsDefaultMaterial &&
+                Variant::isValidDepthVariant(variant) && !mHasCustomDepthShader;
+    };
+    for (size_t k = 0; k < variantCount; ++k) {
+        Variant const variant(k);
+        if (mCachedPrograms[k] && isSharedDepthVariant(variant) && isEdited(*previous, variant)) {
+            slog.w << "Edits to " << (name ? name : "(untitled)")
+                   << " change depth variants shared with the default material, ignoring them"
+                   << io::endl;
+            mMaterialParser = std::move(previous);
+            return;
+        }
+    }
+
+    auto* const reload = new PendingReload{ this, {} };
+    size_t editedCount = 0;
+    for (size_t k = 0; k < variantCount; ++k) {
+        Variant const variant(k);
+        if (!mCachedPrograms[k] || isSharedDepthVariant(variant)) {
+            continue;
+        }
+        if (!isEdited(*previous, variant)) {
+            continue;
+        }
+        Variant const vertexVariant = mMaterialDomain == MaterialDomain::SURFACE ?
+                Variant::filterVariantVertex(variant) : variant;
+        Variant const fragmentVariant = mMaterialDomain == MaterialDomain::SURFACE ?
+                Variant::filterVariantFragment(variant) : variant;
+        Program pb{ getProgramWithVariants(variant, vertexVariant, fragmentVariant) };
+        pb.priorityQueue(CompilerPriorityQueue::LOW);
+        if (mMaterialDomain == MaterialDomain::SURFACE) {
+            pb.multiview(
+                    mEngine.getConfig().stereoscopicType == StereoscopicType::MULTIVIEW &&
+                    Variant::isStereoVariant(variant));
+        }
+        reload->programs[k] = mEngine.getHwProgramFactory().create(
+                mEngine.getDriverApi(), std::move(pb));
+        editedCount++;
+    }
+
+    slog.d << editedCount << " program(s) of " << (name ? name : "(untitled)")
+           << " are recompiling" << io::endl;
+
+    if (!editedCount) {
+        delete reload;
+        return;
+    }
+
+    // the callback runs on this thread, once every program created so far is ready
+    mPendingReload = reload;
+    mEngine.getDriverApi().compilePrograms(CompilerPriorityQueue::LOW, nullptr,
+            &FMaterial::swapReloadedPrograms, reload);
+}
+
+bool FMaterial::isEdited(MaterialParser& previous, Variant variant) const noexcept {
+    ShaderModel const sm = mEngine.getShaderModel();
+    for (ShaderStage const stage: { ShaderStage::VERTEX, ShaderStage::FRAGMENT }) {
+        Variant const stageVariant = mMaterialDomain != MaterialDomain::SURFACE ? variant :
+                stage == ShaderStage::VERTEX ? Variant::filterVariantVertex(variant) :
+                Variant::filterVariantFragment(variant);
+        filaflat::ShaderContent before;
+        filaflat::ShaderContent after;
+        bool const hadShader = previous.getShader(before, sm, stageVariant, stage);
+        bool const hasShader = mMaterialParser->getShader(after, sm, stageVariant, stage);
+        if (hadShader != hasShader || before.size() != after.size() ||
+                memcmp(before.data(), after.data(), before.size()) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FMaterial::swapReloadedPrograms(void* user) {
+    auto* const reload = static_cast<PendingReload*>(user);
+    FMaterial* const material = reload->material;
+    if (material) {
+        DriverApi& driverApi = material->mEngine.getDriverApi();
+        for (size_t k = 0, n = VARIANT_COUNT; k < n; ++k) {
+            if (reload->programs[k]) {
+                material->mEngine.getHwProgramFactory().destroy(driverApi,
+                        material->mCachedPrograms[k]);
+                material->mCachedPrograms[k] = reload->programs[k];
+            }
+        }
+        material->mPendingReload = nullptr;
+    }
+    delete reload;
 }
 
 void FMaterial::setPendingEdits(std::unique_ptr<MaterialParser> pendingEdits) noexcept {
@@ -709,7 +947,7 @@ void FMaterial::destroyPrograms(FEngine& engine) {
                 continue;
             }
         }
-        driverApi.destroyProgram(cachedPrograms[k]);
+        engine.getHwProgramFactory().destroy(driverApi, cachedPrograms[k]);
         cachedPrograms[k].clear();
     }
 }
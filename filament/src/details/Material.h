@@ -96,6 +96,11 @@ public:
             backend::CallbackHandler* handler,
             utils::Invocable<void(Material*)>&& callback) noexcept;
 
+    void compile(CompilerPriorityQueue priority,
+            void const* manifest, size_t size,
+            backend::CallbackHandler* handler,
+            utils::Invocable<void(Material*)>&& callback) noexcept;
+
     // Create an instance of this material
     FMaterialInstance* createInstance(const char* name) const noexcept;
 
@@ -113,6 +118,13 @@ public:
         return std::launder(reinterpret_cast<FMaterialInstance*>(&mDefaultInstanceStorage));
     }
 
+    // Range of the engine's UniformBufferArena holding the uniforms of a new instance. It is
+    // never written after the material is created, and instances whose uniforms are identical
+    // bind it instead of their own range. Empty at feature level 0.
+    UniformBufferArena::Allocation const& getDefaultUniforms() const noexcept {
+        return mDefaultUniforms;
+    }
+
     FEngine& getEngine() const noexcept  { return mEngine; }
 
     bool isCached(Variant variant) const noexcept {
@@ -241,12 +253,22 @@ private:
     bool hasVariant(Variant variant) const noexcept;
     void prepareProgramSlow(Variant variant,
             CompilerPriorityQueue priorityQueue) const noexcept;
+    // same as prepareProgramSlow(), without recording the variant in the engine's manifest
+    void createProgramSlow(Variant variant,
+            CompilerPriorityQueue priorityQueue) const noexcept;
+    void compilePrograms(CompilerPriorityQueue priority,
+            backend::CallbackHandler* handler,
+            utils::Invocable<void(Material*)>&& callback) noexcept;
     void getSurfaceProgramSlow(Variant variant,
             CompilerPriorityQueue priorityQueue) const noexcept;
     void getPostProcessProgramSlow(Variant variant,
             CompilerPriorityQueue priorityQueue) const noexcept;
+    void getComputeProgramSlow(Variant variant,
+            CompilerPriorityQueue priorityQueue) const noexcept;
     backend::Program getProgramWithVariants(Variant variant,
             Variant vertexVariant, Variant fragmentVariant) const noexcept;
+    // sets everything but the shaders and the push constants, which depend on the domain
+    void setProgramInterface(backend::Program& program, Variant variant) const noexcept;
 
     void processBlendingMode(MaterialParser const* parser);
 
@@ -295,6 +317,7 @@ private:
     // reserve some space to construct the default material instance
     std::aligned_storage<sizeof(FMaterialInstance), alignof(FMaterialInstance)>::type mDefaultInstanceStorage;
     static_assert(sizeof(mDefaultInstanceStorage) >= sizeof(mDefaultInstanceStorage));
+    UniformBufferArena::Allocation mDefaultUniforms;
 
     SamplerInterfaceBlock mSamplerInterfaceBlock;
     BufferInterfaceBlock mUniformInterfaceBlock;
@@ -331,9 +354,14 @@ private:
     mutable VariantList mActivePrograms;
     mutable utils::Mutex mPendingEditsLock;
     std::unique_ptr<MaterialParser> mPendingEdits;
+    // programs of the edited variants that are compiling, swapped in once they're ready
+    struct PendingReload;
+    PendingReload* mPendingReload = nullptr;
     void setPendingEdits(std::unique_ptr<MaterialParser> pendingEdits) noexcept;
     bool hasPendingEdits() noexcept;
     void latchPendingEdits() noexcept;
+    bool isEdited(MaterialParser& previous, Variant variant) const noexcept;
+    static void swapReloadedPrograms(void* user);
 #endif
 
     utils::CString mName;
@@ -28,6 +28,10 @@
 
 #include <utils/Log.h>
 
+#include <algorithm>
+
+#include <string.h>
+
 using namespace filament::math;
 using namespace utils;
 
@@ -49,8 +53,7 @@ FMaterialInstance::FMaterialInstance(FEngine& engine, FMaterial const* material)
 
     if (!material->getUniformInterfaceBlock().isEmpty()) {
         mUniforms = UniformBuffer(material->getUniformInterfaceBlock().getSize());
-        mUbHandle = driver.createBufferObject(mUniforms.getSize(),
-                BufferObjectBinding::UNIFORM, backend::BufferUsage::STATIC);
+        createUniformBuffer(engine, BufferUsage::STATIC);
     }
 
     if (!material->getSamplerInterfaceBlock().isEmpty()) {
@@ -114,8 +117,7 @@ FMaterialInstance::FMaterialInstance(FEngine& engine,
 
     if (!material->getUniformInterfaceBlock().isEmpty()) {
         mUniforms.setUniforms(other->getUniformBuffer());
-        mUbHandle = driver.createBufferObject(mUniforms.getSize(),
-                BufferObjectBinding::UNIFORM, backend::BufferUsage::DYNAMIC);
+        createUniformBuffer(engine, BufferUsage::DYNAMIC);
     }
 
     if (!material->getSamplerInterfaceBlock().isEmpty()) {
@@ -152,16 +154,56 @@ FMaterialInstance* FMaterialInstance::duplicate(
 
 FMaterialInstance::~FMaterialInstance() noexcept = default;
 
+void FMaterialInstance::createUniformBuffer(FEngine& engine, BufferUsage usage) {
+    if (engine.getActiveFeatureLevel() == FeatureLevel::FEATURE_LEVEL_0) {
+        mUbHandle = engine.getDriverApi().createBufferObject(mUniforms.getSize(),
+                BufferObjectBinding::UNIFORM, usage);
+    } else {
+        // the range is picked by the first commit, see commitSlow()
+        mUbArena = &engine.getUniformBufferArena();
+    }
+}
+
 void FMaterialInstance::terminate(FEngine& engine) {
     FEngine::DriverApi& driver = engine.getDriverApi();
+    if (mUbArena) {
+        if (mOwnsUbAllocation) {
+            mUbArena->free(mUbAllocation);
+            mOwnsUbAllocation = false;
+        }
+        mUbArena = nullptr;
+    }
     driver.destroyBufferObject(mUbHandle);
     driver.destroySamplerGroup(mSbHandle);
 }
 
-void FMaterialInstance::commitSlow(DriverApi& driver) const {
+void FMaterialInstance::commitSlow(DriverApi& driver, bool commitArena) const {
     // update uniforms if needed
     if (mUniforms.isDirty()) {
-        driver.updateBufferObject(mUbHandle, mUniforms.toBufferDescriptor(driver), 0);
+        if (mUbArena) {
+            uint32_t const size = uint32_t(mUniforms.getSize());
+            UniformBufferArena::Allocation const& defaults = mMaterial->getDefaultUniforms();
+            if (defaults.size && !memcmp(mUbArena->data(defaults), mUniforms.getBuffer(), size)) {
+                // nothing differs from the defaults, bind the material's copy and upload nothing
+                if (mOwnsUbAllocation) {
+                    mUbArena->free(mUbAllocation);
+                    mOwnsUbAllocation = false;
+                }
+                mUbAllocation = defaults;
+            } else {
+                if (!mOwnsUbAllocation) {
+                    mUbAllocation = mUbArena->allocate(size);
+                    mOwnsUbAllocation = true;
+                }
+                mUbArena->write(mUbAllocation, mUniforms.getBuffer(), size);
+            }
+            mUniforms.clean();
+            if (commitArena) {
+                mUbArena->commit(driver);
+            }
+        } else {
+            driver.updateBufferObject(mUbHandle, mUniforms.toBufferDescriptor(driver), 0);
+        }
     }
     if (mSamplers.isDirty()) {
         driver.updateSamplerGroup(mSbHandle, mSamplers.toBufferDescriptor(driver));
@@ -176,6 +218,25 @@ void FMaterialInstance::setParameter(std::string_view name,
     mSamplers.setSampler(index, { texture, params });
 }
 
+MaterialInstance::ParameterHandle FMaterialInstance::getParameterHandle(
+        std::string_view name) const {
+    auto const* const info = mMaterial->getUniformInterfaceBlock().getFieldInfo(name);
+    // the size includes the padding of the last array element, which is still inside the buffer
+    return { uint32_t(info->getBufferOffset()),
+             uint32_t(info->stride * sizeof(uint32_t) * std::max(1u, info->size)) };
+}
+
+void FMaterialInstance::setParameters(ParameterHandle const* handles, size_t count,
+        void const* data) noexcept {
+    char const* p = static_cast<char const*>(data);
+    for (size_t i = 0; i < count; i++) {
+        ParameterHandle const handle = handles[i];
+        assert_invariant(handle.isValid());
+        memcpy(mUniforms.invalidateUniforms(handle.offset, handle.size), p, handle.size);
+        p += handle.size;
+    }
+}
+
 void FMaterialInstance::setParameterImpl(std::string_view name,
         FTexture const* texture, TextureSampler const& sampler) {
 
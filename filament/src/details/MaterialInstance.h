@@ -19,6 +19,7 @@
 
 #include "downcast.h"
 #include "UniformBuffer.h"
+#include "UniformBufferArena.h"
 #include "details/Engine.h"
 
 #include "private/backend/DriverApi.h"
@@ -50,12 +51,24 @@ public:
 
     void commit(FEngine::DriverApi& driver) const {
         if (UTILS_UNLIKELY(mUniforms.isDirty() || mSamplers.isDirty())) {
-            commitSlow(driver);
+            commitSlow(driver, true);
+        }
+    }
+
+    // Same as commit(), but uniforms that live in the engine's UniformBufferArena are only
+    // written to it, the caller is responsible for committing the arena before use().
+    void commitDeferred(FEngine::DriverApi& driver) const {
+        if (UTILS_UNLIKELY(mUniforms.isDirty() || mSamplers.isDirty())) {
+            commitSlow(driver, false);
         }
     }
 
     void use(FEngine::DriverApi& driver) const {
-        if (mUbHandle) {
+        if (mUbArena) {
+            driver.bindBufferRange(backend::BufferObjectBinding::UNIFORM,
+                    +UniformBindingPoints::PER_MATERIAL_INSTANCE, mUbArena->getHandle(),
+                    mUbAllocation.offset, uint32_t(mUniforms.getSize()));
+        } else if (mUbHandle) {
             driver.bindUniformBuffer(+UniformBindingPoints::PER_MATERIAL_INSTANCE, mUbHandle);
         }
         if (mSbHandle) {
@@ -212,6 +225,10 @@ public:
 
     using MaterialInstance::setParameter;
 
+    ParameterHandle getParameterHandle(std::string_view name) const;
+
+    void setParameters(ParameterHandle const* handles, size_t count, void const* data) noexcept;
+
 private:
     friend class FMaterial;
     friend class MaterialInstance;
@@ -228,17 +245,32 @@ private:
     template<typename T>
     void setParameterImpl(std::string_view name, const T* value, size_t count);
 
+    template<typename T>
+    void setParameterImpl(ParameterHandle handle, T const& value);
+
+    template<typename T>
+    void setParameterImpl(ParameterHandle handle, const T* value, size_t count);
+
     void setParameterImpl(std::string_view name,
             FTexture const* texture, TextureSampler const& sampler);
 
     // initialize the default instance
     FMaterialInstance(FEngine& engine, FMaterial const* material) noexcept;
 
-    void commitSlow(FEngine::DriverApi& driver) const;
+    void commitSlow(FEngine::DriverApi& driver, bool commitArena) const;
+
+    void createUniformBuffer(FEngine& engine, backend::BufferUsage usage);
 
     // keep these grouped, they're accessed together in the render-loop
     FMaterial const* mMaterial = nullptr;
 
+    // The uniforms live either in a range of the engine's UniformBufferArena, or, at feature
+    // level 0 where the backend caches uniforms per buffer object, in their own buffer object.
+    // While they are identical to the material's default uniforms, mUbAllocation is the
+    // material's shared range and the instance doesn't own any; see commitSlow().
+    UniformBufferArena* mUbArena = nullptr;
+    mutable UniformBufferArena::Allocation mUbAllocation;
+    mutable bool mOwnsUbAllocation = false;
     backend::Handle<backend::HwBufferObject> mUbHandle;
     backend::Handle<backend::HwSamplerGroup> mSbHandle;
     UniformBuffer mUniforms;
@@ -133,6 +133,14 @@ FMorphTargetBuffer::FMorphTargetBuffer(FEngine& engine, const Builder& builder)
     driver.updateSamplerGroup(mSbHandle, samplerGroup.toBufferDescriptor(driver));
 }
 
+size_t FMorphTargetBuffer::getByteCount() const noexcept {
+    if (!mPbHandle) {
+        return 0; // feature level 0
+    }
+    return (getSize<VertexAttribute::POSITION>(mVertexCount) +
+            getSize<VertexAttribute::TANGENTS>(mVertexCount)) * mCount;
+}
+
 void FMorphTargetBuffer::terminate(FEngine& engine) {
     FEngine::DriverApi& driver = engine.getDriverApi();
     if (UTILS_LIKELY(mSbHandle)) {
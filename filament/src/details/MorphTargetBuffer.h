@@ -59,6 +59,9 @@ public:
     inline size_t getVertexCount() const noexcept { return mVertexCount; }
     inline size_t getCount() const noexcept { return mCount; }
 
+    // size of the positions and tangents textures, in bytes
+    size_t getByteCount() const noexcept;
+
 private:
     friend class FView;
     friend class RenderPass;
@@ -59,6 +59,7 @@
 #include <utils/debug.h>
 
 #include <chrono>
+#include <cmath>
 #include <limits>
 #include <utility>
 
@@ -81,7 +82,7 @@ using namespace backend;
 
 FRenderer::FRenderer(FEngine& engine) :
         mEngine(engine),
-        mFrameSkipper(),
+        mFrameSkipper(engine.getConfig().maxFramesInFlight),
         mRenderTargetHandle(engine.getDefaultRenderTarget()),
         mFrameInfoManager(engine.getDriverApi()),
         mHdrTranslucent(TextureFormat::RGBA16F),
@@ -173,6 +174,7 @@ void FRenderer::terminate(FEngine& engine) {
         engine.execute();
     }
     mFrameInfoManager.terminate(driver);
+    mGpuPassTimer.terminate(driver);
     mFrameSkipper.terminate(driver);
 }
 
@@ -180,6 +182,14 @@ void FRenderer::resetUserTime() {
     mUserEpoch = std::chrono::steady_clock::now();
 }
 
+StateChangeStats FRenderer::getStateChangeStats() const noexcept {
+    return mEngine.getDriverApi().getStateChangeStats();
+}
+
+size_t FRenderer::getFrameTimings(FrameTimings* out, size_t count) const noexcept {
+    return mEngine.getFrameTimingsRecorder().getHistory(out, count);
+}
+
 TextureFormat FRenderer::getHdrFormat(const FView& view, bool translucent) const noexcept {
     if (translucent) {
         return mHdrTranslucent;
@@ -259,6 +269,15 @@ bool FRenderer::beginFrame(FSwapChain* swapChain, uint64_t vsyncSteadyClockTimeN
     mFrameId++;
     mViewRenderedCount = 0;
 
+    // the platform doesn't update the thermal headroom more than once per second
+    if (now - mThermalHeadroomTime >= seconds(1)) {
+        mThermalHeadroomTime = now;
+        float const headroom = mThermalManager.getThermalHeadroom(THERMAL_FORECAST_SECONDS);
+        if (!std::isnan(headroom)) {
+            mThermalHeadroom = headroom;
+        }
+    }
+
     SYSTRACE_FRAME_ID(mFrameId);
 
     FEngine& engine = mEngine;
@@ -310,6 +329,8 @@ bool FRenderer::beginFrame(FSwapChain* swapChain, uint64_t vsyncSteadyClockTimeN
         mFrameInfoManager.beginFrame(driver, {
                 .historySize = mFrameRateOptions.history
         }, mFrameId);
+        mGpuPassTimer.beginFrame(driver, mFrameId);
+        engine.getFrameTimingsRecorder().beginFrame(mFrameId);
 
         // ask the engine to do what it needs to (e.g. updates light buffer, materials...)
         engine.prepare();
@@ -355,7 +376,9 @@ void FRenderer::endFrame() {
     }
 
     mFrameInfoManager.endFrame(driver);
+    mGpuPassTimer.endFrame();
     mFrameSkipper.endFrame(driver);
+    engine.getFrameTimingsRecorder().endFrame();
 
     driver.endFrame(mFrameId);
 
@@ -450,14 +473,24 @@ void FRenderer::copyFrame(FSwapChain* dstSwapChain, filament::Viewport const& ds
 }
 
 void FRenderer::renderStandaloneView(FView const* view) {
+    View const* const views[] = { view };
+    renderStandaloneViews(views, 1);
+}
+
+void FRenderer::renderStandaloneViews(View const* const* views, size_t const count) {
     SYSTRACE_CALL();
 
     using namespace std::chrono;
 
-    FILAMENT_CHECK_PRECONDITION(view->getRenderTarget())
-            << "View \"" << view->getName() << "\" must have a RenderTarget associated";
+    bool hasScene = false;
+    for (size_t i = 0; i < count; i++) {
+        FView const* const view = downcast(views[i]);
+        FILAMENT_CHECK_PRECONDITION(view->getRenderTarget())
+                << "View \"" << view->getName() << "\" must have a RenderTarget associated";
+        hasScene = hasScene || view->getScene();
+    }
 
-    if (UTILS_LIKELY(view->getScene())) {
+    if (UTILS_LIKELY(hasScene)) {
         mPreviousRenderTargets.clear();
         mFrameId++;
 
@@ -472,7 +505,18 @@ void FRenderer::renderStandaloneView(FView const* view) {
                         1'000'000'000.0 / mDisplayInfo.refreshRate),
                 mFrameId);
 
-        renderInternal(view);
+        size_t renderedCount = 0;
+        for (size_t i = 0; i < count; i++) {
+            FView const* const view = downcast(views[i]);
+            if (view->getScene()) {
+                if (renderedCount) {
+                    // kick the GPU with the previous view's commands before preparing this one
+                    driver.flush();
+                }
+                renderInternal(view);
+                renderedCount++;
+            }
+        }
 
         driver.endFrame(mFrameId);
     }
@@ -535,7 +579,17 @@ void FRenderer::renderJob(RootArenaScope& rootArenaScope, FView& view) {
     bool hasColorGrading = hasPostProcess;
     bool hasDithering = view.getDithering() == Dithering::TEMPORAL;
     bool hasFXAA = view.getAntiAliasing() == AntiAliasing::FXAA;
-    float2 scale = view.updateScale(engine, mFrameInfoManager.getLastFrameInfo(), mFrameRateOptions, mDisplayInfo);
+    // take additional GPU headroom as the device gets closer to throttling. The GPU load is
+    // what heats up the device the most, and dynamic resolution is what reduces it.
+    FrameRateOptions frameRateOptions = mFrameRateOptions;
+    float const thermalThreshold = frameRateOptions.thermalHeadroomThreshold;
+    if (thermalThreshold < 1.0f && mThermalHeadroom > thermalThreshold) {
+        float const t = std::min(1.0f,
+                (mThermalHeadroom - thermalThreshold) / (1.0f - thermalThreshold));
+        frameRateOptions.headRoomRatio = std::min(0.9f,
+                frameRateOptions.headRoomRatio + t * frameRateOptions.thermalHeadRoomRatio);
+    }
+    float2 scale = view.updateScale(engine, mFrameInfoManager.getLastFrameInfo(), frameRateOptions, mDisplayInfo);
     auto msaaOptions = view.getMultiSampleAntiAliasingOptions();
     auto dsrOptions = view.getDynamicResolutionOptions();
     auto bloomOptions = view.getBloomOptions();
@@ -546,6 +600,14 @@ void FRenderer::renderJob(RootArenaScope& rootArenaScope, FView& view) {
     auto colorGrading = view.getColorGrading();
     auto ssReflectionsOptions = view.getScreenSpaceReflectionsOptions();
     auto guardBandOptions = view.getGuardBandOptions();
+    if (view.getPostProcessingBudget() > 0.0f && mGpuPassTimer.isEnabled()) {
+        std::array<GpuPassTiming, GpuPassTimer::MAX_PASS_COUNT> timings;
+        uint32_t timingsFrameId = 0;
+        size_t const count = mGpuPassTimer.getTimings(timings.data(), timings.size(),
+                &timingsFrameId);
+        view.updatePostProcessingBudget(timings.data(), count, timingsFrameId, mFrameId);
+        view.applyPostProcessingBudget(ssReflectionsOptions, dofOptions, aoOptions, bloomOptions);
+    }
     const bool isRenderingMultiview = view.hasStereo() &&
             engine.getConfig().stereoscopicType == backend::StereoscopicType::MULTIVIEW;
     // FIXME: This is to override some settings that are not supported for multiview at the moment.
@@ -571,12 +633,12 @@ void FRenderer::renderJob(RootArenaScope& rootArenaScope, FView& view) {
         if (taaOptions.enabled) {
             ppm.configureTemporalAntiAliasingMaterial(taaOptions);
             if (taaOptions.upscaling) {
-                // for now TAA upscaling is incompatible with regular dsr
-                dsrOptions.enabled = false;
-                // also, upscaling doesn't work well with quater-resolution SSAO
+                // upscaling doesn't work well with quater-resolution SSAO
                 aoOptions.resolution = 1.0;
-                // Currently we only support a fixed TAA upscaling ratio
-                scale = 0.5f;
+                // TAA upscales by a fixed 2x ratio in each direction. Dynamic resolution's scale
+                // is relative to TAA's output, and the remaining ratio, which can be anything, is
+                // handled by the regular upscaler after post-processing.
+                scale *= 0.5f;
             }
         }
     }
@@ -589,13 +651,15 @@ void FRenderer::renderJob(RootArenaScope& rootArenaScope, FView& view) {
 
     const bool isProtectedContent =  mSwapChain && mSwapChain->isProtected();
 
-    // asSubpass is disabled with TAA (although it's supported) because performance was degraded
-    // on qualcomm hardware -- we might need a backend dependent toggle at some point
+    // With TAA, color grading runs as a subpass of the TAA pass, except where the backend reports
+    // that it degrades performance (e.g. on Qualcomm hardware).
+    const bool colorGradingAsTaaSubpass = !taaOptions.enabled ||
+            !driver.isWorkaroundNeeded(Workaround::DISABLE_TAA_COLOR_GRADING_SUBPASS);
     const PostProcessManager::ColorGradingConfig colorGradingConfig{
             .asSubpass =
                     hasColorGrading &&
                     msaaSampleCount <= 1 &&
-                    !bloomOptions.enabled && !dofOptions.enabled && !taaOptions.enabled &&
+                    !bloomOptions.enabled && !dofOptions.enabled && colorGradingAsTaaSubpass &&
                     driver.isFrameBufferFetchSupported(),
             .customResolve =
                     msaaOptions.customResolve &&
@@ -822,7 +886,9 @@ void FRenderer::renderJob(RootArenaScope& rootArenaScope, FView& view) {
             .hasContactShadows = scene.hasContactShadows(),
             // at this point we don't know if we have refraction, but that's handled later
             .hasScreenSpaceReflectionsOrRefractions = ssReflectionsOptions.enabled,
-            .enabledStencilBuffer = view.isStencilBufferEnabled()
+            .enabledStencilBuffer = view.isStencilBufferEnabled(),
+            // SSR can be disabled for this frame only, by the post-processing budget
+            .screenSpaceReflectionHistoryNotReady = !ssReflectionsOptions.enabled
     };
 
     /*
@@ -883,16 +949,18 @@ void FRenderer::renderJob(RootArenaScope& rootArenaScope, FView& view) {
     // This is normally used by SSAO and contact-shadows
 
     // TODO: the scaling should depends on all passes that need the structure pass
+    RenderPassBuilder structurePassBuilder{ passBuilder };
+    structurePassBuilder.sortCache(view.getStructurePassSortCache());
     const auto [structure, picking_] = ppm.structure(fg,
-            passBuilder, renderFlags, svp.width, svp.height, {
+            structurePassBuilder, renderFlags, svp.width, svp.height, {
             .scale = aoOptions.resolution,
-            .picking = view.hasPicking()
+            .picking = view.hasPicking() || view.needsDepthReadback()
     });
     blackboard["structure"] = structure;
     const auto picking = picking_;
 
 
-    if (view.hasPicking()) {
+    if (view.hasPicking() || view.needsDepthReadback()) {
         struct PickingResolvePassData {
             FrameGraphId<FrameGraphTexture> picking;
         };
@@ -906,9 +974,13 @@ void FRenderer::renderJob(RootArenaScope& rootArenaScope, FView& view) {
                     builder.sideEffect();
                 },
                 [=, &view](FrameGraphResources const& resources,
-                        auto const&, DriverApi& driver) mutable {
+                        auto const& data, DriverApi& driver) mutable {
                     auto out = resources.getRenderPassInfo();
                     view.executePickingQueries(driver, out.target, scale * aoOptions.resolution);
+                    if (view.needsDepthReadback()) {
+                        auto const& desc = resources.getDescriptor(data.picking);
+                        view.readbackOcclusionDepth(driver, out.target, desc.width, desc.height);
+                    }
                 });
     }
 
@@ -924,7 +996,11 @@ void FRenderer::renderJob(RootArenaScope& rootArenaScope, FView& view) {
 
     if (aoOptions.enabled) {
         // we could rely on FrameGraph culling, but this creates unnecessary CPU work
-        auto ssao = ppm.screenSpaceAmbientOcclusion(fg, svp, cameraInfo, structure, aoOptions);
+        // the TAA history is what accumulates temporal samples, so they require TAA
+        bool const temporalSampling = view.isTemporalAmbientOcclusionEnabled() &&
+                taaOptions.enabled;
+        auto ssao = ppm.screenSpaceAmbientOcclusion(fg, svp, cameraInfo, structure, aoOptions,
+                temporalSampling, view.getFrameHistory().getCurrent().taa.frameId);
         blackboard["ssao"] = ssao;
     }
 
@@ -942,12 +1018,23 @@ void FRenderer::renderJob(RootArenaScope& rootArenaScope, FView& view) {
     // screen-space reflections pass
 
     if (ssReflectionsOptions.enabled) {
+        // the resolution is either 1.0 or 0.5, and the viewports are multiples of 16, so the
+        // results are integers. At half resolution the reflections are upscaled with the blit
+        // into the reflection mipmap chain.
+        float const ssrResolution = ssReflectionsOptions.resolution;
         auto reflections = ppm.ssr(fg, passBuilder,
                 view.getFrameHistory(), cameraInfo,
                 view.getPerViewUniforms(),
                 structure,
                 ssReflectionsOptions,
-                { .width = svp.width, .height = svp.height });
+                {
+                        .width = uint32_t(float(svp.width) * ssrResolution),
+                        .height = uint32_t(float(svp.height) * ssrResolution) },
+                {
+                        int32_t(float(xvp.left) * ssrResolution),
+                        int32_t(float(xvp.bottom) * ssrResolution),
+                        uint32_t(float(xvp.width) * ssrResolution),
+                        uint32_t(float(xvp.height) * ssrResolution) });
 
         if (UTILS_LIKELY(reflections)) {
             // generate the mipchain
@@ -1002,6 +1089,8 @@ void FRenderer::renderJob(RootArenaScope& rootArenaScope, FView& view) {
         passBuilder.renderFlags(renderFlags);
     }
 
+    passBuilder.sortCache(view.getColorPassSortCache());
+
     RenderPass const pass{ passBuilder.build(engine) };
 
     FrameGraphTexture::Descriptor colorBufferDesc = {
@@ -1113,8 +1202,8 @@ void FRenderer::renderJob(RootArenaScope& rootArenaScope, FView& view) {
         input = ppm.taa(fg, input, depth, view.getFrameHistory(), &FrameHistoryEntry::taa,
                 taaOptions, colorGradingConfig);
         if (taaOptions.upscaling) {
-            scale = 1.0f;
-            scaled = false;
+            scale *= 2.0f;
+            scaled = any(notEqual(scale, float2(1.0f)));
             UTILS_UNUSED_IN_RELEASE auto const& inputDesc = fg.getDescriptor(input);
             svp.width = inputDesc.width;
             svp.height = inputDesc.height;
@@ -1142,7 +1231,7 @@ void FRenderer::renderJob(RootArenaScope& rootArenaScope, FView& view) {
                 aspect > 1.0f ? 1.0f / aspect : 1.0f
             };
             input = ppm.dof(fg, input, depth, cameraInfo, needsAlphaChannel,
-                    bokehScale, dofOptions);
+                    bokehScale, dofOptions, view.getVisibleDistanceRange());
         }
 
         FrameGraphId<FrameGraphTexture> bloom, flare;
@@ -1252,11 +1341,19 @@ void FRenderer::renderJob(RootArenaScope& rootArenaScope, FView& view) {
 
     fg.present(fgViewRenderTarget);
 
-    fg.compile();
+    {
+        FrameTimingsRecorder::Scope const timing(engine.getFrameTimingsRecorder(),
+                FrameTimingsRecorder::Stage::FRAME_GRAPH_COMPILE);
+        fg.compile();
+    }
 
     //fg.export_graphviz(slog.d, view.getName());
 
-    fg.execute(driver);
+    {
+        FrameTimingsRecorder::Scope const timing(engine.getFrameTimingsRecorder(),
+                FrameTimingsRecorder::Stage::FRAME_GRAPH_EXECUTE);
+        fg.execute(driver, mGpuPassTimer.isEnabled() ? &mGpuPassTimer : nullptr);
+    }
 
     // save the current history entry and destroy the oldest entry
     view.commitFrameHistory(engine);
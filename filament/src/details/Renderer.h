@@ -22,6 +22,7 @@
 #include "Allocators.h"
 #include "FrameInfo.h"
 #include "FrameSkipper.h"
+#include "GpuPassTimer.h"
 #include "PostProcessManager.h"
 #include "RenderPass.h"
 
@@ -40,9 +41,14 @@
 
 #include <utils/compiler.h>
 #include <utils/Allocator.h>
+#include <utils/ThermalManager.h>
 
 #include <tsl/robin_set.h>
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
 namespace filament {
 
 namespace backend {
@@ -58,6 +64,8 @@ class FView;
  */
 class FRenderer : public Renderer {
     static constexpr unsigned MAX_FRAMETIME_HISTORY = 32u;
+    // how far ahead we ask the platform to forecast the thermal headroom
+    static constexpr int THERMAL_FORECAST_SECONDS = 10;
 
 public:
     explicit FRenderer(FEngine& engine);
@@ -72,9 +80,30 @@ public:
 
     void resetUserTime();
 
+    backend::StateChangeStats getStateChangeStats() const noexcept;
+
+    float getThermalHeadroom() const noexcept { return mThermalHeadroom; }
+
+    size_t getFrameTimings(FrameTimings* out, size_t count) const noexcept;
+
+    void setGpuPassTimingsEnabled(bool enabled) noexcept {
+        mGpuPassTimer.setEnabled(enabled);
+    }
+
+    bool isGpuPassTimingsEnabled() const noexcept {
+        return mGpuPassTimer.isEnabled();
+    }
+
+    size_t getGpuPassTimings(GpuPassTiming* out, size_t count, uint32_t* frameId) const noexcept {
+        return mGpuPassTimer.getTimings(out, count, frameId);
+    }
+
     // renders a single standalone view. The view must have a a custom rendertarget.
     void renderStandaloneView(FView const* view);
 
+    // renders several standalone views as part of the same frame.
+    void renderStandaloneViews(View const* const* views, size_t count);
+
 
     void setPresentationTime(int64_t monotonic_clock_ns);
 
@@ -121,6 +150,10 @@ public:
         // headroom can't be larger than frame time, or less than 0
         frameRateOptions.headRoomRatio = std::min(frameRateOptions.headRoomRatio, 1.0f);
         frameRateOptions.headRoomRatio = std::max(frameRateOptions.headRoomRatio, 0.0f);
+
+        // the thermal headroom can't take more than half of the frame time
+        frameRateOptions.thermalHeadRoomRatio =
+                std::clamp(frameRateOptions.thermalHeadRoomRatio, 0.0f, 0.5f);
     }
 
     void setClearOptions(const ClearOptions& options) {
@@ -131,6 +164,11 @@ public:
         return mClearOptions;
     }
 
+    // largest amount of commands recorded by a frame, in bytes
+    size_t getCommandsHighWatermark() const noexcept {
+        return mCommandsHighWatermark;
+    }
+
 private:
     friend class Renderer;
     using Command = RenderPass::Command;
@@ -158,10 +196,6 @@ private:
         mCommandsHighWatermark = std::max(mCommandsHighWatermark, watermark);
     }
 
-    size_t getCommandsHighWatermark() const noexcept {
-        return mCommandsHighWatermark;
-    }
-
     void renderInternal(FView const* view);
     void renderJob(RootArenaScope& rootArenaScope, FView& view);
 
@@ -174,6 +208,7 @@ private:
     uint32_t mFrameId = 0;
     uint32_t mViewRenderedCount = 0;
     FrameInfoManager mFrameInfoManager;
+    GpuPassTimer mGpuPassTimer;
     backend::TextureFormat mHdrTranslucent;
     backend::TextureFormat mHdrQualityMedium;
     backend::TextureFormat mHdrQualityHigh;
@@ -182,6 +217,9 @@ private:
     math::float4 mShaderUserTime{};
     DisplayInfo mDisplayInfo;
     FrameRateOptions mFrameRateOptions;
+    utils::ThermalManager mThermalManager;
+    float mThermalHeadroom = std::numeric_limits<float>::quiet_NaN();
+    std::chrono::steady_clock::time_point mThermalHeadroomTime{};
     ClearOptions mClearOptions;
     backend::TargetBufferFlags mDiscardStartFlags{};
     backend::TargetBufferFlags mClearFlags{};
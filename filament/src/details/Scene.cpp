@@ -36,6 +36,9 @@
 #include <math/quat.h>
 
 #include <algorithm>
+#include <vector>
+
+#include <string.h>
 
 using namespace filament::backend;
 using namespace filament::math;
@@ -51,96 +54,118 @@ FScene::FScene(FEngine& engine) :
 
 FScene::~FScene() noexcept = default;
 
+bool FScene::instancesAreStale() noexcept {
+    FEngine& engine = mEngine;
+    EntityManager const& em = engine.getEntityManager();
+    bool stale = mEntitiesChanged ||
+            mRenderableManagerVersion != engine.getRenderableManager().getVersion() ||
+            mLightManagerVersion != engine.getLightManager().getVersion() ||
+            mTransformManagerVersion != engine.getTransformManager().getVersion();
+
+    // Entities of the scene that were destroyed must be skipped, even if their components still
+    // exist. The journal is always read entirely so that the cursor stays current.
+    constexpr size_t BATCH_SIZE = 64;
+    Entity destroyed[BATCH_SIZE];
+    size_t count;
+    do {
+        count = BATCH_SIZE;
+        if (UTILS_UNLIKELY(!em.readDestroyedEntities(mDestroyedEntitiesCursor, destroyed, count))) {
+            stale = true;
+        }
+        for (size_t i = 0; i < count && !stale; i++) {
+            stale = mEntities.find(destroyed[i]) != mEntities.end();
+        }
+    } while (count == BATCH_SIZE);
+    return stale;
+}
 
-void FScene::prepare(utils::JobSystem& js,
-        RootArenaScope& rootArenaScope,
-        mat4 const& worldTransform,
-        bool shadowReceiversAreCasters) noexcept {
-    // TODO: can we skip this in most cases? Since we rely on indices staying the same,
-    //       we could only skip, if nothing changed in the RCM.
-
+UTILS_NOINLINE
+void FScene::updateInstances() noexcept {
     SYSTRACE_CALL();
 
-    SYSTRACE_CONTEXT();
-
-    // This will reset the allocator upon exiting
-    ArenaScope<RootArenaScope::Arena> localArenaScope(rootArenaScope.getArena());
-
     FEngine& engine = mEngine;
     EntityManager const& em = engine.getEntityManager();
     FRenderableManager const& rcm = engine.getRenderableManager();
     FTransformManager const& tcm = engine.getTransformManager();
     FLightManager const& lcm = engine.getLightManager();
-    // go through the list of entities, and gather the data of those that are renderables
-    auto& sceneData = mRenderableData;
-    auto& lightData = mLightData;
-    auto const& entities = mEntities;
-
-    using RenderableContainerData = std::pair<RenderableManager::Instance, TransformManager::Instance>;
-    using RenderableInstanceContainer = FixedCapacityVector<RenderableContainerData,
-            utils::STLAllocator< RenderableContainerData, LinearAllocatorArena >, false>;
-
-    using LightContainerData = std::pair<LightManager::Instance, TransformManager::Instance>;
-    using LightInstanceContainer = FixedCapacityVector<LightContainerData,
-            utils::STLAllocator< LightContainerData, LinearAllocatorArena >, false>;
-
-    RenderableInstanceContainer renderableInstances{
-            RenderableInstanceContainer::with_capacity(entities.size(), localArenaScope.getArena()) };
 
-    LightInstanceContainer lightInstances{
-            LightInstanceContainer::with_capacity(entities.size(), localArenaScope.getArena()) };
+    mRenderableInstances.clear();
+    mLightInstances.clear();
+    mDirectionalLightInstances.clear();
+    mRenderableInstances.reserve(mEntities.size());
 
-    SYSTRACE_NAME_BEGIN("InstanceLoop");
-
-    // find the max intensity directional light index in our local array
-    float maxIntensity = 0.0f;
-    std::pair<LightManager::Instance, TransformManager::Instance> directionalLightInstances{};
-
-    /*
-     * First compute the exact number of renderables and lights in the scene.
-     * Also find the main directional light.
-     */
-
-    for (Entity const e: entities) {
+    for (Entity const e: mEntities) {
         if (UTILS_LIKELY(em.isAlive(e))) {
             auto ti = tcm.getInstance(e);
             auto li = lcm.getInstance(e);
             auto ri = rcm.getInstance(e);
             if (li) {
-                // we handle the directional light here because it'd prevent multithreading below
+                // we handle the directional lights separately because we only keep a single one
                 if (UTILS_UNLIKELY(lcm.isDirectionalLight(li))) {
-                    // we don't store the directional lights, because we only have a single one
-                    if (lcm.getIntensity(li) >= maxIntensity) {
-                        maxIntensity = lcm.getIntensity(li);
-                        directionalLightInstances = { li, ti };
-                    }
+                    mDirectionalLightInstances.emplace_back(li, ti);
                 } else {
-                    lightInstances.emplace_back(li, ti);
+                    mLightInstances.emplace_back(li, ti);
                 }
             }
             if (ri) {
-                renderableInstances.emplace_back(ri, ti);
+                mRenderableInstances.emplace_back(ri, ti);
             }
         }
     }
 
-    SYSTRACE_NAME_END();
+    mRenderableManagerVersion = rcm.getVersion();
+    mLightManagerVersion = lcm.getVersion();
+    mTransformManagerVersion = tcm.getVersion();
+    mEntitiesChanged = false;
+}
+
+
+void FScene::prepare(utils::JobSystem& js,
+        RootArenaScope& rootArenaScope,
+        mat4 const& worldTransform,
+        bool shadowReceiversAreCasters) noexcept {
+    SYSTRACE_CALL();
+
+    SYSTRACE_CONTEXT();
+
+    FEngine& engine = mEngine;
+    FTransformManager const& tcm = engine.getTransformManager();
+    FLightManager const& lcm = engine.getLightManager();
+    FRenderableManager const& rcm = engine.getRenderableManager();
+    // go through the list of entities, and gather the data of those that are renderables
+    auto& sceneData = mRenderableData;
+    auto& lightData = mLightData;
+    auto const& entities = mEntities;
+
+    // the instances rarely change, so we only gather them again when they might have
+    bool const instancesChanged = instancesAreStale();
+    if (instancesChanged) {
+        updateInstances();
+    }
+    auto const& renderableInstances = mRenderableInstances;
+    auto const& lightInstances = mLightInstances;
+
+    // find the max intensity directional light
+    float maxIntensity = 0.0f;
+    std::pair<LightManager::Instance, TransformManager::Instance> directionalLightInstances{};
+    for (auto const& [li, ti] : mDirectionalLightInstances) {
+        if (lcm.getIntensity(li) >= maxIntensity) {
+            maxIntensity = lcm.getIntensity(li);
+            directionalLightInstances = { li, ti };
+        }
+    }
 
     /*
      * Evaluate the capacity needed for the renderable and light SoAs
      */
 
-    // we need the capacity to be multiple of 16 for SIMD loops
+    // the SoAs pad their arrays to a multiple of 16 elements for SIMD loops
     // we need 1 extra entry at the end for the summed primitive count
-    size_t renderableDataCapacity = entities.size();
-    renderableDataCapacity = (renderableDataCapacity + 0xFu) & ~0xFu;
-    renderableDataCapacity = renderableDataCapacity + 1;
+    size_t const renderableDataCapacity = entities.size() + 1;
 
     // The light data list will always contain at least one entry for the
     // dominating directional light, even if there are no entities.
-    // we need the capacity to be multiple of 16 for SIMD loops
-    size_t lightDataCapacity = std::max<size_t>(DIRECTIONAL_LIGHTS_COUNT, entities.size());
-    lightDataCapacity = (lightDataCapacity + 0xFu) & ~0xFu;
+    size_t const lightDataCapacity = std::max<size_t>(DIRECTIONAL_LIGHTS_COUNT, entities.size());
 
     /*
      * Now resize the SoAs if needed
@@ -166,6 +191,25 @@ void FScene::prepare(utils::JobSystem& js,
         lightData.resize(lightInstances.size() + DIRECTIONAL_LIGHTS_COUNT);
     }
 
+    /*
+     * When the preparation is shared, the renderables prepared by a previous View of this frame
+     * are reused, even though that View reordered them; only the lights are prepared again.
+     */
+
+    auto const sameTransform = [](mat4 const& a, mat4 const& b) {
+        return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+    };
+    uint32_t const frameIndex = engine.getFrameIndex();
+    bool const reuseRenderables = mSharedPreparation && mRenderablesPrepared && !instancesChanged &&
+            mPreparedFrameIndex == frameIndex &&
+            mPreparedShadowReceiversAreCasters == shadowReceiversAreCasters &&
+            sameTransform(mPreparedWorldTransform, worldTransform) &&
+            sceneData.size() == renderableInstances.size();
+    mPreparedWorldTransform = worldTransform;
+    mPreparedFrameIndex = frameIndex;
+    mPreparedShadowReceiversAreCasters = shadowReceiversAreCasters;
+    mRenderablesPrepared = true;
+
     /*
      * Fill the SoA with the JobSystem
      */
@@ -179,7 +223,7 @@ void FScene::prepare(utils::JobSystem& js,
 
             // this is where we go from double to float for our transforms
             const mat4f shaderWorldTransform{
-                    worldTransform * tcm.getWorldTransformAccurate(ti) };
+                    worldTransform * tcm.getPublishedWorldTransformAccurate(ti) };
             const bool reversedWindingOrder = det(shaderWorldTransform.upperLeft()) < 0;
 
             // compute the world AABB so we can perform culling
@@ -193,7 +237,7 @@ void FScene::prepare(utils::JobSystem& js,
 
             // FIXME: We compute and store the local scale because it's needed for glTF but
             //        we need a better way to handle this
-            const mat4f& transform = tcm.getTransform(ti);
+            const mat4f& transform = tcm.getPublishedTransform(ti);
             float const scale = (length(transform[0].xyz) + length(transform[1].xyz) +
                                  length(transform[2].xyz)) / 3.0f;
 
@@ -225,7 +269,7 @@ void FScene::prepare(utils::JobSystem& js,
             auto [li, ti] = p[i];
             // this is where we go from double to float for our transforms
             mat4f const shaderWorldTransform{
-                    worldTransform * tcm.getWorldTransformAccurate(ti) };
+                    worldTransform * tcm.getPublishedWorldTransformAccurate(ti) };
             float4 const position = shaderWorldTransform * float4{ lcm.getLocalPosition(li), 1 };
             float3 d = 0;
             if (!lcm.isPointLight(li) || lcm.isIESLight(li)) {
@@ -247,7 +291,7 @@ void FScene::prepare(utils::JobSystem& js,
     JobSystem::Job* rootJob = js.createJob();
 
     auto* renderableJob = jobs::parallel_for(js, rootJob,
-            renderableInstances.data(), renderableInstances.size(),
+            renderableInstances.data(), reuseRenderables ? 0 : renderableInstances.size(),
             std::cref(renderableWork), jobs::CountSplitter<128, 5>());
 
     auto* lightJob = jobs::parallel_for(js, rootJob,
@@ -267,8 +311,8 @@ void FScene::prepare(utils::JobSystem& js,
         // in the code below, we only transform directions, so the translation of the
         // world transform is irrelevant, and we don't need to use getWorldTransformAccurate()
 
-        mat3 const worldDirectionTransform =
-                mat3::getTransformForNormals(tcm.getWorldTransformAccurate(ti).upperLeft());
+        mat3 const worldDirectionTransform = mat3::getTransformForNormals(
+                tcm.getPublishedWorldTransformAccurate(ti).upperLeft());
         FLightManager::ShadowParams const params = lcm.getShadowParams(li);
         float3 const localDirection = worldDirectionTransform * lcm.getLocalDirection(li);
         double3 const shadowLocalDirection = params.options.transform * localDirection;
@@ -324,12 +368,19 @@ void FScene::prepare(utils::JobSystem& js,
     js.runAndWait(rootJob);
 
     SYSTRACE_NAME_END();
+
+    if (mCullingHierarchy) {
+        mCullingHierarchy->update(sceneData.data<RENDERABLE_INSTANCE>(),
+                sceneData.data<WORLD_AABB_CENTER>(), sceneData.data<WORLD_AABB_EXTENT>(),
+                sceneData.size());
+    }
 }
 
 void FScene::prepareVisibleRenderables(Range<uint32_t> visibleRenderables) noexcept {
     SYSTRACE_CALL();
     RenderableSoa& sceneData = mRenderableData;
     FRenderableManager const& rcm = mEngine.getRenderableManager();
+    uint32_t const frameIndex = mEngine.getFrameIndex();
 
     mHasContactShadows = false;
     for (uint32_t const i : visibleRenderables) {
@@ -364,6 +415,25 @@ void FScene::prepareVisibleRenderables(Range<uint32_t> visibleRenderables) noexc
 
         uboData.worldFromModelNormalMatrix = m;
 
+        Entity const entity = rcm.getEntity(ri);
+
+        // The previous transform only advances once per frame, so that all views of this frame
+        // get the same one. If the renderable wasn't visible in the previous frame, we don't
+        // know where it was, and it's assumed static.
+        if (UTILS_UNLIKELY(ri.asValue() >= mTransformHistory.size())) {
+            mTransformHistory.resize(ri.asValue() + 1);
+        }
+        TransformHistory& history = mTransformHistory[ri.asValue()];
+        if (history.frameIndex != frameIndex || history.entity != entity) {
+            bool const continuous = history.entity == entity &&
+                    history.frameIndex == frameIndex - 1;
+            history.previous = continuous ? history.current : model;
+            history.entity = entity;
+            history.frameIndex = frameIndex;
+        }
+        history.current = model;
+        uboData.previousWorldFromModelMatrix = history.previous;
+
         uboData.flagsChannels = PerRenderableData::packFlagsChannels(
                 visibility.skinning,
                 visibility.morphing,
@@ -373,7 +443,7 @@ void FScene::prepareVisibleRenderables(Range<uint32_t> visibleRenderables) noexc
 
         uboData.morphTargetCount = sceneData.elementAt<MORPHING_BUFFER>(i).count;
 
-        uboData.objectId = rcm.getEntity(ri).getId();
+        uboData.objectId = entity.getId();
 
         // TODO: We need to find a better way to provide the scale information per object
         uboData.userData = sceneData.elementAt<USER_DATA>(i);
@@ -384,23 +454,15 @@ void FScene::prepareVisibleRenderables(Range<uint32_t> visibleRenderables) noexc
 
 void FScene::updateUBOs(
         Range<uint32_t> visibleRenderables,
-        Handle<HwBufferObject> renderableUbh) noexcept {
+        Handle<HwBufferObject> renderableUbh,
+        std::vector<PerRenderableData>& uploaded) noexcept {
     SYSTRACE_CALL();
     FEngine::DriverApi& driver = mEngine.getDriverApi();
 
     // don't allocate more than 16 KiB directly into the render stream
     static constexpr size_t MAX_STREAM_ALLOCATION_COUNT = 64;   // 16 KiB
     const size_t count = visibleRenderables.size();
-    PerRenderableData* buffer = [&]{
-        if (count >= MAX_STREAM_ALLOCATION_COUNT) {
-            // use the heap allocator
-            auto& bufferPoolAllocator = mSharedState->mBufferPoolAllocator;
-            return (PerRenderableData*)bufferPoolAllocator.get(count * sizeof(PerRenderableData));
-        } else {
-            // allocate space into the command stream directly
-            return driver.allocatePod<PerRenderableData>(count);
-        }
-    }();
+    assert_invariant(visibleRenderables.first == 0);
 
     PerRenderableData const* const uboData = mRenderableData.data<UBO>();
     mat4f const* const worldTransformData = mRenderableData.data<WORLD_TRANSFORM>();
@@ -415,30 +477,83 @@ void FScene::updateUBOs(
         }
     }
 
-    // copy our data into the UBO for each visible renderable
-    for (uint32_t const i : visibleRenderables) {
-        buffer[i] = uboData[i];
+    // Copies the given rows into a buffer owned by the command stream or the buffer pool, and
+    // uploads them to the UBO.
+    auto upload = [&](Range<uint32_t> rows, bool synchronized) {
+        const size_t n = rows.size();
+        PerRenderableData* const buffer = (n >= MAX_STREAM_ALLOCATION_COUNT) ?
+                (PerRenderableData*)mSharedState->mBufferPoolAllocator.get(
+                        n * sizeof(PerRenderableData)) :
+                driver.allocatePod<PerRenderableData>(n);
+        std::copy(uboData + rows.first, uboData + rows.last, buffer);
+
+        // We capture state shared between Scene and the update buffer callback, because the
+        // Scene could be destroyed before the callback executes.
+        std::weak_ptr<SharedState>* const weakShared =
+                new std::weak_ptr<SharedState>(mSharedState);
+
+        BufferDescriptor data{
+                buffer, n * sizeof(PerRenderableData),
+                +[](void* p, size_t s, void* user) {
+                    std::weak_ptr<SharedState>* const weakShared =
+                            static_cast<std::weak_ptr<SharedState>*>(user);
+                    if (s >= MAX_STREAM_ALLOCATION_COUNT * sizeof(PerRenderableData)) {
+                        if (auto state = weakShared->lock()) {
+                            state->mBufferPoolAllocator.put(p);
+                        }
+                    }
+                    delete weakShared;
+                }, weakShared };
+        uint32_t const byteOffset = uint32_t(rows.first * sizeof(PerRenderableData));
+        if (synchronized) {
+            driver.updateBufferObject(renderableUbh, std::move(data), byteOffset);
+        } else {
+            driver.updateBufferObjectUnsynchronized(renderableUbh, std::move(data), byteOffset);
+        }
+    };
+
+    // Find the rows that differ from the ones the UBO already holds. Renderables are in the same
+    // order from frame to frame unless the scene or their visibility change, so in mostly static
+    // scenes this is a small fraction of the rows, which we upload as a few coalesced ranges.
+    static constexpr size_t MAX_DIRTY_RANGES = 16;
+    static constexpr uint32_t MAX_RANGE_GAP = 4;
+    Range<uint32_t> ranges[MAX_DIRTY_RANGES];
+    size_t rangeCount = 0;
+    bool uploadAll = uploaded.size() < count;
+    if (!uploadAll) {
+        size_t dirtyCount = 0;
+        for (uint32_t const i : visibleRenderables) {
+            if (!memcmp(uploaded.data() + i, uboData + i, sizeof(PerRenderableData))) {
+                continue;
+            }
+            if (rangeCount && i - ranges[rangeCount - 1].last <= MAX_RANGE_GAP) {
+                dirtyCount += i + 1 - ranges[rangeCount - 1].last;
+                ranges[rangeCount - 1].last = i + 1;
+            } else if (rangeCount < MAX_DIRTY_RANGES) {
+                dirtyCount++;
+                ranges[rangeCount++] = { i, i + 1 };
+            } else {
+                uploadAll = true;
+                break;
+            }
+        }
+        // past this point, replacing the whole UBO is cheaper than synchronized updates
+        uploadAll = uploadAll || dirtyCount > count / 2;
     }
 
-    // We capture state shared between Scene and the update buffer callback, because the Scene could
-    // be destroyed before the callback executes.
-    std::weak_ptr<SharedState>* const weakShared = new std::weak_ptr<SharedState>(mSharedState);
-
-    // update the UBO
-    driver.resetBufferObject(renderableUbh);
-    driver.updateBufferObjectUnsynchronized(renderableUbh, {
-            buffer, count * sizeof(PerRenderableData),
-            +[](void* p, size_t s, void* user) {
-                std::weak_ptr<SharedState>* const weakShared =
-                        static_cast<std::weak_ptr<SharedState>*>(user);
-                if (s >= MAX_STREAM_ALLOCATION_COUNT * sizeof(PerRenderableData)) {
-                    if (auto state = weakShared->lock()) {
-                        state->mBufferPoolAllocator.put(p);
-                    }
-                }
-                delete weakShared;
-            }, weakShared
-    }, 0);
+    if (uploadAll) {
+        // orphan the UBO and upload everything
+        uploaded.assign(uboData, uboData + count);
+        driver.resetBufferObject(renderableUbh);
+        upload(visibleRenderables, false);
+        return;
+    }
+
+    for (size_t r = 0; r < rangeCount; r++) {
+        std::copy(uboData + ranges[r].first, uboData + ranges[r].last,
+                uploaded.data() + ranges[r].first);
+        upload(ranges[r], true);
+    }
 }
 
 void FScene::terminate(FEngine&) {
@@ -527,16 +642,19 @@ inline void FScene::computeLightRanges(
 UTILS_NOINLINE
 void FScene::addEntity(Entity entity) {
     mEntities.insert(entity);
+    mEntitiesChanged = true;
 }
 
 UTILS_NOINLINE
 void FScene::addEntities(const Entity* entities, size_t count) {
     mEntities.insert(entities, entities + count);
+    mEntitiesChanged = true;
 }
 
 UTILS_NOINLINE
 void FScene::remove(Entity entity) {
     mEntities.erase(entity);
+    mEntitiesChanged = true;
 }
 
 UTILS_NOINLINE
@@ -617,4 +735,12 @@ void FScene::forEach(Invocable<void(Entity)>&& functor) const noexcept {
     std::for_each(mEntities.begin(), mEntities.end(), std::move(functor));
 }
 
+void FScene::setCullingHierarchyEnabled(bool enabled) noexcept {
+    if (!enabled) {
+        mCullingHierarchy.reset();
+    } else if (!mCullingHierarchy) {
+        mCullingHierarchy = std::make_unique<CullingHierarchy>();
+    }
+}
+
 } // namespace filament
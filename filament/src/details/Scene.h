@@ -21,6 +21,7 @@
 
 #include "Allocators.h"
 #include "Culler.h"
+#include "CullingHierarchy.h"
 
 #include "components/LightManager.h"
 #include "components/RenderableManager.h"
@@ -45,6 +46,7 @@
 #include <tsl/robin_set.h>
 
 #include <memory>
+#include <vector>
 
 namespace filament {
 
@@ -110,7 +112,8 @@ public:
         USER_DATA,              //   4 | user data currently used to store the scale
     };
 
-    using RenderableSoa = utils::StructureOfArrays<
+    // arrays are padded to a multiple of 16 renderables, so that they can be culled in batches
+    using RenderableSoa = utils::BatchedStructureOfArrays<16,
             utils::EntityInstance<RenderableManager>,   // RENDERABLE_INSTANCE
             math::mat4f,                                // WORLD_TRANSFORM
             FRenderableManager::Visibility,             // VISIBILITY_STATE
@@ -129,6 +132,8 @@ public:
             float                                       // USER_DATA
     >;
 
+    static_assert(RenderableSoa::getBatchSize() % Culler::MODULO == 0);
+
     RenderableSoa const& getRenderableData() const noexcept { return mRenderableData; }
     RenderableSoa& getRenderableData() noexcept { return mRenderableData; }
 
@@ -168,7 +173,7 @@ public:
         SHADOW_INFO
     };
 
-    using LightSoa = utils::StructureOfArrays<
+    using LightSoa = utils::BatchedStructureOfArrays<16,
             math::float4,
             math::float3,
             math::float3,
@@ -182,11 +187,21 @@ public:
     LightSoa const& getLightData() const noexcept { return mLightData; }
     LightSoa& getLightData() noexcept { return mLightData; }
 
+    // Uploads the UBO data of the visible renderables. `uploaded` holds what the UBO last
+    // received and must be cleared when the UBO is recreated; only the rows that changed are
+    // uploaded.
     void updateUBOs(utils::Range<uint32_t> visibleRenderables,
-            backend::Handle<backend::HwBufferObject> renderableUbh) noexcept;
+            backend::Handle<backend::HwBufferObject> renderableUbh,
+            std::vector<PerRenderableData>& uploaded) noexcept;
 
     bool hasContactShadows() const noexcept;
 
+    // Returns the culling hierarchy of the renderables set up by prepare(), or nullptr if it is
+    // disabled.
+    CullingHierarchy const* getCullingHierarchy() const noexcept {
+        return mCullingHierarchy.get();
+    }
+
 private:
     friend class Scene;
     void setSkybox(FSkybox* skybox) noexcept;
@@ -200,6 +215,13 @@ private:
     size_t getLightCount() const noexcept;
     bool hasEntity(utils::Entity entity) const noexcept;
     void forEach(utils::Invocable<void(utils::Entity)>&& functor) const noexcept;
+    void setCullingHierarchyEnabled(bool enabled) noexcept;
+    bool isCullingHierarchyEnabled() const noexcept { return bool(mCullingHierarchy); }
+    void setSharedPreparationEnabled(bool enabled) noexcept {
+        mSharedPreparation = enabled;
+        mRenderablesPrepared = false;
+    }
+    bool isSharedPreparationEnabled() const noexcept { return mSharedPreparation; }
 
     static inline void computeLightRanges(math::float2* zrange,
             CameraInfo const& camera, const math::float4* spheres, size_t count) noexcept;
@@ -215,6 +237,33 @@ private:
      */
     tsl::robin_set<utils::Entity, utils::Entity::Hasher> mEntities;
 
+    /*
+     * The renderable and light instances of mEntities, gathered by prepare(). They only change
+     * when entities are added to or removed from the scene, when entities of the scene are
+     * destroyed, or when components are created, destroyed or reordered, in which case the
+     * versions below differ from the managers'. The SoAs are still refreshed on each prepare().
+     */
+    void updateInstances() noexcept;
+    bool instancesAreStale() noexcept;
+    using RenderableInstances = std::pair<FRenderableManager::Instance, FTransformManager::Instance>;
+    using LightInstances = std::pair<FLightManager::Instance, FTransformManager::Instance>;
+    std::vector<RenderableInstances> mRenderableInstances;
+    std::vector<LightInstances> mLightInstances;
+    std::vector<LightInstances> mDirectionalLightInstances;
+    uint64_t mDestroyedEntitiesCursor = 0;
+    uint32_t mRenderableManagerVersion = 0;
+    uint32_t mLightManagerVersion = 0;
+    uint32_t mTransformManagerVersion = 0;
+    bool mEntitiesChanged = true;
+
+    // Parameters of the last renderables preparation, which can be reused by the next View of
+    // the same frame when the preparation is shared.
+    math::mat4 mPreparedWorldTransform;
+    uint32_t mPreparedFrameIndex = 0;
+    bool mPreparedShadowReceiversAreCasters = false;
+    bool mRenderablesPrepared = false;
+    bool mSharedPreparation = false;
+
 
     /*
      * The data below is valid only during a view pass. i.e. if a scene is used in multiple
@@ -226,6 +275,20 @@ private:
     LightSoa mLightData;
     bool mHasContactShadows = false;
 
+    // this one is persistent, it is updated from mRenderableData on each prepare()
+    std::unique_ptr<CullingHierarchy> mCullingHierarchy;
+
+    // World transforms of the current and previous frames, indexed by renderable instance. This
+    // is persistent so that each view of a frame sees the same previous transforms. Instances
+    // are reused by the RenderableManager, so the entity is checked too.
+    struct TransformHistory {
+        math::mat4f current;
+        math::mat4f previous;
+        utils::Entity entity;
+        uint32_t frameIndex = 0;
+    };
+    std::vector<TransformHistory> mTransformHistory;
+
     // State shared between Scene and driver callbacks.
     struct SharedState {
         BufferPoolAllocator<3> mBufferPoolAllocator = {};
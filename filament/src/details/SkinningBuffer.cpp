@@ -125,10 +125,7 @@ void FSkinningBuffer::setBones(FEngine& engine, Handle<backend::HwBufferObject>
     auto& driverApi = engine.getDriverApi();
     auto* UTILS_RESTRICT out = driverApi.allocatePod<PerRenderableBoneUib::BoneData>(boneCount);
     for (size_t i = 0, c = boneCount; i < c; ++i) {
-        // the transform is stored in row-major, last row is not stored.
-        mat4f transform(transforms[i].unitQuaternion);
-        transform[3] = float4{ transforms[i].translation, 1.0f };
-        out[i] = makeBone(transform);
+        out[i] = makeBone(transforms[i].unitQuaternion, transforms[i].translation);
     }
     driverApi.updateBufferObject(handle, {
                     out, boneCount * sizeof(PerRenderableBoneUib::BoneData) },
@@ -154,6 +151,28 @@ PerRenderableBoneUib::BoneData FSkinningBuffer::makeBone(mat4f transform) noexce
     };
 }
 
+PerRenderableBoneUib::BoneData FSkinningBuffer::makeBone(
+        quatf const& unitQuaternion, float3 const& translation) noexcept {
+    // the cofactor matrix of a rotation R is det(R) * transpose(inverse(R)), i.e. R itself, so
+    // we can skip computing it.
+    const mat3f rotation(unitQuaternion);
+    const mat3f rows = transpose(rotation); // row-major conversion
+    return {
+            .transform = {
+                    float4{ rows[0], translation.x },
+                    float4{ rows[1], translation.y },
+                    float4{ rows[2], translation.z }
+            },
+            .cof = {
+                    packHalf2x16({ rotation[0].x, rotation[0].y }),
+                    packHalf2x16({ rotation[0].z, rotation[1].x }),
+                    packHalf2x16({ rotation[1].y, rotation[1].z }),
+                    packHalf2x16({ rotation[2].x, rotation[2].y })
+                    // cofactor[2][2] is not stored because we don't have space for it
+            }
+    };
+}
+
 void FSkinningBuffer::setBones(FEngine& engine, Handle<backend::HwBufferObject> handle,
         mat4f const* transforms, size_t boneCount, size_t offset) noexcept {
     auto& driverApi = engine.getDriverApi();
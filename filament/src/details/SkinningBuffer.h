@@ -28,7 +28,9 @@
 #include <backend/Handle.h>
 
 #include <utils/compiler.h>
+#include <math/quat.h>
 #include <math/vec2.h>
+#include <math/vec3.h>
 
 // for gtest
 class FilamentTest_Bones_Test;
@@ -49,6 +51,10 @@ public:
     void setBones(FEngine& engine, math::mat4f const* transforms, size_t count, size_t offset);
     size_t getBoneCount() const noexcept { return mBoneCount; }
 
+    size_t getByteCount() const noexcept {
+        return getPhysicalBoneCount(mBoneCount) * sizeof(PerRenderableBoneUib::BoneData);
+    }
+
     // round count to the size of the UBO in the shader
     static size_t getPhysicalBoneCount(size_t count) noexcept {
         static_assert((CONFIG_MAX_BONE_COUNT & (CONFIG_MAX_BONE_COUNT - 1)) == 0);
@@ -71,6 +77,10 @@ private:
 
     static PerRenderableBoneUib::BoneData makeBone(math::mat4f transform) noexcept;
 
+    // same as makeBone() for a rigid transform, whose cofactor matrix is its rotation
+    static PerRenderableBoneUib::BoneData makeBone(
+            math::quatf const& unitQuaternion, math::float3 const& translation) noexcept;
+
     backend::Handle<backend::HwBufferObject> getHwHandle() const noexcept {
         return mHandle;
     }
@@ -263,6 +263,23 @@ size_t FTexture::getDepth(size_t level) const noexcept {
     return valueForLevel(level, mDepth);
 }
 
+size_t FTexture::getStorageSize() const noexcept {
+    size_t const formatSize = getFormatSize(mFormat);
+    size_t const blockWidth = isCompressed() ? backend::getBlockWidth(mFormat) : 1;
+    size_t const blockHeight = isCompressed() ? backend::getBlockHeight(mFormat) : 1;
+    size_t const faceCount = (mTarget == Sampler::SAMPLER_CUBEMAP ||
+            mTarget == Sampler::SAMPLER_CUBEMAP_ARRAY) ? 6 : 1;
+    size_t size = 0;
+    for (size_t level = 0; level < mLevelCount; level++) {
+        // only 3D textures get smaller in depth, for arrays the depth is the layer count
+        size_t const depth = mTarget == Sampler::SAMPLER_3D ? getDepth(level) : mDepth;
+        size_t const w = (getWidth(level) + blockWidth - 1) / blockWidth;
+        size_t const h = (getHeight(level) + blockHeight - 1) / blockHeight;
+        size += w * h * depth * faceCount * formatSize;
+    }
+    return size * std::max(size_t(1), size_t(mSampleCount));
+}
+
 void FTexture::setImage(FEngine& engine, size_t level,
         uint32_t xoffset, uint32_t yoffset, uint32_t zoffset,
         uint32_t width, uint32_t height, uint32_t depth,
@@ -466,6 +483,18 @@ void FTexture::generateMipmaps(FEngine& engine) const noexcept {
     engine.getDriverApi().generateMipmaps(mHandle);
 }
 
+void FTexture::setMinMaxLevels(FEngine& engine, uint8_t const minLevel, uint8_t const maxLevel) {
+    FILAMENT_CHECK_PRECONDITION(any(mUsage & Usage::SAMPLEABLE))
+            << "Texture must be SAMPLEABLE";
+
+    FILAMENT_CHECK_PRECONDITION(minLevel <= maxLevel && maxLevel < mLevelCount)
+            << "minLevel (" << unsigned(minLevel) << ") must not be greater than maxLevel ("
+            << unsigned(maxLevel) << "), which must be less than the level count ("
+            << unsigned(mLevelCount) << ")";
+
+    engine.getDriverApi().setMinMaxLevels(mHandle, minLevel, maxLevel);
+}
+
 bool FTexture::isTextureFormatSupported(FEngine& engine, InternalFormat format) noexcept {
     return engine.getDriverApi().isTextureFormatSupported(format);
 }
@@ -43,6 +43,9 @@ public:
     size_t getHeight(size_t level = 0) const noexcept;
     size_t getDepth(size_t level = 0) const noexcept;
     size_t getLevelCount() const noexcept { return mLevelCount; }
+
+    // estimated size of the texture's storage in bytes, including all levels and samples
+    size_t getStorageSize() const noexcept;
     Sampler getTarget() const noexcept { return mTarget; }
     InternalFormat getFormat() const noexcept { return mFormat; }
     Usage getUsage() const noexcept { return mUsage; }
@@ -66,6 +69,8 @@ public:
 
     void generateMipmaps(FEngine& engine) const noexcept;
 
+    void setMinMaxLevels(FEngine& engine, uint8_t minLevel, uint8_t maxLevel);
+
     void setSampleCount(size_t sampleCount) noexcept { mSampleCount = uint8_t(sampleCount); }
     size_t getSampleCount() const noexcept { return mSampleCount; }
     bool isMultisample() const noexcept { return mSampleCount > 1; }
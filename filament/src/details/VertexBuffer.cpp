@@ -289,6 +289,7 @@ FVertexBuffer::FVertexBuffer(FEngine& engine, const VertexBuffer::Builder& build
                             backend::BufferObjectBinding::VERTEX, backend::BufferUsage::STATIC);
                     driver.setVertexBufferObject(mHandle, i, bo);
                     mBufferObjects[i] = bo;
+                    mByteCount += bufferSizes[i];
                 }
             }
         }
@@ -305,6 +306,7 @@ FVertexBuffer::FVertexBuffer(FEngine& engine, const VertexBuffer::Builder& build
                             backend::BufferObjectBinding::VERTEX, backend::BufferUsage::STATIC);
                     driver.setVertexBufferObject(mHandle, i, bo);
                     mBufferObjects[i] = bo;
+                    mByteCount += bufferSizes[i];
                 }
             }
         }
@@ -56,6 +56,9 @@ public:
 
     size_t getVertexCount() const noexcept;
 
+    // size of the buffer objects owned by this VertexBuffer, i.e. not set with setBufferObjectAt()
+    size_t getByteCount() const noexcept { return mByteCount; }
+
     AttributeBitset getDeclaredAttributes() const noexcept {
         return mDeclaredAttributes;
     }
@@ -78,6 +81,7 @@ private:
     std::array<BufferObjectHandle, backend::MAX_VERTEX_BUFFER_COUNT> mBufferObjects;
     AttributeBitset mDeclaredAttributes;
     uint32_t mVertexCount = 0;
+    uint32_t mByteCount = 0;
     uint8_t mBufferCount = 0;
     bool mBufferObjectsEnabled = false;
     bool mAdvancedSkinningEnabled = false;
@@ -36,6 +36,7 @@
 #include <private/filament/UibStructs.h>
 
 #include <utils/Profiler.h>
+#include <utils/algorithm.h>
 #include <utils/Slice.h>
 #include <utils/Systrace.h>
 #include <utils/debug.h>
@@ -45,7 +46,9 @@
 #include <math/fast.h>
 
 #include <array>
+#include <cmath>
 #include <memory>
+#include <string_view>
 
 using namespace utils;
 
@@ -57,6 +60,16 @@ using namespace math;
 static constexpr float PID_CONTROLLER_Ki = 0.002f;
 static constexpr float PID_CONTROLLER_Kd = 0.0f;
 
+// Dynamic resolution snaps the scaled viewport to multiples of this many pixels, so that the
+// render targets only change size when the scale changes significantly and are otherwise reused
+// from the ResourceAllocator's cache.
+static constexpr float DYNAMIC_RESOLUTION_SIZE_STEP = 16.0f;
+
+// Number of renderables culled by each job, enough to amortize the cost of the job (see
+// FView::cullRenderables). Must be a multiple of Culler::MODULO.
+static constexpr uint32_t JOBS_PARALLEL_FOR_CULLING_COUNT = 8192;
+static_assert(JOBS_PARALLEL_FOR_CULLING_COUNT % Culler::MODULO == 0);
+
 FView::FView(FEngine& engine)
         : mFroxelizer(engine),
           mFogEntity(engine.getEntityManager().create()),
@@ -115,6 +128,12 @@ void FView::terminate(FEngine& engine) {
         FPickingQuery::put(pQuery);
     }
 
+    while (mActivePickingBatchesList) {
+        std::unique_ptr<FPickingBatch> const pBatch(mActivePickingBatchesList);
+        mActivePickingBatchesList = pBatch->next;
+        pBatch->callback(pBatch->results.data(), pBatch->results.size(), pBatch->user);
+    }
+
     DriverApi& driver = engine.getDriverApi();
     driver.destroyBufferObject(mLightUbh);
     driver.destroyBufferObject(mRenderableUbh);
@@ -161,6 +180,20 @@ void FView::setDynamicLightingOptions(float zLightNear, float zLightFar) noexcep
     mFroxelizer.setOptions(zLightNear, zLightFar);
 }
 
+static float quantizeDynamicResolutionScale(float scale, uint32_t length) noexcept {
+    float const size = float(length) * scale;
+    if (scale == 1.0f || size < DYNAMIC_RESOLUTION_SIZE_STEP) {
+        return scale;
+    }
+    float const snapped = std::round(size / DYNAMIC_RESOLUTION_SIZE_STEP) *
+            DYNAMIC_RESOLUTION_SIZE_STEP;
+    if ((scale < 1.0f && snapped >= float(length)) || (scale > 1.0f && snapped <= float(length))) {
+        return 1.0f;
+    }
+    // the extra half pixel makes sure the size computed from this scale truncates to snapped
+    return (snapped + 0.5f) / float(length);
+}
+
 float2 FView::updateScale(FEngine& engine,
         FrameInfo const& info,
         Renderer::FrameRateOptions const& frameRateOptions,
@@ -269,6 +302,12 @@ float2 FView::updateScale(FEngine& engine,
     }
 #endif
 
+    if (options.enabled) {
+        // mScale stays continuous so that the controller isn't affected by the snapping
+        return {
+                quantizeDynamicResolutionScale(mScale.x, mViewport.width),
+                quantizeDynamicResolutionScale(mScale.y, mViewport.height) };
+    }
     return mScale;
 }
 
@@ -477,9 +516,13 @@ void FView::prepare(FEngine& engine, DriverApi& driver, RootArenaScope& rootAren
      * Gather all information needed to render this scene. Apply the world origin to all
      * objects in the scene.
      */
-    scene->prepare(js, rootArenaScope,
-            cameraInfo.worldTransform,
-            hasVSM());
+    {
+        FrameTimingsRecorder::Scope const timing(engine.getFrameTimingsRecorder(),
+                FrameTimingsRecorder::Stage::SCENE_PREPARE);
+        scene->prepare(js, rootArenaScope,
+                cameraInfo.worldTransform,
+                hasVSM());
+    }
 
     /*
      * Light culling: runs in parallel with Renderable culling (below)
@@ -523,7 +566,31 @@ void FView::prepare(FEngine& engine, DriverApi& driver, RootArenaScope& rootAren
          * (this will set the VISIBLE_RENDERABLE bit)
          */
 
-        prepareVisibleRenderables(js, cullingFrustum, renderableData);
+        {
+            FrameTimingsRecorder::Scope const timing(engine.getFrameTimingsRecorder(),
+                    FrameTimingsRecorder::Stage::CULLING);
+
+            prepareVisibleRenderables(js, cullingFrustum, renderableData);
+
+            /*
+             * Occlusion culling: test the renderables that passed frustum culling against the
+             * reprojected depth of a previous frame (this can clear the VISIBLE_RENDERABLE bit)
+             */
+
+            mHasReprojectedDepth = false;
+            if (UTILS_UNLIKELY(needsDepthReadback())) {
+                mClipFromUserWorld = mat4{ cameraInfo.projection } * cameraInfo.getUserViewMatrix();
+                mat4f const clipFromWorld{
+                        highPrecisionMultiply(cameraInfo.projection, cameraInfo.view) };
+                mHasReprojectedDepth = mOcclusionCuller.prepare(mClipFromUserWorld, clipFromWorld);
+                if (mHasReprojectedDepth && hasOcclusionCulling()) {
+                    mOcclusionCuller.intersects(renderableData.data<FScene::VISIBLE_MASK>(),
+                            renderableData.data<FScene::WORLD_AABB_CENTER>(),
+                            renderableData.data<FScene::WORLD_AABB_EXTENT>(),
+                            renderableData.size(), VISIBLE_RENDERABLE_BIT);
+                }
+            }
+        }
 
 
         /*
@@ -556,11 +623,26 @@ void FView::prepare(FEngine& engine, DriverApi& driver, RootArenaScope& rootAren
                 //       strictly necessary
                 mPerViewUniforms.prepareDynamicLights(mFroxelizer);
             }
+
+            // Restrict the lights to the froxels that had geometry in the reprojected depth
+            if (UTILS_UNLIKELY(hasLightDepthBounds() && mHasReprojectedDepth)) {
+                size_t const countX = froxelizer.getFroxelCountX();
+                size_t const countY = froxelizer.getFroxelCountY();
+                mFroxelDepthBounds.resize(countX * countY);
+                mOcclusionCuller.getDepthBounds(mFroxelDepthBounds.data(),
+                        countX, countY, froxelizer.getFroxelSize(),
+                        mat4f{ inverse(cameraInfo.projection) });
+                froxelizer.setDepthBounds({ mFroxelDepthBounds.data(), mFroxelDepthBounds.size() });
+            } else {
+                froxelizer.setDepthBounds({});
+            }
             // We need to pass viewMatrix by value here because it extends the scope of this
             // function.
             std::function<void(JobSystem&, JobSystem::Job*)> froxelizerWork =
                     [&froxelizer = mFroxelizer, &engine, viewMatrix = cameraInfo.view, &lightData]
                             (JobSystem&, JobSystem::Job*) {
+                        FrameTimingsRecorder::Scope const timing(engine.getFrameTimingsRecorder(),
+                                FrameTimingsRecorder::Stage::FROXELIZATION);
                         froxelizer.froxelizeLights(engine, viewMatrix, lightData);
                     };
             froxelizeLightsJob = js.runAndRetain(js.createJob(nullptr, std::move(froxelizerWork)));
@@ -568,7 +650,11 @@ void FView::prepare(FEngine& engine, DriverApi& driver, RootArenaScope& rootAren
 
         setFroxelizerSync(froxelizeLightsJob);
 
-        prepareShadowing(engine, renderableData, lightData, cameraInfo);
+        {
+            FrameTimingsRecorder::Scope const timing(engine.getFrameTimingsRecorder(),
+                    FrameTimingsRecorder::Stage::SHADOW_MAP_UPDATE);
+            prepareShadowing(engine, renderableData, lightData, cameraInfo);
+        }
 
         /*
          * Partition the SoA so that renderables are partitioned w.r.t their visibility into the
@@ -636,6 +722,12 @@ void FView::prepare(FEngine& engine, DriverApi& driver, RootArenaScope& rootAren
 
         SYSTRACE_NAME_END();
 
+        if (mDepthOfFieldOptions.enabled) {
+            // this lets depth-of-field skip its passes entirely when everything is in focus
+            mVisibleDistanceRange = computeVisibleDistanceRange(cameraInfo.view,
+                    renderableData, mVisibleRenderables);
+        }
+
         // TODO: when any spotlight is used, `merged` ends-up being the whole list. However,
         //       some of the items will end-up not being visible by any light. Can we do better?
         //       e.g. could we deffer some of the prepareVisibleRenderables() to later?
@@ -652,11 +744,12 @@ void FView::prepare(FEngine& engine, DriverApi& driver, RootArenaScope& rootAren
                 mRenderableUbh = driver.createBufferObject(
                         mRenderableUBOSize + sizeof(PerRenderableUib),
                         BufferObjectBinding::UNIFORM, BufferUsage::DYNAMIC);
+                mRenderableUboContents.clear();
             } else {
                 // TODO: should we shrink the underlying UBO at some point?
             }
             assert_invariant(mRenderableUbh);
-            scene->updateUBOs(merged, mRenderableUbh);
+            scene->updateUBOs(merged, mRenderableUbh, mRenderableUboContents);
         }
     }
 
@@ -683,6 +776,28 @@ void FView::prepare(FEngine& engine, DriverApi& driver, RootArenaScope& rootAren
     mPerViewUniforms.prepareMaterialGlobals(mMaterialGlobals);
 }
 
+float2 FView::computeVisibleDistanceRange(mat4f const& viewMatrix,
+        FScene::RenderableSoa const& renderableData, Range visible) noexcept {
+    SYSTRACE_CALL();
+    float3 const* const worldAABBCenter = renderableData.data<FScene::WORLD_AABB_CENTER>();
+    float3 const* const worldAABBExtent = renderableData.data<FScene::WORLD_AABB_EXTENT>();
+    auto const* const visibility = renderableData.data<FScene::VISIBILITY_STATE>();
+    float2 range{ std::numeric_limits<float>::max(), 0.0f };
+    for (uint32_t const i : visible) {
+        if (UTILS_UNLIKELY(!visibility[i].culling)) {
+            // the bounds of renderables that aren't culled (e.g. the skybox) are meaningless
+            return { 0.0f, std::numeric_limits<float>::infinity() };
+        }
+        Aabb const aabb{ worldAABBCenter[i] - worldAABBExtent[i],
+                         worldAABBCenter[i] + worldAABBExtent[i] };
+        Aabb const r = Aabb::transform(viewMatrix.upperLeft(), viewMatrix[3].xyz, aabb);
+        // the camera looks towards -z
+        range.x = std::min(range.x, -r.max.z);
+        range.y = std::max(range.y, -r.min.z);
+    }
+    return { std::max(range.x, 0.0f), range.y };
+}
+
 void FView::bindPerViewUniformsAndSamplers(FEngine::DriverApi& driver) const noexcept {
     mPerViewUniforms.bind(driver);
 
@@ -755,14 +870,17 @@ void FView::prepareUpscaler(float2 scale,
     SYSTRACE_CALL();
     float bias = 0.0f;
     float2 derivativesScale{ 1.0f };
+    if (taaOptions.enabled && taaOptions.upscaling) {
+        // TAA upscaling is accounted for by the derivatives scale, the bias below only needs
+        // to account for dynamic resolution.
+        derivativesScale = 0.5f;
+        scale *= 2.0f;
+    }
     if (dsrOptions.enabled && dsrOptions.quality >= QualityLevel::HIGH) {
         bias = std::log2(std::min(scale.x, scale.y));
     }
     if (taaOptions.enabled) {
         bias += taaOptions.lodBias;
-        if (taaOptions.upscaling) {
-            derivativesScale = 0.5f;
-        }
     }
     mPerViewUniforms.prepareLodBias(bias, derivativesScale);
 }
@@ -846,15 +964,28 @@ void FView::prepareVisibleRenderables(JobSystem& js,
         Frustum const& frustum, FScene::RenderableSoa& renderableData) const noexcept {
     SYSTRACE_CALL();
     if (UTILS_LIKELY(isFrustumCullingEnabled())) {
-        FView::cullRenderables(js, renderableData, frustum, VISIBLE_RENDERABLE_BIT);
+        FView::cullRenderables(js, renderableData, frustum, VISIBLE_RENDERABLE_BIT,
+                getScene()->getCullingHierarchy());
     } else {
         std::uninitialized_fill(renderableData.begin<FScene::VISIBLE_MASK>(),
                   renderableData.end<FScene::VISIBLE_MASK>(), VISIBLE_RENDERABLE);
     }
 }
 
-void FView::cullRenderables(JobSystem&,
-        FScene::RenderableSoa& renderableData, Frustum const& frustum, size_t bit) noexcept {
+void FView::cullRenderables(JobSystem& js,
+        FScene::RenderableSoa& renderableData, Frustum const& frustum, size_t bit,
+        CullingHierarchy const* hierarchy) noexcept {
+    if (hierarchy) {
+        assert_invariant(hierarchy->size() == renderableData.size());
+        hierarchy->intersects(renderableData.data<FScene::VISIBLE_MASK>(), frustum, bit);
+        return;
+    }
+    cullRenderables(js, renderableData, frustum, bit, { 0, uint32_t(renderableData.size()) });
+}
+
+void FView::cullRenderables(JobSystem& js,
+        FScene::RenderableSoa& renderableData, Frustum const& frustum, size_t bit,
+        Range range) noexcept {
     SYSTRACE_CALL();
 
     float3 const* worldAABBCenter = renderableData.data<FScene::WORLD_AABB_CENTER>();
@@ -871,12 +1002,24 @@ void FView::cullRenderables(JobSystem&,
                 worldAABBExtent + index, c, bit);
     };
 
-    // Note: we can't use jobs::parallel_for() here because Culler::intersects() must process
-    //       multiples of eight primitives.
-    // Moreover, even with a large number of primitives, the overhead of the JobSystem is too
-    // large compared to the run time of Culler::intersects, e.g.: ~100us for 4000 primitives
-    // on Pixel4.
-    functor(0, renderableData.size());
+    // The overhead of the JobSystem is large compared to the run time of Culler::intersects,
+    // e.g.: ~100us for 4000 primitives on Pixel4, so we only go wide for large scenes.
+    if (range.size() < JOBS_PARALLEL_FOR_CULLING_COUNT * 2) {
+        functor(range.first, range.size());
+        return;
+    }
+
+    // Culler::intersects() must process multiples of MODULO primitives, so we split the work
+    // in groups of MODULO primitives; only the last group can extend past the range.
+    constexpr uint32_t MODULO = Culler::MODULO;
+    auto groupFunctor = [&functor, range](uint32_t group, uint32_t groupCount) {
+        uint32_t const index = range.first + group * MODULO;
+        functor(index, std::min(groupCount * MODULO, range.last - index));
+    };
+    uint32_t const groupCount = (range.size() + MODULO - 1) / MODULO;
+    auto* job = jobs::parallel_for(js, nullptr, 0, groupCount, std::cref(groupFunctor),
+            jobs::CountSplitter<JOBS_PARALLEL_FOR_CULLING_COUNT / MODULO, 5>());
+    js.runAndWait(job);
 }
 
 void FView::prepareVisibleLights(FLightManager const& lcm,
@@ -988,13 +1131,33 @@ inline void FView::computeLightCameraDistances(
     }
 }
 
-void FView::updatePrimitivesLod(FEngine& engine, const CameraInfo&,
+void FView::updatePrimitivesLod(FEngine& engine, const CameraInfo& camera,
         FScene::RenderableSoa& renderableData, Range visible) noexcept {
     FRenderableManager const& rcm = engine.getRenderableManager();
+
+    // The screen size of a renderable is the diameter of its bounding sphere relative to the
+    // viewport height, that is its radius times the vertical scale of the projection, divided by
+    // its distance to the camera for perspective projections.
+    float const projectionScale = camera.projection[1][1];
+    bool const perspective = camera.projection[2][3] != 0.0f;
+    float3 const eye = camera.getPosition();
+
     for (uint32_t const index : visible) {
-        uint8_t const level = 0; // TODO: pick the proper level of detail
         auto ri = renderableData.elementAt<FScene::RENDERABLE_INSTANCE>(index);
-        renderableData.elementAt<FScene::PRIMITIVES>(index) = rcm.getRenderPrimitives(ri, level);
+        if (UTILS_LIKELY(rcm.getLevelCount(ri) == 1)) {
+            renderableData.elementAt<FScene::PRIMITIVES>(index) = rcm.getRenderPrimitives(ri, 0);
+            continue;
+        }
+        float3 const center = renderableData.elementAt<FScene::WORLD_AABB_CENTER>(index);
+        float const radius = length(renderableData.elementAt<FScene::WORLD_AABB_EXTENT>(index));
+        float const distance = perspective ?
+                std::max(length(center - eye), std::numeric_limits<float>::min()) : 1.0f;
+        uint8_t const level = rcm.getLevelOfDetail(ri, radius * projectionScale / distance);
+
+        // the morph targets are indexed like the primitives, so they need to follow the level
+        renderableData.elementAt<FScene::PRIMITIVES>(index) = rcm.getLevelPrimitives(ri, level);
+        renderableData.elementAt<FScene::MORPHING_BUFFER>(index).targets =
+                rcm.getLevelMorphTargets(ri, level);
     }
 }
 
@@ -1072,6 +1235,62 @@ void FView::executePickingQueries(backend::DriverApi& driver,
             });
         }
     }
+
+    bool const featureLevel0 = driver.getFeatureLevel() == FeatureLevel::FEATURE_LEVEL_0;
+    while (mActivePickingBatchesList) {
+        FPickingBatch* const pBatch = mActivePickingBatchesList;
+        mActivePickingBatchesList = pBatch->next;
+
+        // read back the rectangle that bounds all the points of the batch, at once
+        uint2 lo{ std::numeric_limits<uint32_t>::max() };
+        uint2 hi{ 0 };
+        for (uint2 const p : pBatch->points) {
+            uint2 const s{ float2(p) * scale };
+            lo = min(lo, s);
+            hi = max(hi, s);
+        }
+        pBatch->origin = lo;
+        pBatch->size = hi - lo + 1u;
+        pBatch->scale = scale;
+        pBatch->featureLevel0 = featureLevel0;
+
+        // at feature level 0 the picking buffer is RGBA8, otherwise it's RG32F
+        size_t const texelSize = featureLevel0 ? 4u : 8u;
+        size_t const size = size_t(pBatch->size.x) * pBatch->size.y * texelSize;
+        pBatch->pixels = std::make_unique<uint8_t[]>(size);
+        driver.readPixels(handle, lo.x, lo.y, pBatch->size.x, pBatch->size.y, {
+                pBatch->pixels.get(), size,
+                featureLevel0 ? backend::PixelDataFormat::RGBA : backend::PixelDataFormat::RG,
+                featureLevel0 ? backend::PixelDataType::UBYTE : backend::PixelDataType::FLOAT,
+                pBatch->handler, [](void*, size_t, void* user) {
+                    std::unique_ptr<FPickingBatch> const pBatch(static_cast<FPickingBatch*>(user));
+                    pBatch->resolve();
+                    pBatch->callback(pBatch->results.data(), pBatch->results.size(),
+                            pBatch->user);
+                }, pBatch
+        });
+    }
+}
+
+void FView::FPickingBatch::resolve() noexcept {
+    for (size_t i = 0, c = points.size(); i < c; i++) {
+        uint2 const p = points[i];
+        uint2 const s = uint2{ float2(p) * scale } - origin;
+        size_t const texel = size_t(s.y) * size.x + s.x;
+        PickingQueryResult& result = results[i];
+        if (UTILS_UNLIKELY(featureLevel0)) {
+            // same encoding as for a single query, see executePickingQueries()
+            uint8_t const* const q = pixels.get() + texel * 4u;
+            int32_t const identity = int32_t(uint32_t(q[3]) << 16u | uint32_t(q[2]) << 8u | q[1]);
+            result.renderable = Entity::import(identity);
+            result.depth = float(q[0]) / 255.0f;
+        } else {
+            float2 const q = reinterpret_cast<float2 const*>(pixels.get())[texel];
+            result.renderable = Entity::import(int32_t(utils::bit_cast<uint32_t>(q.x)));
+            result.depth = q.y;
+        }
+        result.fragCoords = { p.x, p.y, float(1.0 - result.depth) };
+    }
 }
 
 void FView::setTemporalAntiAliasingOptions(TemporalAntiAliasingOptions options) noexcept {
@@ -1091,6 +1310,7 @@ void FView::setScreenSpaceReflectionsOptions(ScreenSpaceReflectionsOptions optio
     options.bias = std::max(0.0f, options.bias);
     options.maxDistance = std::max(0.0f, options.maxDistance);
     options.stride = std::max(1.0f, options.stride);
+    options.resolution = options.resolution <= 0.5f ? 0.5f : 1.0f;
     mScreenSpaceReflectionsOptions = options;
 }
 
@@ -1130,6 +1350,79 @@ void FView::setSoftShadowOptions(SoftShadowOptions options) noexcept {
     mSoftShadowOptions = options;
 }
 
+void FView::setPostProcessingBudget(float milliseconds) noexcept {
+    mPostProcessingBudget = { .budget = std::max(0.0f, milliseconds) };
+}
+
+void FView::updatePostProcessingBudget(Renderer::GpuPassTiming const* timings, size_t count,
+        uint32_t timingsFrameId, uint32_t frameId) noexcept {
+    auto& state = mPostProcessingBudget;
+    if (!state.budget || !count || timingsFrameId == state.lastTimingsFrameId ||
+            timingsFrameId < state.settleFrameId) {
+        return;
+    }
+    state.lastTimingsFrameId = timingsFrameId;
+
+    // the passes of the effects the budget controls
+    constexpr std::string_view prefixes[] = {
+            "SSR", "DoF", "SSAO", "Separable Blur", "Bloom", "Flare" };
+    uint64_t duration = 0;
+    for (size_t i = 0; i < count; i++) {
+        std::string_view const name{ timings[i].name };
+        for (auto const prefix : prefixes) {
+            if (name.substr(0, prefix.size()) == prefix) {
+                duration += timings[i].duration;
+                break;
+            }
+        }
+    }
+    float const cost = float(duration) * 1e-6f;
+
+    if (state.measureSavings) {
+        // first measurement since the last reduction
+        state.savings[state.level - 1] = std::max(0.0f, state.costBeforeReduction - cost);
+        state.measureSavings = false;
+    }
+
+    constexpr size_t REDUCTION_COUNT = PostProcessingBudget::REDUCTION_COUNT;
+    if (cost > state.budget) {
+        if (state.level < REDUCTION_COUNT) {
+            state.costBeforeReduction = cost;
+            state.level++;
+            state.settleFrameId = frameId;
+            state.measureSavings = true;
+        }
+    } else if (state.level && cost + state.savings[state.level - 1] < 0.8f * state.budget) {
+        // we can afford to undo the last reduction with some margin, so we don't oscillate
+        state.level--;
+        state.settleFrameId = frameId;
+    }
+}
+
+void FView::applyPostProcessingBudget(ScreenSpaceReflectionsOptions& ssrOptions,
+        DepthOfFieldOptions& dofOptions, AmbientOcclusionOptions& aoOptions,
+        BloomOptions& bloomOptions) const noexcept {
+    uint8_t const level = mPostProcessingBudget.budget ? mPostProcessingBudget.level : 0;
+    if (level >= 1) {
+        ssrOptions.enabled = false;
+    }
+    if (level >= 2) {
+        // 0 selects the default ring count, which is higher on desktop
+        auto fewerRings = [](uint8_t count) {
+            return count ? std::min(count, uint8_t(3)) : uint8_t(3);
+        };
+        dofOptions.foregroundRingCount = fewerRings(dofOptions.foregroundRingCount);
+        dofOptions.backgroundRingCount = fewerRings(dofOptions.backgroundRingCount);
+        dofOptions.fastGatherRingCount = fewerRings(dofOptions.fastGatherRingCount);
+    }
+    if (level >= 3) {
+        aoOptions.resolution = 0.5f;
+    }
+    if (level >= 4) {
+        bloomOptions.levels = std::max(uint8_t(3), uint8_t(bloomOptions.levels - 2));
+    }
+}
+
 void FView::setBloomOptions(BloomOptions options) noexcept {
     options.dirtStrength = math::saturate(options.dirtStrength);
     options.resolution = math::clamp(options.resolution, 2u, 2048u);
@@ -1170,6 +1463,14 @@ View::PickingQuery& FView::pick(uint32_t x, uint32_t y, backend::CallbackHandler
     return *pQuery;
 }
 
+void FView::pick(uint2 const* points, size_t count, backend::CallbackHandler* handler,
+        View::PickingQueriesResultCallback callback, void* user) noexcept {
+    FILAMENT_CHECK_PRECONDITION(count > 0) << "a picking batch needs at least one point";
+    FPickingBatch* const pBatch = new FPickingBatch(points, count, handler, callback, user);
+    pBatch->next = mActivePickingBatchesList;
+    mActivePickingBatchesList = pBatch;
+}
+
 void FView::setStereoscopicOptions(const StereoscopicOptions& options) noexcept {
     mStereoscopicOptions = options;
 }
@@ -27,8 +27,10 @@
 #include "FrameHistory.h"
 #include "FrameInfo.h"
 #include "Froxelizer.h"
+#include "OcclusionCuller.h"
 #include "PerViewUniforms.h"
 #include "PIDController.h"
+#include "RenderPass.h"
 #include "ShadowMap.h"
 #include "ShadowMapManager.h"
 #include "TypedUniformBuffer.h"
@@ -54,7 +56,9 @@
 #include <math/mat4.h>
 
 #include <array>
+#include <limits>
 #include <memory>
+#include <vector>
 
 namespace utils {
 class JobSystem;
@@ -118,6 +122,49 @@ public:
     void setFrustumCullingEnabled(bool culling) noexcept { mCulling = culling; }
     bool isFrustumCullingEnabled() const noexcept { return mCulling; }
 
+    void setOcclusionCullingEnabled(bool enabled) noexcept { mOcclusionCulling = enabled; }
+    bool isOcclusionCullingEnabled() const noexcept { return mOcclusionCulling; }
+
+    // whether occlusion culling is enabled and supported for this frame
+    bool hasOcclusionCulling() const noexcept { return mOcclusionCulling && !hasStereo(); }
+
+    void setLightDepthBoundsEnabled(bool enabled) noexcept { mLightDepthBounds = enabled; }
+    bool isLightDepthBoundsEnabled() const noexcept { return mLightDepthBounds; }
+
+    // whether the lights are restricted to the depth bounds for this frame
+    bool hasLightDepthBounds() const noexcept { return mLightDepthBounds && !hasStereo(); }
+
+    // whether the depth of the structure pass is read back for the next frames
+    bool needsDepthReadback() const noexcept {
+        return hasOcclusionCulling() || hasLightDepthBounds();
+    }
+
+    void setShadowCachingEnabled(bool enabled) noexcept { mShadowCaching = enabled; }
+    bool isShadowCachingEnabled() const noexcept { return mShadowCaching; }
+
+    void setAdaptiveShadowResolutionEnabled(bool enabled) noexcept {
+        mAdaptiveShadowResolution = enabled;
+    }
+    bool isAdaptiveShadowResolutionEnabled() const noexcept { return mAdaptiveShadowResolution; }
+
+    void setTemporalAmbientOcclusionEnabled(bool enabled) noexcept {
+        mTemporalAmbientOcclusion = enabled;
+    }
+    bool isTemporalAmbientOcclusionEnabled() const noexcept { return mTemporalAmbientOcclusion; }
+
+    void setPostProcessingBudget(float milliseconds) noexcept;
+    float getPostProcessingBudget() const noexcept { return mPostProcessingBudget.budget; }
+
+    // Updates the quality reductions of the post-processing budget from the GPU timings of a
+    // frame. frameId is the id of the frame being rendered.
+    void updatePostProcessingBudget(Renderer::GpuPassTiming const* timings, size_t count,
+            uint32_t timingsFrameId, uint32_t frameId) noexcept;
+
+    // Applies the quality reductions of the post-processing budget to these options
+    void applyPostProcessingBudget(ScreenSpaceReflectionsOptions& ssrOptions,
+            DepthOfFieldOptions& dofOptions, AmbientOcclusionOptions& aoOptions,
+            BloomOptions& bloomOptions) const noexcept;
+
     void setFrontFaceWindingInverted(bool inverted) noexcept { mFrontFaceWindingInverted = inverted; }
     bool isFrontFaceWindingInverted() const noexcept { return mFrontFaceWindingInverted; }
 
@@ -172,7 +219,9 @@ public:
     bool hasVSM() const noexcept { return mShadowType == ShadowType::VSM; }
     bool hasDPCF() const noexcept { return mShadowType == ShadowType::DPCF; }
     bool hasPCSS() const noexcept { return mShadowType == ShadowType::PCSS; }
-    bool hasPicking() const noexcept { return mActivePickingQueriesList != nullptr; }
+    bool hasPicking() const noexcept {
+        return mActivePickingQueriesList != nullptr || mActivePickingBatchesList != nullptr;
+    }
     bool hasStereo() const noexcept {
         return mIsStereoSupported && mStereoscopicOptions.enabled;
     }
@@ -377,6 +426,12 @@ public:
         return mVisibleRenderables;
     }
 
+    // distances to the camera of the nearest and farthest visible renderables, only computed
+    // when depth-of-field is enabled
+    math::float2 getVisibleDistanceRange() const noexcept {
+        return mVisibleDistanceRange;
+    }
+
     Range const& getVisibleDirectionalShadowCasters() const noexcept {
         return mVisibleDirectionalShadowCasters;
     }
@@ -406,8 +461,15 @@ public:
         }
     }
 
+    // Culls all the renderables, using the scene's culling hierarchy if one is given.
     static void cullRenderables(utils::JobSystem& js, FScene::RenderableSoa& renderableData,
-            Frustum const& frustum, size_t bit) noexcept;
+            Frustum const& frustum, size_t bit,
+            CullingHierarchy const* hierarchy = nullptr) noexcept;
+
+    // Culls the renderables in the given range only. Like Culler::intersects(), this can write
+    // the visibility of up to Culler::MODULO - 1 renderables past the end of the range.
+    static void cullRenderables(utils::JobSystem& js, FScene::RenderableSoa& renderableData,
+            Frustum const& frustum, size_t bit, utils::Range<uint32_t> range) noexcept;
 
     PerViewUniforms const& getPerViewUniforms() const noexcept { return mPerViewUniforms; }
     PerViewUniforms& getPerViewUniforms() noexcept { return mPerViewUniforms; }
@@ -426,9 +488,25 @@ public:
     View::PickingQuery& pick(uint32_t x, uint32_t y, backend::CallbackHandler* handler,
             View::PickingQueryResultCallback callback) noexcept;
 
+    // create a batch of picking queries
+    void pick(math::uint2 const* points, size_t count, backend::CallbackHandler* handler,
+            View::PickingQueriesResultCallback callback, void* user) noexcept;
+
     void executePickingQueries(backend::DriverApi& driver,
             backend::RenderTargetHandle handle, math::float2 scale) noexcept;
 
+    // caches used to sort the commands of the color and structure passes of this view
+    RenderPass::SortCache* getColorPassSortCache() noexcept { return &mColorPassSortCache; }
+    RenderPass::SortCache* getStructurePassSortCache() noexcept {
+        return &mStructurePassSortCache;
+    }
+
+    // reads back the depth of the picking buffer for occlusion culling and light depth bounds
+    void readbackOcclusionDepth(backend::DriverApi& driver,
+            backend::RenderTargetHandle handle, uint32_t width, uint32_t height) noexcept {
+        mOcclusionCuller.readback(driver, handle, width, height, mClipFromUserWorld);
+    }
+
     void setMaterialGlobal(uint32_t index, math::float4 const& value);
 
     math::float4 getMaterialGlobal(uint32_t index) const;
@@ -468,6 +546,29 @@ private:
         PickingQueryResult result;
     };
 
+    struct FPickingBatch {
+        FPickingBatch(math::uint2 const* points, size_t count,
+                backend::CallbackHandler* handler,
+                View::PickingQueriesResultCallback callback, void* user)
+                : points(points, points + count), results(count),
+                  handler(handler), callback(callback), user(user) {}
+        // decodes the read back rectangle into the results
+        void resolve() noexcept;
+        FPickingBatch* next = nullptr;
+        // picking query parameters
+        std::vector<math::uint2> points;
+        std::vector<PickingQueryResult> results;
+        backend::CallbackHandler* const handler;
+        View::PickingQueriesResultCallback const callback;
+        void* const user;
+        // the read back rectangle, in the picking buffer
+        std::unique_ptr<uint8_t[]> pixels;
+        math::uint2 origin{};
+        math::uint2 size{};
+        math::float2 scale{};
+        bool featureLevel0 = false;
+    };
+
     void prepareVisibleRenderables(utils::JobSystem& js,
             Frustum const& frustum, FScene::RenderableSoa& renderableData) const noexcept;
 
@@ -485,6 +586,9 @@ private:
             Culler::result_type* visibleMask,
             size_t count);
 
+    static math::float2 computeVisibleDistanceRange(math::mat4f const& viewMatrix,
+            FScene::RenderableSoa const& renderableData, Range visible) noexcept;
+
     // Clean-up the whole history, free all resources. This is typically called when the View is
     // being terminated.
     void drainFrameHistory(FEngine& engine) noexcept;
@@ -511,8 +615,25 @@ private:
 
     Viewport mViewport;
     bool mCulling = true;
+    bool mOcclusionCulling = false;
+    bool mLightDepthBounds = false;
+    bool mShadowCaching = false;
+    bool mAdaptiveShadowResolution = false;
+    bool mTemporalAmbientOcclusion = false;
     bool mFrontFaceWindingInverted = false;
 
+    struct PostProcessingBudget {
+        // SSR, DoF rings, SSAO resolution, bloom levels
+        static constexpr size_t REDUCTION_COUNT = 4;
+        float budget = 0.0f;                    // in ms, 0 when disabled
+        float costBeforeReduction = 0.0f;       // in ms, cost measured before the last reduction
+        std::array<float, REDUCTION_COUNT> savings{};   // in ms, last measured for each reduction
+        uint32_t settleFrameId = 0;             // timings of earlier frames predate the level
+        uint32_t lastTimingsFrameId = 0;
+        uint8_t level = 0;                      // number of reductions applied
+        bool measureSavings = false;
+    } mPostProcessingBudget;
+
     FRenderTarget* mRenderTarget = nullptr;
 
     uint8_t mVisibleLayers = 0x1;
@@ -553,6 +674,18 @@ private:
     mutable FrameHistory mFrameHistory{};
 
     FPickingQuery* mActivePickingQueriesList = nullptr;
+    FPickingBatch* mActivePickingBatchesList = nullptr;
+
+    RenderPass::SortCache mColorPassSortCache;
+    RenderPass::SortCache mStructurePassSortCache;
+
+    OcclusionCuller mOcclusionCuller;
+    // clip-from-user-world transform of the current frame's structure pass
+    math::mat4 mClipFromUserWorld;
+    // whether mOcclusionCuller has depth for the current frame
+    bool mHasReprojectedDepth = false;
+    // depth bounds of each froxel column, see Froxelizer::setDepthBounds()
+    std::vector<math::float2> mFroxelDepthBounds;
 
     utils::CString mName;
 
@@ -560,7 +693,10 @@ private:
     Range mVisibleRenderables;
     Range mVisibleDirectionalShadowCasters;
     Range mSpotLightShadowCasters;
+    math::float2 mVisibleDistanceRange{ 0.0f, std::numeric_limits<float>::infinity() };
     uint32_t mRenderableUBOSize = 0;
+    // what mRenderableUbh currently holds, which lets FScene::updateUBOs() upload only changes
+    std::vector<PerRenderableData> mRenderableUboContents;
     mutable bool mHasDirectionalLight = false;
     mutable bool mHasDynamicLighting = false;
     mutable bool mHasShadowing = false;
@@ -16,9 +16,14 @@
 
 #include "fg/details/DependencyGraph.h"
 
+#include <utils/compiler.h>
 #include <utils/Systrace.h>
 
+#include <algorithm>
 #include <iterator>
+#include <vector>
+
+#include <stdint.h>
 
 namespace filament {
 
@@ -44,6 +49,7 @@ void DependencyGraph::registerNode(Node* node, NodeID id) noexcept {
         nodes.reserve(nodes.capacity() * 2);
     }
     nodes.push_back(node);
+    mAdjacencyDirty = true;
 }
 
 bool DependencyGraph::isEdgeValid(DependencyGraph::Edge const* edge) const noexcept {
@@ -60,6 +66,7 @@ void DependencyGraph::link(DependencyGraph::Edge* edge) noexcept {
         edges.reserve(edges.capacity() * 2);
     }
     edges.push_back(edge);
+    mAdjacencyDirty = true;
 }
 
 DependencyGraph::EdgeContainer const& DependencyGraph::getEdges() const noexcept {
@@ -71,26 +78,52 @@ DependencyGraph::NodeContainer const& DependencyGraph::getNodes() const noexcept
     return mNodes;
 }
 
-DependencyGraph::EdgeContainer DependencyGraph::getIncomingEdges(
+// Buckets the edges by the given end with a counting sort, which keeps their order of creation.
+static void sortEdges(DependencyGraph::EdgeContainer const& edges, size_t nodeCount,
+        DependencyGraph::NodeID const DependencyGraph::Edge::* end,
+        std::vector<DependencyGraph::Edge*>& sorted, std::vector<uint32_t>& offsets) noexcept {
+    offsets.assign(nodeCount + 1, 0);
+    for (DependencyGraph::Edge const* const edge : edges) {
+        offsets[edge->*end]++;
+    }
+    uint32_t sum = 0;
+    for (uint32_t& offset : offsets) {
+        uint32_t const count = offset;
+        offset = sum;
+        sum += count;
+    }
+    sorted.resize(edges.size());
+    for (DependencyGraph::Edge* const edge : edges) {
+        sorted[offsets[edge->*end]++] = edge;
+    }
+    // each offset now points to the end of its node's edges, i.e. the start of the next node's
+    std::copy_backward(offsets.begin(), offsets.end() - 1, offsets.end());
+    offsets[0] = 0;
+}
+
+void DependencyGraph::updateAdjacency() const noexcept {
+    if (UTILS_LIKELY(!mAdjacencyDirty)) {
+        return;
+    }
+    sortEdges(mEdges, mNodes.size(), &Edge::to, mIncomingEdges, mIncomingOffsets);
+    sortEdges(mEdges, mNodes.size(), &Edge::from, mOutgoingEdges, mOutgoingOffsets);
+    mAdjacencyDirty = false;
+}
+
+DependencyGraph::EdgeSlice DependencyGraph::getIncomingEdges(
         DependencyGraph::Node const* node) const noexcept {
-    // TODO: we might need something more efficient
-    auto result = EdgeContainer::with_capacity(mEdges.size());
+    updateAdjacency();
     NodeID const nodeId = node->getId();
-    std::copy_if(mEdges.begin(), mEdges.end(),
-            std::back_insert_iterator<EdgeContainer>(result),
-            [nodeId](auto edge) { return edge->to == nodeId; });
-    return result;
+    return { mIncomingEdges.data() + mIncomingOffsets[nodeId],
+             mIncomingEdges.data() + mIncomingOffsets[nodeId + 1] };
 }
 
-DependencyGraph::EdgeContainer DependencyGraph::getOutgoingEdges(
+DependencyGraph::EdgeSlice DependencyGraph::getOutgoingEdges(
         DependencyGraph::Node const* node) const noexcept {
-    // TODO: we might need something more efficient
-    auto result = EdgeContainer::with_capacity(mEdges.size());
+    updateAdjacency();
     NodeID const nodeId = node->getId();
-    std::copy_if(mEdges.begin(), mEdges.end(),
-            std::back_insert_iterator<EdgeContainer>(result),
-            [nodeId](auto edge) { return edge->from == nodeId; });
-    return result;
+    return { mOutgoingEdges.data() + mOutgoingOffsets[nodeId],
+             mOutgoingEdges.data() + mOutgoingOffsets[nodeId + 1] };
 }
 
 DependencyGraph::Node const* DependencyGraph::getNode(DependencyGraph::NodeID id) const noexcept {
@@ -124,7 +157,7 @@ void DependencyGraph::cull() noexcept {
     while (!stack.empty()) {
         Node* const pNode = stack.back();
         stack.pop_back();
-        EdgeContainer const& incoming = getIncomingEdges(pNode);
+        EdgeSlice const incoming = getIncomingEdges(pNode);
         for (Edge* edge : incoming) {
             Node* pLinkedNode = getNode(edge->from);
             if (--pLinkedNode->mRefCount == 0) {
@@ -137,6 +170,7 @@ void DependencyGraph::cull() noexcept {
 void DependencyGraph::clear() noexcept {
     mEdges.clear();
     mNodes.clear();
+    mAdjacencyDirty = true;
 }
 
 void DependencyGraph::export_graphviz(utils::io::ostream& out, char const* name) {
@@ -159,7 +193,8 @@ void DependencyGraph::export_graphviz(utils::io::ostream& out, char const* name)
     for (Node const* node : nodes) {
         uint32_t id = node->getId();
 
-        auto edges = getOutgoingEdges(node);
+        EdgeSlice const outgoing = getOutgoingEdges(node);
+        std::vector<Edge*> edges(outgoing.begin(), outgoing.end());
         auto first = edges.begin();
         auto pos = std::partition(first, edges.end(),
                 [this](auto const& edge) { return isEdgeValid(edge); });
@@ -189,10 +189,20 @@ FrameGraph& FrameGraph::compile() noexcept {
         pNode->resolveResourceUsage(dependencyGraph);
     }
 
+    /*
+     * Mark the attachments that don't need backing memory
+     */
+    first = mPassNodes.begin();
+    while (first != activePassNodesEnd) {
+        PassNode* const passNode = *first;
+        first++;
+        passNode->resolveTransientAttachments();
+    }
+
     return *this;
 }
 
-void FrameGraph::execute(backend::DriverApi& driver) noexcept {
+void FrameGraph::execute(backend::DriverApi& driver, PassListener* listener) noexcept {
 
     SYSTRACE_CALL();
 
@@ -220,8 +230,14 @@ void FrameGraph::execute(backend::DriverApi& driver) noexcept {
         }
 
         // call execute
+        if (listener) {
+            listener->onPassBegin(driver, node->getName());
+        }
         FrameGraphResources const resources(*this, *node);
         node->execute(resources, driver);
+        if (listener) {
+            listener->onPassEnd(driver);
+        }
 
         // destroy concrete resources
         for (VirtualResource* resource : node->destroy) {
@@ -48,6 +48,19 @@ class VirtualResource;
 class FrameGraph {
 public:
 
+    /**
+     * Notified around the execution of each pass, e.g. to time the passes on the GPU.
+     */
+    class PassListener {
+    public:
+        // called before a pass executes, name is the static string given to addPass()
+        virtual void onPassBegin(backend::DriverApi& driver, const char* name) noexcept = 0;
+        // called after the pass executed
+        virtual void onPassEnd(backend::DriverApi& driver) noexcept = 0;
+    protected:
+        virtual ~PassListener() noexcept = default;
+    };
+
     class Builder {
     public:
         Builder(Builder const&) = delete;
@@ -295,8 +308,9 @@ public:
      * Execute all referenced passes
      *
      * @param driver a reference to the backend to execute the commands
+     * @param listener an optional listener, notified around the execution of each pass
      */
-    void execute(backend::DriverApi& driver) noexcept;
+    void execute(backend::DriverApi& driver, PassListener* listener = nullptr) noexcept;
 
     /**
      * Forwards a resource to another one which gets replaced.
@@ -23,6 +23,7 @@
 
 #include <details/Texture.h>
 
+#include <algorithm>
 #include <string>
 
 using namespace filament::backend;
@@ -245,6 +246,52 @@ void RenderPassNode::resolve() noexcept {
     }
 }
 
+void RenderPassNode::resolveTransientAttachments() noexcept {
+    using namespace backend;
+
+    constexpr TextureUsage attachmentUsages = TextureUsage::COLOR_ATTACHMENT |
+            TextureUsage::DEPTH_ATTACHMENT | TextureUsage::STENCIL_ATTACHMENT;
+
+    auto isAttachedTo = [this](RenderPassData const& rt, VirtualResource const* pResource) {
+        for (auto const& handle : rt.descriptor.attachments.array) {
+            if (handle && mFrameGraph.getResource(handle) == pResource) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // An attachment that is neither loaded nor stored, and that is only used by a single render
+    // target of this pass, never needs to leave the tile memory of a tiled GPU.
+    for (auto const& rt : mRenderTargetData) {
+        if (rt.imported) {
+            continue;
+        }
+        TargetBufferFlags const discarded =
+                rt.backend.params.flags.discardStart & rt.backend.params.flags.discardEnd;
+        for (size_t i = 0; i < RenderPassData::ATTACHMENT_COUNT; i++) {
+            FrameGraphId<FrameGraphTexture> const handle = rt.descriptor.attachments.array[i];
+            if (!handle || none(discarded & getTargetBufferFlagsAt(i))) {
+                continue;
+            }
+            VirtualResource* const pResource = mFrameGraph.getResource(handle);
+            if (pResource->isImported() || pResource->isSubResource() ||
+                    pResource->first != this || pResource->last != this) {
+                continue;
+            }
+            auto* const pTextureResource = static_cast<Resource<FrameGraphTexture>*>(pResource);
+            if (any(pTextureResource->usage & ~attachmentUsages)) {
+                continue;
+            }
+            auto const count = std::count_if(mRenderTargetData.begin(), mRenderTargetData.end(),
+                    [&](RenderPassData const& other) { return isAttachedTo(other, pResource); });
+            if (count == 1) {
+                pTextureResource->usage |= TextureUsage::TRANSIENT_ATTACHMENT;
+            }
+        }
+    }
+}
+
 void RenderPassNode::RenderPassData::devirtualize(FrameGraph& fg,
         ResourceAllocatorInterface& resourceAllocator) noexcept {
     assert_invariant(any(targetBufferFlags));
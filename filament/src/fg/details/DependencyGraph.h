@@ -20,6 +20,7 @@
 #include <utils/ostream.h>
 #include <utils/CString.h>
 #include <utils/FixedCapacityVector.h>
+#include <utils/Slice.h>
 #include <utils/debug.h>
 
 #include <vector>
@@ -129,6 +130,7 @@ public:
 
     using EdgeContainer = utils::FixedCapacityVector<Edge*, std::allocator<Edge*>, false>;
     using NodeContainer = utils::FixedCapacityVector<Node*, std::allocator<Node*>, false>;
+    using EdgeSlice = utils::Slice<Edge*>;
 
     /**
      * Removes all edges and nodes from the graph.
@@ -145,16 +147,18 @@ public:
     /**
      * Returns the list of incoming edges to a node
      * @param node the node to consider
-     * @return A list of incoming edges
+     * @return A list of incoming edges, in the order they were created. It stays valid until
+     *         the graph is modified.
      */
-    EdgeContainer getIncomingEdges(Node const* node) const noexcept;
+    EdgeSlice getIncomingEdges(Node const* node) const noexcept;
 
     /**
      * Returns the list of outgoing edges to a node
      * @param node the node to consider
-     * @return A list of outgoing edges
+     * @return A list of outgoing edges, in the order they were created. It stays valid until
+     *         the graph is modified.
      */
-    EdgeContainer getOutgoingEdges(Node const* node) const noexcept;
+    EdgeSlice getOutgoingEdges(Node const* node) const noexcept;
 
     Node const* getNode(NodeID id) const noexcept;
 
@@ -181,8 +185,17 @@ private:
     void registerNode(Node* node, NodeID id) noexcept;
     void link(Edge* edge) noexcept;
     static bool isAcyclicInternal(DependencyGraph& graph) noexcept;
+    void updateAdjacency() const noexcept;
     NodeContainer mNodes;
     EdgeContainer mEdges;
+
+    // Edges sorted by destination and by source node, and the offset of each node's edges.
+    // They're built on demand, so that querying the edges of all the nodes is linear.
+    mutable std::vector<Edge*> mIncomingEdges;
+    mutable std::vector<Edge*> mOutgoingEdges;
+    mutable std::vector<uint32_t> mIncomingOffsets;
+    mutable std::vector<uint32_t> mOutgoingOffsets;
+    mutable bool mAdjacencyDirty = true;
 };
 
 inline DependencyGraph::Edge::Edge(DependencyGraph& graph,
@@ -56,6 +56,8 @@ public:
 
     virtual void execute(FrameGraphResources const& resources, backend::DriverApi& driver) noexcept = 0;
     virtual void resolve() noexcept = 0;
+    // called once the first/last passes and the usage of all resources are known
+    virtual void resolveTransientAttachments() noexcept { }
     utils::CString graphvizifyEdgeColor() const noexcept override;
 
     Vector<VirtualResource*> devirtualize;         // resources we need to create before executing
@@ -98,6 +100,7 @@ private:
     utils::CString graphvizify() const noexcept override;
     void execute(FrameGraphResources const& resources, backend::DriverApi& driver) noexcept override;
     void resolve() noexcept override;
+    void resolveTransientAttachments() noexcept override;
 
     // constants
     const char* const mName = nullptr;
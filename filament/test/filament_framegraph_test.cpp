@@ -29,6 +29,9 @@
 
 #include "details/Texture.h"
 
+#include <string>
+#include <vector>
+
 using namespace filament;
 using namespace backend;
 
@@ -224,6 +227,39 @@ TEST_F(FrameGraphTest, ReadRead) {
     fg.execute(driverApi);
 }
 
+TEST_F(FrameGraphTest, PassListener) {
+    struct Listener : public FrameGraph::PassListener {
+        std::vector<std::string> events;
+        void onPassBegin(backend::DriverApi&, const char* name) noexcept override {
+            events.emplace_back(name);
+        }
+        void onPassEnd(backend::DriverApi&) noexcept override {
+            events.emplace_back("end");
+        }
+    } listener;
+
+    struct PassData {
+        FrameGraphId<FrameGraphTexture> output;
+    };
+    auto& culledPass = fg.addPass<PassData>("Culled", [&](FrameGraph::Builder& builder, auto& data) {
+                data.output = builder.create<FrameGraphTexture>("Culled buffer", {.width=16, .height=32});
+                data.output = builder.write(data.output);
+            },
+            [=](FrameGraphResources const&, auto const&, backend::DriverApi&) {
+            });
+    fg.addTrivialSideEffectPass("First", [](backend::DriverApi&) {});
+    fg.addTrivialSideEffectPass("Second", [](backend::DriverApi&) {});
+
+    fg.compile();
+
+    EXPECT_TRUE(fg.isCulled(culledPass));
+
+    fg.execute(driverApi, &listener);
+
+    std::vector<std::string> const expected{ "First", "end", "Second", "end" };
+    EXPECT_EQ(listener.events, expected);
+}
+
 TEST_F(FrameGraphTest, WriteWrite) {
     struct PassData {
         FrameGraphId<FrameGraphTexture> output1;
@@ -943,3 +979,88 @@ TEST_F(FrameGraphTest, WriteResourceReadAsAttachment) {
 
     fg.execute(driverApi);
 }
+
+TEST_F(FrameGraphTest, TransientAttachments) {
+
+    struct PassData {
+        FrameGraphId<FrameGraphTexture> color;
+        FrameGraphId<FrameGraphTexture> depth;
+        FrameGraphId<FrameGraphTexture> sharedColor;
+        FrameGraphId<FrameGraphTexture> sharedDepth;
+    };
+    auto& pass = fg.addPass<PassData>("Pass", [&](FrameGraph::Builder& builder, auto& data) {
+                data.color = builder.create<FrameGraphTexture>("Color buffer", {.width=16, .height=32});
+                data.depth = builder.create<FrameGraphTexture>("Depth buffer", {.width=16, .height=32});
+                data.color = builder.write(data.color, FrameGraphTexture::Usage::COLOR_ATTACHMENT);
+                data.depth = builder.write(data.depth, FrameGraphTexture::Usage::DEPTH_ATTACHMENT);
+                builder.declareRenderPass("Target", { .attachments = {
+                        .color = { data.color }, .depth = data.depth }});
+
+                // this depth buffer is used by two render targets of the pass
+                data.sharedColor = builder.create<FrameGraphTexture>("Shared color", {.width=16, .height=32});
+                data.sharedDepth = builder.create<FrameGraphTexture>("Shared depth", {.width=16, .height=32});
+                data.sharedColor = builder.write(data.sharedColor, FrameGraphTexture::Usage::COLOR_ATTACHMENT);
+                data.sharedDepth = builder.write(data.sharedDepth, FrameGraphTexture::Usage::DEPTH_ATTACHMENT);
+                builder.declareRenderPass("Shared target 0", { .attachments = {
+                        .color = { data.sharedColor }, .depth = data.sharedDepth }});
+                builder.declareRenderPass("Shared target 1", { .attachments = {
+                        .depth = data.sharedDepth }});
+            },
+            [=](FrameGraphResources const& resources, auto const& data, backend::DriverApi&) {
+                // the color buffer is presented, the depth buffer lives within the render pass
+                EXPECT_EQ(resources.getUsage(data.color), FrameGraphTexture::Usage::COLOR_ATTACHMENT);
+                EXPECT_EQ(resources.getUsage(data.depth), FrameGraphTexture::Usage::DEPTH_ATTACHMENT |
+                        FrameGraphTexture::Usage::TRANSIENT_ATTACHMENT);
+                EXPECT_EQ(resources.getUsage(data.sharedColor), FrameGraphTexture::Usage::COLOR_ATTACHMENT);
+                EXPECT_EQ(resources.getUsage(data.sharedDepth), FrameGraphTexture::Usage::DEPTH_ATTACHMENT);
+            });
+
+    fg.present(pass->color);
+    fg.present(pass->sharedColor);
+
+    EXPECT_TRUE(fg.isAcyclic());
+
+    fg.compile();
+
+    fg.execute(driverApi);
+}
+
+TEST_F(FrameGraphTest, ResourceAllocatorKeepsFrameOverBudget) {
+    Engine::Config config;
+    config.resourceAllocatorCacheSizeMB = 1;
+    ResourceAllocator allocator(config, driverApi);
+
+    // each texture is 4 MiB, so this frame alone exceeds the budget
+    auto frame = [&]() {
+        std::array<TextureHandle, 2> handles;
+        for (auto& h : handles) {
+            h = allocator.createTexture("color", SamplerType::SAMPLER_2D, 1,
+                    TextureFormat::RGBA8, 1, 1024, 1024, 1,
+                    { TextureSwizzle::CHANNEL_0, TextureSwizzle::CHANNEL_1,
+                      TextureSwizzle::CHANNEL_2, TextureSwizzle::CHANNEL_3 },
+                    TextureUsage::COLOR_ATTACHMENT);
+        }
+        for (auto h : handles) {
+            allocator.destroyTexture(h);
+        }
+        allocator.gc();
+        return handles;
+    };
+
+    auto const first = frame();
+    EXPECT_EQ(allocator.getCacheSize(), 8u << 20u);
+
+    // the same frame again reuses the cached textures instead of reallocating them
+    for (int i = 0; i < 4; i++) {
+        auto const handles = frame();
+        EXPECT_EQ(handles[0], first[0]);
+        EXPECT_EQ(handles[1], first[1]);
+        EXPECT_EQ(allocator.getCacheSize(), 8u << 20u);
+    }
+
+    // once they're not used by a frame, they're over budget and get evicted
+    allocator.gc();
+    EXPECT_EQ(allocator.getCacheSize(), 0u);
+
+    allocator.terminate();
+}
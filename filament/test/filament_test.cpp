@@ -16,34 +16,48 @@
 
 #include <iostream>
 #include <random>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 #include <math/vec3.h>
 #include <math/vec4.h>
 #include <math/mat3.h>
+#include <math/half.h>
 #include <math/mat4.h>
+#include <math/quat.h>
 #include <math/scalar.h>
 
 #include <filament/Box.h>
 #include <filament/Camera.h>
 #include <filament/Color.h>
+#include <filament/ColorGrading.h>
 #include <filament/Frustum.h>
 #include <filament/Material.h>
 #include <filament/Engine.h>
+#include <filament/IndexBuffer.h>
+#include <filament/Texture.h>
 
 #include <private/filament/BufferInterfaceBlock.h>
 #include <private/filament/UibStructs.h>
 #include <private/backend/BackendUtils.h>
 
 #include "Allocators.h"
+#include "CullingHierarchy.h"
 #include "details/Material.h"
 #include "details/Camera.h"
+#include "details/ColorGrading.h"
+#include "details/View.h"
 #include "Froxelizer.h"
+#include "FrameTimings.h"
+#include "HwProgramFactory.h"
+#include "OcclusionCuller.h"
 #include "details/Engine.h"
 #include "components/RenderableManager.h"
 #include "components/TransformManager.h"
+#include "details/SkinningBuffer.h"
 #include "UniformBuffer.h"
+#include "UniformBufferArena.h"
 
 using namespace filament;
 using namespace filament::math;
@@ -179,6 +193,38 @@ TEST(FilamentTest, SkinningMath) {
     }
 }
 
+TEST(FilamentTest, Bones) {
+    // the rigid bone path must produce the same data as the general one
+    std::default_random_engine generator(82828); // NOLINT
+    std::uniform_real_distribution<float> distribution(-4, 4);
+    std::uniform_real_distribution<float> dangle(-f::TAU, f::TAU);
+    auto rand_gen = std::bind(distribution, generator);
+
+    for (size_t i = 0; i < 100; ++i) {
+        const quatf q = quatf::fromAxisAngle(
+                normalize(float3{ rand_gen(), rand_gen(), rand_gen() }), dangle(generator));
+        const float3 t{ rand_gen(), rand_gen(), rand_gen() };
+        mat4f m(q);
+        m[3] = float4{ t, 1.0f };
+
+        const auto expected = FSkinningBuffer::makeBone(m);
+        const auto actual = FSkinningBuffer::makeBone(q, t);
+        for (size_t r = 0; r < 3; r++) {
+            for (size_t c = 0; c < 4; c++) {
+                EXPECT_NEAR(expected.transform[r][c], actual.transform[r][c], 1e-5f);
+            }
+        }
+        for (size_t c = 0; c < 4; c++) {
+            // the cofactors are stored as pairs of half-floats
+            for (uint32_t shift : { 0u, 16u }) {
+                const float e = makeHalf(uint16_t(expected.cof[c] >> shift));
+                const float a = makeHalf(uint16_t(actual.cof[c] >> shift));
+                EXPECT_NEAR(e, a, 2e-3f);
+            }
+        }
+    }
+}
+
 TEST(FilamentTest, TransformManagerSimple) {
     filament::FTransformManager tcm;
     EntityManager& em = EntityManager::get();
@@ -300,6 +346,134 @@ TEST(FilamentTest, TransformManager) {
     EXPECT_EQ(c, tcm.getChildCount(newParent));
 }
 
+TEST(FilamentTest, TransformManagerDirtySubtrees) {
+    filament::FTransformManager tcm;
+    EntityManager& em = EntityManager::get();
+    std::array<Entity, 4> entities;
+    em.create(entities.size(), entities.data());
+
+    // two independent hierarchies: 0 -> 1 and 2 -> 3
+    tcm.create(entities[0]);
+    tcm.create(entities[1], tcm.getInstance(entities[0]), mat4f{});
+    tcm.create(entities[2]);
+    tcm.create(entities[3], tcm.getInstance(entities[2]), mat4f{});
+    auto instance = [&](size_t i) { return tcm.getInstance(entities[i]); };
+
+    tcm.openLocalTransformTransaction();
+    tcm.setTransform(instance(0), mat4f{ float4{ 2 }});
+    tcm.setTransform(instance(3), mat4f{ float4{ 3 }});
+    tcm.commitLocalTransformTransaction();
+
+    EXPECT_EQ(tcm.getWorldTransform(instance(0)), mat4f{ float4{ 2 }});
+    EXPECT_EQ(tcm.getWorldTransform(instance(1)), mat4f{ float4{ 2 }});
+    EXPECT_EQ(tcm.getWorldTransform(instance(2)), mat4f{ float4{ 1 }});
+    EXPECT_EQ(tcm.getWorldTransform(instance(3)), mat4f{ float4{ 3 }});
+
+    // a child and its parent both changed
+    tcm.openLocalTransformTransaction();
+    tcm.setTransform(instance(1), mat4f{ float4{ 5 }});
+    tcm.setTransform(instance(0), mat4f{ float4{ 1 }});
+    tcm.commitLocalTransformTransaction();
+
+    EXPECT_EQ(tcm.getWorldTransform(instance(0)), mat4f{ float4{ 1 }});
+    EXPECT_EQ(tcm.getWorldTransform(instance(1)), mat4f{ float4{ 5 }});
+    EXPECT_EQ(tcm.getWorldTransform(instance(3)), mat4f{ float4{ 3 }});
+
+    // destroying a parent turns its children into dirty roots
+    tcm.openLocalTransformTransaction();
+    tcm.setTransform(instance(2), mat4f{ float4{ 7 }});
+    tcm.destroy(entities[2]);
+    tcm.commitLocalTransformTransaction();
+
+    EXPECT_EQ(tcm.getWorldTransform(instance(3)), mat4f{ float4{ 3 }});
+
+    tcm.destroy(entities[0]);
+    tcm.destroy(entities[1]);
+    tcm.destroy(entities[3]);
+    em.destroy(entities.size(), entities.data());
+}
+
+TEST(FilamentTest, TransformManagerBulkTransforms) {
+    filament::FTransformManager tcm;
+    EntityManager& em = EntityManager::get();
+    std::array<Entity, 3> entities;
+    em.create(entities.size(), entities.data());
+
+    // 0 -> 1 -> 2
+    tcm.create(entities[0]);
+    tcm.create(entities[1], tcm.getInstance(entities[0]), mat4f{});
+    tcm.create(entities[2], tcm.getInstance(entities[1]), mat4f{});
+    std::array<TransformManager::Instance, 3> instances;
+    for (size_t i = 0; i < entities.size(); i++) {
+        instances[i] = tcm.getInstance(entities[i]);
+    }
+
+    std::array<mat4f, 3> const locals = {
+            mat4f::translation(float3{ 1, 0, 0 }),
+            mat4f::scaling(float3{ 2 }),
+            mat4f::translation(float3{ 0, 1, 0 }) };
+    tcm.setTransforms(instances.data(), locals.data(), instances.size());
+    EXPECT_EQ(tcm.getTransform(instances[1]), locals[1]);
+    EXPECT_EQ(tcm.getWorldTransform(instances[2]), locals[0] * locals[1] * locals[2]);
+
+    std::array<float3, 3> const translations = {
+            float3{ 1, 2, 3 }, float3{ 0 }, float3{ 0, 0, 1 } };
+    std::array<quatf, 3> const rotations = {
+            quatf{ 1 }, quatf::fromAxisAngle(float3{ 0, 0, 1 }, f::PI_2), quatf{ 1 } };
+    std::array<float3, 3> const scales = {
+            float3{ 1 }, float3{ 1 }, float3{ 3 } };
+    tcm.openLocalTransformTransaction();
+    tcm.setTransforms(instances.data(), translations.data(), rotations.data(), scales.data(),
+            instances.size());
+    tcm.commitLocalTransformTransaction();
+    for (size_t i = 0; i < instances.size(); i++) {
+        mat4f const expected = mat4f::translation(translations[i]) * mat4f(rotations[i]) *
+                mat4f::scaling(scales[i]);
+        EXPECT_TRUE(all(lessThan(abs(tcm.getTransform(instances[i])[0] - expected[0]), float4{ 1e-6f })));
+        EXPECT_EQ(tcm.getTransform(instances[i])[3], expected[3]);
+    }
+    EXPECT_TRUE(all(lessThan(abs(tcm.getWorldTransform(instances[2])[3] - float4{ 1, 2, 4, 1 }),
+            float4{ 1e-6f })));
+
+    for (Entity e : entities) {
+        tcm.destroy(e);
+    }
+    em.destroy(entities.size(), entities.data());
+}
+
+TEST(FilamentTest, TransformManagerSnapshot) {
+    filament::FTransformManager tcm;
+    EntityManager& em = EntityManager::get();
+    std::array<Entity, 2> entities;
+    em.create(entities.size(), entities.data());
+    tcm.create(entities[0]);
+    tcm.create(entities[1], tcm.getInstance(entities[0]), mat4f{});
+    auto const child = tcm.getInstance(entities[1]);
+
+    // without a snapshot, the current transforms are used
+    tcm.setTransform(tcm.getInstance(entities[0]), mat4f{ float4{ 2 }});
+    EXPECT_EQ(tcm.getPublishedWorldTransformAccurate(child), mat4{ double4{ 2 }});
+
+    tcm.setSnapshotEnabled(true);
+    tcm.setTransform(tcm.getInstance(entities[0]), mat4f{ float4{ 3 }});
+    EXPECT_EQ(tcm.getWorldTransform(child), mat4f{ float4{ 3 }});
+    EXPECT_EQ(tcm.getPublishedWorldTransformAccurate(child), mat4{ double4{ 2 }});
+
+    tcm.publishSnapshot();
+    EXPECT_EQ(tcm.getPublishedWorldTransformAccurate(child), mat4{ double4{ 3 }});
+    EXPECT_EQ(tcm.getPublishedTransform(child), mat4f{});
+
+    // destroying a component invalidates the snapshot
+    tcm.setTransform(tcm.getInstance(entities[0]), mat4f{ float4{ 4 }});
+    tcm.destroy(entities[0]);
+    EXPECT_EQ(tcm.getPublishedWorldTransformAccurate(tcm.getInstance(entities[1])),
+            mat4{ double4{ 4 }});
+
+    tcm.setSnapshotEnabled(false);
+    tcm.destroy(entities[1]);
+    em.destroy(entities.size(), entities.data());
+}
+
 TEST(FilamentTest, UniformInterfaceBlock) {
 
     BufferInterfaceBlock::Builder b;
@@ -532,6 +706,47 @@ TEST(FilamentTest, UniformBufferSize2) {
     buffer.invalidate();
 }
 
+TEST(FilamentTest, UniformBufferArena) {
+    constexpr uint32_t A = UniformBufferArena::ALIGNMENT;
+    UniformBufferArena arena;
+    EXPECT_EQ(arena.getCapacity(), 0);
+
+    // allocations are aligned and packed
+    auto a = arena.allocate(16);
+    auto b = arena.allocate(A + 1);
+    auto c = arena.allocate(A);
+    EXPECT_EQ(a.offset, 0);
+    EXPECT_EQ(a.size, A);
+    EXPECT_EQ(b.offset, A);
+    EXPECT_EQ(b.size, 2 * A);
+    EXPECT_EQ(c.offset, 3 * A);
+    size_t const capacity = arena.getCapacity();
+    EXPECT_GE(capacity, 4 * A);
+
+    // freed neighbours are merged and reused first
+    arena.free(a);
+    arena.free(b);
+    auto d = arena.allocate(3 * A);
+    EXPECT_EQ(d.offset, 0);
+
+    // the CPU copy of a range can be read back
+    uint32_t const value = 0x12345678;
+    arena.write(d, &value, sizeof(value));
+    EXPECT_EQ(*static_cast<uint32_t const*>(arena.data(d)), value);
+
+    // running out of space grows the arena
+    auto e = arena.allocate(uint32_t(capacity));
+    EXPECT_GE(e.offset, 4 * A);
+    EXPECT_GE(arena.getCapacity(), e.offset + e.size);
+
+    arena.free(c);
+    arena.free(d);
+    arena.free(e);
+    auto f = arena.allocate(uint32_t(arena.getCapacity()));
+    EXPECT_EQ(f.offset, 0);
+    arena.free(f);
+}
+
 TEST(FilamentTest, BoxCulling) {
     Frustum frustum(mat4f::frustum(-1, 1, -1, 1, 1, 100));
 
@@ -612,6 +827,148 @@ TEST(FilamentTest, SphereCulling) {
     EXPECT_TRUE(frustum.intersects({ 0, 200 }));
 }
 
+TEST(FilamentTest, CullingHierarchy) {
+    Frustum frustum(mat4f::frustum(-1, 1, -1, 1, 1, 100));
+
+    constexpr size_t COUNT = 1000;
+    size_t const capacity = Culler::round(COUNT);
+    std::default_random_engine generator(82828);
+    std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+    std::uniform_real_distribution<float> size(0.1f, 5.0f);
+
+    std::vector<CullingHierarchy::Instance> instances(COUNT);
+    std::vector<float3> centers(capacity);
+    std::vector<float3> extents(capacity);
+    auto move = [&](size_t i) {
+        centers[i] = { position(generator), position(generator), position(generator) - 50.0f };
+        extents[i] = { size(generator), size(generator), size(generator) };
+    };
+    for (size_t i = 0; i < COUNT; i++) {
+        instances[i] = CullingHierarchy::Instance(i + 1);
+        move(i);
+    }
+
+    // the hierarchy must agree with the brute force culler, and leave the other bits untouched
+    CullingHierarchy hierarchy;
+    auto check = [&](size_t count) {
+        hierarchy.update(instances.data(), centers.data(), extents.data(), count);
+        EXPECT_EQ(hierarchy.size(), count);
+        std::vector<Culler::result_type> expected(capacity, 0x5);
+        std::vector<Culler::result_type> actual(capacity, 0x5);
+        Culler::intersects(expected.data(), frustum, centers.data(), extents.data(), count, 1);
+        hierarchy.intersects(actual.data(), frustum, 1);
+        size_t visibleCount = 0;
+        for (size_t i = 0; i < count; i++) {
+            EXPECT_EQ(expected[i], actual[i]);
+            visibleCount += (actual[i] & 0x2) ? 1 : 0;
+        }
+        EXPECT_GT(visibleCount, 0);
+        EXPECT_LT(visibleCount, count);
+    };
+
+    check(COUNT);
+
+    // a few renderables move: the hierarchy is refit
+    for (size_t i = 0; i < COUNT; i += 100) {
+        move(i);
+    }
+    check(COUNT);
+
+    // all renderables move: the hierarchy is eventually rebuilt
+    for (size_t n = 0; n < 3; n++) {
+        for (size_t i = 0; i < COUNT; i++) {
+            move(i);
+        }
+        check(COUNT);
+    }
+
+    // the set of renderables changes
+    std::swap(instances[0], instances[1]);
+    std::swap(centers[0], centers[1]);
+    std::swap(extents[0], extents[1]);
+    check(COUNT);
+    check(COUNT - 1);
+}
+
+TEST(FilamentTest, OcclusionCuller) {
+    // a 10x10 wall at 10m in front of a camera with a 90 degrees field of view
+    mat4 const projection = mat4::perspective(90, 1, 0.1, 100);
+    float4 const wall = projection * double4{ 0, 0, -10, 1 };
+    constexpr uint32_t SIZE = 64;
+    std::vector<float> depth(SIZE * SIZE);
+    for (uint32_t y = 0; y < SIZE; y++) {
+        for (uint32_t x = 0; x < SIZE; x++) {
+            float2 const ndc = (float2{ x, y } + 0.5f) * (2.0f / SIZE) - 1.0f;
+            bool const hit = std::abs(ndc.x * 10.0f) <= 5.0f && std::abs(ndc.y * 10.0f) <= 5.0f;
+            depth[y * SIZE + x] = hit ? wall.z / wall.w : 1.0f;
+        }
+    }
+
+    OcclusionCuller culler;
+    EXPECT_FALSE(culler.prepare(projection, mat4f{ projection }));
+    culler.setDepth(depth.data(), SIZE, SIZE, projection);
+    EXPECT_TRUE(culler.prepare(projection, mat4f{ projection }));
+
+    EXPECT_TRUE(culler.isOccluded({ 0, 0, -20 }, 1));       // behind the wall
+    EXPECT_TRUE(culler.isOccluded({ 3, -3, -50 }, 2));      // behind the wall
+    EXPECT_FALSE(culler.isOccluded({ 0, 0, -5 }, 1));       // in front of the wall
+    EXPECT_FALSE(culler.isOccluded({ 0, 0, -10 }, 1));      // crosses the wall
+    EXPECT_FALSE(culler.isOccluded({ 15, 0, -20 }, 1));     // next to the wall
+    EXPECT_FALSE(culler.isOccluded({ 0, 0, 0 }, 1));        // contains the camera
+    EXPECT_TRUE(culler.isOccluded({ 13, 0, -30 }, 1));      // behind the edge of the wall
+
+    // the depth is reprojected when the camera moves to the right
+    mat4 const moved = projection * inverse(mat4::translation(double3{ 2, 0, 0 }));
+    EXPECT_TRUE(culler.prepare(moved, mat4f{ moved }));
+    EXPECT_TRUE(culler.isOccluded({ 0, 0, -20 }, 1));
+    EXPECT_FALSE(culler.isOccluded({ 0, 0, -5 }, 1));
+    EXPECT_FALSE(culler.isOccluded({ 13, 0, -30 }, 1));     // now next to the wall
+
+    // only the requested bit of the renderables that are occluded is cleared
+    float3 const centers[] = { { 0, 0, -20 }, { 0, 0, -5 }, { 0, 0, -30 } };
+    float3 const extents[] = { 1, 1, 1 };
+    Culler::result_type results[] = { 0x3, 0x3, 0x2 };
+    culler.intersects(results, centers, extents, 3, 0);
+    EXPECT_EQ(results[0], 0x2);
+    EXPECT_EQ(results[1], 0x3);
+    EXPECT_EQ(results[2], 0x2);
+}
+
+TEST(FilamentTest, OcclusionCullerDepthBounds) {
+    // a 10x10 wall at 10m in front of a camera with a 90 degrees field of view, which covers
+    // the 2x2 tiles at the center of a 4x4 grid
+    mat4 const projection = mat4::perspective(90, 1, 0.1, 100);
+    float4 const wall = projection * double4{ 0, 0, -10, 1 };
+    constexpr uint32_t SIZE = 64;
+    std::vector<float> depth(SIZE * SIZE);
+    for (uint32_t y = 0; y < SIZE; y++) {
+        for (uint32_t x = 0; x < SIZE; x++) {
+            float2 const ndc = (float2{ x, y } + 0.5f) * (2.0f / SIZE) - 1.0f;
+            bool const hit = std::abs(ndc.x * 10.0f) <= 5.0f && std::abs(ndc.y * 10.0f) <= 5.0f;
+            depth[y * SIZE + x] = hit ? wall.z / wall.w : 1.0f;
+        }
+    }
+
+    OcclusionCuller culler;
+    culler.setDepth(depth.data(), SIZE, SIZE, projection);
+    EXPECT_TRUE(culler.prepare(projection, mat4f{ projection }));
+
+    float2 bounds[16];
+    culler.getDepthBounds(bounds, 4, 4, 0.25f, mat4f{ inverse(projection) });
+    for (uint32_t y = 0; y < 4; y++) {
+        for (uint32_t x = 0; x < 4; x++) {
+            float2 const b = bounds[y * 4 + x];
+            if ((x == 1 || x == 2) && (y == 1 || y == 2)) {
+                EXPECT_NEAR(b.x, -10.0f, 0.01f);
+                EXPECT_NEAR(b.y, -10.0f, 0.01f);
+            } else {
+                // nothing but the far plane there
+                EXPECT_LT(b.x, b.y);
+            }
+        }
+    }
+}
+
 TEST(FilamentTest, ColorConversion) {
     // Linear to Gamma
     // 0.0 stays 0.0
@@ -659,8 +1016,8 @@ TEST(FilamentTest, FroxelData) {
 
     FEngine* engine = downcast(Engine::create());
 
-    LinearAllocatorArena arena("FRenderer: per-frame allocator", 3 * 1024 * 1024);
-    utils::ArenaScope<LinearAllocatorArena> scope(arena);
+    PerRenderPassArena arena("FRenderer: per-frame allocator", 3 * 1024 * 1024);
+    RootArenaScope scope(arena);
 
 
     // view-port size is chosen so that we fit exactly a integer # of froxels horizontally
@@ -758,6 +1115,218 @@ TEST(FilamentTest, FroxelData) {
     Engine::destroy((Engine **)&engine);
 }
 
+TEST(FilamentTest, CommandBufferStats) {
+    using namespace filament;
+
+    Engine* engine = Engine::create();
+
+    Engine::CommandBufferStats stats = engine->getCommandBufferStats();
+    EXPECT_EQ(stats.capacity, size_t(FILAMENT_COMMAND_BUFFER_SIZE_IN_MB) << 20u);
+    EXPECT_LT(stats.minCapacity, stats.capacity);
+
+    engine->flushAndWait();
+
+    Engine::CommandBufferStats const after = engine->getCommandBufferStats();
+    EXPECT_GT(after.highWatermark, 0);
+    EXPECT_LE(after.highWatermark, after.capacity);
+    EXPECT_GE(after.flushStallDuration, stats.flushStallDuration);
+    EXPECT_GE(after.waitForCommandsDuration, stats.waitForCommandsDuration);
+
+    Engine::destroy(&engine);
+}
+
+TEST(FilamentTest, VariantManifest) {
+    using namespace filament;
+
+    FEngine* engine = downcast(Engine::create());
+    EXPECT_FALSE(engine->isVariantRecordingEnabled());
+    size_t const emptySize = engine->getVariantManifest(nullptr, 0);
+
+    engine->setVariantRecordingEnabled(true);
+    engine->recordVariant(0x1234, Variant{ 3 });
+    engine->recordVariant(0x1234, Variant{ 7 });
+    engine->recordVariant(0x1234, Variant{ 3 });
+    engine->recordVariant(0x5678, Variant{ 1 });
+
+    size_t const size = engine->getVariantManifest(nullptr, 0);
+    EXPECT_EQ(size, emptySize + 2 * (sizeof(uint64_t) + sizeof(uint32_t)) + 3);
+    std::vector<uint8_t> manifest(size);
+    EXPECT_EQ(engine->getVariantManifest(manifest.data(), size - 1), size);
+    EXPECT_EQ(engine->getVariantManifest(manifest.data(), size), size);
+
+    VariantList const a = FEngine::getVariantManifestEntry(manifest.data(), size, 0x1234);
+    EXPECT_EQ(a.count(), 2);
+    EXPECT_TRUE(a.test(3));
+    EXPECT_TRUE(a.test(7));
+    VariantList const b = FEngine::getVariantManifestEntry(manifest.data(), size, 0x5678);
+    EXPECT_EQ(b.count(), 1);
+    EXPECT_TRUE(b.test(1));
+    EXPECT_EQ(FEngine::getVariantManifestEntry(manifest.data(), size, 42).count(), 0);
+
+    // truncated manifests are rejected
+    EXPECT_EQ(FEngine::getVariantManifestEntry(manifest.data(), size - 1, 0x1234).count(), 0);
+
+    Engine::destroy((Engine **)&engine);
+}
+
+TEST(FilamentTest, MemoryStats) {
+    using namespace filament;
+
+    Engine* engine = Engine::create();
+    Engine::MemoryStats const before = engine->getMemoryStats();
+
+    // 64x64 RGBA8 with a full mip chain, and a 4x4 cubemap without mips
+    Texture* texture = Texture::Builder().width(64).height(64).levels(7)
+            .format(Texture::InternalFormat::RGBA8).build(*engine);
+    Texture* cubemap = Texture::Builder().width(4).height(4)
+            .sampler(Texture::Sampler::SAMPLER_CUBEMAP)
+            .format(Texture::InternalFormat::R8).build(*engine);
+    IndexBuffer* indices = IndexBuffer::Builder().indexCount(30)
+            .bufferType(IndexBuffer::IndexType::USHORT).build(*engine);
+
+    Engine::MemoryStats const after = engine->getMemoryStats();
+    size_t const mips = 4 * (64 * 64 + 32 * 32 + 16 * 16 + 8 * 8 + 4 * 4 + 2 * 2 + 1);
+    EXPECT_EQ(after.textures - before.textures, mips + 6 * 4 * 4);
+    EXPECT_EQ(after.indexBuffers - before.indexBuffers, 60);
+    EXPECT_EQ(after.commandBuffer, before.commandBuffer);
+
+    engine->destroy(texture);
+    engine->destroy(cubemap);
+    engine->destroy(indices);
+    EXPECT_EQ(engine->getMemoryStats().textures, before.textures);
+    Engine::destroy(&engine);
+}
+
+TEST(FilamentTest, ColorGradingLutCache) {
+    using namespace filament;
+
+    Engine* engine = Engine::create();
+
+    FilmicToneMapper filmic;
+    FilmicToneMapper otherFilmic;
+    ACESToneMapper aces;
+
+    auto* a = downcast(ColorGrading::Builder().toneMapper(&filmic).contrast(1.2f).build(*engine));
+    auto* b = downcast(ColorGrading::Builder().toneMapper(&otherFilmic).contrast(1.2f).build(*engine));
+    auto* c = downcast(ColorGrading::Builder().toneMapper(&aces).contrast(1.2f).build(*engine));
+    auto* d = downcast(ColorGrading::Builder().toneMapper(&filmic).contrast(1.5f).build(*engine));
+
+    // identical parameters and tone mappers share their LUT
+    EXPECT_EQ(a->getHwHandle(), b->getHwHandle());
+    EXPECT_NE(a->getHwHandle(), c->getHwHandle());
+    EXPECT_NE(a->getHwHandle(), d->getHwHandle());
+
+    // the LUT is kept after all the color gradings using it are destroyed
+    backend::TextureHandle const lut = a->getHwHandle();
+    engine->destroy(a);
+    engine->destroy(b);
+    auto* e = downcast(ColorGrading::Builder().toneMapper(&filmic).contrast(1.2f).build(*engine));
+    EXPECT_EQ(e->getHwHandle(), lut);
+
+    engine->destroy(c);
+    engine->destroy(d);
+    engine->destroy(e);
+    Engine::destroy(&engine);
+}
+
+TEST(FilamentTest, PostProcessingBudget) {
+    using namespace filament;
+
+    Engine* engine = Engine::create();
+    FView* view = downcast(engine->createView());
+    view->setPostProcessingBudget(2.0f);
+
+    auto apply = [view]() {
+        ScreenSpaceReflectionsOptions ssr{ .enabled = true };
+        DepthOfFieldOptions dof{ .enabled = true };
+        AmbientOcclusionOptions ao{ .resolution = 1.0f, .enabled = true };
+        BloomOptions bloom{ .levels = 6, .enabled = true };
+        view->applyPostProcessingBudget(ssr, dof, ao, bloom);
+        return std::make_tuple(ssr.enabled, dof.backgroundRingCount, ao.resolution, bloom.levels);
+    };
+
+    // 3ms of SSR and SSAO, the unrelated color pass isn't counted
+    Renderer::GpuPassTiming timings[] = {
+            { "Color Pass", 10'000'000 }, { "SSR Pass", 2'000'000 }, { "SSAO Pass", 1'000'000 }};
+    EXPECT_EQ(apply(), std::make_tuple(true, 0, 1.0f, 6));
+    view->updatePostProcessingBudget(timings, 3, 1, 5);
+    EXPECT_EQ(apply(), std::make_tuple(false, 0, 1.0f, 6));
+
+    // timings of frames rendered before the reduction are ignored
+    view->updatePostProcessingBudget(timings, 3, 4, 6);
+    EXPECT_EQ(apply(), std::make_tuple(false, 0, 1.0f, 6));
+
+    // still over budget after disabling SSR: fewer DoF rings
+    timings[1].duration = 1'500'000;
+    timings[2].duration = 1'000'000;
+    view->updatePostProcessingBudget(timings, 3, 5, 7);
+    EXPECT_EQ(apply(), std::make_tuple(false, 3, 1.0f, 6));
+
+    // within budget, but undoing the last reduction would exceed it
+    timings[1].duration = 0;
+    view->updatePostProcessingBudget(timings, 3, 7, 8);
+    EXPECT_EQ(apply(), std::make_tuple(false, 3, 1.0f, 6));
+
+    // the scene got cheaper
+    timings[2].duration = 50'000;
+    view->updatePostProcessingBudget(timings, 3, 8, 9);
+    EXPECT_EQ(apply(), std::make_tuple(false, 0, 1.0f, 6));
+
+    view->setPostProcessingBudget(0.0f);
+    EXPECT_EQ(apply(), std::make_tuple(true, 0, 1.0f, 6));
+
+    engine->destroy(view);
+    Engine::destroy(&engine);
+}
+
+TEST(FilamentTest, ProgramContentHash) {
+    using namespace filament;
+    using namespace filament::backend;
+
+    auto makeProgram = [](const char* source, int32_t constant, const char* name) {
+        Program program;
+        program.shader(ShaderStage::VERTEX, source, strlen(source) + 1)
+               .shader(ShaderStage::FRAGMENT, source, strlen(source) + 1)
+               .specializationConstants({{ 0, constant }})
+               .diagnostics(utils::CString{ name },
+                       [](utils::io::ostream& out) -> utils::io::ostream& { return out; });
+        return program;
+    };
+
+    uint64_t const a = HwProgramFactory::hash(makeProgram("void main() {}", 1, "a"));
+    // the name doesn't take part in the program's identity
+    EXPECT_EQ(a, HwProgramFactory::hash(makeProgram("void main() {}", 1, "b")));
+    EXPECT_NE(a, HwProgramFactory::hash(makeProgram("void main() {}", 2, "a")));
+    EXPECT_NE(a, HwProgramFactory::hash(makeProgram("void main() { }", 1, "a")));
+}
+
+TEST(FilamentTest, FrameTimings) {
+    using namespace filament;
+    using Stage = FrameTimingsRecorder::Stage;
+
+    FrameTimingsRecorder recorder;
+    Renderer::FrameTimings timings[Renderer::FRAME_TIMINGS_HISTORY_SIZE + 1];
+    EXPECT_EQ(recorder.getHistory(timings, 4), 0);
+
+    for (uint32_t frame = 1; frame <= Renderer::FRAME_TIMINGS_HISTORY_SIZE + 2; frame++) {
+        recorder.beginFrame(frame);
+        // stages are accumulated
+        recorder.add(Stage::CULLING, std::chrono::microseconds(frame));
+        recorder.add(Stage::CULLING, std::chrono::microseconds(frame));
+        recorder.endFrame();
+    }
+
+    // the most recent frames come first, and only a fixed number of them is kept
+    size_t const count = recorder.getHistory(timings, std::size(timings));
+    EXPECT_EQ(count, Renderer::FRAME_TIMINGS_HISTORY_SIZE);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t const frame = Renderer::FRAME_TIMINGS_HISTORY_SIZE + 2 - i;
+        EXPECT_EQ(timings[i].frameId, frame);
+        EXPECT_EQ(timings[i].getDuration(Stage::CULLING), 2000u * frame);
+        EXPECT_EQ(timings[i].getDuration(Stage::SCENE_PREPARE), 0u);
+    }
+}
+
 TEST(FilamentTest, GoogleLineDirective) {
     {
         char s[512] = "#line 10 \"foobar\"";
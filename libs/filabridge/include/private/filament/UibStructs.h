@@ -221,7 +221,11 @@ struct PerRenderableData {
     // TODO: We need a better solution, this currently holds the average local scale for the renderable
     float userData;
 
-    math::float4 reserved[8];
+    // worldFromModelMatrix of the previous frame, used to compute per-pixel velocities.
+    // This is the current matrix when the renderable wasn't visible in the previous frame.
+    std140::mat44 previousWorldFromModelMatrix;
+
+    math::float4 reserved[4];
 
     static uint32_t packFlagsChannels(
             bool skinning, bool morphing, bool contactShadows, bool hasInstanceBuffer,
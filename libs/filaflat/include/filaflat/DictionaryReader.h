@@ -19,12 +19,35 @@
 
 #include <filaflat/ChunkContainer.h>
 
+#include <utils/FixedCapacityVector.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
 namespace filaflat {
 
 struct DictionaryReader {
+    // A blob of a binary dictionary as stored in the package, i.e. still compressed for SPIR-V.
+    // It points inside the container's data.
+    struct Blob {
+        const uint8_t* data;
+        size_t size;
+    };
+    using BlobIndex = utils::FixedCapacityVector<Blob>;
+
+    // Reads and decodes all the blobs of a dictionary.
     static bool unflatten(ChunkContainer const& container,
             ChunkContainer::Type dictionaryTag,
             BlobDictionary& dictionary);
+
+    // Locates the blobs of a binary dictionary (DictionarySpirv or DictionaryMetalLibrary)
+    // without decoding them, so that they can be decoded individually with decode().
+    static bool index(ChunkContainer const& container,
+            ChunkContainer::Type dictionaryTag,
+            BlobIndex& index);
+
+    // Decodes a blob found by index().
+    static bool decode(ChunkContainer::Type dictionaryTag, Blob blob, ShaderContent& content);
 };
 
 } // namespace filaflat
@@ -56,6 +56,11 @@ public:
 
     bool hasShader(ShaderModel model, Variant variant, ShaderStage stage) const noexcept;
 
+    // For binary materials (SPIR-V and Metal libraries), retrieves the index of the shader's blob
+    // in the dictionary without reading it, or returns false on failure.
+    bool getBlobIndex(ShaderModel model, Variant variant, ShaderStage stage,
+            uint32_t* index) const noexcept;
+
     // These methods are for debugging purposes only (matdbg)
     // @{
     static void decodeKey(uint32_t key,
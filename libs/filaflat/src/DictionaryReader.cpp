@@ -30,9 +30,9 @@ using namespace filamat;
 
 namespace filaflat {
 
-bool DictionaryReader::unflatten(ChunkContainer const& container,
+bool DictionaryReader::index(ChunkContainer const& container,
         ChunkContainer::Type dictionaryTag,
-        BlobDictionary& dictionary) {
+        BlobIndex& index) {
 
     auto [start, end] = container.getChunkRange(dictionaryTag);
     Unflattener unflattener(start, end);
@@ -44,60 +44,83 @@ bool DictionaryReader::unflatten(ChunkContainer const& container,
         }
         // For now, 1 is the only acceptable compression scheme.
         assert(compressionScheme == 1);
+    } else if (dictionaryTag != ChunkType::DictionaryMetalLibrary) {
+        return false;
+    }
+
+    uint32_t blobCount;
+    if (!unflattener.read(&blobCount)) {
+        return false;
+    }
 
-        uint32_t blobCount;
-        if (!unflattener.read(&blobCount)) {
+    index.reserve(blobCount);
+    for (uint32_t i = 0; i < blobCount; i++) {
+        unflattener.skipAlignmentPadding();
+
+        const char* data;
+        size_t dataSize;
+        if (!unflattener.read(&data, &dataSize)) {
             return false;
         }
 
-        dictionary.reserve(blobCount);
-        for (uint32_t i = 0; i < blobCount; i++) {
-            unflattener.skipAlignmentPadding();
+        assert_invariant((intptr_t(data) % 8) == 0);
 
-            const char* compressed;
-            size_t compressedSize;
-            if (!unflattener.read(&compressed, &compressedSize)) {
-                return false;
-            }
-
-            assert_invariant((intptr_t(compressed) % 8) == 0);
+        index.push_back({ reinterpret_cast<const uint8_t*>(data), dataSize });
+    }
+    return true;
+}
 
+bool DictionaryReader::decode(ChunkContainer::Type dictionaryTag, Blob blob,
+        ShaderContent& content) {
+    if (dictionaryTag == ChunkType::DictionarySpirv) {
 #if defined (FILAMENT_DRIVER_SUPPORTS_VULKAN)
-            size_t spirvSize = smolv::GetDecodedBufferSize(compressed, compressedSize);
-            if (spirvSize == 0) {
-                return false;
-            }
-            ShaderContent spirv(spirvSize);
-            if (!smolv::Decode(compressed, compressedSize, spirv.data(), spirvSize)) {
-                return false;
-            }
-            dictionary.emplace_back(std::move(spirv));
-#else
+        size_t const spirvSize = smolv::GetDecodedBufferSize(blob.data, blob.size);
+        if (spirvSize == 0) {
             return false;
-#endif
-
         }
-        return true;
-    } else if (dictionaryTag == ChunkType::DictionaryMetalLibrary) {
-        uint32_t blobCount;
-        if (!unflattener.read(&blobCount)) {
+        ShaderContent spirv(spirvSize);
+        if (!smolv::Decode(blob.data, blob.size, spirv.data(), spirvSize)) {
             return false;
         }
+        content = std::move(spirv);
+        return true;
+#else
+        return false;
+#endif
+    } else if (dictionaryTag == ChunkType::DictionaryMetalLibrary) {
+        ShaderContent data(blob.size);
+        memcpy(data.data(), blob.data, blob.size);
+        content = std::move(data);
+        return true;
+    }
+    return false;
+}
 
-        dictionary.reserve(blobCount);
-        for (uint32_t i = 0; i < blobCount; i++) {
-            unflattener.skipAlignmentPadding();
+bool DictionaryReader::unflatten(ChunkContainer const& container,
+        ChunkContainer::Type dictionaryTag,
+        BlobDictionary& dictionary) {
 
-            const char* data;
-            size_t dataSize;
-            if (!unflattener.read(&data, &dataSize)) {
+    if (dictionaryTag == ChunkType::DictionarySpirv ||
+            dictionaryTag == ChunkType::DictionaryMetalLibrary) {
+        BlobIndex blobs;
+        if (!index(container, dictionaryTag, blobs)) {
+            return false;
+        }
+        dictionary.reserve(blobs.size());
+        for (Blob const blob : blobs) {
+            ShaderContent content;
+            if (!decode(dictionaryTag, blob, content)) {
                 return false;
             }
-            dictionary.emplace_back(dataSize);
-            memcpy(dictionary.back().data(), data, dictionary.back().size());
+            dictionary.push_back(std::move(content));
         }
         return true;
-    } else if (dictionaryTag == ChunkType::DictionaryText) {
+    }
+
+    auto [start, end] = container.getChunkRange(dictionaryTag);
+    Unflattener unflattener(start, end);
+
+    if (dictionaryTag == ChunkType::DictionaryText) {
         uint32_t stringCount = 0;
         if (!unflattener.read(&stringCount)) {
             return false;
@@ -178,6 +178,23 @@ bool MaterialChunk::hasShader(ShaderModel model, Variant variant, ShaderStage st
     return pos != mOffsets.end();
 }
 
+bool MaterialChunk::getBlobIndex(ShaderModel model, Variant variant, ShaderStage stage,
+        uint32_t* index) const noexcept {
+    if (mBase == nullptr) {
+        return false;
+    }
+    if (mMaterialTag != filamat::ChunkType::MaterialSpirv &&
+            mMaterialTag != filamat::ChunkType::MaterialMetalLibrary) {
+        return false;
+    }
+    auto pos = mOffsets.find(makeKey(model, variant, stage));
+    if (pos == mOffsets.end()) {
+        return false;
+    }
+    *index = pos->second;
+    return true;
+}
+
 bool MaterialChunk::getShader(ShaderContent& shaderContent, BlobDictionary const& dictionary,
         ShaderModel shaderModel, filament::Variant variant, ShaderStage stage) {
     switch (mMaterialTag) {
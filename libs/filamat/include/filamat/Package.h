@@ -20,6 +20,7 @@
 #include <assert.h>
 #include <inttypes.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <cstddef>
 #include <functional>
@@ -563,9 +563,29 @@ bool GLSLPostProcessor::fullOptimization(const TShader& tShader,
             }
         }
 
+        if (!mGenerateDebugInfo) {
+            // let spirv-cross pick short names for everything that isn't linked by name
+            stripLocalNames(spirv);
+        }
+
         CompilerGLSL glslCompiler(std::move(spirv));
         glslCompiler.set_common_options(glslOptions);
 
+        if (!mGenerateDebugInfo) {
+            // Don't declare the uniform blocks, samplers and uniforms that the optimized shader
+            // doesn't use, the backend skips those it can't find. Stage inputs and outputs are
+            // all kept, so that the interface between the vertex and fragment shaders doesn't
+            // depend on what each of them uses.
+            auto enabled = glslCompiler.get_active_interface_variables();
+            ShaderResources const resources = glslCompiler.get_shader_resources();
+            for (auto const* list : { &resources.stage_inputs, &resources.stage_outputs }) {
+                for (auto const& resource : *list) {
+                    enabled.insert(VariableID(resource.id));
+                }
+            }
+            glslCompiler.set_enabled_interface_variables(std::move(enabled));
+        }
+
         if (!glslOptions.es) {
             // enable GL_ARB_shading_language_packing if available
             glslCompiler.add_header_line("#extension GL_ARB_shading_language_packing : enable");
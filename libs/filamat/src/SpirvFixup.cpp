@@ -16,8 +16,22 @@
 
 #include "SpirvFixup.h"
 
+#include <algorithm>
+#include <unordered_set>
+
 namespace filamat {
 
+namespace {
+// the few opcodes we need, from the SPIR-V specification
+constexpr uint32_t SPV_HEADER_SIZE = 5;
+constexpr uint32_t OP_NAME = 5;
+constexpr uint32_t OP_ENTRY_POINT = 15;
+constexpr uint32_t OP_FUNCTION = 54;
+constexpr uint32_t OP_FUNCTION_PARAMETER = 55;
+constexpr uint32_t OP_VARIABLE = 59;
+constexpr uint32_t STORAGE_CLASS_FUNCTION = 7;
+} // anonymous namespace
+
 bool fixupClipDistance(std::string& spirvDisassembly) {
     size_t p = spirvDisassembly.find("OpDecorate %filament_gl_ClipDistance Location");
     if (p == std::string::npos) {
@@ -32,4 +46,53 @@ bool fixupClipDistance(std::string& spirvDisassembly) {
     return true;
 }
 
+size_t stripLocalNames(std::vector<uint32_t>& spirv) {
+    if (spirv.size() < SPV_HEADER_SIZE) {
+        return 0;
+    }
+
+    // Names are declared before the functions, so first find the ids of everything local.
+    std::unordered_set<uint32_t> locals;
+    std::unordered_set<uint32_t> entryPoints;
+    for (size_t i = SPV_HEADER_SIZE; i < spirv.size();) {
+        uint32_t const opcode = spirv[i] & 0xFFFFu;
+        uint32_t const wordCount = spirv[i] >> 16u;
+        if (wordCount == 0 || i + wordCount > spirv.size()) {
+            return 0; // malformed module, leave it alone
+        }
+        switch (opcode) {
+            case OP_ENTRY_POINT:
+                entryPoints.insert(spirv[i + 2]);
+                break;
+            case OP_FUNCTION:
+            case OP_FUNCTION_PARAMETER:
+                locals.insert(spirv[i + 2]);
+                break;
+            case OP_VARIABLE:
+                if (spirv[i + 3] == STORAGE_CLASS_FUNCTION) {
+                    locals.insert(spirv[i + 2]);
+                }
+                break;
+        }
+        i += wordCount;
+    }
+
+    size_t removed = 0;
+    size_t out = SPV_HEADER_SIZE;
+    for (size_t i = SPV_HEADER_SIZE; i < spirv.size();) {
+        uint32_t const opcode = spirv[i] & 0xFFFFu;
+        uint32_t const wordCount = spirv[i] >> 16u;
+        if (opcode == OP_NAME && locals.count(spirv[i + 1]) &&
+                !entryPoints.count(spirv[i + 1])) {
+            removed++;
+        } else {
+            std::copy(spirv.begin() + i, spirv.begin() + i + wordCount, spirv.begin() + out);
+            out += wordCount;
+        }
+        i += wordCount;
+    }
+    spirv.resize(out);
+    return removed;
+}
+
 } // namespace filamat
@@ -18,6 +18,10 @@
 #define TNT_SPIRVFIXUP_H
 
 #include <string>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
 
 namespace filamat {
 
@@ -51,6 +55,19 @@ namespace filamat {
  */
 bool fixupClipDistance(std::string& spirvDisassembly);
 
+/**
+ * Removes the debug names (OpName) of functions, function parameters and function-scope
+ * variables from a SPIR-V module, except for the entry points. spirv-cross then gives them short
+ * generated names, which makes the GLSL it outputs smaller and faster to parse.
+ *
+ * Names of global variables, types and struct members are kept, since OpenGL matches interfaces
+ * and binds resources by name.
+ *
+ * @param spirv a SPIR-V module, will be modified
+ * @return the number of names that were removed
+ */
+size_t stripLocalNames(std::vector<uint32_t>& spirv);
+
 }
 
 #endif  // TNT_SPIRVFIXUP_H
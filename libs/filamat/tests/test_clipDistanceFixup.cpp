@@ -56,3 +56,40 @@ TEST(ClipDistanceFixup, NoNewline) {
     EXPECT_EQ(filamat::fixupClipDistance(disassembly), true);
     EXPECT_EQ(disassembly, expected);
 }
+
+// builds an instruction from its opcode and operands
+static void op(std::vector<uint32_t>& spirv, uint32_t opcode, std::vector<uint32_t> operands) {
+    spirv.push_back(uint32_t(operands.size() + 1) << 16u | opcode);
+    spirv.insert(spirv.end(), operands.begin(), operands.end());
+}
+
+TEST(StripLocalNames, KeepsGlobalNames) {
+    // literal strings are packed in words with their terminating nul, one-letter names fit in one
+    std::vector<uint32_t> spirv = { 0x07230203, 0x00010300, 0, 100, 0 };
+    op(spirv, 15, { 4, 10, 'm' | 'a' << 8 | 'i' << 16 | 'n' << 24, 0 });   // OpEntryPoint %10
+    op(spirv, 5, { 10, 'm' | 'a' << 8 | 'i' << 16 | 'n' << 24, 0 });       // OpName %10 "main"
+    op(spirv, 5, { 11, 'f' });                                             // OpName %11 "f"
+    op(spirv, 5, { 20, 'g' });                                             // OpName %20 "g"
+    op(spirv, 5, { 21, 'l' });                                             // OpName %21 "l"
+    op(spirv, 5, { 22, 'p' });                                             // OpName %22 "p"
+    op(spirv, 59, { 1, 20, 2 });      // %20 = OpVariable Uniform
+    op(spirv, 54, { 1, 10, 0, 2 });   // %10 = OpFunction
+    op(spirv, 56, {});                // OpFunctionEnd
+    op(spirv, 54, { 1, 11, 0, 2 });   // %11 = OpFunction
+    op(spirv, 55, { 1, 22 });         // %22 = OpFunctionParameter
+    op(spirv, 59, { 1, 21, 7 });      // %21 = OpVariable Function
+    op(spirv, 56, {});                // OpFunctionEnd
+
+    size_t const size = spirv.size();
+    EXPECT_EQ(filamat::stripLocalNames(spirv), 3);
+    EXPECT_EQ(spirv.size(), size - 3 * 3);
+
+    // only the names of the entry point and of the global variable are left
+    std::vector<uint32_t> names;
+    for (size_t i = 5; i < spirv.size(); i += spirv[i] >> 16u) {
+        if ((spirv[i] & 0xFFFFu) == 5) {
+            names.push_back(spirv[i + 1]);
+        }
+    }
+    EXPECT_EQ(names, std::vector<uint32_t>({ 10, 20 }));
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TNT_GEOMETRY_LEVELSOFDETAIL_H
+#define TNT_GEOMETRY_LEVELSOFDETAIL_H
+
+#include <math/vec3.h>
+
+#include <utils/compiler.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+namespace geometry {
+
+struct LevelsOfDetailBuilderImpl;
+struct LevelsOfDetailImpl;
+
+/**
+ * Generates a chain of simplified index buffers, or levels of detail, for a triangle mesh.
+ *
+ * Each level collapses edges of the previous one using a quadric error metric until its triangle
+ * count falls below the previous count times the reduction ratio, or until the error would exceed
+ * the maximum error. All levels share the vertices of the original mesh, so they can be drawn
+ * from the same VertexBuffer, with one IndexBuffer or one index range per level. Level 0 is the
+ * original mesh.
+ *
+ * The levels are meant to be given to RenderableManager::Builder::levelOfDetail(), with screen
+ * sizes that can be derived from getError().
+ */
+class UTILS_PUBLIC LevelsOfDetail {
+public:
+
+    /**
+     * The Builder is used to construct immutable levels of detail.
+     *
+     * Clients provide pointers into their own data, which is synchronously consumed during build().
+     * Positions and triangles are required.
+     */
+    class Builder {
+    public:
+        Builder() noexcept;
+        ~Builder() noexcept;
+        Builder(Builder&& that) noexcept;
+        Builder& operator=(Builder&& that) noexcept;
+
+        Builder& vertexCount(size_t vertexCount) noexcept;
+        Builder& positions(const filament::math::float3*, size_t stride = 0) noexcept;
+
+        Builder& triangleCount(size_t triangleCount) noexcept;
+        Builder& triangles(const filament::math::uint3*) noexcept;
+        Builder& triangles(const filament::math::ushort3*) noexcept;
+
+        /**
+         * Maximum number of levels, including the original mesh. Fewer levels are generated
+         * when the mesh cannot be simplified further. (default value: 4)
+         */
+        Builder& levelCount(size_t count) noexcept;
+
+        /**
+         * Target triangle count of a level relative to the previous one, within (0, 1).
+         * (default value: 0.5)
+         */
+        Builder& reduction(float ratio) noexcept;
+
+        /**
+         * Maximum error of a level relative to the extent of the mesh, within [0, 1].
+         * (default value: 0.05)
+         */
+        Builder& maxError(float error) noexcept;
+
+        /**
+         * Prevents the vertices on the border of the mesh from moving, which avoids cracks
+         * between meshes that are simplified separately. (default value: false)
+         */
+        Builder& lockBorder(bool enabled) noexcept;
+
+        /**
+         * Generates the levels of detail or returns null if the submitted data is incomplete.
+         */
+        LevelsOfDetail* build();
+
+    private:
+        LevelsOfDetailBuilderImpl* mImpl;
+        Builder(const Builder&) = delete;
+        Builder& operator=(const Builder&) = delete;
+    };
+
+    ~LevelsOfDetail() noexcept;
+    LevelsOfDetail(LevelsOfDetail&& that) noexcept;
+    LevelsOfDetail& operator=(LevelsOfDetail&& that) noexcept;
+
+    /**
+     * Returns the number of levels, which is at least 1.
+     */
+    size_t getLevelCount() const noexcept;
+
+    size_t getTriangleCount(size_t level) const noexcept;
+
+    /**
+     * Returns the error of a level relative to the extent of the mesh, 0 for level 0. A level
+     * is visually indistinguishable from the original mesh while this error, multiplied by the
+     * projected size of the mesh, is below a pixel.
+     */
+    float getError(size_t level) const noexcept;
+
+    /**
+     * Writes the triangles of a level, that is getTriangleCount(level) triangles.
+     * @{
+     */
+    void getTriangles(size_t level, filament::math::uint3* out) const noexcept;
+    void getTriangles(size_t level, filament::math::ushort3* out) const noexcept;
+    /**
+     * @}
+     */
+
+private:
+    LevelsOfDetail(LevelsOfDetailImpl*) noexcept;
+    LevelsOfDetail(const LevelsOfDetail&) = delete;
+    LevelsOfDetail& operator=(const LevelsOfDetail&) = delete;
+    LevelsOfDetailImpl* mImpl;
+    friend struct LevelsOfDetailBuilderImpl;
+};
+
+} // namespace geometry
+} // namespace filament
+
+#endif // TNT_GEOMETRY_LEVELSOFDETAIL_H
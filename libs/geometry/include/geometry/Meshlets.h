@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TNT_GEOMETRY_MESHLETS_H
+#define TNT_GEOMETRY_MESHLETS_H
+
+#include <math/vec3.h>
+
+#include <utils/compiler.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+namespace geometry {
+
+struct MeshletsBuilderImpl;
+struct MeshletsImpl;
+
+/**
+ * Partitions the triangles of a mesh into small clusters, or meshlets, and computes their bounds.
+ *
+ * Each meshlet references at most maxVertices vertices and maxTriangles triangles that are close
+ * to each other and face roughly the same direction, which makes them suitable for culling at a
+ * finer granularity than the whole mesh: the bounding sphere is used for frustum culling and the
+ * normal cone for back-face culling (see isBackFacing()).
+ *
+ * The meshlets can be consumed as-is by a mesh shader, or flattened into an index buffer with
+ * getIndices(), in which case each meshlet is a contiguous range of triangles that can be drawn
+ * (or skipped) on its own.
+ */
+class UTILS_PUBLIC Meshlets {
+public:
+
+    struct Meshlet {
+        uint32_t vertexOffset;      //!< offset of the first vertex in getVertices()
+        uint32_t triangleOffset;    //!< offset of the first triangle in getTriangles()
+        uint32_t vertexCount;
+        uint32_t triangleCount;
+    };
+
+    struct Bounds {
+        filament::math::float3 center;      //!< bounding sphere
+        float radius;
+        filament::math::float3 coneApex;    //!< normal cone
+        filament::math::float3 coneAxis;
+        float coneCutoff;                   //!< cosine of the half-angle, >= 1 means no cone
+    };
+
+    /**
+     * The Builder is used to construct immutable meshlets.
+     *
+     * Clients provide pointers into their own data, which is synchronously consumed during build().
+     * Positions and triangles are required.
+     */
+    class Builder {
+    public:
+        Builder() noexcept;
+        ~Builder() noexcept;
+        Builder(Builder&& that) noexcept;
+        Builder& operator=(Builder&& that) noexcept;
+
+        Builder& vertexCount(size_t vertexCount) noexcept;
+        Builder& positions(const filament::math::float3*, size_t stride = 0) noexcept;
+
+        Builder& triangleCount(size_t triangleCount) noexcept;
+        Builder& triangles(const filament::math::uint3*) noexcept;
+        Builder& triangles(const filament::math::ushort3*) noexcept;
+
+        /**
+         * Maximum number of vertices per meshlet, at most 255. (default value: 64)
+         */
+        Builder& maxVertices(size_t count) noexcept;
+
+        /**
+         * Maximum number of triangles per meshlet, a multiple of 4 that is at most 512.
+         * (default value: 124)
+         */
+        Builder& maxTriangles(size_t count) noexcept;
+
+        /**
+         * Balances cluster size against the tightness of the normal cones, between 0 (no regard
+         * for cone culling) and 1. (default value: 0.25)
+         */
+        Builder& coneWeight(float weight) noexcept;
+
+        /**
+         * Generates meshlets or returns null if the submitted data is incomplete.
+         */
+        Meshlets* build();
+
+    private:
+        MeshletsBuilderImpl* mImpl;
+        Builder(const Builder&) = delete;
+        Builder& operator=(const Builder&) = delete;
+    };
+
+    ~Meshlets() noexcept;
+    Meshlets(Meshlets&& that) noexcept;
+    Meshlets& operator=(Meshlets&& that) noexcept;
+
+    size_t getMeshletCount() const noexcept;
+    Meshlet const* getMeshlets() const noexcept;
+    Bounds const* getBounds() const noexcept;
+
+    /**
+     * Returns the mesh vertex indices referenced by the meshlets.
+     */
+    uint32_t const* getVertices() const noexcept;
+
+    /**
+     * Returns the triangles of the meshlets, three bytes each, which are indices relative to the
+     * vertices of their meshlet.
+     */
+    uint8_t const* getTriangles() const noexcept;
+
+    /**
+     * Returns the number of triangles of all meshlets, which is the triangle count of the mesh.
+     */
+    size_t getTriangleCount() const noexcept;
+
+    /**
+     * Writes the mesh index buffer in meshlet order, that is 3 * getTriangleCount() indices. The
+     * triangles of a meshlet start at index 3 * triangleOffset.
+     * @{
+     */
+    void getIndices(uint32_t* out) const noexcept;
+    void getIndices(uint16_t* out) const noexcept;
+    /**
+     * @}
+     */
+
+    /**
+     * Returns true if every triangle of a meshlet with the given bounds faces away from a camera
+     * at the given position, in which case the meshlet can be culled.
+     */
+    static bool isBackFacing(Bounds const& bounds,
+            filament::math::float3 const& cameraPosition) noexcept;
+
+private:
+    Meshlets(MeshletsImpl*) noexcept;
+    Meshlets(const Meshlets&) = delete;
+    Meshlets& operator=(const Meshlets&) = delete;
+    MeshletsImpl* mImpl;
+    friend struct MeshletsBuilderImpl;
+};
+
+} // namespace geometry
+} // namespace filament
+
+#endif // TNT_GEOMETRY_MESHLETS_H
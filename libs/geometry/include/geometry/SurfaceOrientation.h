@@ -117,6 +117,16 @@ public:
      * @}
      */
 
+    /**
+     * Computes the quaternions of vertices that have normals but neither tangents nor UVs, which
+     * is what Builder does when it is only given normals, and writes them in packed form.
+     *
+     * Unlike Builder, this does not allocate memory, so that large meshes can be processed in
+     * parallel by calling this on disjoint ranges of vertices.
+     */
+    static void computeQuatsFromNormals(const filament::math::float3* normals,
+            filament::math::short4* out, size_t count) noexcept;
+
 private:
     SurfaceOrientation(OrientationImpl*) noexcept;
     SurfaceOrientation(const SurfaceOrientation&) = delete;
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <geometry/LevelsOfDetail.h>
+
+#include <utils/Panic.h>
+#include <utils/debug.h>
+
+#include <math/vec3.h>
+
+#include <meshoptimizer.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace filament {
+namespace geometry {
+
+using namespace filament::math;
+using std::vector;
+using Builder = LevelsOfDetail::Builder;
+
+struct LevelsOfDetailBuilderImpl {
+    size_t vertexCount = 0;
+    const float3* positions = nullptr;
+    const uint3* triangles32 = nullptr;
+    const ushort3* triangles16 = nullptr;
+    size_t positionStride = 0;
+    size_t triangleCount = 0;
+    size_t levelCount = 4;
+    float reduction = 0.5f;
+    float maxError = 0.05f;
+    bool lockBorder = false;
+    LevelsOfDetail* build();
+};
+
+struct LevelsOfDetailImpl {
+    struct Level {
+        vector<uint32_t> indices;
+        float error;
+    };
+    vector<Level> levels;
+};
+
+Builder::Builder() noexcept : mImpl(new LevelsOfDetailBuilderImpl) {}
+
+Builder::~Builder() noexcept { delete mImpl; }
+
+Builder::Builder(Builder&& that) noexcept {
+    std::swap(mImpl, that.mImpl);
+}
+
+Builder& Builder::operator=(Builder&& that) noexcept {
+    std::swap(mImpl, that.mImpl);
+    return *this;
+}
+
+Builder& Builder::vertexCount(size_t vertexCount) noexcept {
+    mImpl->vertexCount = vertexCount;
+    return *this;
+}
+
+Builder& Builder::positions(const float3* positions, size_t stride) noexcept {
+    mImpl->positions = positions;
+    mImpl->positionStride = stride;
+    return *this;
+}
+
+Builder& Builder::triangleCount(size_t triangleCount) noexcept {
+    mImpl->triangleCount = triangleCount;
+    return *this;
+}
+
+Builder& Builder::triangles(const uint3* triangles) noexcept {
+    mImpl->triangles32 = triangles;
+    return *this;
+}
+
+Builder& Builder::triangles(const ushort3* triangles) noexcept {
+    mImpl->triangles16 = triangles;
+    return *this;
+}
+
+Builder& Builder::levelCount(size_t count) noexcept {
+    mImpl->levelCount = count;
+    return *this;
+}
+
+Builder& Builder::reduction(float ratio) noexcept {
+    mImpl->reduction = ratio;
+    return *this;
+}
+
+Builder& Builder::maxError(float error) noexcept {
+    mImpl->maxError = error;
+    return *this;
+}
+
+Builder& Builder::lockBorder(bool enabled) noexcept {
+    mImpl->lockBorder = enabled;
+    return *this;
+}
+
+LevelsOfDetail* Builder::build() {
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->vertexCount > 0, "Vertex count must be non-zero.")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->positions, "Positions are required.")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->triangles16 || mImpl->triangles32,
+            "Triangles are required.")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(!mImpl->triangles16 || !mImpl->triangles32,
+            "Choose 16 or 32-bit indices, not both.")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->triangleCount > 0, "Triangle count is required.")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->levelCount > 0, "Level count must be non-zero.")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->reduction > 0.0f && mImpl->reduction < 1.0f,
+            "The reduction ratio must be within (0, 1).")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->maxError >= 0.0f && mImpl->maxError <= 1.0f,
+            "The maximum error must be within [0, 1].")) {
+        return nullptr;
+    }
+    const size_t stride = mImpl->positionStride ? mImpl->positionStride : sizeof(float3);
+    if (!ASSERT_PRECONDITION_NON_FATAL(stride >= sizeof(float3) && stride <= 256 &&
+            stride % sizeof(float) == 0, "Invalid position stride.")) {
+        return nullptr;
+    }
+    return mImpl->build();
+}
+
+LevelsOfDetail* LevelsOfDetailBuilderImpl::build() {
+    const size_t indexCount = triangleCount * 3;
+    const float* vertexPositions = &positions->x;
+    const size_t stride = positionStride ? positionStride : sizeof(float3);
+    const unsigned int options = lockBorder ? meshopt_SimplifyLockBorder : 0;
+
+    LevelsOfDetailImpl* impl = new LevelsOfDetailImpl;
+    impl->levels.reserve(levelCount);
+
+    vector<uint32_t> indices;
+    if (triangles16) {
+        const uint16_t* in = (const uint16_t*) triangles16;
+        indices.assign(in, in + indexCount);
+    } else {
+        const uint32_t* in = (const uint32_t*) triangles32;
+        indices.assign(in, in + indexCount);
+    }
+    impl->levels.push_back({ std::move(indices), 0.0f });
+
+    // Each level simplifies the previous one rather than the original mesh, which is faster and
+    // keeps the levels consistent with each other. The errors are relative to the original mesh.
+    float error = 0.0f;
+    while (impl->levels.size() < levelCount) {
+        vector<uint32_t> const& source = impl->levels.back().indices;
+        const size_t targetIndexCount = size_t(float(source.size() / 3) * reduction) * 3;
+        if (targetIndexCount < 3) {
+            break;
+        }
+        vector<uint32_t> destination(source.size());
+        float levelError = 0.0f;
+        const size_t count = meshopt_simplify(destination.data(), source.data(), source.size(),
+                vertexPositions, vertexCount, stride, targetIndexCount, maxError, options,
+                &levelError);
+        // Stop when the error bound prevents getting at least halfway to the target count.
+        if (count == 0 || float(count) > float(source.size()) * (1.0f + reduction) * 0.5f) {
+            break;
+        }
+        destination.resize(count);
+        meshopt_optimizeVertexCache(destination.data(), destination.data(), count, vertexCount);
+        error = std::max(error, levelError);
+        impl->levels.push_back({ std::move(destination), error });
+    }
+
+    return new LevelsOfDetail(impl);
+}
+
+LevelsOfDetail::LevelsOfDetail(LevelsOfDetailImpl* impl) noexcept : mImpl(impl) {}
+
+LevelsOfDetail::~LevelsOfDetail() noexcept { delete mImpl; }
+
+LevelsOfDetail::LevelsOfDetail(LevelsOfDetail&& that) noexcept : mImpl(nullptr) {
+    std::swap(mImpl, that.mImpl);
+}
+
+LevelsOfDetail& LevelsOfDetail::operator=(LevelsOfDetail&& that) noexcept {
+    std::swap(mImpl, that.mImpl);
+    return *this;
+}
+
+size_t LevelsOfDetail::getLevelCount() const noexcept {
+    return mImpl->levels.size();
+}
+
+size_t LevelsOfDetail::getTriangleCount(size_t level) const noexcept {
+    assert_invariant(level < mImpl->levels.size());
+    return mImpl->levels[level].indices.size() / 3;
+}
+
+float LevelsOfDetail::getError(size_t level) const noexcept {
+    assert_invariant(level < mImpl->levels.size());
+    return mImpl->levels[level].error;
+}
+
+void LevelsOfDetail::getTriangles(size_t level, uint3* out) const noexcept {
+    assert_invariant(level < mImpl->levels.size());
+    vector<uint32_t> const& indices = mImpl->levels[level].indices;
+    std::copy(indices.begin(), indices.end(), &out->x);
+}
+
+void LevelsOfDetail::getTriangles(size_t level, ushort3* out) const noexcept {
+    assert_invariant(level < mImpl->levels.size());
+    vector<uint32_t> const& indices = mImpl->levels[level].indices;
+    uint16_t* dst = &out->x;
+    for (uint32_t index : indices) {
+        *dst++ = uint16_t(index);
+    }
+}
+
+} // namespace geometry
+} // namespace filament
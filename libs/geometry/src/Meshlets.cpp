@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <geometry/Meshlets.h>
+
+#include <utils/Panic.h>
+#include <utils/debug.h>
+
+#include <math/vec3.h>
+
+#include <meshoptimizer.h>
+
+#include <vector>
+
+namespace filament {
+namespace geometry {
+
+using namespace filament::math;
+using std::vector;
+using Builder = Meshlets::Builder;
+
+struct MeshletsBuilderImpl {
+    size_t vertexCount = 0;
+    const float3* positions = nullptr;
+    const uint3* triangles32 = nullptr;
+    const ushort3* triangles16 = nullptr;
+    size_t positionStride = 0;
+    size_t triangleCount = 0;
+    size_t maxVertices = 64;
+    size_t maxTriangles = 124;
+    float coneWeight = 0.25f;
+    Meshlets* build();
+};
+
+struct MeshletsImpl {
+    vector<Meshlets::Meshlet> meshlets;
+    vector<Meshlets::Bounds> bounds;
+    vector<uint32_t> vertices;
+    vector<uint8_t> triangles;
+};
+
+Builder::Builder() noexcept : mImpl(new MeshletsBuilderImpl) {}
+
+Builder::~Builder() noexcept { delete mImpl; }
+
+Builder::Builder(Builder&& that) noexcept {
+    std::swap(mImpl, that.mImpl);
+}
+
+Builder& Builder::operator=(Builder&& that) noexcept {
+    std::swap(mImpl, that.mImpl);
+    return *this;
+}
+
+Builder& Builder::vertexCount(size_t vertexCount) noexcept {
+    mImpl->vertexCount = vertexCount;
+    return *this;
+}
+
+Builder& Builder::positions(const float3* positions, size_t stride) noexcept {
+    mImpl->positions = positions;
+    mImpl->positionStride = stride;
+    return *this;
+}
+
+Builder& Builder::triangleCount(size_t triangleCount) noexcept {
+    mImpl->triangleCount = triangleCount;
+    return *this;
+}
+
+Builder& Builder::triangles(const uint3* triangles) noexcept {
+    mImpl->triangles32 = triangles;
+    return *this;
+}
+
+Builder& Builder::triangles(const ushort3* triangles) noexcept {
+    mImpl->triangles16 = triangles;
+    return *this;
+}
+
+Builder& Builder::maxVertices(size_t count) noexcept {
+    mImpl->maxVertices = count;
+    return *this;
+}
+
+Builder& Builder::maxTriangles(size_t count) noexcept {
+    mImpl->maxTriangles = count;
+    return *this;
+}
+
+Builder& Builder::coneWeight(float weight) noexcept {
+    mImpl->coneWeight = weight;
+    return *this;
+}
+
+Meshlets* Builder::build() {
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->vertexCount > 0, "Vertex count must be non-zero.")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->positions, "Positions are required.")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->triangles16 || mImpl->triangles32,
+            "Triangles are required.")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(!mImpl->triangles16 || !mImpl->triangles32,
+            "Choose 16 or 32-bit indices, not both.")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->triangleCount > 0, "Triangle count is required.")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->maxVertices >= 3 && mImpl->maxVertices <= 255,
+            "The maximum vertex count must be within [3, 255].")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->maxTriangles >= 4 && mImpl->maxTriangles <= 512 &&
+            mImpl->maxTriangles % 4 == 0,
+            "The maximum triangle count must be a multiple of 4 within [4, 512].")) {
+        return nullptr;
+    }
+    const size_t stride = mImpl->positionStride ? mImpl->positionStride : sizeof(float3);
+    if (!ASSERT_PRECONDITION_NON_FATAL(stride >= sizeof(float3) && stride <= 256 &&
+            stride % sizeof(float) == 0, "Invalid position stride.")) {
+        return nullptr;
+    }
+    return mImpl->build();
+}
+
+Meshlets* MeshletsBuilderImpl::build() {
+    const size_t indexCount = triangleCount * 3;
+
+    vector<uint32_t> indices;
+    const uint32_t* indices32 = (const uint32_t*) triangles32;
+    if (triangles16) {
+        const uint16_t* in = (const uint16_t*) triangles16;
+        indices.assign(in, in + indexCount);
+        indices32 = indices.data();
+    }
+
+    const float* vertexPositions = &positions->x;
+    const size_t stride = positionStride ? positionStride : sizeof(float3);
+
+    const size_t maxMeshlets = meshopt_buildMeshletsBound(indexCount, maxVertices, maxTriangles);
+    vector<meshopt_Meshlet> meshlets(maxMeshlets);
+    vector<uint32_t> meshletVertices(maxMeshlets * maxVertices);
+    vector<uint8_t> meshletTriangles(maxMeshlets * maxTriangles * 3);
+    const size_t meshletCount = meshopt_buildMeshlets(meshlets.data(), meshletVertices.data(),
+            meshletTriangles.data(), indices32, indexCount, vertexPositions, vertexCount, stride,
+            maxVertices, maxTriangles, coneWeight);
+
+    // meshoptimizer pads the triangles of each meshlet to 4 bytes, we pack them instead so that
+    // triangle offsets map directly to ranges of the flattened index buffer.
+    MeshletsImpl* impl = new MeshletsImpl;
+    impl->meshlets.reserve(meshletCount);
+    impl->bounds.reserve(meshletCount);
+    impl->triangles.reserve(indexCount);
+    uint32_t vertexOffset = 0;
+    uint32_t triangleOffset = 0;
+    for (size_t i = 0; i < meshletCount; ++i) {
+        const meshopt_Meshlet& m = meshlets[i];
+        const uint32_t* vertices = meshletVertices.data() + m.vertex_offset;
+        const uint8_t* triangles = meshletTriangles.data() + m.triangle_offset;
+
+        impl->meshlets.push_back({ vertexOffset, triangleOffset, m.vertex_count,
+                m.triangle_count });
+        impl->vertices.insert(impl->vertices.end(), vertices, vertices + m.vertex_count);
+        impl->triangles.insert(impl->triangles.end(), triangles, triangles + m.triangle_count * 3);
+
+        const meshopt_Bounds b = meshopt_computeMeshletBounds(vertices, triangles,
+                m.triangle_count, vertexPositions, vertexCount, stride);
+        impl->bounds.push_back({
+                .center = { b.center[0], b.center[1], b.center[2] },
+                .radius = b.radius,
+                .coneApex = { b.cone_apex[0], b.cone_apex[1], b.cone_apex[2] },
+                .coneAxis = { b.cone_axis[0], b.cone_axis[1], b.cone_axis[2] },
+                .coneCutoff = b.cone_cutoff });
+
+        vertexOffset += m.vertex_count;
+        triangleOffset += m.triangle_count;
+    }
+    assert_invariant(triangleOffset == triangleCount);
+
+    return new Meshlets(impl);
+}
+
+Meshlets::Meshlets(MeshletsImpl* impl) noexcept : mImpl(impl) {}
+
+Meshlets::~Meshlets() noexcept { delete mImpl; }
+
+Meshlets::Meshlets(Meshlets&& that) noexcept : mImpl(nullptr) {
+    std::swap(mImpl, that.mImpl);
+}
+
+Meshlets& Meshlets::operator=(Meshlets&& that) noexcept {
+    std::swap(mImpl, that.mImpl);
+    return *this;
+}
+
+size_t Meshlets::getMeshletCount() const noexcept {
+    return mImpl->meshlets.size();
+}
+
+Meshlets::Meshlet const* Meshlets::getMeshlets() const noexcept {
+    return mImpl->meshlets.data();
+}
+
+Meshlets::Bounds const* Meshlets::getBounds() const noexcept {
+    return mImpl->bounds.data();
+}
+
+uint32_t const* Meshlets::getVertices() const noexcept {
+    return mImpl->vertices.data();
+}
+
+uint8_t const* Meshlets::getTriangles() const noexcept {
+    return mImpl->triangles.data();
+}
+
+size_t Meshlets::getTriangleCount() const noexcept {
+    return mImpl->triangles.size() / 3;
+}
+
+template<typename T>
+static void writeIndices(MeshletsImpl const& impl, T* out) noexcept {
+    for (Meshlets::Meshlet const& m : impl.meshlets) {
+        uint32_t const* vertices = impl.vertices.data() + m.vertexOffset;
+        uint8_t const* triangles = impl.triangles.data() + m.triangleOffset * 3;
+        for (size_t i = 0, n = m.triangleCount * 3; i < n; ++i) {
+            *out++ = T(vertices[triangles[i]]);
+        }
+    }
+}
+
+void Meshlets::getIndices(uint32_t* out) const noexcept {
+    writeIndices(*mImpl, out);
+}
+
+void Meshlets::getIndices(uint16_t* out) const noexcept {
+    writeIndices(*mImpl, out);
+}
+
+bool Meshlets::isBackFacing(Bounds const& bounds, float3 const& cameraPosition) noexcept {
+    // A cutoff of 1 or more means that the triangles face too many directions for a cone.
+    if (bounds.coneCutoff >= 1.0f) {
+        return false;
+    }
+    const float3 v = bounds.coneApex - cameraPosition;
+    const float d = length(v);
+    return d > 0.0f && dot(v, bounds.coneAxis) >= bounds.coneCutoff * d;
+}
+
+} // namespace geometry
+} // namespace filament
@@ -170,6 +170,33 @@ static void frisvadTangentSpace(const float3& N, float3& T, float3& B) {
     B = float3(1.0f - N.x * N.x * a, -N.x, b);
 }
 
+// Returns the result of frisvadTangentSpace() followed by mat3f::packTangentFrame(), in closed
+// form. The Frisvad basis is the shortest rotation from +Y to the normal, applied to the basis of
+// +Y itself, which is a rotation of -120 degrees around (1, 1, 1); below is the product of these
+// two quaternions, up to a scale factor. This is branchless except for the singularity.
+static quatf packFrisvadTangentFrame(float3 n) noexcept {
+    n = normalize(n);
+    const float a = 1.0f + n.y;
+    if (UTILS_UNLIKELY(a < std::numeric_limits<float>::epsilon())) {
+        float3 b, t;
+        frisvadTangentSpace(n, t, b);
+        return mat3f::packTangentFrame({t, b, n});
+    }
+    quatf q{ a + n.z - n.x, -a + n.z - n.x, -a + n.z + n.x, -a - n.z - n.x };
+    q *= (q.w < 0.0f ? -1.0f : 1.0f) / length(q);
+
+    // Same bias as mat3f::packTangentFrame(), which ensures w is never 0.
+    constexpr float bias = 1.0f / 32767.0f;
+    const float factor = 0.99999999953433871f; // sqrt(1 - bias * bias)
+    if (q.w < bias) {
+        q.w = bias;
+        q.xyz *= factor;
+    }
+
+    // The Frisvad basis is right-handed, so mat3f::packTangentFrame() always negates the result.
+    return -q;
+}
+
 SurfaceOrientation* OrientationBuilderImpl::buildWithNormalsOnly() {
     vector<quatf> quats(vertexCount);
 
@@ -177,10 +204,7 @@ SurfaceOrientation* OrientationBuilderImpl::buildWithNormalsOnly() {
     size_t nstride = this->normalStride ? this->normalStride : sizeof(float3);
 
     for (size_t qindex = 0; qindex < vertexCount; ++qindex) {
-        float3 n = *normal;
-        float3 b, t;
-        frisvadTangentSpace(n, t, b);
-        quats[qindex] = mat3f::packTangentFrame({t, b, n});
+        quats[qindex] = packFrisvadTangentFrame(*normal);
         normal = (const float3*) (((const uint8_t*) normal) + nstride);
     }
 
@@ -320,6 +344,13 @@ size_t SurfaceOrientation::getVertexCount() const noexcept {
     return mImpl->quaternions.size();
 }
 
+void SurfaceOrientation::computeQuatsFromNormals(const float3* UTILS_RESTRICT normals,
+        short4* UTILS_RESTRICT out, size_t count) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = packSnorm16(packFrisvadTangentFrame(normals[i]).xyzw);
+    }
+}
+
 void SurfaceOrientation::getQuats(quatf* out, size_t quatCount, size_t stride) const noexcept {
     const vector<quatf>& in = mImpl->quaternions;
     quatCount = std::min(quatCount, in.size());
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <geometry/LevelsOfDetail.h>
+
+#include <math/vec3.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+class LevelsOfDetailTest : public testing::Test {};
+
+using namespace filament::geometry;
+using namespace filament::math;
+
+TEST_F(LevelsOfDetailTest, Grid) {
+    // A flat grid can be simplified down to very few triangles without any error.
+    const uint32_t size = 32;
+    const uint32_t n = size + 1;
+    std::vector<float3> positions;
+    std::vector<uint3> triangles;
+    for (uint32_t y = 0; y < n; ++y) {
+        for (uint32_t x = 0; x < n; ++x) {
+            positions.push_back({ float(x), float(y), 0.0f });
+        }
+    }
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            const uint32_t i = y * n + x;
+            triangles.push_back({ i, i + 1, i + n + 1 });
+            triangles.push_back({ i, i + n + 1, i + n });
+        }
+    }
+
+    LevelsOfDetail* lods = LevelsOfDetail::Builder()
+            .vertexCount(positions.size())
+            .positions(positions.data())
+            .triangleCount(triangles.size())
+            .triangles(triangles.data())
+            .levelCount(4)
+            .build();
+    ASSERT_NE(lods, nullptr);
+    ASSERT_EQ(lods->getLevelCount(), 4);
+    ASSERT_EQ(lods->getTriangleCount(0), triangles.size());
+    EXPECT_EQ(lods->getError(0), 0.0f);
+
+    for (size_t level = 1; level < lods->getLevelCount(); ++level) {
+        const size_t count = lods->getTriangleCount(level);
+        EXPECT_LE(count, lods->getTriangleCount(level - 1) / 2);
+        EXPECT_GE(lods->getError(level), lods->getError(level - 1));
+        EXPECT_LT(lods->getError(level), 1e-3f);
+
+        std::vector<uint3> simplified(count);
+        lods->getTriangles(level, simplified.data());
+        for (uint3 const& t : simplified) {
+            EXPECT_LT(t.x, positions.size());
+            EXPECT_LT(t.y, positions.size());
+            EXPECT_LT(t.z, positions.size());
+        }
+    }
+
+    delete lods;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <geometry/Meshlets.h>
+
+#include <math/vec3.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+class MeshletsTest : public testing::Test {};
+
+using namespace filament::geometry;
+using namespace filament::math;
+
+namespace {
+
+// A flat grid of size x size quads in the XY plane, with counter-clockwise triangles facing +Z.
+void makeGrid(uint32_t size, std::vector<float3>& positions, std::vector<uint3>& triangles) {
+    const uint32_t n = size + 1;
+    for (uint32_t y = 0; y < n; ++y) {
+        for (uint32_t x = 0; x < n; ++x) {
+            positions.push_back({ float(x), float(y), 0.0f });
+        }
+    }
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            const uint32_t i = y * n + x;
+            triangles.push_back({ i, i + 1, i + n + 1 });
+            triangles.push_back({ i, i + n + 1, i + n });
+        }
+    }
+}
+
+} // anonymous namespace
+
+TEST_F(MeshletsTest, Grid) {
+    std::vector<float3> positions;
+    std::vector<uint3> triangles;
+    makeGrid(32, positions, triangles);
+
+    Meshlets* meshlets = Meshlets::Builder()
+            .vertexCount(positions.size())
+            .positions(positions.data())
+            .triangleCount(triangles.size())
+            .triangles(triangles.data())
+            .build();
+    ASSERT_NE(meshlets, nullptr);
+    ASSERT_GT(meshlets->getMeshletCount(), 1);
+    ASSERT_EQ(meshlets->getTriangleCount(), triangles.size());
+
+    uint32_t triangleOffset = 0;
+    for (size_t i = 0; i < meshlets->getMeshletCount(); ++i) {
+        Meshlets::Meshlet const& m = meshlets->getMeshlets()[i];
+        Meshlets::Bounds const& b = meshlets->getBounds()[i];
+        EXPECT_LE(m.vertexCount, 64);
+        EXPECT_LE(m.triangleCount, 124);
+        EXPECT_EQ(m.triangleOffset, triangleOffset);
+        triangleOffset += m.triangleCount;
+
+        // Every vertex is within the bounding sphere.
+        for (uint32_t v = 0; v < m.vertexCount; ++v) {
+            const float3 p = positions[meshlets->getVertices()[m.vertexOffset + v]];
+            EXPECT_LE(distance(p, b.center), b.radius * 1.001f);
+        }
+
+        // The grid is flat, so all the cones point towards +Z.
+        EXPECT_NEAR(b.coneAxis.z, 1.0f, 1e-2f);
+        EXPECT_TRUE(Meshlets::isBackFacing(b, b.center - float3{ 0, 0, 10 }));
+        EXPECT_FALSE(Meshlets::isBackFacing(b, b.center + float3{ 0, 0, 10 }));
+    }
+
+    // The flattened index buffer contains the same triangles, with the same winding.
+    std::vector<uint32_t> indices(triangles.size() * 3);
+    meshlets->getIndices(indices.data());
+    auto canonical = [](uint3 t) {
+        while (t.x > t.y || t.x > t.z) {
+            t = uint3{ t.y, t.z, t.x };
+        }
+        return std::vector<uint32_t>{ t.x, t.y, t.z };
+    };
+    std::vector<std::vector<uint32_t>> expected, actual;
+    for (size_t i = 0; i < triangles.size(); ++i) {
+        expected.push_back(canonical(triangles[i]));
+        actual.push_back(canonical({ indices[i * 3], indices[i * 3 + 1], indices[i * 3 + 2] }));
+    }
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    EXPECT_EQ(expected, actual);
+
+    delete meshlets;
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <geometry/SurfaceOrientation.h>
 #include <geometry/TangentSpaceMesh.h>
 
 #include <math/quat.h>
@@ -427,6 +428,27 @@ TEST_F(TangentSpaceMeshTest, Lengyel) {
     TangentSpaceMesh::destroy(mesh);
 }
 
+TEST_F(TangentSpaceMeshTest, SurfaceOrientationFromNormals) {
+    const size_t count = TEST_NORMALS.size();
+    SurfaceOrientation* orientation = SurfaceOrientation::Builder()
+            .vertexCount(count)
+            .normals(TEST_NORMALS.data())
+            .build();
+    std::vector<short4> expected(count);
+    orientation->getQuats(expected.data(), count);
+    delete orientation;
+
+    // The allocation-free kernel must produce the same quaternions as the builder.
+    std::vector<short4> quats(count);
+    SurfaceOrientation::computeQuatsFromNormals(TEST_NORMALS.data(), quats.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(quats[i], expected[i]);
+        const float4 q = float4(quats[i]) / 32767.0f;
+        const float3 n = normalize(quatf(q.w, q.x, q.y, q.z) * NORMAL_AXIS);
+        EXPECT_LT(length(n - TEST_NORMALS[i]), 1e-3f);
+    }
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -42,11 +42,36 @@ public:
      * Applies rotation, translation, and scale to entities that have been targeted by the given
      * animation definition. Uses filament::TransformManager.
      *
+     * \c KHR_animation_pointer channels that target the factors of a material or the color and
+     * intensity of a light are applied through filament::MaterialInstance and
+     * filament::LightManager. These are bound when the animator is created, so they require the
+     * source data of the asset (see FilamentAsset::releaseSourceData).
+     *
      * @param animationIndex Zero-based index for the \c animation of interest.
      * @param time Elapsed time of interest in seconds.
      */
     void applyAnimation(size_t animationIndex, float time) const;
 
+    /** Describes an animation to apply with applyAnimations(). */
+    struct AnimationState {
+        Animator* animator;     //!< animator that drives the entities of interest
+        size_t animationIndex;  //!< zero-based index for the \c animation of interest
+        float time;             //!< elapsed time of interest in seconds
+    };
+
+    /**
+     * Equivalent to calling applyAnimation() on each of the given animators, but spreads the work
+     * across the threads of the engine's utils::JobSystem.
+     *
+     * All animators must belong to assets that were created with the same engine, and a given
+     * animator must not appear more than once in the list. This must be called from the engine's
+     * main thread.
+     *
+     * @param states List of animator / animation / time tuples to apply.
+     * @param count Number of entries in the list.
+     */
+    static void applyAnimations(AnimationState const* states, size_t count);
+
     /**
      * Computes root-to-node transforms for all bone nodes, then passes
      * the results into filament::RenderableManager::setBones.
@@ -56,11 +81,22 @@ public:
      */
     void updateBoneMatrices();
 
+    /**
+     * Equivalent to calling updateBoneMatrices() on each of the given animators, but computes the
+     * bone matrices in parallel across the threads of the engine's utils::JobSystem.
+     *
+     * All animators must belong to assets that were created with the same engine, and a given
+     * animator must not appear more than once in the list. This must be called from the engine's
+     * main thread.
+     */
+    static void updateBoneMatrices(Animator* const* animators, size_t count);
+
     /**
      * Applies a blended transform to the union of nodes affected by two animations.
      * Used for cross-fading from a previous skinning-based animation or rigid body animation.
      *
-     * First, this stashes the current transform hierarchy into a transient memory buffer.
+     * First, this stashes the current local transforms of the nodes targeted by the previous
+     * animation into a transient memory buffer. Other nodes are not affected by the cross fade.
      *
      * Next, this applies previousAnimIndex / previousAnimTime to the actual asset by internally
      * calling applyAnimation().
@@ -75,6 +111,107 @@ public:
      */
     void applyCrossFade(size_t previousAnimIndex, float previousAnimTime, float alpha);
 
+    /** Describes one layer of the blend performed by applyAnimationLayers(). */
+    struct AnimationLayer {
+        size_t animationIndex;  //!< zero-based index for the \c animation of interest
+        float time;             //!< elapsed time of interest in seconds
+        float weight = 1.0f;    //!< influence of this layer, between 0 and 1
+
+        //! If true, this layer adds the motion of the animation relative to its first keyframe,
+        //! rather than blending towards its pose.
+        bool additive = false;
+
+        //! Optional list of the entities that this layer affects, e.g. the upper-body joints.
+        //! If null, the layer affects all the entities targeted by the animation.
+        utils::Entity const* mask = nullptr;
+        size_t maskCount = 0;   //!< number of entities in the mask
+    };
+
+    /**
+     * Blends any number of animations and applies the result to the targeted entities. Each
+     * affected node is written once, regardless of the number of layers.
+     *
+     * Layers are evaluated in order, starting from the rest pose of the asset. A regular layer
+     * blends the accumulated pose towards its own pose according to its weight, so a layer with a
+     * weight of 1 overrides the layers below it. An additive layer instead adds the difference
+     * between its pose and the first keyframe of its animation, scaled by its weight.
+     *
+     * Morph weights are blended in the same way, starting from zero.
+     *
+     * For example, to play an upper-body action over a locomotion cycle, pass the locomotion
+     * animation with no mask, followed by the action with a mask of the upper-body joints.
+     *
+     * @param layers List of layers, from bottom to top.
+     * @param count Number of layers in the list.
+     */
+    void applyAnimationLayers(AnimationLayer const* layers, size_t count);
+
+    /** Level of detail settings, see setLevelOfDetail(). */
+    struct LevelOfDetail {
+        //! Number of calls to applyAnimation() per evaluation of the animation. In between
+        //! evaluations, local transforms are interpolated towards the pose of the next evaluation,
+        //! which is predicted from the rate at which the given time advances.
+        uint32_t updateInterval = 1;
+
+        //! Optional list of the entities that are animated at this level of detail, e.g. the main
+        //! joints of a skeleton. If null, all of the targeted entities are animated.
+        utils::Entity const* mask = nullptr;
+        size_t maskCount = 0;   //!< number of entities in the mask
+
+        //! If false, updateBoneMatrices() does nothing. Clients will typically set this to false
+        //! when the instance was outside of the view frustum in the previous frame.
+        bool visible = true;
+    };
+
+    /**
+     * Reduces the cost of animating this instance, e.g. according to its distance from the camera
+     * or to its visibility. The default settings evaluate everything at every call.
+     *
+     * The mask applies to applyAnimation(), applyAnimations() and applyAnimationLayers(), while
+     * the update interval applies to the first two.
+     */
+    void setLevelOfDetail(LevelOfDetail const& lod);
+
+    /**
+     * Samples the given animation at a fixed rate and caches the resulting bone matrices, so that
+     * applyBakedAnimation() can play it back for a fraction of the cost of calling
+     * applyAnimation() followed by updateBoneMatrices().
+     *
+     * The cache is shared by the animators of all instances of the asset, so a looping cycle
+     * only needs to be baked once for a whole crowd. Its memory cost is proportional to the
+     * frame rate, the duration of the animation, and the number of bones.
+     *
+     * A conservative bounding box is also baked for each frame of each skinned renderable, from the
+     * extent of the vertices that each joint influences. These extents are computed when resources
+     * are loaded, so this does not need the source data. Renderables whose positions are morphed
+     * and vertex data that was not decoded at that time are left out.
+     *
+     * This temporarily applies the animation to the entities driven by this animator, then
+     * restores their local transforms.
+     *
+     * @param animationIndex Zero-based index for the \c animation of interest.
+     * @param frameRate Number of frames per second to sample.
+     */
+    void bakeAnimation(size_t animationIndex, float frameRate = 30.0f);
+
+    /**
+     * Passes bone matrices to filament::RenderableManager::setBones by interpolating between the
+     * two baked frames nearest to the given time. The animation must have been baked by the
+     * animator of any instance of this asset, see bakeAnimation().
+     *
+     * This neither updates filament::TransformManager nor morph weights, so it is suited to
+     * skinned characters that do not need anything else from the animation.
+     *
+     * The bounding boxes of the skinned renderables are set from the baked bounds, which keeps
+     * culling tight as the character moves. The renderables of instances that follow the skinning
+     * of another instance keep their bounding box. Other methods of this class do not restore the
+     * bind-pose bounding boxes.
+     *
+     * @param animationIndex Zero-based index for the \c animation of interest.
+     * @param time Elapsed time of interest in seconds.
+     */
+    void applyBakedAnimation(size_t animationIndex, float time);
+
     /**
      * Pass the identity matrix into all bone nodes, useful for returning to the T pose.
      *
@@ -82,7 +219,10 @@ public:
      */
     void resetBoneMatrices();
 
-    /** Returns the number of \c animation definitions in the glTF asset. */
+    /**
+     * Returns the number of \c animation definitions in the glTF asset, plus the number of
+     * animations that were added with addAnimation().
+     */
     size_t getAnimationCount() const;
 
     /** Returns the duration of the specified glTF \c animation in seconds. */
@@ -94,6 +234,86 @@ public:
      */
     const char* getAnimationName(size_t animationIndex) const;
 
+    /**
+     * Binds an \c animation definition from the given asset to the entities driven by this
+     * animator, and returns its index for use with applyAnimation() and the other methods.
+     *
+     * The decoded keyframe data is shared with the source asset rather than copied, and it stays
+     * alive for as long as this animator uses it, even if the source asset is destroyed. This
+     * allows a library of animations to be loaded once and played by many instances.
+     *
+     * Channels are matched with their targets by glTF node index, so the source asset should
+     * have the same node hierarchy as this one (e.g. an animation-only export of the same rig).
+     * Channels that target nodes that do not exist in this asset are ignored.
+     *
+     * @param source Asset that holds the animation, which must have been loaded with
+     *               ResourceLoader. This can be the asset that owns this animator.
+     * @param animationIndex Zero-based index of the \c animation within the source asset.
+     * @return Zero-based index of the newly added animation within this animator.
+     */
+    size_t addAnimation(FilamentAsset const* source, size_t animationIndex);
+
+    /** Renames a node of a source asset for the purpose of retargetAnimation(). */
+    struct NameMapping {
+        const char* source; //!< name of the node in the source asset
+        const char* target; //!< name of the node in this asset
+    };
+
+    /**
+     * Binds an \c animation definition from an asset with a different node hierarchy, and
+     * returns its index for use with applyAnimation() and the other methods.
+     *
+     * This is similar to addAnimation(), except that channels are matched with their targets by
+     * node name. Names are resolved once, during this call, so playing a retargeted animation
+     * costs no more than playing any other animation. Channels whose target has no counterpart in
+     * this asset are ignored.
+     *
+     * Only the names are remapped: local transforms are applied as-is, so the two skeletons
+     * should have compatible rest poses.
+     *
+     * @param source Asset that holds the animation, which must have been loaded with
+     *               ResourceLoader.
+     * @param animationIndex Zero-based index of the \c animation within the source asset.
+     * @param remap Optional list of renames for nodes whose names differ between the two assets.
+     *              Source nodes that are not in this list are matched with a node of the same name.
+     * @param remapCount Number of entries in the remap list.
+     * @return Zero-based index of the newly added animation within this animator.
+     */
+    size_t retargetAnimation(FilamentAsset const* source, size_t animationIndex,
+            NameMapping const* remap = nullptr, size_t remapCount = 0);
+
+    /**
+     * Counters of the work done by this animator since it was created or since the last call to
+     * resetStats(). These help to confirm that the level of detail and the other optimizations
+     * are effective, e.g. by resetting them once per frame.
+     *
+     * The methods that do this work also appear in systrace, along with counters of the work done
+     * by each call.
+     */
+    struct Stats {
+        uint32_t channelsEvaluated = 0;     //!< animation channels sampled
+        uint32_t keyframeSearchSteps = 0;   //!< keyframes visited to find the sampled keyframes
+        uint32_t nodesComposed = 0;         //!< local transforms recomposed from their components
+        uint32_t bonesUploaded = 0;         //!< bone matrices passed to setBones
+        uint32_t morphWeightsUploaded = 0;  //!< morph weights passed to setMorphWeights
+        uint64_t bytesUploaded = 0;         //!< size of the bone matrices and morph weights
+        uint64_t animationTime = 0;         //!< nanoseconds spent applying animations
+        uint64_t crossFadeTime = 0;         //!< nanoseconds spent in applyCrossFade()
+        uint64_t boneTime = 0;              //!< nanoseconds spent updating bone matrices
+    };
+
+    /**
+     * Returns the work done by this animator since the last call to resetStats().
+     *
+     * The time spent in applyCrossFade() includes the time spent applying the previous
+     * animation, which is also counted in the animation time. The bone time includes
+     * applyBakedAnimation() and resetBoneMatrices().
+     */
+    Stats getStats() const;
+
+    /** Resets all the counters returned by getStats() to zero. */
+    void resetStats();
+
     // For internal use only.
     void addInstance(FFilamentInstance* instance);
 
@@ -37,6 +37,7 @@ namespace utils {
 namespace filament::gltfio {
 
 class NodeManager;
+struct PreparedAsset;
 
 // Use this struct to enable mikktspace-based tangent-space computation.
 /**
@@ -83,6 +84,17 @@ struct AssetConfiguration {
     //! Optional to enable mikktspace tangents. Lifetime of struct only needs to be maintained for
     //  the duration of the constructor of AssetLoader.
     AssetConfigurationExtended* ext = nullptr;
+
+    //! Stores float texture coordinates as normalized 16-bit integers when their accessor has
+    //! min / max values within [0, 1] or [-1, 1], which halves their size without losing precision
+    //! for textures up to 16K. Other texture coordinates are kept as floats.
+    bool quantizeTexCoords = false;
+
+    //! If true, the programs of the materials used by KHR_materials_variants are compiled in the
+    //! background as soon as their instances are created, with Material::compile(). This avoids a
+    //! hitch the first time FilamentInstance::applyMaterialVariant is called, at the cost of
+    //! compiling variants that might never be applied. Stereo variants are not compiled.
+    bool compileMaterialVariants = false;
 };
 
 /**
@@ -177,6 +189,45 @@ public:
      */
     FilamentAsset* createAsset(const uint8_t* bytes, uint32_t nbytes);
 
+    /**
+     * Same as createAsset() but reads the given file directly. Where supported, the file is
+     * memory-mapped rather than copied, and the binary chunk of a GLB is uploaded from the mapping.
+     * The file stays mapped until the source data and the uploads that reference it are released.
+     *
+     * Returns null if the file cannot be opened or parsed.
+     */
+    FilamentAsset* createAssetFromFile(const char* path);
+
+    /**
+     * First half of createAsset(), which does not create any Filament object: it copies and
+     * parses the glTF, checks that it can be loaded, and flattens its node hierarchy. This does
+     * not touch the engine nor the state of the loader, so it can be called from any thread,
+     * concurrently with other calls to prepareAsset() and with the loader being used elsewhere.
+     *
+     * The result must be passed to commitAsset() or destroyPreparedAsset().
+     * Returns null on failure.
+     */
+    PreparedAsset* prepareAsset(const uint8_t* bytes, uint32_t nbytes);
+
+    /**
+     * Same as prepareAsset() but reads the given file directly, see createAssetFromFile().
+     */
+    PreparedAsset* prepareAssetFromFile(const char* path);
+
+    /**
+     * Second half of createAsset(): creates the entities, components and material instances of
+     * a prepared asset, with one instance. Like createAsset(), this must be called on the thread
+     * that owns the engine.
+     *
+     * This consumes the prepared asset, even on failure, in which case it returns null.
+     */
+    FilamentAsset* commitAsset(PreparedAsset* prepared);
+
+    /**
+     * Frees a prepared asset that will not be committed. Can be called from any thread.
+     */
+    static void destroyPreparedAsset(PreparedAsset* prepared);
+
     /**
      * Consumes the contents of a glTF 2.0 file and produces a primary asset with one or more
      * instances. The primary asset has ownership over the instances.
@@ -209,17 +260,53 @@ public:
      *
      * Use this with caution. It is more efficient to pre-allocate a max number of instances, and
      * gradually add them to the scene as needed. Instances can also be "recycled" by removing and
-     * re-adding them to the scene.
+     * re-adding them to the scene, or through recycleInstance().
      *
      * NOTE: destroyInstance() does not exist because gltfio favors flat arrays for storage of
      * entity lists and instance lists, which would be slow to shift. We also wish to discourage
      * create/destroy churn, as noted above.
      *
-     * This cannot be called after FilamentAsset::releaseSourceData().
-     * See also AssetLoader::createInstancedAsset().
+     * Unless a recycled instance is available, this cannot be called after
+     * FilamentAsset::releaseSourceData().
+     * See also AssetLoader::createInstancedAsset() and AssetLoader::createInstances().
      */
     FilamentInstance* createInstance(FilamentAsset* asset);
 
+    /**
+     * Adds the given number of instances to the asset, which is much faster than calling
+     * createInstance() repeatedly: the entities of all instances are allocated at once.
+     *
+     * Recycled instances (see recycleInstance()) are handed out first.
+     *
+     * With shareSkinning, the new instances are meant to play the same animation at the same time,
+     * e.g. in a crowd. Their skinned renderables then use the bones of the first of them, which are
+     * stored in a SkinningBuffer per skinned node: only the Animator of the first new instance
+     * computes and uploads bones, and updateBoneMatrices() does nothing for the others, so they
+     * don't need to be animated unless other entities are attached to their joints. Instances
+     * keep sharing their bones when they are recycled.
+     *
+     * @param asset the primary asset
+     * @param count number of instances to add
+     * @param instances destination array of size count, can be null
+     * @param shareSkinning whether the new instances share their bones
+     * @return the number of instances written to "instances", which is less than count on failure
+     */
+    size_t createInstances(FilamentAsset* asset, size_t count, FilamentInstance** instances,
+            bool shareSkinning = false);
+
+    /**
+     * Returns an instance that is no longer needed to the pool of its asset, so that it is handed
+     * out again by the next createInstance() or createInstances() call instead of creating new
+     * entities and components.
+     *
+     * The instance stays owned by the asset and its entities are not destroyed, so clients should
+     * remove them from the scene. When it is handed out again, the root and node transforms of the
+     * instance are reset to their initial values (the node transforms only until
+     * FilamentAsset::releaseSourceData() is called) and its bone matrices are reset. Other changes,
+     * such as material parameters or variants, are kept.
+     */
+    void recycleInstance(FilamentAsset* asset, FilamentInstance* instance);
+
     /**
      * Allows clients to enable diagnostic shading on newly-loaded assets.
      */
@@ -134,7 +134,8 @@ public:
      * please use popRenderables().
      *
      * This method allows clients to progressively add the asset's renderables to the scene as
-     * textures gradually become ready through asynchronous loading. For example, on every frame
+     * textures (and, with ResourceConfiguration::progressiveGeometry, geometry) gradually become
+     * ready through asynchronous loading. For example, on every frame
      * progressive applications can do something like this:
      *
      *    while (Entity e = popRenderable()) { scene.addEntity(e); }
@@ -235,6 +236,18 @@ public:
      */
     void releaseSourceData() noexcept;
 
+    /**
+     * Reclaims CPU-side memory for the binary glTF data, i.e. the vertex, index, animation and
+     * embedded image data, but keeps the hierarchy so that new instances can still be created
+     * and animated.
+     *
+     * This should only be called after ResourceLoader::loadResources(), or once
+     * ResourceLoader::asyncGetLoadProgress() reaches 1. The memory is freed once the GPU uploads
+     * that use it are done. Afterwards, FilamentInstance::recomputeBoundingBoxes() can no longer
+     * be called.
+     */
+    void releaseSourceBuffers() noexcept;
+
     /**
      * Returns a weak reference to the underlying cgltf hierarchy. This becomes invalid after
      * calling releaseSourceData().
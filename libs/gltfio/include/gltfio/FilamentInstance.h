@@ -139,7 +139,8 @@ public:
      * THIS IS ONLY USEFUL FOR MALFORMED ASSETS THAT DO NOT HAVE MIN/MAX SET UP CORRECTLY.
      *
      * Does not affect the return value of getBoundingBox() on the owning asset.
-     * Cannot be called after releaseSourceData() on the owning asset.
+     * Cannot be called after releaseSourceData() or releaseSourceBuffers() on the owning asset,
+     * unless its resources were loaded with ResourceConfiguration::cacheBoundingBoxes.
      * Can only be called after loadResources() or asyncBeginLoad().
      */
     void recomputeBoundingBoxes();
@@ -188,7 +188,12 @@ void processShaderString(std::string* shader, const UvMap& uvmap,
 /**
  * Creates a material provider that builds materials on the fly, composing GLSL at run time.
  *
+ * Generated packages are cached for the lifetime of the process and shared by all JIT providers,
+ * so that only the Material objects themselves are created again for other engines or providers.
+ *
  * @param optimizeShaders Optimizes shaders, but at significant cost to construction time.
+ * @param cacheDirectory Optional existing directory where generated packages are persisted, so
+ *                       that subsequent runs can load them instead of generating them again.
  * @return New material provider that can build materials at run time.
  *
  * Requires \c libfilamat to be linked in. Not available in \c libgltfio_core.
@@ -196,7 +201,8 @@ void processShaderString(std::string* shader, const UvMap& uvmap,
  * @see createUbershaderProvider
  */
 UTILS_PUBLIC
-MaterialProvider* createJitShaderProvider(Engine* engine, bool optimizeShaders = false);
+MaterialProvider* createJitShaderProvider(Engine* engine, bool optimizeShaders = false,
+        const char* cacheDirectory = nullptr);
 
 /**
  * Creates a material provider that loads a small set of pre-built materials.
@@ -24,6 +24,7 @@
 #include <utils/CString.h>
 #include <utils/EntityInstance.h>
 #include <utils/FixedCapacityVector.h>
+#include <utils/Slice.h>
 
 namespace utils {
 class Entity;
@@ -84,11 +85,16 @@ public:
      */
     void destroy(Entity e) noexcept;
 
-    void setMorphTargetNames(Instance ci, utils::FixedCapacityVector<CString> names) noexcept;
-    const utils::FixedCapacityVector<CString>& getMorphTargetNames(Instance ci) const noexcept;
+    /**
+     * Node components don't own their strings, they reference strings that must outlive the
+     * component. gltfio stores them in the string pool of the asset, so they're shared by all
+     * the instances of the asset.
+     */
+    void setMorphTargetNames(Instance ci, utils::Slice<const char* const> names) noexcept;
+    utils::Slice<const char* const> getMorphTargetNames(Instance ci) const noexcept;
 
-    void setExtras(Instance ci, CString extras) noexcept;
-    const CString& getExtras(Instance ci) const noexcept;
+    void setExtras(Instance ci, const char* extras) noexcept;
+    const char* getExtras(Instance ci) const noexcept;
 
     void setSceneMembership(Instance ci, SceneMask scenes) noexcept;
     SceneMask getSceneMembership(Instance ci) const noexcept;
@@ -49,6 +49,45 @@ struct ResourceConfiguration {
     //! If true, adjusts skinning weights to sum to 1. Well formed glTF files do not need this,
     //! but it is useful for robustness.
     bool normalizeSkinningWeights;
+
+    //! If true, the translation, rotation and scale animation channels that use linear or step
+    //! interpolation are stored in a compressed form. Keys that interpolation can reconstruct
+    //! within a small tolerance are removed. Rotations are then quantized to 48 bits, and
+    //! translations and scales to 16 bits per component. This typically cuts the memory used by
+    //! dense (e.g. motion capture) animations several-fold, at the cost of sub-millimeter and
+    //! sub-milliradian errors.
+    bool compressAnimations = false;
+
+    //! If greater than zero, the keyframes of the animations that last at least this many seconds
+    //! are streamed rather than kept in memory. They are written to a temporary file when
+    //! resources are loaded, then read back in chunks of #animationChunkDuration seconds. The
+    //! chunk that follows the one being played is read ahead on the utils::JobSystem, and chunks
+    //! are released once every animator that plays the animation has moved past them. Channels
+    //! compressed by #compressAnimations stay in memory.
+    float streamedAnimationDuration = 0.0f;
+
+    //! Duration in seconds of the chunks of streamed animations, see #streamedAnimationDuration.
+    float animationChunkDuration = 2.0f;
+
+    //! If true, #asyncBeginLoad doesn't upload the geometry. Instead, each call to
+    //! #asyncUpdateLoad uploads the vertex and index buffers of a few primitives, the largest
+    //! ones first, and a renderable becomes ready (see FilamentAsset::popRenderable) as soon as
+    //! the geometry of all its primitives has been uploaded. Clients must only add the popped
+    //! renderables to their scene. This is ignored by the synchronous #loadResources.
+    bool progressiveGeometry = false;
+
+    //! If true, the triangles of indexed primitives are reordered before upload, for the
+    //! post-transform vertex cache first and then to reduce overdraw. This costs some loading time
+    //! but cuts vertex shading on assets that were exported without such an optimization. Vertices
+    //! are left in place since they can be shared between primitives and with morph targets.
+    bool optimizeIndices = false;
+
+    //! If true, the object-space bounds of every mesh are computed when resources are loaded, and
+    //! kept along with the bounds of the vertices influenced by each joint. This lets
+    //! FilamentInstance::recomputeBoundingBoxes return quickly, and keep working after
+    //! FilamentAsset::releaseSourceData. Skinned meshes then get conservative bounds instead of
+    //! the exact bounds of their current pose.
+    bool cacheBoundingBoxes = false;
 };
 
 /**
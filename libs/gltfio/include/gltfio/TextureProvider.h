@@ -155,6 +155,16 @@ public:
      */
     virtual void cancelDecoding() = 0;
 
+    /**
+     * Changes the order in which pushed textures are decoded, e.g. to decode the textures of
+     * visible materials first.
+     *
+     * Textures with a higher priority are decoded first, and textures with the same priority are
+     * decoded in the order they were pushed. The default priority is 0. This has no effect on
+     * textures whose decoding has already started, nor on providers that decode eagerly.
+     */
+    virtual void setDecodingPriority(Texture* texture, int priority) {}
+
     /** Total number of successful push calls since the provider was created. */
     virtual size_t getPushedCount() const = 0;
 
@@ -170,8 +180,13 @@ public:
 /**
  * Creates a simple decoder based on stb_image that can handle "image/png" and "image/jpeg".
  * This works only if your build configuration includes STB.
+ *
+ * If compressTextures is true, the decoder threads also generate the mipmaps and compress the
+ * images to BC1 (BC3 if they have an alpha channel), which divides their memory footprint by
+ * 4 to 8. This applies only when the backend supports these formats (typically on desktop) and
+ * the image dimensions are multiples of 4; other images stay uncompressed.
  */
-TextureProvider* createStbProvider(filament::Engine* engine);
+TextureProvider* createStbProvider(filament::Engine* engine, bool compressTextures = false);
 
 /**
  * Creates a decoder that can handle certain types of "image/ktx2" content as specified in
@@ -71,14 +71,11 @@ UTILS_PUBLIC inline void decomposeMatrix(const filament::math::mat4f& mat, filam
     }
     *scale = s;
 
-    // Remove scale from the matrix if it is not close to zero.
-    mat4f clone = mat;
+    // Remove scale from the matrix if it is not close to zero. Only the upper-left 3x3 block is
+    // needed to extract the rotation.
     if (std::abs(det) > std::numeric_limits<float>::epsilon()) {
-        clone[0] /= s.x;
-        clone[1] /= s.y;
-        clone[2] /= s.z;
-        // Extract rotation
-        *rotation = clone.toQuaternion();
+        const mat3f unscaled(mat[0].xyz / s.x, mat[1].xyz / s.y, mat[2].xyz / s.z);
+        *rotation = unscaled.toQuaternion();
     } else {
         // Set to identity if close to zero
         *rotation = quatf(1.0f);
@@ -0,0 +1,410 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AnimationClip.h"
+#include "AnimationCompression.h"
+#include "AnimationStream.h"
+
+#include "FFilamentAsset.h"
+
+#include <utils/Log.h>
+
+#include <cgltf.h>
+
+#include <algorithm>
+#include <string_view>
+#include <utility>
+
+#include <string.h>
+
+using namespace utils;
+
+namespace filament::gltfio {
+
+static void createSampler(const cgltf_animation_sampler& src, Sampler& dst) {
+    // Copy the time values into a flat array. The glTF spec requires them to be strictly
+    // increasing, so the array is sorted and can be searched directly.
+    const cgltf_accessor* timelineAccessor = src.input;
+    const uint8_t* timelineBlob = nullptr;
+    const float* timelineFloats = nullptr;
+    if (timelineAccessor->buffer_view->has_meshopt_compression) {
+        timelineBlob = (const uint8_t*) timelineAccessor->buffer_view->data;
+        timelineFloats = (const float*) (timelineBlob + timelineAccessor->offset);
+    } else {
+        timelineBlob = (const uint8_t*) timelineAccessor->buffer_view->buffer->data;
+        timelineFloats = (const float*) (timelineBlob + timelineAccessor->offset +
+                timelineAccessor->buffer_view->offset);
+    }
+    dst.times.assign(timelineFloats, timelineFloats + timelineAccessor->count);
+
+    // Convert source data to float.
+    const cgltf_accessor* valuesAccessor = src.output;
+    switch (valuesAccessor->type) {
+        case cgltf_type_scalar:
+            dst.values.resize(valuesAccessor->count);
+            cgltf_accessor_unpack_floats(src.output, &dst.values[0], valuesAccessor->count);
+            break;
+        case cgltf_type_vec3:
+            dst.values.resize(valuesAccessor->count * 3);
+            cgltf_accessor_unpack_floats(src.output, &dst.values[0], valuesAccessor->count * 3);
+            break;
+        case cgltf_type_vec4:
+            dst.values.resize(valuesAccessor->count * 4);
+            cgltf_accessor_unpack_floats(src.output, &dst.values[0], valuesAccessor->count * 4);
+            break;
+        default:
+            GLTFIO_WARN("Unknown animation type.");
+            return;
+    }
+
+    switch (src.interpolation) {
+        case cgltf_interpolation_type_linear:
+            dst.interpolation = Sampler::LINEAR;
+            break;
+        case cgltf_interpolation_type_step:
+            dst.interpolation = Sampler::STEP;
+            break;
+        case cgltf_interpolation_type_cubic_spline:
+            dst.interpolation = Sampler::CUBIC;
+            break;
+        case cgltf_interpolation_type_max_enum:
+            break;
+    }
+
+    if (!dst.times.empty()) {
+        dst.valuesPerKey = uint32_t(dst.values.size() / dst.times.size());
+    }
+}
+
+static bool getTrackPath(const cgltf_animation_channel& src, AnimationClip::Path* dst) {
+    switch (src.target_path) {
+        case cgltf_animation_path_type_translation:
+            *dst = AnimationClip::TRANSLATION;
+            return true;
+        case cgltf_animation_path_type_rotation:
+            *dst = AnimationClip::ROTATION;
+            return true;
+        case cgltf_animation_path_type_scale:
+            *dst = AnimationClip::SCALE;
+            return true;
+        case cgltf_animation_path_type_weights:
+            *dst = AnimationClip::WEIGHTS;
+            return true;
+        case cgltf_animation_path_type_max_enum:
+        case cgltf_animation_path_type_invalid:
+            GLTFIO_WARN("Unsupported channel path.");
+            return false;
+    }
+    return false;
+}
+
+// Unnamed nodes are matched with the name of their mesh, which is consistent with the names that
+// AssetLoader assigns to entities.
+static const char* getTargetName(const cgltf_node& node) {
+    if (node.name) return node.name;
+    if (node.mesh && node.mesh->name) return node.mesh->name;
+    return nullptr;
+}
+
+static bool validateAnimation(const cgltf_animation& anim) {
+    for (cgltf_size j = 0; j < anim.channels_count; ++j) {
+        const cgltf_animation_channel& channel = anim.channels[j];
+        const cgltf_animation_sampler* sampler = channel.sampler;
+        if (!channel.target_node) {
+            continue;
+        }
+        if (!channel.sampler) {
+            return false;
+        }
+        cgltf_size components = 1;
+        if (channel.target_path == cgltf_animation_path_type_weights) {
+            if (!channel.target_node->mesh || !channel.target_node->mesh->primitives_count) {
+                return false;
+            }
+            components = channel.target_node->mesh->primitives[0].targets_count;
+        }
+        cgltf_size values = sampler->interpolation == cgltf_interpolation_type_cubic_spline ? 3 : 1;
+        if (sampler->input->count * components * values != sampler->output->count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns the JSON pointer of a KHR_animation_pointer channel, or an empty string. The extension is
+// not parsed by cgltf, so we extract the pointer from its raw JSON.
+static std::string_view getAnimationPointer(const cgltf_animation_channel& channel) {
+    for (cgltf_size i = 0; i < channel.extensions_count; ++i) {
+        const cgltf_extension& extension = channel.extensions[i];
+        if (!extension.name || !extension.data ||
+                strcmp(extension.name, "KHR_animation_pointer") != 0) {
+            continue;
+        }
+        const std::string_view json = extension.data;
+        size_t begin = json.find("\"pointer\"");
+        begin = begin == std::string_view::npos ? begin : json.find(':', begin);
+        begin = begin == std::string_view::npos ? begin : json.find('"', begin);
+        if (begin == std::string_view::npos) {
+            return {};
+        }
+        const size_t end = json.find('"', begin + 1);
+        const std::string_view pointer = json.substr(begin + 1, end - begin - 1);
+        // Escaped characters are not supported, since no supported pointer needs them.
+        if (end == std::string_view::npos || pointer.find('\\') != std::string_view::npos ||
+                pointer.find('~') != std::string_view::npos) {
+            return {};
+        }
+        return pointer;
+    }
+    return {};
+}
+
+// Splits a JSON pointer of the form "<prefix><index>/<property>" into its index and property.
+static bool splitPointer(std::string_view pointer, std::string_view prefix, uint32_t* index,
+        std::string_view* property) {
+    if (pointer.substr(0, prefix.size()) != prefix) {
+        return false;
+    }
+    pointer.remove_prefix(prefix.size());
+    const size_t slash = pointer.find('/');
+    if (slash == 0 || slash == std::string_view::npos) {
+        return false;
+    }
+    uint32_t value = 0;
+    for (char c : pointer.substr(0, slash)) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + uint32_t(c - '0');
+    }
+    *index = value;
+    *property = pointer.substr(slash + 1);
+    return true;
+}
+
+// Translates the JSON pointer of a KHR_animation_pointer channel into the target of a track.
+// Returns false if the target does not exist or is not supported.
+static bool getPointerTarget(const cgltf_data* gltf, std::string_view pointer,
+        AnimationClip::Track* dst) {
+    using Path = AnimationClip::Path;
+    using Property = AnimationClip::Property;
+    static constexpr std::pair<std::string_view, Path> nodePaths[] = {
+        { "translation", AnimationClip::TRANSLATION },
+        { "rotation", AnimationClip::ROTATION },
+        { "scale", AnimationClip::SCALE },
+        { "weights", AnimationClip::WEIGHTS },
+    };
+    static constexpr std::pair<std::string_view, Property> materialProperties[] = {
+        { "pbrMetallicRoughness/baseColorFactor", AnimationClip::BASE_COLOR_FACTOR },
+        { "pbrMetallicRoughness/metallicFactor", AnimationClip::METALLIC_FACTOR },
+        { "pbrMetallicRoughness/roughnessFactor", AnimationClip::ROUGHNESS_FACTOR },
+        { "emissiveFactor", AnimationClip::EMISSIVE_FACTOR },
+        { "extensions/KHR_materials_emissive_strength/emissiveStrength",
+                AnimationClip::EMISSIVE_STRENGTH },
+        { "normalTexture/scale", AnimationClip::NORMAL_SCALE },
+        { "occlusionTexture/strength", AnimationClip::OCCLUSION_STRENGTH },
+        { "alphaCutoff", AnimationClip::ALPHA_CUTOFF },
+    };
+    static constexpr std::pair<std::string_view, Property> lightProperties[] = {
+        { "color", AnimationClip::LIGHT_COLOR },
+        { "intensity", AnimationClip::LIGHT_INTENSITY },
+    };
+
+    uint32_t index;
+    std::string_view property;
+    if (splitPointer(pointer, "/nodes/", &index, &property) && index < gltf->nodes_count) {
+        for (const auto& [name, path] : nodePaths) {
+            if (property == name) {
+                dst->node = index;
+                dst->path = path;
+                return true;
+            }
+        }
+    } else if (splitPointer(pointer, "/materials/", &index, &property) &&
+            index < gltf->materials_count) {
+        for (const auto& [name, value] : materialProperties) {
+            if (property == name) {
+                dst->node = index;
+                dst->path = AnimationClip::MATERIAL;
+                dst->property = value;
+                return true;
+            }
+        }
+    } else if (splitPointer(pointer, "/extensions/KHR_lights_punctual/lights/", &index,
+            &property) && index < gltf->lights_count) {
+        for (const auto& [name, value] : lightProperties) {
+            if (property == name) {
+                dst->node = index;
+                dst->path = AnimationClip::LIGHT;
+                dst->property = value;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Checks that the sampler of a KHR_animation_pointer channel holds values of the right size for its
+// target, which validateAnimation() does not know about.
+static bool validatePointerTrack(const cgltf_data* gltf, const cgltf_animation_sampler& sampler,
+        const AnimationClip::Track& track) {
+    size_t components;
+    switch (track.path) {
+        case AnimationClip::TRANSLATION:
+        case AnimationClip::SCALE:
+            components = 3;
+            break;
+        case AnimationClip::ROTATION:
+            components = 4;
+            break;
+        case AnimationClip::WEIGHTS: {
+            const cgltf_mesh* mesh = gltf->nodes[track.node].mesh;
+            if (!mesh || !mesh->primitives_count) {
+                return false;
+            }
+            components = mesh->primitives[0].targets_count;
+            break;
+        }
+        case AnimationClip::MATERIAL:
+        case AnimationClip::LIGHT:
+            components = getComponentCount(track.property);
+            break;
+    }
+    const size_t values = sampler.interpolation == cgltf_interpolation_type_cubic_spline ? 3 : 1;
+    const size_t elementSize = cgltf_num_components(sampler.output->type);
+    if (track.path != AnimationClip::WEIGHTS && elementSize != components) {
+        return false;
+    }
+    return sampler.input->count * components * values == sampler.output->count * elementSize;
+}
+
+// Returns true if the given sampler yields the same value at any time, i.e. if all its keys have
+// the same value and, for cubic splines, if all its tangents are zero.
+static bool isConstantSampler(const Sampler& sampler) {
+    const size_t count = sampler.times.size();
+    const size_t valuesPerKey = sampler.valuesPerKey;
+    if (count < 2 || valuesPerKey == 0 || sampler.values.size() != count * valuesPerKey) {
+        return count == 1 && valuesPerKey > 0;
+    }
+    const float* values = sampler.values.data();
+    if (sampler.interpolation == Sampler::CUBIC) {
+        // Each key holds the in-tangent, then the spline vertex, then the out-tangent.
+        const size_t n = valuesPerKey / 3;
+        for (size_t key = 0; key < count; ++key) {
+            const float* src = values + key * valuesPerKey;
+            for (size_t i = 0; i < n; ++i) {
+                if (src[i] != 0.0f || src[n * 2 + i] != 0.0f || src[n + i] != values[n + i]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+    for (size_t key = 1; key < count; ++key) {
+        if (!std::equal(values, values + valuesPerKey, values + key * valuesPerKey)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static AnimationClipHandle createAnimationClip(const cgltf_data* gltf,
+        const cgltf_animation& srcAnim, bool compress, const AnimationStreamConfig* streaming) {
+    auto clip = std::make_shared<AnimationClip>();
+    if (srcAnim.name) {
+        clip->name = CString(srcAnim.name);
+    }
+
+    // Import each glTF sampler into a custom data structure.
+    const cgltf_animation_sampler* srcSamplers = srcAnim.samplers;
+    clip->samplers = FixedCapacityVector<Sampler>(srcAnim.samplers_count);
+    for (cgltf_size j = 0, nsamps = srcAnim.samplers_count; j < nsamps; ++j) {
+        Sampler& dstSampler = clip->samplers[j];
+        createSampler(srcSamplers[j], dstSampler);
+        if (dstSampler.times.size() > 1) {
+            clip->duration = std::max(clip->duration, dstSampler.times.back());
+        }
+        // The first key is all that is needed to evaluate a constant sampler at any time, which
+        // also keeps it from being compressed or streamed.
+        if (isConstantSampler(dstSampler)) {
+            dstSampler.times.resize(1);
+            dstSampler.times.shrink_to_fit();
+            dstSampler.values.resize(dstSampler.valuesPerKey);
+            dstSampler.values.shrink_to_fit();
+        }
+    }
+
+    // Record the target of each channel, which is later bound to an entity by the Animator.
+    const cgltf_animation_channel* srcChannels = srcAnim.channels;
+    clip->tracks.reserve(srcAnim.channels_count);
+    clip->targetNames.reserve(srcAnim.channels_count);
+    for (cgltf_size j = 0, nchans = srcAnim.channels_count; j < nchans; ++j) {
+        const cgltf_animation_channel& srcChannel = srcChannels[j];
+        AnimationClip::Track track;
+        if (!srcChannel.target_node) {
+            const std::string_view pointer = getAnimationPointer(srcChannel);
+            if (pointer.empty() || !srcChannel.sampler) {
+                continue;
+            }
+            if (!getPointerTarget(gltf, pointer, &track) ||
+                    !validatePointerTrack(gltf, *srcChannel.sampler, track)) {
+                GLTFIO_WARN("Unsupported animation pointer.");
+                continue;
+            }
+            track.sampler = uint32_t(srcChannel.sampler - srcSamplers);
+            clip->tracks.push_back(track);
+            const bool isNode = track.path < AnimationClip::MATERIAL;
+            clip->targetNames.push_back(isNode ?
+                    CString(getTargetName(gltf->nodes[track.node])) : CString());
+            continue;
+        }
+        if (!getTrackPath(srcChannel, &track.path)) {
+            continue;
+        }
+        track.sampler = uint32_t(srcChannel.sampler - srcSamplers);
+        track.node = uint32_t(srcChannel.target_node - gltf->nodes);
+        clip->tracks.push_back(track);
+        clip->targetNames.push_back(CString(getTargetName(*srcChannel.target_node)));
+    }
+
+    if (compress) {
+        compressSamplers(*clip);
+    }
+
+    if (streaming) {
+        clip->stream = AnimationStream::create(*clip, *streaming);
+    }
+
+    return clip;
+}
+
+AnimationClips createAnimationClips(const cgltf_data* gltf, bool compress,
+        const AnimationStreamConfig* streaming) {
+    const cgltf_animation* srcAnims = gltf->animations;
+    for (cgltf_size i = 0, len = gltf->animations_count; i < len; ++i) {
+        if (!validateAnimation(srcAnims[i])) {
+            GLTFIO_WARN("Disabling animation due to validation failure.");
+            return {};
+        }
+    }
+    AnimationClips clips(gltf->animations_count);
+    for (cgltf_size i = 0, len = gltf->animations_count; i < len; ++i) {
+        clips[i] = createAnimationClip(gltf, srcAnims[i], compress, streaming);
+    }
+    return clips;
+}
+
+} // namespace filament::gltfio
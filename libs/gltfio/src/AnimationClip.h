@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTFIO_ANIMATIONCLIP_H
+#define GLTFIO_ANIMATIONCLIP_H
+
+#include <filament/Box.h>
+
+#include <utils/CString.h>
+#include <utils/FixedCapacityVector.h>
+
+#include <math/mat4.h>
+#include <math/vec3.h>
+
+#include <memory>
+#include <vector>
+
+#include <stdint.h>
+
+struct cgltf_data;
+
+namespace filament::gltfio {
+
+class AnimationStream;
+struct AnimationStreamConfig;
+
+using TimeValues = std::vector<float>;
+using SourceValues = std::vector<float>;
+
+struct Sampler {
+    TimeValues times;
+    SourceValues values;
+    enum Interpolation : uint8_t { LINEAR, STEP, CUBIC } interpolation = LINEAR;
+
+    // Compressed samplers leave "values" empty and instead hold three 16-bit words per key; see
+    // AnimationCompression.h for the encoding. Vectors are dequantized with offset and scale.
+    std::vector<uint16_t> quantized;
+    math::float3 offset;
+    math::float3 scale;
+
+    bool isCompressed() const noexcept { return !quantized.empty(); }
+
+    // Number of floats per key in "values", e.g. 9 for a cubic spline translation.
+    uint32_t valuesPerKey = 0;
+
+    // Streamed samplers only keep the values of their first key in "values", the values of the
+    // other keys are read from the AnimationStream of their clip; see AnimationStream.h.
+    static constexpr uint32_t NOT_STREAMED = UINT32_MAX;
+    uint32_t streamIndex = NOT_STREAMED;
+
+    bool isStreamed() const noexcept { return streamIndex != NOT_STREAMED; }
+
+    // Samplers whose value never changes are reduced to their first key when the clip is created,
+    // so that Animator can resolve their channels once when it binds them.
+    bool isConstant() const noexcept { return times.size() == 1; }
+};
+
+// AnimationClip holds the decoded keyframe data for a single glTF animation definition.
+//
+// Clips are immutable after creation and are shared (via AnimationClipHandle) between all the
+// Animator objects that play them, so their memory cost does not grow with the number of
+// instances. A clip refers to its targets only through glTF node indices; it is up to Animator to
+// resolve these into entities for each instance that it drives.
+struct AnimationClip {
+    // MATERIAL and LIGHT tracks come from KHR_animation_pointer channels, which can also target
+    // the transforms and weights of nodes.
+    enum Path : uint8_t { TRANSLATION, ROTATION, SCALE, WEIGHTS, MATERIAL, LIGHT };
+
+    // Properties of materials and lights that KHR_animation_pointer channels can target.
+    enum Property : uint8_t {
+        NO_PROPERTY,
+        BASE_COLOR_FACTOR,
+        METALLIC_FACTOR,
+        ROUGHNESS_FACTOR,
+        EMISSIVE_FACTOR,
+        EMISSIVE_STRENGTH,
+        NORMAL_SCALE,
+        OCCLUSION_STRENGTH,
+        ALPHA_CUTOFF,
+        LIGHT_COLOR,
+        LIGHT_INTENSITY,
+    };
+
+    struct Track {
+        uint32_t sampler; // index into the samplers list
+        uint32_t node;    // index of the target cgltf_node, cgltf_material or cgltf_light
+        Path path;
+        Property property = NO_PROPERTY; // for MATERIAL and LIGHT tracks
+    };
+
+    utils::CString name;
+    float duration = 0.0f;
+    utils::FixedCapacityVector<Sampler> samplers;
+    utils::FixedCapacityVector<Track> tracks;
+
+    // Names of the target nodes in the source asset (one per track), which allow the clip to be
+    // retargeted to a different hierarchy by matching names. A name can be empty.
+    utils::FixedCapacityVector<utils::CString> targetNames;
+
+    // Reads the values of the streamed samplers, or null if there are none.
+    std::shared_ptr<AnimationStream> stream;
+};
+
+// Returns the number of floats in a value of the given property.
+inline size_t getComponentCount(AnimationClip::Property property) noexcept {
+    switch (property) {
+        case AnimationClip::BASE_COLOR_FACTOR: return 4;
+        case AnimationClip::EMISSIVE_FACTOR:
+        case AnimationClip::LIGHT_COLOR: return 3;
+        default: return 1;
+    }
+}
+
+using AnimationClipHandle = std::shared_ptr<const AnimationClip>;
+using AnimationClips = utils::FixedCapacityVector<AnimationClipHandle>;
+
+// Skinning palettes of an animation sampled at a fixed rate, see Animator::bakeAnimation(). Each
+// frame holds the bones of all the skinned renderables of an instance, in the order in which
+// Animator visits them. Palettes are relative to their renderable, so they are valid for every
+// instance of the asset that they were baked from.
+struct BakedAnimation {
+    float frameRate = 0.0f;
+    size_t frameCount = 0;
+    size_t bonesPerFrame = 0;
+    utils::FixedCapacityVector<math::mat4f> palettes;
+
+    // Bounding box of each skinned renderable at each frame, or empty if none of them has known
+    // joint bounds. Boxes of the renderables without joint bounds are empty.
+    size_t renderablesPerFrame = 0;
+    utils::FixedCapacityVector<Aabb> bounds;
+};
+
+using BakedAnimationHandle = std::shared_ptr<const BakedAnimation>;
+
+// Decodes all animation definitions in the given glTF hierarchy, whose buffers must be loaded.
+// If "compress" is true, eligible samplers are stored in a compressed form. If "streaming" is not
+// null, the clips that are long enough are streamed, see AnimationStream.
+// Returns an empty list if any of the animations fails validation.
+AnimationClips createAnimationClips(const cgltf_data* gltf, bool compress = false,
+        const AnimationStreamConfig* streaming = nullptr);
+
+} // namespace filament::gltfio
+
+#endif // GLTFIO_ANIMATIONCLIP_H
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AnimationCompression.h"
+
+#include <math/quat.h>
+
+#include <utils/FixedCapacityVector.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace filament::math;
+using namespace utils;
+
+namespace filament::gltfio {
+
+// Maximum error introduced by key reduction, in glTF units for translations and scales, and in
+// radians for rotations. Quantization adds a smaller error on top of this.
+static constexpr float VECTOR_TOLERANCE = 1e-4f;
+static constexpr float ROTATION_TOLERANCE = 1e-4f;
+
+// Bounds the cost of key reduction for long runs of keys that can be removed.
+static constexpr size_t MAX_REMOVED_KEYS = 255;
+
+namespace {
+
+enum SamplerUsage : uint8_t { UNUSED, TRANSLATION, ROTATION, SCALE, INELIGIBLE };
+
+struct KeyReducer {
+    const std::vector<float>& times;
+    const std::vector<float4>& keys;
+    bool isRotation;
+    bool isStep;
+
+    // Returns true if interpolating between keys "first" and "last" reconstructs key "k".
+    bool fits(size_t first, size_t last, size_t k) const noexcept {
+        if (isStep) {
+            return keys[k] == keys[first];
+        }
+        const float t = (times[k] - times[first]) / (times[last] - times[first]);
+        if (isRotation) {
+            const float4 q = slerp(quatf{ keys[first] }, quatf{ keys[last] }, t).xyzw;
+            // For small angles the chord between two unit quaternions is half the angle between
+            // the rotations they represent.
+            const float4 r = dot(q, keys[k]) < 0 ? -keys[k] : keys[k];
+            return 2.0f * length(q - r) <= ROTATION_TOLERANCE;
+        }
+        const float4 v = (1 - t) * keys[first] + t * keys[last];
+        return length(v - keys[k]) <= VECTOR_TOLERANCE;
+    }
+
+    // Returns the indices of the keys to keep, which always include the first and last keys.
+    std::vector<size_t> reduce() const {
+        const size_t count = keys.size();
+        std::vector<size_t> kept = { 0 };
+        size_t anchor = 0;
+        for (size_t last = 2; last < count; ++last) {
+            bool removable = last - anchor <= MAX_REMOVED_KEYS + 1;
+            for (size_t k = anchor + 1; k < last && removable; ++k) {
+                removable = fits(anchor, last, k);
+            }
+            if (!removable) {
+                anchor = last - 1;
+                kept.push_back(anchor);
+            }
+        }
+        kept.push_back(count - 1);
+        return kept;
+    }
+};
+
+} // anonymous namespace
+
+static uint16_t quantize(float value, float maximum) noexcept {
+    return uint16_t(std::lround(std::clamp(value, 0.0f, maximum)));
+}
+
+static void encodeRotation(float4 q, uint16_t* words) noexcept {
+    q = normalize(q);
+    size_t largest = 0;
+    for (size_t i = 1; i < 4; ++i) {
+        if (std::abs(q[i]) > std::abs(q[largest])) {
+            largest = i;
+        }
+    }
+    if (q[largest] < 0) {
+        q = -q;
+    }
+    for (size_t i = 0, j = 0; i < 4; ++i) {
+        if (i != largest) {
+            const float c = (q[i] + f::SQRT1_2) * (32767.0f / (2.0f * f::SQRT1_2));
+            words[j++] = uint16_t(quantize(c, 32767.0f) << 1u);
+        }
+    }
+    words[0] |= uint16_t(largest & 1u);
+    words[1] |= uint16_t(largest >> 1u);
+}
+
+static void compressSampler(Sampler& sampler, SamplerUsage usage) {
+    const bool isRotation = usage == ROTATION;
+    const size_t components = isRotation ? 4 : 3;
+    const size_t count = sampler.times.size();
+    if (count < 2 || sampler.values.size() != count * components) {
+        return;
+    }
+
+    std::vector<float4> keys(count);
+    for (size_t i = 0; i < count; ++i) {
+        const float* src = sampler.values.data() + i * components;
+        keys[i] = isRotation ? float4{ src[0], src[1], src[2], src[3] } :
+                float4{ src[0], src[1], src[2], 0 };
+    }
+
+    const KeyReducer reducer = { sampler.times, keys, isRotation,
+            sampler.interpolation == Sampler::STEP };
+    const std::vector<size_t> kept = reducer.reduce();
+
+    TimeValues times(kept.size());
+    std::vector<uint16_t> quantized(kept.size() * 3);
+    if (isRotation) {
+        for (size_t i = 0; i < kept.size(); ++i) {
+            times[i] = sampler.times[kept[i]];
+            encodeRotation(keys[kept[i]], quantized.data() + i * 3);
+        }
+    } else {
+        float3 minimum = keys[0].xyz;
+        float3 maximum = keys[0].xyz;
+        for (size_t index : kept) {
+            minimum = min(minimum, keys[index].xyz);
+            maximum = max(maximum, keys[index].xyz);
+        }
+        const float3 extent = maximum - minimum;
+        sampler.offset = minimum;
+        sampler.scale = extent / 65535.0f;
+        for (size_t i = 0; i < kept.size(); ++i) {
+            times[i] = sampler.times[kept[i]];
+            const float3 v = keys[kept[i]].xyz - minimum;
+            for (size_t c = 0; c < 3; ++c) {
+                quantized[i * 3 + c] = extent[c] > 0 ?
+                        quantize(v[c] / extent[c] * 65535.0f, 65535.0f) : 0;
+            }
+        }
+    }
+
+    sampler.times = std::move(times);
+    sampler.quantized = std::move(quantized);
+    sampler.values = {};
+}
+
+void compressSamplers(AnimationClip& clip) {
+    // A sampler can be shared by several tracks, in which case they must all agree on its usage.
+    FixedCapacityVector<SamplerUsage> usages(clip.samplers.size(), UNUSED);
+    for (const AnimationClip::Track& track : clip.tracks) {
+        SamplerUsage usage = INELIGIBLE;
+        switch (track.path) {
+            case AnimationClip::TRANSLATION: usage = TRANSLATION; break;
+            case AnimationClip::ROTATION: usage = ROTATION; break;
+            case AnimationClip::SCALE: usage = SCALE; break;
+            case AnimationClip::WEIGHTS:
+            case AnimationClip::MATERIAL:
+            case AnimationClip::LIGHT: break;
+        }
+        SamplerUsage& dst = usages[track.sampler];
+        dst = dst == UNUSED || dst == usage ? usage : INELIGIBLE;
+    }
+
+    for (size_t i = 0, n = clip.samplers.size(); i < n; ++i) {
+        Sampler& sampler = clip.samplers[i];
+        if (usages[i] == UNUSED || usages[i] == INELIGIBLE ||
+                sampler.interpolation == Sampler::CUBIC) {
+            continue;
+        }
+        compressSampler(sampler, usages[i]);
+    }
+}
+
+} // namespace filament::gltfio
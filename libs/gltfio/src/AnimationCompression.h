@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTFIO_ANIMATIONCOMPRESSION_H
+#define GLTFIO_ANIMATIONCOMPRESSION_H
+
+#include "AnimationClip.h"
+
+#include <math/scalar.h>
+#include <math/vec3.h>
+#include <math/vec4.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament::gltfio {
+
+// Compressed samplers store three 16-bit words per key.
+//
+// Translations and scales are quantized over the range of the sampler: each word holds one
+// component, and the dequantized value is offset + scale * word.
+//
+// Rotations use the "smallest three" encoding: the largest component (in absolute value) is
+// dropped and recovered from the unit length constraint, after flipping the sign of the
+// quaternion to make it positive. The other three components lie within [-1/sqrt(2), 1/sqrt(2)]
+// and are stored in the upper 15 bits of each word, while the index of the dropped component is
+// stored in the lowest bit of the first two words. The resulting precision is about 5e-5.
+
+// Removes redundant keys from the eligible samplers of the given clip (i.e. the linear and step
+// samplers that drive translations, rotations or scales), then quantizes their values.
+void compressSamplers(AnimationClip& clip);
+
+inline math::float4 decodeVector(const Sampler& sampler, size_t key) noexcept {
+    const uint16_t* words = sampler.quantized.data() + key * 3;
+    const math::float3 value = sampler.offset + sampler.scale * math::float3{
+            words[0], words[1], words[2] };
+    return { value, 0 };
+}
+
+inline math::float4 decodeRotation(const Sampler& sampler, size_t key) noexcept {
+    constexpr float QUANTIZER = 2.0f * math::f::SQRT1_2 / 32767.0f;
+    const uint16_t* words = sampler.quantized.data() + key * 3;
+    const size_t largest = (words[0] & 1u) | ((words[1] & 1u) << 1u);
+    math::float4 q;
+    float sum = 0;
+    for (size_t i = 0, j = 0; i < 4; ++i) {
+        if (i != largest) {
+            const float c = float(words[j++] >> 1u) * QUANTIZER - math::f::SQRT1_2;
+            q[i] = c;
+            sum += c * c;
+        }
+    }
+    q[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+    return q;
+}
+
+} // namespace filament::gltfio
+
+#endif // GLTFIO_ANIMATIONCOMPRESSION_H
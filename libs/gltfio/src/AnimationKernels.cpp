@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AnimationKernels.h"
+
+#include <cmath>
+
+using namespace filament::math;
+
+namespace filament::gltfio::kernels {
+
+void lerp(float4* UTILS_RESTRICT out,
+        float4 const* UTILS_RESTRICT a,
+        float4 const* UTILS_RESTRICT b,
+        float const* UTILS_RESTRICT t, size_t count) noexcept {
+    #pragma clang loop vectorize(enable)
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (1 - t[i]) * a[i] + t[i] * b[i];
+    }
+}
+
+void slerp(float4* UTILS_RESTRICT out,
+        float4 const* UTILS_RESTRICT a,
+        float4 const* UTILS_RESTRICT b,
+        float const* UTILS_RESTRICT t, size_t count) noexcept {
+    // This corrects the interpolant of a normalized lerp with a polynomial fit of the slerp
+    // curve, which depends on the angle between the two quaternions (i.e. their dot product).
+    // See "Approximating slerp" by Arseny Kapoulkine.
+    #pragma clang loop vectorize(enable)
+    for (size_t i = 0; i < count; i++) {
+        const float ca = dot(a[i], b[i]);
+        const float d = std::abs(ca);
+        const float A = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+        const float B = 0.848013f + d * (-1.06021f + d * 0.215638f);
+        const float h = t[i] - 0.5f;
+        const float k = A * h * h + B;
+        const float ot = t[i] + t[i] * h * (t[i] - 1) * k;
+        const float lt = 1 - ot;
+        const float rt = std::copysign(ot, ca);
+        const float4 q = lt * a[i] + rt * b[i];
+        out[i] = q * (1 / std::sqrt(dot(q, q)));
+    }
+}
+
+void cubicSpline(float4* UTILS_RESTRICT out,
+        float4 const* UTILS_RESTRICT vert0,
+        float4 const* UTILS_RESTRICT tang0,
+        float4 const* UTILS_RESTRICT vert1,
+        float4 const* UTILS_RESTRICT tang1,
+        float const* UTILS_RESTRICT t, size_t count) noexcept {
+    #pragma clang loop vectorize(enable)
+    for (size_t i = 0; i < count; i++) {
+        const float tt = t[i] * t[i], ttt = tt * t[i];
+        const float s2 = -2 * ttt + 3 * tt, s3 = ttt - tt;
+        const float s0 = 1 - s2, s1 = s3 - tt + t[i];
+        out[i] = s0 * vert0[i] + s1 * tang0[i] * t[i] + s2 * vert1[i] + s3 * tang1[i] * t[i];
+    }
+}
+
+void normalize(float4* UTILS_RESTRICT inout, size_t count) noexcept {
+    #pragma clang loop vectorize(enable)
+    for (size_t i = 0; i < count; i++) {
+        inout[i] *= 1 / std::sqrt(dot(inout[i], inout[i]));
+    }
+}
+
+} // namespace filament::gltfio::kernels
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTFIO_ANIMATIONKERNELS_H
+#define GLTFIO_ANIMATIONKERNELS_H
+
+#include <math/vec4.h>
+
+#include <utils/compiler.h>
+
+#include <stddef.h>
+
+namespace filament::gltfio::kernels {
+
+// Batched interpolation routines used by Animator.
+//
+// Each routine processes "count" independent channels, whose inputs have been gathered into
+// contiguous arrays. Translations and scales are stored in the xyz components of a float4 and
+// quaternions are stored as xyzw, so that every element fills exactly one SIMD register. The
+// loops are simple enough to be vectorized by the compiler on both SSE and NEON.
+
+// out = (1 - t) * a + t * b
+void lerp(math::float4* UTILS_RESTRICT out,
+        math::float4 const* UTILS_RESTRICT a,
+        math::float4 const* UTILS_RESTRICT b,
+        float const* UTILS_RESTRICT t, size_t count) noexcept;
+
+// Approximates slerp(a, b, t) for unit quaternions, taking the short path. Unlike math::slerp,
+// this is branchless and does not use any trigonometric function. The angular error compared to
+// math::slerp is at most about 1e-3 radians for arbitrary pairs of quaternions, and it is much
+// smaller for the nearby keyframes typically found in animations.
+void slerp(math::float4* UTILS_RESTRICT out,
+        math::float4 const* UTILS_RESTRICT a,
+        math::float4 const* UTILS_RESTRICT b,
+        float const* UTILS_RESTRICT t, size_t count) noexcept;
+
+// Same as gltfio::cubicSpline(), applied to each element.
+void cubicSpline(math::float4* UTILS_RESTRICT out,
+        math::float4 const* UTILS_RESTRICT vert0,
+        math::float4 const* UTILS_RESTRICT tang0,
+        math::float4 const* UTILS_RESTRICT vert1,
+        math::float4 const* UTILS_RESTRICT tang1,
+        float const* UTILS_RESTRICT t, size_t count) noexcept;
+
+// Normalizes each element in place.
+void normalize(math::float4* UTILS_RESTRICT inout, size_t count) noexcept;
+
+} // namespace filament::gltfio::kernels
+
+#endif // GLTFIO_ANIMATIONKERNELS_H
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AnimationStream.h"
+#include "AnimationClip.h"
+
+#include <utils/Log.h>
+#include <utils/debug.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace utils;
+
+namespace filament::gltfio {
+
+// fseek() takes a long, which only has 32 bits on Windows.
+static bool seek(FILE* file, uint64_t offset) {
+#if defined(WIN32)
+    return _fseeki64(file, int64_t(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, off_t(offset), SEEK_SET) == 0;
+#endif
+}
+
+std::shared_ptr<AnimationStream> AnimationStream::create(AnimationClip& clip,
+        const AnimationStreamConfig& config) {
+    if (config.chunkDuration <= 0.0f || clip.duration <= 0.0f ||
+            clip.duration < config.minDuration) {
+        return nullptr;
+    }
+
+    // Compressed samplers are small enough to stay in memory.
+    std::vector<uint32_t> streamed;
+    for (uint32_t i = 0, n = clip.samplers.size(); i < n; ++i) {
+        const Sampler& sampler = clip.samplers[i];
+        if (!sampler.isCompressed() && sampler.times.size() > 1 && sampler.valuesPerKey > 0) {
+            streamed.push_back(i);
+        }
+    }
+    if (streamed.empty()) {
+        return nullptr;
+    }
+
+    const size_t chunkCount = std::max(size_t(1),
+            size_t(std::ceil(clip.duration / config.chunkDuration)));
+    const size_t samplerCount = streamed.size();
+
+    // Each chunk starts at the last key that is not after its start time, so that it also holds
+    // the key that precedes the first key within its time range.
+    std::vector<uint32_t> firstKeys(samplerCount * (chunkCount + 1));
+    for (size_t s = 0; s < samplerCount; ++s) {
+        const TimeValues& times = clip.samplers[streamed[s]].times;
+        uint32_t* dst = firstKeys.data() + s * (chunkCount + 1);
+        dst[0] = 0;
+        for (size_t c = 1; c < chunkCount; ++c) {
+            const float start = float(c) * config.chunkDuration;
+            const size_t next = std::upper_bound(times.begin(), times.end(), start) - times.begin();
+            dst[c] = uint32_t(std::min(next ? next - 1 : 0, times.size() - 1));
+        }
+        dst[chunkCount] = uint32_t(times.size() - 1);
+    }
+
+    FILE* file = tmpfile();
+    if (!file) {
+        slog.w << "Unable to create the file of a streamed animation." << io::endl;
+        return nullptr;
+    }
+
+    std::vector<uint32_t> samplerOffsets(chunkCount * samplerCount);
+    std::vector<uint64_t> chunkOffsets(chunkCount + 1);
+    uint64_t fileOffset = 0;
+    for (size_t c = 0; c < chunkCount; ++c) {
+        chunkOffsets[c] = fileOffset;
+        uint32_t samplerOffset = 0;
+        for (size_t s = 0; s < samplerCount; ++s) {
+            const Sampler& sampler = clip.samplers[streamed[s]];
+            const uint32_t* keys = firstKeys.data() + s * (chunkCount + 1);
+            const size_t count = (keys[c + 1] - keys[c] + 1) * sampler.valuesPerKey;
+            const float* src = sampler.values.data() + keys[c] * sampler.valuesPerKey;
+            if (fwrite(src, sizeof(float), count, file) != count) {
+                slog.w << "Unable to write the file of a streamed animation." << io::endl;
+                fclose(file);
+                return nullptr;
+            }
+            samplerOffsets[c * samplerCount + s] = samplerOffset;
+            samplerOffset += uint32_t(count);
+        }
+        fileOffset += samplerOffset;
+    }
+    chunkOffsets[chunkCount] = fileOffset;
+    fflush(file);
+
+    // Only keep the first key, which additive layers are relative to.
+    for (size_t s = 0; s < samplerCount; ++s) {
+        Sampler& sampler = clip.samplers[streamed[s]];
+        sampler.values.resize(sampler.valuesPerKey);
+        sampler.values.shrink_to_fit();
+        sampler.streamIndex = uint32_t(s);
+    }
+
+    std::shared_ptr<AnimationStream> stream(
+            new AnimationStream(config.jobSystem, file, chunkCount, samplerCount));
+    stream->mFirstKeys = std::move(firstKeys);
+    stream->mSamplerOffsets = std::move(samplerOffsets);
+    stream->mChunkOffsets = std::move(chunkOffsets);
+    return stream;
+}
+
+AnimationStream::AnimationStream(JobSystem* js, FILE* file, size_t chunkCount,
+        size_t samplerCount)
+        : mJobSystem(js), mFile(file), mChunkCount(chunkCount), mSamplerCount(samplerCount),
+          mChunks(chunkCount) {
+}
+
+AnimationStream::~AnimationStream() {
+    // Temporary files are removed when they are closed.
+    fclose(mFile);
+}
+
+AnimationStream::Window AnimationStream::acquire(uint32_t streamIndex, size_t key) {
+    assert_invariant(streamIndex < mSamplerCount);
+    const uint32_t* firstKeys = mFirstKeys.data() + streamIndex * (mChunkCount + 1);
+    const size_t index = std::upper_bound(firstKeys, firstKeys + mChunkCount, uint32_t(key)) -
+            firstKeys - 1;
+
+    ChunkHandle chunk;
+    ChunkHandle next;
+    {
+        std::lock_guard<std::mutex> guard(mLock);
+        chunk = mChunks[index].lock();
+        if (!chunk) {
+            chunk = std::make_shared<Chunk>();
+            chunk->index = index;
+            mChunks[index] = chunk;
+        } else {
+            // A playhead reached the chunk that was read ahead for it.
+            auto pos = std::find(mPrefetched.begin(), mPrefetched.end(), chunk);
+            if (pos != mPrefetched.end()) {
+                mPrefetched.erase(pos);
+            }
+        }
+
+        const size_t nextIndex = (index + 1) % mChunkCount;
+        if (nextIndex != index && mChunks[nextIndex].expired()) {
+            next = std::make_shared<Chunk>();
+            next->index = nextIndex;
+            mChunks[nextIndex] = next;
+            if (mPrefetched.size() == MAX_PREFETCHED_CHUNKS) {
+                mPrefetched.erase(mPrefetched.begin());
+            }
+            mPrefetched.push_back(next);
+        }
+    }
+
+    // Jobs can only be run from the threads of the JobSystem, so when there is none or when the
+    // animation is applied from another thread, the next chunk is read by the first channel that
+    // needs it. The job extends the lifetime of neither the stream nor the chunk, which may have
+    // been dropped from the chunks read ahead by the time it runs.
+    if (next && mJobSystem && mJobSystem->isThreadOwned()) {
+        JobSystem& js = *mJobSystem;
+        js.run(js.createJob(nullptr,
+                [stream = weak_from_this(), chunk = std::weak_ptr<Chunk>(next)](
+                        JobSystem&, JobSystem::Job*) {
+                    auto self = stream.lock();
+                    auto target = chunk.lock();
+                    if (self && target) {
+                        self->load(*target);
+                    }
+                }), JobSystem::Lane::BACKGROUND);
+    }
+
+    load(*chunk);
+    return {
+        chunk,
+        chunk->values.data() + mSamplerOffsets[index * mSamplerCount + streamIndex],
+        firstKeys[index],
+        firstKeys[index + 1],
+    };
+}
+
+size_t AnimationStream::getResidentChunkCount() const {
+    std::lock_guard<std::mutex> guard(mLock);
+    return std::count_if(mChunks.begin(), mChunks.end(),
+            [](const std::weak_ptr<Chunk>& chunk) { return !chunk.expired(); });
+}
+
+void AnimationStream::load(Chunk& chunk) {
+    if (chunk.loaded.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(chunk.lock);
+    if (chunk.loaded.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const uint64_t begin = mChunkOffsets[chunk.index];
+    const uint64_t end = mChunkOffsets[chunk.index + 1];
+    chunk.values.resize(end - begin);
+    bool success;
+    {
+        std::lock_guard<std::mutex> fileGuard(mFileLock);
+        success = seek(mFile, begin * sizeof(float)) &&
+                fread(chunk.values.data(), sizeof(float), chunk.values.size(), mFile) ==
+                        chunk.values.size();
+    }
+    if (UTILS_UNLIKELY(!success)) {
+        slog.e << "Unable to read a chunk of a streamed animation." << io::endl;
+        std::fill(chunk.values.begin(), chunk.values.end(), 0.0f);
+    }
+    chunk.loaded.store(true, std::memory_order_release);
+}
+
+} // namespace filament::gltfio
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTFIO_ANIMATIONSTREAM_H
+#define GLTFIO_ANIMATIONSTREAM_H
+
+#include <utils/JobSystem.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+namespace filament::gltfio {
+
+struct AnimationClip;
+
+// Settings of the clips that are streamed, see ResourceConfiguration.
+struct AnimationStreamConfig {
+    utils::JobSystem* jobSystem;
+    float minDuration;      // clips that last at least this long are streamed
+    float chunkDuration;    // duration of each chunk, in seconds
+};
+
+// Keeps the keyframe values of a long animation clip in a sidecar file rather than in memory.
+//
+// The timeline of the clip is divided into chunks of a fixed duration. A chunk holds the values of
+// all the streamed samplers over its time range, plus the key that follows it, so that any pair of
+// consecutive keys is found within a single chunk. Key times stay in memory since they are needed
+// to find keys, as do the values of the first key, which are the reference of additive layers.
+//
+// Channels hold the chunk of their current keys through a Window. A chunk is read from the file
+// when a channel first needs it, unless it has already been read ahead: whenever a chunk is
+// acquired, the next one (wrapping around, since clips usually loop) is read on the JobSystem.
+// Reading ahead only happens when the chunk is acquired from a thread of the JobSystem; on other
+// threads, the next chunk is read when a channel first needs it.
+// Chunks are released once no channel holds them, i.e. once all the playheads have moved past,
+// so the memory cost depends on the chunk duration and the number of playheads, but not on the
+// duration of the clip.
+//
+// All methods are thread safe, so that animators can be evaluated by concurrent jobs.
+class AnimationStream : public std::enable_shared_from_this<AnimationStream> {
+public:
+    struct Chunk {
+        std::atomic<bool> loaded{ false };
+        std::mutex lock;
+        size_t index = 0;
+        std::vector<float> values;
+    };
+    using ChunkHandle = std::shared_ptr<Chunk>;
+
+    // The values of the keys firstKey through lastKey of a streamed sampler.
+    struct Window {
+        ChunkHandle chunk;
+        const float* values = nullptr;
+        uint32_t firstKey = 0;
+        uint32_t lastKey = 0;
+    };
+
+    // Moves the values of the eligible samplers of the given clip into a temporary file, except
+    // for the values of their first key, and returns the stream that reads them back. Returns null
+    // if the clip has nothing to stream or if the file cannot be created, in which case the clip is
+    // left untouched. This must be called before the clip is shared.
+    static std::shared_ptr<AnimationStream> create(AnimationClip& clip,
+            const AnimationStreamConfig& config);
+
+    ~AnimationStream();
+
+    AnimationStream(AnimationStream const&) = delete;
+    AnimationStream& operator=(AnimationStream const&) = delete;
+
+    // Returns the chunk that holds the given key of a streamed sampler, and the key that follows
+    // it. This blocks until the chunk has been read.
+    Window acquire(uint32_t streamIndex, size_t key);
+
+    size_t getChunkCount() const noexcept { return mChunkCount; }
+
+    // Number of chunks that are currently in memory, including those that are being read ahead.
+    size_t getResidentChunkCount() const;
+
+private:
+    // Maximum number of chunks read ahead for playheads that have not reached them yet.
+    static constexpr size_t MAX_PREFETCHED_CHUNKS = 4;
+
+    AnimationStream(utils::JobSystem* js, FILE* file, size_t chunkCount, size_t samplerCount);
+
+    void load(Chunk& chunk);
+
+    utils::JobSystem* const mJobSystem;
+    FILE* const mFile;
+    std::mutex mFileLock;
+    const size_t mChunkCount;
+    const size_t mSamplerCount;
+
+    // First key of each streamed sampler in each chunk, i.e. mChunkCount + 1 keys per sampler
+    // where the last one is the last key of the sampler.
+    std::vector<uint32_t> mFirstKeys;
+
+    // Offset of the values of each streamed sampler within each chunk, in floats, i.e.
+    // mSamplerCount offsets per chunk.
+    std::vector<uint32_t> mSamplerOffsets;
+
+    // Offset of each chunk within the file in floats, followed by the size of the file.
+    std::vector<uint64_t> mChunkOffsets;
+
+    mutable std::mutex mLock;
+    std::vector<std::weak_ptr<Chunk>> mChunks;
+    std::vector<ChunkHandle> mPrefetched; // oldest first
+};
+
+} // namespace filament::gltfio
+
+#endif // GLTFIO_ANIMATIONSTREAM_H
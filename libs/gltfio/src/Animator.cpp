@@ -17,16 +17,27 @@
 #include <gltfio/Animator.h>
 #include <gltfio/math.h>
 
+#include "AnimationClip.h"
+#include "AnimationCompression.h"
+#include "AnimationKernels.h"
+#include "AnimationStream.h"
 #include "FFilamentAsset.h"
 #include "FFilamentInstance.h"
 #include "FTrsTransformManager.h"
 #include "downcast.h"
 
+#include <filament/LightManager.h>
+#include <filament/Material.h>
+#include <filament/MaterialInstance.h>
 #include <filament/VertexBuffer.h>
 #include <filament/RenderableManager.h>
+#include <filament/SkinningBuffer.h>
 #include <filament/TransformManager.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Log.h>
+#include <utils/Panic.h>
+#include <utils/Systrace.h>
 
 #include <math/mat4.h>
 #include <math/quat.h>
@@ -34,8 +45,15 @@
 #include <math/vec3.h>
 #include <math/vec4.h>
 
-#include <map>
-#include <string>
+#include <tsl/robin_map.h>
+#include <tsl/robin_set.h>
+
+#include <cgltf.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <string_view>
 #include <vector>
 
 using namespace filament;
@@ -45,215 +63,463 @@ using namespace utils;
 
 namespace filament::gltfio {
 
-using TimeValues = map<float, size_t>;
-using SourceValues = vector<float>;
 using BoneVector = vector<mat4f>;
 
-struct Sampler {
-    TimeValues times;
-    SourceValues values;
-    enum { LINEAR, STEP, CUBIC } interpolation;
+// Number of animators that are processed by a single job in the batched entry points.
+static constexpr size_t JOBS_PARALLEL_FOR_ANIMATIONS_COUNT = 4;
+
+// Kind of value that a channel yields, which together with the interpolation of its sampler
+// determines how the channel is evaluated.
+enum ValueType : uint8_t {
+    VECTOR,             // translation or scale
+    ROTATION,
+    QUANTIZED_VECTOR,   // compressed translation or scale
+    QUANTIZED_ROTATION, // compressed rotation
+    PROPERTY,           // material or light property
+    WEIGHTS,
+    VALUE_TYPE_COUNT
 };
 
+// The channels of an animation are sorted into homogeneous groups, each of which is evaluated by
+// a loop that is specialized for the interpolation and the value type of its channels, so that
+// none of them is decided channel by channel. The transforms and properties of constant samplers
+// need neither a key lookup nor an interpolation, so they have their own groups. The other groups
+// are numbered FIRST_SAMPLED_GROUP + interpolation * VALUE_TYPE_COUNT + value type.
+enum ChannelGroup : uint8_t { CONSTANT_TRANSFORM, CONSTANT_PROPERTY, FIRST_SAMPLED_GROUP };
+static constexpr size_t CHANNEL_GROUP_COUNT = FIRST_SAMPLED_GROUP + 3 * VALUE_TYPE_COUNT;
+
 struct Channel {
     const Sampler* sourceData;
     Entity targetEntity;
-    enum { TRANSLATION, ROTATION, SCALE, WEIGHTS } transformType;
+    AnimationClip::Path transformType;
+
+    // Index of the keyframe found by the most recent lookup, used as a starting point for the next
+    // one. Playheads typically move forward by a small amount each frame, so this is usually
+    // either the correct keyframe or only a few steps away from it.
+    size_t cursor = 0;
+
+    // True if the target is excluded by the mask of the current level of detail.
+    bool culled = false;
+
+    // For morph weight channels, index of the slot that holds the weights of the target.
+    uint32_t morphSlot = 0;
+
+    // For transform channels, index of the slot that holds the pending local transform of the
+    // target.
+    uint32_t transformSlot = 0;
+
+    // For material and light channels, index of the slot that holds the pending property value.
+    uint32_t propertySlot = 0;
+
+    // For streamed samplers, the chunk that holds the keys of the most recent lookup.
+    AnimationStream* stream = nullptr;
+    AnimationStream::Window window;
+
+    // See ChannelGroup.
+    uint8_t group = 0;
+
+    // For the channels of the constant groups, the value of their sampler.
+    float4 constantValue;
 };
 
+// Binds the shared data of an animation clip to the entities of one or more instances.
 struct Animation {
-    float duration;
-    std::string name;
-    vector<Sampler> samplers;
+    static constexpr uint32_t UNBOUND_NODE = std::numeric_limits<uint32_t>::max();
+
+    AnimationClipHandle clip;
+
+    // Sorted by group, where the channels of group i start at groupOffsets[i].
     vector<Channel> channels;
+    uint32_t groupOffsets[CHANNEL_GROUP_COUNT + 1] = {};
+
+    // For retargeted clips, this holds the index of the node that each track drives in this
+    // asset, or UNBOUND_NODE. Otherwise this is empty and the clip's own node indices are used.
+    FixedCapacityVector<uint32_t> targetNodes;
+
+    // Sorted list of the entities whose transform is driven by this animation, computed on demand.
+    vector<Entity> transformTargets;
+    bool transformTargetsDirty = true;
+};
+
+// The members of a group of instances that share their bones, other than its leader, never
+// compute nor write bones.
+static bool isSkinningFollower(FFilamentInstance const* instance) noexcept {
+    return instance->mSharedSkinning && instance->mSharedSkinning->leader != instance;
+}
+
+// A skinned renderable and the range of its bones within the palette of a baked animation. All
+// instances share the same palette, so offsets restart from zero at each instance.
+struct SkinnedRenderable {
+    RenderableManager::Instance renderable;
+    size_t offset;
+    size_t boneCount;
+    SkinningBuffer* sharedBuffer;   // see SharedSkinning
+    size_t index;                   // position within the renderables of the instance
+    FFilamentAsset::JointBounds const* jointBounds; // null if the bounds are unknown
+};
+
+// Local transform of a node, in the form used by TrsTransformManager.
+struct TrsStash {
+    float3 translation;
+    quatf rotation;
+    float3 scale;
 };
 
 struct AnimatorImpl {
     vector<Animation> animations;
+    Animator::Stats stats;
     BoneVector boneMatrices;
     FFilamentAsset const* asset = nullptr;
     FFilamentInstance* instance = nullptr;
     RenderableManager* renderableManager;
     TransformManager* transformManager;
-    TrsTransformManager* trsTransformManager;
+    LightManager* lightManager;
+    FTrsTransformManager* trsTransformManager;
     vector<float> weights;
-    FixedCapacityVector<mat4f> crossFade;
-    void addChannels(const FixedCapacityVector<Entity>& nodeMap, const cgltf_animation& srcAnim,
-            Animation& dst);
-    void applyAnimation(const Channel& channel, float t, size_t prevIndex, size_t nextIndex);
-    void stashCrossFade();
-    void applyCrossFade(float alpha);
+    vector<TrsStash> crossFade;
+    void addChannels(const FixedCapacityVector<Entity>& nodeMap, Animation& dst);
+    void groupChannels(Animation& anim);
+    void addAnimation(AnimationClipHandle clip, FixedCapacityVector<uint32_t> targetNodes = {});
+    FixedCapacityVector<uint32_t> resolveTargetsByName(const AnimationClip& clip,
+            const Animator::NameMapping* remap, size_t remapCount) const;
+    void applyAnimation(size_t animationIndex, float time, bool deferMorphWeights);
+    void sampleAnimation(size_t animationIndex, float time, bool deferMorphWeights);
+    void sampleAnimationAtInterval(size_t animationIndex, float time, bool deferMorphWeights);
+    void setLevelOfDetail(const Animator::LevelOfDetail& lod);
+    void bakeAnimation(size_t animationIndex, float frameRate);
+    void applyBakedAnimation(const BakedAnimation& baked, float duration, float time);
+    const vector<SkinnedRenderable>& getSkinnedRenderables();
+    void sampleChannels(Animation& anim, float time, float transformTime,
+            const Animator::AnimationLayer* layer);
+    template<Sampler::Interpolation I, ValueType V>
+    void sampleGroup(Channel* begin, Channel* end, float time,
+            const Animator::AnimationLayer* layer);
+    template<ValueType V>
+    void sampleConstantGroup(Channel* begin, Channel* end, float time,
+            const Animator::AnimationLayer* layer);
+    bool isMasked(const Channel& channel, const Animator::AnimationLayer* layer) const;
+    void evaluateChannelBatches();
+    void clearChannelBatches();
+    void applyChannelBatches();
+    uint32_t getTransformSlot(Entity entity);
+    void flushTransforms();
+    template<Sampler::Interpolation I>
+    void applyMorphWeights(const Channel& channel, float t, size_t prevIndex, size_t nextIndex);
+    uint32_t getMorphSlot(Entity entity, size_t count);
+    void flushMorphWeights();
+    bool bindProperty(const FixedCapacityVector<Entity>& nodeMap, const AnimationClip::Track& track,
+            Channel& dst);
+    void writeProperty(const Channel& channel, float4 value);
+    void flushProperties();
+    void applyAnimationLayers(const Animator::AnimationLayer* layers, size_t count);
+    void accumulateTransform(const Channel& channel, float4 value,
+            const Animator::AnimationLayer& layer);
+    void accumulateMorphWeights(const Channel& channel, const Animator::AnimationLayer& layer);
+    void captureRestPose(const FixedCapacityVector<Entity>& nodeMap);
+    const vector<Entity>& getTransformTargets(Animation& anim);
+    void stashCrossFade(size_t previousAnimIndex);
+    void applyCrossFade(size_t previousAnimIndex, float alpha);
     void resetBoneMatrices(FFilamentInstance* instance);
-    void updateBoneMatrices(FFilamentInstance* instance);
+    SkinningBuffer* getSharedBuffer(FFilamentInstance const* instance, Entity entity) const;
+    void setBones(SkinningBuffer* sharedBuffer, RenderableManager::Instance renderable,
+            const mat4f* bones, size_t count, size_t offset = 0);
+    void computeBoneMatrices();
+    void computeBoneMatrices(FFilamentInstance* instance, bool accurate);
+    void uploadBoneMatrices();
+
+    // Morph weights of each renderable targeted by a weights channel, stored in a flat buffer
+    // that is allocated when the channels are bound. Sampling merely writes into this buffer, so
+    // it can happen in a job, while setMorphWeights is called once per modified renderable.
+    struct MorphSlot {
+        Entity entity;
+        uint32_t offset;
+        uint32_t count;
+        bool dirty;
+    };
+    vector<MorphSlot> morphSlots;
+    vector<float> morphWeights;
+    vector<uint32_t> dirtyMorphSlots;
+    tsl::robin_map<Entity, uint32_t, Entity::Hasher> morphSlotIndices;
+
+    // Material parameters and light properties targeted by KHR_animation_pointer channels. Like
+    // morph weights, these are sampled into their slot and only applied once all channels have
+    // been evaluated, since MaterialInstance and LightManager cannot be used from jobs.
+    struct PropertySlot {
+        AnimationClip::Property property;
+        vector<MaterialInstance*> materials;
+        vector<Entity> lights;
+        float scale;    // applied to the emissive factor, see bindProperty()
+        float4 value;
+        bool dirty;
+    };
+    vector<PropertySlot> propertySlots;
+    vector<uint32_t> dirtyPropertySlots;
+
+    // Local transforms of the nodes targeted by translation, rotation or scale channels. Channels
+    // only write the components they animate into their slot, and each modified node then has
+    // its matrix composed and set once, however many of its channels were evaluated.
+    enum : uint8_t { TRANSLATION_BIT = 1, ROTATION_BIT = 2, SCALE_BIT = 4, TRS_BITS = 7 };
+    struct TransformSlot {
+        Entity entity;
+        TrsStash trs;
+        uint8_t dirty;
+    };
+    vector<TransformSlot> transformSlots;
+    vector<uint32_t> dirtyTransformSlots;
+    tsl::robin_map<Entity, uint32_t, Entity::Hasher> transformSlotIndices;
+
+    // Translation, rotation and scale channels are not evaluated one by one; instead their
+    // keyframes are gathered into structure-of-arrays batches that share an interpolation kernel,
+    // so that each batch can be evaluated with a single vectorized loop. The CONSTANT batch merely
+    // holds the values of constant channels in vert0.
+    enum BatchKind { LINEAR, CUBIC, LINEAR_ROTATION, CUBIC_ROTATION, CONSTANT, BATCH_COUNT };
+    struct ChannelBatch {
+        vector<const Channel*> channels;
+        vector<float4> vert0;
+        vector<float4> tang0; // cubic only
+        vector<float4> vert1;
+        vector<float4> tang1; // cubic only
+        vector<float> t;
+        vector<float4> results;
+    };
+    ChannelBatch batches[BATCH_COUNT];
+
+    using GroupSampler = void (AnimatorImpl::*)(Channel* begin, Channel* end, float time,
+            const Animator::AnimationLayer* layer);
+    static const GroupSampler GROUP_SAMPLERS[CHANNEL_GROUP_COUNT];
+
+    // Local transforms of all nodes at the time they were bound, which is the starting point of
+    // layered blends.
+    tsl::robin_map<Entity, TrsStash, Entity::Hasher> restPose;
+
+    // Poses accumulated by applyAnimationLayers, each written once all layers have been evaluated.
+    struct LayeredTransform {
+        Entity entity;
+        TrsStash trs;
+    };
+    struct LayeredMorphWeights {
+        Entity entity;
+        vector<float> weights;
+    };
+    vector<LayeredTransform> layeredTransforms;
+    vector<LayeredMorphWeights> layeredMorphWeights;
+    tsl::robin_map<Entity, uint32_t, Entity::Hasher> layeredTransformIndices;
+    tsl::robin_map<Entity, uint32_t, Entity::Hasher> layeredMorphWeightIndices;
+    tsl::robin_set<Entity, Entity::Hasher> layerMask;
+    vector<float> sampledWeights;
+
+    // Level of detail settings, see Animator::setLevelOfDetail.
+    uint32_t lodInterval = 1;
+    bool lodVisible = true;
+    bool hasLodMask = false;
+    tsl::robin_set<Entity, Entity::Hasher> lodMask;
+
+    // When animations are evaluated at an interval, each evaluation samples the pose that the
+    // animation will have at the next evaluation, and the calls in between interpolate towards it.
+    struct IntervalTransform {
+        Entity entity;
+        TrsStash from;
+        TrsStash to;
+    };
+    vector<IntervalTransform> intervalTransforms;
+    tsl::robin_map<Entity, uint32_t, Entity::Hasher> intervalTransformIndices;
+    size_t intervalAnimation = std::numeric_limits<size_t>::max();
+    uint32_t intervalFrame = 0;
+    float intervalTime = 0.0f;
+
+    // Cached state of each skinned renderable, which allows us to skip the work for the joints
+    // that did not move and to skip setBones entirely when none of them did.
+    struct SkinnedTarget {
+        RenderableManager::Instance renderable;
+        SkinningBuffer* sharedBuffer = nullptr; // see SharedSkinning
+        mat4 worldTransform;            // world transform of the renderable
+        mat4 inverseWorldTransform;     // inverse of the above, updated when it changes
+        mat4f inverseWorldTransformF;   // single-precision copy of the above
+        vector<mat4> jointTransforms;   // world transforms of the joints that the bones use
+        BoneVector bones;
+        bool valid = false;             // false if the cache must be discarded
+
+        // Range of bones that must be passed to setBones, which is empty if none changed.
+        size_t dirtyBegin = 0;
+        size_t dirtyEnd = 0;
+    };
+    vector<SkinnedTarget> skinnedTargets;
+    size_t skinnedTargetCount = 0;
+
+    // Lazily computed list of skinned renderables, used to play baked animations.
+    vector<SkinnedRenderable> skinnedRenderables;
+    bool skinnedRenderablesDirty = true;
 };
 
-static void createSampler(const cgltf_animation_sampler& src, Sampler& dst) {
-    // Copy the time values into a red-black tree.
-    const cgltf_accessor* timelineAccessor = src.input;
-    const uint8_t* timelineBlob = nullptr;
-    const float* timelineFloats = nullptr;
-    if (timelineAccessor->buffer_view->has_meshopt_compression) {
-        timelineBlob = (const uint8_t*) timelineAccessor->buffer_view->data;
-        timelineFloats = (const float*) (timelineBlob + timelineAccessor->offset);
-    } else {
-        timelineBlob = (const uint8_t*) timelineAccessor->buffer_view->buffer->data;
-        timelineFloats = (const float*) (timelineBlob + timelineAccessor->offset +
-                timelineAccessor->buffer_view->offset);
-    }
-    for (size_t i = 0, len = timelineAccessor->count; i < len; ++i) {
-        dst.times[timelineFloats[i]] = i;
+// Measures a call to a public method of Animator: its duration is added to the given counter, and
+// the work it did is reported to systrace.
+class StatsScope {
+public:
+    StatsScope(AnimatorImpl& impl, uint64_t Animator::Stats::* time) noexcept
+            : mStats(impl.stats), mTime(time), mBefore(impl.stats),
+              mStart(std::chrono::steady_clock::now()) {
     }
 
-    // Convert source data to float.
-    const cgltf_accessor* valuesAccessor = src.output;
-    switch (valuesAccessor->type) {
-        case cgltf_type_scalar:
-            dst.values.resize(valuesAccessor->count);
-            cgltf_accessor_unpack_floats(src.output, &dst.values[0], valuesAccessor->count);
-            break;
-        case cgltf_type_vec3:
-            dst.values.resize(valuesAccessor->count * 3);
-            cgltf_accessor_unpack_floats(src.output, &dst.values[0], valuesAccessor->count * 3);
-            break;
-        case cgltf_type_vec4:
-            dst.values.resize(valuesAccessor->count * 4);
-            cgltf_accessor_unpack_floats(src.output, &dst.values[0], valuesAccessor->count * 4);
-            break;
-        default:
-            GLTFIO_WARN("Unknown animation type.");
-            return;
+    ~StatsScope() noexcept {
+        const auto duration = std::chrono::steady_clock::now() - mStart;
+        mStats.*mTime += uint64_t(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+        SYSTRACE_CONTEXT();
+        SYSTRACE_VALUE32("animatedChannels",
+                mStats.channelsEvaluated - mBefore.channelsEvaluated);
+        SYSTRACE_VALUE32("keyframeSearchSteps",
+                mStats.keyframeSearchSteps - mBefore.keyframeSearchSteps);
+        SYSTRACE_VALUE32("composedNodes", mStats.nodesComposed - mBefore.nodesComposed);
+        SYSTRACE_VALUE32("uploadedBones", mStats.bonesUploaded - mBefore.bonesUploaded);
+        SYSTRACE_VALUE32("uploadedMorphWeights",
+                mStats.morphWeightsUploaded - mBefore.morphWeightsUploaded);
     }
 
-    switch (src.interpolation) {
-        case cgltf_interpolation_type_linear:
-            dst.interpolation = Sampler::LINEAR;
-            break;
-        case cgltf_interpolation_type_step:
-            dst.interpolation = Sampler::STEP;
-            break;
-        case cgltf_interpolation_type_cubic_spline:
-            dst.interpolation = Sampler::CUBIC;
-            break;
-        case cgltf_interpolation_type_max_enum:
-            break;
-    }
-}
+    StatsScope(StatsScope const&) = delete;
+    StatsScope& operator=(StatsScope const&) = delete;
 
-static void setTransformType(const cgltf_animation_channel& src, Channel& dst) {
-    switch (src.target_path) {
-        case cgltf_animation_path_type_translation:
-            dst.transformType = Channel::TRANSLATION;
-            break;
-        case cgltf_animation_path_type_rotation:
-            dst.transformType = Channel::ROTATION;
-            break;
-        case cgltf_animation_path_type_scale:
-            dst.transformType = Channel::SCALE;
-            break;
-        case cgltf_animation_path_type_weights:
-            dst.transformType = Channel::WEIGHTS;
-            break;
-        case cgltf_animation_path_type_max_enum:
-        case cgltf_animation_path_type_invalid:
-            GLTFIO_WARN("Unsupported channel path.");
-            break;
+private:
+    Animator::Stats& mStats;
+    uint64_t Animator::Stats::* const mTime;
+    const Animator::Stats mBefore;
+    const std::chrono::steady_clock::time_point mStart;
+};
+
+// Returns the number of keyframes visited by a binary search over the given number of keyframes.
+static uint32_t getBinarySearchSteps(size_t count) {
+    uint32_t steps = 0;
+    for (; count; count >>= 1u) {
+        ++steps;
     }
+    return steps;
 }
 
-static bool validateAnimation(const cgltf_animation& anim) {
-    for (cgltf_size j = 0; j < anim.channels_count; ++j) {
-        const cgltf_animation_channel& channel = anim.channels[j];
-        const cgltf_animation_sampler* sampler = channel.sampler;
-        if (!channel.target_node) {
-            continue;
-        }
-        if (!channel.sampler) {
-            return false;
-        }
-        cgltf_size components = 1;
-        if (channel.target_path == cgltf_animation_path_type_weights) {
-            if (!channel.target_node->mesh || !channel.target_node->mesh->primitives_count) {
-                return false;
+// Returns the index of the first keyframe whose time is not less than the given time, which is
+// equivalent to std::lower_bound. The cursor holds the result of the previous lookup; when the
+// playhead moves forward by less than a few keyframes we simply walk from there, otherwise we fall
+// back to a binary search. The number of keyframes visited is added to "steps".
+static size_t findKeyframe(const TimeValues& times, float time, size_t& cursor, uint32_t& steps) {
+    constexpr size_t MAX_LINEAR_STEPS = 4;
+    const size_t count = times.size();
+    size_t index = std::min(cursor, count);
+    if (index > 0 && times[index - 1] >= time) {
+        // The playhead moved backwards, e.g. when the animation loops.
+        steps += 1 + getBinarySearchSteps(index);
+        index = std::lower_bound(times.begin(), times.begin() + index, time) - times.begin();
+    } else {
+        size_t step = 0;
+        for (; index < count && times[index] < time; ++index) {
+            if (++step > MAX_LINEAR_STEPS) {
+                step += getBinarySearchSteps(count - index);
+                index = std::lower_bound(times.begin() + index, times.end(), time) - times.begin();
+                break;
             }
-            components = channel.target_node->mesh->primitives[0].targets_count;
-        }
-        cgltf_size values = sampler->interpolation == cgltf_interpolation_type_cubic_spline ? 3 : 1;
-        if (sampler->input->count * components * values != sampler->output->count) {
-            return false;
         }
+        steps += uint32_t(step) + 1;
     }
-    return true;
+    cursor = index;
+    return index;
 }
 
 Animator::Animator(FFilamentAsset const* asset, FFilamentInstance* instance) {
-    assert(asset->mResourcesLoaded && asset->mSourceAsset);
+    assert(asset->mResourcesLoaded);
     mImpl = new AnimatorImpl();
     mImpl->asset = asset;
     mImpl->instance = instance;
     mImpl->renderableManager = &asset->mEngine->getRenderableManager();
     mImpl->transformManager = &asset->mEngine->getTransformManager();
-    mImpl->trsTransformManager = asset->getTrsTransformManager();
-
-    const cgltf_data* srcAsset = asset->mSourceAsset->hierarchy;
-    const cgltf_animation* srcAnims = srcAsset->animations;
-    for (cgltf_size i = 0, len = srcAsset->animations_count; i < len; ++i) {
-        const cgltf_animation& anim = srcAnims[i];
-        if (!validateAnimation(anim)) {
-            GLTFIO_WARN("Disabling animation due to validation failure.");
-            return;
-        }
-    }
-
-    // Loop over the glTF animation definitions.
-    mImpl->animations.resize(srcAsset->animations_count);
-    for (cgltf_size i = 0, len = srcAsset->animations_count; i < len; ++i) {
-        const cgltf_animation& srcAnim = srcAnims[i];
-        Animation& dstAnim = mImpl->animations[i];
-        dstAnim.duration = 0;
-        if (srcAnim.name) {
-            dstAnim.name = srcAnim.name;
-        }
+    mImpl->lightManager = &asset->mEngine->getLightManager();
+    mImpl->trsTransformManager = downcast(asset->getTrsTransformManager());
 
-        // Import each glTF sampler into a custom data structure.
-        cgltf_animation_sampler* srcSamplers = srcAnim.samplers;
-        dstAnim.samplers.resize(srcAnim.samplers_count);
-        for (cgltf_size j = 0, nsamps = srcAnim.samplers_count; j < nsamps; ++j) {
-            const cgltf_animation_sampler& srcSampler = srcSamplers[j];
-            Sampler& dstSampler = dstAnim.samplers[j];
-            createSampler(srcSampler, dstSampler);
-            if (dstSampler.times.size() > 1) {
-                float maxtime = (--dstSampler.times.end())->first;
-                dstAnim.duration = std::max(dstAnim.duration, maxtime);
-            }
+    // The decoded animation data is owned by the asset and shared by all of its animators, so
+    // here we merely bind each animation channel to the entities that it targets.
+    if (instance) {
+        mImpl->captureRestPose(instance->mNodeMap);
+    } else {
+        for (FFilamentInstance* instance : asset->mInstances) {
+            mImpl->captureRestPose(instance->mNodeMap);
         }
+    }
 
-        // Import each glTF channel into a custom data structure.
-        if (instance) {
-            mImpl->addChannels(instance->mNodeMap, srcAnim, dstAnim);
-        } else {
-            for (FFilamentInstance* instance : asset->mInstances) {
-                mImpl->addChannels(instance->mNodeMap, srcAnim, dstAnim);
-            }
-        }
+    mImpl->animations.reserve(asset->mAnimationClips.size());
+    for (const AnimationClipHandle& clip : asset->mAnimationClips) {
+        mImpl->addAnimation(clip);
     }
 }
 
 void Animator::applyCrossFade(size_t previousAnimIndex, float previousAnimTime, float alpha) {
-    mImpl->stashCrossFade();
+    SYSTRACE_CALL();
+    StatsScope scope(*mImpl, &Stats::crossFadeTime);
+    mImpl->stashCrossFade(previousAnimIndex);
     applyAnimation(previousAnimIndex, previousAnimTime);
-    mImpl->applyCrossFade(alpha);
+    mImpl->applyCrossFade(previousAnimIndex, alpha);
+}
+
+void Animator::applyAnimationLayers(AnimationLayer const* layers, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        FILAMENT_CHECK_PRECONDITION(layers[i].animationIndex < mImpl->animations.size())
+                << "Animation index " << layers[i].animationIndex << " is out of range";
+    }
+    SYSTRACE_CALL();
+    StatsScope scope(*mImpl, &Stats::animationTime);
+    mImpl->applyAnimationLayers(layers, count);
+}
+
+void Animator::setLevelOfDetail(LevelOfDetail const& lod) {
+    FILAMENT_CHECK_PRECONDITION(lod.updateInterval > 0) << "The update interval must be positive";
+    mImpl->setLevelOfDetail(lod);
+}
+
+void Animator::bakeAnimation(size_t animationIndex, float frameRate) {
+    FILAMENT_CHECK_PRECONDITION(animationIndex < mImpl->animations.size())
+            << "Animation index " << animationIndex << " is out of range";
+    FILAMENT_CHECK_PRECONDITION(frameRate > 0.0f) << "The frame rate must be positive";
+    SYSTRACE_CALL();
+    mImpl->bakeAnimation(animationIndex, frameRate);
+}
+
+void Animator::applyBakedAnimation(size_t animationIndex, float time) {
+    FILAMENT_CHECK_PRECONDITION(animationIndex < mImpl->animations.size())
+            << "Animation index " << animationIndex << " is out of range";
+    const AnimationClip* clip = mImpl->animations[animationIndex].clip.get();
+    auto iter = mImpl->asset->mBakedAnimations.find(clip);
+    FILAMENT_CHECK_PRECONDITION(iter != mImpl->asset->mBakedAnimations.end())
+            << "Animation " << animationIndex << " has not been baked";
+    SYSTRACE_CALL();
+    StatsScope scope(*mImpl, &Stats::boneTime);
+    mImpl->applyBakedAnimation(*iter->second, clip->duration, time);
 }
 
 void Animator::addInstance(FFilamentInstance* instance) {
-    const cgltf_data* srcAsset = mImpl->asset->mSourceAsset->hierarchy;
-    const cgltf_animation* srcAnims = srcAsset->animations;
-    for (cgltf_size i = 0, len = srcAsset->animations_count; i < len; ++i) {
-        const cgltf_animation& srcAnim = srcAnims[i];
-        Animation& dstAnim = mImpl->animations[i];
-        mImpl->addChannels(instance->mNodeMap, srcAnim, dstAnim);
+    mImpl->captureRestPose(instance->mNodeMap);
+    mImpl->skinnedRenderablesDirty = true;
+    for (Animation& anim : mImpl->animations) {
+        mImpl->addChannels(instance->mNodeMap, anim);
     }
 }
 
+size_t Animator::addAnimation(FilamentAsset const* source, size_t animationIndex) {
+    FFilamentAsset const* sourceAsset = downcast(source);
+    FILAMENT_CHECK_PRECONDITION(sourceAsset->mResourcesLoaded)
+            << "The source asset must be loaded before its animations can be added";
+    FILAMENT_CHECK_PRECONDITION(animationIndex < sourceAsset->mAnimationClips.size())
+            << "Animation index " << animationIndex << " is out of range";
+    mImpl->addAnimation(sourceAsset->mAnimationClips[animationIndex]);
+    return mImpl->animations.size() - 1;
+}
+
+size_t Animator::retargetAnimation(FilamentAsset const* source, size_t animationIndex,
+        NameMapping const* remap, size_t remapCount) {
+    FFilamentAsset const* sourceAsset = downcast(source);
+    FILAMENT_CHECK_PRECONDITION(sourceAsset->mResourcesLoaded)
+            << "The source asset must be loaded before its animations can be added";
+    FILAMENT_CHECK_PRECONDITION(animationIndex < sourceAsset->mAnimationClips.size())
+            << "Animation index " << animationIndex << " is out of range";
+    const AnimationClipHandle& clip = sourceAsset->mAnimationClips[animationIndex];
+    mImpl->addAnimation(clip, mImpl->resolveTargetsByName(*clip, remap, remapCount));
+    return mImpl->animations.size() - 1;
+}
+
 Animator::~Animator() {
     delete mImpl;
 }
@@ -263,54 +529,49 @@ size_t Animator::getAnimationCount() const {
 }
 
 void Animator::applyAnimation(size_t animationIndex, float time) const {
-    const Animation& anim = mImpl->animations[animationIndex];
-    time = fmod(time, anim.duration);
+    SYSTRACE_CALL();
+    StatsScope scope(*mImpl, &Stats::animationTime);
     TransformManager& transformManager = *mImpl->transformManager;
     transformManager.openLocalTransformTransaction();
-    for (const auto& channel : anim.channels) {
-        const Sampler* sampler = channel.sourceData;
-        if (sampler->times.size() < 2) {
-            continue;
-        }
-
-        const TimeValues& times = sampler->times;
-
-        // Find the first keyframe after the given time, or the keyframe that matches it exactly.
-        TimeValues::const_iterator iter = times.lower_bound(time);
+    mImpl->applyAnimation(animationIndex, time, false);
+    transformManager.commitLocalTransformTransaction();
+}
 
-        // Compute the interpolant (between 0 and 1) and determine the keyframe pair.
-        float t = 0.0f;
-        size_t nextIndex;
-        size_t prevIndex;
-        if (iter == times.end()) {
-            nextIndex = times.size() - 1;
-            prevIndex = nextIndex;
-        } else if (iter == times.begin()) {
-            nextIndex = 0;
-            prevIndex = 0;
-        } else {
-            TimeValues::const_iterator prev = iter; --prev;
-            nextIndex = iter->second;
-            prevIndex = prev->second;
-            const float nextTime = iter->first;
-            const float prevTime = prev->first;
-            float deltaTime = nextTime - prevTime;
-            assert(deltaTime >= 0);
-            if (deltaTime > 0) {
-                t = (time - prevTime) / deltaTime;
-            }
-        }
+void Animator::applyAnimations(AnimationState const* states, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    SYSTRACE_CALL();
+    AnimatorImpl const& first = *states[0].animator->mImpl;
+    JobSystem& js = first.asset->mEngine->getJobSystem();
+    TransformManager& transformManager = *first.transformManager;
 
-        if (sampler->interpolation == Sampler::STEP) {
-            t = 0.0f;
+    // While a local transform transaction is open, setting a transform merely writes the local
+    // matrix of the given node. Since animators drive disjoint sets of nodes, they can therefore
+    // be sampled concurrently. Morph weights go through the driver and are deferred until all
+    // jobs have completed.
+    transformManager.openLocalTransformTransaction();
+    auto work = [states](uint32_t start, uint32_t count) {
+        for (uint32_t i = start, end = start + count; i < end; ++i) {
+            AnimationState const& state = states[i];
+            StatsScope scope(*state.animator->mImpl, &Stats::animationTime);
+            state.animator->mImpl->applyAnimation(state.animationIndex, state.time, true);
         }
-
-        mImpl->applyAnimation(channel, t, prevIndex, nextIndex);
+    };
+    auto* job = jobs::parallel_for(js, nullptr, 0, uint32_t(count),
+            std::cref(work), jobs::CountSplitter<JOBS_PARALLEL_FOR_ANIMATIONS_COUNT>());
+    js.runAndWait(job);
+    for (size_t i = 0; i < count; ++i) {
+        StatsScope scope(*states[i].animator->mImpl, &Stats::animationTime);
+        states[i].animator->mImpl->flushMorphWeights();
+        states[i].animator->mImpl->flushProperties();
     }
     transformManager.commitLocalTransformTransaction();
 }
 
 void Animator::resetBoneMatrices() {
+    StatsScope scope(*mImpl, &Stats::boneTime);
+
     // If this is a single-instance animator, then reset only this instance.
     if (mImpl->instance) {
         mImpl->resetBoneMatrices(mImpl->instance);
@@ -324,209 +585,1293 @@ void Animator::resetBoneMatrices() {
 }
 
 void Animator::updateBoneMatrices() {
-    // If this is a single-instance animator, then update only this instance.
-    if (mImpl->instance) {
-        mImpl->updateBoneMatrices(mImpl->instance);
+    SYSTRACE_CALL();
+    StatsScope scope(*mImpl, &Stats::boneTime);
+    mImpl->computeBoneMatrices();
+    mImpl->uploadBoneMatrices();
+}
+
+void Animator::updateBoneMatrices(Animator* const* animators, size_t count) {
+    if (count == 0) {
         return;
     }
+    SYSTRACE_CALL();
+    JobSystem& js = animators[0]->mImpl->asset->mEngine->getJobSystem();
 
-    // If this is a broadcast animator, then update all instances.
-    for (FFilamentInstance* instance : mImpl->asset->mInstances) {
-        mImpl->updateBoneMatrices(instance);
+    // Computing the bone matrices only reads from TransformManager, but uploading them goes
+    // through the driver, so only the former is done in parallel.
+    auto work = [animators](uint32_t start, uint32_t count) {
+        for (uint32_t i = start, end = start + count; i < end; ++i) {
+            StatsScope scope(*animators[i]->mImpl, &Stats::boneTime);
+            animators[i]->mImpl->computeBoneMatrices();
+        }
+    };
+    auto* job = jobs::parallel_for(js, nullptr, 0, uint32_t(count),
+            std::cref(work), jobs::CountSplitter<JOBS_PARALLEL_FOR_ANIMATIONS_COUNT>());
+    js.runAndWait(job);
+    for (size_t i = 0; i < count; ++i) {
+        StatsScope scope(*animators[i]->mImpl, &Stats::boneTime);
+        animators[i]->mImpl->uploadBoneMatrices();
     }
 }
 
 float Animator::getAnimationDuration(size_t animationIndex) const {
-    return mImpl->animations[animationIndex].duration;
+    return mImpl->animations[animationIndex].clip->duration;
 }
 
 const char* Animator::getAnimationName(size_t animationIndex) const {
-    return mImpl->animations[animationIndex].name.c_str();
+    return mImpl->animations[animationIndex].clip->name.c_str_safe();
 }
 
-void AnimatorImpl::stashCrossFade() {
-    using Instance = TransformManager::Instance;
-    auto& tm = *this->transformManager;
-    auto& stash = this->crossFade;
+Animator::Stats Animator::getStats() const {
+    return mImpl->stats;
+}
 
-    // Count the total number of transformable nodes to preallocate the stash memory.
-    // We considered caching this count, but the cache would need to be invalidated when entities
-    // are added into the hierarchy.
-    auto recursiveCount = [&tm](Instance node, size_t count, auto& fn) -> size_t {
-        ++count;
-        for (auto iter = tm.getChildrenBegin(node); iter != tm.getChildrenEnd(node); ++iter) {
-            count = fn(*iter, count, fn);
+void Animator::resetStats() {
+    mImpl->stats = {};
+}
+
+// Returns the number of morph weights per keyframe of the given weights sampler.
+static size_t getMorphTargetCount(const Sampler& sampler) {
+    const size_t valuesPerKeyframe = sampler.valuesPerKey;
+    return sampler.interpolation == Sampler::CUBIC ? valuesPerKeyframe / 3 : valuesPerKeyframe;
+}
+
+// Returns the values of the given keyframe of a channel. Streamed channels only hold the keyframes
+// of their current chunk, so the keyframe must come from the most recent findKeyframes().
+static const float* getKeyValues(const Channel& channel, size_t key) {
+    const Sampler* sampler = channel.sourceData;
+    if (sampler->isStreamed()) {
+        const AnimationStream::Window& window = channel.window;
+        assert_invariant(key >= window.firstKey && key <= window.lastKey);
+        return window.values + (key - window.firstKey) * sampler->valuesPerKey;
+    }
+    return sampler->values.data() + key * sampler->valuesPerKey;
+}
+
+// Interpolates the morph weights of the given keyframes into "out", which must be large enough to
+// hold getMorphTargetCount() values. I is the interpolation of the sampler.
+template<Sampler::Interpolation I>
+static void computeMorphWeights(const Sampler& sampler, float t, const float* prevValues,
+        const float* nextValues, float* UTILS_RESTRICT out) {
+    const int valuesPerKeyframe = int(sampler.valuesPerKey);
+
+    if constexpr (I == Sampler::CUBIC) {
+        assert(valuesPerKeyframe % 3 == 0);
+        const int numMorphTargets = valuesPerKeyframe / 3;
+
+        // Each keyframe holds the in-tangents, then the spline vertices, then the out-tangents.
+        for (int comp = 0; comp < numMorphTargets; ++comp) {
+            float vert0 = prevValues[comp + numMorphTargets];
+            float tang0 = prevValues[comp + numMorphTargets * 2];
+            float tang1 = nextValues[comp];
+            float vert1 = nextValues[comp + numMorphTargets];
+            out[comp] = cubicSpline(vert0, tang0, vert1, tang1, t);
         }
-        return count;
-    };
+    } else {
+        for (int comp = 0; comp < valuesPerKeyframe; ++comp) {
+            float previous = prevValues[comp];
+            float current = nextValues[comp];
+            out[comp] = (1 - t) * previous + t * current;
+        }
+    }
+}
+
+// Determines the keyframe pair that surrounds the given time and the interpolant (between 0 and
+// 1) between them. I is the interpolation of the sampler.
+template<Sampler::Interpolation I>
+static void findKeyframes(Channel& channel, float time, float* t, size_t* prevIndex,
+        size_t* nextIndex, Animator::Stats& stats) {
+    const Sampler* sampler = channel.sourceData;
+    const TimeValues& times = sampler->times;
+    stats.channelsEvaluated++;
+
+    // Find the first keyframe after the given time, or the keyframe that matches it exactly.
+    const size_t index = findKeyframe(times, time, channel.cursor, stats.keyframeSearchSteps);
 
-    auto recursiveStash = [&tm, &stash](Instance node, size_t index, auto& fn) -> size_t {
-        stash[index++] = tm.getTransform(node);
-        for (auto iter = tm.getChildrenBegin(node); iter != tm.getChildrenEnd(node); ++iter) {
-            index = fn(*iter, index, fn);
+    *t = 0.0f;
+    if (index == times.size()) {
+        *nextIndex = times.size() - 1;
+        *prevIndex = *nextIndex;
+    } else if (index == 0) {
+        *nextIndex = 0;
+        *prevIndex = 0;
+    } else {
+        *nextIndex = index;
+        *prevIndex = index - 1;
+        if constexpr (I != Sampler::STEP) {
+            const float nextTime = times[*nextIndex];
+            const float prevTime = times[*prevIndex];
+            float deltaTime = nextTime - prevTime;
+            assert(deltaTime >= 0);
+            if (deltaTime > 0) {
+                *t = (time - prevTime) / deltaTime;
+            }
         }
-        return index;
-    };
+    }
 
-    const Entity rootEntity = instance ? instance->getRoot() : asset->mRoot;
-    const Instance root = tm.getInstance(rootEntity);
-    const size_t count = recursiveCount(root, 0, recursiveCount);
-    crossFade.reserve(count);
-    crossFade.resize(count);
-    recursiveStash(root, 0, recursiveStash);
-}
-
-void AnimatorImpl::applyCrossFade(float alpha) {
-    using Instance = TransformManager::Instance;
-    auto& tm = *this->transformManager;
-    auto& stash = this->crossFade;
-    auto recursiveFn = [&tm, &stash, alpha](Instance node, size_t index, auto& fn) -> size_t {
-        float3 scale0, scale1;
-        quatf rotation0, rotation1;
-        float3 translation0, translation1;
-        decomposeMatrix(stash[index++], &translation1, &rotation1, &scale1);
-        decomposeMatrix(tm.getTransform(node), &translation0, &rotation0, &scale0);
-        const float3 scale = mix(scale0, scale1, alpha);
-        const quatf rotation = slerp(rotation0, rotation1, alpha);
-        const float3 translation = mix(translation0, translation1, alpha);
-        tm.setTransform(node, composeMatrix(translation, rotation, scale));
-        for (auto iter = tm.getChildrenBegin(node); iter != tm.getChildrenEnd(node); ++iter) {
-            index = fn(*iter, index, fn);
-        }
-        return index;
-    };
-    const Entity rootEntity = instance ? instance->getRoot() : asset->mRoot;
-    const Instance root = tm.getInstance(rootEntity);
-    recursiveFn(root, 0, recursiveFn);
-}
-
-void AnimatorImpl::addChannels(const FixedCapacityVector<Entity>& nodeMap,
-        const cgltf_animation& srcAnim, Animation& dst) {
-    const cgltf_animation_channel* srcChannels = srcAnim.channels;
-    const cgltf_animation_sampler* srcSamplers = srcAnim.samplers;
-    const cgltf_node* nodes = asset->mSourceAsset->hierarchy->nodes;
-    const Sampler* samplers = dst.samplers.data();
-    for (cgltf_size j = 0, nchans = srcAnim.channels_count; j < nchans; ++j) {
-        const cgltf_animation_channel& srcChannel = srcChannels[j];
-        Entity targetEntity = nodeMap[srcChannel.target_node - nodes];
+    // Switch to the chunk that holds both keyframes, unless the current one does.
+    AnimationStream::Window& window = channel.window;
+    if (channel.stream && (!window.chunk || *prevIndex < window.firstKey ||
+            *nextIndex > window.lastKey)) {
+        window = channel.stream->acquire(sampler->streamIndex, *prevIndex);
+    }
+}
+
+// Returns the value type of the channels of the given group.
+static constexpr ValueType getValueType(size_t group) {
+    switch (group) {
+        case CONSTANT_TRANSFORM: return VECTOR;
+        case CONSTANT_PROPERTY: return PROPERTY;
+        default: return ValueType((group - FIRST_SAMPLED_GROUP) % VALUE_TYPE_COUNT);
+    }
+}
+
+// Returns the group of the given channel, see ChannelGroup. Morph weights are not part of the
+// constant groups since they have any number of components, but a constant weights sampler only
+// has a single key to look up anyway.
+static uint8_t getChannelGroup(const Channel& channel) {
+    const Sampler* sampler = channel.sourceData;
+    const bool isCompressed = sampler->isCompressed();
+    ValueType type = PROPERTY;
+    switch (channel.transformType) {
+        case AnimationClip::TRANSLATION:
+        case AnimationClip::SCALE: type = isCompressed ? QUANTIZED_VECTOR : VECTOR; break;
+        case AnimationClip::ROTATION: type = isCompressed ? QUANTIZED_ROTATION : ROTATION; break;
+        case AnimationClip::WEIGHTS: type = WEIGHTS; break;
+        case AnimationClip::MATERIAL:
+        case AnimationClip::LIGHT: type = PROPERTY; break;
+    }
+    if (sampler->isConstant() && type != WEIGHTS) {
+        return type == PROPERTY ? CONSTANT_PROPERTY : CONSTANT_TRANSFORM;
+    }
+    // Compressed samplers are never cubic.
+    assert_invariant(!isCompressed || sampler->interpolation != Sampler::CUBIC);
+    return uint8_t(FIRST_SAMPLED_GROUP + sampler->interpolation * VALUE_TYPE_COUNT + type);
+}
+
+// Loads the i-th value of a keyframe, which holds a single value for linear and step samplers, or
+// the in-tangent, the spline vertex and the out-tangent for cubic samplers. Properties have
+// between one and four components.
+template<ValueType V>
+static float4 loadValue(const float* key, size_t i, size_t componentCount) {
+    if constexpr (V == ROTATION) {
+        return ((const quatf*) key)[i].xyzw;
+    } else if constexpr (V == VECTOR) {
+        return float4{ ((const float3*) key)[i], 0 };
+    } else {
+        float4 value = 0.0f;
+        std::copy_n(key + i * componentCount, componentCount, value.v);
+        return value;
+    }
+}
+
+void AnimatorImpl::applyAnimation(size_t animationIndex, float time, bool deferMorphWeights) {
+    if (lodInterval > 1) {
+        sampleAnimationAtInterval(animationIndex, time, deferMorphWeights);
+        return;
+    }
+    sampleAnimation(animationIndex, time, deferMorphWeights);
+}
+
+void AnimatorImpl::sampleAnimation(size_t animationIndex, float time, bool deferMorphWeights) {
+    Animation& anim = animations[animationIndex];
+    time = fmod(time, anim.clip->duration);
+    sampleChannels(anim, time, time, nullptr);
+    applyChannelBatches();
+    if (!deferMorphWeights) {
+        flushMorphWeights();
+        flushProperties();
+    }
+}
+
+void AnimatorImpl::sampleAnimationAtInterval(size_t animationIndex, float time,
+        bool deferMorphWeights) {
+    // Start over when switching to a different animation or when the playhead moves backwards,
+    // e.g. when seeking.
+    if (animationIndex != intervalAnimation || time < intervalTime) {
+        sampleAnimation(animationIndex, time, deferMorphWeights);
+        intervalAnimation = animationIndex;
+        intervalTime = time;
+        intervalFrame = lodInterval;
+        intervalTransforms.clear();
+        intervalTransformIndices.clear();
+        return;
+    }
+
+    // Interpolate towards the pose sampled by the previous evaluation.
+    const float deltaTime = time - intervalTime;
+    intervalTime = time;
+    intervalFrame = std::min(intervalFrame + 1, lodInterval);
+    const float alpha = float(intervalFrame) / float(lodInterval);
+    stats.nodesComposed += uint32_t(intervalTransforms.size());
+    for (const IntervalTransform& xform : intervalTransforms) {
+        auto trsNode = trsTransformManager->getInstance(xform.entity);
+        trsTransformManager->setTrs(trsNode,
+                mix(xform.from.translation, xform.to.translation, alpha),
+                slerp(xform.from.rotation, xform.to.rotation, alpha),
+                mix(xform.from.scale, xform.to.scale, alpha));
+        TransformManager::Instance node = transformManager->getInstance(xform.entity);
+        transformManager->setTransform(node, trsTransformManager->getTransform(trsNode));
+    }
+    if (intervalFrame < lodInterval) {
+        return;
+    }
+
+    // This is an evaluation frame. Morph weights and properties are not interpolated, so they are
+    // sampled at the current time, whereas transforms are sampled ahead by one interval, assuming
+    // that time advances at the same rate as it did since the previous call.
+    intervalFrame = 0;
+    Animation& anim = animations[animationIndex];
+    const float duration = anim.clip->duration;
+    const float currentTime = fmod(time, duration);
+    const float targetTime = fmod(time + deltaTime * float(lodInterval), duration);
+    sampleChannels(anim, currentTime, targetTime, nullptr);
+
+    for (IntervalTransform& xform : intervalTransforms) {
+        xform.from = xform.to;
+    }
+    evaluateChannelBatches();
+    for (ChannelBatch& batch : batches) {
+        for (size_t i = 0, n = batch.channels.size(); i < n; ++i) {
+            if (batch.channels[i]->transformType > AnimationClip::SCALE) {
+                writeProperty(*batch.channels[i], batch.results[i]);
+                continue;
+            }
+            const Entity entity = batch.channels[i]->targetEntity;
+            auto iter = intervalTransformIndices.find(entity);
+            if (iter == intervalTransformIndices.end()) {
+                auto trsNode = trsTransformManager->getInstance(entity);
+                const TrsStash current = {
+                    trsTransformManager->getTranslation(trsNode),
+                    trsTransformManager->getRotation(trsNode),
+                    trsTransformManager->getScale(trsNode),
+                };
+                iter = intervalTransformIndices.emplace(entity,
+                        uint32_t(intervalTransforms.size())).first;
+                intervalTransforms.push_back({ entity, current, current });
+            }
+            TrsStash& target = intervalTransforms[iter->second].to;
+            const float4 value = batch.results[i];
+            switch (batch.channels[i]->transformType) {
+                case AnimationClip::TRANSLATION: target.translation = value.xyz; break;
+                case AnimationClip::ROTATION: target.rotation = quatf{ value }; break;
+                case AnimationClip::SCALE: target.scale = value.xyz; break;
+                case AnimationClip::WEIGHTS:
+                case AnimationClip::MATERIAL:
+                case AnimationClip::LIGHT: break;
+            }
+        }
+    }
+    clearChannelBatches();
+    if (!deferMorphWeights) {
+        flushMorphWeights();
+        flushProperties();
+    }
+}
+
+void AnimatorImpl::bakeAnimation(size_t animationIndex, float frameRate) {
+    Animation& anim = animations[animationIndex];
+    const float duration = anim.clip->duration;
+    auto baked = std::make_shared<BakedAnimation>();
+    baked->frameRate = frameRate;
+    baked->frameCount = size_t(std::ceil(duration * frameRate)) + 1;
+
+    // Save the local transforms that baking is about to overwrite.
+    const vector<Entity>& targets = getTransformTargets(anim);
+    vector<TrsStash> saved(targets.size());
+    for (size_t i = 0, n = targets.size(); i < n; ++i) {
+        auto trsNode = trsTransformManager->getInstance(targets[i]);
+        saved[i] = {
+            trsTransformManager->getTranslation(trsNode),
+            trsTransformManager->getRotation(trsNode),
+            trsTransformManager->getScale(trsNode),
+        };
+    }
+
+    // Bones must be computed regardless of the level of detail.
+    const bool visible = lodVisible;
+    lodVisible = true;
+    size_t firstInstanceTargets = 0;
+    for (size_t frame = 0; frame < baked->frameCount; ++frame) {
+        transformManager->openLocalTransformTransaction();
+        sampleAnimation(animationIndex, float(frame) / frameRate, true);
+        transformManager->commitLocalTransformTransaction();
+        computeBoneMatrices();
+        if (frame == 0) {
+            // Only the bones of the first instance are kept, since they are expressed relative
+            // to their renderables and are therefore the same for every instance.
+            for (const SkinnedRenderable& target : getSkinnedRenderables()) {
+                if (target.offset == 0 && firstInstanceTargets > 0) {
+                    break;
+                }
+                baked->bonesPerFrame += target.boneCount;
+                firstInstanceTargets++;
+            }
+            baked->palettes = FixedCapacityVector<mat4f>(baked->frameCount * baked->bonesPerFrame);
+            const auto& renderables = getSkinnedRenderables();
+            if (std::any_of(renderables.begin(), renderables.begin() + firstInstanceTargets,
+                    [](const SkinnedRenderable& target) { return target.jointBounds; })) {
+                baked->renderablesPerFrame = firstInstanceTargets;
+                baked->bounds = FixedCapacityVector<Aabb>(baked->frameCount * firstInstanceTargets);
+            }
+        }
+        assert_invariant(firstInstanceTargets <= skinnedTargetCount);
+        mat4f* dst = baked->palettes.data() + frame * baked->bonesPerFrame;
+        for (size_t i = 0; i < firstInstanceTargets; ++i) {
+            const BoneVector& bones = skinnedTargets[i].bones;
+            dst = std::copy(bones.begin(), bones.end(), dst);
+        }
+        if (!baked->bounds.empty()) {
+            const auto& renderables = getSkinnedRenderables();
+            Aabb* bounds = baked->bounds.data() + frame * firstInstanceTargets;
+            for (size_t i = 0; i < firstInstanceTargets; ++i) {
+                if (renderables[i].jointBounds) {
+                    const BoneVector& bones = skinnedTargets[i].bones;
+                    bounds[i] = renderables[i].jointBounds->transform(bones.data(),
+                            bones.size());
+                }
+            }
+        }
+    }
+    lodVisible = visible;
+
+    // Restore the local transforms, and discard the morph weights and the bone matrices that
+    // were computed while baking.
+    transformManager->openLocalTransformTransaction();
+    for (size_t i = 0, n = targets.size(); i < n; ++i) {
+        auto trsNode = trsTransformManager->getInstance(targets[i]);
+        trsTransformManager->setTrs(trsNode, saved[i].translation, saved[i].rotation,
+                saved[i].scale);
+        TransformManager::Instance node = transformManager->getInstance(targets[i]);
+        transformManager->setTransform(node, trsTransformManager->getTransform(trsNode));
+    }
+    transformManager->commitLocalTransformTransaction();
+    for (uint32_t index : dirtyMorphSlots) {
+        morphSlots[index].dirty = false;
+    }
+    dirtyMorphSlots.clear();
+    for (uint32_t index : dirtyPropertySlots) {
+        propertySlots[index].dirty = false;
+    }
+    dirtyPropertySlots.clear();
+    for (SkinnedTarget& target : skinnedTargets) {
+        target.valid = false;
+    }
+
+    asset->mBakedAnimations[anim.clip.get()] = std::move(baked);
+}
+
+void AnimatorImpl::applyBakedAnimation(const BakedAnimation& baked, float duration, float time) {
+    // Find the pair of frames that surrounds the given time.
+    const size_t lastFrame = baked.frameCount - 1;
+    const float frame = duration > 0.0f ? fmod(time, duration) * baked.frameRate : 0.0f;
+    const size_t prevFrame = std::min(size_t(frame), lastFrame);
+    const size_t nextFrame = std::min(prevFrame + 1, lastFrame);
+    const float t = std::clamp(frame - float(prevFrame), 0.0f, 1.0f);
+    const mat4f* prev = baked.palettes.data() + prevFrame * baked.bonesPerFrame;
+    const mat4f* next = baked.palettes.data() + nextFrame * baked.bonesPerFrame;
+
+    for (const SkinnedRenderable& target : getSkinnedRenderables()) {
+        const size_t offset = target.offset;
+        if (offset + target.boneCount > baked.bonesPerFrame) {
+            continue;
+        }
+        boneMatrices.resize(target.boneCount);
+        for (size_t i = 0; i < target.boneCount; ++i) {
+            boneMatrices[i] = (1 - t) * prev[offset + i] + t * next[offset + i];
+        }
+        setBones(target.sharedBuffer, target.renderable, boneMatrices.data(), target.boneCount);
+
+        // Skinned positions are linear in the bones, so the union of the boxes of the two frames
+        // contains the interpolated pose.
+        if (target.jointBounds && target.index < baked.renderablesPerFrame) {
+            const size_t n = baked.renderablesPerFrame;
+            const Aabb& a = baked.bounds[prevFrame * n + target.index];
+            const Aabb& b = baked.bounds[nextFrame * n + target.index];
+            const float3 lo = min(a.min, b.min);
+            const float3 hi = max(a.max, b.max);
+            if (all(lessThanEqual(lo, hi))) {
+                renderableManager->setAxisAlignedBoundingBox(target.renderable,
+                        Box().set(lo, hi));
+            }
+        }
+    }
+
+    // The cached bones no longer reflect what the renderables use.
+    for (SkinnedTarget& target : skinnedTargets) {
+        target.valid = false;
+    }
+}
+
+const vector<SkinnedRenderable>& AnimatorImpl::getSkinnedRenderables() {
+    if (skinnedRenderablesDirty) {
+        skinnedRenderables.clear();
+        // This must visit renderables in the same order as computeBoneMatrices().
+        auto addInstance = [this](FFilamentInstance const* instance) {
+            if (isSkinningFollower(instance)) {
+                return;
+            }
+            size_t offset = 0;
+            size_t index = 0;
+            for (size_t skinIndex = 0; skinIndex < instance->mSkins.size(); ++skinIndex) {
+                const auto& skin = instance->mSkins[skinIndex];
+                for (Entity entity : skin.targets) {
+                    if (auto renderable = renderableManager->getInstance(entity)) {
+                        // The joint bounds only apply to the node that the skin is bound to in
+                        // the glTF, not to the targets added with attachSkin().
+                        FFilamentAsset::JointBounds const* jointBounds = nullptr;
+                        for (const auto& bounds : asset->mJointBounds) {
+                            if (bounds.skin == skinIndex &&
+                                    instance->mNodeMap[bounds.node] == entity) {
+                                jointBounds = &bounds;
+                                break;
+                            }
+                        }
+                        skinnedRenderables.push_back({ renderable, offset, skin.joints.size(),
+                                getSharedBuffer(instance, entity), index++, jointBounds });
+                        offset += skin.joints.size();
+                    }
+                }
+            }
+        };
+        if (instance) {
+            addInstance(instance);
+        } else {
+            for (FFilamentInstance const* instance : asset->mInstances) {
+                addInstance(instance);
+            }
+        }
+        skinnedRenderablesDirty = false;
+    }
+    return skinnedRenderables;
+}
+
+void AnimatorImpl::setLevelOfDetail(const Animator::LevelOfDetail& lod) {
+    lodInterval = lod.updateInterval;
+    lodVisible = lod.visible;
+    hasLodMask = lod.mask != nullptr;
+    lodMask.clear();
+    for (size_t i = 0; i < lod.maskCount; ++i) {
+        lodMask.insert(lod.mask[i]);
+    }
+    for (Animation& anim : animations) {
+        for (Channel& channel : anim.channels) {
+            // Material and light channels do not target a node, so the mask does not apply.
+            channel.culled = hasLodMask && channel.transformType <= AnimationClip::WEIGHTS &&
+                    lodMask.find(channel.targetEntity) == lodMask.end();
+        }
+    }
+
+    // Start over from a full evaluation.
+    intervalAnimation = std::numeric_limits<size_t>::max();
+}
+
+void AnimatorImpl::applyAnimationLayers(const Animator::AnimationLayer* layers, size_t count) {
+    layeredTransforms.clear();
+    layeredTransformIndices.clear();
+    layeredMorphWeights.clear();
+    layeredMorphWeightIndices.clear();
+
+    for (size_t l = 0; l < count; ++l) {
+        const Animator::AnimationLayer& layer = layers[l];
+        if (layer.weight <= 0.0f) {
+            continue;
+        }
+        Animation& anim = animations[layer.animationIndex];
+        const float time = fmod(layer.time, anim.clip->duration);
+
+        layerMask.clear();
+        for (size_t i = 0; i < layer.maskCount; ++i) {
+            layerMask.insert(layer.mask[i]);
+        }
+
+        sampleChannels(anim, time, time, &layer);
+
+        evaluateChannelBatches();
+        for (ChannelBatch& batch : batches) {
+            for (size_t i = 0, n = batch.channels.size(); i < n; ++i) {
+                const Channel& channel = *batch.channels[i];
+                if (channel.transformType <= AnimationClip::SCALE) {
+                    accumulateTransform(channel, batch.results[i], layer);
+                    continue;
+                }
+                // Each layer blends the properties towards its own value, starting from the value
+                // of the layers below it.
+                const PropertySlot& slot = propertySlots[channel.propertySlot];
+                writeProperty(channel, slot.dirty ?
+                        mix(slot.value, batch.results[i], std::min(layer.weight, 1.0f)) :
+                        batch.results[i]);
+            }
+        }
+        clearChannelBatches();
+    }
+
+    // Each affected node is written exactly once, regardless of the number of layers.
+    stats.nodesComposed += uint32_t(layeredTransforms.size());
+    transformManager->openLocalTransformTransaction();
+    for (const LayeredTransform& dst : layeredTransforms) {
+        auto trsNode = trsTransformManager->getInstance(dst.entity);
+        trsTransformManager->setTrs(trsNode, dst.trs.translation, dst.trs.rotation,
+                dst.trs.scale);
+        TransformManager::Instance node = transformManager->getInstance(dst.entity);
+        transformManager->setTransform(node, trsTransformManager->getTransform(trsNode));
+    }
+    transformManager->commitLocalTransformTransaction();
+
+    for (const LayeredMorphWeights& dst : layeredMorphWeights) {
+        auto ci = renderableManager->getInstance(dst.entity);
+        renderableManager->setMorphWeights(ci, dst.weights.data(), dst.weights.size());
+        stats.morphWeightsUploaded += uint32_t(dst.weights.size());
+        stats.bytesUploaded += dst.weights.size() * sizeof(float);
+    }
+    flushProperties();
+}
+
+// Returns the value of the first keyframe of the given channel, which is the reference pose that
+// additive layers are relative to.
+static float4 getReferenceValue(const Channel& channel) {
+    const Sampler* sampler = channel.sourceData;
+    const bool isRotation = channel.transformType == AnimationClip::ROTATION;
+    if (sampler->isCompressed()) {
+        return isRotation ? decodeRotation(*sampler, 0) : decodeVector(*sampler, 0);
+    }
+    const size_t key = sampler->interpolation == Sampler::CUBIC ? 1 : 0;
+    if (isRotation) {
+        return ((const quatf*) sampler->values.data())[key].xyzw;
+    }
+    return float4{ ((const float3*) sampler->values.data())[key], 0 };
+}
+
+void AnimatorImpl::accumulateTransform(const Channel& channel, float4 value,
+        const Animator::AnimationLayer& layer) {
+    const Entity entity = channel.targetEntity;
+    auto iter = layeredTransformIndices.find(entity);
+    if (iter == layeredTransformIndices.end()) {
+        auto rest = restPose.find(entity);
+        if (rest == restPose.end()) {
+            return;
+        }
+        iter = layeredTransformIndices.emplace(entity, uint32_t(layeredTransforms.size())).first;
+        layeredTransforms.push_back({ entity, rest->second });
+    }
+    TrsStash& pose = layeredTransforms[iter->second].trs;
+    const float weight = std::min(layer.weight, 1.0f);
+
+    switch (channel.transformType) {
+        case AnimationClip::TRANSLATION:
+            if (layer.additive) {
+                pose.translation += weight * (value.xyz - getReferenceValue(channel).xyz);
+            } else {
+                pose.translation = mix(pose.translation, value.xyz, weight);
+            }
+            break;
+        case AnimationClip::ROTATION:
+            if (layer.additive) {
+                const quatf delta = inverse(quatf{ getReferenceValue(channel) }) * quatf{ value };
+                pose.rotation = normalize(pose.rotation * slerp(quatf{ 1 }, delta, weight));
+            } else {
+                pose.rotation = slerp(pose.rotation, quatf{ value }, weight);
+            }
+            break;
+        case AnimationClip::SCALE:
+            if (layer.additive) {
+                const float3 reference = getReferenceValue(channel).xyz;
+                float3 ratio = 1.0f;
+                for (size_t c = 0; c < 3; ++c) {
+                    if (reference[c] != 0.0f) {
+                        ratio[c] = value[c] / reference[c];
+                    }
+                }
+                pose.scale *= mix(float3{ 1 }, ratio, weight);
+            } else {
+                pose.scale = mix(pose.scale, value.xyz, weight);
+            }
+            break;
+        case AnimationClip::WEIGHTS:
+        case AnimationClip::MATERIAL:
+        case AnimationClip::LIGHT:
+            break;
+    }
+}
+
+void AnimatorImpl::accumulateMorphWeights(const Channel& channel,
+        const Animator::AnimationLayer& layer) {
+    const Entity entity = channel.targetEntity;
+    auto iter = layeredMorphWeightIndices.find(entity);
+    if (iter == layeredMorphWeightIndices.end()) {
+        iter = layeredMorphWeightIndices.emplace(entity,
+                uint32_t(layeredMorphWeights.size())).first;
+        layeredMorphWeights.push_back({ entity, {} });
+    }
+
+    // Morph weights start from zero, which corresponds to the base mesh.
+    vector<float>& dst = layeredMorphWeights[iter->second].weights;
+    if (dst.size() < weights.size()) {
+        dst.resize(weights.size(), 0.0f);
+    }
+    const float weight = std::min(layer.weight, 1.0f);
+    if (layer.additive) {
+        sampledWeights = weights;
+        const Sampler& sampler = *channel.sourceData;
+        const float* reference = sampler.values.data();
+        if (sampler.interpolation == Sampler::CUBIC) {
+            computeMorphWeights<Sampler::CUBIC>(sampler, 0.0f, reference, reference,
+                    weights.data());
+        } else {
+            computeMorphWeights<Sampler::LINEAR>(sampler, 0.0f, reference, reference,
+                    weights.data());
+        }
+        for (size_t i = 0, n = sampledWeights.size(); i < n; ++i) {
+            dst[i] += weight * (sampledWeights[i] - weights[i]);
+        }
+    } else {
+        for (size_t i = 0, n = weights.size(); i < n; ++i) {
+            dst[i] = mix(dst[i], weights[i], weight);
+        }
+    }
+}
+
+void AnimatorImpl::flushMorphWeights() {
+    for (uint32_t index : dirtyMorphSlots) {
+        MorphSlot& slot = morphSlots[index];
+        auto ci = renderableManager->getInstance(slot.entity);
+        renderableManager->setMorphWeights(ci, morphWeights.data() + slot.offset, slot.count);
+        stats.morphWeightsUploaded += slot.count;
+        stats.bytesUploaded += slot.count * sizeof(float);
+        slot.dirty = false;
+    }
+    dirtyMorphSlots.clear();
+}
+
+// Returns the name of the material parameter that holds the given property, which matches the
+// names used by the materials that AssetLoader creates.
+static const char* getParameterName(AnimationClip::Property property) {
+    switch (property) {
+        case AnimationClip::BASE_COLOR_FACTOR: return "baseColorFactor";
+        case AnimationClip::METALLIC_FACTOR: return "metallicFactor";
+        case AnimationClip::ROUGHNESS_FACTOR: return "roughnessFactor";
+        case AnimationClip::EMISSIVE_FACTOR: return "emissiveFactor";
+        case AnimationClip::EMISSIVE_STRENGTH: return "emissiveStrength";
+        case AnimationClip::NORMAL_SCALE: return "normalScale";
+        case AnimationClip::OCCLUSION_STRENGTH: return "aoStrength";
+        default: return nullptr;
+    }
+}
+
+bool AnimatorImpl::bindProperty(const FixedCapacityVector<Entity>& nodeMap,
+        const AnimationClip::Track& track, Channel& dst) {
+    // Materials and lights are found through the glTF hierarchy, which must still be available.
+    const cgltf_data* gltf = (const cgltf_data*) asset->getSourceAsset();
+    if (!gltf) {
+        if (GLTFIO_VERBOSE) {
+            slog.w << "Material and light channels cannot be bound after releaseSourceData."
+                   << io::endl;
+        }
+        return false;
+    }
+
+    PropertySlot slot = { track.property, {}, {}, 1.0f, {}, false };
+    const size_t nodeCount = std::min(size_t(gltf->nodes_count), size_t(nodeMap.size()));
+    if (track.path == AnimationClip::MATERIAL) {
+        if (track.node >= gltf->materials_count) {
+            return false;
+        }
+        const cgltf_material* material = gltf->materials + track.node;
+        const char* name = getParameterName(track.property);
+
+        // Primitives of a renderable are in the same order as those of its glTF mesh.
+        for (size_t i = 0; i < nodeCount; ++i) {
+            const cgltf_mesh* mesh = gltf->nodes[i].mesh;
+            auto renderable = renderableManager->getInstance(nodeMap[i]);
+            if (!mesh || !renderable) {
+                continue;
+            }
+            const size_t primitiveCount = std::min(size_t(mesh->primitives_count),
+                    renderableManager->getPrimitiveCount(renderable));
+            for (size_t p = 0; p < primitiveCount; ++p) {
+                if (mesh->primitives[p].material != material) {
+                    continue;
+                }
+                MaterialInstance* mi = renderableManager->getMaterialInstanceAt(renderable, p);
+                if (!mi || std::find(slot.materials.begin(), slot.materials.end(), mi) !=
+                        slot.materials.end()) {
+                    continue;
+                }
+                // Materials that do not expose the property, such as unlit or opaque materials,
+                // are left alone.
+                const Material* ma = mi->getMaterial();
+                if (name ? ma->hasParameter(name) :
+                        ma->getBlendingMode() == BlendingMode::MASKED) {
+                    slot.materials.push_back(mi);
+                }
+            }
+        }
+
+        // AssetLoader folds the emissive strength into the emissive factor.
+        if (track.property == AnimationClip::EMISSIVE_FACTOR && material->has_emissive_strength) {
+            slot.scale = material->emissive_strength.emissive_strength;
+        }
+    } else {
+        if (track.node >= gltf->lights_count) {
+            return false;
+        }
+        for (size_t i = 0; i < nodeCount; ++i) {
+            if (gltf->nodes[i].light == gltf->lights + track.node &&
+                    lightManager->hasComponent(nodeMap[i])) {
+                slot.lights.push_back(nodeMap[i]);
+            }
+        }
+    }
+    if (slot.materials.empty() && slot.lights.empty()) {
+        return false;
+    }
+
+    dst.targetEntity = slot.lights.empty() ? Entity() : slot.lights.front();
+    dst.transformType = track.path;
+    dst.propertySlot = uint32_t(propertySlots.size());
+    propertySlots.push_back(std::move(slot));
+    return true;
+}
+
+void AnimatorImpl::writeProperty(const Channel& channel, float4 value) {
+    PropertySlot& slot = propertySlots[channel.propertySlot];
+    slot.value = value;
+    if (!slot.dirty) {
+        slot.dirty = true;
+        dirtyPropertySlots.push_back(channel.propertySlot);
+    }
+}
+
+void AnimatorImpl::flushProperties() {
+    for (uint32_t index : dirtyPropertySlots) {
+        PropertySlot& slot = propertySlots[index];
+        const float4 value = slot.value;
+        const char* name = getParameterName(slot.property);
+        for (MaterialInstance* mi : slot.materials) {
+            switch (slot.property) {
+                case AnimationClip::BASE_COLOR_FACTOR:
+                    mi->setParameter(name, value);
+                    break;
+                case AnimationClip::EMISSIVE_FACTOR:
+                    mi->setParameter(name, value.xyz * slot.scale);
+                    break;
+                case AnimationClip::ALPHA_CUTOFF:
+                    mi->setMaskThreshold(value.x);
+                    break;
+                default:
+                    mi->setParameter(name, value.x);
+                    break;
+            }
+        }
+        for (Entity entity : slot.lights) {
+            auto light = lightManager->getInstance(entity);
+            if (slot.property == AnimationClip::LIGHT_COLOR) {
+                lightManager->setColor(light, value.xyz);
+            } else if (lightManager->isDirectional(light)) {
+                lightManager->setIntensity(light, value.x);
+            } else {
+                lightManager->setIntensityCandela(light, value.x);
+            }
+        }
+        slot.dirty = false;
+    }
+    dirtyPropertySlots.clear();
+}
+
+const vector<Entity>& AnimatorImpl::getTransformTargets(Animation& anim) {
+    if (anim.transformTargetsDirty) {
+        vector<Entity>& targets = anim.transformTargets;
+        targets.clear();
+        for (const Channel& channel : anim.channels) {
+            if (channel.transformType <= AnimationClip::SCALE) {
+                targets.push_back(channel.targetEntity);
+            }
+        }
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+        anim.transformTargetsDirty = false;
+    }
+    return anim.transformTargets;
+}
+
+void AnimatorImpl::stashCrossFade(size_t previousAnimIndex) {
+    // Applying the previous animation can only modify the nodes that it targets, so these are the
+    // only nodes whose transforms need to be blended.
+    const vector<Entity>& targets = getTransformTargets(animations[previousAnimIndex]);
+    crossFade.resize(targets.size());
+    for (size_t i = 0, n = targets.size(); i < n; ++i) {
+        auto trsNode = trsTransformManager->getInstance(targets[i]);
+        crossFade[i].translation = trsTransformManager->getTranslation(trsNode);
+        crossFade[i].rotation = trsTransformManager->getRotation(trsNode);
+        crossFade[i].scale = trsTransformManager->getScale(trsNode);
+    }
+}
+
+void AnimatorImpl::applyCrossFade(size_t previousAnimIndex, float alpha) {
+    const vector<Entity>& targets = getTransformTargets(animations[previousAnimIndex]);
+    assert_invariant(targets.size() == crossFade.size());
+    stats.nodesComposed += uint32_t(targets.size());
+    transformManager->openLocalTransformTransaction();
+    for (size_t i = 0, n = targets.size(); i < n; ++i) {
+        auto trsNode = trsTransformManager->getInstance(targets[i]);
+        const TrsStash& current = crossFade[i];
+        const float3 translation = mix(trsTransformManager->getTranslation(trsNode),
+                current.translation, alpha);
+        const quatf rotation = slerp(trsTransformManager->getRotation(trsNode),
+                current.rotation, alpha);
+        const float3 scale = mix(trsTransformManager->getScale(trsNode), current.scale, alpha);
+        trsTransformManager->setTrs(trsNode, translation, rotation, scale);
+        TransformManager::Instance node = transformManager->getInstance(targets[i]);
+        transformManager->setTransform(node, trsTransformManager->getTransform(trsNode));
+    }
+    transformManager->commitLocalTransformTransaction();
+}
+
+void AnimatorImpl::captureRestPose(const FixedCapacityVector<Entity>& nodeMap) {
+    for (Entity entity : nodeMap) {
+        auto trsNode = trsTransformManager->getInstance(entity);
+        if (!trsNode) {
+            continue;
+        }
+        restPose[entity] = {
+            trsTransformManager->getTranslation(trsNode),
+            trsTransformManager->getRotation(trsNode),
+            trsTransformManager->getScale(trsNode),
+        };
+    }
+}
+
+void AnimatorImpl::addAnimation(AnimationClipHandle clip,
+        FixedCapacityVector<uint32_t> targetNodes) {
+    Animation& dst = animations.emplace_back();
+    dst.clip = std::move(clip);
+    dst.targetNodes = std::move(targetNodes);
+    if (instance) {
+        addChannels(instance->mNodeMap, dst);
+    } else {
+        for (FFilamentInstance* instance : asset->mInstances) {
+            addChannels(instance->mNodeMap, dst);
+        }
+    }
+}
+
+void AnimatorImpl::addChannels(const FixedCapacityVector<Entity>& nodeMap, Animation& dst) {
+    const AnimationClip& clip = *dst.clip;
+    dst.transformTargetsDirty = true;
+    dst.channels.reserve(dst.channels.size() + clip.tracks.size());
+    for (size_t j = 0, ntracks = clip.tracks.size(); j < ntracks; ++j) {
+        const AnimationClip::Track& track = clip.tracks[j];
+        const Sampler& sampler = clip.samplers[track.sampler];
+        if (sampler.times.empty() || sampler.valuesPerKey == 0) {
+            continue;
+        }
+        if (track.path > AnimationClip::WEIGHTS) {
+            // Retargeted clips come from a different asset, whose materials and lights are unknown.
+            Channel dstChannel;
+            if (dst.targetNodes.empty() && bindProperty(nodeMap, track, dstChannel)) {
+                dstChannel.sourceData = clip.samplers.data() + track.sampler;
+                if (dstChannel.sourceData->isStreamed()) {
+                    dstChannel.stream = clip.stream.get();
+                }
+                dst.channels.push_back(dstChannel);
+            }
+            continue;
+        }
+        const uint32_t node = dst.targetNodes.empty() ? track.node : dst.targetNodes[j];
+        Entity targetEntity = node < nodeMap.size() ? nodeMap[node] : Entity();
         if (UTILS_UNLIKELY(!targetEntity)) {
             if (GLTFIO_VERBOSE) {
                 slog.w << "No scene root contains node ";
-                if (srcChannel.target_node->name) {
-                    slog.w << "'" << srcChannel.target_node->name << "' ";
+                if (!clip.targetNames[j].empty()) {
+                    slog.w << "'" << clip.targetNames[j].c_str() << "' ";
                 }
                 slog.w << "for animation ";
-                if (srcAnim.name) {
-                    slog.w << "'" << srcAnim.name << "' ";
+                if (!clip.name.empty()) {
+                    slog.w << "'" << clip.name.c_str() << "' ";
                 }
                 slog.w << "in channel " << j << io::endl;
             }
             continue;
         }
         Channel dstChannel;
-        dstChannel.sourceData = samplers + (srcChannel.sampler - srcSamplers);
+        dstChannel.sourceData = clip.samplers.data() + track.sampler;
+        if (dstChannel.sourceData->isStreamed()) {
+            dstChannel.stream = clip.stream.get();
+        }
         dstChannel.targetEntity = targetEntity;
-        setTransformType(srcChannel, dstChannel);
+        dstChannel.transformType = track.path;
+        dstChannel.culled = hasLodMask && lodMask.find(targetEntity) == lodMask.end();
+        if (track.path == AnimationClip::WEIGHTS) {
+            dstChannel.morphSlot = getMorphSlot(targetEntity,
+                    getMorphTargetCount(*dstChannel.sourceData));
+        } else {
+            dstChannel.transformSlot = getTransformSlot(targetEntity);
+        }
         dst.channels.push_back(dstChannel);
     }
+    groupChannels(dst);
 }
 
-void AnimatorImpl::applyAnimation(const Channel& channel, float t, size_t prevIndex,
-        size_t nextIndex) {
-    const Sampler* sampler = channel.sourceData;
-    const TimeValues& times = sampler->times;
-    TrsTransformManager::Instance trsNode = trsTransformManager->getInstance(channel.targetEntity);
-    TransformManager::Instance node = transformManager->getInstance(channel.targetEntity);
+void AnimatorImpl::groupChannels(Animation& anim) {
+    for (Channel& channel : anim.channels) {
+        channel.group = getChannelGroup(channel);
+        if (channel.group == CONSTANT_TRANSFORM) {
+            channel.constantValue = getReferenceValue(channel);
+        } else if (channel.group == CONSTANT_PROPERTY) {
+            const Sampler* sampler = channel.sourceData;
+            const size_t n = getComponentCount(propertySlots[channel.propertySlot].property);
+            channel.constantValue = loadValue<PROPERTY>(sampler->values.data(),
+                    sampler->interpolation == Sampler::CUBIC ? 1 : 0, n);
+        }
+    }
 
-    switch (channel.transformType) {
+    // glTF does not allow two channels of an animation to target the same property of a node, so
+    // the order in which the groups are evaluated does not matter.
+    std::stable_sort(anim.channels.begin(), anim.channels.end(),
+            [](const Channel& a, const Channel& b) { return a.group < b.group; });
+    std::fill(std::begin(anim.groupOffsets), std::end(anim.groupOffsets), 0);
+    for (const Channel& channel : anim.channels) {
+        anim.groupOffsets[channel.group + 1]++;
+    }
+    for (size_t group = 0; group < CHANNEL_GROUP_COUNT; ++group) {
+        anim.groupOffsets[group + 1] += anim.groupOffsets[group];
+    }
+}
 
-        case Channel::SCALE: {
-            float3 scale;
-            const float3* srcVec3 = (const float3*) sampler->values.data();
-            if (sampler->interpolation == Sampler::CUBIC) {
-                float3 vert0 = srcVec3[prevIndex * 3 + 1];
-                float3 tang0 = srcVec3[prevIndex * 3 + 2];
-                float3 tang1 = srcVec3[nextIndex * 3];
-                float3 vert1 = srcVec3[nextIndex * 3 + 1];
-                scale = cubicSpline(vert0, tang0, vert1, tang1, t);
-            } else {
-                scale = ((1 - t) * srcVec3[prevIndex]) + (t * srcVec3[nextIndex]);
+FixedCapacityVector<uint32_t> AnimatorImpl::resolveTargetsByName(const AnimationClip& clip,
+        const Animator::NameMapping* remap, size_t remapCount) const {
+    FixedCapacityVector<uint32_t> targets(clip.tracks.size(), Animation::UNBOUND_NODE);
+
+    // Node indices are the same for every instance of the asset, so we can use any instance to
+    // map the names of the asset's entities to node indices.
+    FFilamentInstance const* reference = instance;
+    if (!reference) {
+        if (asset->mInstances.empty()) {
+            return targets;
+        }
+        reference = asset->mInstances.front();
+    }
+    tsl::robin_map<Entity, uint32_t, Entity::Hasher> entityToNode;
+    const auto& nodeMap = reference->mNodeMap;
+    for (uint32_t i = 0, n = nodeMap.size(); i < n; ++i) {
+        if (nodeMap[i]) {
+            entityToNode[nodeMap[i]] = i;
+        }
+    }
+    tsl::robin_map<std::string_view, uint32_t> nameToNode;
+    for (const auto& [name, entities] : asset->mNameToEntity) {
+        for (Entity entity : entities) {
+            if (auto iter = entityToNode.find(entity); iter != entityToNode.end()) {
+                nameToNode.emplace(name, iter->second);
+                break;
             }
-            trsTransformManager->setScale(trsNode, scale);
-            break;
         }
+    }
 
-        case Channel::TRANSLATION: {
-            float3 translation;
-            const float3* srcVec3 = (const float3*) sampler->values.data();
-            if (sampler->interpolation == Sampler::CUBIC) {
-                float3 vert0 = srcVec3[prevIndex * 3 + 1];
-                float3 tang0 = srcVec3[prevIndex * 3 + 2];
-                float3 tang1 = srcVec3[nextIndex * 3];
-                float3 vert1 = srcVec3[nextIndex * 3 + 1];
-                translation = cubicSpline(vert0, tang0, vert1, tang1, t);
-            } else {
-                translation = ((1 - t) * srcVec3[prevIndex]) + (t * srcVec3[nextIndex]);
+    tsl::robin_map<std::string_view, std::string_view> renames;
+    for (size_t i = 0; i < remapCount; ++i) {
+        if (remap[i].source && remap[i].target) {
+            renames[remap[i].source] = remap[i].target;
+        }
+    }
+
+    for (size_t j = 0, ntracks = clip.tracks.size(); j < ntracks; ++j) {
+        std::string_view name = clip.targetNames[j].c_str_safe();
+        if (auto iter = renames.find(name); iter != renames.end()) {
+            name = iter->second;
+        }
+        if (auto iter = nameToNode.find(name); !name.empty() && iter != nameToNode.end()) {
+            targets[j] = iter->second;
+        }
+    }
+    return targets;
+}
+
+// One sampler per group, which must follow the numbering of ChannelGroup. Compressed samplers
+// are never cubic.
+const AnimatorImpl::GroupSampler AnimatorImpl::GROUP_SAMPLERS[CHANNEL_GROUP_COUNT] = {
+    &AnimatorImpl::sampleConstantGroup<VECTOR>,
+    &AnimatorImpl::sampleConstantGroup<PROPERTY>,
+    &AnimatorImpl::sampleGroup<Sampler::LINEAR, VECTOR>,
+    &AnimatorImpl::sampleGroup<Sampler::LINEAR, ROTATION>,
+    &AnimatorImpl::sampleGroup<Sampler::LINEAR, QUANTIZED_VECTOR>,
+    &AnimatorImpl::sampleGroup<Sampler::LINEAR, QUANTIZED_ROTATION>,
+    &AnimatorImpl::sampleGroup<Sampler::LINEAR, PROPERTY>,
+    &AnimatorImpl::sampleGroup<Sampler::LINEAR, WEIGHTS>,
+    &AnimatorImpl::sampleGroup<Sampler::STEP, VECTOR>,
+    &AnimatorImpl::sampleGroup<Sampler::STEP, ROTATION>,
+    &AnimatorImpl::sampleGroup<Sampler::STEP, QUANTIZED_VECTOR>,
+    &AnimatorImpl::sampleGroup<Sampler::STEP, QUANTIZED_ROTATION>,
+    &AnimatorImpl::sampleGroup<Sampler::STEP, PROPERTY>,
+    &AnimatorImpl::sampleGroup<Sampler::STEP, WEIGHTS>,
+    &AnimatorImpl::sampleGroup<Sampler::CUBIC, VECTOR>,
+    &AnimatorImpl::sampleGroup<Sampler::CUBIC, ROTATION>,
+    nullptr,
+    nullptr,
+    &AnimatorImpl::sampleGroup<Sampler::CUBIC, PROPERTY>,
+    &AnimatorImpl::sampleGroup<Sampler::CUBIC, WEIGHTS>,
+};
+
+// Samples the channels of the given animation, where transforms are sampled at transformTime and
+// morph weights and properties at the given time. Transforms and properties are gathered into the
+// batches, while morph weights are either written into their slot or, for layers, accumulated.
+void AnimatorImpl::sampleChannels(Animation& anim, float time, float transformTime,
+        const Animator::AnimationLayer* layer) {
+    Channel* channels = anim.channels.data();
+    for (size_t group = 0; group < CHANNEL_GROUP_COUNT; ++group) {
+        const uint32_t begin = anim.groupOffsets[group];
+        const uint32_t end = anim.groupOffsets[group + 1];
+        if (begin == end) {
+            continue;
+        }
+        const ValueType type = getValueType(group);
+        // Properties have no rest value to be relative to, so additive layers skip them.
+        if (type == PROPERTY && layer && layer->additive) {
+            continue;
+        }
+        const bool isTransform = type < PROPERTY;
+        (this->*GROUP_SAMPLERS[group])(channels + begin, channels + end,
+                isTransform ? transformTime : time, layer);
+    }
+}
+
+// Returns true if the given layer has a mask that excludes the target of the given channel.
+bool AnimatorImpl::isMasked(const Channel& channel, const Animator::AnimationLayer* layer) const {
+    return layer && layer->mask && layerMask.find(channel.targetEntity) == layerMask.end();
+}
+
+template<Sampler::Interpolation I, ValueType V>
+void AnimatorImpl::sampleGroup(Channel* begin, Channel* end, float time,
+        const Animator::AnimationLayer* layer) {
+    // Step interpolation is a linear interpolation with t = 0, which yields the previous keyframe
+    // exactly, so step rotations do not need to go through the slerp kernel.
+    constexpr bool isRotation = V == ROTATION || V == QUANTIZED_ROTATION;
+    constexpr BatchKind kind = I == Sampler::CUBIC ? (isRotation ? CUBIC_ROTATION : CUBIC) :
+            (I == Sampler::LINEAR && isRotation ? LINEAR_ROTATION : LINEAR);
+    ChannelBatch& batch = batches[kind];
+
+    for (Channel* channel = begin; channel != end; ++channel) {
+        // Material and light channels do not target a node, so masks do not apply.
+        if constexpr (V != PROPERTY) {
+            if (channel->culled || isMasked(*channel, layer)) {
+                continue;
             }
-            trsTransformManager->setTranslation(trsNode, translation);
-            break;
         }
+        float t;
+        size_t prevIndex, nextIndex;
+        findKeyframes<I>(*channel, time, &t, &prevIndex, &nextIndex, stats);
+        const Sampler* sampler = channel->sourceData;
 
-        case Channel::ROTATION: {
-            quatf rotation;
-            const quatf* srcQuat = (const quatf*) sampler->values.data();
-            if (sampler->interpolation == Sampler::CUBIC) {
-                quatf vert0 = srcQuat[prevIndex * 3 + 1];
-                quatf tang0 = srcQuat[prevIndex * 3 + 2];
-                quatf tang1 = srcQuat[nextIndex * 3];
-                quatf vert1 = srcQuat[nextIndex * 3 + 1];
-                rotation = normalize(cubicSpline(vert0, tang0, vert1, tang1, t));
+        if constexpr (V == WEIGHTS) {
+            if (!layer) {
+                applyMorphWeights<I>(*channel, t, prevIndex, nextIndex);
+                continue;
+            }
+            weights.resize(getMorphTargetCount(*sampler));
+            computeMorphWeights<I>(*sampler, t, getKeyValues(*channel, prevIndex),
+                    getKeyValues(*channel, nextIndex), weights.data());
+            accumulateMorphWeights(*channel, *layer);
+            continue;
+        } else if constexpr (V == QUANTIZED_VECTOR) {
+            batch.vert0.push_back(decodeVector(*sampler, prevIndex));
+            batch.vert1.push_back(decodeVector(*sampler, nextIndex));
+        } else if constexpr (V == QUANTIZED_ROTATION) {
+            batch.vert0.push_back(decodeRotation(*sampler, prevIndex));
+            batch.vert1.push_back(decodeRotation(*sampler, nextIndex));
+        } else {
+            size_t n = 0;
+            if constexpr (V == PROPERTY) {
+                n = getComponentCount(propertySlots[channel->propertySlot].property);
+            }
+            const float* prev = getKeyValues(*channel, prevIndex);
+            const float* next = getKeyValues(*channel, nextIndex);
+            if constexpr (I == Sampler::CUBIC) {
+                batch.vert0.push_back(loadValue<V>(prev, 1, n));
+                batch.tang0.push_back(loadValue<V>(prev, 2, n));
+                batch.tang1.push_back(loadValue<V>(next, 0, n));
+                batch.vert1.push_back(loadValue<V>(next, 1, n));
             } else {
-                rotation = slerp(srcQuat[prevIndex], srcQuat[nextIndex], t);
+                batch.vert0.push_back(loadValue<V>(prev, 0, n));
+                batch.vert1.push_back(loadValue<V>(next, 0, n));
             }
-            trsTransformManager->setRotation(trsNode, rotation);
-            break;
         }
+        batch.channels.push_back(channel);
+        batch.t.push_back(t);
+    }
+}
 
-        case Channel::WEIGHTS: {
-            const float* const samplerValues = sampler->values.data();
-            assert(sampler->values.size() % times.size() == 0);
-            const int valuesPerKeyframe = sampler->values.size() / times.size();
-
-            if (sampler->interpolation == Sampler::CUBIC) {
-                assert(valuesPerKeyframe % 3 == 0);
-                const int numMorphTargets = valuesPerKeyframe / 3;
-                const float* const inTangents = samplerValues;
-                const float* const splineVerts = samplerValues + numMorphTargets;
-                const float* const outTangents = samplerValues + numMorphTargets * 2;
-
-                weights.resize(numMorphTargets);
-                for (int comp = 0; comp < numMorphTargets; ++comp) {
-                    float vert0 = splineVerts[comp + prevIndex * valuesPerKeyframe];
-                    float tang0 = outTangents[comp + prevIndex * valuesPerKeyframe];
-                    float tang1 = inTangents[comp + nextIndex * valuesPerKeyframe];
-                    float vert1 = splineVerts[comp + nextIndex * valuesPerKeyframe];
-                    weights[comp] = cubicSpline(vert0, tang0, vert1, tang1, t);
-                }
-            } else {
-                weights.resize(valuesPerKeyframe);
-                for (int comp = 0; comp < valuesPerKeyframe; ++comp) {
-                    float previous = samplerValues[comp + prevIndex * valuesPerKeyframe];
-                    float current = samplerValues[comp + nextIndex * valuesPerKeyframe];
-                    weights[comp] = (1 - t) * previous + t * current;
+template<ValueType V>
+void AnimatorImpl::sampleConstantGroup(Channel* begin, Channel* end, float,
+        const Animator::AnimationLayer* layer) {
+    ChannelBatch& batch = batches[CONSTANT];
+    for (Channel* channel = begin; channel != end; ++channel) {
+        if constexpr (V != PROPERTY) {
+            if (channel->culled || isMasked(*channel, layer)) {
+                continue;
+            }
+        }
+        stats.channelsEvaluated++;
+        batch.vert0.push_back(channel->constantValue);
+        batch.channels.push_back(channel);
+    }
+}
+
+void AnimatorImpl::evaluateChannelBatches() {
+    for (size_t kind = 0; kind < BATCH_COUNT; ++kind) {
+        ChannelBatch& batch = batches[kind];
+        const size_t count = batch.channels.size();
+        if (count == 0) {
+            continue;
+        }
+        batch.results.resize(count);
+        float4* results = batch.results.data();
+        switch (kind) {
+            case LINEAR:
+                kernels::lerp(results, batch.vert0.data(), batch.vert1.data(), batch.t.data(),
+                        count);
+                break;
+            case LINEAR_ROTATION:
+                kernels::slerp(results, batch.vert0.data(), batch.vert1.data(), batch.t.data(),
+                        count);
+                break;
+            case CUBIC:
+            case CUBIC_ROTATION:
+                kernels::cubicSpline(results, batch.vert0.data(), batch.tang0.data(),
+                        batch.vert1.data(), batch.tang1.data(), batch.t.data(), count);
+                if (kind == CUBIC_ROTATION) {
+                    kernels::normalize(results, count);
                 }
+                break;
+            case CONSTANT:
+                std::copy_n(batch.vert0.data(), count, results);
+                break;
+        }
+    }
+}
+
+void AnimatorImpl::clearChannelBatches() {
+    for (ChannelBatch& batch : batches) {
+        batch.channels.clear();
+        batch.vert0.clear();
+        batch.tang0.clear();
+        batch.vert1.clear();
+        batch.tang1.clear();
+        batch.t.clear();
+    }
+}
+
+void AnimatorImpl::applyChannelBatches() {
+    evaluateChannelBatches();
+    for (ChannelBatch& batch : batches) {
+        const size_t count = batch.channels.size();
+        const float4* results = batch.results.data();
+        for (size_t i = 0; i < count; ++i) {
+            const Channel& channel = *batch.channels[i];
+            if (channel.transformType > AnimationClip::SCALE) {
+                writeProperty(channel, results[i]);
+                continue;
+            }
+            TransformSlot& slot = transformSlots[channel.transformSlot];
+            const uint8_t dirty = slot.dirty;
+            switch (channel.transformType) {
+                case AnimationClip::TRANSLATION:
+                    slot.trs.translation = results[i].xyz;
+                    slot.dirty |= TRANSLATION_BIT;
+                    break;
+                case AnimationClip::ROTATION:
+                    slot.trs.rotation = quatf{ results[i] };
+                    slot.dirty |= ROTATION_BIT;
+                    break;
+                case AnimationClip::SCALE:
+                    slot.trs.scale = results[i].xyz;
+                    slot.dirty |= SCALE_BIT;
+                    break;
+                case AnimationClip::WEIGHTS:
+                case AnimationClip::MATERIAL:
+                case AnimationClip::LIGHT:
+                    break;
             }
+            if (!dirty && slot.dirty) {
+                dirtyTransformSlots.push_back(channel.transformSlot);
+            }
+        }
+    }
+    clearChannelBatches();
 
-            auto ci = renderableManager->getInstance(channel.targetEntity);
-            renderableManager->setMorphWeights(ci, weights.data(), weights.size());
-            return;
+    // The local transforms are recomposed once all the components have been updated.
+    flushTransforms();
+}
+
+uint32_t AnimatorImpl::getTransformSlot(Entity entity) {
+    auto iter = transformSlotIndices.find(entity);
+    if (iter == transformSlotIndices.end()) {
+        iter = transformSlotIndices.emplace(entity, uint32_t(transformSlots.size())).first;
+        transformSlots.push_back({ entity, {}, 0 });
+    }
+    return iter->second;
+}
+
+void AnimatorImpl::flushTransforms() {
+    stats.nodesComposed += uint32_t(dirtyTransformSlots.size());
+    for (uint32_t index : dirtyTransformSlots) {
+        TransformSlot& slot = transformSlots[index];
+        auto trsNode = trsTransformManager->getInstance(slot.entity);
+        if (slot.dirty != TRS_BITS) {
+            // Components that no channel animated keep their current value.
+            if (!(slot.dirty & TRANSLATION_BIT)) {
+                slot.trs.translation = trsTransformManager->getTranslation(trsNode);
+            }
+            if (!(slot.dirty & ROTATION_BIT)) {
+                slot.trs.rotation = trsTransformManager->getRotation(trsNode);
+            }
+            if (!(slot.dirty & SCALE_BIT)) {
+                slot.trs.scale = trsTransformManager->getScale(trsNode);
+            }
         }
+        trsTransformManager->setTrs(trsNode, slot.trs.translation, slot.trs.rotation,
+                slot.trs.scale);
+        TransformManager::Instance node = transformManager->getInstance(slot.entity);
+        transformManager->setTransform(node, trsTransformManager->getTransform(trsNode));
+        slot.dirty = 0;
+    }
+    dirtyTransformSlots.clear();
+}
+
+template<Sampler::Interpolation I>
+void AnimatorImpl::applyMorphWeights(const Channel& channel, float t, size_t prevIndex,
+        size_t nextIndex) {
+    MorphSlot& slot = morphSlots[channel.morphSlot];
+    assert_invariant(getMorphTargetCount(*channel.sourceData) <= slot.count);
+    computeMorphWeights<I>(*channel.sourceData, t, getKeyValues(channel, prevIndex),
+            getKeyValues(channel, nextIndex), morphWeights.data() + slot.offset);
+    if (!slot.dirty) {
+        slot.dirty = true;
+        dirtyMorphSlots.push_back(channel.morphSlot);
     }
+}
 
-    transformManager->setTransform(node, trsTransformManager->getTransform(trsNode));
+uint32_t AnimatorImpl::getMorphSlot(Entity entity, size_t count) {
+    auto iter = morphSlotIndices.find(entity);
+    if (iter == morphSlotIndices.end()) {
+        iter = morphSlotIndices.emplace(entity, uint32_t(morphSlots.size())).first;
+        morphSlots.push_back({ entity, 0, 0, false });
+    }
+    MorphSlot& slot = morphSlots[iter->second];
+    if (slot.count < count) {
+        // This is rare since all channels that target a renderable normally have the same number
+        // of weights, so we simply move the slot to the end of the buffer.
+        slot.offset = uint32_t(morphWeights.size());
+        slot.count = uint32_t(count);
+        morphWeights.resize(morphWeights.size() + count, 0.0f);
+    }
+    return iter->second;
 }
 
 void AnimatorImpl::resetBoneMatrices(FFilamentInstance* instance) {
+    if (isSkinningFollower(instance)) {
+        return;
+    }
     for (const auto& skin : instance->mSkins) {
         size_t njoints = skin.joints.size();
         boneMatrices.resize(njoints);
@@ -536,39 +1881,152 @@ void AnimatorImpl::resetBoneMatrices(FFilamentInstance* instance) {
                 for (size_t boneIndex = 0; boneIndex < njoints; ++boneIndex) {
                     boneMatrices[boneIndex] = mat4f();
                 }
-                renderableManager->setBones(renderable, boneMatrices.data(), boneMatrices.size());
+                setBones(getSharedBuffer(instance, entity), renderable, boneMatrices.data(),
+                        boneMatrices.size());
             }
         }
     }
+
+    // The cached bones no longer reflect what the renderables use.
+    for (SkinnedTarget& target : skinnedTargets) {
+        target.valid = false;
+    }
+}
+
+SkinningBuffer* AnimatorImpl::getSharedBuffer(FFilamentInstance const* instance,
+        Entity entity) const {
+    if (SharedSkinning const* skinning = instance->mSharedSkinning) {
+        auto iter = skinning->leaderBuffers.find(entity);
+        if (iter != skinning->leaderBuffers.end()) {
+            return iter->second;
+        }
+    }
+    return nullptr;
 }
 
-void AnimatorImpl::updateBoneMatrices(FFilamentInstance* instance) {
+void AnimatorImpl::setBones(SkinningBuffer* sharedBuffer, RenderableManager::Instance renderable,
+        const mat4f* bones, size_t count, size_t offset) {
+    stats.bonesUploaded += uint32_t(count);
+    stats.bytesUploaded += count * sizeof(mat4f);
+    if (sharedBuffer) {
+        sharedBuffer->setBones(*asset->mEngine, bones, count, offset);
+    } else {
+        renderableManager->setBones(renderable, bones, count, offset);
+    }
+}
+
+static bool equal(const mat4& a, const mat4& b) noexcept {
+    return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+}
+
+void AnimatorImpl::computeBoneMatrices() {
+    skinnedTargetCount = 0;
+    if (!lodVisible) {
+        return;
+    }
+
+    // Without accurate translations, world transforms are computed in single precision, so the
+    // bones can be computed in single precision as well.
+    const bool accurate = transformManager->isAccurateTranslationsEnabled();
+
+    // If this is a single-instance animator, then update only this instance.
+    if (instance) {
+        computeBoneMatrices(instance, accurate);
+        return;
+    }
+
+    // If this is a broadcast animator, then update all instances.
+    for (FFilamentInstance* instance : asset->mInstances) {
+        computeBoneMatrices(instance, accurate);
+    }
+}
+
+void AnimatorImpl::computeBoneMatrices(FFilamentInstance* instance, bool accurate) {
     assert_invariant(instance->mSkins.size() == asset->mSkins.size());
+    if (isSkinningFollower(instance)) {
+        return;
+    }
+    const TransformManager& tm = *transformManager;
+    auto getWorldTransform = [&tm, accurate](TransformManager::Instance ci) {
+        return accurate ? tm.getWorldTransformAccurate(ci) : mat4{ tm.getWorldTransform(ci) };
+    };
+
     size_t skinIndex = 0;
     for (const auto& skin : instance->mSkins) {
         const auto& assetSkin = asset->mSkins[skinIndex++];
         size_t njoints = skin.joints.size();
-        boneMatrices.resize(njoints);
         for (Entity entity : skin.targets) {
             auto renderable = renderableManager->getInstance(entity);
             if (!renderable) {
                 continue;
             }
-            mat4 inverseGlobalTransform;
+            if (skinnedTargetCount == skinnedTargets.size()) {
+                skinnedTargets.emplace_back();
+            }
+            SkinnedTarget& target = skinnedTargets[skinnedTargetCount++];
+            if (target.renderable != renderable || target.bones.size() != njoints) {
+                target.renderable = renderable;
+                target.sharedBuffer = getSharedBuffer(instance, entity);
+                target.valid = false;
+            }
+
+            // If the renderable moved, all of its bones must be recomputed.
+            bool recomputeAll = !target.valid;
+            mat4 worldTransform;
             auto xformable = transformManager->getInstance(entity);
             if (xformable) {
-                inverseGlobalTransform = inverse(transformManager->getWorldTransformAccurate(xformable));
+                worldTransform = getWorldTransform(xformable);
+            }
+            if (recomputeAll || !equal(worldTransform, target.worldTransform)) {
+                target.worldTransform = worldTransform;
+                target.inverseWorldTransform = inverse(worldTransform);
+                target.inverseWorldTransformF = mat4f{ target.inverseWorldTransform };
+                recomputeAll = true;
+            }
+
+            target.jointTransforms.resize(njoints);
+            target.bones.resize(njoints);
+            if (recomputeAll) {
+                target.dirtyBegin = 0;
+                target.dirtyEnd = njoints;
             }
             for (size_t boneIndex = 0; boneIndex < njoints; ++boneIndex) {
                 const auto& joint = skin.joints[boneIndex];
-                const mat4f& inverseBindMatrix = assetSkin.inverseBindMatrices[boneIndex];
                 TransformManager::Instance jointInstance = transformManager->getInstance(joint);
-                mat4 globalJointTransform = transformManager->getWorldTransformAccurate(jointInstance);
-                boneMatrices[boneIndex] =
-                        mat4f{ inverseGlobalTransform * globalJointTransform } *
-                        inverseBindMatrix;
+                const mat4 globalJointTransform = getWorldTransform(jointInstance);
+                if (!recomputeAll &&
+                        equal(globalJointTransform, target.jointTransforms[boneIndex])) {
+                    continue;
+                }
+                target.jointTransforms[boneIndex] = globalJointTransform;
+                const mat4f& inverseBindMatrix = assetSkin.inverseBindMatrices[boneIndex];
+                if (accurate) {
+                    target.bones[boneIndex] =
+                            mat4f{ target.inverseWorldTransform * globalJointTransform } *
+                            inverseBindMatrix;
+                } else {
+                    target.bones[boneIndex] = target.inverseWorldTransformF *
+                            tm.getWorldTransform(jointInstance) * inverseBindMatrix;
+                }
+                const bool clean = target.dirtyBegin == target.dirtyEnd;
+                target.dirtyBegin = clean ? boneIndex : std::min(target.dirtyBegin, boneIndex);
+                target.dirtyEnd = std::max(target.dirtyEnd, boneIndex + 1);
             }
-            renderableManager->setBones(renderable, boneMatrices.data(), boneMatrices.size());
+            target.valid = true;
+        }
+    }
+}
+
+void AnimatorImpl::uploadBoneMatrices() {
+    for (size_t i = 0; i < skinnedTargetCount; ++i) {
+        SkinnedTarget& target = skinnedTargets[i];
+        // Only the range of bones that changed is uploaded, which is typically much smaller
+        // than the whole palette when a few joints are animated (e.g. facial rigs).
+        if (target.dirtyBegin < target.dirtyEnd) {
+            setBones(target.sharedBuffer, target.renderable,
+                    target.bones.data() + target.dirtyBegin,
+                    target.dirtyEnd - target.dirtyBegin, target.dirtyBegin);
+            target.dirtyBegin = target.dirtyEnd = 0;
         }
     }
 }
@@ -27,11 +27,8 @@
 #include <utils/Log.h>
 #include <utils/Panic.h>
 #include <utils/debug.h>
-#include <utils/memalign.h>
 #include <utils/ostream.h>
 
-#include <zstd.h>
-
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
@@ -60,17 +57,19 @@ static bool strIsEqual(const CString& a, const char* b) {
 
 void ArchiveCache::load(const void* archiveData, uint64_t archiveByteCount) {
     assert_invariant(mArchive == nullptr && "Do not call load() twice");
-    const uint64_t decompSize = ZSTD_getFrameContentSize(archiveData, archiveByteCount);
-    if (decompSize == ZSTD_CONTENTSIZE_UNKNOWN || decompSize == ZSTD_CONTENTSIZE_ERROR) {
-        PANIC_POSTCONDITION("Decompression error.");
-    }
-    uint64_t* basePointer = (uint64_t*) utils::aligned_alloc(decompSize, 8);
-    ZSTD_decompress(basePointer, decompSize, archiveData, archiveByteCount);
-    mArchive = (ReadableArchive*) basePointer;
-    convertOffsetsToPointers(mArchive);
+    mReader = std::make_unique<ArchiveReader>(archiveData, archiveByteCount);
+    mArchive = &mReader->getArchive();
     mMaterials = FixedCapacityVector<Material*>(mArchive->specsCount, nullptr);
 }
 
+Material* ArchiveCache::createMaterial(size_t specIndex) {
+    // the engine keeps its own copy of the package
+    FixedCapacityVector<uint8_t> const package = mReader->getPackage(specIndex);
+    return Material::Builder()
+        .package(package.data(), package.size())
+        .build(mEngine);
+}
+
 // This loops though all ubershaders and returns the first one that meets the given requirements.
 Material* ArchiveCache::getMaterial(const ArchiveRequirements& reqs) {
     assert_invariant(mArchive && "Please call load() before requesting any materials.");
@@ -132,9 +131,7 @@ Material* ArchiveCache::getMaterial(const ArchiveRequirements& reqs) {
 
         if (specIsSuitable) {
             if (mMaterials[i] == nullptr) {
-                mMaterials[i] = Material::Builder()
-                    .package(spec.package, spec.packageByteCount)
-                    .build(mEngine);
+                mMaterials[i] = createMaterial(i);
             }
 
             return mMaterials[i];
@@ -148,9 +145,7 @@ Material* ArchiveCache::getDefaultMaterial() {
     assert_invariant(!mMaterials.empty() && "Archive must have at least one material.");
     if (!mArchive) return nullptr;
     if (mMaterials[0] == nullptr) {
-        mMaterials[0] = Material::Builder()
-            .package(mArchive->specs[0].package, mArchive->specs[0].packageByteCount)
-            .build(mEngine);
+        mMaterials[0] = createMaterial(0);
     }
     return mMaterials[0];
 }
@@ -178,7 +173,6 @@ FeatureMap ArchiveCache::getFeatureMap(Material* material) const {
 ArchiveCache::~ArchiveCache() {
     assert_invariant(mMaterials.empty() &&
         "Please call destroyMaterials explicitly to ensure correct destruction order");
-    utils::aligned_free(mArchive);
 }
 
 } // namespace filament::gltfio
@@ -22,6 +22,7 @@
 
 #include <tsl/robin_map.h>
 
+#include <memory>
 #include <string_view>
 
 #include <uberz/ReadableArchive.h>
@@ -51,8 +52,12 @@ namespace filament::gltfio {
 
     private:
         Engine& mEngine;
+        Material* createMaterial(size_t specIndex);
+
         utils::FixedCapacityVector<Material*> mMaterials;
-        uberz::ReadableArchive* mArchive = nullptr;
+        // only the index of the archive is decompressed, packages are when their spec is used
+        std::unique_ptr<uberz::ArchiveReader> mReader;
+        uberz::ReadableArchive const* mArchive = nullptr;
     };
 
     struct ArchiveRequirements {
@@ -31,11 +31,13 @@
 #include <filament/Camera.h>
 #include <filament/Engine.h>
 #include <filament/IndexBuffer.h>
+#include <filament/InstanceBuffer.h>
 #include <filament/LightManager.h>
 #include <filament/Material.h>
 #include <filament/MorphTargetBuffer.h>
 #include <filament/RenderableManager.h>
 #include <filament/Scene.h>
+#include <filament/SkinningBuffer.h>
 #include <filament/TextureSampler.h>
 #include <filament/TransformManager.h>
 #include <filament/VertexBuffer.h>
@@ -53,12 +55,15 @@
 #include <utils/Systrace.h>
 
 #include <tsl/robin_map.h>
+#include <tsl/robin_set.h>
 
 #include <cgltf.h>
 
 #include "downcast.h"
 
 #include <memory>
+#include <string_view>
+#include <variant>
 
 using namespace filament;
 using namespace filament::math;
@@ -70,6 +75,9 @@ using SceneMask = NodeManager::SceneMask;
 
 static const auto FREE_CALLBACK = [](void* mem, size_t, void*) { free(mem); };
 
+// Size of the buffers of SharedSkinning, which must hold a whole bones uniform block.
+static constexpr uint32_t SHARED_SKINNING_BONE_COUNT = 256;
+
 // The default glTF material.
 static constexpr cgltf_material kDefaultMat = {
     .name = (char*) "Default GLTF material",
@@ -96,6 +104,14 @@ static const char* getNodeName(const cgltf_node* node, const char* defaultNodeNa
     return defaultNodeName;
 }
 
+// Returns the number of instances of a node that uses EXT_mesh_gpu_instancing, or zero.
+static size_t getGpuInstanceCount(const cgltf_node* node) {
+    if (!node->has_mesh_gpu_instancing || node->mesh_gpu_instancing.attributes_count == 0) {
+        return 0;
+    }
+    return node->mesh_gpu_instancing.attributes[0].data->count;
+}
+
 static bool primitiveHasVertexColor(const cgltf_primitive& inPrim) {
     for (int slot = 0; slot < inPrim.attributes_count; slot++) {
         const cgltf_attribute& inputAttribute = inPrim.attributes[slot];
@@ -212,7 +228,9 @@ struct FAssetLoader : public AssetLoader {
             mTransformManager(config.engine->getTransformManager()),
             mMaterials(*config.materials),
             mEngine(*config.engine),
-            mDefaultNodeName(config.defaultNodeName) {
+            mDefaultNodeName(config.defaultNodeName),
+            mQuantizeTexCoords(config.quantizeTexCoords),
+            mCompileMaterialVariants(config.compileMaterialVariants) {
         if (config.ext) {
             FILAMENT_CHECK_PRECONDITION(AssetConfigurationExtended::isSupported())
                     << "Extend asset loading is not supported on this platform";
@@ -222,9 +240,25 @@ struct FAssetLoader : public AssetLoader {
     }
 
     FFilamentAsset* createAsset(const uint8_t* bytes, uint32_t nbytes);
+    FFilamentAsset* createAssetFromFile(const char* path);
     FFilamentAsset* createInstancedAsset(const uint8_t* bytes, uint32_t numBytes,
             FilamentInstance** instances, size_t numInstances);
     FilamentInstance* createInstance(FFilamentAsset* fAsset);
+    size_t createInstances(FFilamentAsset* fAsset, size_t count, FilamentInstance** instances,
+            bool shareSkinning = false);
+    void recycleInstance(FFilamentAsset* fAsset, FFilamentInstance* instance);
+
+    // Memory that cgltf points into, either a copy of the client's blob or a mapped file.
+    using SourceStorage = std::variant<utils::FixedCapacityVector<uint8_t>,
+            std::unique_ptr<utility::MappedFile>>;
+    FFilamentAsset* createInstancedAsset(const uint8_t* bytes, size_t numBytes,
+            FilamentInstance** instances, size_t numInstances, SourceStorage storage);
+
+    // These do not touch the state of the loader, see AssetLoader::prepareAsset().
+    PreparedAsset* prepareAsset(const uint8_t* bytes, size_t numBytes, SourceStorage storage) const;
+    static cgltf_data* parseAsset(const uint8_t* bytes, size_t numBytes);
+
+    FFilamentAsset* commitAsset(PreparedAsset* prepared);
 
     static void destroy(FAssetLoader** loader) noexcept {
         delete *loader;
@@ -263,10 +297,13 @@ private:
 
     // Methods used during subsequent traverals (creation of entities, renderables, etc)
     void createInstances(size_t numInstances, FFilamentAsset* fAsset);
+    FFilamentInstance* createNewInstance(FFilamentAsset* fAsset);
+    void resetInstance(FFilamentAsset* fAsset, FFilamentInstance* instance);
+    Entity createEntity();
     void recurseEntities(const cgltf_node* node, SceneMask scenes, Entity parent,
             FFilamentAsset* fAsset, FFilamentInstance* instance);
     void createRenderable(const cgltf_node* node, Entity entity, const char* name,
-            FFilamentAsset* fAsset);
+            FFilamentAsset* fAsset, FFilamentInstance* instance);
     void createLight(const cgltf_light* light, Entity entity, FFilamentAsset* fAsset);
     void createCamera(const cgltf_camera* camera, Entity entity, FFilamentAsset* fAsset);
     void addTextureBinding(MaterialInstance* materialInstance, const char* parameterName,
@@ -296,26 +333,85 @@ public:
 
     // Transient state used only for the asset currently being loaded:
     const char* mDefaultNodeName;
+    const bool mQuantizeTexCoords;
+    const bool mCompileMaterialVariants;
     bool mError = false;
     bool mDiagnosticsEnabled = false;
     MaterialInstanceCache mMaterialInstanceCache;
 
+    // Materials of KHR_materials_variants whose programs have been requested, see
+    // AssetConfiguration::compileMaterialVariants.
+    tsl::robin_set<const Material*> mCompiledVariantMaterials;
+
+    // Entities allocated up front by createInstances(), handed out by createEntity().
+    std::vector<Entity> mPreallocatedEntities;
+    size_t mPreallocatedIndex = 0;
+
+    // Group of the instances being created by createInstances() when they share their bones.
+    SharedSkinning* mSharedSkinning = nullptr;
+
     // Weak reference to the largest dummy buffer so far in the current loading phase.
     BufferObject* mDummyBufferObject = nullptr;
 
+    // World transform of each node of the asset being committed, by node index, if prepared.
+    const mat4f* mWorldTransforms = nullptr;
+
 public:
     std::unique_ptr<AssetLoaderExtended> mLoaderExtended;
 };
 
 FILAMENT_DOWNCAST(AssetLoader)
 
+// Result of FAssetLoader::prepareAsset(), owns the parsed glTF until it is committed.
+struct PreparedAsset {
+    ~PreparedAsset() { cgltf_free(sourceAsset); }
+    FAssetLoader::SourceStorage storage;
+    cgltf_data* sourceAsset = nullptr;
+    FixedCapacityVector<mat4f> worldTransforms;
+};
+
+static void flattenHierarchy(const cgltf_data* srcAsset, const cgltf_node* node,
+        mat4f const& parentTransform, mat4f* worldTransforms) {
+    mat4f localTransform;
+    cgltf_node_transform_local(node, &localTransform[0][0]);
+    mat4f const worldTransform = parentTransform * localTransform;
+    worldTransforms[node - srcAsset->nodes] = worldTransform;
+    for (cgltf_size i = 0, len = node->children_count; i < len; ++i) {
+        flattenHierarchy(srcAsset, node->children[i], worldTransform, worldTransforms);
+    }
+}
+
 FFilamentAsset* FAssetLoader::createAsset(const uint8_t* bytes, uint32_t byteCount) {
     FilamentInstance* instances;
     return createInstancedAsset(bytes, byteCount, &instances, 1);
 }
 
+FFilamentAsset* FAssetLoader::createAssetFromFile(const char* path) {
+    std::unique_ptr<utility::MappedFile> file = utility::MappedFile::open(path);
+    if (!file) {
+        slog.e << "Unable to open " << path << io::endl;
+        return nullptr;
+    }
+    const uint8_t* bytes = file->getData();
+    const size_t byteCount = file->getSize();
+    FilamentInstance* instance;
+    return createInstancedAsset(bytes, byteCount, &instance, 1, std::move(file));
+}
+
 FFilamentAsset* FAssetLoader::createInstancedAsset(const uint8_t* bytes, uint32_t byteCount,
         FilamentInstance** instances, size_t numInstances) {
+    // Clients can free up their source blob immediately, but cgltf has pointers into the data that
+    // need to stay valid. Therefore we create a copy of the source blob and stash it inside the
+    // asset.
+    utils::FixedCapacityVector<uint8_t> glbdata(byteCount);
+    std::copy_n(bytes, byteCount, glbdata.data());
+    return createInstancedAsset(glbdata.data(), byteCount, instances, numInstances,
+            std::move(glbdata));
+}
+
+cgltf_data* FAssetLoader::parseAsset(const uint8_t* bytes, size_t byteCount) {
+    SYSTRACE_CALL();
+
     // This method can be used to load JSON or GLB. By using a default options struct, we are asking
     // cgltf to examine the magic identifier to determine which type of file is being loaded.
     cgltf_options options {};
@@ -334,20 +430,34 @@ FFilamentAsset* FAssetLoader::createInstancedAsset(const uint8_t* bytes, uint32_
         options.file.release = [](const cgltf_memory_options*, const cgltf_file_options*, void*) {};
     }
 
-    // Clients can free up their source blob immediately, but cgltf has pointers into the data that
-    // need to stay valid. Therefore we create a copy of the source blob and stash it inside the
-    // asset.
-    utils::FixedCapacityVector<uint8_t> glbdata(byteCount);
-    std::copy_n(bytes, byteCount, glbdata.data());
-
     // The ownership of an allocated `sourceAsset` will be moved to FFilamentAsset::mSourceAsset.
     cgltf_data* sourceAsset;
-    cgltf_result result = cgltf_parse(&options, glbdata.data(), byteCount, &sourceAsset);
+    cgltf_result result = cgltf_parse(&options, bytes, byteCount, &sourceAsset);
     if (result != cgltf_result_success) {
         slog.e << "Unable to parse glTF file." << io::endl;
         return nullptr;
     }
 
+    #if !GLTFIO_DRACO_SUPPORTED
+    for (cgltf_size i = 0; i < sourceAsset->extensions_required_count; i++) {
+        if (!strcmp(sourceAsset->extensions_required[i], "KHR_draco_mesh_compression")) {
+            slog.e << "KHR_draco_mesh_compression is not supported." << io::endl;
+            cgltf_free(sourceAsset);
+            return nullptr;
+        }
+    }
+    #endif
+
+    return sourceAsset;
+}
+
+FFilamentAsset* FAssetLoader::createInstancedAsset(const uint8_t* bytes, size_t byteCount,
+        FilamentInstance** instances, size_t numInstances, SourceStorage storage) {
+    cgltf_data* sourceAsset = parseAsset(bytes, byteCount);
+    if (!sourceAsset) {
+        return nullptr;
+    }
+
     FFilamentAsset* fAsset = createRootAsset(sourceAsset);
     if (mError) {
         delete fAsset;
@@ -355,7 +465,13 @@ FFilamentAsset* FAssetLoader::createInstancedAsset(const uint8_t* bytes, uint32_
         mError = false;
         return nullptr;
     }
-    glbdata.swap(fAsset->mSourceAsset->glbData);
+    // The asset takes ownership of the memory that cgltf points into.
+    if (auto* glbdata = std::get_if<utils::FixedCapacityVector<uint8_t>>(&storage)) {
+        glbdata->swap(fAsset->mSourceAsset->glbData);
+    } else {
+        fAsset->mSourceAsset->mappedFile =
+                std::move(std::get<std::unique_ptr<utility::MappedFile>>(storage));
+    }
 
     createInstances(numInstances, fAsset);
     if (mError) {
@@ -369,32 +485,210 @@ FFilamentAsset* FAssetLoader::createInstancedAsset(const uint8_t* bytes, uint32_
     return fAsset;
 }
 
+PreparedAsset* FAssetLoader::prepareAsset(const uint8_t* bytes, size_t byteCount,
+        SourceStorage storage) const {
+    SYSTRACE_CALL();
+    cgltf_data* sourceAsset = parseAsset(bytes, byteCount);
+    if (!sourceAsset) {
+        return nullptr;
+    }
+
+    auto* prepared = new PreparedAsset{ std::move(storage), sourceAsset,
+            FixedCapacityVector<mat4f>(sourceAsset->nodes_count) };
+    for (cgltf_size i = 0, n = sourceAsset->nodes_count; i < n; ++i) {
+        if (sourceAsset->nodes[i].parent == nullptr) {
+            flattenHierarchy(sourceAsset, &sourceAsset->nodes[i], mat4f(),
+                    prepared->worldTransforms.data());
+        }
+    }
+    return prepared;
+}
+
+FFilamentAsset* FAssetLoader::commitAsset(PreparedAsset* prepared) {
+    SYSTRACE_CALL();
+    std::unique_ptr<PreparedAsset> const owner(prepared);
+
+    // The asset takes ownership of the parsed glTF as soon as it is created.
+    cgltf_data* const sourceAsset = prepared->sourceAsset;
+    prepared->sourceAsset = nullptr;
+
+    mWorldTransforms = prepared->worldTransforms.data();
+    FFilamentAsset* fAsset = createRootAsset(sourceAsset);
+    mWorldTransforms = nullptr;
+    if (mError) {
+        delete fAsset;
+        mError = false;
+        return nullptr;
+    }
+    if (auto* glbdata = std::get_if<utils::FixedCapacityVector<uint8_t>>(&prepared->storage)) {
+        glbdata->swap(fAsset->mSourceAsset->glbData);
+    } else {
+        fAsset->mSourceAsset->mappedFile =
+                std::move(std::get<std::unique_ptr<utility::MappedFile>>(prepared->storage));
+    }
+
+    createInstances(1, fAsset);
+    if (mError) {
+        delete fAsset;
+        mError = false;
+        return nullptr;
+    }
+    return fAsset;
+}
+
 FilamentInstance* FAssetLoader::createInstance(FFilamentAsset* fAsset) {
+    FilamentInstance* instance = nullptr;
+    createInstances(fAsset, 1, &instance);
+    return instance;
+}
+
+size_t FAssetLoader::createInstances(FFilamentAsset* fAsset, size_t count,
+        FilamentInstance** instances, bool shareSkinning) {
+    SYSTRACE_CALL();
+    size_t created = 0;
+
+    // Recycled instances already have all of their entities and components.
+    while (created < count && !fAsset->mRecycledInstances.empty()) {
+        FFilamentInstance* instance = fAsset->mRecycledInstances.back();
+        fAsset->mRecycledInstances.pop_back();
+        resetInstance(fAsset, instance);
+        if (instances) {
+            instances[created] = instance;
+        }
+        created++;
+    }
+    if (created == count) {
+        return created;
+    }
+
     if (!fAsset->mSourceAsset) {
         slog.e << "Source data has been released; asset is frozen." << io::endl;
-        return nullptr;
+        return created;
     }
     const cgltf_data* srcAsset = fAsset->mSourceAsset->hierarchy;
     if (srcAsset->scenes == nullptr) {
         slog.e << "There is no scene in the asset." << io::endl;
-        return nullptr;
+        return created;
+    }
+
+    // Each instance has a root entity and one entity per node, so we can allocate all of them
+    // at once, along with the storage of the lists that hold them.
+    const size_t remaining = count - created;
+    const size_t entitiesPerInstance = srcAsset->nodes_count + 1;
+    mPreallocatedEntities.resize(remaining * entitiesPerInstance);
+    mPreallocatedIndex = 0;
+    mEntityManager.create(mPreallocatedEntities.size(), mPreallocatedEntities.data());
+    fAsset->mEntities.reserve(fAsset->mEntities.size() + remaining * srcAsset->nodes_count);
+    fAsset->mInstances.reserve(fAsset->mInstances.size() + remaining);
+
+    if (shareSkinning && srcAsset->skins_count > 0) {
+        auto skinning = std::make_unique<SharedSkinning>();
+        skinning->buffers = FixedCapacityVector<SkinningBuffer*>(srcAsset->nodes_count, nullptr);
+        mSharedSkinning = skinning.get();
+        fAsset->mSharedSkinnings.push_back(std::move(skinning));
+    }
+
+    for (; created < count; created++) {
+        FFilamentInstance* instance = createNewInstance(fAsset);
+        if (instances) {
+            instances[created] = instance;
+        }
+    }
+
+    // Release the entities that were not used, which only happens with nodes that are not
+    // reachable from any root.
+    if (mPreallocatedIndex < mPreallocatedEntities.size()) {
+        mEntityManager.destroy(mPreallocatedEntities.size() - mPreallocatedIndex,
+                mPreallocatedEntities.data() + mPreallocatedIndex);
     }
+    mPreallocatedEntities.clear();
+    mPreallocatedIndex = 0;
+    mSharedSkinning = nullptr;
+
+    fAsset->mDependencyGraph.commitEdges();
+
+    return created;
+}
+
+void FAssetLoader::recycleInstance(FFilamentAsset* fAsset, FFilamentInstance* instance) {
+    FILAMENT_CHECK_PRECONDITION(instance->mOwner == fAsset)
+            << "The instance does not belong to this asset.";
+    FILAMENT_CHECK_PRECONDITION(!instance->mRecycled) << "The instance was already recycled.";
+    instance->mRecycled = true;
+    fAsset->mRecycledInstances.push_back(instance);
+}
+
+void FAssetLoader::resetInstance(FFilamentAsset* fAsset, FFilamentInstance* instance) {
+    instance->mRecycled = false;
+    instance->mBoundingBox = fAsset->mBoundingBox;
 
+    TransformManager& tm = mTransformManager;
+    tm.openLocalTransformTransaction();
+
+    auto root = tm.getInstance(instance->mRoot);
+    tm.setParent(root, tm.getInstance(fAsset->mRoot));
+    tm.setTransform(root, mat4f());
+
+    // Put the nodes back in their rest pose, which requires the source hierarchy.
+    if (fAsset->mSourceAsset) {
+        const cgltf_data* srcAsset = fAsset->mSourceAsset->hierarchy;
+        for (size_t i = 0, n = instance->mNodeMap.size(); i < n; ++i) {
+            const Entity entity = instance->mNodeMap[i];
+            if (!entity) {
+                continue;
+            }
+            const cgltf_node& node = srcAsset->nodes[i];
+            mat4f localTransform;
+            if (node.has_matrix) {
+                memcpy(&localTransform[0][0], &node.matrix[0], 16 * sizeof(float));
+            } else {
+                auto trs = mTrsTransformManager.getInstance(entity);
+                mTrsTransformManager.setTrs(trs, *(const float3*) &node.translation[0],
+                        *(const quatf*) &node.rotation[0], *(const float3*) &node.scale[0]);
+                localTransform = mTrsTransformManager.getTransform(trs);
+            }
+            tm.setTransform(tm.getInstance(entity), localTransform);
+        }
+    }
+
+    tm.commitLocalTransformTransaction();
+
+    if (instance->mAnimator) {
+        instance->mAnimator->resetBoneMatrices();
+    }
+}
+
+Entity FAssetLoader::createEntity() {
+    if (mPreallocatedIndex < mPreallocatedEntities.size()) {
+        return mPreallocatedEntities[mPreallocatedIndex++];
+    }
+    return mEntityManager.create();
+}
+
+FFilamentInstance* FAssetLoader::createNewInstance(FFilamentAsset* fAsset) {
+    const cgltf_data* srcAsset = fAsset->mSourceAsset->hierarchy;
     auto rootTransform = mTransformManager.getInstance(fAsset->mRoot);
-    Entity instanceRoot = mEntityManager.create();
+    Entity instanceRoot = createEntity();
     mTransformManager.create(instanceRoot, rootTransform);
 
     mMaterialInstanceCache = MaterialInstanceCache(srcAsset);
+    mCompiledVariantMaterials.clear();
 
     // Create an instance object, which is a just a lightweight wrapper around a vector of
     // entities and an animator. The creation of animator is triggered from ResourceLoader
     // because it could require external bin data.
     FFilamentInstance* instance = new FFilamentInstance(instanceRoot, fAsset);
+    if (mSharedSkinning) {
+        if (!mSharedSkinning->leader) {
+            mSharedSkinning->leader = instance;
+        }
+        instance->mSharedSkinning = mSharedSkinning;
+    }
 
     // Check if the asset has variants.
     instance->mVariants.reserve(srcAsset->variants_count);
     for (cgltf_size i = 0, len = srcAsset->variants_count; i < len; ++i) {
-        instance->mVariants.push_back({ CString(srcAsset->variants[i].name) });
+        instance->mVariants.push_back({ fAsset->mStrings.intern(srcAsset->variants[i].name) });
     }
 
     // For each scene root, recursively create all entities.
@@ -417,22 +711,11 @@ FilamentInstance* FAssetLoader::createInstance(FFilamentAsset* fAsset) {
 
     mMaterialInstanceCache.flush(&instance->mMaterialInstances);
 
-    fAsset->mDependencyGraph.commitEdges();
-
     return instance;
 }
 
 FFilamentAsset* FAssetLoader::createRootAsset(const cgltf_data* srcAsset) {
     SYSTRACE_CALL();
-    #if !GLTFIO_DRACO_SUPPORTED
-    for (cgltf_size i = 0; i < srcAsset->extensions_required_count; i++) {
-        if (!strcmp(srcAsset->extensions_required[i], "KHR_draco_mesh_compression")) {
-            slog.e << "KHR_draco_mesh_compression is not supported." << io::endl;
-            return nullptr;
-        }
-    }
-    #endif
-
     mDummyBufferObject = nullptr;
     FFilamentAsset* fAsset = new FFilamentAsset(&mEngine, mNameManager, &mEntityManager,
             &mNodeManager, &mTrsTransformManager, srcAsset, (bool) mLoaderExtended);
@@ -509,7 +792,10 @@ void FAssetLoader::recursePrimitives(const cgltf_node* node, FFilamentAsset* fAs
 
     if (node->mesh) {
         createPrimitives(node, name, fAsset);
-        fAsset->mRenderableCount++;
+        const size_t maxInstances = mEngine.getMaxAutomaticInstances();
+        const size_t instanceCount = getGpuInstanceCount(node);
+        fAsset->mRenderableCount += std::max(size_t(1),
+                (instanceCount + maxInstances - 1) / maxInstances);
     }
 
     for (cgltf_size i = 0, len = node->children_count; i < len; ++i) {
@@ -521,11 +807,8 @@ void FAssetLoader::createInstances(size_t numInstances, FFilamentAsset* fAsset)
     // Create a separate entity hierarchy for each instance. Note that MeshCache (vertex
     // buffers and index buffers) and MaterialInstanceCache (materials and textures) help avoid
     // needless duplication of resources.
-    for (size_t index = 0; index < numInstances; ++index) {
-        if (createInstance(fAsset) == nullptr) {
-            mError = true;
-            break;
-        }
+    if (createInstances(fAsset, numInstances, nullptr) != numInstances) {
+        mError = true;
     }
 
     // Sort the entities so that the renderable ones come first. This allows us to expose
@@ -540,7 +823,7 @@ void FAssetLoader::recurseEntities(const cgltf_node* node, SceneMask scenes, Ent
         FFilamentAsset* fAsset, FFilamentInstance* instance) {
     NodeManager& nm = mNodeManager;
     const cgltf_data* srcAsset = fAsset->mSourceAsset->hierarchy;
-    const Entity entity = mEntityManager.create();
+    const Entity entity = createEntity();
     nm.create(entity);
     const auto nodeInstance = nm.getInstance(entity);
     nm.setSceneMembership(nodeInstance, scenes);
@@ -564,8 +847,8 @@ void FAssetLoader::recurseEntities(const cgltf_node* node, SceneMask scenes, Ent
     // Check if this node has an extras string.
     const cgltf_size extras_size = node->extras.end_offset - node->extras.start_offset;
     if (extras_size > 0) {
-        mNodeManager.setExtras(mNodeManager.getInstance(entity),
-                {srcAsset->json + node->extras.start_offset, extras_size});
+        mNodeManager.setExtras(mNodeManager.getInstance(entity), fAsset->mStrings.intern(
+                std::string_view{ srcAsset->json + node->extras.start_offset, extras_size }));
     }
 
     // Update the asset's entity list and private node mapping.
@@ -588,10 +871,7 @@ void FAssetLoader::recurseEntities(const cgltf_node* node, SceneMask scenes, Ent
 
     // If the node has a mesh, then create a renderable component.
     if (node->mesh) {
-        createRenderable(node, entity, name, fAsset);
-        if (srcAsset->variants_count > 0) {
-            createMaterialVariants(node->mesh, entity, fAsset, instance);
-        }
+        createRenderable(node, entity, name, fAsset, instance);
     }
 
     if (node->light) {
@@ -670,7 +950,11 @@ void FAssetLoader::createPrimitives(const cgltf_node* node, const char* name,
     }
 
     mat4f worldTransform;
-    cgltf_node_transform_world(node, &worldTransform[0][0]);
+    if (mWorldTransforms) {
+        worldTransform = mWorldTransforms[node - gltf->nodes];
+    } else {
+        cgltf_node_transform_world(node, &worldTransform[0][0]);
+    }
 
     const Aabb transformed = aabb.transform(worldTransform);
     fAsset->mBoundingBox.min = min(fAsset->mBoundingBox.min, transformed.min);
@@ -678,7 +962,7 @@ void FAssetLoader::createPrimitives(const cgltf_node* node, const char* name,
  }
 
 void FAssetLoader::createRenderable(const cgltf_node* node, Entity entity, const char* name,
-        FFilamentAsset* fAsset) {
+        FFilamentAsset* fAsset, FFilamentInstance* instance) {
     const cgltf_data* srcAsset = fAsset->mSourceAsset->hierarchy;
     const cgltf_mesh* mesh = node->mesh;
     const cgltf_size primitiveCount = mesh->primitives_count;
@@ -697,6 +981,35 @@ void FAssetLoader::createRenderable(const cgltf_node* node, Entity entity, const
     RenderableManager::Builder builder(primitiveCount);
     builder.morphing(numMorphTargets);
 
+    // Nodes that use EXT_mesh_gpu_instancing draw their instances with InstanceBuffers. The
+    // instances that do not fit in the renderable of the node are drawn by child entities, which
+    // have an identity transform and the same scene membership as the node.
+    auto& nm = mNodeManager;
+    const size_t instanceCount = getGpuInstanceCount(node);
+    const size_t maxInstances = mEngine.getMaxAutomaticInstances();
+    auto targets = FixedCapacityVector<Entity>::with_capacity(
+            std::max(size_t(1), (instanceCount + maxInstances - 1) / maxInstances));
+    targets.push_back(entity);
+    for (size_t first = maxInstances; first < instanceCount; first += maxInstances) {
+        const Entity target = mEntityManager.create();
+        mTransformManager.create(target, mTransformManager.getInstance(entity));
+        nm.create(target);
+        nm.setSceneMembership(nm.getInstance(target),
+                nm.getSceneMembership(nm.getInstance(entity)));
+        fAsset->mEntities.push_back(target);
+        instance->mEntities.push_back(target);
+        targets.push_back(target);
+    }
+
+    // The entity must not become ready before all of its geometry has been uploaded.
+    for (cgltf_size index = 0; index < primitiveCount; ++index) {
+        if (prims[index].vertices) {
+            for (Entity target : targets) {
+                fAsset->mDependencyGraph.addEdge(target, prims[index].vertices);
+            }
+        }
+    }
+
     // For each prim, create a Filament VertexBuffer, IndexBuffer, and MaterialInstance.
     // The VertexBuffer and IndexBuffer objects are cached for possible re-use, but MaterialInstance
     // is not.
@@ -724,7 +1037,9 @@ void FAssetLoader::createRenderable(const cgltf_node* node, Entity entity, const
             continue;
         }
 
-        fAsset->mDependencyGraph.addEdge(entity, mi);
+        for (Entity target : targets) {
+            fAsset->mDependencyGraph.addEdge(target, mi);
+        }
         builder.material(index, mi);
 
         assert_invariant(outputPrim->vertices);
@@ -745,14 +1060,34 @@ void FAssetLoader::createRenderable(const cgltf_node* node, Entity entity, const
         }
     }
 
-    FixedCapacityVector<CString> morphTargetNames(numMorphTargets);
-    for (cgltf_size i = 0, c = mesh->target_names_count; i < c; ++i) {
-        morphTargetNames[i] = CString(mesh->target_names[i]);
-    }
-    auto& nm = mNodeManager;
-    nm.setMorphTargetNames(nm.getInstance(entity), std::move(morphTargetNames));
-
-    if (node->skin) {
+    // The names are interned once per mesh and shared by all the nodes and instances using it.
+    auto [pos, inserted] = fAsset->mMorphTargetNames.try_emplace(mesh - srcAsset->meshes);
+    if (inserted) {
+        FixedCapacityVector<const char*> morphTargetNames(numMorphTargets);
+        for (cgltf_size i = 0, c = std::min(mesh->target_names_count, numMorphTargets); i < c; ++i) {
+            morphTargetNames[i] = fAsset->mStrings.intern(mesh->target_names[i]);
+        }
+        pos.value() = std::move(morphTargetNames);
+    }
+    Slice<const char* const> const morphTargetNames{ pos->second.data(), pos->second.size() };
+    for (Entity target : targets) {
+        nm.setMorphTargetNames(nm.getInstance(target), morphTargetNames);
+    }
+
+    if (node->skin && mSharedSkinning) {
+        // The renderables of the group use the same region of a shared buffer, which is as large
+        // as the bones uniform block since it is bound in its entirety.
+        const cgltf_data* srcAsset = fAsset->mSourceAsset->hierarchy;
+        SkinningBuffer*& buffer = mSharedSkinning->buffers[node - srcAsset->nodes];
+        if (!buffer) {
+            buffer = SkinningBuffer::Builder()
+                    .boneCount(SHARED_SKINNING_BONE_COUNT)
+                    .initialize(true)
+                    .build(mEngine);
+            mSharedSkinning->leaderBuffers[entity] = buffer;
+        }
+        builder.enableSkinningBuffers().skinning(buffer, node->skin->joints_count, 0);
+    } else if (node->skin) {
        builder.skinning(node->skin->joints_count);
     }
 
@@ -768,23 +1103,45 @@ void FAssetLoader::createRenderable(const cgltf_node* node, Entity entity, const
         .boundingBox(box)
         .culling(true)
         .castShadows(true)
-        .receiveShadows(true)
-        .build(mEngine, entity);
+        .receiveShadows(true);
 
     // According to the spec, the mesh may or may not specify default weights, regardless of whether
     // it actually has morph targets. If it has morphing enabled then the default weights are 0. If
     // node weights are provided, they override the ones specified on the mesh.
-    if (numMorphTargets > 0) {
-        RenderableManager::Instance renderable = mRenderableManager.getInstance(entity);
-        const auto size = std::min(MAX_MORPH_TARGETS, numMorphTargets);
-        FixedCapacityVector<float> weights(size, 0.0f);
-        for (cgltf_size i = 0, c = std::min(size, mesh->weights_count); i < c; ++i) {
-            weights[i] = mesh->weights[i];
+    const auto morphWeightCount = std::min(MAX_MORPH_TARGETS, numMorphTargets);
+    FixedCapacityVector<float> weights(morphWeightCount, 0.0f);
+    for (cgltf_size i = 0, c = std::min(morphWeightCount, mesh->weights_count); i < c; ++i) {
+        weights[i] = mesh->weights[i];
+    }
+    for (cgltf_size i = 0, c = std::min(morphWeightCount, node->weights_count); i < c; ++i) {
+        weights[i] = node->weights[i];
+    }
+
+    auto buildRenderable = [&](Entity target) {
+        builder.build(mEngine, target);
+        if (numMorphTargets > 0) {
+            RenderableManager::Instance renderable = mRenderableManager.getInstance(target);
+            mRenderableManager.setMorphWeights(renderable, weights.data(), morphWeightCount);
         }
-        for (cgltf_size i = 0, c = std::min(size, node->weights_count); i < c; ++i) {
-            weights[i] = node->weights[i];
+        if (srcAsset->variants_count > 0) {
+            createMaterialVariants(mesh, target, fAsset, instance);
         }
-        mRenderableManager.setMorphWeights(renderable, weights.data(), size);
+    };
+
+    if (instanceCount == 0) {
+        buildRenderable(entity);
+        return;
+    }
+    for (size_t i = 0, n = targets.size(); i < n; ++i) {
+        const Entity target = targets[i];
+        const size_t first = i * maxInstances;
+        const size_t count = std::min(maxInstances, instanceCount - first);
+        InstanceBuffer* buffer = InstanceBuffer::Builder(count).build(mEngine);
+        builder.instances(count, buffer);
+        buildRenderable(target);
+        fAsset->mGpuInstances.push_back({ cgltf_size(node - srcAsset->nodes), target, buffer,
+                first, aabb });
+        fAsset->applyGpuInstances(fAsset->mGpuInstances.back());
     }
 }
 
@@ -806,6 +1163,15 @@ void FAssetLoader::createMaterialVariants(const cgltf_mesh* mesh, Entity entity,
             }
             fAsset->mDependencyGraph.addEdge(entity, mi);
             instance->mVariants[variantIndex].mappings.push_back({entity, prim, mi});
+
+            // Variant materials are not drawn until the variant is applied, so their programs
+            // would otherwise be compiled by the first frame that follows the switch.
+            // The material belongs to the MaterialProvider, which hands it out as mutable.
+            Material* ma = const_cast<Material*>(mi->getMaterial());
+            if (mCompileMaterialVariants && mCompiledVariantMaterials.insert(ma).second) {
+                ma->compile(Material::CompilerPriorityQueue::LOW,
+                        UserVariantFilterBit::ALL & ~UserVariantFilterBit::STE);
+            }
         }
     }
 }
@@ -847,6 +1213,7 @@ bool FAssetLoader::createPrimitive(const cgltf_primitive& inPrim, const char* na
 
         FFilamentAsset::ResourceInfo::BufferSlot slot = { accessor };
         slot.indexBuffer = indices;
+        slot.primitive = &inPrim;
         addBufferSlot(slot);
     } else if (inPrim.attributes_count > 0) {
         // If a primitive does not have an index buffer, generate a trivial one now.
@@ -965,14 +1332,24 @@ bool FAssetLoader::createPrimitive(const cgltf_primitive& inPrim, const char* na
             slog.e << "Unsupported accessor type in " << name << io::endl;
             return false;
         }
-        const int stride = (fatype == actualType) ? accessor->stride : 0;
+        int stride = (fatype == actualType) ? accessor->stride : 0;
+
+        // Float texture coordinates within the unit range are stored as normalized shorts, which
+        // ResourceLoader converts to when uploading them.
+        bool quantized = false;
+        if (atype == cgltf_attribute_type_texcoord && mQuantizeTexCoords) {
+            quantized = getQuantizedTexCoordType(accessor, &fatype);
+            stride = quantized ? 0 : stride;
+        }
 
         // The cgltf library provides a stride value for all accessors, even though they do not
         // exist in the glTF file. It is computed from the type and the stride of the buffer view.
         // As a convenience, cgltf also replaces zero (default) stride with the actual stride.
         vbb.attribute(semantic, slot, fatype, 0, stride);
-        vbb.normalized(semantic, accessor->normalized);
-        addBufferSlot({accessor, atype, slot++});
+        vbb.normalized(semantic, accessor->normalized || quantized);
+        BufferSlot bufferSlot = { accessor, atype, slot++ };
+        bufferSlot.quantized = quantized;
+        addBufferSlot(bufferSlot);
     }
 
     // If the model is lit but does not have normals, we'll need to generate flat normals.
@@ -1576,6 +1953,18 @@ void FAssetLoader::importSkins(FFilamentInstance* instance, const cgltf_data* gl
             instance->mSkins[skinIndex].targets.insert(entity);
         }
     }
+    // The renderables that draw the remaining GPU instances of a skinned node need its bones too,
+    // unless they already share the skinning buffer of the node.
+    if (!instance->mSharedSkinning) {
+        for (const auto& instances : instance->mOwner->mGpuInstances) {
+            const cgltf_node& node = gltf->nodes[instances.node];
+            const Entity entity = nodeMap[instances.node];
+            if (node.skin && instances.entity != entity && mTransformManager.getParent(
+                    mTransformManager.getInstance(instances.entity)) == entity) {
+                instance->mSkins[node.skin - gltf->skins].targets.insert(instances.entity);
+            }
+        }
+    }
     for (cgltf_size i = 0, len = gltf->skins_count; i < len; ++i) {
         FFilamentInstance::Skin& dstSkin = instance->mSkins[i];
         const cgltf_skin& srcSkin = gltf->skins[i];
@@ -1610,6 +1999,37 @@ FilamentAsset* AssetLoader::createAsset(uint8_t const* bytes, uint32_t nbytes) {
     return downcast(this)->createAsset(bytes, nbytes);
 }
 
+FilamentAsset* AssetLoader::createAssetFromFile(const char* path) {
+    return downcast(this)->createAssetFromFile(path);
+}
+
+PreparedAsset* AssetLoader::prepareAsset(const uint8_t* bytes, uint32_t nbytes) {
+    // Clients can free up their source blob immediately, see createInstancedAsset().
+    FixedCapacityVector<uint8_t> glbdata(nbytes);
+    std::copy_n(bytes, nbytes, glbdata.data());
+    const uint8_t* data = glbdata.data();
+    return downcast(this)->prepareAsset(data, nbytes, std::move(glbdata));
+}
+
+PreparedAsset* AssetLoader::prepareAssetFromFile(const char* path) {
+    std::unique_ptr<utility::MappedFile> file = utility::MappedFile::open(path);
+    if (!file) {
+        slog.e << "Unable to open " << path << io::endl;
+        return nullptr;
+    }
+    const uint8_t* bytes = file->getData();
+    const size_t byteCount = file->getSize();
+    return downcast(this)->prepareAsset(bytes, byteCount, std::move(file));
+}
+
+FilamentAsset* AssetLoader::commitAsset(PreparedAsset* prepared) {
+    return downcast(this)->commitAsset(prepared);
+}
+
+void AssetLoader::destroyPreparedAsset(PreparedAsset* prepared) {
+    delete prepared;
+}
+
 FilamentAsset* AssetLoader::createInstancedAsset(const uint8_t* bytes, uint32_t numBytes,
         FilamentInstance** instances, size_t numInstances) {
     return downcast(this)->createInstancedAsset(bytes, numBytes, instances, numInstances);
@@ -1619,6 +2039,15 @@ FilamentInstance* AssetLoader::createInstance(FilamentAsset* asset) {
     return downcast(this)->createInstance(downcast(asset));
 }
 
+size_t AssetLoader::createInstances(FilamentAsset* asset, size_t count,
+        FilamentInstance** instances, bool shareSkinning) {
+    return downcast(this)->createInstances(downcast(asset), count, instances, shareSkinning);
+}
+
+void AssetLoader::recycleInstance(FilamentAsset* asset, FilamentInstance* instance) {
+    downcast(this)->recycleInstance(downcast(asset), downcast(instance));
+}
+
 void AssetLoader::enableDiagnostics(bool enable) {
     downcast(this)->mDiagnosticsEnabled = enable;
 }
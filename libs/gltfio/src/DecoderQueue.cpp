@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DecoderQueue.h"
+
+#include <utils/compiler.h>
+#include <utils/debug.h>
+
+#include <algorithm>
+#include <utility>
+
+using namespace utils;
+
+namespace filament::gltfio {
+
+DecoderQueue::DecoderQueue(JobSystem& js, size_t maxJobCount)
+        : mJobSystem(js),
+          mMaxJobCount(maxJobCount ? maxJobCount : std::max(size_t(1), (js.getThreadCount() + 1) / 2)) {
+}
+
+DecoderQueue::~DecoderQueue() {
+    cancel();
+}
+
+DecoderQueue::Ticket DecoderQueue::push(Work work, int priority) {
+    auto task = std::make_unique<Task>();
+    task->work = std::move(work);
+    task->ticket = mNextTicket++;
+    task->priority = priority;
+    Ticket const ticket = task->ticket;
+    mQueued.push_back(std::move(task));
+    if constexpr (UTILS_HAS_THREADING) {
+        startQueued();
+    }
+    return ticket;
+}
+
+void DecoderQueue::setPriority(Ticket ticket, int priority) noexcept {
+    auto pos = std::find_if(mQueued.begin(), mQueued.end(),
+            [ticket](auto const& task) { return task->ticket == ticket; });
+    if (pos != mQueued.end()) {
+        (*pos)->priority = priority;
+    }
+}
+
+std::unique_ptr<DecoderQueue::Task> DecoderQueue::popNext() noexcept {
+    if (mQueued.empty()) {
+        return {};
+    }
+    // Tickets increase with push order, so among equal priorities the oldest task wins. The queue
+    // holds at most a few hundred textures, so a linear search is fine.
+    auto pos = std::min_element(mQueued.begin(), mQueued.end(),
+            [](auto const& lhs, auto const& rhs) {
+                return lhs->priority != rhs->priority ?
+                       lhs->priority > rhs->priority : lhs->ticket < rhs->ticket;
+            });
+    std::unique_ptr<Task> task = std::move(*pos);
+    mQueued.erase(pos);
+    return task;
+}
+
+void DecoderQueue::start(std::unique_ptr<Task> task) {
+    Task* const t = task.get();
+    t->job = jobs::createJob(mJobSystem, nullptr, [t] {
+        t->work();
+        t->done.store(true, std::memory_order_release);
+    });
+    // Decoding can take a while, keep it out of the way of the frame's jobs.
+    mJobSystem.runAndRetain(t->job, JobSystem::Lane::BACKGROUND);
+    mRunning.push_back(std::move(task));
+}
+
+void DecoderQueue::startQueued() {
+    while (mRunning.size() < mMaxJobCount && !mQueued.empty()) {
+        start(popNext());
+    }
+}
+
+void DecoderQueue::update() {
+    if constexpr (!UTILS_HAS_THREADING) {
+        // Amortize the decoding cost across several frames.
+        if (std::unique_ptr<Task> task = popNext()) {
+            task->work();
+        }
+        return;
+    }
+    for (size_t i = 0; i < mRunning.size();) {
+        if (mRunning[i]->done.load(std::memory_order_acquire)) {
+            mJobSystem.waitAndRelease(mRunning[i]->job);
+            mRunning.erase(mRunning.begin() + ptrdiff_t(i));
+        } else {
+            i++;
+        }
+    }
+    startQueued();
+}
+
+void DecoderQueue::waitForCompletion() {
+    if constexpr (!UTILS_HAS_THREADING) {
+        while (std::unique_ptr<Task> task = popNext()) {
+            task->work();
+        }
+        return;
+    }
+    startQueued();
+    while (!mRunning.empty()) {
+        // Waiting on the oldest job first, since it is the most likely to be done already.
+        mJobSystem.waitAndRelease(mRunning.front()->job);
+        mRunning.erase(mRunning.begin());
+        startQueued();
+    }
+}
+
+void DecoderQueue::cancel() {
+    mQueued.clear();
+    for (auto& task : mRunning) {
+        mJobSystem.waitAndRelease(task->job);
+    }
+    mRunning.clear();
+}
+
+} // namespace filament::gltfio
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTFIO_DECODERQUEUE_H
+#define GLTFIO_DECODERQUEUE_H
+
+#include <utils/JobSystem.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament::gltfio {
+
+/**
+ * Internal helper that runs the decoder jobs of the texture providers.
+ *
+ * At most maxJobCount jobs run at any given time. The others wait in a queue, where they are
+ * ordered by priority then by push order, and from which they can be cancelled. All methods must
+ * be called from the foreground thread, only the work functions run on the job threads.
+ *
+ * Without threading support, update() runs one queued work function on the calling thread.
+ */
+class DecoderQueue {
+public:
+    using Ticket = uint32_t;
+    using Work = std::function<void()>;
+
+    // A maxJobCount of 0 uses half of the job system's threads, which leaves the others to the
+    // engine.
+    explicit DecoderQueue(utils::JobSystem& js, size_t maxJobCount = 0);
+    ~DecoderQueue();
+
+    DecoderQueue(DecoderQueue const&) = delete;
+    DecoderQueue& operator=(DecoderQueue const&) = delete;
+
+    // Queues the given work, and starts it right away if fewer than maxJobCount jobs are running.
+    Ticket push(Work work, int priority = 0);
+
+    // Changes the priority of work that hasn't started yet, otherwise does nothing.
+    void setPriority(Ticket ticket, int priority) noexcept;
+
+    // Releases the jobs that are done and starts queued work in their place.
+    void update();
+
+    // Runs all the queued work and waits for all of it to complete.
+    void waitForCompletion();
+
+    // Drops all the queued work, which will never run, and waits for the running jobs.
+    void cancel();
+
+    size_t getQueuedCount() const noexcept { return mQueued.size(); }
+    size_t getRunningCount() const noexcept { return mRunning.size(); }
+
+private:
+    struct Task {
+        Work work;
+        Ticket ticket;
+        int priority;
+        std::atomic<bool> done{ false };
+        utils::JobSystem::Job* job = nullptr;
+    };
+
+    // Removes the highest-priority task from the queue, or returns null if it is empty.
+    std::unique_ptr<Task> popNext() noexcept;
+    void start(std::unique_ptr<Task> task);
+    void startQueued();
+
+    utils::JobSystem& mJobSystem;
+    size_t const mMaxJobCount;
+    Ticket mNextTicket = 0;
+    std::vector<std::unique_ptr<Task>> mQueued;
+    std::vector<std::unique_ptr<Task>> mRunning;
+};
+
+} // namespace filament::gltfio
+
+#endif // GLTFIO_DECODERQUEUE_H
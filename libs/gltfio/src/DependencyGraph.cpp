@@ -37,10 +37,7 @@ size_t DependencyGraph::popRenderables(Entity* result, size_t count) noexcept {
 
 void DependencyGraph::addEdge(Entity entity, MaterialInstance* mi) {
     if (mDisabled) {
-        if (mEntityToMaterial.count(entity) == 0) {
-            mEntityToMaterial[entity] = {};
-            mReadyRenderables.push(entity);
-        }
+        checkReadiness(entity, mEntityToMaterial[entity]);
     } else {
         mMaterialToEntity[mi].insert(entity);
         mEntityToMaterial[entity].materials.insert(mi);
@@ -75,6 +72,23 @@ void DependencyGraph::addEdge(Texture* texture, MaterialInstance* material, cons
     }
 }
 
+void DependencyGraph::addEdge(Entity entity, VertexBuffer* vertices) {
+    GeometryNode& geometry = mGeometryToEntity[vertices];
+    if (!geometry.ready && geometry.entities.insert(entity).second) {
+        mEntityToMaterial[entity].numPendingGeometries++;
+    }
+}
+
+void DependencyGraph::checkReadiness(Entity entity, EntityNode& status) {
+    if (status.revealed || status.numPendingGeometries > 0) {
+        return;
+    }
+    if (mDisabled || status.numReadyMaterials == status.materials.size()) {
+        status.revealed = true;
+        mReadyRenderables.push(entity);
+    }
+}
+
 void DependencyGraph::checkReadiness(Material* material) {
     auto& status = mMaterialToTexture.at(material);
 
@@ -121,12 +135,31 @@ void DependencyGraph::markAsReady(MaterialInstance* material) {
         if (status.numReadyMaterials == status.materials.size()) {
             continue;
         }
-        if (++status.numReadyMaterials == status.materials.size()) {
-            mReadyRenderables.push(entity);
-        }
+        ++status.numReadyMaterials;
+        checkReadiness(entity, status);
     }
 }
 
+void DependencyGraph::markAsReady(VertexBuffer* vertices) {
+    auto iter = mGeometryToEntity.find(vertices);
+    if (iter == mGeometryToEntity.end()) {
+        mGeometryToEntity[vertices].ready = true;
+        return;
+    }
+    GeometryNode& geometry = iter.value();
+    if (geometry.ready) {
+        return;
+    }
+    geometry.ready = true;
+    for (auto entity : geometry.entities) {
+        auto& status = mEntityToMaterial.at(entity);
+        assert_invariant(status.numPendingGeometries > 0);
+        --status.numPendingGeometries;
+        checkReadiness(entity, status);
+    }
+    geometry.entities = {};
+}
+
 DependencyGraph::TextureNode* DependencyGraph::getStatus(Texture* texture) {
     assert_invariant(texture);
     auto iter = mTextureNodes.find(texture);
@@ -140,10 +173,8 @@ DependencyGraph::TextureNode* DependencyGraph::getStatus(Texture* texture) {
 
 void DependencyGraph::disableProgressiveReveal() {
     mDisabled = true;
-    for (auto& [entity, status] : mEntityToMaterial) {
-        if (status.numReadyMaterials < status.materials.size()) {
-            mReadyRenderables.push(entity);
-        }
+    for (auto iter = mEntityToMaterial.begin(); iter != mEntityToMaterial.end(); ++iter) {
+        checkReadiness(iter->first, iter.value());
     }
 }
 
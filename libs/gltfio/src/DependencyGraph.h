@@ -28,6 +28,7 @@
 namespace filament {
     class MaterialInstance;
     class Texture;
+    class VertexBuffer;
 }
 
 namespace filament::gltfio {
@@ -56,6 +57,11 @@ namespace filament::gltfio {
  *
  * Note that the left-most entity in the above graph has no textures, so it becomes ready as soon as
  * commitEdges is called.
+ *
+ * Entities can also depend on the vertex buffers of their primitives, which is used when the
+ * geometry itself is loaded progressively. Unlike textures, these dependencies are honored even
+ * after progressive reveal has been disabled. Vertex buffers that are never marked as ready are
+ * not considered loaded, so all the vertex buffers added to the graph must eventually be marked.
  */
 class DependencyGraph {
 public:
@@ -71,6 +77,7 @@ public:
     void addEdge(Entity entity, Material* material);
     void addEdge(Material* material, const char* parameter);
     void addEdge(Texture* texture, Material* material, const char* parameter);
+    void addEdge(Entity entity, VertexBuffer* vertices);
 
     // Commits a set of edges to the graph. This simply triggers a check to see if
     // any entities are already ready, e.g. if any entities are non-textured.
@@ -79,6 +86,9 @@ public:
     // Marks the given texture as being fully decoded, with all miplevels initialized.
     void markAsReady(Texture* texture);
 
+    // Marks the given vertex buffer (and the other buffers of its primitive) as being uploaded.
+    void markAsReady(VertexBuffer* vertices);
+
     // Causes the dependency graph to enter a disabled state, whereby adding Entity <=> Material
     // edges will immediately mark the entity as ready without actually growing the graph.
     void disableProgressiveReveal();
@@ -96,9 +106,17 @@ private:
     struct EntityNode {
         tsl::robin_set<Material*> materials;
         size_t numReadyMaterials = 0;
+        size_t numPendingGeometries = 0;
+        bool revealed = false;
+    };
+
+    struct GeometryNode {
+        tsl::robin_set<Entity, Entity::Hasher> entities;
+        bool ready = false;
     };
 
     void checkReadiness(Material* material);
+    void checkReadiness(Entity entity, EntityNode& status);
     void markAsReady(Material* material);
     TextureNode* getStatus(Texture* texture);
 
@@ -107,6 +125,7 @@ private:
     tsl::robin_map<Material*, tsl::robin_set<Entity, Entity::Hasher>> mMaterialToEntity;
     tsl::robin_map<Material*, MaterialNode> mMaterialToTexture;
     tsl::robin_map<Texture*, tsl::robin_set<Material*>> mTextureToMaterial;
+    tsl::robin_map<VertexBuffer*, GeometryNode> mGeometryToEntity;
 
     // Each texture (and its readiness flag) can be referenced from multiple nodes, so we own
     // a collection of wrapper objects in the following map. This uses std::unique_ptr to allow
@@ -21,7 +21,11 @@
 #endif
 
 #include <utils/compiler.h>
+#include <utils/JobSystem.h>
 #include <utils/Log.h>
+#include <utils/Systrace.h>
+
+#include <vector>
 
 #if GLTFIO_DRACO_SUPPORTED
 
@@ -49,6 +53,40 @@ DracoMesh* DracoCache::findOrCreateMesh(const cgltf_buffer_view* key) {
     return mesh;
 }
 
+void DracoCache::decodeMeshes(JobSystem& js, const cgltf_buffer_view* const* keys, size_t count) {
+    SYSTRACE_CALL();
+
+    // Several primitives can share the same compressed mesh, so each one is decoded only once.
+    std::vector<const cgltf_buffer_view*> missing;
+    missing.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (mCache.find(keys[i]) == mCache.end()) {
+            mCache.emplace(keys[i], nullptr);
+            missing.push_back(keys[i]);
+        }
+    }
+    if (missing.empty()) {
+        return;
+    }
+
+    std::vector<DracoMesh*> meshes(missing.size());
+    JobSystem::Job* parent = js.createJob();
+    for (size_t i = 0, n = missing.size(); i < n; ++i) {
+        const cgltf_buffer_view* key = missing[i];
+        DracoMesh** mesh = &meshes[i];
+        js.run(jobs::createJob(js, parent, [key, mesh] {
+            assert(key->buffer && key->buffer->data);
+            const uint8_t* compressedData = key->offset + (uint8_t*) key->buffer->data;
+            *mesh = DracoMesh::decode(compressedData, key->size);
+        }));
+    }
+    js.runAndWait(parent);
+
+    for (size_t i = 0, n = missing.size(); i < n; ++i) {
+        mCache[missing[i]].reset(meshes[i]);
+    }
+}
+
 DracoMesh::DracoMesh(struct DracoMeshDetails* details) : mDetails(details) {}
 
 #if GLTFIO_DRACO_SUPPORTED
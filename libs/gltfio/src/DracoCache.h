@@ -19,10 +19,14 @@
 
 #include <cgltf.h>
 
+#include <utils/JobSystem.h>
+
 #include <tsl/robin_map.h>
 
 #include <memory>
 
+#include <stddef.h>
+
 #ifndef GLTFIO_DRACO_SUPPORTED
 #define GLTFIO_DRACO_SUPPORTED 0
 #endif
@@ -38,6 +42,9 @@ class DracoMesh;
 class DracoCache {
 public:
     DracoMesh* findOrCreateMesh(const cgltf_buffer_view* key);
+
+    // Decodes the given meshes that are not in the cache yet, in parallel, and adds them to it.
+    void decodeMeshes(utils::JobSystem& js, const cgltf_buffer_view* const* keys, size_t count);
 private:
     tsl::robin_map<const cgltf_buffer_view*, std::unique_ptr<DracoMesh>> mCache;
 };
@@ -23,6 +23,7 @@
 
 #include <filament/Engine.h>
 #include <filament/IndexBuffer.h>
+#include <filament/InstanceBuffer.h>
 #include <filament/MaterialInstance.h>
 #include <filament/RenderableManager.h>
 #include <filament/Texture.h>
@@ -38,15 +39,19 @@
 #include <utils/FixedCapacityVector.h>
 #include <utils/CString.h>
 #include <utils/Entity.h>
+#include <utils/StringPool.h>
 
 #include <cgltf.h>
 
 #include "downcast.h"
+#include "AnimationClip.h"
 #include "DependencyGraph.h"
 #include "DracoCache.h"
 #include "FFilamentInstance.h"
 #include "Utility.h"
 
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <variant>
@@ -204,6 +209,8 @@ struct FFilamentAsset : public FilamentAsset {
 
     void releaseSourceData() noexcept;
 
+    void releaseSourceBuffers() noexcept;
+
     const void* getSourceAsset() const noexcept {
         return mSourceAsset.get() ? mSourceAsset->hierarchy : nullptr;
     }
@@ -244,11 +251,46 @@ struct FFilamentAsset : public FilamentAsset {
     // to the dependency graph used for gradual reveal of entities.
     void applyTextureBinding(size_t textureIndex,const TextureSlot& tb, bool addDependency = true);
 
+    // A renderable that draws a range of the instances of a node that uses EXT_mesh_gpu_instancing.
+    // Nodes with more instances than Engine::getMaxAutomaticInstances() are split across several
+    // renderables, the first of which is the node itself.
+    struct GpuInstances {
+        cgltf_size node;
+        utils::Entity entity;
+        InstanceBuffer* buffer;
+        size_t first;
+        Aabb aabb;  // object-space bounds of the mesh
+    };
+
+    // Uploads the transforms of the given instances and sets the bounding box of their renderable.
+    // This does nothing if the instance transforms have not been decoded yet.
+    void applyGpuInstances(const GpuInstances& instances) const;
+
     struct Skin {
         utils::CString name;
         utils::FixedCapacityVector<math::mat4f> inverseBindMatrices;
     };
 
+    // Bounds of the vertices influenced by each joint of a skinned node, in the local space of the
+    // node. These are computed while the source data is available, and let the animator derive a
+    // conservative bounding box from the bone matrices alone (see Animator::bakeAnimation).
+    struct JointBounds {
+        cgltf_size node;
+        cgltf_size skin;
+        utils::FixedCapacityVector<Aabb> joints; // empty for the joints that influence no vertex
+
+        // Returns a box that contains the node when it is skinned with the given bones, which is
+        // the union of the joint bounds transformed by their bones.
+        Aabb transform(const math::mat4f* bones, size_t boneCount) const noexcept;
+    };
+
+    // Object-space bounds of a node with a mesh, including its morph targets. See
+    // ResourceConfiguration::cacheBoundingBoxes.
+    struct NodeBounds {
+        cgltf_size node;
+        Aabb aabb;
+    };
+
     Engine* const mEngine;
     utils::NameComponentManager* const mNameManager;
     utils::EntityManager* const mEntityManager;
@@ -263,10 +305,27 @@ struct FFilamentAsset : public FilamentAsset {
     std::vector<IndexBuffer*> mIndexBuffers;
     std::vector<MorphTargetBuffer*> mMorphTargetBuffers;
     utils::FixedCapacityVector<Skin> mSkins;
+    std::vector<JointBounds> mJointBounds;
+    std::vector<NodeBounds> mNodeBounds;
+    bool mNodeBoundsCached = false;
     utils::FixedCapacityVector<utils::CString> mScenes;
+
+    // Decoded animation data, created once when resources are loaded and shared with every
+    // Animator that plays it (including animators that belong to other assets).
+    AnimationClips mAnimationClips;
+
+    // Skinning palettes baked by Animator::bakeAnimation, shared by the animators of all instances.
+    mutable tsl::robin_map<const AnimationClip*, BakedAnimationHandle> mBakedAnimations;
     Aabb mBoundingBox;
     utils::Entity mRoot;
     std::vector<FFilamentInstance*> mInstances;
+    std::vector<FFilamentInstance*> mRecycledInstances; // see AssetLoader::recycleInstance()
+    std::vector<std::unique_ptr<SharedSkinning>> mSharedSkinnings;
+    std::vector<GpuInstances> mGpuInstances;
+
+    // Transforms of the instances of each node that uses EXT_mesh_gpu_instancing, relative to the
+    // node. These are decoded by ResourceLoader and kept for the instances created afterwards.
+    tsl::robin_map<cgltf_size, utils::FixedCapacityVector<math::mat4f>> mGpuInstanceTransforms;
     Wireframe* mWireframe = nullptr;
 
     // Indicates if resource decoding has started (not necessarily finished)
@@ -275,6 +334,12 @@ struct FFilamentAsset : public FilamentAsset {
     DependencyGraph mDependencyGraph;
     std::unordered_map<std::string, std::vector<utils::Entity>> mNameToEntity;
     utils::CString mAssetExtras;
+
+    // Strings referenced by the node components and the instances, shared by all instances.
+    utils::StringPool mStrings;
+
+    // Interned morph target names of each mesh, referenced by the node components.
+    tsl::robin_map<cgltf_size, utils::FixedCapacityVector<const char*>> mMorphTargetNames;
     bool mDetachedFilamentComponents = false;
 
     // Sentinels for situations where ResourceLoader needs to generate data.
@@ -288,6 +353,26 @@ struct FFilamentAsset : public FilamentAsset {
         cgltf_data* hierarchy;
         DracoCache dracoCache;
         utils::FixedCapacityVector<uint8_t> glbData;
+        std::unique_ptr<utility::MappedFile> mappedFile;
+
+        // When the binary payloads are released, the JSON chunk of a GLB is copied here so that
+        // extras can still be read when creating instances.
+        utils::FixedCapacityVector<char> jsonData;
+
+        // Buffer uploads that still reference the binary payloads; the payloads are only freed
+        // once they are all done, see releaseBuffers().
+        std::mutex bufferLock;
+        uint32_t pendingUploadCount = 0;
+        bool buffersReleaseRequested = false;
+        bool buffersReleased = false;
+
+        void acquireUpload() noexcept;
+        void releaseUpload() noexcept;
+
+        // Frees the vertex, index, animation and image data, as well as the decoded Draco and
+        // meshopt data, but keeps the hierarchy.
+        void releaseBuffers() noexcept;
+        void releaseBuffersLocked() noexcept;
     };
 
     // We used shared ownership for the raw cgltf data in order to permit ResourceLoader to
@@ -329,6 +414,8 @@ struct FFilamentAsset : public FilamentAsset {
             VertexBuffer* vertexBuffer;
             IndexBuffer* indexBuffer;
             MorphTargetBuffer* morphTargetBuffer;
+            const cgltf_primitive* primitive; // for index buffer only
+            bool quantized; // for texture coordinates only
         };
 
         std::vector<BufferSlot> mBufferSlots;
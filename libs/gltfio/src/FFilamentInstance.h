@@ -25,6 +25,7 @@
 
 #include <math/mat4.h>
 
+#include <tsl/robin_map.h>
 #include <tsl/robin_set.h>
 
 #include <vector>
@@ -35,6 +36,7 @@ struct cgltf_node;
 
 namespace filament {
     class MaterialInstance;
+    class SkinningBuffer;
 }
 
 namespace filament::gltfio {
@@ -49,10 +51,20 @@ struct VariantMapping {
 };
 
 struct Variant {
-    utils::CString name;
+    const char* name; // owned by the asset's string pool
     std::vector<VariantMapping> mappings;
 };
 
+// Bones shared by a group of instances that play the same animation in lockstep, see
+// AssetLoader::createInstances(). Each skinned node of the asset has a SkinningBuffer that is used
+// by the corresponding renderable of every instance in the group, and only the animator of the
+// first instance (the leader) writes to it.
+struct SharedSkinning {
+    FilamentInstance const* leader = nullptr;
+    utils::FixedCapacityVector<SkinningBuffer*> buffers; // indexed by cgltf_node, may be null
+    tsl::robin_map<utils::Entity, SkinningBuffer*, utils::Entity::Hasher> leaderBuffers;
+};
+
 struct FFilamentInstance : public FilamentInstance {
     FFilamentInstance(utils::Entity root, FFilamentAsset const* owner);
     ~FFilamentInstance();
@@ -107,6 +119,12 @@ struct FFilamentInstance : public FilamentInstance {
 
     Aabb mBoundingBox;
 
+    // Set while the instance is in its asset's pool of recycled instances.
+    bool mRecycled = false;
+
+    // Non-null if the instance belongs to a group of instances that share their bones.
+    SharedSkinning const* mSharedSkinning = nullptr;
+
     utils::FixedCapacityVector<MaterialInstance*> mMaterialInstances;
 
     void createAnimator();
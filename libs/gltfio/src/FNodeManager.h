@@ -68,20 +68,20 @@ public:
         });
     }
 
-    void setMorphTargetNames(Instance ci, utils::FixedCapacityVector<CString> names) noexcept {
+    void setMorphTargetNames(Instance ci, utils::Slice<const char* const> names) noexcept {
         assert_invariant(ci.isValid());
-        mManager[ci].morphTargetNames = std::move(names);
+        mManager[ci].morphTargetNames = names;
     }
 
-    const utils::FixedCapacityVector<CString>& getMorphTargetNames(Instance ci) const noexcept {
+    utils::Slice<const char* const> getMorphTargetNames(Instance ci) const noexcept {
         return mManager[ci].morphTargetNames;
     }
 
-    void setExtras(Instance ci, CString extras) noexcept {
-        mManager[ci].extras = std::move(extras);
+    void setExtras(Instance ci, const char* extras) noexcept {
+        mManager[ci].extras = extras;
     }
 
-    const CString& getExtras(Instance ci) const noexcept {
+    const char* getExtras(Instance ci) const noexcept {
         return mManager[ci].extras;
     }
 
@@ -101,8 +101,8 @@ private:
     };
 
     using Base = utils::SingleInstanceComponentManager<  // 28 bytes
-            utils::FixedCapacityVector<CString>,  // 16
-            CString,                              // 8
+            utils::Slice<const char* const>,      // 16
+            const char*,                          // 8
             SceneMask>;                           // 4
 
     struct Sim : public Base {
@@ -20,14 +20,21 @@
 
 #include <filament/RenderableManager.h>
 #include <filament/Scene.h>
+#include <filament/SkinningBuffer.h>
 
 #include <utils/EntityManager.h>
 #include <utils/Log.h>
 #include <utils/NameComponentManager.h>
+#include <utils/debug.h>
 
 #include "GltfEnums.h"
 #include "Wireframe.h"
 
+#include <algorithm>
+#include <mutex>
+
+#include <stdlib.h>
+
 using namespace filament;
 using namespace utils;
 
@@ -93,13 +100,23 @@ FFilamentAsset::~FFilamentAsset() {
     for (auto tb : mMorphTargetBuffers) {
         mEngine->destroy(tb);
     }
+    for (const auto& skinning : mSharedSkinnings) {
+        for (auto sb : skinning->buffers) {
+            if (sb) {
+                mEngine->destroy(sb);
+            }
+        }
+    }
+    for (const auto& instances : mGpuInstances) {
+        mEngine->destroy(instances.buffer);
+    }
 }
 
 const char* FFilamentAsset::getExtras(utils::Entity entity) const noexcept {
     if (entity.isNull()) {
         return mAssetExtras.c_str();
     }
-    return mNodeManager->getExtras(mNodeManager->getInstance(entity)).c_str();
+    return mNodeManager->getExtras(mNodeManager->getInstance(entity));
 }
 
 void FFilamentAsset::addTextureBinding(MaterialInstance* materialInstance,
@@ -156,18 +173,56 @@ void FFilamentAsset::applyTextureBinding(size_t textureIndex, const TextureSlot&
     }
 }
 
+void FFilamentAsset::applyGpuInstances(const GpuInstances& instances) const {
+    auto iter = mGpuInstanceTransforms.find(instances.node);
+    if (iter == mGpuInstanceTransforms.end()) {
+        return;
+    }
+    const math::mat4f* transforms = iter->second.data() + instances.first;
+    const size_t count = instances.buffer->getInstanceCount();
+    assert_invariant(instances.first + count <= iter->second.size());
+    instances.buffer->setLocalTransforms(transforms, count);
+
+    // All instances are culled with the bounding box of the renderable.
+    Aabb aabb;
+    for (size_t i = 0; i < count; ++i) {
+        const Aabb transformed = instances.aabb.transform(transforms[i]);
+        aabb.min = min(aabb.min, transformed.min);
+        aabb.max = max(aabb.max, transformed.max);
+    }
+    auto& rm = mEngine->getRenderableManager();
+    if (auto renderable = rm.getInstance(instances.entity); renderable && !aabb.isEmpty()) {
+        rm.setAxisAlignedBoundingBox(renderable, Box().set(aabb.min, aabb.max));
+    }
+}
+
+Aabb FFilamentAsset::JointBounds::transform(const math::mat4f* bones,
+        size_t boneCount) const noexcept {
+    Aabb result;
+    for (size_t i = 0, n = std::min(boneCount, size_t(joints.size())); i < n; ++i) {
+        const Aabb& joint = joints[i];
+        if (any(greaterThan(joint.min, joint.max))) {
+            continue;
+        }
+        const Aabb box = Aabb::transform(bones[i].upperLeft(), bones[i][3].xyz, joint);
+        result.min = min(result.min, box.min);
+        result.max = max(result.max, box.max);
+    }
+    return result;
+}
+
 const char* FFilamentAsset::getMorphTargetNameAt(utils::Entity entity,
         size_t targetIndex) const noexcept {
     if (!mResourcesLoaded) {
         return nullptr;
     }
 
-    const auto& names =  mNodeManager->getMorphTargetNames(mNodeManager->getInstance(entity));
+    auto const names = mNodeManager->getMorphTargetNames(mNodeManager->getInstance(entity));
     if (targetIndex >= names.size()) {
         return nullptr;
     }
 
-    return names[targetIndex].c_str();
+    return names[targetIndex];
 }
 
 size_t FFilamentAsset::getMorphTargetCountAt(utils::Entity entity) const noexcept {
@@ -175,7 +230,7 @@ size_t FFilamentAsset::getMorphTargetCountAt(utils::Entity entity) const noexcep
         return 0;
     }
 
-    const auto& names = mNodeManager->getMorphTargetNames(mNodeManager->getInstance(entity));
+    auto const names = mNodeManager->getMorphTargetNames(mNodeManager->getInstance(entity));
     return names.size();
 }
 
@@ -198,6 +253,83 @@ void FFilamentAsset::releaseSourceData() noexcept {
     mSourceAsset.reset();
 }
 
+void FFilamentAsset::releaseSourceBuffers() noexcept {
+    if (mSourceAsset) {
+        mSourceAsset->releaseBuffers();
+    }
+}
+
+void FFilamentAsset::SourceAsset::acquireUpload() noexcept {
+    std::lock_guard const lock(bufferLock);
+    assert_invariant(!buffersReleased);
+    pendingUploadCount++;
+}
+
+void FFilamentAsset::SourceAsset::releaseUpload() noexcept {
+    // Upload callbacks can be called from the driver thread.
+    std::lock_guard const lock(bufferLock);
+    assert_invariant(pendingUploadCount > 0);
+    if (--pendingUploadCount == 0 && buffersReleaseRequested) {
+        releaseBuffersLocked();
+    }
+}
+
+void FFilamentAsset::SourceAsset::releaseBuffers() noexcept {
+    std::lock_guard const lock(bufferLock);
+    buffersReleaseRequested = true;
+    if (pendingUploadCount == 0) {
+        releaseBuffersLocked();
+    }
+}
+
+void FFilamentAsset::SourceAsset::releaseBuffersLocked() noexcept {
+    if (buffersReleased) {
+        return;
+    }
+    buffersReleased = true;
+
+    // This mirrors what cgltf_free() does with the buffers, which it then skips.
+    cgltf_data* const data = hierarchy;
+    void (*const freeFunc)(void*, void*) = data->memory.free_func;
+    void* const userData = data->memory.user_data;
+    for (cgltf_size i = 0; i < data->buffers_count; ++i) {
+        cgltf_buffer& buffer = data->buffers[i];
+        if (buffer.data_free_method == cgltf_data_free_method_file_release) {
+            if (data->file.release) {
+                data->file.release(&data->memory, &data->file, buffer.data);
+            } else if (freeFunc) {
+                freeFunc(userData, buffer.data);
+            } else {
+                free(buffer.data);
+            }
+        } else if (buffer.data_free_method == cgltf_data_free_method_memory_free) {
+            freeFunc(userData, buffer.data);
+        }
+        buffer.data = nullptr;
+        buffer.data_free_method = cgltf_data_free_method_none;
+    }
+
+    // Decoded meshopt data.
+    for (cgltf_size i = 0; i < data->buffer_views_count; ++i) {
+        freeFunc(userData, data->buffer_views[i].data);
+        data->buffer_views[i].data = nullptr;
+    }
+
+    dracoCache = {};
+
+    // The binary chunk of a GLB lives in glbData along with its JSON, which we keep.
+    if (data->bin) {
+        jsonData = utils::FixedCapacityVector<char>(data->json_size + 1);
+        std::copy_n(data->json, data->json_size, jsonData.data());
+        jsonData[data->json_size] = 0;
+        data->json = jsonData.data();
+        data->bin = nullptr;
+        data->bin_size = 0;
+        glbData = {};
+        mappedFile.reset();
+    }
+}
+
 const char* FFilamentAsset::getName(utils::Entity entity) const noexcept {
     if (mNameManager == nullptr) {
         return nullptr;
@@ -381,6 +513,10 @@ void FilamentAsset::releaseSourceData() noexcept {
     return downcast(this)->releaseSourceData();
 }
 
+void FilamentAsset::releaseSourceBuffers() noexcept {
+    return downcast(this)->releaseSourceBuffers();
+}
+
 const void* FilamentAsset::getSourceAsset() noexcept {
     return downcast(this)->getSourceAsset();
 }
@@ -22,6 +22,9 @@
 #include <utils/JobSystem.h>
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <vector>
+
 using namespace filament;
 using namespace filament::math;
 using namespace utils;
@@ -97,10 +100,72 @@ mat4f const* FFilamentInstance::getInverseBindMatricesAt(size_t skinIndex) const
     return mOwner->mSkins[skinIndex].inverseBindMatrices.data();
 }
 
+// Computes the bounds of a skinned primitive in the pose given by its bones, which are relative to
+// the skinned node.
+static Aabb computeSkinnedBounds(const cgltf_primitive& prim, const mat4f* bones,
+        size_t boneCount) {
+    FixedCapacityVector<float3> verts;
+    FixedCapacityVector<float4> joints;
+    FixedCapacityVector<float4> weights;
+    for (cgltf_size slot = 0, n = prim.attributes_count; slot < n; ++slot) {
+        const cgltf_attribute& attr = prim.attributes[slot];
+        const cgltf_accessor& accessor = *attr.data;
+        switch (attr.type) {
+        case cgltf_attribute_type_position:
+            verts = FixedCapacityVector<float3>(accessor.count);
+            cgltf_accessor_unpack_floats(&accessor, &verts.data()->x, accessor.count * 3);
+            break;
+        case cgltf_attribute_type_joints:
+            joints = FixedCapacityVector<float4>(accessor.count);
+            cgltf_accessor_unpack_floats(&accessor, &joints.data()->x, accessor.count * 4);
+            break;
+        case cgltf_attribute_type_weights:
+            weights = FixedCapacityVector<float4>(accessor.count);
+            cgltf_accessor_unpack_floats(&accessor, &weights.data()->x, accessor.count * 4);
+            break;
+        default:
+            break;
+        }
+    }
+
+    Aabb aabb;
+    const size_t count = std::min({ verts.size(), joints.size(), weights.size() });
+    for (size_t i = 0; i < count; i++) {
+        mat4f skinMatrix = mat4f(0.0f);
+        for (size_t j = 0; j < 4; j++) {
+            const size_t jointIndex = size_t(joints[i][j]);
+            if (jointIndex < boneCount) {
+                skinMatrix += weights[i][j] * bones[jointIndex];
+            }
+        }
+
+        // NOTE: Filament's vertex shader assumes that last row is [0,0,0,1]
+        // so we make the same assumption in the following transformation.
+
+        const float3 point = verts[i];
+        const float3 skinnedPoint =
+                point.x * skinMatrix[0].xyz +
+                point.y * skinMatrix[1].xyz +
+                point.z * skinMatrix[2].xyz +
+                skinMatrix[3].xyz;
+
+        aabb.min = min(aabb.min, skinnedPoint);
+        aabb.max = max(aabb.max, skinnedPoint);
+    }
+    return aabb;
+}
+
 void FFilamentInstance::recomputeBoundingBoxes() {
-    FILAMENT_CHECK_PRECONDITION(mOwner->mSourceAsset)
+    // Cached bounds make the source data optional.
+    const bool cached = mOwner->mNodeBoundsCached;
+    const bool hasSource = mOwner->mSourceAsset && !mOwner->mSourceAsset->buffersReleaseRequested;
+
+    FILAMENT_CHECK_PRECONDITION(cached || mOwner->mSourceAsset)
             << "Do not call releaseSourceData before recomputeBoundingBoxes";
 
+    FILAMENT_CHECK_PRECONDITION(cached || !mOwner->mSourceAsset->buffersReleaseRequested)
+            << "Do not call releaseSourceBuffers before recomputeBoundingBoxes";
+
     FILAMENT_CHECK_PRECONDITION(mOwner->mResourcesLoaded)
             << "Do not call recomputeBoundingBoxes before loadResources or asyncBeginLoad";
 
@@ -117,205 +182,118 @@ void FFilamentInstance::recomputeBoundingBoxes() {
         tm.setParent(tm.getInstance(e), 0);
     }
 
-    struct Prim {
-        cgltf_primitive const* prim;
-        Entity node;
-        ssize_t skinIndex;
-    };
-
-    auto computeBoundingBox = [](const cgltf_primitive* prim) -> Aabb {
+    // Collect the nodes that we wish to find bounds for, along with the bones of their current pose
+    // if they are skinned. The bones are relative to the node, like the ones given to setBones.
+    struct Target {
+        Entity entity;
+        FixedCapacityVector<mat4f> bones;
         Aabb aabb;
-        for (cgltf_size slot = 0; slot < prim->attributes_count; slot++) {
-            const cgltf_attribute& attr = prim->attributes[slot];
-            const cgltf_accessor* accessor = attr.data;
-            const size_t dim = cgltf_num_components(accessor->type);
-            if (attr.type == cgltf_attribute_type_position && dim >= 3) {
-                utils::FixedCapacityVector<float> unpacked(accessor->count * dim);
-                cgltf_accessor_unpack_floats(accessor, unpacked.data(), unpacked.size());
-                for (cgltf_size i = 0, j = 0, n = accessor->count; i < n; ++i, j += dim) {
-                    float3 pt(unpacked[j + 0], unpacked[j + 1], unpacked[j + 2]);
-                    aabb.min = min(aabb.min, pt);
-                    aabb.max = max(aabb.max, pt);
-                }
-
-                if (!prim->targets_count) {
-                    break;
-                }
-
-                Aabb baseAabb(aabb);
-                for (cgltf_size targetIndex = 0; targetIndex < prim->targets_count; ++targetIndex) {
-                    const cgltf_morph_target& target = prim->targets[targetIndex];
-                    for (cgltf_size attribIndex = 0; attribIndex < target.attributes_count; ++attribIndex) {
-                        const cgltf_attribute& targetAttribute = target.attributes[attribIndex];
-                        if (targetAttribute.type != cgltf_attribute_type_position) {
-                            continue;
-                        }
-
-                        const cgltf_accessor* targetAccessor = targetAttribute.data;
-
-                        assert_invariant(targetAccessor);
-                        assert_invariant(targetAccessor->count == accessor->count);
-                        assert_invariant(cgltf_num_components(targetAccessor->type) == dim);
-
-                        cgltf_accessor_unpack_floats(targetAccessor, unpacked.data(), unpacked.size());
-
-                        Aabb targetAabb;
-                        for (cgltf_size i = 0, j = 0, n = accessor->count; i < n; ++i, j += dim) {
-                            float3 delta(unpacked[j + 0], unpacked[j + 1], unpacked[j + 2]);
-                            targetAabb.min = min(targetAabb.min, delta);
-                            targetAabb.max = max(targetAabb.max, delta);
-                        }
-
-                        targetAabb.min += baseAabb.min;
-                        targetAabb.max += baseAabb.max;
-
-                        aabb.min = min(aabb.min, targetAabb.min);
-                        aabb.max = max(aabb.max, targetAabb.max);
-
-                        break;
-                    }
-                }
-                break;
-            }
-        }
-        return aabb;
     };
-
-    auto computeBoundingBoxSkinned = [&tm, this](const Prim& prim) -> Aabb {
-        FixedCapacityVector<float3> verts;
-        FixedCapacityVector<uint4> joints;
-        FixedCapacityVector<float4> weights;
-        for (cgltf_size slot = 0, n = prim.prim->attributes_count; slot < n; ++slot) {
-            const cgltf_attribute& attr = prim.prim->attributes[slot];
-            const cgltf_accessor& accessor = *attr.data;
-            switch (attr.type) {
-            case cgltf_attribute_type_position:
-                verts = FixedCapacityVector<float3>(accessor.count);
-                cgltf_accessor_unpack_floats(&accessor, &verts.data()->x, accessor.count * 3);
-                break;
-            case cgltf_attribute_type_joints: {
-                FixedCapacityVector<float4> tmp(accessor.count);
-                cgltf_accessor_unpack_floats(&accessor, &tmp.data()->x, accessor.count * 4);
-                joints = FixedCapacityVector<uint4>(accessor.count);
-                for (size_t i = 0, n = accessor.count; i < n; ++i) {
-                    joints[i] = uint4(tmp[i]);
-                }
-                break;
-            }
-            case cgltf_attribute_type_weights:
-                weights = FixedCapacityVector<float4>(accessor.count);
-                cgltf_accessor_unpack_floats(&accessor, &weights.data()->x, accessor.count * 4);
-                break;
-            default:
-                break;
-            }
+    std::vector<Target> targets;
+    auto addTarget = [&](cgltf_size nodeIndex, ssize_t skinIndex) {
+        Target& target = targets.emplace_back();
+        target.entity = mNodeMap[nodeIndex];
+        if (skinIndex < 0 || size_t(skinIndex) >= mSkins.size()) {
+            return;
         }
+        const Skin& instanceSkin = mSkins[skinIndex];
+        const FFilamentAsset::Skin& assetSkin = mOwner->mSkins[skinIndex];
+        const mat4f inverseGlobalTransform =
+                inverse(tm.getWorldTransform(tm.getInstance(target.entity)));
+        const size_t boneCount = std::min(size_t(instanceSkin.joints.size()),
+                size_t(assetSkin.inverseBindMatrices.size()));
+        target.bones = FixedCapacityVector<mat4f>(boneCount);
+        for (size_t i = 0; i < boneCount; ++i) {
+            const mat4f globalJointTransform =
+                    tm.getWorldTransform(tm.getInstance(instanceSkin.joints[i]));
+            target.bones[i] = inverseGlobalTransform * globalJointTransform *
+                    assetSkin.inverseBindMatrices[i];
+        }
+    };
 
+    // Primitives whose bounds must be computed from their vertices, one job each.
+    struct Prim {
+        cgltf_primitive const* prim;
+        size_t target;
         Aabb aabb;
-        TransformManager::Instance transformable = tm.getInstance(prim.node);
-        const mat4f inverseGlobalTransform = inverse(tm.getWorldTransform(transformable));
-        const Skin& instanceSkin = mSkins[prim.skinIndex];
-        const FFilamentAsset::Skin& assetSkin = mOwner->mSkins[prim.skinIndex];
-        for (size_t i = 0, n = verts.size(); i < n; i++) {
-            mat4f tmp = mat4f(0.0f);
-            for (size_t j = 0; j < 4; j++) {
-                size_t jointIndex = joints[i][j];
-                Entity jointEntity = instanceSkin.joints[jointIndex];
-                mat4f globalJointTransform = tm.getWorldTransform(tm.getInstance(jointEntity));
-                mat4f inverseBindMatrix = assetSkin.inverseBindMatrices[jointIndex];
-                tmp += weights[i][j] *  globalJointTransform * inverseBindMatrix;
-            }
-            const mat4f skinMatrix = inverseGlobalTransform * tmp;
-
-            const float3 point = verts[i];
-
-            // NOTE: Filament's vertex shader assumes that last row is [0,0,0,1]
-            // so we make the same assumption in the following transformation.
-
-            const float3 skinnedPoint =
-                    point.x * skinMatrix[0].xyz +
-                    point.y * skinMatrix[1].xyz +
-                    point.z * skinMatrix[2].xyz +
-                    skinMatrix[3].xyz;
+    };
+    std::vector<Prim> primitives;
 
-            aabb.min = min(aabb.min, skinnedPoint);
-            aabb.max = max(aabb.max, skinnedPoint);
+    const cgltf_data* hierarchy = hasSource ? mOwner->mSourceAsset->hierarchy : nullptr;
+    auto addPrimitives = [&](cgltf_size nodeIndex) {
+        const cgltf_mesh* mesh = hierarchy->nodes[nodeIndex].mesh;
+        for (cgltf_size j = 0, nprims = mesh->primitives_count; j < nprims; ++j) {
+            primitives.push_back({ &mesh->primitives[j], targets.size() - 1, {} });
         }
-        return aabb;
     };
 
-    // Collect all mesh primitives that we wish to find bounds for. For each mesh primitive, we also
-    // collect the skin it is bound to (nullptr if not skinned) for bounds computation.
-    size_t primCount = 0;
-    const cgltf_data* hierarchy = mOwner->mSourceAsset->hierarchy;
-    const cgltf_node* nodes = hierarchy->nodes;
-    for (size_t i = 0, n = hierarchy->nodes_count; i < n; ++i) {
-        if (const cgltf_mesh* mesh = nodes[i].mesh; mesh) {
-            primCount += mesh->primitives_count;
-        }
-    }
-    auto primitives = FixedCapacityVector<Prim>::with_capacity(primCount);
-    const cgltf_skin* baseSkin = &hierarchy->skins[0];
-    for (size_t i = 0, n = hierarchy->nodes_count; i < n; ++i) {
-        const cgltf_node& node = nodes[i];
-        const Entity entity = mNodeMap[i];
-        if (entity.isNull()) {
-            continue;
+    if (cached) {
+        // Unskinned nodes simply use their cached bounds, and skinned nodes transform the bounds of
+        // their joints. Skinned nodes without joint bounds (e.g. morphed ones) are skinned from
+        // their vertices when the source data is available.
+        for (const FFilamentAsset::NodeBounds& bounds : mOwner->mNodeBounds) {
+            if (mNodeMap[bounds.node].isNull()) {
+                continue;
+            }
+            auto iter = std::find_if(mOwner->mJointBounds.begin(), mOwner->mJointBounds.end(),
+                    [&bounds](const auto& joints) { return joints.node == bounds.node; });
+            const bool hasJointBounds = iter != mOwner->mJointBounds.end();
+            const cgltf_node* node = hierarchy ? &hierarchy->nodes[bounds.node] : nullptr;
+            if (hasJointBounds) {
+                addTarget(bounds.node, ssize_t(iter->skin));
+                Target& target = targets.back();
+                target.aabb = iter->transform(target.bones.data(), target.bones.size());
+            } else if (node && node->skin) {
+                addTarget(bounds.node, node->skin - hierarchy->skins);
+                addPrimitives(bounds.node);
+            } else {
+                addTarget(bounds.node, -1);
+                targets.back().aabb = bounds.aabb;
+            }
         }
-        if (const cgltf_mesh* mesh = node.mesh; mesh) {
-            for (cgltf_size j = 0, nprims = mesh->primitives_count; j < nprims; ++j) {
-                primitives.push_back({
-                    .prim = &mesh->primitives[j],
-                    .node = entity,
-                    .skinIndex = node.skin ? (node.skin - baseSkin) : -1
-                });
+    } else {
+        for (cgltf_size i = 0, n = hierarchy->nodes_count; i < n; ++i) {
+            const cgltf_node& node = hierarchy->nodes[i];
+            if (!node.mesh || node.has_mesh_gpu_instancing || mNodeMap[i].isNull()) {
+                continue;
             }
+            addTarget(i, node.skin ? node.skin - hierarchy->skins : -1);
+            addPrimitives(i);
         }
     }
 
     // Kick off a bounding box job for every primitive.
-    FixedCapacityVector<Aabb> bounds(primitives.size());
     JobSystem& js = mOwner->mEngine->getJobSystem();
     JobSystem::Job* parent = js.createJob();
-    for (size_t i = 0; i < primitives.size(); ++i) {
-        Aabb& result = bounds[i];
-        const Prim& prim = primitives[i];
-        if (primitives[i].skinIndex < 0) {
-            js.run(jobs::createJob(js, parent, [&prim, &result, computeBoundingBox] {
-                result = computeBoundingBox(prim.prim);
-            }));
-        } else {
-            js.run(jobs::createJob(js, parent, [&prim, &result, computeBoundingBoxSkinned] {
-                result = computeBoundingBoxSkinned(prim);
-            }));
-        }
+    for (Prim& prim : primitives) {
+        const Target& target = targets[prim.target];
+        js.run(jobs::createJob(js, parent, [&prim, &target] {
+            prim.aabb = target.bones.empty() ? utility::computePrimitiveBounds(prim.prim) :
+                    computeSkinnedBounds(*prim.prim, target.bones.data(), target.bones.size());
+        }));
     }
     js.runAndWait(parent);
 
+    // Find the object-space bounds for each renderable by unioning the bounds of each prim.
+    for (const Prim& prim : primitives) {
+        Aabb& aabb = targets[prim.target].aabb;
+        aabb.min = min(aabb.min, prim.aabb.min);
+        aabb.max = max(aabb.max, prim.aabb.max);
+    }
+
     // Compute the asset-level bounding box.
-    size_t primIndex = 0;
     Aabb assetBounds;
-    for (size_t i = 0, n = mOwner->mSourceAsset->hierarchy->nodes_count; i < n; ++i) {
-        const cgltf_node& node = nodes[i];
-        const Entity entity = mNodeMap[i];
-        if (const cgltf_mesh* mesh = node.mesh; mesh) {
-            // Find the object-space bounds for the renderable by unioning the bounds of each prim.
-            Aabb aabb;
-            for (cgltf_size j = 0, nprims = mesh->primitives_count; j < nprims; ++j) {
-                Aabb primBounds = bounds[primIndex++];
-                aabb.min = min(aabb.min, primBounds.min);
-                aabb.max = max(aabb.max, primBounds.max);
-            }
-            auto renderable = rm.getInstance(entity);
-            rm.setAxisAlignedBoundingBox(renderable, Box().set(aabb.min, aabb.max));
-
-            // Transform this bounding box, then update the asset-level bounding box.
-            auto transformable = tm.getInstance(entity);
-            const mat4f worldTransform = tm.getWorldTransform(transformable);
-            const Aabb transformed = aabb.transform(worldTransform);
-            assetBounds.min = min(assetBounds.min, transformed.min);
-            assetBounds.max = max(assetBounds.max, transformed.max);
+    for (const Target& target : targets) {
+        if (auto renderable = rm.getInstance(target.entity)) {
+            rm.setAxisAlignedBoundingBox(renderable, Box().set(target.aabb.min, target.aabb.max));
         }
+
+        // Transform this bounding box, then update the asset-level bounding box.
+        auto transformable = tm.getInstance(target.entity);
+        const mat4f worldTransform = tm.getWorldTransform(transformable);
+        const Aabb transformed = target.aabb.transform(worldTransform);
+        assetBounds.min = min(assetBounds.min, transformed.min);
+        assetBounds.max = max(assetBounds.max, transformed.max);
     }
 
     // Restore the root node.
@@ -334,7 +312,7 @@ const char* FFilamentInstance::getMaterialVariantName(size_t variantIndex) const
     if (variantIndex >= mVariants.size()) {
         return nullptr;
     }
-    return mVariants[variantIndex].name.c_str();
+    return mVariants[variantIndex].name;
 }
 
 void FFilamentInstance::applyMaterialVariant(size_t variantIndex) noexcept {
@@ -343,9 +321,22 @@ void FFilamentInstance::applyMaterialVariant(size_t variantIndex) noexcept {
     }
     const auto& mappings = mVariants[variantIndex].mappings;
     RenderableManager& rm = mOwner->mEngine->getRenderableManager();
+    Entity entity;
+    RenderableManager::Instance renderable;
     for (const auto& mapping : mappings) {
-        auto renderable = rm.getInstance(mapping.renderable);
-        rm.setMaterialInstanceAt(renderable, mapping.primitiveIndex, mapping.material);
+        // The mappings of a renderable are contiguous, since AssetLoader creates them one
+        // renderable at a time, so each renderable is looked up once.
+        if (mapping.renderable != entity) {
+            entity = mapping.renderable;
+            renderable = rm.getInstance(entity);
+        }
+        if (!renderable) {
+            continue;
+        }
+        // Primitives that already use the material of the variant are left alone.
+        if (rm.getMaterialInstanceAt(renderable, mapping.primitiveIndex) != mapping.material) {
+            rm.setMaterialInstanceAt(renderable, mapping.primitiveIndex, mapping.material);
+        }
     }
 }
 
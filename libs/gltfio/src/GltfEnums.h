@@ -264,4 +264,24 @@ inline bool getElementType(cgltf_type type, cgltf_component_type ctype,
     return false;
 }
 
+// Float texture coordinates with known bounds within [0, 1] or [-1, 1] can be stored as normalized
+// USHORT2 or SHORT2, respectively. Returns false if the accessor should be kept as is.
+inline bool getQuantizedTexCoordType(cgltf_accessor const* accessor,
+        filament::VertexBuffer::AttributeType* type) {
+    if (accessor->type != cgltf_type_vec2 ||
+            accessor->component_type != cgltf_component_type_r_32f ||
+            !accessor->has_min || !accessor->has_max) {
+        return false;
+    }
+    const float* minp = &accessor->min[0];
+    const float* maxp = &accessor->max[0];
+    if (maxp[0] > 1.0f || maxp[1] > 1.0f || minp[0] < -1.0f || minp[1] < -1.0f) {
+        return false;
+    }
+    const bool isUnsigned = minp[0] >= 0.0f && minp[1] >= 0.0f;
+    *type = isUnsigned ? filament::VertexBuffer::AttributeType::USHORT2 :
+            filament::VertexBuffer::AttributeType::SHORT2;
+    return true;
+}
+
 #endif // GLTFIO_GLTFENUMS_H
@@ -16,13 +16,23 @@
 
 #include <gltfio/MaterialProvider.h>
 
+#include <filament/MaterialEnums.h>
+
 #include <filamat/MaterialBuilder.h>
 
 #include <utils/Hash.h>
+#include <utils/Log.h>
 
 #include <tsl/robin_map.h>
 
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
+
+#include <string.h>
 
 using namespace filamat;
 using namespace filament;
@@ -31,9 +41,129 @@ using namespace utils;
 
 namespace {
 
+using PackageData = std::shared_ptr<const std::vector<uint8_t>>;
+
+// Everything that goes into a generated material package. The label is not part of it, so a
+// package is named after the first material that needed it, like materials are within a provider.
+struct alignas(4) PackageKey {
+    MaterialKey material;
+    UvMap uvmap;
+    uint8_t targetApi;
+    uint8_t stereoscopicType;
+    uint8_t stereoscopicEyeCount;
+    uint8_t optimizeShaders;
+};
+
+static_assert(sizeof(PackageKey) % 4 == 0, "PackageKey must be hashable.");
+
+inline bool operator==(PackageKey const& lhs, PackageKey const& rhs) noexcept {
+    return memcmp(&lhs, &rhs, sizeof(PackageKey)) == 0;
+}
+
+// Materials are owned by an Engine, but the packages they are built from only depend on the key,
+// so they are cached for the whole process: other providers, e.g. those of other engines or of
+// JIT providers that were destroyed and created again, don't have to invoke filamat again.
+// Packages can also be persisted in a directory, which makes later runs skip filamat entirely.
+class PackageCache {
+public:
+    static PackageCache& get() noexcept {
+        static PackageCache sCache;
+        return sCache;
+    }
+
+    PackageData find(PackageKey const& key, const char* directory);
+    void insert(PackageKey const& key, PackageData const& data, const char* directory);
+
+private:
+    // Files start with this header, the package follows. The key guards against hash
+    // collisions and the checksum against truncated files: Filament panics on invalid packages.
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t materialVersion;
+        uint32_t size;
+        uint32_t checksum;
+        PackageKey key;
+    };
+
+    static constexpr uint32_t FILE_MAGIC = 0x4A495446; // 'JITF'
+
+    static std::string getPath(PackageKey const& key, const char* directory);
+
+    using HashFn = hash::MurmurHashFn<PackageKey>;
+    tsl::robin_map<PackageKey, PackageData, HashFn> mPackages;
+    std::mutex mLock;
+};
+
+std::string PackageCache::getPath(PackageKey const& key, const char* directory) {
+    char name[32];
+    snprintf(name, sizeof(name), "/%08x.filamat", HashFn{}(key));
+    return directory + std::string(name);
+}
+
+PackageData PackageCache::find(PackageKey const& key, const char* directory) {
+    {
+        std::lock_guard const lock(mLock);
+        if (auto iter = mPackages.find(key); iter != mPackages.end()) {
+            return iter.value();
+        }
+    }
+    if (!directory) {
+        return {};
+    }
+
+    std::ifstream in(getPath(key, directory), std::ios::binary);
+    FileHeader header;
+    if (!in || !in.read((char*) &header, sizeof(header)) ||
+            header.magic != FILE_MAGIC || header.materialVersion != MATERIAL_VERSION ||
+            !(header.key == key)) {
+        return {};
+    }
+    std::vector<uint8_t> bytes(header.size);
+    if (!in.read((char*) bytes.data(), std::streamsize(bytes.size())) ||
+            hash::murmurSlow(bytes.data(), bytes.size(), 0) != header.checksum) {
+        slog.w << "Ignoring invalid cached material in " << directory << io::endl;
+        return {};
+    }
+
+    auto data = std::make_shared<const std::vector<uint8_t>>(std::move(bytes));
+    std::lock_guard const lock(mLock);
+    return mPackages.emplace(key, data).first.value();
+}
+
+void PackageCache::insert(PackageKey const& key, PackageData const& data, const char* directory) {
+    {
+        std::lock_guard const lock(mLock);
+        mPackages.emplace(key, data);
+    }
+    if (!directory) {
+        return;
+    }
+
+    // Write to a temporary file first so that concurrent readers never see a partial package.
+    std::string const path = getPath(key, directory);
+    std::string const temp = path + ".tmp";
+    FileHeader header{};
+    header.magic = FILE_MAGIC;
+    header.materialVersion = MATERIAL_VERSION;
+    header.size = uint32_t(data->size());
+    header.checksum = hash::murmurSlow(data->data(), data->size(), 0);
+    header.key = key;
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out || !out.write((const char*) &header, sizeof(header)) ||
+                !out.write((const char*) data->data(), std::streamsize(data->size()))) {
+            slog.w << "Unable to write cached material to " << directory << io::endl;
+            return;
+        }
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+    }
+}
+
 class JitShaderProvider : public MaterialProvider {
 public:
-    explicit JitShaderProvider(Engine* engine, bool optimizeShaders);
+    JitShaderProvider(Engine* engine, bool optimizeShaders, const char* cacheDirectory);
     ~JitShaderProvider() override;
 
     MaterialInstance* createMaterialInstance(MaterialKey* config, UvMap* uvmap,
@@ -52,12 +182,15 @@ public:
     using HashFn = hash::MurmurHashFn<MaterialKey>;
     tsl::robin_map<MaterialKey, Material*, HashFn> mCache;
     std::vector<Material*> mMaterials;
+    std::mutex mLock;
     Engine* const mEngine;
     const bool mOptimizeShaders;
+    const std::string mCacheDirectory;
 };
 
-JitShaderProvider::JitShaderProvider(Engine* engine, bool optimizeShaders) : mEngine(engine),
-        mOptimizeShaders(optimizeShaders) {
+JitShaderProvider::JitShaderProvider(Engine* engine, bool optimizeShaders,
+        const char* cacheDirectory) : mEngine(engine), mOptimizeShaders(optimizeShaders),
+        mCacheDirectory(cacheDirectory ? cacheDirectory : "") {
     MaterialBuilder::init();
 }
 
@@ -74,6 +207,7 @@ const Material* const* JitShaderProvider::getMaterials() const noexcept {
 }
 
 void JitShaderProvider::destroyMaterials() {
+    std::lock_guard const lock(mLock);
     for (auto& iter : mCache) {
         mEngine->destroy(iter.second);
     }
@@ -314,7 +448,7 @@ std::string shaderFromKey(const MaterialKey& config) {
     return shader;
 }
 
-Material* createMaterial(Engine* engine, const MaterialKey& config, const UvMap& uvmap,
+std::vector<uint8_t> buildPackage(Engine* engine, const MaterialKey& config, const UvMap& uvmap,
         const char* name, bool optimizeShaders) {
     std::string shader = shaderFromKey(config);
     processShaderString(&shader, uvmap, config);
@@ -533,11 +667,33 @@ Material* createMaterial(Engine* engine, const MaterialKey& config, const UvMap&
     }
 
     Package pkg = builder.build(engine->getJobSystem());
-    return Material::Builder().package(pkg.getData(), pkg.getSize()).build(*engine);
+    return { pkg.getData(), pkg.getData() + pkg.getSize() };
+}
+
+Material* createMaterial(Engine* engine, const MaterialKey& config, const UvMap& uvmap,
+        const char* name, bool optimizeShaders, const char* cacheDirectory) {
+    PackageKey key;
+    memset(&key, 0, sizeof(key));
+    key.material = config;
+    key.uvmap = uvmap;
+    key.targetApi = uint8_t(filamat::targetApiFromBackend(engine->getBackend()));
+    key.stereoscopicType = uint8_t(engine->getConfig().stereoscopicType);
+    key.stereoscopicEyeCount = engine->getConfig().stereoscopicEyeCount;
+    key.optimizeShaders = optimizeShaders;
+
+    PackageCache& cache = PackageCache::get();
+    PackageData data = cache.find(key, cacheDirectory);
+    if (!data) {
+        data = std::make_shared<const std::vector<uint8_t>>(
+                buildPackage(engine, config, uvmap, name, optimizeShaders));
+        cache.insert(key, data, cacheDirectory);
+    }
+    return Material::Builder().package(data->data(), data->size()).build(*engine);
 }
 
 Material* JitShaderProvider::getMaterial(MaterialKey* config, UvMap* uvmap, const char* label) {
     constrainMaterial(config, uvmap);
+    std::lock_guard const lock(mLock);
     auto iter = mCache.find(*config);
     if (iter == mCache.end()) {
 
@@ -546,7 +702,8 @@ Material* JitShaderProvider::getMaterial(MaterialKey* config, UvMap* uvmap, cons
         optimizeShaders = false;
 #endif
 
-        Material* mat = createMaterial(mEngine, *config, *uvmap, label, optimizeShaders);
+        Material* mat = createMaterial(mEngine, *config, *uvmap, label, optimizeShaders,
+                mCacheDirectory.empty() ? nullptr : mCacheDirectory.c_str());
         mCache.emplace(std::make_pair(*config, mat));
         mMaterials.push_back(mat);
         return mat;
@@ -563,8 +720,9 @@ MaterialInstance* JitShaderProvider::createMaterialInstance(MaterialKey* config,
 
 namespace filament::gltfio {
 
-MaterialProvider* createJitShaderProvider(filament::Engine* engine, bool optimizeShaders) {
-    return new JitShaderProvider(engine, optimizeShaders);
+MaterialProvider* createJitShaderProvider(filament::Engine* engine, bool optimizeShaders,
+        const char* cacheDirectory) {
+    return new JitShaderProvider(engine, optimizeShaders, cacheDirectory);
 }
 
 } // namespace filament::gltfio
@@ -26,6 +26,8 @@
 
 #include <ktxreader/Ktx2Reader.h>
 
+#include "DecoderQueue.h"
+
 using namespace filament;
 using namespace utils;
 
@@ -47,6 +49,7 @@ public:
     void updateQueue() final;
     void waitForCompletion() final;
     void cancelDecoding() final;
+    void setDecodingPriority(Texture* texture, int priority) final;
     const char* getPushMessage() const final;
     const char* getPopMessage() const final;
     size_t getPushedCount() const final { return mPushedCount; }
@@ -70,20 +73,20 @@ private:
         ktxreader::Ktx2Reader::Async* async;
         QueueItemState state;
         atomic<TranscoderState> transcoderState;
-        JobSystem::Job* job;
+        DecoderQueue::Ticket ticket;
     };
 
-    void transcodeSingleTexture();
+    static void transcode(QueueItem* item, JobSystem& js);
 
     size_t mPushedCount = 0;
     size_t mPoppedCount = 0;
     size_t mDecodedCount = 0;
     vector<unique_ptr<QueueItem> > mQueueItems;
-    JobSystem::Job* mDecoderRootJob;
     std::string mRecentPushMessage;
     std::string mRecentPopMessage;
     std::unique_ptr<ktxreader::Ktx2Reader> mKtxReader;
     Engine* const mEngine;
+    DecoderQueue mDecoderQueue;
 };
 
 Texture* Ktx2Provider::pushTexture(const uint8_t* data, size_t byteCount,
@@ -106,23 +109,9 @@ Texture* Ktx2Provider::pushTexture(const uint8_t* data, size_t byteCount,
     item->async = async;
     item->state = QueueItemState::TRANSCODING;
     item->transcoderState.store(TranscoderState::NOT_STARTED);
-
-    // On single threaded systems, it is usually fine to create jobs because the job system will
-    // simply execute serially. However in our case, we wish to amortize the decoder cost across
-    // several frames, so we instead use the updateQueue() method to perform decoding.
-    if constexpr (!UTILS_HAS_THREADING) {
-        item->job = nullptr;
-        return async->getTexture();
-    }
-
-    JobSystem* js = &mEngine->getJobSystem();
-    item->job = jobs::createJob(*js, mDecoderRootJob, [item] {
-        using Result = ktxreader::Ktx2Reader::Result;
-        const bool success = Result::SUCCESS == item->async->doTranscoding();
-        item->transcoderState.store(success ? TranscoderState::SUCCESS : TranscoderState::ERROR);
+    item->ticket = mDecoderQueue.push([item, &js = mEngine->getJobSystem()] {
+        transcode(item, js);
     });
-
-    js->runAndRetain(item->job);
     return async->getTexture();
 }
 
@@ -150,29 +139,26 @@ Texture* Ktx2Provider::popTexture() {
 }
 
 void Ktx2Provider::updateQueue() {
-    if (!UTILS_HAS_THREADING) {
-        transcodeSingleTexture();
-    }
-    JobSystem* js = &mEngine->getJobSystem();
+    mDecoderQueue.update();
     for (auto& item : mQueueItems) {
         if (item->state != QueueItemState::TRANSCODING) {
             continue;
         }
-        item->async->getTexture();
         const TranscoderState state = item->transcoderState.load();
-        if (state != TranscoderState::NOT_STARTED) {
-            if (item->job) {
-                js->waitAndRelease(item->job);
-            }
-            if (state == TranscoderState::ERROR) {
-                item->state = QueueItemState::READY;
-                ++mDecodedCount;
-                continue;
-            }
+        if (state == TranscoderState::NOT_STARTED) {
+            // Hand over the mipmaps that are already transcoded, so that the upload cost is spread
+            // across several updates.
             item->async->uploadImages();
+            continue;
+        }
+        if (state == TranscoderState::ERROR) {
             item->state = QueueItemState::READY;
             ++mDecodedCount;
+            continue;
         }
+        item->async->uploadImages();
+        item->state = QueueItemState::READY;
+        ++mDecodedCount;
     }
 
     // Here we periodically clean up the "queue" (which is really just a vector) by removing unused
@@ -184,19 +170,12 @@ void Ktx2Provider::updateQueue() {
 }
 
 void Ktx2Provider::waitForCompletion() {
-    JobSystem& js = mEngine->getJobSystem();
-    for (auto& item : mQueueItems) {
-        if (item->job) {
-            js.waitAndRelease(item->job);
-        }
-    }
+    mDecoderQueue.waitForCompletion();
 }
 
 void Ktx2Provider::cancelDecoding() {
-    // TODO: Currently, Ktx2Provider runs jobs eagerly and JobSystem does not allow cancellation of
-    // in-flight jobs. We should consider throttling the number of simultaneous decoder jobs, which
-    // would allow for actual cancellation.
-    waitForCompletion();
+    // Queued textures are dropped without being transcoded, only the running jobs are waited for.
+    mDecoderQueue.cancel();
 
     // For cancelled jobs, we need to set the QueueItemState to POPPED and free the decoded data
     // stored in item->async.
@@ -218,20 +197,24 @@ const char* Ktx2Provider::getPopMessage() const {
     return mRecentPopMessage.empty() ? nullptr : mRecentPopMessage.c_str();
 }
 
-void Ktx2Provider::transcodeSingleTexture() {
-    assert_invariant(!UTILS_HAS_THREADING);
+void Ktx2Provider::setDecodingPriority(Texture* texture, int priority) {
     for (auto& item : mQueueItems) {
-        if (item->state == QueueItemState::TRANSCODING) {
-            using Result = ktxreader::Ktx2Reader::Result;
-            bool success = Result::SUCCESS == item->async->doTranscoding();
-            item->transcoderState.store(success ? TranscoderState::SUCCESS : TranscoderState::ERROR);
-            break;
+        if (item->async && item->async->getTexture() == texture) {
+            mDecoderQueue.setPriority(item->ticket, priority);
+            return;
         }
     }
 }
 
-Ktx2Provider::Ktx2Provider(Engine* engine) : mEngine(engine) {
-    mDecoderRootJob = mEngine->getJobSystem().createJob();
+void Ktx2Provider::transcode(QueueItem* item, JobSystem& js) {
+    using Result = ktxreader::Ktx2Reader::Result;
+    const bool success = Result::SUCCESS == (UTILS_HAS_THREADING ?
+            item->async->doTranscoding(js) : item->async->doTranscoding());
+    item->transcoderState.store(success ? TranscoderState::SUCCESS : TranscoderState::ERROR);
+}
+
+Ktx2Provider::Ktx2Provider(Engine* engine)
+        : mEngine(engine), mDecoderQueue(engine->getJobSystem()) {
 #ifdef NDEBUG
     const bool quiet = true;
 #else
@@ -253,7 +236,6 @@ Ktx2Provider::~Ktx2Provider() {
     for (auto& item : mQueueItems) {
         mKtxReader->asyncDestroy(&item->async);
     }
-    mEngine->getJobSystem().release(mDecoderRootJob);
 }
 
 TextureProvider* createKtx2Provider(Engine* engine) {
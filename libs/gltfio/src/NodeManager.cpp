@@ -56,19 +56,19 @@ void NodeManager::destroy(Entity e) noexcept {
     downcast(this)->destroy(e);
 }
 
-void NodeManager::setMorphTargetNames(Instance ci, FixedCapacityVector<CString> names) noexcept {
-    downcast(this)->setMorphTargetNames(ci, std::move(names));
+void NodeManager::setMorphTargetNames(Instance ci, Slice<const char* const> names) noexcept {
+    downcast(this)->setMorphTargetNames(ci, names);
 }
 
-const FixedCapacityVector<CString>& NodeManager::getMorphTargetNames(Instance ci) const noexcept {
+Slice<const char* const> NodeManager::getMorphTargetNames(Instance ci) const noexcept {
     return downcast(this)->getMorphTargetNames(ci);
 }
 
-void NodeManager::setExtras(Instance ci, CString extras) noexcept {
-    return downcast(this)->setExtras(ci, std::move(extras));
+void NodeManager::setExtras(Instance ci, const char* extras) noexcept {
+    return downcast(this)->setExtras(ci, extras);
 }
 
-const CString& NodeManager::getExtras(Instance ci) const noexcept {
+const char* NodeManager::getExtras(Instance ci) const noexcept {
     return downcast(this)->getExtras(ci);
 }
 
@@ -16,7 +16,9 @@
 
 #include <gltfio/ResourceLoader.h>
 #include <gltfio/TextureProvider.h>
+#include <gltfio/math.h>
 
+#include "AnimationStream.h"
 #include "GltfEnums.h"
 #include "FFilamentAsset.h"
 #include "TangentsJob.h"
@@ -49,10 +51,14 @@
 
 #include <tsl/robin_map.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <fstream>
 #include <memory>
 #include <string>
 #include <tuple>
+#include <vector>
 
 using namespace filament;
 using namespace filament::math;
@@ -67,6 +73,11 @@ namespace filament::gltfio {
 using BufferTextureCache = tsl::robin_map<const void*, Texture*>;
 using FilepathTextureCache = tsl::robin_map<std::string, Texture*>;
 using TextureProviderList = tsl::robin_map<std::string, TextureProvider*>;
+using BufferSlot = FFilamentAsset::ResourceInfo::BufferSlot;
+using TangentsJobParams = TangentsJob::Params;
+
+// How long each call to asyncUpdateLoad() spends uploading geometry in the progressive mode.
+static constexpr std::chrono::microseconds PROGRESSIVE_GEOMETRY_BUDGET{ 2000 };
 
 namespace {
 enum class CacheResult {
@@ -81,11 +92,23 @@ struct ResourceLoader::Impl {
     explicit Impl(const ResourceConfiguration& config) :
         mEngine(config.engine),
         mNormalizeSkinningWeights(config.normalizeSkinningWeights),
+        mCompressAnimations(config.compressAnimations),
+        mStreamedAnimationDuration(config.streamedAnimationDuration),
+        mAnimationChunkDuration(config.animationChunkDuration),
+        mProgressiveGeometry(config.progressiveGeometry),
+        mOptimizeIndices(config.optimizeIndices),
+        mCacheBoundingBoxes(config.cacheBoundingBoxes),
         mGltfPath(config.gltfPath ? config.gltfPath : ""),
         mUriDataCache(std::make_shared<UriDataCache>()) {}
 
     Engine* const mEngine;
     bool mNormalizeSkinningWeights;
+    bool mCompressAnimations;
+    float mStreamedAnimationDuration;
+    float mAnimationChunkDuration;
+    bool mProgressiveGeometry;
+    bool mOptimizeIndices;
+    bool mCacheBoundingBoxes;
     std::string mGltfPath;
 
     // User-provided resource data with URI string keys, populated with addResourceData().
@@ -102,8 +125,31 @@ struct ResourceLoader::Impl {
     FFilamentAsset* mAsyncAsset = nullptr;
     size_t mRemainingTextureDownloads = 0;
 
+    // The buffers of a single primitive, which are uploaded together in the progressive mode.
+    struct GeometryBatch {
+        const cgltf_mesh* mesh;
+        const cgltf_primitive* prim;
+        cgltf_size primIndex;
+        Primitive primitive;
+        float size;
+        std::vector<BufferSlot> slots;
+    };
+
+    // Geometry that hasn't been uploaded yet, the largest primitive is at the back. The source
+    // handle keeps the cgltf data alive even if the client releases the source data early.
+    FFilamentAsset* mGeometryAsset = nullptr;
+    FFilamentAsset::SourceHandle mGeometrySource;
+    std::vector<GeometryBatch> mGeometryBatches;
+    size_t mGeometryBatchCount = 0;
+    bool mGeometryDecodeDraco = false;
+
     void addResourceData(const char* uri, BufferDescriptor&& buffer);
     void computeTangents(FFilamentAsset* asset);
+    void runTangentsJobs(FFilamentAsset* asset, std::vector<TangentsJobParams>& jobParams);
+    void beginGeometryStreaming(FFilamentAsset* asset, bool decodeDraco);
+    void uploadGeometry(GeometryBatch& batch);
+    void updateGeometryStreaming(bool uploadAll);
+    void cancelGeometryStreaming();
     void createTextures(FFilamentAsset* asset, bool async);
     void cancelTextureDecoding();
     std::pair<Texture*, CacheResult> getOrCreateTexture(FFilamentAsset* asset, size_t textureIndex,
@@ -120,11 +166,13 @@ struct UploadEvent {
 };
 
 UploadEvent* uploadUserdata(FFilamentAsset* asset, UriDataCacheHandle dataCache) {
+    asset->mSourceAsset->acquireUpload();
     return new UploadEvent({ asset->mSourceAsset, dataCache });
 }
 
 void uploadCallback(void* buffer, size_t size, void* user) {
     auto event = (UploadEvent*) user;
+    event->handle->releaseUpload();
     delete event;
 }
 
@@ -227,10 +275,278 @@ inline void createSkins(cgltf_data const* gltf, bool normalize,
     }
 }
 
+// Computes the bounds of the vertices influenced by each joint of every skinned node. A skinned
+// vertex is a convex combination of the positions given by the bones of its joints, so the union of
+// the joint bounds transformed by their bones contains the skinned mesh. Nodes whose data cannot be
+// read, or whose positions are morphed, are left out.
+inline void computeJointBounds(cgltf_data const* gltf, bool dracoDecoded,
+        std::vector<FFilamentAsset::JointBounds>& result) {
+    auto unpack = [](cgltf_accessor const* accessor, size_t dim, std::vector<float>& dst) {
+        dst.resize(accessor->count * dim);
+        return accessor->buffer_view && cgltf_num_components(accessor->type) == dim &&
+                cgltf_accessor_unpack_floats(accessor, dst.data(), dst.size()) == dst.size();
+    };
+    std::vector<float> positions;
+    std::vector<float> joints;
+    std::vector<float> weights;
+    for (cgltf_size nodeIndex = 0; nodeIndex < gltf->nodes_count; ++nodeIndex) {
+        const cgltf_node& node = gltf->nodes[nodeIndex];
+        if (!node.mesh || !node.skin || node.has_mesh_gpu_instancing) {
+            continue;
+        }
+        const cgltf_size jointCount = node.skin->joints_count;
+        FixedCapacityVector<Aabb> bounds(jointCount);
+        bool valid = true;
+        for (cgltf_size pindex = 0; pindex < node.mesh->primitives_count; ++pindex) {
+            const cgltf_primitive& prim = node.mesh->primitives[pindex];
+            if (prim.has_draco_mesh_compression && !dracoDecoded) {
+                valid = false;
+                break;
+            }
+            for (cgltf_size tindex = 0; tindex < prim.targets_count; ++tindex) {
+                const cgltf_morph_target& target = prim.targets[tindex];
+                for (cgltf_size aindex = 0; aindex < target.attributes_count; ++aindex) {
+                    if (target.attributes[aindex].type == cgltf_attribute_type_position) {
+                        valid = false;
+                    }
+                }
+            }
+            const cgltf_accessor* positionsAccessor = nullptr;
+            const cgltf_accessor* jointsAccessor = nullptr;
+            const cgltf_accessor* weightsAccessor = nullptr;
+            for (cgltf_size aindex = 0; aindex < prim.attributes_count; ++aindex) {
+                const cgltf_attribute& attr = prim.attributes[aindex];
+                if (attr.index > 0) {
+                    continue;
+                }
+                switch (attr.type) {
+                    case cgltf_attribute_type_position: positionsAccessor = attr.data; break;
+                    case cgltf_attribute_type_joints: jointsAccessor = attr.data; break;
+                    case cgltf_attribute_type_weights: weightsAccessor = attr.data; break;
+                    default: break;
+                }
+            }
+            if (!valid || !positionsAccessor || !jointsAccessor || !weightsAccessor ||
+                    !unpack(positionsAccessor, 3, positions) ||
+                    !unpack(jointsAccessor, 4, joints) ||
+                    !unpack(weightsAccessor, 4, weights) ||
+                    jointsAccessor->count != positionsAccessor->count ||
+                    weightsAccessor->count != positionsAccessor->count) {
+                valid = false;
+                break;
+            }
+            for (size_t i = 0, n = positionsAccessor->count; i < n; ++i) {
+                const float3 position{ positions[i * 3], positions[i * 3 + 1],
+                        positions[i * 3 + 2] };
+                for (size_t j = 0; j < 4; ++j) {
+                    const size_t joint = size_t(joints[i * 4 + j]);
+                    if (weights[i * 4 + j] > 0.0f && joint < jointCount) {
+                        bounds[joint].min = min(bounds[joint].min, position);
+                        bounds[joint].max = max(bounds[joint].max, position);
+                    }
+                }
+            }
+        }
+        if (valid) {
+            result.push_back({ nodeIndex, cgltf_size(node.skin - gltf->skins), std::move(bounds) });
+        }
+    }
+}
+
+// Computes the object-space bounds of every node with a mesh, one job per node, so that
+// FilamentInstance::recomputeBoundingBoxes does not need to read the vertices again. Nodes that use
+// instancing, or whose data cannot be read, are left out.
+inline void computeNodeBounds(cgltf_data const* gltf, bool dracoDecoded, JobSystem& js,
+        std::vector<FFilamentAsset::NodeBounds>& result) {
+    for (cgltf_size nodeIndex = 0; nodeIndex < gltf->nodes_count; ++nodeIndex) {
+        const cgltf_node& node = gltf->nodes[nodeIndex];
+        if (!node.mesh || node.has_mesh_gpu_instancing) {
+            continue;
+        }
+        const cgltf_primitive* prims = node.mesh->primitives;
+        const cgltf_size primCount = node.mesh->primitives_count;
+        if (!dracoDecoded && std::any_of(prims, prims + primCount,
+                [](const cgltf_primitive& prim) { return prim.has_draco_mesh_compression; })) {
+            continue;
+        }
+        result.push_back({ nodeIndex, {} });
+    }
+    JobSystem::Job* parent = js.createJob();
+    for (FFilamentAsset::NodeBounds& dst : result) {
+        const cgltf_mesh* mesh = gltf->nodes[dst.node].mesh;
+        js.run(jobs::createJob(js, parent, [mesh, &dst] {
+            for (cgltf_size i = 0; i < mesh->primitives_count; ++i) {
+                const Aabb aabb = utility::computePrimitiveBounds(&mesh->primitives[i]);
+                dst.aabb.min = min(dst.aabb.min, aabb.min);
+                dst.aabb.max = max(dst.aabb.max, aabb.max);
+            }
+        }));
+    }
+    js.runAndWait(parent);
+}
+
+// Decodes the instance transforms of every node that uses EXT_mesh_gpu_instancing, then uploads
+// them to the renderables that AssetLoader has created so far and expands the bounding boxes.
+inline void decodeGpuInstances(cgltf_data const* gltf, FFilamentAsset* asset) {
+    for (cgltf_size nodeIndex = 0; nodeIndex < gltf->nodes_count; ++nodeIndex) {
+        const cgltf_node& node = gltf->nodes[nodeIndex];
+        if (!node.mesh || !node.has_mesh_gpu_instancing ||
+                node.mesh_gpu_instancing.attributes_count == 0) {
+            continue;
+        }
+        const cgltf_mesh_gpu_instancing& instancing = node.mesh_gpu_instancing;
+        const size_t count = instancing.attributes[0].data->count;
+        FixedCapacityVector<float3> translations(count, float3(0.0f));
+        FixedCapacityVector<quatf> rotations(count, quatf{ 1.0f, 0.0f, 0.0f, 0.0f });
+        FixedCapacityVector<float3> scales(count, float3(1.0f));
+        bool valid = true;
+        for (cgltf_size aindex = 0; aindex < instancing.attributes_count; ++aindex) {
+            const cgltf_attribute& attr = instancing.attributes[aindex];
+            const std::string_view name = attr.name ? attr.name : "";
+            float* dst;
+            size_t dim;
+            if (name == "TRANSLATION") {
+                dst = &translations.data()->x;
+                dim = 3;
+            } else if (name == "ROTATION") {
+                dst = &rotations.data()->x;
+                dim = 4;
+            } else if (name == "SCALE") {
+                dst = &scales.data()->x;
+                dim = 3;
+            } else {
+                continue;
+            }
+            const cgltf_accessor* accessor = attr.data;
+            if (accessor->count != count || cgltf_num_components(accessor->type) != dim ||
+                    cgltf_accessor_unpack_floats(accessor, dst, count * dim) != count * dim) {
+                valid = false;
+            }
+        }
+        if (!valid) {
+            slog.e << "Invalid EXT_mesh_gpu_instancing attributes in node "
+                   << (node.name ? node.name : "") << io::endl;
+            continue;
+        }
+
+        FixedCapacityVector<mat4f> transforms(count);
+        for (size_t i = 0; i < count; ++i) {
+            transforms[i] = composeMatrix(translations[i], rotations[i], scales[i]);
+        }
+
+        // The bounding box of the asset includes every instance.
+        auto first = std::find_if(asset->mGpuInstances.begin(), asset->mGpuInstances.end(),
+                [nodeIndex](const auto& instances) { return instances.node == nodeIndex; });
+        if (first != asset->mGpuInstances.end()) {
+            mat4f worldTransform;
+            cgltf_node_transform_world(&node, &worldTransform[0][0]);
+            Aabb aabb;
+            for (const mat4f& transform : transforms) {
+                const Aabb transformed = first->aabb.transform(worldTransform * transform);
+                aabb.min = min(aabb.min, transformed.min);
+                aabb.max = max(aabb.max, transformed.max);
+            }
+            auto expand = [&aabb](Aabb& box) {
+                box.min = min(box.min, aabb.min);
+                box.max = max(box.max, aabb.max);
+            };
+            expand(asset->mBoundingBox);
+            for (FFilamentInstance* instance : asset->mInstances) {
+                expand(instance->mBoundingBox);
+            }
+        }
+
+        asset->mGpuInstanceTransforms[nodeIndex] = std::move(transforms);
+    }
+    for (const auto& instances : asset->mGpuInstances) {
+        asset->applyGpuInstances(instances);
+    }
+}
+
+// Returns a malloc'd copy of the given triangle indices, reordered for the post-transform vertex
+// cache and then for overdraw, or null if the primitive cannot be optimized. 8-bit indices are
+// widened to 16 bits, like they are without optimization.
+void* optimizeIndices(const cgltf_primitive* prim, const uint8_t* data, size_t* outSize) {
+    const cgltf_accessor* indices = prim->indices;
+    if (prim->type != cgltf_primitive_type_triangles || indices->count % 3 != 0 ||
+            prim->has_draco_mesh_compression) {
+        return nullptr;
+    }
+    const cgltf_accessor* positions = nullptr;
+    for (cgltf_size aindex = 0; aindex < prim->attributes_count; aindex++) {
+        if (prim->attributes[aindex].type == cgltf_attribute_type_position) {
+            positions = prim->attributes[aindex].data;
+            break;
+        }
+    }
+    if (!positions || !positions->buffer_view || positions->type != cgltf_type_vec3) {
+        return nullptr;
+    }
+
+    const size_t indexCount = indices->count;
+    const size_t vertexCount = positions->count;
+    std::vector<uint32_t> source(indexCount);
+    for (size_t i = 0; i < indexCount; ++i) {
+        switch (indices->component_type) {
+            case cgltf_component_type_r_8u: source[i] = data[i]; break;
+            case cgltf_component_type_r_16u: source[i] = ((const uint16_t*) data)[i]; break;
+            default: source[i] = ((const uint32_t*) data)[i]; break;
+        }
+        if (UTILS_UNLIKELY(source[i] >= vertexCount)) {
+            return nullptr;
+        }
+    }
+
+    std::vector<float> vertices(vertexCount * 3);
+    cgltf_accessor_unpack_floats(positions, vertices.data(), vertices.size());
+
+    std::vector<uint32_t> optimized(indexCount);
+    meshopt_optimizeVertexCache(optimized.data(), source.data(), indexCount, vertexCount);
+    meshopt_optimizeOverdraw(source.data(), optimized.data(), indexCount, vertices.data(),
+            vertexCount, sizeof(float3), 1.05f);
+
+    if (indices->component_type == cgltf_component_type_r_32u) {
+        *outSize = indexCount * sizeof(uint32_t);
+        void* result = malloc(*outSize);
+        memcpy(result, source.data(), *outSize);
+        return result;
+    }
+    *outSize = indexCount * sizeof(uint16_t);
+    uint16_t* result = (uint16_t*) malloc(*outSize);
+    for (size_t i = 0; i < indexCount; ++i) {
+        result[i] = uint16_t(source[i]);
+    }
+    return result;
+}
+
+// Converts float texture coordinates to the normalized USHORT2 or SHORT2 type that AssetLoader
+// selected, see getQuantizedTexCoordType. The result must be freed by the caller.
+uint16_t* quantizeTexCoords(const cgltf_accessor* accessor) {
+    VertexBuffer::AttributeType type;
+    UTILS_UNUSED_IN_RELEASE bool const quantizable = getQuantizedTexCoordType(accessor, &type);
+    assert_invariant(quantizable);
+    const size_t count = accessor->count * 2;
+    float* floats = (float*) malloc(sizeof(float) * count);
+    cgltf_accessor_unpack_floats(accessor, floats, count);
+    uint16_t* quantized = (uint16_t*) malloc(sizeof(uint16_t) * count);
+    if (type == VertexBuffer::AttributeType::USHORT2) {
+        for (size_t i = 0; i < count; ++i) {
+            quantized[i] = uint16_t(std::clamp(floats[i], 0.0f, 1.0f) * 65535.0f + 0.5f);
+        }
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            quantized[i] = uint16_t(int16_t(std::round(
+                    std::clamp(floats[i], -1.0f, 1.0f) * 32767.0f)));
+        }
+    }
+    free(floats);
+    return quantized;
+}
+
 inline void uploadBuffers(FFilamentAsset* asset, Engine& engine,
-        UriDataCacheHandle uriDataCache) {
+        UriDataCacheHandle uriDataCache, std::vector<BufferSlot> const& slots,
+        bool optimize) {
     // Upload VertexBuffer and IndexBuffer data to the GPU.
-    auto& slots = std::get<FFilamentAsset::ResourceInfo>(asset->mResourceInfo).mBufferSlots;
     for (auto const& slot: slots) {
         const cgltf_accessor* accessor = slot.accessor;
         if (!accessor->buffer_view) {
@@ -248,6 +564,16 @@ inline void uploadBuffers(FFilamentAsset* asset, Engine& engine,
         assert_invariant(bufferData);
         const uint32_t size = utility::computeBindingSize(accessor);
         if (slot.vertexBuffer) {
+            if (slot.quantized) {
+                uint16_t* quantized = quantizeTexCoords(accessor);
+                const size_t quantizedByteCount = sizeof(uint16_t) * 2 * accessor->count;
+                BufferObject* bo = BufferObject::Builder().size(quantizedByteCount).build(engine);
+                asset->mBufferObjects.push_back(bo);
+                bo->setBuffer(engine, BufferDescriptor(quantized, quantizedByteCount,
+                        FREE_CALLBACK));
+                slot.vertexBuffer->setBufferObjectAt(engine, slot.bufferIndex, bo);
+                continue;
+            }
             if (utility::requiresConversion(accessor)) {
                 const size_t floatsCount = accessor->count * cgltf_num_components(accessor->type);
                 const size_t floatsByteCount = sizeof(float) * floatsCount;
@@ -267,6 +593,14 @@ inline void uploadBuffers(FFilamentAsset* asset, Engine& engine,
             slot.vertexBuffer->setBufferObjectAt(engine, slot.bufferIndex, bo);
             continue;
         } else if (slot.indexBuffer) {
+            size_t optimizedSize = 0;
+            void* optimized = optimize && slot.primitive ?
+                    optimizeIndices(slot.primitive, data, &optimizedSize) : nullptr;
+            if (optimized) {
+                IndexBuffer::BufferDescriptor bd(optimized, optimizedSize, FREE_CALLBACK);
+                slot.indexBuffer->setBuffer(engine, std::move(bd));
+                continue;
+            }
             if (accessor->component_type == cgltf_component_type_r_8u) {
                 const size_t size16 = size * 2;
                 uint16_t* data16 = (uint16_t*) malloc(size16);
@@ -313,6 +647,32 @@ inline void uploadBuffers(FFilamentAsset* asset, Engine& engine,
     }
 }
 
+// Adds the jobs that compute the tangents of the morph targets of the given primitive.
+inline void addMorphTangentsJobs(const cgltf_primitive& prim, cgltf_size pindex,
+        MorphTargetBuffer* tb, std::vector<TangentsJobParams>& jobParams) {
+    using Params = TangentsJobParams;
+    for (cgltf_size tindex = 0, tcount = prim.targets_count; tindex < tcount; ++tindex) {
+        const cgltf_morph_target& target = prim.targets[tindex];
+        bool hasNormals = false;
+        for (cgltf_size aindex = 0; aindex < target.attributes_count; aindex++) {
+            const cgltf_attribute& attribute = target.attributes[aindex];
+            const cgltf_attribute_type atype = attribute.type;
+            if (atype != cgltf_attribute_type_tangent) {
+                continue;
+            }
+            hasNormals = true;
+            jobParams.emplace_back(Params { { &prim, (int) tindex },
+                                            { nullptr, tb, (uint8_t) pindex } });
+            break;
+        }
+        // Generate flat normals if necessary.
+        if (!hasNormals && prim.material && !prim.material->unlit) {
+            jobParams.emplace_back(Params { { &prim, (int) tindex },
+                                            { nullptr, tb, (uint8_t) pindex } });
+        }
+    }
+}
+
 } // anonymous namespace
 
 ResourceLoader::ResourceLoader(const ResourceConfiguration& config) : pImpl(new Impl(config)) { }
@@ -323,6 +683,12 @@ ResourceLoader::~ResourceLoader() {
 
 void ResourceLoader::setConfiguration(const ResourceConfiguration& config) {
     pImpl->mNormalizeSkinningWeights = config.normalizeSkinningWeights;
+    pImpl->mCompressAnimations = config.compressAnimations;
+    pImpl->mStreamedAnimationDuration = config.streamedAnimationDuration;
+    pImpl->mAnimationChunkDuration = config.animationChunkDuration;
+    pImpl->mProgressiveGeometry = config.progressiveGeometry;
+    pImpl->mOptimizeIndices = config.optimizeIndices;
+    pImpl->mCacheBoundingBoxes = config.cacheBoundingBoxes;
     pImpl->mGltfPath = config.gltfPath;
 }
 
@@ -408,6 +774,10 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
     }
     asset->mResourcesLoaded = true;
 
+    // Geometry that is still being streamed for a previous asset is uploaded right away.
+    pImpl->updateGeometryStreaming(true);
+    pImpl->mGeometryBatchCount = 0;
+
     bool const isExtendedAlgo = asset->isUsingExtendedAlgorithm();
 
     // At this point, any entities that are created in the future (i.e. dynamically added instances)
@@ -421,38 +791,77 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
     pImpl->mFilepathTextureCache.clear();
 
     cgltf_data const* gltf = asset->mSourceAsset->hierarchy;
+    bool dracoDecoded = !isExtendedAlgo;
 
     if (!isExtendedAlgo) {
         utility::loadCgltfBuffers(gltf, pImpl->mGltfPath.c_str(), pImpl->mUriDataCache);
 
+        // In the progressive mode, Draco meshes are decoded along with the rest of their
+        // primitive, unless the skinning weights need to be normalized first.
+        bool const progressive = async && pImpl->mProgressiveGeometry;
+        bool const decodeDracoEarly = !progressive || pImpl->mNormalizeSkinningWeights;
+        dracoDecoded = decodeDracoEarly;
+
         // Decompress Draco meshes early on, which allows us to exploit subsequent processing such
-        // as tangent generation.
+        // as tangent generation. The meshes are decoded in parallel, then copied to the accessors
+        // of their primitives on this thread, since primitives can share accessors.
+        JobSystem& js = pImpl->mEngine->getJobSystem();
         DracoCache* dracoCache = &asset->mSourceAsset->dracoCache;
         auto& primitives = std::get<FFilamentAsset::ResourceInfo>(asset->mResourceInfo).mPrimitives;
+        if (decodeDracoEarly) {
+            std::vector<const cgltf_buffer_view*> dracoMeshes;
+            for (auto& [prim, vertexBuffer]: primitives) {
+                if (prim->has_draco_mesh_compression) {
+                    dracoMeshes.push_back(prim->draco_mesh_compression.buffer_view);
+                }
+            }
+            if (!dracoMeshes.empty()) {
+                dracoCache->decodeMeshes(js, dracoMeshes.data(), dracoMeshes.size());
+            }
+        }
         // Go through every primitive and check if it has a Draco mesh.
         for (auto& [prim, vertexBuffer]: primitives) {
-            if (!prim->has_draco_mesh_compression) {
+            if (!decodeDracoEarly || !prim->has_draco_mesh_compression) {
                 continue;
             }
             utility::decodeDracoMeshes(gltf, prim, dracoCache);
         }
-        utility::decodeMeshoptCompression((cgltf_data*) gltf);
+        utility::decodeMeshoptCompression((cgltf_data*) gltf, &js);
+
+        if (progressive) {
+            pImpl->beginGeometryStreaming(asset, !decodeDracoEarly);
+        } else {
+            auto& slots = std::get<FFilamentAsset::ResourceInfo>(asset->mResourceInfo).mBufferSlots;
+            uploadBuffers(asset, *pImpl->mEngine, pImpl->mUriDataCache, slots,
+                    pImpl->mOptimizeIndices);
 
-        uploadBuffers(asset, *pImpl->mEngine, pImpl->mUriDataCache);
+            // Compute surface orientation quaternions if necessary. This is similar to sparse data
+            // in that we need to generate the contents of a GPU buffer by processing one or more
+            // CPU buffer(s).
+            pImpl->computeTangents(asset);
 
-        // Compute surface orientation quaternions if necessary. This is similar to sparse data in
-        // that we need to generate the contents of a GPU buffer by processing one or more CPU
-        // buffer(s).
-        pImpl->computeTangents(asset);
+            for (VertexBuffer* vb : asset->mVertexBuffers) {
+                asset->mDependencyGraph.markAsReady(vb);
+            }
+        }
 
         std::get<FFilamentAsset::ResourceInfo>(asset->mResourceInfo).mBufferSlots.clear();
         std::get<FFilamentAsset::ResourceInfo>(asset->mResourceInfo).mPrimitives.clear();
     } else {
         auto& slots = std::get<FFilamentAsset::ResourceInfoExtended>(asset->mResourceInfo).slots;
         ResourceLoaderExtended::loadResources(slots, pImpl->mEngine, asset->mBufferObjects);
+        for (VertexBuffer* vb : asset->mVertexBuffers) {
+            asset->mDependencyGraph.markAsReady(vb);
+        }
     }
 
     createSkins(gltf, pImpl->mNormalizeSkinningWeights, asset->mSkins);
+    computeJointBounds(gltf, dracoDecoded, asset->mJointBounds);
+    if (pImpl->mCacheBoundingBoxes) {
+        computeNodeBounds(gltf, dracoDecoded, pImpl->mEngine->getJobSystem(), asset->mNodeBounds);
+        asset->mNodeBoundsCached = true;
+    }
+    decodeGpuInstances(gltf, asset);
 
     // If any decoding jobs are still underway from a previous load, wait for them to finish.
     for (const auto& iter: pImpl->mTextureProviders) {
@@ -467,6 +876,14 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
     // materials or textures will be added. Notify the dependency graph.
     asset->mDependencyGraph.commitEdges();
 
+    // Decode the animation data once so that it can be shared by all animators.
+    const AnimationStreamConfig streaming = {
+            .jobSystem = &pImpl->mEngine->getJobSystem(),
+            .minDuration = pImpl->mStreamedAnimationDuration,
+            .chunkDuration = pImpl->mAnimationChunkDuration,
+    };
+    asset->mAnimationClips = createAnimationClips(gltf, pImpl->mCompressAnimations,
+            pImpl->mStreamedAnimationDuration > 0.0f ? &streaming : nullptr);
     for (FFilamentInstance* instance : asset->mInstances) {
         instance->createAnimator();
     }
@@ -480,6 +897,7 @@ bool ResourceLoader::asyncBeginLoad(FilamentAsset* asset) {
 }
 
 void ResourceLoader::asyncCancelLoad() {
+    pImpl->cancelGeometryStreaming();
     pImpl->cancelTextureDecoding();
     pImpl->mAsyncAsset = nullptr;
     pImpl->mEngine->flushAndWait();
@@ -490,11 +908,13 @@ void ResourceLoader::addTextureProvider(const char* mimeType, TextureProvider* p
 }
 
 float ResourceLoader::asyncGetLoadProgress() const {
-    if (pImpl->mTextureProviders.empty() || !pImpl->mAsyncAsset) {
+    size_t const geometryCount = pImpl->mGeometryBatchCount;
+    if ((pImpl->mTextureProviders.empty() && geometryCount == 0) || !pImpl->mAsyncAsset) {
         return 0;
     }
-    size_t pushedCount = 0;
-    size_t poppedCount = 0;
+    // Each primitive whose geometry is streamed counts as much as a texture.
+    size_t pushedCount = geometryCount;
+    size_t poppedCount = geometryCount - pImpl->mGeometryBatches.size();
     for (const auto& iter : pImpl->mTextureProviders) {
         pushedCount += iter.second->getPushedCount();
         poppedCount += iter.second->getPoppedCount();
@@ -511,6 +931,7 @@ void ResourceLoader::asyncUpdateLoad() {
     if (!pImpl->mAsyncAsset) {
         return;
     }
+    pImpl->updateGeometryStreaming(false);
     for (const auto& iter : pImpl->mTextureProviders) {
         iter.second->updateQueue();
         while (Texture* texture = iter.second->popTexture()) {
@@ -686,7 +1107,7 @@ void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
     }
 
     // Create a job description for each triangle-based primitive.
-    using Params = TangentsJob::Params;
+    using Params = TangentsJobParams;
     std::vector<Params> jobParams;
     for (auto const& [prim, vb] : primitives) {
         if (UTILS_UNLIKELY(prim->type != cgltf_primitive_type_triangles)) {
@@ -706,37 +1127,25 @@ void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
             continue;
         }
         for (cgltf_size pindex = 0, pcount = mesh.primitives_count; pindex < pcount; ++pindex) {
-            const cgltf_primitive& prim = mesh.primitives[pindex];
-            MorphTargetBuffer* tb = prims[pindex].targets;
-            for (cgltf_size tindex = 0, tcount = prim.targets_count; tindex < tcount; ++tindex) {
-                const cgltf_morph_target& target = prim.targets[tindex];
-                bool hasNormals = false;
-                for (cgltf_size aindex = 0; aindex < target.attributes_count; aindex++) {
-                    const cgltf_attribute& attribute = target.attributes[aindex];
-                    const cgltf_attribute_type atype = attribute.type;
-                    if (atype != cgltf_attribute_type_tangent) {
-                        continue;
-                    }
-                    hasNormals = true;
-                    jobParams.emplace_back(Params { { &prim, (int) tindex },
-                                                    { nullptr, tb, (uint8_t) pindex } });
-                    break;
-                }
-                // Generate flat normals if necessary.
-                if (!hasNormals && prim.material && !prim.material->unlit) {
-                    jobParams.emplace_back(Params { { &prim, (int) tindex },
-                                                    { nullptr, tb, (uint8_t) pindex } });
-                }
-            }
+            addMorphTangentsJobs(mesh.primitives[pindex], pindex, prims[pindex].targets, jobParams);
         }
     }
 
+    runTangentsJobs(asset, jobParams);
+}
+
+void ResourceLoader::Impl::runTangentsJobs(FFilamentAsset* asset,
+        std::vector<TangentsJobParams>& jobParams) {
+    using Params = TangentsJobParams;
+
     // Kick off jobs for computing tangent frames.
     JobSystem* js = &mEngine->getJobSystem();
     JobSystem::Job* parent = js->createJob();
     for (Params& params : jobParams) {
         Params* pptr = &params;
-        js->run(jobs::createJob(*js, parent, [pptr] { TangentsJob::run(pptr); }));
+        js->run(jobs::createJob(*js, parent, [pptr, js, parent] {
+            TangentsJob::run(pptr, js, parent);
+        }));
     }
     js->runAndWait(parent);
 
@@ -758,6 +1167,130 @@ void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
     }
 }
 
+void ResourceLoader::Impl::beginGeometryStreaming(FFilamentAsset* asset, bool decodeDraco) {
+    SYSTRACE_CALL();
+
+    mGeometryAsset = asset;
+    mGeometrySource = asset->mSourceAsset;
+    mGeometryBatches.clear();
+
+    // Create one batch per primitive, and find which batch each buffer belongs to.
+    cgltf_data const* gltf = asset->mSourceAsset->hierarchy;
+    tsl::robin_map<void const*, size_t> batchIndices;
+    for (cgltf_size i = 0, n = gltf->meshes_count; i < n; ++i) {
+        const cgltf_mesh& mesh = gltf->meshes[i];
+        const FixedCapacityVector<Primitive>& prims = asset->mMeshCache[i];
+        for (cgltf_size pindex = 0, pcount = prims.size(); pindex < pcount; ++pindex) {
+            Primitive const& primitive = prims[pindex];
+            if (!primitive.vertices || batchIndices.count(primitive.vertices)) {
+                continue;
+            }
+            size_t const index = mGeometryBatches.size();
+            batchIndices[primitive.vertices] = index;
+            if (primitive.indices) {
+                batchIndices[primitive.indices] = index;
+            }
+            if (primitive.targets) {
+                batchIndices[primitive.targets] = index;
+            }
+            // Without a camera, the object-space size is our best guess of the screen size.
+            Aabb const& aabb = primitive.aabb;
+            float const size = any(greaterThan(aabb.min, aabb.max)) ? 0.0f :
+                    length(aabb.max - aabb.min);
+            mGeometryBatches.push_back({ &mesh, &mesh.primitives[pindex], pindex, primitive,
+                    size, {} });
+        }
+    }
+
+    auto& slots = std::get<FFilamentAsset::ResourceInfo>(asset->mResourceInfo).mBufferSlots;
+    std::vector<BufferSlot> orphans;
+    for (BufferSlot const& slot : slots) {
+        void const* buffer = slot.vertexBuffer ? (void const*) slot.vertexBuffer :
+                slot.indexBuffer ? (void const*) slot.indexBuffer :
+                (void const*) slot.morphTargetBuffer;
+        if (auto iter = batchIndices.find(buffer); iter != batchIndices.end()) {
+            mGeometryBatches[iter->second].slots.push_back(slot);
+        } else {
+            orphans.push_back(slot);
+        }
+    }
+    if (!orphans.empty()) {
+        uploadBuffers(asset, *mEngine, mUriDataCache, orphans, mOptimizeIndices);
+    }
+
+    // The largest primitives are uploaded first, in the order of the file for equal sizes, so
+    // they go to the back.
+    std::stable_sort(mGeometryBatches.begin(), mGeometryBatches.end(),
+            [](GeometryBatch const& lhs, GeometryBatch const& rhs) {
+                return lhs.size > rhs.size;
+            });
+    std::reverse(mGeometryBatches.begin(), mGeometryBatches.end());
+    mGeometryBatchCount = mGeometryBatches.size();
+    mGeometryDecodeDraco = decodeDraco;
+}
+
+void ResourceLoader::Impl::uploadGeometry(GeometryBatch& batch) {
+    FFilamentAsset* const asset = mGeometryAsset;
+    cgltf_data const* gltf = mGeometrySource->hierarchy;
+    const cgltf_primitive* prim = batch.prim;
+
+    if (mGeometryDecodeDraco && prim->has_draco_mesh_compression) {
+        utility::decodeDracoMeshes(gltf, prim, &mGeometrySource->dracoCache);
+    }
+
+    uploadBuffers(asset, *mEngine, mUriDataCache, batch.slots, mOptimizeIndices);
+
+    // Same as computeTangents(), for this primitive only.
+    std::vector<TangentsJobParams> jobParams;
+    if (prim->type == cgltf_primitive_type_triangles) {
+        for (BufferSlot const& slot : batch.slots) {
+            if (slot.vertexBuffer && (slot.accessor == &asset->mGenerateTangents ||
+                    slot.accessor == &asset->mGenerateNormals)) {
+                jobParams.push_back({{ prim }, { slot.vertexBuffer, nullptr,
+                        (uint8_t) slot.bufferIndex }});
+                break;
+            }
+        }
+    }
+    if (batch.mesh->weights_count && batch.primitive.targets) {
+        addMorphTangentsJobs(*prim, batch.primIndex, batch.primitive.targets, jobParams);
+    }
+    if (!jobParams.empty()) {
+        runTangentsJobs(asset, jobParams);
+    }
+
+    asset->mDependencyGraph.markAsReady(batch.primitive.vertices);
+}
+
+void ResourceLoader::Impl::updateGeometryStreaming(bool uploadAll) {
+    if (mGeometryBatches.empty()) {
+        return;
+    }
+    SYSTRACE_CALL();
+
+    // Upload at least one primitive per call, so that we always make progress.
+    using clock = std::chrono::steady_clock;
+    clock::time_point const start = clock::now();
+    do {
+        uploadGeometry(mGeometryBatches.back());
+        mGeometryBatches.pop_back();
+    } while (!mGeometryBatches.empty() &&
+            (uploadAll || clock::now() - start < PROGRESSIVE_GEOMETRY_BUDGET));
+
+    if (mGeometryBatches.empty()) {
+        mGeometryAsset = nullptr;
+        mGeometrySource.reset();
+    }
+}
+
+void ResourceLoader::Impl::cancelGeometryStreaming() {
+    // The renderables whose geometry wasn't uploaded never become ready.
+    mGeometryBatches.clear();
+    mGeometryBatchCount = 0;
+    mGeometryAsset = nullptr;
+    mGeometrySource.reset();
+}
+
 ResourceLoader::Impl::~Impl() {
     for (const auto& iter : mTextureProviders) {
         iter.second->cancelDecoding();
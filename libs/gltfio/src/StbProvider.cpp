@@ -16,6 +16,9 @@
 
 #include <gltfio/TextureProvider.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <string>
 #include <vector>
 
@@ -27,6 +30,12 @@
 
 #include <stb_image.h>
 
+#define STB_DXT_STATIC
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+#include "DecoderQueue.h"
+
 using namespace filament;
 using namespace utils;
 
@@ -38,7 +47,7 @@ namespace filament::gltfio {
 
 class StbProvider final : public TextureProvider {
 public:
-    StbProvider(Engine* engine);
+    StbProvider(Engine* engine, bool compressTextures);
     ~StbProvider();
 
     Texture* pushTexture(const uint8_t* data, size_t byteCount,
@@ -48,6 +57,7 @@ public:
     void updateQueue() final;
     void waitForCompletion() final;
     void cancelDecoding() final;
+    void setDecodingPriority(Texture* texture, int priority) final;
     const char* getPushMessage() const final;
     const char* getPopMessage() const final;
     size_t getPushedCount() const final { return mPushedCount; }
@@ -66,7 +76,14 @@ private:
         TextureState state;
         atomic<intptr_t> decodedTexelsBaseMipmap;
         vector<uint8_t> sourceBuffer;
-        JobSystem::Job*  decoderJob;
+        DecoderQueue::Ticket ticket;
+
+        // When compressed, the decoder also generates the mipmaps and encodes all the levels
+        // into blocks, and decodedTexelsBaseMipmap points to the blocks.
+        bool compressed = false;
+        bool alpha = false;
+        bool srgb = false;
+        vector<uint8_t> blocks;
     };
 
     // Declare some sentinel values for the "decodedTexelsBaseMipmap" field.
@@ -74,18 +91,105 @@ private:
     static const intptr_t DECODING_NOT_READY = 0x0;
     static const intptr_t DECODING_ERROR = 0x1;
 
-    void decodeSingleTexture();
+    static void decode(TextureInfo* info);
+    static void compress(TextureInfo* info, uint8_t const* texels);
 
     size_t mPushedCount = 0;
     size_t mPoppedCount = 0;
     size_t mDecodedCount = 0;
     vector<unique_ptr<TextureInfo> > mTextures;
-    JobSystem::Job* mDecoderRootJob;
     std::string mRecentPushMessage;
     std::string mRecentPopMessage;
     Engine* const mEngine;
+    DecoderQueue mDecoderQueue;
+    const bool mCompressTextures;
 };
 
+namespace {
+
+size_t getBlockSize(bool alpha) noexcept {
+    // BC3 (DXT5) stores an alpha block in addition to the BC1 (DXT1) color block
+    return alpha ? 16 : 8;
+}
+
+size_t getCompressedSize(uint32_t width, uint32_t height, bool alpha) noexcept {
+    return size_t((width + 3) / 4) * size_t((height + 3) / 4) * getBlockSize(alpha);
+}
+
+float srgbToLinear(uint8_t c) noexcept {
+    static const auto lut = [] {
+        std::array<float, 256> table{};
+        for (size_t i = 0; i < table.size(); i++) {
+            const float v = float(i) / 255.0f;
+            table[i] = v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+        }
+        return table;
+    }();
+    return lut[c];
+}
+
+uint8_t linearToSrgb(float v) noexcept {
+    v = v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+    return uint8_t(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+// Halves an RGBA8 image with a box filter. Color channels of sRGB images are averaged in
+// linear space.
+void downsample(uint8_t const* src, uint32_t width, uint32_t height, uint8_t* dst,
+        bool srgb) noexcept {
+    const uint32_t w = std::max(1u, width / 2);
+    const uint32_t h = std::max(1u, height / 2);
+    for (uint32_t y = 0; y < h; y++) {
+        const uint32_t y0 = std::min(y * 2, height - 1);
+        const uint32_t y1 = std::min(y * 2 + 1, height - 1);
+        for (uint32_t x = 0; x < w; x++, dst += 4) {
+            const uint32_t x0 = std::min(x * 2, width - 1);
+            const uint32_t x1 = std::min(x * 2 + 1, width - 1);
+            uint8_t const* const texels[4] = {
+                    src + (y0 * width + x0) * 4, src + (y0 * width + x1) * 4,
+                    src + (y1 * width + x0) * 4, src + (y1 * width + x1) * 4 };
+            for (size_t c = 0; c < 4; c++) {
+                if (srgb && c < 3) {
+                    float sum = 0;
+                    for (uint8_t const* texel : texels) {
+                        sum += srgbToLinear(texel[c]);
+                    }
+                    dst[c] = linearToSrgb(sum * 0.25f);
+                } else {
+                    uint32_t sum = 2;
+                    for (uint8_t const* texel : texels) {
+                        sum += texel[c];
+                    }
+                    dst[c] = uint8_t(sum / 4);
+                }
+            }
+        }
+    }
+}
+
+// Encodes an RGBA8 image into BC1 or BC3 blocks. Blocks that go past the edges of the image
+// (in the smallest levels) repeat its last row and column.
+uint8_t* encode(uint8_t const* src, uint32_t width, uint32_t height, bool alpha,
+        uint8_t* dst) noexcept {
+    uint8_t block[16 * 4];
+    for (uint32_t by = 0; by < height; by += 4) {
+        for (uint32_t bx = 0; bx < width; bx += 4) {
+            for (uint32_t y = 0; y < 4; y++) {
+                const uint32_t sy = std::min(by + y, height - 1);
+                for (uint32_t x = 0; x < 4; x++) {
+                    const uint32_t sx = std::min(bx + x, width - 1);
+                    std::copy_n(src + (sy * width + sx) * 4, 4, block + (y * 4 + x) * 4);
+                }
+            }
+            stb_compress_dxt_block(dst, block, alpha ? 1 : 0, STB_DXT_NORMAL);
+            dst += getBlockSize(alpha);
+        }
+    }
+    return dst;
+}
+
+} // anonymous namespace
+
 Texture* StbProvider::pushTexture(const uint8_t* data, size_t byteCount,
             const char* mimeType, TextureFlags flags) {
     int width, height, numComponents;
@@ -96,11 +200,28 @@ Texture* StbProvider::pushTexture(const uint8_t* data, size_t byteCount,
 
     using InternalFormat = Texture::InternalFormat;
 
+    const bool srgb = any(flags & TextureFlags::sRGB);
+    const bool alpha = numComponents == 2 || numComponents == 4;
+
+    // Block compression requires the dimensions of the base level to be multiples of the
+    // block size.
+    InternalFormat format = srgb ? InternalFormat::SRGB8_A8 : InternalFormat::RGBA8;
+    bool compressed = false;
+    if (mCompressTextures && width % 4 == 0 && height % 4 == 0) {
+        const InternalFormat compressedFormat = alpha ?
+                (srgb ? InternalFormat::DXT5_SRGBA : InternalFormat::DXT5_RGBA) :
+                (srgb ? InternalFormat::DXT1_SRGB : InternalFormat::DXT1_RGB);
+        if (Texture::isTextureFormatSupported(*mEngine, compressedFormat)) {
+            format = compressedFormat;
+            compressed = true;
+        }
+    }
+
     Texture* texture = Texture::Builder()
             .width(width)
             .height(height)
             .levels(0xff)
-            .format(any(flags & TextureFlags::sRGB) ? InternalFormat::SRGB8_A8 : InternalFormat::RGBA8)
+            .format(format)
             .build(*mEngine);
 
     if (texture == nullptr) {
@@ -114,33 +235,12 @@ Texture* StbProvider::pushTexture(const uint8_t* data, size_t byteCount,
 
     info->texture = texture;
     info->state = TextureState::DECODING;
+    info->compressed = compressed;
+    info->alpha = alpha;
+    info->srgb = srgb;
     info->sourceBuffer.assign(data, data + byteCount);
     info->decodedTexelsBaseMipmap.store(DECODING_NOT_READY);
-
-    // On single threaded systems, it is usually fine to create jobs because the job system will
-    // simply execute serially. However in our case, we wish to amortize the decoder cost across
-    // several frames, so we instead use the updateQueue() method to perform decoding.
-    if constexpr (!UTILS_HAS_THREADING) {
-        info->decoderJob = nullptr;
-        return texture;
-    }
-
-    JobSystem* js = &mEngine->getJobSystem();
-    info->decoderJob = jobs::createJob(*js, mDecoderRootJob, [info] {
-        auto& source = info->sourceBuffer;
-        int width, height, comp;
-
-        // Test asynchronous loading by uncommenting this line.
-        // std::this_thread::sleep_for(std::chrono::milliseconds(rand() % 10000));
-
-        stbi_uc* texels = stbi_load_from_memory(source.data(), source.size(),
-                &width, &height, &comp, 4);
-        source.clear();
-        source.shrink_to_fit();
-        info->decodedTexelsBaseMipmap.store(texels ? intptr_t(texels) : DECODING_ERROR);
-    });
-
-    js->runAndRetain(info->decoderJob);
+    info->ticket = mDecoderQueue.push([info] { decode(info); });
     return texture;
 }
 
@@ -165,24 +265,44 @@ Texture* StbProvider::popTexture() {
 }
 
 void StbProvider::updateQueue() {
-    if (!UTILS_HAS_THREADING) {
-        decodeSingleTexture();
-    }
-    JobSystem* js = &mEngine->getJobSystem();
+    mDecoderQueue.update();
     for (auto& info : mTextures) {
         if (info->state != TextureState::DECODING) {
             continue;
         }
         Texture* texture = info->texture;
         if (intptr_t data = info->decodedTexelsBaseMipmap.load()) {
-            if (info->decoderJob) {
-                js->waitAndRelease(info->decoderJob);
-            }
             if (data == DECODING_ERROR) {
                 info->state = TextureState::READY;
                 ++mDecodedCount;
                 continue;
             }
+            if (info->compressed) {
+                // All the levels reference the same allocation, which is released after the
+                // last one is uploaded.
+                using CompressedType = Texture::CompressedType;
+                const CompressedType type = info->alpha ?
+                        (info->srgb ? CompressedType::DXT5_SRGBA : CompressedType::DXT5_RGBA) :
+                        (info->srgb ? CompressedType::DXT1_SRGB : CompressedType::DXT1_RGB);
+                auto* const blocks = new vector<uint8_t>(std::move(info->blocks));
+                Texture::PixelBufferDescriptor::Callback const release =
+                        [](void*, size_t, void* user) {
+                            delete static_cast<vector<uint8_t>*>(user);
+                        };
+                uint8_t const* level = blocks->data();
+                const size_t levels = texture->getLevels();
+                for (size_t l = 0; l < levels; l++) {
+                    const auto size = uint32_t(getCompressedSize(
+                            texture->getWidth(l), texture->getHeight(l), info->alpha));
+                    const bool last = l == levels - 1;
+                    texture->setImage(*mEngine, l, { level, size, type, size,
+                            last ? release : nullptr, last ? blocks : nullptr });
+                    level += size;
+                }
+                info->state = TextureState::READY;
+                ++mDecodedCount;
+                continue;
+            }
             Texture::PixelBufferDescriptor pbd((uint8_t*) data,
                     texture->getWidth() * texture->getHeight() * 4, Texture::Format::RGBA,
                     Texture::Type::UBYTE, [](void* mem, size_t, void*) { stbi_image_free(mem); });
@@ -206,19 +326,12 @@ void StbProvider::updateQueue() {
 }
 
 void StbProvider::waitForCompletion() {
-    JobSystem& js = mEngine->getJobSystem();
-    for (auto& info : mTextures) {
-        if (info->decoderJob) {
-            js.waitAndRelease(info->decoderJob);
-        }
-    }
+    mDecoderQueue.waitForCompletion();
 }
 
 void StbProvider::cancelDecoding() {
-    // TODO: Currently, StbProvider runs jobs eagerly and JobSystem does not allow cancellation of
-    // in-flight jobs. We should consider throttling the number of simultaneous decoder jobs, which
-    // would allow for actual cancellation.
-    waitForCompletion();
+    // Queued images are dropped without being decoded, only the running jobs are waited for.
+    mDecoderQueue.cancel();
 
     // For cancelled jobs, we need to set the TextureInfo to the popped state and free the decoded
     // data.
@@ -226,17 +339,29 @@ void StbProvider::cancelDecoding() {
         if (info->state != TextureState::DECODING) {
             continue;
         }
-        // Deleting data here should be safe thread-wise as the only other place where
-        // decodedTexelsBaseMipmap is loaded is in the job threads, and we have waited them to
+        // Freeing data here should be safe thread-wise as the only other place where
+        // decodedTexelsBaseMipmap is stored is in the job threads, and we have waited them to
         // completion above. We also expect the TextureProvider API calls to be made only from one
         // thread.
-        if (intptr_t data = info->decodedTexelsBaseMipmap.load()) {
-            delete [] (uint8_t*) data;
+        if (intptr_t data = info->decodedTexelsBaseMipmap.load();
+                data && data != DECODING_ERROR && !info->compressed) {
+            stbi_image_free((void*) data);
         }
+        info->sourceBuffer = {};
+        info->blocks = {};
         info->state = TextureState::POPPED;
     }
 }
 
+void StbProvider::setDecodingPriority(Texture* texture, int priority) {
+    for (auto& info : mTextures) {
+        if (info->texture == texture) {
+            mDecoderQueue.setPriority(info->ticket, priority);
+            return;
+        }
+    }
+}
+
 const char* StbProvider::getPushMessage() const {
     return mRecentPushMessage.empty() ? nullptr : mRecentPushMessage.c_str();
 }
@@ -245,24 +370,58 @@ const char* StbProvider::getPopMessage() const {
     return mRecentPopMessage.empty() ? nullptr : mRecentPopMessage.c_str();
 }
 
-void StbProvider::decodeSingleTexture() {
-    assert_invariant(!UTILS_HAS_THREADING);
-    for (auto& info : mTextures) {
-        if (info->state == TextureState::DECODING) {
-            auto& source = info->sourceBuffer;
-            int width, height, comp;
-            stbi_uc* texels = stbi_load_from_memory(source.data(), source.size(),
-                    &width, &height, &comp, 4);
-            source.clear();
-            source.shrink_to_fit();
-            info->decodedTexelsBaseMipmap.store(texels ? intptr_t(texels) : DECODING_ERROR);
-            break;
+void StbProvider::decode(TextureInfo* info) {
+    auto& source = info->sourceBuffer;
+    int width, height, comp;
+
+    // Test asynchronous loading by uncommenting this line.
+    // std::this_thread::sleep_for(std::chrono::milliseconds(rand() % 10000));
+
+    stbi_uc* texels = stbi_load_from_memory(source.data(), source.size(),
+            &width, &height, &comp, 4);
+    source.clear();
+    source.shrink_to_fit();
+    if (texels && info->compressed) {
+        compress(info, texels);
+        stbi_image_free(texels);
+        info->decodedTexelsBaseMipmap.store(intptr_t(info->blocks.data()));
+        return;
+    }
+    info->decodedTexelsBaseMipmap.store(texels ? intptr_t(texels) : DECODING_ERROR);
+}
+
+void StbProvider::compress(TextureInfo* info, uint8_t const* texels) {
+    Texture const* const texture = info->texture;
+    const size_t levels = texture->getLevels();
+
+    size_t size = 0;
+    for (size_t l = 0; l < levels; l++) {
+        size += getCompressedSize(texture->getWidth(l), texture->getHeight(l), info->alpha);
+    }
+    info->blocks.resize(size);
+
+    // the mipmaps are generated here, because compressed textures can't generate them
+    JobSystem::ScratchArena& scratch = JobSystem::getScratchArena();
+    JobSystem::ScratchVector<uint8_t> current(scratch);
+    JobSystem::ScratchVector<uint8_t> next(scratch);
+    uint8_t const* src = texels;
+    uint8_t* dst = info->blocks.data();
+    for (size_t l = 0; l < levels; l++) {
+        const uint32_t width = texture->getWidth(l);
+        const uint32_t height = texture->getHeight(l);
+        dst = encode(src, width, height, info->alpha, dst);
+        if (l + 1 < levels) {
+            next.resize(size_t(texture->getWidth(l + 1)) * texture->getHeight(l + 1) * 4);
+            downsample(src, width, height, next.data(), info->srgb);
+            std::swap(current, next);
+            src = current.data();
         }
     }
 }
 
-StbProvider::StbProvider(Engine* engine) : mEngine(engine) {
-    mDecoderRootJob = mEngine->getJobSystem().createJob();
+StbProvider::StbProvider(Engine* engine, bool compressTextures)
+        : mEngine(engine), mDecoderQueue(engine->getJobSystem()),
+          mCompressTextures(compressTextures) {
 #ifndef NDEBUG
     slog.i << "Texture Decoder has "
             << mEngine->getJobSystem().getThreadCount()
@@ -272,11 +431,10 @@ StbProvider::StbProvider(Engine* engine) : mEngine(engine) {
 
 StbProvider::~StbProvider() {
     cancelDecoding();
-    mEngine->getJobSystem().release(mDecoderRootJob);
 }
 
-TextureProvider* createStbProvider(Engine* engine) {
-    return new StbProvider(engine);
+TextureProvider* createStbProvider(Engine* engine, bool compressTextures) {
+    return new StbProvider(engine, compressTextures);
 }
 
 } // namespace filament::gltfio
@@ -20,12 +20,18 @@
 
 #include <geometry/SurfaceOrientation.h>
 
+#include <utils/JobSystem.h>
+
 using namespace filament::gltfio;
 using namespace filament;
 using namespace filament::math;
+using namespace utils;
+
+// Number of vertices per job when the tangent frames only depend on the normals.
+static constexpr size_t NORMALS_ONLY_JOB_VERTEX_COUNT = 64 * 1024;
 
 // This procedure is designed to run in an isolated job.
-void TangentsJob::run(Params* params) {
+void TangentsJob::run(Params* params, JobSystem* js, JobSystem::Job* parent) {
     const cgltf_primitive& prim = *params->in.prim;
     const int morphTargetIndex = params->in.morphTargetIndex;
     const bool isMorphTarget = morphTargetIndex != kMorphTargetUnused;
@@ -41,12 +47,15 @@ void TangentsJob::run(Params* params) {
     // Declare storage for data that has been unpacked and converted from the source buffers.
     // This data needs to be held until after the SurfaceOrientation helper consumes it.
     // Not all of these will be required, so they get allocated lazily.
+    // Except for the normals, which can be handed to other jobs, they come from this thread's
+    // scratch arena and are released when the job returns.
+    JobSystem::ScratchArena& scratch = JobSystem::getScratchArena();
     std::unique_ptr<float3[]> unpackedNormals;
-    std::unique_ptr<float4[]> unpackedTangents;
-    std::unique_ptr<float3[]> unpackedPositions;
-    std::unique_ptr<float2[]> unpackedTexCoords;
-    std::unique_ptr<uint3[]> unpackedTriangles;
-    std::unique_ptr<float3[]> morphDeltas;
+    float4* unpackedTangents = nullptr;
+    float3* unpackedPositions = nullptr;
+    float2* unpackedTexCoords = nullptr;
+    uint3* unpackedTriangles = nullptr;
+    float3* morphDeltas = nullptr;
 
     // Build a mapping from cgltf_attribute_type to cgltf_accessor.
     const int NUM_ATTRIBUTES = cgltf_attribute_type_max_enum;
@@ -79,7 +88,7 @@ void TangentsJob::run(Params* params) {
 
     // Allocate scratch space to store morph deltas.
     if (isMorphTarget) {
-        morphDeltas.reset(new float3[vertexCount]);
+        morphDeltas = scratch.alloc<float3>(vertexCount);
     }
 
     // Convert normals into packed floats.
@@ -97,10 +106,41 @@ void TangentsJob::run(Params* params) {
         sob.normals(unpackedNormals.get());
     }
 
+    // Without tangents and UVs, each frame only depends on the normal of its vertex, so neither
+    // positions nor triangles are needed and large primitives can be processed in parallel.
+    auto uvInfo = baseAccessors[cgltf_attribute_type_texcoord];
+    const bool hasUvs = uvInfo && uvInfo->count == vertexCount && uvInfo->type == cgltf_type_vec2;
+    if (unpackedNormals && !baseAccessors[cgltf_attribute_type_tangent] && !hasUvs) {
+        const float3* normals = unpackedNormals.get();
+        short4* results = (short4*) malloc(sizeof(short4) * vertexCount);
+        params->out.results = results;
+        if (!js || vertexCount <= NORMALS_ONLY_JOB_VERTEX_COUNT) {
+            geometry::SurfaceOrientation::computeQuatsFromNormals(normals, results, vertexCount);
+            return;
+        }
+        auto* job = jobs::parallel_for(*js, parent, 0, uint32_t(vertexCount),
+                [normals, results](uint32_t start, uint32_t count) {
+                    geometry::SurfaceOrientation::computeQuatsFromNormals(normals + start,
+                            results + start, count);
+                }, jobs::CountSplitter<NORMALS_ONLY_JOB_VERTEX_COUNT>());
+        // Rather than waiting here, which would block a job thread, the normals are freed by a
+        // continuation of the split jobs, and the parent completes after it.
+        JobSystem::Job* cleanup = parent ? jobs::createJob(*js, parent,
+                [normals = unpackedNormals.get()] { delete[] normals; }) : nullptr;
+        if (cleanup) {
+            unpackedNormals.release();
+            js->runAfter(cleanup, job);
+            js->run(job);
+            return;
+        }
+        js->runAndWait(job);
+        return;
+    }
+
     // Convert tangents into packed floats.
     if (auto baseTangentsInfo = baseAccessors[cgltf_attribute_type_tangent]; baseTangentsInfo) {
         assert(baseTangentsInfo->count == vertexCount);
-        unpackedTangents.reset(new float4[vertexCount]);
+        unpackedTangents = scratch.alloc<float4>(vertexCount);
         cgltf_accessor_unpack_floats(baseTangentsInfo, &unpackedTangents[0].x, vertexCount * 4);
         if (auto mtTangentsInfo = morphTargetAccessors[cgltf_attribute_type_tangent]) {
             cgltf_accessor_unpack_floats(mtTangentsInfo, &morphDeltas[0].x, vertexCount * 3);
@@ -108,14 +148,14 @@ void TangentsJob::run(Params* params) {
                 unpackedTangents[i].xyz += morphDeltas[i];
             }
         }
-        sob.tangents(unpackedTangents.get());
+        sob.tangents(unpackedTangents);
     }
 
     if (auto basePosInfo = baseAccessors[cgltf_attribute_type_position]; basePosInfo) {
         assert(basePosInfo->count == vertexCount && basePosInfo->type == cgltf_type_vec3);
-        unpackedPositions.reset(new float3[vertexCount]);
+        unpackedPositions = scratch.alloc<float3>(vertexCount);
         cgltf_accessor_unpack_floats(basePosInfo, &unpackedPositions[0].x, vertexCount * 3);
-        sob.positions(unpackedPositions.get());
+        sob.positions(unpackedPositions);
         if (auto mtPositionsInfo = morphTargetAccessors[cgltf_attribute_type_position]) {
             cgltf_accessor_unpack_floats(mtPositionsInfo, &morphDeltas[0].x, vertexCount * 3);
             for (cgltf_size i = 0; i < vertexCount; i++) {
@@ -125,7 +165,7 @@ void TangentsJob::run(Params* params) {
     }
 
     const size_t triangleCount = prim.indices ? (prim.indices->count / 3) : (vertexCount / 3);
-    unpackedTriangles.reset(new uint3[triangleCount]);
+    unpackedTriangles = scratch.alloc<uint3>(triangleCount);
 
     if (prim.indices) {
         for (size_t tri = 0, j = 0; tri < triangleCount; ++tri) {
@@ -144,13 +184,12 @@ void TangentsJob::run(Params* params) {
     }
 
     sob.triangleCount(triangleCount);
-    sob.triangles(unpackedTriangles.get());
+    sob.triangles(unpackedTriangles);
 
-    auto uvInfo = baseAccessors[cgltf_attribute_type_texcoord];
-    if (uvInfo && uvInfo->count == vertexCount && uvInfo->type == cgltf_type_vec2) {
-        unpackedTexCoords.reset(new float2[vertexCount]);
+    if (hasUvs) {
+        unpackedTexCoords = scratch.alloc<float2>(vertexCount);
         cgltf_accessor_unpack_floats(uvInfo, &unpackedTexCoords[0].x, vertexCount * 2);
-        sob.uvs(unpackedTexCoords.get());
+        sob.uvs(unpackedTexCoords);
     }
 
     // Compute surface orientation quaternions.
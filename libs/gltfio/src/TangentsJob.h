@@ -18,6 +18,8 @@
 
 #include <math/vec4.h>
 
+#include <utils/JobSystem.h>
+
 namespace filament {
 
 class VertexBuffer;
@@ -65,8 +67,11 @@ struct TangentsJob {
     };
 
     // Performs tangents generation synchronously. This can be invoked from inside a job if desired.
-    // The parameters structure is owned by the client.
-    static void run(Params* params);
+    // The parameters structure is owned by the client. If a job system is given, large primitives
+    // that only have normals are split across jobs. This waits for them, unless a parent job is
+    // given, in which case they complete with the parent instead of blocking the calling thread.
+    static void run(Params* params, utils::JobSystem* js = nullptr,
+            utils::JobSystem::Job* parent = nullptr);
 };
 
 } // namespace filament::gltfio
@@ -22,8 +22,13 @@
 
 #include <math/mat4.h>
 
+#include <utils/Hash.h>
 #include <utils/Log.h>
 
+#include <tsl/robin_map.h>
+
+#include <mutex>
+
 #include "ArchiveCache.h"
 
 using namespace filament;
@@ -92,6 +97,13 @@ public:
 
     Material* getMaterial(const MaterialKey& config) const;
 
+    // Resolving a key through the archive builds a map of feature names and scans all of its
+    // specs, so the result is remembered for each (constrained) key. Assets typically share a
+    // handful of keys, which makes this a cache across assets.
+    using HashFn = hash::MurmurHashFn<MaterialKey>;
+    tsl::robin_map<MaterialKey, Material*, HashFn> mCache;
+    std::mutex mCacheLock;
+
     mutable ArchiveCache mMaterials;
     Texture* mDummyTexture = nullptr;
 
@@ -120,6 +132,8 @@ const Material* const* UbershaderProvider::getMaterials() const noexcept {
 }
 
 void UbershaderProvider::destroyMaterials() {
+    std::lock_guard const lock(mCacheLock);
+    mCache.clear();
     mMaterials.destroyMaterials();
     mEngine->destroy(mDummyTexture);
 }
@@ -170,6 +184,12 @@ Material* UbershaderProvider::getMaterial(const MaterialKey& config) const {
 Material* UbershaderProvider::getMaterial(MaterialKey* config, UvMap* uvmap, const char* label) {
     prepareConfig(config, label);
     constrainMaterial(config, uvmap);
+
+    std::lock_guard const lock(mCacheLock);
+    if (auto iter = mCache.find(*config); iter != mCache.end()) {
+        return iter.value();
+    }
+
     Material* material = getMaterial(*config);
     if (material == nullptr) {
 #ifndef NDEBUG
@@ -177,6 +197,7 @@ Material* UbershaderProvider::getMaterial(MaterialKey* config, UvMap* uvmap, con
 #endif
         material = mMaterials.getDefaultMaterial();
     }
+    mCache.emplace(*config, material);
     return material;
 }
 
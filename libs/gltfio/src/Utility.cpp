@@ -20,6 +20,7 @@
 #include "FFilamentAsset.h"
 #include "GltfEnums.h"
 
+#include <utils/JobSystem.h>
 #include <utils/Log.h>
 #include <utils/Systrace.h>
 
@@ -27,6 +28,20 @@
 #include <cgltf.h>
 #include <meshoptimizer.h>
 
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+#if !defined(WIN32) && !defined(__EMSCRIPTEN__)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    define HAS_MMAP 1
+#else
+#    define HAS_MMAP 0
+#endif
+
 namespace filament::gltfio::utility {
 
 using namespace utils;
@@ -83,61 +98,77 @@ void decodeDracoMeshes(cgltf_data const* gltf, cgltf_primitive const* prim,
     }
 }
 
-void decodeMeshoptCompression(cgltf_data* data) {
-    for (size_t i = 0; i < data->buffer_views_count; ++i) {
-        if (!data->buffer_views[i].has_meshopt_compression) {
-            continue;
-        }
-        cgltf_meshopt_compression* compression = &data->buffer_views[i].meshopt_compression;
-        const uint8_t* source = (const uint8_t*) compression->buffer->data;
-        assert_invariant(source);
-        source += compression->offset;
-
-        // This memory is freed by cgltf.
-        void* destination = malloc(compression->count * compression->stride);
-        assert_invariant(destination);
-
-        UTILS_UNUSED_IN_RELEASE int error = 0;
-        switch (compression->mode) {
-            case cgltf_meshopt_compression_mode_invalid:
-                break;
-            case cgltf_meshopt_compression_mode_attributes:
-                error = meshopt_decodeVertexBuffer(destination, compression->count,
-                        compression->stride, source, compression->size);
-                break;
-            case cgltf_meshopt_compression_mode_triangles:
-                error = meshopt_decodeIndexBuffer(destination, compression->count,
-                        compression->stride, source, compression->size);
-                break;
-            case cgltf_meshopt_compression_mode_indices:
-                error = meshopt_decodeIndexSequence(destination, compression->count,
-                        compression->stride, source, compression->size);
-                break;
-            default:
-                assert_invariant(false);
-                break;
-        }
-        assert_invariant(!error);
+static void decodeMeshoptBufferView(cgltf_buffer_view* view) {
+    cgltf_meshopt_compression* compression = &view->meshopt_compression;
+    const uint8_t* source = (const uint8_t*) compression->buffer->data;
+    assert_invariant(source);
+    source += compression->offset;
 
-        switch (compression->filter) {
-            case cgltf_meshopt_compression_filter_none:
-                break;
-            case cgltf_meshopt_compression_filter_octahedral:
-                meshopt_decodeFilterOct(destination, compression->count, compression->stride);
-                break;
-            case cgltf_meshopt_compression_filter_quaternion:
-                meshopt_decodeFilterQuat(destination, compression->count, compression->stride);
-                break;
-            case cgltf_meshopt_compression_filter_exponential:
-                meshopt_decodeFilterExp(destination, compression->count, compression->stride);
-                break;
-            default:
-                assert_invariant(false);
-                break;
+    // This memory is freed by cgltf.
+    void* destination = malloc(compression->count * compression->stride);
+    assert_invariant(destination);
+
+    UTILS_UNUSED_IN_RELEASE int error = 0;
+    switch (compression->mode) {
+        case cgltf_meshopt_compression_mode_invalid:
+            break;
+        case cgltf_meshopt_compression_mode_attributes:
+            error = meshopt_decodeVertexBuffer(destination, compression->count,
+                    compression->stride, source, compression->size);
+            break;
+        case cgltf_meshopt_compression_mode_triangles:
+            error = meshopt_decodeIndexBuffer(destination, compression->count,
+                    compression->stride, source, compression->size);
+            break;
+        case cgltf_meshopt_compression_mode_indices:
+            error = meshopt_decodeIndexSequence(destination, compression->count,
+                    compression->stride, source, compression->size);
+            break;
+        default:
+            assert_invariant(false);
+            break;
+    }
+    assert_invariant(!error);
+
+    switch (compression->filter) {
+        case cgltf_meshopt_compression_filter_none:
+            break;
+        case cgltf_meshopt_compression_filter_octahedral:
+            meshopt_decodeFilterOct(destination, compression->count, compression->stride);
+            break;
+        case cgltf_meshopt_compression_filter_quaternion:
+            meshopt_decodeFilterQuat(destination, compression->count, compression->stride);
+            break;
+        case cgltf_meshopt_compression_filter_exponential:
+            meshopt_decodeFilterExp(destination, compression->count, compression->stride);
+            break;
+        default:
+            assert_invariant(false);
+            break;
+    }
+
+    view->data = destination;
+}
+
+void decodeMeshoptCompression(cgltf_data* data, JobSystem* js) {
+    if (!js) {
+        for (size_t i = 0; i < data->buffer_views_count; ++i) {
+            if (data->buffer_views[i].has_meshopt_compression) {
+                decodeMeshoptBufferView(&data->buffer_views[i]);
+            }
         }
+        return;
+    }
 
-        data->buffer_views[i].data = destination;
+    // Each buffer view is decoded into its own allocation, so they can all be decoded in parallel.
+    JobSystem::Job* parent = js->createJob();
+    for (size_t i = 0; i < data->buffer_views_count; ++i) {
+        cgltf_buffer_view* view = &data->buffer_views[i];
+        if (view->has_meshopt_compression) {
+            js->run(jobs::createJob(*js, parent, [view] { decodeMeshoptBufferView(view); }));
+        }
     }
+    js->runAndWait(parent);
 }
 
 bool primitiveHasVertexColor(cgltf_primitive* inPrim) {
@@ -262,4 +293,108 @@ bool loadCgltfBuffers(cgltf_data const* gltf, char const* gltfPath,
     return true;
 }
 
+// Returns the bounds of the given positions. This is a plain loop over separate min / max
+// accumulators, which compilers turn into packed min / max instructions.
+static Aabb computeBounds(float const* data, size_t count, size_t stride) {
+    math::float3 lo(std::numeric_limits<float>::max());
+    math::float3 hi(std::numeric_limits<float>::lowest());
+    for (size_t i = 0; i < count; ++i, data += stride) {
+        for (size_t c = 0; c < 3; ++c) {
+            lo[c] = std::min(lo[c], data[c]);
+            hi[c] = std::max(hi[c], data[c]);
+        }
+    }
+    return { lo, hi };
+}
+
+Aabb computePrimitiveBounds(cgltf_primitive const* prim) {
+    Aabb aabb;
+    for (cgltf_size slot = 0; slot < prim->attributes_count; slot++) {
+        const cgltf_attribute& attr = prim->attributes[slot];
+        const cgltf_accessor* accessor = attr.data;
+        const size_t dim = cgltf_num_components(accessor->type);
+        if (attr.type != cgltf_attribute_type_position || dim < 3 || accessor->count == 0) {
+            continue;
+        }
+        FixedCapacityVector<float> unpacked(accessor->count * dim);
+        cgltf_accessor_unpack_floats(accessor, unpacked.data(), unpacked.size());
+        aabb = computeBounds(unpacked.data(), accessor->count, dim);
+
+        // Each morph target moves the vertices by at most the extent of its deltas.
+        const Aabb baseAabb(aabb);
+        for (cgltf_size targetIndex = 0; targetIndex < prim->targets_count; ++targetIndex) {
+            const cgltf_morph_target& target = prim->targets[targetIndex];
+            for (cgltf_size attribIndex = 0; attribIndex < target.attributes_count; ++attribIndex) {
+                const cgltf_attribute& targetAttribute = target.attributes[attribIndex];
+                if (targetAttribute.type != cgltf_attribute_type_position) {
+                    continue;
+                }
+
+                const cgltf_accessor* targetAccessor = targetAttribute.data;
+
+                assert_invariant(targetAccessor);
+                assert_invariant(targetAccessor->count == accessor->count);
+                assert_invariant(cgltf_num_components(targetAccessor->type) == dim);
+
+                cgltf_accessor_unpack_floats(targetAccessor, unpacked.data(), unpacked.size());
+                const Aabb targetAabb = computeBounds(unpacked.data(), accessor->count, dim);
+                aabb.min = min(aabb.min, targetAabb.min + baseAabb.min);
+                aabb.max = max(aabb.max, targetAabb.max + baseAabb.max);
+                break;
+            }
+        }
+        break;
+    }
+    return aabb;
+}
+
+std::unique_ptr<MappedFile> MappedFile::open(char const* path) {
+    std::unique_ptr<MappedFile> file(new MappedFile());
+#if HAS_MMAP
+    int const fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return {};
+    }
+    struct stat st{};
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* const data = mmap(nullptr, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                fd, 0);
+        if (data != MAP_FAILED) {
+            file->mData = (uint8_t*) data;
+            file->mSize = size_t(st.st_size);
+            file->mMapped = true;
+        }
+    }
+    // The mapping stays valid after the file is closed.
+    close(fd);
+    if (file->mMapped) {
+        return file;
+    }
+#endif
+    std::ifstream in(path, std::ifstream::binary | std::ifstream::ate);
+    if (!in) {
+        return {};
+    }
+    std::streamoff const size = in.tellg();
+    if (size <= 0) {
+        return {};
+    }
+    file->mContents = FixedCapacityVector<uint8_t>(size_t(size));
+    in.seekg(0);
+    if (!in.read((char*) file->mContents.data(), size)) {
+        return {};
+    }
+    file->mData = file->mContents.data();
+    file->mSize = file->mContents.size();
+    return file;
+}
+
+MappedFile::~MappedFile() {
+#if HAS_MMAP
+    if (mMapped) {
+        munmap(mData, mSize);
+    }
+#endif
+}
+
 } // namespace filament::gltfio::utility
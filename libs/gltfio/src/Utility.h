@@ -19,8 +19,14 @@
 
 #include <backend/BufferDescriptor.h>
 
+#include <filament/Box.h>
+
+#include <utils/FixedCapacityVector.h>
+
 #include <tsl/robin_map.h>
 
+#include <memory>
+
 #include <stdint.h>
 #include <stddef.h>
 
@@ -31,6 +37,10 @@ class DracoCache;
 
 struct cgltf_accessor;
 
+namespace utils {
+class JobSystem;
+} // namespace utils
+
 namespace filament::gltfio {
 
 // Referenced in ResourceLoader and AssetLoaderExtended
@@ -44,7 +54,8 @@ namespace filament::gltfio::utility {
 
 // Functions that are shared between the original implementation and the extended implementation.
 void decodeDracoMeshes(cgltf_data const* gltf, cgltf_primitive const* prim, DracoCache* dracoCache);
-void decodeMeshoptCompression(cgltf_data* data);
+// If a job system is given, the buffer views are decoded in parallel.
+void decodeMeshoptCompression(cgltf_data* data, utils::JobSystem* js = nullptr);
 bool primitiveHasVertexColor(cgltf_primitive* inPrim);
 uint32_t computeBindingSize(cgltf_accessor const* accessor);
 void convertBytesToShorts(uint16_t* dst, uint8_t const* src, size_t count);
@@ -54,6 +65,33 @@ bool requiresPacking(cgltf_accessor const* accessor);
 bool loadCgltfBuffers(cgltf_data const* gltf, char const* gltfPath,
         UriDataCacheHandle uriDataCacheHandle);
 
+// Computes the object-space bounds of the positions of a primitive, expanded to contain its morph
+// targets at any weight between zero and one. This reads the source buffers.
+Aabb computePrimitiveBounds(cgltf_primitive const* prim);
+
+// The contents of a file, which is memory-mapped on platforms that support it, and read in memory
+// otherwise. Pages of the mapping are private and copied on write, since loading some assets
+// modifies their buffers in place.
+class MappedFile {
+public:
+    // Returns null if the file can't be opened or is empty.
+    static std::unique_ptr<MappedFile> open(char const* path);
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    uint8_t const* getData() const noexcept { return mData; }
+    size_t getSize() const noexcept { return mSize; }
+
+private:
+    MappedFile() = default;
+    uint8_t* mData = nullptr;
+    size_t mSize = 0;
+    bool mMapped = false;
+    utils::FixedCapacityVector<uint8_t> mContents;
+};
+
 } // namespace filament::gltfio::utility
 
 #endif
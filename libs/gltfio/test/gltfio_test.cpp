@@ -18,11 +18,13 @@
 
 #include <backend/PixelBufferDescriptor.h>
 
+#include <filament/Box.h>
 #include <filament/Engine.h>
 #include <filament/MaterialEnums.h>
 #include <filament/RenderableManager.h>
 #include <filament/TransformManager.h>
 
+#include <gltfio/Animator.h>
 #include <gltfio/AssetLoader.h>
 #include <gltfio/FilamentAsset.h>
 #include <gltfio/ResourceLoader.h>
@@ -31,11 +33,16 @@
 #include <math/mathfwd.h>
 #include <utils/EntityManager.h>
 #include <utils/NameComponentManager.h>
+#include <utils/Panic.h>
 #include <utils/Path.h>
 
 #include "materials/uberarchive.h"
 
+#include <algorithm>
+#include <array>
 #include <fstream>
+#include <string>
+#include <thread>
 #include <unordered_map>
 
 using namespace filament;
@@ -50,45 +57,60 @@ static std::ifstream::pos_type getFileSize(const char* filename) {
     return in.tellg();
 }
 
+static std::vector<uint8_t> readFile(Path const& filename) {
+    long contentSize = static_cast<long>(getFileSize(filename.c_str()));
+    if (contentSize <= 0) {
+        std::cerr << "Unable to open " << filename.c_str() << std::endl;
+        exit(1);
+    }
+
+    std::ifstream in(filename.c_str(), std::ifstream::binary | std::ifstream::in);
+    std::vector<uint8_t> buffer(static_cast<unsigned long>(contentSize));
+    if (!in.read((char*) buffer.data(), contentSize)) {
+        std::cerr << "Unable to read " << filename.c_str() << std::endl;
+        exit(1);
+    }
+    return buffer;
+}
+
 class glTFData {
 public:
     glTFData(Path filename, Engine* engine, MaterialProvider* materialProvider,
-            NameComponentManager* nameManager)
+            NameComponentManager* nameManager, bool progressiveGeometry = false,
+            float streamedAnimationDuration = 0.0f)
+        : glTFData(readFile(filename), filename.getAbsolutePath().c_str(), engine,
+                  materialProvider, nameManager, progressiveGeometry, streamedAnimationDuration) {
+    }
+
+    // Loads a glTF file whose buffers are all embedded, e.g. as data URIs.
+    glTFData(std::vector<uint8_t> const& content, char const* gltfPath, Engine* engine,
+            MaterialProvider* materialProvider, NameComponentManager* nameManager,
+            bool progressiveGeometry = false, float streamedAnimationDuration = 0.0f)
         : mAssetLoader(AssetLoader::create({engine, materialProvider, nameManager})),
           mResourceLoader(new ResourceLoader({
-                  engine, filename.getAbsolutePath().c_str(), false, /* normalizeSkinningWeights */
+                  .engine = engine,
+                  .gltfPath = gltfPath,
+                  .normalizeSkinningWeights = false,
+                  .streamedAnimationDuration = streamedAnimationDuration,
+                  .animationChunkDuration = 0.25f,
+                  .progressiveGeometry = progressiveGeometry,
           })),
           mStbDecoder(createStbProvider(engine)), mKtxDecoder(createKtx2Provider(engine)) {
         mResourceLoader->addTextureProvider("image/png", mStbDecoder);
         mResourceLoader->addTextureProvider("image/ktx2", mKtxDecoder);
 
-        long contentSize = static_cast<long>(getFileSize(filename.c_str()));
-        if (contentSize <= 0) {
-            std::cerr << "Unable to open " << filename.c_str() << std::endl;
-            exit(1);
-        }
-
-        // Consume the glTF file.
-        std::ifstream in(filename.c_str(), std::ifstream::binary | std::ifstream::in);
-        std::vector<uint8_t> buffer(static_cast<unsigned long>(contentSize));
-        if (!in.read((char*) buffer.data(), contentSize)) {
-            std::cerr << "Unable to read " << filename.c_str() << std::endl;
-            exit(1);
-        }
+        char const* name = gltfPath ? gltfPath : "(embedded)";
 
         // Parse the glTF file and create Filament entities.
-        mAsset = mAssetLoader->createAsset(buffer.data(), buffer.size());
-        buffer.clear();
-        buffer.shrink_to_fit();
-
+        mAsset = mAssetLoader->createAsset(content.data(), content.size());
         if (!mAsset) {
-            std::cerr << "Unable to parse " << filename.c_str() << std::endl;
+            std::cerr << "Unable to parse " << name << std::endl;
             exit(1);
         }
 
         // Load resources
         if (!mResourceLoader->asyncBeginLoad(mAsset)) {
-            std::cerr << "Unable to start loading resources for " << filename << std::endl;
+            std::cerr << "Unable to start loading resources for " << name << std::endl;
             exit(1);
         }
         mAsset->releaseSourceData();
@@ -112,6 +134,162 @@ public:
     FilamentAsset* mAsset = nullptr;
 };
 
+static std::string encodeBase64(std::vector<uint8_t> const& data) {
+    static constexpr char ALPHABET[] =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string result;
+    for (size_t i = 0, n = data.size(); i < n; i += 3) {
+        uint32_t bits = uint32_t(data[i]) << 16u;
+        bits |= i + 1 < n ? uint32_t(data[i + 1]) << 8u : 0u;
+        bits |= i + 2 < n ? uint32_t(data[i + 2]) : 0u;
+        result += ALPHABET[(bits >> 18u) & 63u];
+        result += ALPHABET[(bits >> 12u) & 63u];
+        result += i + 1 < n ? ALPHABET[(bits >> 6u) & 63u] : '=';
+        result += i + 2 < n ? ALPHABET[bits & 63u] : '=';
+    }
+    return result;
+}
+
+// Keyframes of the animation of the AnimatedJoints asset, which lasts one second.
+static constexpr float JOINT_KEY_TIMES[] = { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f };
+static constexpr float JOINT0_TRANSLATIONS[][3] = {    // linear
+        { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 }, { 0, 0, 0 }};
+static constexpr float JOINT0_SCALE[3] = { 1.5f, 1.5f, 1.5f };    // single key
+static constexpr float JOINT1_ANGLES[] = { 0.0f, 45.0f, 90.0f, 135.0f, 180.0f };   // linear, z axis
+static constexpr float JOINT2_SCALES[][3] = {          // step
+        { 1, 1, 1 }, { 2, 2, 2 }, { 1, 2, 1 }, { 2, 1, 2 }, { 1, 1, 1 }};
+static constexpr float JOINT2_TRANSLATIONS[][3] = {    // cubic spline, in-tangent, vertex, out-tangent
+        { 0, 0, 0 }, { 0, 0, 0 }, { 0, 2, 0 },
+        { 0, 2, 0 }, { 0, 0, 1 }, { 0, 2, 0 },
+        { 0, -1, 0 }, { 0, 1, 1 }, { 0, -1, 0 },
+        { 0, 0, 0 }, { 0, 1, 0 }, { 0, 0, 0 },
+        { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 }};
+
+// Vertices of the triangle, each of which is bound to a single joint.
+static constexpr float JOINTS_TRIANGLE[][3] = {{ 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 }};
+
+static math::quatf getJoint1Rotation(float degrees) {
+    return math::quatf::fromAxisAngle(math::float3{ 0, 0, 1 }, degrees * math::f::PI / 180.0f);
+}
+
+// Creates a glTF asset with a skinned triangle whose vertices are bound to a chain of three joints,
+// "Joint0" to "Joint2", and an animation that drives the joints with linear, step, cubic spline
+// and single-key samplers. Unlike the morph weights of AnimatedMorphCube, its poses can be read
+// back, from the local transforms of the joints and from the bounding box of the triangle.
+static std::vector<uint8_t> createAnimatedJoints() {
+    std::vector<uint8_t> buffer;
+    std::string accessors;
+    std::string bufferViews;
+    size_t accessorCount = 0;
+    auto addAccessor = [&](void const* data, size_t size, size_t count, int componentType,
+            char const* type, std::string const& bounds = {}) {
+        size_t const index = accessorCount++;
+        std::string const separator = index ? "," : "";
+        bufferViews += separator + R"({"buffer":0,"byteOffset":)" +
+                std::to_string(buffer.size()) + R"(,"byteLength":)" + std::to_string(size) + "}";
+        accessors += separator + R"({"bufferView":)" + std::to_string(index) +
+                R"(,"componentType":)" + std::to_string(componentType) + R"(,"count":)" +
+                std::to_string(count) + R"(,"type":")" + type + "\"" + bounds + "}";
+        buffer.insert(buffer.end(), (uint8_t const*) data, (uint8_t const*) data + size);
+        buffer.resize((buffer.size() + 3) & ~size_t(3));
+        return index;
+    };
+    constexpr int FLOAT = 5126;
+    constexpr int UNSIGNED_BYTE = 5121;
+
+    float const normals[3][3] = {{ 0, 0, 1 }, { 0, 0, 1 }, { 0, 0, 1 }};
+    uint8_t const joints[3][4] = {{ 0, 0, 0, 0 }, { 1, 0, 0, 0 }, { 2, 0, 0, 0 }};
+    float const weights[3][4] = {{ 1, 0, 0, 0 }, { 1, 0, 0, 0 }, { 1, 0, 0, 0 }};
+    float const singleKeyTime[1] = { 0.0f };
+    math::quatf rotations[5];
+    for (size_t i = 0; i < 5; ++i) {
+        rotations[i] = getJoint1Rotation(JOINT1_ANGLES[i]);
+    }
+
+    size_t const positions = addAccessor(JOINTS_TRIANGLE, sizeof(JOINTS_TRIANGLE), 3, FLOAT,
+            "VEC3", R"(,"min":[0,0,0],"max":[1,1,1])");
+    size_t const normal = addAccessor(normals, sizeof(normals), 3, FLOAT, "VEC3");
+    size_t const joint = addAccessor(joints, sizeof(joints), 3, UNSIGNED_BYTE, "VEC4");
+    size_t const weight = addAccessor(weights, sizeof(weights), 3, FLOAT, "VEC4");
+    size_t const times = addAccessor(JOINT_KEY_TIMES, sizeof(JOINT_KEY_TIMES), 5, FLOAT, "SCALAR",
+            R"(,"min":[0],"max":[1])");
+    size_t const singleKey = addAccessor(singleKeyTime, sizeof(singleKeyTime), 1, FLOAT, "SCALAR",
+            R"(,"min":[0],"max":[0])");
+    size_t const translations0 = addAccessor(JOINT0_TRANSLATIONS, sizeof(JOINT0_TRANSLATIONS), 5,
+            FLOAT, "VEC3");
+    size_t const scale0 = addAccessor(JOINT0_SCALE, sizeof(JOINT0_SCALE), 1, FLOAT, "VEC3");
+    size_t const rotations1 = addAccessor(rotations, sizeof(rotations), 5, FLOAT, "VEC4");
+    size_t const scales2 = addAccessor(JOINT2_SCALES, sizeof(JOINT2_SCALES), 5, FLOAT, "VEC3");
+    size_t const translations2 = addAccessor(JOINT2_TRANSLATIONS, sizeof(JOINT2_TRANSLATIONS), 15,
+            FLOAT, "VEC3");
+
+    auto const sampler = [](size_t input, size_t output, char const* interpolation) {
+        return R"({"input":)" + std::to_string(input) + R"(,"output":)" +
+                std::to_string(output) + R"(,"interpolation":")" + interpolation + "\"}";
+    };
+    auto const channel = [](int sampler, int node, char const* path) {
+        return R"({"sampler":)" + std::to_string(sampler) + R"(,"target":{"node":)" +
+                std::to_string(node) + R"(,"path":")" + path + "\"}}";
+    };
+
+    std::string const json = R"({"asset":{"version":"2.0"},"scene":0,"scenes":[{"nodes":[0,1]}],)"
+            R"("nodes":[{"name":"Skinned","mesh":0,"skin":0},)"
+            R"({"name":"Joint0","children":[2]},)"
+            R"({"name":"Joint1","translation":[0,1,0],"children":[3]},)"
+            R"({"name":"Joint2"}],)"
+            R"("skins":[{"joints":[1,2,3]}],)"
+            R"("meshes":[{"primitives":[{"attributes":{"POSITION":)" + std::to_string(positions) +
+            R"(,"NORMAL":)" + std::to_string(normal) + R"(,"JOINTS_0":)" + std::to_string(joint) +
+            R"(,"WEIGHTS_0":)" + std::to_string(weight) + "}}]}]," +
+            R"("animations":[{"name":"Motion","samplers":[)" +
+            sampler(times, translations0, "LINEAR") + "," +
+            sampler(times, rotations1, "LINEAR") + "," +
+            sampler(times, scales2, "STEP") + "," +
+            sampler(times, translations2, "CUBICSPLINE") + "," +
+            sampler(singleKey, scale0, "LINEAR") + R"(],"channels":[)" +
+            channel(0, 1, "translation") + "," +
+            channel(1, 2, "rotation") + "," +
+            channel(2, 3, "scale") + "," +
+            channel(3, 3, "translation") + "," +
+            channel(4, 1, "scale") + "]}]," +
+            R"("accessors":[)" + accessors + R"(],"bufferViews":[)" + bufferViews + "]," +
+            R"("buffers":[{"byteLength":)" + std::to_string(buffer.size()) +
+            R"(,"uri":"data:application/octet-stream;base64,)" + encodeBase64(buffer) + "\"}]}";
+    return { json.begin(), json.end() };
+}
+
+// Returns the local transforms of the joints of an AnimatedJoints asset.
+using JointTransforms = std::array<math::mat4f, 3>;
+static JointTransforms getJointTransforms(Engine* engine, FilamentAsset* asset) {
+    auto const& transformManager = engine->getTransformManager();
+    JointTransforms result;
+    for (size_t i = 0; i < result.size(); ++i) {
+        std::string const name = "Joint" + std::to_string(i);
+        Entity const joint = asset->getFirstEntityByName(name.c_str());
+        result[i] = transformManager.getTransform(transformManager.getInstance(joint));
+    }
+    return result;
+}
+
+// Returns the bounds of the triangle of an AnimatedJoints asset in its current pose. The triangle
+// is not transformed and its skin has no inverse bind matrices, so each vertex is simply
+// transformed by the world transform of its joint.
+static Aabb getSkinnedBounds(Engine* engine, FilamentAsset* asset) {
+    auto const& transformManager = engine->getTransformManager();
+    Aabb result;
+    for (size_t i = 0; i < 3; ++i) {
+        std::string const name = "Joint" + std::to_string(i);
+        Entity const joint = asset->getFirstEntityByName(name.c_str());
+        math::mat4f const& world =
+                transformManager.getWorldTransform(transformManager.getInstance(joint));
+        math::float3 const vertex = (world * math::float4{ math::float3{
+                JOINTS_TRIANGLE[i][0], JOINTS_TRIANGLE[i][1], JOINTS_TRIANGLE[i][2] }, 1 }).xyz;
+        result.min = i ? min(result.min, vertex) : vertex;
+        result.max = i ? max(result.max, vertex) : vertex;
+    }
+    return result;
+}
+
 class glTFIOTest : public testing::Test {
 protected:
     Engine* mEngine = nullptr;
@@ -135,6 +313,11 @@ protected:
         }
     }
 
+    std::unique_ptr<glTFData> loadAnimatedJoints(float streamedAnimationDuration = 0.0f) {
+        return std::make_unique<glTFData>(createAnimatedJoints(), nullptr, mEngine,
+                mMaterialProvider, mNameManager, false, streamedAnimationDuration);
+    }
+
     void TearDown() override {
         mData.clear();
         mMaterialProvider->destroyMaterials();
@@ -236,6 +419,391 @@ TEST_F(glTFIOTest, AnimatedMorphCubeRenderables) {
     EXPECT_EQ(morphTargetBuffer->getVertexCount(), 24u);
 }
 
+TEST_F(glTFIOTest, AnimatedMorphCubeSharedAnimation) {
+    FilamentAsset* morphCubeAsset = mData[ANIMATED_MORPH_CUBE_GLB]->getAsset();
+    Animator* animator = morphCubeAsset->getInstance()->getAnimator();
+
+    size_t const count = animator->getAnimationCount();
+    ASSERT_GT(count, 0u);
+
+    // Binding an animation from an asset with the same hierarchy shares its keyframe data.
+    size_t const index = animator->addAnimation(morphCubeAsset, 0);
+    EXPECT_EQ(index, count);
+    EXPECT_EQ(animator->getAnimationCount(), count + 1);
+    EXPECT_EQ(animator->getAnimationDuration(index), animator->getAnimationDuration(0));
+    EXPECT_STREQ(animator->getAnimationName(index), animator->getAnimationName(0));
+}
+
+TEST_F(glTFIOTest, AnimatedJointsRetargetedAnimation) {
+    std::unique_ptr<glTFData> source = loadAnimatedJoints();
+    std::unique_ptr<glTFData> target = loadAnimatedJoints();
+    FilamentAsset* sourceAsset = source->getAsset();
+    FilamentAsset* targetAsset = target->getAsset();
+    Animator* sourceAnimator = sourceAsset->getInstance()->getAnimator();
+    Animator* animator = targetAsset->getInstance()->getAnimator();
+    ASSERT_EQ(animator->getAnimationCount(), 1u);
+
+    // Retargeting by name binds every channel to the node of the same name.
+    Animator::NameMapping const unused[] = {{ "unknown", "Joint0" }};
+    size_t const index = animator->retargetAnimation(sourceAsset, 0, unused, 1);
+    EXPECT_EQ(index, 1u);
+    EXPECT_EQ(animator->getAnimationDuration(index), sourceAnimator->getAnimationDuration(0));
+
+    // Renamed nodes are driven in place of the node of the same name.
+    Animator::NameMapping const remap[] = {{ "Joint0", "Skinned" }};
+    size_t const remapped = animator->retargetAnimation(sourceAsset, 0, remap, 1);
+    EXPECT_EQ(remapped, 2u);
+
+    auto const& transformManager = mEngine->getTransformManager();
+    auto const skinned = transformManager.getInstance(targetAsset->getFirstEntityByName("Skinned"));
+    for (float const time : { 0.1f, 0.3f, 0.55f, 0.8f }) {
+        SCOPED_TRACE(testing::Message() << "time " << time);
+        sourceAnimator->applyAnimation(0, time);
+        JointTransforms const expected = getJointTransforms(mEngine, sourceAsset);
+
+        animator->applyAnimation(0, 0.0f);
+        animator->applyAnimation(index, time);
+        JointTransforms actual = getJointTransforms(mEngine, targetAsset);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_MAT_NEAR(actual[i], expected[i], 0.0f);
+        }
+
+        animator->applyAnimation(0, 0.0f);
+        math::mat4f const before = getJointTransforms(mEngine, targetAsset)[0];
+        animator->applyAnimation(remapped, time);
+        actual = getJointTransforms(mEngine, targetAsset);
+        EXPECT_MAT_NEAR(transformManager.getTransform(skinned), expected[0], 0.0f);
+        EXPECT_MAT_NEAR(actual[0], before, 0.0f);
+        EXPECT_MAT_NEAR(actual[1], expected[1], 0.0f);
+        EXPECT_MAT_NEAR(actual[2], expected[2], 0.0f);
+    }
+}
+
+TEST_F(glTFIOTest, AnimatedJointsBatchedAnimation) {
+    // Enough instances to be split across several jobs, each at a different time.
+    constexpr size_t COUNT = 6;
+    std::unique_ptr<glTFData> data[COUNT];
+    Animator* animators[COUNT];
+    Animator::AnimationState states[COUNT];
+    for (size_t i = 0; i < COUNT; ++i) {
+        data[i] = loadAnimatedJoints();
+        animators[i] = data[i]->getAsset()->getInstance()->getAnimator();
+        ASSERT_EQ(animators[i]->getAnimationCount(), 1u);
+        states[i] = { animators[i], 0, 0.1f + 0.15f * float(i) };
+    }
+
+    auto const reset = [&]() {
+        for (Animator* animator : animators) {
+            animator->applyAnimation(0, 0.0f);
+        }
+    };
+    auto const getPoses = [&]() {
+        std::array<JointTransforms, COUNT> poses;
+        for (size_t i = 0; i < COUNT; ++i) {
+            poses[i] = getJointTransforms(mEngine, data[i]->getAsset());
+        }
+        return poses;
+    };
+
+    reset();
+    JointTransforms const rest = getJointTransforms(mEngine, data[0]->getAsset());
+    Animator::applyAnimations(states, COUNT);
+    Animator::updateBoneMatrices(animators, COUNT);
+    auto const batched = getPoses();
+
+    // The batched update gives the same poses as updating each instance on its own.
+    reset();
+    for (Animator::AnimationState const& state : states) {
+        state.animator->applyAnimation(state.animationIndex, state.time);
+    }
+    auto const expected = getPoses();
+    for (size_t i = 0; i < COUNT; ++i) {
+        SCOPED_TRACE(testing::Message() << "instance " << i);
+        for (size_t j = 0; j < rest.size(); ++j) {
+            EXPECT_MAT_NEAR(batched[i][j], expected[i][j], 0.0f);
+        }
+        EXPECT_NE(batched[i][0], rest[0]);
+    }
+
+    // Batching nothing is a no-op.
+    Animator::applyAnimations(nullptr, 0);
+    Animator::updateBoneMatrices(nullptr, 0);
+    auto const unchanged = getPoses();
+    for (size_t i = 0; i < COUNT; ++i) {
+        for (size_t j = 0; j < rest.size(); ++j) {
+            EXPECT_MAT_NEAR(unchanged[i][j], expected[i][j], 0.0f);
+        }
+    }
+}
+
+TEST_F(glTFIOTest, AnimatedJointsLayeredAnimation) {
+    std::unique_ptr<glTFData> data = loadAnimatedJoints();
+    FilamentAsset* asset = data->getAsset();
+    Animator* animator = asset->getInstance()->getAnimator();
+    ASSERT_EQ(animator->getAnimationCount(), 1u);
+    float const eps = 1e-5f;
+
+    // At 0.375s, Joint0 is at (1, 0.5, 0) and Joint1 is rotated by 67.5 degrees. At 0.625s, they
+    // are at (0.5, 1, 0) and 112.5 degrees. The scale of Joint0 is always 1.5.
+    Animator::AnimationLayer layers[2] = {};
+    layers[0] = { 0, 0.375f };
+    layers[1] = { 0, 0.625f, 0.5f };
+    animator->applyAnimationLayers(layers, 2);
+    JointTransforms blended = getJointTransforms(mEngine, asset);
+    EXPECT_MAT_NEAR(blended[0], composeMatrix(math::float3{ 0.75f, 0.75f, 0.0f }, math::quatf{ 1 },
+            math::float3{ 1.5f }), eps);
+    EXPECT_MAT_NEAR(blended[1], composeMatrix(math::float3{ 0.0f, 1.0f, 0.0f },
+            getJoint1Rotation(90.0f), math::float3{ 1.0f }), eps);
+
+    // Additive layers add their weighted difference with the first keyframe instead.
+    layers[1].additive = true;
+    animator->applyAnimationLayers(layers, 2);
+    blended = getJointTransforms(mEngine, asset);
+    EXPECT_MAT_NEAR(blended[0], composeMatrix(math::float3{ 1.25f, 1.0f, 0.0f }, math::quatf{ 1 },
+            math::float3{ 1.5f }), eps);
+    EXPECT_MAT_NEAR(blended[1], composeMatrix(math::float3{ 0.0f, 1.0f, 0.0f },
+            getJoint1Rotation(67.5f + 56.25f), math::float3{ 1.0f }), eps);
+
+    // A layer with an empty mask does not affect anything.
+    utils::Entity const root = asset->getRoot();
+    layers[1].mask = &root;
+    layers[1].maskCount = 0;
+    animator->applyAnimationLayers(layers + 1, 1);
+    JointTransforms const masked = getJointTransforms(mEngine, asset);
+    for (size_t i = 0; i < masked.size(); ++i) {
+        EXPECT_MAT_NEAR(masked[i], blended[i], 0.0f);
+    }
+
+#ifdef __EXCEPTIONS
+    // An out-of-range animation index is a precondition failure.
+    layers[0].animationIndex = animator->getAnimationCount();
+    EXPECT_THROW(animator->applyAnimationLayers(layers, 1), utils::PreconditionPanic);
+#endif
+}
+
+TEST_F(glTFIOTest, AnimatedMorphCubeAnimationStats) {
+    FilamentAsset* morphCubeAsset = mData[ANIMATED_MORPH_CUBE_GLB]->getAsset();
+    Animator* animator = morphCubeAsset->getInstance()->getAnimator();
+    ASSERT_GT(animator->getAnimationCount(), 0u);
+
+    animator->resetStats();
+    animator->applyAnimation(0, 0.5f);
+    animator->updateBoneMatrices();
+    Animator::Stats const stats = animator->getStats();
+    EXPECT_GT(stats.channelsEvaluated, 0u);
+    EXPECT_GE(stats.keyframeSearchSteps, stats.channelsEvaluated);
+    EXPECT_GT(stats.morphWeightsUploaded, 0u);
+    EXPECT_EQ(stats.bytesUploaded, stats.morphWeightsUploaded * sizeof(float) +
+            stats.bonesUploaded * sizeof(math::mat4f));
+
+    animator->resetStats();
+    EXPECT_EQ(animator->getStats().channelsEvaluated, 0u);
+    EXPECT_EQ(animator->getStats().animationTime, 0u);
+}
+
+TEST_F(glTFIOTest, AnimatedJointsLevelOfDetail) {
+    std::unique_ptr<glTFData> data = loadAnimatedJoints();
+    std::unique_ptr<glTFData> resident = loadAnimatedJoints();
+    Animator* animator = data->getAsset()->getInstance()->getAnimator();
+    Animator* reference = resident->getAsset()->getInstance()->getAnimator();
+    ASSERT_EQ(animator->getAnimationCount(), 1u);
+
+    // The first call evaluates the current pose. The second one evaluates the pose one interval
+    // ahead, which is reached by interpolation on every third frame from there on.
+    Animator::LevelOfDetail lod;
+    lod.updateInterval = 3;
+    animator->setLevelOfDetail(lod);
+    for (int frame = 0; frame < 8; ++frame) {
+        SCOPED_TRACE(testing::Message() << "frame " << frame);
+        float const time = float(frame) / 60.0f;
+        animator->resetStats();
+        animator->applyAnimation(0, time);
+        bool const evaluated = frame == 0 || frame == 1 || frame == 4 || frame == 7;
+        EXPECT_EQ(animator->getStats().channelsEvaluated > 0, evaluated);
+
+        if (frame == 0 || frame == 4 || frame == 7) {
+            reference->applyAnimation(0, time);
+            JointTransforms const expected = getJointTransforms(mEngine, resident->getAsset());
+            JointTransforms const actual = getJointTransforms(mEngine, data->getAsset());
+            for (size_t i = 0; i < expected.size(); ++i) {
+                EXPECT_MAT_NEAR(actual[i], expected[i], 1e-5f);
+            }
+        }
+    }
+
+    // Invisible instances do not upload their bones.
+    animator->resetStats();
+    animator->updateBoneMatrices();
+    EXPECT_GT(animator->getStats().bonesUploaded, 0u);
+    lod.visible = false;
+    animator->setLevelOfDetail(lod);
+    animator->applyAnimation(0, 0.5f);
+    animator->resetStats();
+    animator->updateBoneMatrices();
+    EXPECT_EQ(animator->getStats().bonesUploaded, 0u);
+
+    // Restoring the default settings evaluates every call again.
+    animator->setLevelOfDetail({});
+    for (int frame = 0; frame < 3; ++frame) {
+        animator->resetStats();
+        animator->applyAnimation(0, 0.5f + float(frame) / 60.0f);
+        EXPECT_GT(animator->getStats().channelsEvaluated, 0u);
+    }
+}
+
+TEST_F(glTFIOTest, AnimatedJointsBakedAnimation) {
+    std::unique_ptr<glTFData> data = loadAnimatedJoints();
+    std::unique_ptr<glTFData> resident = loadAnimatedJoints();
+    FilamentAsset* asset = data->getAsset();
+    Animator* animator = asset->getInstance()->getAnimator();
+    Animator* reference = resident->getAsset()->getInstance()->getAnimator();
+    ASSERT_EQ(animator->getAnimationCount(), 1u);
+
+#ifdef __EXCEPTIONS
+    EXPECT_THROW(animator->applyBakedAnimation(0, 0.0f), utils::PreconditionPanic);
+#endif
+
+    // Bake the one second clip at 4 frames per second, i.e. on its keyframes.
+    constexpr float FRAME_RATE = 4.0f;
+    JointTransforms const rest = getJointTransforms(mEngine, asset);
+    animator->bakeAnimation(0, FRAME_RATE);
+    Aabb frames[5];
+    for (size_t frame = 0; frame < 5; ++frame) {
+        reference->applyAnimation(0, float(frame) / FRAME_RATE);
+        frames[frame] = getSkinnedBounds(mEngine, resident->getAsset());
+    }
+
+    // The skinned triangle is not readable, but its bounds are computed from the baked bones.
+    // They are the union of the bounds of the two baked frames that surround the given time,
+    // which holds both on the baked frames and in between.
+    auto const& renderableManager = mEngine->getRenderableManager();
+    auto const renderable = renderableManager.getInstance(asset->getFirstEntityByName("Skinned"));
+    for (size_t frame = 0; frame < 4; ++frame) {
+        math::float3 const expectedMin = min(frames[frame].min, frames[frame + 1].min);
+        math::float3 const expectedMax = max(frames[frame].max, frames[frame + 1].max);
+        for (float const offset : { 0.0f, 0.5f }) {
+            SCOPED_TRACE(testing::Message() << "frame " << frame + offset);
+            animator->applyBakedAnimation(0, (float(frame) + offset) / FRAME_RATE);
+            Box const box = renderableManager.getAxisAlignedBoundingBox(renderable);
+            for (size_t i = 0; i < 3; ++i) {
+                EXPECT_NEAR(box.getMin()[i], expectedMin[i], 1e-5f);
+                EXPECT_NEAR(box.getMax()[i], expectedMax[i], 1e-5f);
+            }
+        }
+    }
+
+    // Time wraps around the clip, and neither baking nor baked playback touches the local
+    // transforms.
+    animator->applyBakedAnimation(0, animator->getAnimationDuration(0) + 0.5f / FRAME_RATE);
+    Box const wrapped = renderableManager.getAxisAlignedBoundingBox(renderable);
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_NEAR(wrapped.getMin()[i], min(frames[0].min, frames[1].min)[i], 1e-5f);
+        EXPECT_NEAR(wrapped.getMax()[i], max(frames[0].max, frames[1].max)[i], 1e-5f);
+    }
+    JointTransforms const after = getJointTransforms(mEngine, asset);
+    for (size_t i = 0; i < rest.size(); ++i) {
+        EXPECT_MAT_NEAR(after[i], rest[i], 0.0f);
+    }
+}
+
+TEST_F(glTFIOTest, AnimatedJointsStreamedAnimation) {
+    // The clip lasts one second and is streamed in chunks of 0.25 seconds.
+    std::unique_ptr<glTFData> streamed = loadAnimatedJoints(0.001f);
+    std::unique_ptr<glTFData> resident = loadAnimatedJoints();
+    Animator* animator = streamed->getAsset()->getInstance()->getAnimator();
+    Animator* reference = resident->getAsset()->getInstance()->getAnimator();
+    ASSERT_EQ(animator->getAnimationCount(), 1u);
+
+    // Play forward across all the chunk boundaries and past the end, then seek backwards.
+    float const times[] = { 0.0f, 0.1f, 0.24f, 0.25f, 0.26f, 0.49f, 0.51f, 0.74f, 0.76f, 0.99f,
+            1.1f, 1.3f, 0.6f, 0.05f };
+    for (float const time : times) {
+        animator->applyAnimation(0, time);
+        reference->applyAnimation(0, time);
+        JointTransforms const expected = getJointTransforms(mEngine, resident->getAsset());
+        JointTransforms const actual = getJointTransforms(mEngine, streamed->getAsset());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            SCOPED_TRACE(testing::Message() << "time " << time << ", joint " << i);
+            EXPECT_MAT_NEAR(actual[i], expected[i], 0.0f);
+        }
+    }
+
+    // Additive layers are relative to the first keyframe, which is always resident.
+    Animator::AnimationLayer layers[2] = {};
+    layers[0] = { 0, 0.3f };
+    layers[1] = { 0, 0.9f, 0.5f, true };
+    animator->applyAnimationLayers(layers, 2);
+    reference->applyAnimationLayers(layers, 2);
+    JointTransforms const expected = getJointTransforms(mEngine, resident->getAsset());
+    JointTransforms const actual = getJointTransforms(mEngine, streamed->getAsset());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_MAT_NEAR(actual[i], expected[i], 0.0f);
+    }
+}
+
+TEST_F(glTFIOTest, AnimatedMorphCubeProgressiveGeometry) {
+    Path gltfFile = Path::getCurrentExecutable().getParent() + Path(ANIMATED_MORPH_CUBE_GLB);
+    glTFData data(gltfFile, mEngine, mMaterialProvider, mNameManager, true);
+    FilamentAsset* asset = data.getAsset();
+    ResourceLoader* loader = data.mResourceLoader;
+
+    // The cube only becomes ready once its geometry has been uploaded.
+    EXPECT_EQ(asset->popRenderables(nullptr, 0), 0u);
+    EXPECT_LT(loader->asyncGetLoadProgress(), 1.0f);
+
+    while (loader->asyncGetLoadProgress() < 1.0f) {
+        loader->asyncUpdateLoad();
+    }
+    EXPECT_EQ(asset->popRenderables(nullptr, 0), asset->getRenderableEntityCount());
+}
+
+TEST_F(glTFIOTest, AnimatedMorphCubeRecycledInstance) {
+    // Recycling changes the instance, so this uses its own copy of the asset.
+    Path gltfFile = Path::getCurrentExecutable().getParent() + Path(ANIMATED_MORPH_CUBE_GLB);
+    auto data = std::make_unique<glTFData>(gltfFile, mEngine, mMaterialProvider, mNameManager);
+    FilamentAsset* asset = data->getAsset();
+    FilamentInstance* instance = asset->getInstance();
+    auto& transformManager = mEngine->getTransformManager();
+    auto const root = transformManager.getInstance(instance->getRoot());
+    transformManager.setTransform(root, math::mat4f::translation(math::float3{1.0f, 2.0f, 3.0f}));
+
+    data->mAssetLoader->recycleInstance(asset, instance);
+#ifdef __EXCEPTIONS
+    EXPECT_THROW(data->mAssetLoader->recycleInstance(asset, instance), utils::PreconditionPanic);
+#endif
+
+    // The source data has been released, so only the recycled instance can be handed out.
+    FilamentInstance* instances[2] = {};
+    EXPECT_EQ(data->mAssetLoader->createInstances(asset, 2, instances), 1u);
+    EXPECT_EQ(instances[0], instance);
+    EXPECT_EQ(asset->getAssetInstanceCount(), 1u);
+    EXPECT_MAT_NEAR(transformManager.getTransform(root), math::mat4f{}, 0.0f);
+}
+
+TEST_F(glTFIOTest, AnimatedMorphCubePreparedAsset) {
+    glTFData* data = mData[ANIMATED_MORPH_CUBE_GLB].get();
+    AssetLoader* assetLoader = data->mAssetLoader;
+    Path gltfFile = Path::getCurrentExecutable().getParent() + Path(ANIMATED_MORPH_CUBE_GLB);
+
+    PreparedAsset* prepared = nullptr;
+    std::thread worker([&]() {
+        prepared = assetLoader->prepareAssetFromFile(gltfFile.c_str());
+    });
+    worker.join();
+    ASSERT_NE(prepared, nullptr);
+
+    FilamentAsset* asset = assetLoader->commitAsset(prepared);
+    ASSERT_NE(asset, nullptr);
+    FilamentAsset const* reference = data->getAsset();
+    EXPECT_EQ(asset->getEntityCount(), reference->getEntityCount());
+    EXPECT_EQ(asset->getRenderableEntityCount(), reference->getRenderableEntityCount());
+    EXPECT_EQ(asset->getBoundingBox().min, reference->getBoundingBox().min);
+    EXPECT_EQ(asset->getBoundingBox().max, reference->getBoundingBox().max);
+    assetLoader->destroyAsset(asset);
+
+    AssetLoader::destroyPreparedAsset(assetLoader->prepareAssetFromFile(gltfFile.c_str()));
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
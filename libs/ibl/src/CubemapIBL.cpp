@@ -28,6 +28,8 @@
 #include <math/mat3.h>
 #include <math/scalar.h>
 
+#include <algorithm>
+#include <iterator>
 #include <random>
 #include <vector>
 
@@ -401,6 +403,10 @@ void CubemapIBL::roughnessFilter(
             uint8_t l0 = uint8_t(mipLevel);
             uint8_t l1 = uint8_t(std::min(maxLevel, size_t(l0 + 1)));
             float lerp = mipLevel - (float) l0;
+            if (lerp == 0.0f) {
+                // this sample only needs a bilinear fetch, see below
+                l1 = l0;
+            }
 
             cache.push_back({ L, brdf_NoL, lerp, l0, l1 });
         }
@@ -415,6 +421,13 @@ void CubemapIBL::roughnessFilter(
         return lhs.brdf_NoL < rhs.brdf_NoL;
     });
 
+    // Samples that fall exactly on a level, i.e. all of them without prefiltering and those
+    // clamped to the first or last level with it, only need a single bilinear fetch. We move
+    // them first, so they can be processed in their own loop, without the second fetch.
+    const size_t bilinearCount = size_t(std::distance(cache.begin(),
+            std::stable_partition(cache.begin(), cache.end(), [](CacheEntry const& entry) {
+                return entry.l0 == entry.l1;
+            })));
 
     struct State {
         // maybe blue-noise instead would look even better
@@ -443,7 +456,12 @@ void CubemapIBL::roughnessFilter(
             R *= mat3f::rotation(state.distribution(state.gen), float3{0,0,1});
 
             float3 Li = 0;
-            for (size_t sample = 0; sample < numSamples; sample++) {
+            for (size_t sample = 0; sample < bilinearCount; sample++) {
+                const CacheEntry& e = cache[sample];
+                const float3 L(R * e.L);
+                Li += levels[e.l0].filterAt(L) * e.brdf_NoL;
+            }
+            for (size_t sample = bilinearCount; sample < numSamples; sample++) {
                 const CacheEntry& e = cache[sample];
                 const float3 L(R * e.L);
                 const Cubemap& cmBase = levels[e.l0];
@@ -22,6 +22,10 @@
 
 #include <filament/Texture.h>
 
+#include <math/vec3.h>
+
+#include <stdint.h>
+
 namespace filament {
 class Engine;
 class View;
@@ -32,6 +36,7 @@ class MaterialInstance;
 class VertexBuffer;
 class IndexBuffer;
 class Camera;
+class RenderTarget;
 class Texture;
 } // namespace filament
 
@@ -320,17 +325,203 @@ public:
                 filament::Texture const* environmentCubemap,
                 filament::Texture* outReflectionsTexture = nullptr);
 
-        // TODO: option for progressive filtering
+        /**
+         * Generates a prefiltered cubemap from an environment in client memory. This is the
+         * GPU equivalent of Texture::generatePrefilterMipmap(), which runs on the CPU.
+         * The environment is uploaded to a temporary cubemap whose mipmaps are generated.
+         *
+         * @param options                   Options for this environment. generateMipmap is
+         *                                  ignored.
+         * @param buffer                    Client-side buffer containing the six faces of the
+         *                                  environment. The format must be RGB or RGBA and the
+         *                                  type FLOAT or HALF, or UINT_10F_11F_11F_REV with RGB.
+         * @param faceOffsets               Offsets in bytes into \p buffer for all six faces, in
+         *                                  the following order: +x, -x, +y, -y, +z, -z
+         * @param size                      Size of the faces, must be a power of two.
+         * @param outReflectionsTexture     Output prefiltered texture or, if null, it is
+         *                                  automatically created with some default parameters.
+         *                                  Same requirements as operator()(Options,
+         *                                  Texture const*, Texture*).
+         * @return returns outReflectionsTexture
+         */
+        filament::Texture* operator()(Options options,
+                filament::Texture::PixelBufferDescriptor&& buffer,
+                filament::Texture::FaceOffsets const& faceOffsets, uint32_t size,
+                filament::Texture* outReflectionsTexture = nullptr);
+
+        /**
+         * Starts generating a prefiltered cubemap progressively, so that the work can be spread
+         * over several frames, e.g. to update the reflections of a dynamic sky. The filtering
+         * is done by step(), in passes that each render three faces of one level.
+         *
+         * The filter owns two reflection textures, created with some default parameters. The
+         * result is rendered into one of them while the other one keeps the result of the
+         * previous progressive filtering, so that it can still be used by an IndirectLight in
+         * the meantime. Calling begin() again before step() completes restarts the filtering.
+         *
+         * @param options               Options for this environment
+         * @param environmentCubemap    Environment cubemap (input). Can't be null.
+         *                              This cubemap must be SAMPLEABLE and must have all its
+         *                              levels allocated. If Options.generateMipmap is true,
+         *                              the mipmap levels are overwritten by this call. Its
+         *                              content must not change until step() completes.
+         */
+        void begin(Options options, filament::Texture const* environmentCubemap);
 
-        // TODO: add a callback for when the processing is done?
+        /**
+         * Renders the next passes of the progressive filtering started with begin().
+         * A cubemap with N levels takes 2 x N passes. The first level is a copy of the
+         * environment, and is much cheaper than the others.
+         *
+         * @param passCount     Maximum number of passes to render during this call.
+         * @return The prefiltered texture once all passes are rendered, nullptr otherwise.
+         *         This texture is owned by the filter. The next begin() renders into the
+         *         texture returned by the previous completion, so IndirectLights that use it must
+         *         be replaced by then.
+         */
+        filament::Texture* step(uint32_t passCount = 1u);
 
     private:
         filament::Texture* createReflectionsTexture();
+        void render(Options const& options, filament::Texture const* environmentCubemap,
+                filament::Texture* outReflectionsTexture, uint8_t lod, uint8_t side);
+
+        struct Progress {
+            Options options;
+            filament::Texture const* environment = nullptr;
+            filament::Texture* textures[2] = {};
+            uint32_t pass = 0u;
+            uint8_t back = 0u;
+        };
+
         IBLPrefilterContext& mContext;
         filament::Material* mKernelMaterial = nullptr;
         filament::Texture* mKernelTexture = nullptr;
         uint32_t mSampleCount = 0u;
         uint8_t mLevelCount = 1u;
+        Progress mProgress;
+    };
+
+    /**
+     * ReflectionProbe captures a Scene into a low resolution cubemap from a given position and
+     * prefilters it with a SpecularFilter, so that it can be used as the reflections of a
+     * local IndirectLight. The irradiance is then derived from the reflections by the
+     * IndirectLight itself.
+     *
+     * The work is spread over several frames: begin() starts an update, and each call to
+     * step() renders at most a given number of passes. A capture takes 6 passes, one per face,
+     * and the filtering takes 2 passes per level. This makes it possible to keep many probes
+     * up to date with a fixed per-frame budget, by distributing the passes across them.
+     *
+     * Usage Example:
+     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+     * IBLPrefilterContext::ReflectionProbe probe(context);
+     * probe.begin(scene, position);
+     *
+     * // every frame, outside of Renderer::beginFrame() / endFrame()
+     * if (Texture const* reflections = probe.step(4)) {
+     *     engine->destroy(indirectLight);
+     *     indirectLight = IndirectLight::Builder().reflections(reflections).build(*engine);
+     *     probe.begin(scene, position);
+     * }
+     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+     */
+    class ReflectionProbe {
+    public:
+        /**
+         * Probe configuration.
+         */
+        struct Config {
+            uint16_t size = 128u;                   //!< size of the captured faces, a power of two
+            float near = 0.1f;                      //!< near plane of the capture, in world units
+            float far = 100.0f;                     //!< far plane of the capture, in world units
+            SpecularFilter::Config filter{};        //!< configuration of the specular filter
+        };
+
+        /**
+         * Creates a ReflectionProbe.
+         * @param context IBLPrefilterContext to use
+         * @param config  Configuration of the probe
+         */
+        ReflectionProbe(IBLPrefilterContext& context, Config const& config);
+
+        /**
+         * Creates a probe with the default configuration.
+         * @param context IBLPrefilterContext to use
+         */
+        explicit ReflectionProbe(IBLPrefilterContext& context);
+
+        /**
+         * Destroys all GPU resources created during initialization.
+         */
+        ~ReflectionProbe() noexcept;
+
+        ReflectionProbe(ReflectionProbe const&) = delete;
+        ReflectionProbe& operator=(ReflectionProbe const&) = delete;
+        ReflectionProbe(ReflectionProbe&& rhs) noexcept;
+        ReflectionProbe& operator=(ReflectionProbe&& rhs) noexcept;
+
+        /**
+         * Returns the View used to capture the faces, e.g. to enable shadows or to change the
+         * visible layers. Post-processing is disabled so that the capture stays in linear HDR,
+         * and the exposure of its camera is 1.
+         */
+        filament::View* getView() noexcept { return mView; }
+
+        /**
+         * Starts updating the probe. Calling begin() again before step() completes restarts
+         * the update.
+         *
+         * @param scene     Scene to capture. Can't be null. It must stay alive until step()
+         *                  completes.
+         * @param position  Position of the probe in world space.
+         * @param options   Options of the specular filter. The mipmaps of the captured
+         *                  environment are always generated.
+         */
+        void begin(filament::Scene* scene, filament::math::float3 const& position,
+                SpecularFilter::Options const& options);
+
+        /**
+         * Starts updating the probe with the default options of the specular filter.
+         * @param scene     Scene to capture. Can't be null.
+         * @param position  Position of the probe in world space.
+         */
+        void begin(filament::Scene* scene, filament::math::float3 const& position);
+
+        /**
+         * Renders the next passes of the update started with begin(). This calls
+         * Renderer::renderStandaloneView() and must be called outside of
+         * Renderer::beginFrame() / endFrame().
+         *
+         * @param passCount     Maximum number of passes to render during this call.
+         * @return The prefiltered reflections once all passes are rendered, nullptr otherwise.
+         *         The texture is owned by the probe. The update after the next one renders
+         *         into it again, so IndirectLights that use it must be replaced by then
+         *         (see SpecularFilter::step()).
+         */
+        filament::Texture* step(uint32_t passCount = 1u);
+
+        /**
+         * Returns the number of passes that step() still has to render for the current update.
+         */
+        uint32_t getRemainingPassCount() const noexcept;
+
+    private:
+        void capture(uint8_t face);
+
+        IBLPrefilterContext& mContext;
+        Config mConfig;
+        SpecularFilter mFilter;
+        SpecularFilter::Options mOptions{};
+        filament::Texture* mEnvironment = nullptr;
+        filament::Texture* mDepth = nullptr;
+        filament::RenderTarget* mRenderTargets[6] = {};
+        filament::View* mView = nullptr;
+        filament::Camera* mCamera = nullptr;
+        utils::Entity mCameraEntity{};
+        filament::math::float3 mPosition{};
+        uint32_t mFilterPassCount = 0u;     // filter passes left once the capture is complete
+        uint8_t mFace = 6u;                 // next face to capture, 6 when the capture is done
     };
 
 private:
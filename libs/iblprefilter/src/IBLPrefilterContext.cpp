@@ -16,6 +16,7 @@
 
 #include "filament-iblprefilter/IBLPrefilterContext.h"
 
+#include <filament/Camera.h>
 #include <filament/Engine.h>
 #include <filament/IndexBuffer.h>
 #include <filament/Material.h>
@@ -552,6 +553,8 @@ IBLPrefilterContext::SpecularFilter::~SpecularFilter() noexcept {
     Engine& engine = mContext.mEngine;
     engine.destroy(mKernelTexture);
     engine.destroy(mKernelMaterial);
+    engine.destroy(mProgress.textures[0]);
+    engine.destroy(mProgress.textures[1]);
 }
 
 IBLPrefilterContext::SpecularFilter::SpecularFilter(SpecularFilter&& rhs) noexcept
@@ -565,6 +568,7 @@ IBLPrefilterContext::SpecularFilter::operator=(SpecularFilter&& rhs) noexcept {
     if (this != & rhs) {
         swap(mKernelMaterial, rhs.mKernelMaterial);
         swap(mKernelTexture, rhs.mKernelTexture);
+        swap(mProgress, rhs.mProgress);
         mSampleCount = rhs.mSampleCount;
         mLevelCount = rhs.mLevelCount;
     }
@@ -626,6 +630,96 @@ Texture* IBLPrefilterContext::SpecularFilter::operator()(
             << "outReflectionsTexture has " << +outReflectionsTexture->getLevels() << " levels but "
             << +mLevelCount << " are requested.";
 
+    if (options.generateMipmap) {
+        // We need mipmaps for prefiltering
+        environmentCubemap->generateMipmaps(mContext.mEngine);
+    }
+
+    const uint8_t levels = outReflectionsTexture->getLevels();
+    for (uint8_t lod = 0; lod < levels; lod++) {
+        SYSTRACE_NAME("executeFilterLOD");
+        for (uint8_t side = 0; side < 2; side++) {
+            render(options, environmentCubemap, outReflectionsTexture, lod, side);
+        }
+    }
+
+    return outReflectionsTexture;
+}
+
+Texture* IBLPrefilterContext::SpecularFilter::operator()(
+        IBLPrefilterContext::SpecularFilter::Options options,
+        Texture::PixelBufferDescriptor&& buffer, Texture::FaceOffsets const& faceOffsets,
+        uint32_t size, Texture* outReflectionsTexture) {
+    SYSTRACE_CALL();
+    using namespace backend;
+
+    FILAMENT_CHECK_PRECONDITION(size && !(size & (size - 1u)))
+            << "size must be a power of two, got " << size;
+
+    FILAMENT_CHECK_PRECONDITION(
+            buffer.format == PixelDataFormat::RGB || buffer.format == PixelDataFormat::RGBA)
+            << "input data format must be RGB or RGBA";
+
+    FILAMENT_CHECK_PRECONDITION(buffer.type == PixelDataType::FLOAT ||
+            buffer.type == PixelDataType::HALF ||
+            (buffer.type == PixelDataType::UINT_10F_11F_11F_REV &&
+                    buffer.format == PixelDataFormat::RGB))
+            << "input data type must be FLOAT, HALF or UINT_10F_11F_11F_REV";
+
+    Engine& engine = mContext.mEngine;
+
+    // both formats accept all the input types, and are color-renderable so that the mipmaps
+    // can be generated
+    const uint8_t levels = uint8_t(std::log2(size) + 0.5f) + 1u;
+    Texture* const environment = Texture::Builder()
+            .sampler(Texture::Sampler::SAMPLER_CUBEMAP)
+            .format(buffer.format == PixelDataFormat::RGB ?
+                    Texture::InternalFormat::R11F_G11F_B10F : Texture::InternalFormat::RGBA16F)
+            .usage(Texture::Usage::COLOR_ATTACHMENT | Texture::Usage::SAMPLEABLE |
+                   Texture::Usage::UPLOADABLE |
+                   Texture::Usage::BLIT_SRC | Texture::Usage::BLIT_DST)
+            .width(size).height(size).levels(levels)
+            .build(engine);
+
+    // Each face is uploaded with a descriptor that references the client buffer. The last one
+    // owns it, so that the client's callback is called once all faces are uploaded.
+    const auto format = buffer.format;
+    const auto type = buffer.type;
+    const uint8_t alignment = buffer.alignment;
+    const uint32_t left = buffer.left;
+    const uint32_t top = buffer.top;
+    const uint32_t stride = buffer.stride;
+    const size_t faceSize = Texture::PixelBufferDescriptor::computeDataSize(
+            format, type, stride ? stride : size, size, alignment);
+    char const* const data = static_cast<char const*>(buffer.buffer);
+    for (uint32_t face = 0; face < 6; face++) {
+        Texture::PixelBufferDescriptor::Callback callback = nullptr;
+        Texture::PixelBufferDescriptor* owner = nullptr;
+        if (face == 5) {
+            owner = new Texture::PixelBufferDescriptor(std::move(buffer));
+            callback = [](void*, size_t, void* user) {
+                delete static_cast<Texture::PixelBufferDescriptor*>(user);
+            };
+        }
+        environment->setImage(engine, 0, 0, 0, face, size, size, 1, {
+                data + faceOffsets[face], faceSize, format, type, alignment, left, top, stride,
+                callback, owner });
+    }
+
+    options.generateMipmap = true;
+    outReflectionsTexture = operator()(options, environment, outReflectionsTexture);
+
+    // the destruction is deferred until the commands that use the texture have executed
+    engine.destroy(environment);
+
+    return outReflectionsTexture;
+}
+
+void IBLPrefilterContext::SpecularFilter::render(Options const& options,
+        Texture const* environmentCubemap, Texture* outReflectionsTexture,
+        uint8_t lod, uint8_t side) {
+    using namespace backend;
+
     const TextureCubemapFace faces[2][3] = {
             { TextureCubemapFace::POSITIVE_X, TextureCubemapFace::POSITIVE_Y, TextureCubemapFace::POSITIVE_Z },
             { TextureCubemapFace::NEGATIVE_X, TextureCubemapFace::NEGATIVE_Y, TextureCubemapFace::NEGATIVE_Z }
@@ -636,6 +730,8 @@ Texture* IBLPrefilterContext::SpecularFilter::operator()(
     Renderer* const renderer = mContext.mRenderer;
     MaterialInstance* const mi = mContext.mIntegrationMaterial->getDefaultInstance();
 
+    // The material instance is shared by all the filters of the context, so all its parameters
+    // are set for each pass, in case another filter ran in between (see begin()/step()).
     RenderableManager& rcm = engine.getRenderableManager();
     rcm.setMaterialInstanceAt(
             rcm.getInstance(mContext.mFullScreenQuadEntity), 0, mi);
@@ -644,8 +740,9 @@ Texture* IBLPrefilterContext::SpecularFilter::operator()(
     const float linear = options.hdrLinear;
     const float compress = options.hdrMax;
     const uint8_t levels = outReflectionsTexture->getLevels();
-    uint32_t dim = outReflectionsTexture->getWidth();
-    const float omegaP = (4.0f * f::PI) / float(6 * dim * dim);
+    const uint32_t baseDim = outReflectionsTexture->getWidth();
+    const uint32_t dim = std::max(1u, baseDim >> lod);
+    const float omegaP = (4.0f * f::PI) / float(6 * baseDim * baseDim);
 
     TextureSampler environmentSampler;
     environmentSampler.setMagFilter(SamplerMagFilter::LINEAR);
@@ -654,52 +751,248 @@ Texture* IBLPrefilterContext::SpecularFilter::operator()(
     mi->setParameter("environment", environmentCubemap, environmentSampler);
     mi->setParameter("kernel", mKernelTexture, TextureSampler{ SamplerMagFilter::NEAREST });
     mi->setParameter("compress", float2{ linear, compress });
-    mi->setParameter("lodOffset", options.lodOffset - log4(omegaP));
+
+    // the last lod uses a more aggressive filtering because this level is also used for the
+    // diffuse brdf by filament, and we need it to be very smooth. So we set the lod offset to
+    // at least 2.
+    const float lodOffset = lod == levels - 1 ? std::max(2.0f, options.lodOffset) : options.lodOffset;
+    mi->setParameter("lodOffset", lodOffset - log4(omegaP));
+    mi->setParameter("sampleCount", uint32_t(lod == 0 ? 1u : sampleCount));
+    mi->setParameter("attachmentLevel", uint32_t(lod));
+    mi->setParameter("side", side == 0 ? 1.0f : -1.0f);
+
+    view->setViewport({ 0, 0, dim, dim });
+
+    RenderTarget* const rt = RenderTarget::Builder()
+            .texture(RenderTarget::AttachmentPoint::COLOR0, outReflectionsTexture)
+            .texture(RenderTarget::AttachmentPoint::COLOR1, outReflectionsTexture)
+            .texture(RenderTarget::AttachmentPoint::COLOR2, outReflectionsTexture)
+            .mipLevel(RenderTarget::AttachmentPoint::COLOR0, lod)
+            .mipLevel(RenderTarget::AttachmentPoint::COLOR1, lod)
+            .mipLevel(RenderTarget::AttachmentPoint::COLOR2, lod)
+            .face(RenderTarget::AttachmentPoint::COLOR0, faces[side][0])
+            .face(RenderTarget::AttachmentPoint::COLOR1, faces[side][1])
+            .face(RenderTarget::AttachmentPoint::COLOR2, faces[side][2])
+            .build(engine);
+
+    view->setRenderTarget(rt);
+    renderer->renderStandaloneView(view);
+    engine.destroy(rt);
+}
+
+void IBLPrefilterContext::SpecularFilter::begin(Options options,
+        Texture const* environmentCubemap) {
+    SYSTRACE_CALL();
+
+    FILAMENT_CHECK_PRECONDITION(environmentCubemap != nullptr) << "environmentCubemap is null!";
+
+    FILAMENT_CHECK_PRECONDITION(
+            environmentCubemap->getTarget() == Texture::Sampler::SAMPLER_CUBEMAP)
+            << "environmentCubemap must be a cubemap.";
+
+    Progress& progress = mProgress;
+    if (!progress.textures[progress.back]) {
+        progress.textures[progress.back] = createReflectionsTexture();
+    }
 
     if (options.generateMipmap) {
         // We need mipmaps for prefiltering
-        environmentCubemap->generateMipmaps(engine);
+        environmentCubemap->generateMipmaps(mContext.mEngine);
     }
 
-    RenderTarget::Builder builder;
-    builder.texture(RenderTarget::AttachmentPoint::COLOR0, outReflectionsTexture)
-           .texture(RenderTarget::AttachmentPoint::COLOR1, outReflectionsTexture)
-           .texture(RenderTarget::AttachmentPoint::COLOR2, outReflectionsTexture);
+    progress.options = options;
+    progress.environment = environmentCubemap;
+    progress.pass = 0;
+}
 
-    for (size_t lod = 0; lod < levels; lod++) {
-        SYSTRACE_NAME("executeFilterLOD");
+Texture* IBLPrefilterContext::SpecularFilter::step(uint32_t passCount) {
+    SYSTRACE_CALL();
 
-        mi->setParameter("sampleCount", uint32_t(lod == 0 ? 1u : sampleCount));
-        mi->setParameter("attachmentLevel", uint32_t(lod));
+    Progress& progress = mProgress;
+    if (!progress.environment) {
+        return nullptr;
+    }
 
-        if (lod == levels - 1) {
-            // this is the last lod, use a more aggressive filtering because this level is also
-            // used for the diffuse brdf by filament, and we need it to be very smooth.
-            // So we set the lod offset to at least 2.
-            mi->setParameter("lodOffset", std::max(2.0f, options.lodOffset) - log4(omegaP));
-        }
+    Texture* const target = progress.textures[progress.back];
+    const uint32_t totalPassCount = target->getLevels() * 2u;
+    for (uint32_t i = 0; i < passCount && progress.pass < totalPassCount; i++, progress.pass++) {
+        render(progress.options, progress.environment, target,
+                uint8_t(progress.pass / 2u), uint8_t(progress.pass % 2u));
+    }
+
+    if (progress.pass < totalPassCount) {
+        return nullptr;
+    }
+
+    // the next filtering renders into the other texture
+    progress.environment = nullptr;
+    progress.back ^= 1u;
+    return target;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+IBLPrefilterContext::ReflectionProbe::ReflectionProbe(IBLPrefilterContext& context,
+        Config const& config)
+        : mContext(context), mConfig(config), mFilter(context, config.filter) {
+    using namespace backend;
+
+    FILAMENT_CHECK_PRECONDITION(config.size && !(config.size & (config.size - 1u)))
+            << "size must be a power of two, got " << config.size;
+
+    // same as the SpecularFilter
+    mConfig.filter.levelCount = std::max(config.filter.levelCount, uint8_t(1u));
+
+    Engine& engine = mContext.mEngine;
+    const uint32_t size = config.size;
+    const uint8_t levels = uint8_t(std::log2(size) + 0.5f) + 1u;
+
+    // the environment needs all its levels for the specular filter, which generates them
+    mEnvironment = Texture::Builder()
+            .sampler(Texture::Sampler::SAMPLER_CUBEMAP)
+            .format(Texture::InternalFormat::R11F_G11F_B10F)
+            .usage(Texture::Usage::COLOR_ATTACHMENT | Texture::Usage::SAMPLEABLE |
+                   Texture::Usage::BLIT_SRC | Texture::Usage::BLIT_DST)
+            .width(size).height(size).levels(levels)
+            .build(engine);
+
+    mDepth = Texture::Builder()
+            .format(Texture::InternalFormat::DEPTH24)
+            .usage(Texture::Usage::DEPTH_ATTACHMENT)
+            .width(size).height(size).levels(1)
+            .build(engine);
+
+    for (uint8_t face = 0; face < 6; face++) {
+        mRenderTargets[face] = RenderTarget::Builder()
+                .texture(RenderTarget::AttachmentPoint::COLOR0, mEnvironment)
+                .face(RenderTarget::AttachmentPoint::COLOR0, TextureCubemapFace(face))
+                .texture(RenderTarget::AttachmentPoint::DEPTH, mDepth)
+                .build(engine);
+    }
+
+    mCameraEntity = utils::EntityManager::get().create();
+    mCamera = engine.createCamera(mCameraEntity);
+    mCamera->setProjection(90.0, 1.0, config.near, config.far, Camera::Fov::VERTICAL);
+    // the probe captures the scene's luminance, the exposure is applied when it is used
+    mCamera->setExposure(1.0f);
+
+    mView = engine.createView();
+    View* const view = mView;
+    view->setCamera(mCamera);
+    view->setViewport({ 0, 0, size, size });
+    view->setPostProcessingEnabled(false);
+    view->setScreenSpaceRefractionEnabled(false);
+    view->setShadowingEnabled(false);
+}
+
+IBLPrefilterContext::ReflectionProbe::ReflectionProbe(IBLPrefilterContext& context)
+        : ReflectionProbe(context, {}) {
+}
 
-        builder.mipLevel(RenderTarget::AttachmentPoint::COLOR0, lod)
-               .mipLevel(RenderTarget::AttachmentPoint::COLOR1, lod)
-               .mipLevel(RenderTarget::AttachmentPoint::COLOR2, lod);
+IBLPrefilterContext::ReflectionProbe::~ReflectionProbe() noexcept {
+    Engine& engine = mContext.mEngine;
+    engine.destroy(mView);
+    for (RenderTarget* rt : mRenderTargets) {
+        engine.destroy(rt);
+    }
+    engine.destroy(mDepth);
+    engine.destroy(mEnvironment);
+    engine.destroyCameraComponent(mCameraEntity);
+    utils::EntityManager::get().destroy(mCameraEntity);
+}
 
-        view->setViewport({ 0, 0, dim, dim });
+IBLPrefilterContext::ReflectionProbe::ReflectionProbe(ReflectionProbe&& rhs) noexcept
+        : mContext(rhs.mContext), mConfig(rhs.mConfig), mFilter(std::move(rhs.mFilter)) {
+    using std::swap;
+    swap(mOptions, rhs.mOptions);
+    swap(mEnvironment, rhs.mEnvironment);
+    swap(mDepth, rhs.mDepth);
+    swap(mRenderTargets, rhs.mRenderTargets);
+    swap(mView, rhs.mView);
+    swap(mCamera, rhs.mCamera);
+    swap(mCameraEntity, rhs.mCameraEntity);
+    swap(mPosition, rhs.mPosition);
+    swap(mFace, rhs.mFace);
+    swap(mFilterPassCount, rhs.mFilterPassCount);
+}
 
-        for (size_t i = 0; i < 2; i++) {
-            mi->setParameter("side", i == 0 ? 1.0f : -1.0f);
+IBLPrefilterContext::ReflectionProbe&
+IBLPrefilterContext::ReflectionProbe::operator=(ReflectionProbe&& rhs) noexcept {
+    using std::swap;
+    if (this != & rhs) {
+        swap(mConfig, rhs.mConfig);
+        swap(mFilter, rhs.mFilter);
+        swap(mOptions, rhs.mOptions);
+        swap(mEnvironment, rhs.mEnvironment);
+        swap(mDepth, rhs.mDepth);
+        swap(mRenderTargets, rhs.mRenderTargets);
+        swap(mView, rhs.mView);
+        swap(mCamera, rhs.mCamera);
+        swap(mCameraEntity, rhs.mCameraEntity);
+        swap(mPosition, rhs.mPosition);
+        swap(mFace, rhs.mFace);
+        swap(mFilterPassCount, rhs.mFilterPassCount);
+    }
+    return *this;
+}
 
-            builder.face(RenderTarget::AttachmentPoint::COLOR0, faces[i][0])
-                   .face(RenderTarget::AttachmentPoint::COLOR1, faces[i][1])
-                   .face(RenderTarget::AttachmentPoint::COLOR2, faces[i][2]);
+void IBLPrefilterContext::ReflectionProbe::begin(Scene* scene, float3 const& position,
+        SpecularFilter::Options const& options) {
+    FILAMENT_CHECK_PRECONDITION(scene != nullptr) << "scene is null!";
+    mView->setScene(scene);
+    mPosition = position;
+    mOptions = options;
+    mFace = 0;
+    mFilterPassCount = 0;
+}
+
+void IBLPrefilterContext::ReflectionProbe::begin(Scene* scene, float3 const& position) {
+    begin(scene, position, {});
+}
+
+void IBLPrefilterContext::ReflectionProbe::capture(uint8_t face) {
+    using namespace backend;
+
+    // standard cubemap face orientations
+    constexpr float3 directions[6] = {
+            {  1,  0,  0 }, { -1,  0,  0 },
+            {  0,  1,  0 }, {  0, -1,  0 },
+            {  0,  0,  1 }, {  0,  0, -1 }
+    };
+    constexpr float3 ups[6] = {
+            {  0, -1,  0 }, {  0, -1,  0 },
+            {  0,  0,  1 }, {  0,  0, -1 },
+            {  0, -1,  0 }, {  0, -1,  0 }
+    };
 
-            RenderTarget* const rt = builder.build(engine);
-            view->setRenderTarget(rt);
-            renderer->renderStandaloneView(view);
-            engine.destroy(rt);
+    const double3 eye{ mPosition };
+    mCamera->lookAt(eye, eye + double3{ directions[face] }, double3{ ups[face] });
+    mView->setRenderTarget(mRenderTargets[face]);
+    mContext.mRenderer->renderStandaloneView(mView);
+}
+
+Texture* IBLPrefilterContext::ReflectionProbe::step(uint32_t passCount) {
+    SYSTRACE_CALL();
+
+    for (; passCount && mFace < 6u; passCount--) {
+        capture(mFace++);
+        if (mFace == 6u) {
+            // this generates the mipmaps of the environment, which the specular filter needs
+            SpecularFilter::Options options = mOptions;
+            options.generateMipmap = true;
+            mFilter.begin(options, mEnvironment);
+            mFilterPassCount = 2u * mConfig.filter.levelCount;
         }
+    }
 
-        dim >>= 1;
+    if (!passCount || !mFilterPassCount) {
+        return nullptr;
     }
 
-    return outReflectionsTexture;
+    mFilterPassCount -= std::min(passCount, mFilterPassCount);
+    return mFilter.step(passCount);
+}
+
+uint32_t IBLPrefilterContext::ReflectionProbe::getRemainingPassCount() const noexcept {
+    return mFace < 6u ? (6u - mFace) + 2u * mConfig.filter.levelCount : mFilterPassCount;
 }
@@ -21,6 +21,10 @@
 
 #include <utils/compiler.h>
 
+namespace utils {
+class JobSystem;
+} // namespace utils
+
 namespace image {
 
 /**
@@ -98,6 +102,7 @@ struct ImageSampler {
     Boundary north;
     Boundary west;
     Boundary south;
+    utils::JobSystem* jobSystem = nullptr; // if set, rows are resampled in parallel
 };
 
 /**
@@ -140,10 +145,11 @@ void computeSingleSample(const LinearImage& source, float x, float y, SingleSamp
  *
  * Source image need not be power-of-two. In the result vector, the half-size image is returned at
  * index 0, the quarter-size image is at index 1, etc. Please note that the original-sized image is
- * not included.
+ * not included. If a JobSystem is given, the rows of each level are resampled in parallel.
  */
 UTILS_PUBLIC
-void generateMipmaps(const LinearImage& source, Filter, LinearImage* result, uint32_t mipCount);
+void generateMipmaps(const LinearImage& source, Filter, LinearImage* result, uint32_t mipCount,
+        utils::JobSystem* jobSystem = nullptr);
 
 /**
  * Returns the number of miplevels it would take to downsample the given image down to 1x1. This
@@ -204,13 +204,21 @@ LinearImage transpose(const LinearImage& image) {
     LinearImage result(height, width, channels);
     float const* source = image.getPixelRef();
     float* target = result.getPixelRef();
-    for (uint32_t n = 0; n < width * height; ++n) {
-        const uint32_t i = n / width;
-        const uint32_t j = n % width;
-        float const* src = source + channels * n;
-        float* dst = target + channels * (height * j + i);
-        for (uint32_t c = 0; c < channels; ++c) {
-            dst[c] = src[c];
+    // Transpose by tiles, so that both the rows we read and the rows we write stay in the cache.
+    constexpr uint32_t TILE_SIZE = 32;
+    for (uint32_t i0 = 0; i0 < height; i0 += TILE_SIZE) {
+        const uint32_t i1 = std::min(i0 + TILE_SIZE, height);
+        for (uint32_t j0 = 0; j0 < width; j0 += TILE_SIZE) {
+            const uint32_t j1 = std::min(j0 + TILE_SIZE, width);
+            for (uint32_t i = i0; i < i1; ++i) {
+                for (uint32_t j = j0; j < j1; ++j) {
+                    float const* src = source + channels * (size_t(width) * i + j);
+                    float* dst = target + channels * (size_t(height) * j + i);
+                    for (uint32_t c = 0; c < channels; ++c) {
+                        dst[c] = src[c];
+                    }
+                }
+            }
         }
     }
     return result;
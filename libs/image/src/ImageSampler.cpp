@@ -21,6 +21,7 @@
 #include <math/vec3.h>
 #include <math/vec4.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 
 #include <memory>
@@ -131,8 +132,9 @@ void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float ri
     // As an optimization, compute the "filterBound", which is the half-width of the filter within
     // the [0,1] domain. If this were a huge number, the filtered results would look the same, but
     // the filter would perform very poorly because it would be iterating over a lot more samples
-    // than necessary.
-    const float filterBounds = domainScale * std::abs(filter.boundingRadius);
+    // than necessary. Filter function arguments are distances scaled by domainScale, so the bound
+    // is the radius divided by that scale.
+    const float filterBounds = std::abs(filter.boundingRadius) / domainScale;
 
     // Iterate through target samples. "xtarget" points to the center of each target pixel.
     float xtarget = dtarget / 2.0f;
@@ -143,9 +145,18 @@ void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float ri
         uint32_t count = 0;
         float sum = 0;
 
-        // Iterate through source samples that lie within the bounded region.
-        const auto isource_lower = int32_t((xtarget - filterBounds) * nsource);
-        const auto isource_upper = int32_t(std::ceil((xtarget + filterBounds) * nsource));
+        // Iterate through source samples that lie within the bounded region, which is mapped to
+        // source indices through the source range. The nearest filter has no extent, it picks the
+        // source samples at the target center.
+        int32_t isource_lower = int32_t(xtarget * nsource);
+        int32_t isource_upper = int32_t(std::ceil(xtarget * nsource));
+        if (filterBounds > 0) {
+            const float range = right - left;
+            isource_lower = int32_t(std::floor(
+                    (left + (xtarget - filterBounds) * range) * nsource - 0.5f));
+            isource_upper = int32_t(std::ceil(
+                    (left + (xtarget + filterBounds) * range) * nsource - 0.5f));
+        }
         for (int32_t isource = isource_lower; isource <= isource_upper; ++isource) {
             const float xsource = (((isource + 0.5f) / nsource) - left) / (right - left);
             const bool outside_image = isource < 0 || isource >= int32_t(nsource);
@@ -190,6 +201,62 @@ void expandMadProgram(uint32_t nchannels, MadProgram* program) {
     program->swap(result);
 }
 
+// A MAD program where the instructions of each target sample are replaced by a contiguous range
+// of source samples and their weights. Source samples that the filter skipped in that range get
+// a zero weight. This lets us accumulate all the channels of a target sample at once.
+struct PackedMadProgram {
+    struct Target {
+        int32_t firstSource;
+        uint32_t weightCount;
+        uint32_t weightOffset;
+    };
+    std::vector<Target> targets;
+    std::vector<float> weights;
+};
+
+// Packs a single-channel MAD program, whose instructions are ordered by target index.
+void packMadProgram(uint32_t ntarget, MadProgram const& program, PackedMadProgram* result) {
+    result->targets.assign(ntarget, { 0, 0, 0 });
+    result->weights.clear();
+    for (size_t i = 0, n = program.size(); i < n;) {
+        const uint32_t itarget = program[i].targetIndex;
+        size_t end = i + 1;
+        while (end < n && program[end].targetIndex == itarget) {
+            ++end;
+        }
+        const int32_t first = program[i].sourceIndex;
+        const int32_t last = program[end - 1].sourceIndex;
+        auto& target = result->targets[itarget];
+        target.firstSource = first;
+        target.weightCount = uint32_t(last - first + 1);
+        target.weightOffset = uint32_t(result->weights.size());
+        result->weights.resize(result->weights.size() + target.weightCount, 0.0f);
+        for (; i < end; ++i) {
+            result->weights[target.weightOffset + program[i].sourceIndex - first] =
+                    program[i].weight;
+        }
+    }
+}
+
+template<uint32_t NCHAN>
+void executePackedMadProgram(PackedMadProgram const& program, uint32_t nchan,
+        float const* UTILS_RESTRICT sourceRow, float* UTILS_RESTRICT targetRow) {
+    // NCHAN is 0 when the channel count isn't known at compile time
+    const uint32_t channels = NCHAN ? NCHAN : nchan;
+    float const* const weights = program.weights.data();
+    for (auto const& target : program.targets) {
+        float const* UTILS_RESTRICT source = sourceRow + target.firstSource * channels;
+        float const* UTILS_RESTRICT w = weights + target.weightOffset;
+        for (uint32_t k = 0; k < target.weightCount; ++k, source += channels) {
+            const float weight = w[k];
+            for (uint32_t c = 0; c < channels; ++c) {
+                targetRow[c] += source[c] * weight;
+            }
+        }
+        targetRow += channels;
+    }
+}
+
 FilterFunction createFilterFunction(Filter ftype) {
     FilterFunction fn;
     switch (ftype) {
@@ -227,7 +294,8 @@ void normalize(LinearImage& image) {
 }
 
 LinearImage resampleImage1D(const LinearImage& source, MadProgram* program,
-        uint32_t twidth, Filter filter, float left, float right, float filterRadiusMultiplier) {
+        uint32_t twidth, Filter filter, float left, float right, float filterRadiusMultiplier,
+        utils::JobSystem* js = nullptr) {
     const uint32_t swidth = source.getWidth();
     const uint32_t sheight = source.getHeight();
     const uint32_t nchan = source.getChannels();
@@ -238,7 +306,6 @@ LinearImage resampleImage1D(const LinearImage& source, MadProgram* program,
     // Generate a flat list of multiply-add (MAD) instructions.
     program->clear();
     generateMadProgram(twidth, swidth, left, right, hfn, filterRadiusMultiplier, program);
-    expandMadProgram(nchan, program);
 
     // Allocate the target image.
     LinearImage result(twidth, sheight, nchan);
@@ -247,6 +314,7 @@ LinearImage resampleImage1D(const LinearImage& source, MadProgram* program,
 
     // The MIN filter is special because it starts with non-zero values and ignores filter weights.
     if (filter == Filter::MINIMUM) {
+        expandMadProgram(nchan, program);
         for (uint32_t n = 0; n < twidth * sheight * nchan; ++n) {
             targetRow[n] = std::numeric_limits<float>::max();
         }
@@ -262,13 +330,30 @@ LinearImage resampleImage1D(const LinearImage& source, MadProgram* program,
         return result;
     }
 
-    // Resize the image horizontally by executing the MAD instructions over each row.
-    for (uint32_t row = 0; row < sheight; ++row) {
-        for (auto mad : *program) {
-            targetRow[mad.targetIndex] += sourceRow[mad.sourceIndex] * mad.weight;
+    // Resize the image horizontally by executing the MAD instructions over each row. Rows are
+    // independent, so they're split across jobs if a JobSystem is given.
+    PackedMadProgram packed;
+    packMadProgram(twidth, *program, &packed);
+    auto execute = [&packed, nchan, sourceRow, targetRow, swidth, twidth](
+            uint32_t first, uint32_t count) {
+        for (uint32_t row = first; row < first + count; ++row) {
+            float const* const source = sourceRow + size_t(row) * swidth * nchan;
+            float* const target = targetRow + size_t(row) * twidth * nchan;
+            switch (nchan) {
+                case 1: executePackedMadProgram<1>(packed, nchan, source, target); break;
+                case 2: executePackedMadProgram<2>(packed, nchan, source, target); break;
+                case 3: executePackedMadProgram<3>(packed, nchan, source, target); break;
+                case 4: executePackedMadProgram<4>(packed, nchan, source, target); break;
+                default: executePackedMadProgram<0>(packed, nchan, source, target); break;
+            }
         }
-        targetRow += twidth * nchan;
-        sourceRow += swidth * nchan;
+    };
+    if (js && sheight > 1) {
+        auto* job = utils::jobs::parallel_for(*js, nullptr, 0, sheight,
+                std::cref(execute), utils::jobs::CountSplitter<16, 8>());
+        js->runAndWait(job);
+    } else {
+        execute(0, sheight);
     }
 
     // Perform post processing for the current pass.
@@ -299,10 +384,11 @@ LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t he
     const float top = sampler.sourceRegion.top;
     const float right = sampler.sourceRegion.right;
     const float bottom = sampler.sourceRegion.bottom;
+    utils::JobSystem* const js = sampler.jobSystem;
     MadProgram program;
     LinearImage result;
-    result = transpose(resampleImage1D(source, &program, width, hfilter, left, right, radius));
-    result = transpose(resampleImage1D(result, &program, height, vfilter, top, bottom, radius));
+    result = transpose(resampleImage1D(source, &program, width, hfilter, left, right, radius, js));
+    result = transpose(resampleImage1D(result, &program, height, vfilter, top, bottom, radius, js));
     return result;
 }
 
@@ -337,14 +423,19 @@ void computeSingleSample(const LinearImage& source, float x, float y, SingleSamp
 // Generates the given number of mipmaps (not including the base level) using the given filter.
 // Unlike traditional mipmap generation, our implementation generates all levels from the original
 // image, under the premise that this produces a higher quality result.
-void generateMipmaps(const LinearImage& source, Filter filter, LinearImage* result, uint32_t mips) {
+void generateMipmaps(const LinearImage& source, Filter filter, LinearImage* result, uint32_t mips,
+        utils::JobSystem* js) {
     mips = std::min(mips, getMipmapCount(source));
     uint32_t width = source.getWidth();
     uint32_t height = source.getHeight();
     for (uint32_t n = 0; n < mips; ++n) {
         width = std::max(width >> 1u, 1u);
         height = std::max(height >> 1u, 1u);
-        result[n] = resampleImage(source, width, height, filter);
+        result[n] = resampleImage(source, width, height, ImageSampler {
+            .horizontalFilter = filter,
+            .verticalFilter = filter,
+            .jobSystem = js
+        });
     }
 }
 
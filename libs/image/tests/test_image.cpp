@@ -26,6 +26,7 @@
 
 #include <gtest/gtest.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 #include <utils/Path.h>
 
@@ -259,6 +260,32 @@ TEST_F(ImageTest, DepthFilters) { // NOLINT
     updateOrCompare(atlas, "depths.png");
 }
 
+TEST_F(ImageTest, ParallelResample) { // NOLINT
+    LinearImage source(97, 61, 3);
+    float* data = source.getPixelRef();
+    for (uint32_t n = 0; n < 97 * 61 * 3; ++n) {
+        data[n] = float(n % 17) / 16.0f;
+    }
+    utils::JobSystem js;
+    js.adopt();
+    for (Filter filter : { Filter::BOX, Filter::LANCZOS, Filter::MITCHELL, Filter::MINIMUM }) {
+        for (uint32_t size : { 13u, 200u }) {
+            LinearImage serial = resampleImage(source, size, size / 2, filter);
+            LinearImage parallel = resampleImage(source, size, size / 2, ImageSampler {
+                .horizontalFilter = filter,
+                .verticalFilter = filter,
+                .jobSystem = &js
+            });
+            float const* a = serial.getPixelRef();
+            float const* b = parallel.getPixelRef();
+            for (uint32_t n = 0; n < size * (size / 2) * 3; ++n) {
+                ASSERT_EQ(a[n], b[n]);
+            }
+        }
+    }
+    js.emancipate();
+}
+
 TEST_F(ImageTest, ImageOps) { // NOLINT
     auto finalize = [] (LinearImage image) {
         return resampleImage(image, 100, 100, Filter::NEAREST);
@@ -98,9 +98,14 @@ public:
         Builder& normals(bool enabled) noexcept;
 
         /**
-         * Initializes the basis encoder with the given number of jobs.
+         * Initializes the basis encoder with the given number of jobs. Zero uses one job per
+         * hardware thread.
          *
-         * default value: 4
+         * BasisU runs these jobs on its own thread pool, which splits each image into slices.
+         * Several encoders can be built and run concurrently, e.g. one per texture, in which case
+         * the job count of each should be lowered accordingly.
+         *
+         * default value: 0
          */
         Builder& jobs(size_t count) noexcept;
 
@@ -20,6 +20,10 @@
 #include <image/ImageOps.h>
 #include <utils/debug.h>
 
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Warray-bounds"
 #include <basisu_comp.h>
@@ -29,13 +33,33 @@ namespace image {
 
 using Builder = BasisEncoder::Builder;
 
+// The BasisU encoder library has global state, it is initialized when the first encoder is built
+// and released with the last one, so that several encoders can be used concurrently.
+static std::mutex sLibraryMutex;
+static size_t sLibraryRefCount = 0;
+
+static void acquireLibrary() {
+    std::lock_guard<std::mutex> lock(sLibraryMutex);
+    if (sLibraryRefCount++ == 0) {
+        basisu::basisu_encoder_init();
+    }
+}
+
+static void releaseLibrary() {
+    std::lock_guard<std::mutex> lock(sLibraryMutex);
+    assert_invariant(sLibraryRefCount > 0);
+    if (--sLibraryRefCount == 0) {
+        basisu::basisu_encoder_deinit();
+    }
+}
+
 struct BasisEncoderBuilderImpl {
     basisu::basis_compressor_params params = {};
     bool grayscale = false;
     bool linear = false;
     bool normals = false;
     bool quiet = false;
-    size_t jobs = 4;
+    size_t jobs = 0;
     bool error = false;
 };
 
@@ -156,12 +180,16 @@ BasisEncoder* Builder::build() {
         return nullptr;
     }
 
-    basisu::basisu_encoder_init();
+    acquireLibrary();
 
     auto& params = mImpl->params;
 
+    const size_t jobCount = mImpl->jobs ? mImpl->jobs :
+            std::max(1u, std::thread::hardware_concurrency());
+
     params.m_status_output = !mImpl->quiet;
-    params.m_pJob_pool = new basisu::job_pool(mImpl->jobs);
+    params.m_multithreading = jobCount > 1;
+    params.m_pJob_pool = new basisu::job_pool(jobCount);
     params.m_create_ktx2_file = true;
     params.m_ktx2_uastc_supercompression = basist::KTX2_SS_ZSTANDARD;
 
@@ -188,6 +216,9 @@ BasisEncoder* Builder::build() {
     if (!encoder->init(params)) {
         assert_invariant(false);
         delete encoder;
+        delete params.m_pJob_pool;
+        params.m_pJob_pool = nullptr;
+        releaseLibrary();
         return nullptr;
     }
 
@@ -201,10 +232,13 @@ BasisEncoder* Builder::build() {
 BasisEncoder::BasisEncoder(BasisEncoderImpl* impl) noexcept : mImpl(impl) {}
 
 BasisEncoder::~BasisEncoder() noexcept {
+    if (!mImpl) {
+        return;
+    }
     delete mImpl->encoder;
     delete mImpl->jobs;
     delete mImpl;
-    basisu::basisu_encoder_deinit();
+    releaseLibrary();
 }
 
 BasisEncoder::BasisEncoder(BasisEncoder&& that) noexcept  : mImpl(nullptr) {
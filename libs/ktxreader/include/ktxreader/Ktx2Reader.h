@@ -24,6 +24,10 @@
 
 #include <utils/FixedCapacityVector.h>
 
+namespace utils {
+class JobSystem;
+} // namespace utils
+
 namespace filament {
     class Engine;
 }
@@ -126,15 +130,22 @@ class Ktx2Reader {
             /**
              * Loads all mipmaps from the KTX2 file and transcodes them to the resolved format.
              *
-             * This does not return until all mipmaps have been transcoded. This is typically
-             * called from a background thread.
+             * Mipmaps are transcoded from the smallest to the largest. This does not return until
+             * all mipmaps have been transcoded. This is typically called from a background thread.
              */
             Result doTranscoding();
 
+            /**
+             * Same as doTranscoding() but each mipmap is transcoded in its own job. This can be
+             * called from within a job of the given job system.
+             */
+            Result doTranscoding(utils::JobSystem& js);
+
             /**
              * Uploads pending mipmaps to the texture.
              *
-             * This can safely be called while doTranscoding() is still working in another thread.
+             * This can safely be called while doTranscoding() is still working in another thread,
+             * and can be called repeatedly to upload each mipmap as soon as it is transcoded.
              * Since this calls Texture::setImage(), it should be called from the foreground thread;
              * see "Thread safety" in the documentation for filament::Engine.
              */
@@ -19,6 +19,7 @@
 #include <filament/Engine.h>
 #include <filament/Texture.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Log.h>
 
 #include <atomic>
@@ -169,7 +170,7 @@ public:
             mTexture(texture), mEngine(engine), mTranscoder(transcoder),
             mSourceBuffer(std::move(buf)) {}
     Texture* getTexture() const noexcept { return mTexture; }
-    Result doTranscoding();
+    Result doTranscoding(utils::JobSystem* js);
     void uploadImages();
 
 protected:
@@ -178,9 +179,11 @@ protected:
 private:
     using TranscoderResult = std::atomic<Texture::PixelBufferDescriptor*>;
 
+    Result transcodeLevel(uint32_t levelIndex);
+
     // After each level is transcoded, the results are stashed in the following array until the
     // foreground thread calls uploadImages(). Each slot in the array corresponds to a single
-    // miplevel in the texture.
+    // miplevel in the texture. Slots are filled from the smallest miplevel to the largest.
     TranscoderResult mTranscoderResults[KTX2_MAX_SUPPORTED_LEVEL_COUNT] = {};
 
     Texture* const mTexture;
@@ -272,19 +275,49 @@ FAsync::~FAsync() {
     }
 }
 
-Result FAsync::doTranscoding() {
+Result FAsync::transcodeLevel(uint32_t levelIndex) {
+    // Each level gets its own transcoder state, which is what allows levels to be transcoded
+    // concurrently.
     ktx2_transcoder_state basisThreadState;
     basisThreadState.clear();
-    for (uint32_t levelIndex = 0, n = mTranscoder->get_levels(); levelIndex < n; levelIndex++) {
-        Texture::PixelBufferDescriptor* pbd;
-        Result result = transcodeImageLevel(*mTranscoder, basisThreadState, mTexture->getFormat(),
-                levelIndex, &pbd);
-        if (UTILS_UNLIKELY(result != Result::SUCCESS)) {
-            return result;
-        }
+    Texture::PixelBufferDescriptor* pbd;
+    Result result = transcodeImageLevel(*mTranscoder, basisThreadState, mTexture->getFormat(),
+            levelIndex, &pbd);
+    if (UTILS_LIKELY(result == Result::SUCCESS)) {
         mTranscoderResults[levelIndex].store(pbd);
     }
-    return Result::SUCCESS;
+    return result;
+}
+
+Result FAsync::doTranscoding(utils::JobSystem* js) {
+    const uint32_t levelCount = mTranscoder->get_levels();
+
+    // The smallest levels are transcoded first because they are the cheapest, this lets
+    // uploadImages() hand them over to the texture while the larger levels are still in flight.
+    if (!js || levelCount < 2) {
+        for (uint32_t levelIndex = levelCount; levelIndex-- > 0;) {
+            Result result = transcodeLevel(levelIndex);
+            if (UTILS_UNLIKELY(result != Result::SUCCESS)) {
+                return result;
+            }
+        }
+        return Result::SUCCESS;
+    }
+
+    std::atomic<Result> status{ Result::SUCCESS };
+    utils::JobSystem::Job* parent = js->createJob();
+    for (uint32_t levelIndex = levelCount; levelIndex-- > 0;) {
+        utils::JobSystem::Job* job = utils::jobs::createJob(*js, parent,
+                [this, levelIndex, &status]() {
+                    Result result = transcodeLevel(levelIndex);
+                    if (UTILS_UNLIKELY(result != Result::SUCCESS)) {
+                        status.store(result, std::memory_order_relaxed);
+                    }
+                });
+        js->run(job);
+    }
+    js->runAndWait(parent);
+    return status.load(std::memory_order_relaxed);
 }
 
 void FAsync::uploadImages() {
@@ -431,7 +464,11 @@ Texture* Async::getTexture() const noexcept {
 }
 
 Result Async::doTranscoding() {
-    return static_cast<FAsync*>(this)->doTranscoding();
+    return static_cast<FAsync*>(this)->doTranscoding(nullptr);
+}
+
+Result Async::doTranscoding(utils::JobSystem& js) {
+    return static_cast<FAsync*>(this)->doTranscoding(&js);
 }
 
 void Async::uploadImages() {
@@ -193,6 +193,56 @@ constexpr MATRIX MATH_PURE fastInverse3(const MATRIX& x) {
     return inverted;
 }
 
+//------------------------------------------------------------------------------
+// Inverse of a 4x4 affine matrix, i.e. one whose last row is [0 0 0 1], which is the case of all
+// transforms. The upper-left 3x3 block is inverted analytically as above, and the translation is
+// mapped through it. This is branch-free and several times cheaper than gaussJordanInverse().
+template<typename MATRIX>
+constexpr MATRIX MATH_PURE fastAffineInverse4(const MATRIX& x) {
+    typedef typename MATRIX::value_type T;
+
+    MATRIX inverted{};
+
+    const T a = x[0][0];
+    const T b = x[1][0];
+    const T c = x[2][0];
+    const T d = x[0][1];
+    const T e = x[1][1];
+    const T f = x[2][1];
+    const T g = x[0][2];
+    const T h = x[1][2];
+    const T i = x[2][2];
+
+    const T A = e * i - f * h;
+    const T B = f * g - d * i;
+    const T C = d * h - e * g;
+    const T det(a * A + b * B + c * C);
+    inverted[0][0] = A / det;
+    inverted[0][1] = B / det;
+    inverted[0][2] = C / det;
+    inverted[1][0] = (c * h - b * i) / det;
+    inverted[1][1] = (a * i - c * g) / det;
+    inverted[1][2] = (b * g - a * h) / det;
+    inverted[2][0] = (b * f - c * e) / det;
+    inverted[2][1] = (c * d - a * f) / det;
+    inverted[2][2] = (a * e - b * d) / det;
+
+    for (size_t row = 0; row < 3; ++row) {
+        inverted[3][row] = -(inverted[0][row] * x[3][0] +
+                             inverted[1][row] * x[3][1] +
+                             inverted[2][row] * x[3][2]);
+        inverted[row][3] = 0;
+    }
+    inverted[3][3] = 1;
+
+    return inverted;
+}
+
+template<typename MATRIX>
+constexpr bool MATH_PURE isAffine4(const MATRIX& x) {
+    typedef typename MATRIX::value_type T;
+    return x[0][3] == T(0) && x[1][3] == T(0) && x[2][3] == T(0) && x[3][3] == T(1);
+}
 
 //------------------------------------------------------------------------------
 // Determinant and cofactor
@@ -401,7 +451,9 @@ template<typename MATRIX,
 inline constexpr MATRIX MATH_PURE inverse(const MATRIX& matrix) {
     return (MATRIX::NUM_ROWS == 2) ? fastInverse2<MATRIX>(matrix) :
            ((MATRIX::NUM_ROWS == 3) ? fastInverse3<MATRIX>(matrix) :
-            gaussJordanInverse<MATRIX>(matrix));
+           ((MATRIX::NUM_ROWS == 4 && isAffine4<MATRIX>(matrix)) ?
+                   fastAffineInverse4<MATRIX>(matrix) :
+                   gaussJordanInverse<MATRIX>(matrix)));
 }
 
 template<typename MATRIX_R, typename MATRIX_A, typename MATRIX_B,
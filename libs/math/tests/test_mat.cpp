@@ -288,6 +288,28 @@ TEST_F(MatTest, MiscOps) {
     }
 }
 
+TEST_F(MatTest, AffineInverse) {
+    const mat4 m = mat4::translation(double3(1, -2, 3)) *
+            mat4::rotation(0.7, normalize(double3(1, 2, 3))) * mat4::scaling(double3(2, 3, -4));
+    const mat4 affine = inverse(m);
+    const mat4 general = details::matrix::gaussJordanInverse(m);
+    for (size_t c = 0; c < 4; c++) {
+        for (size_t r = 0; r < 4; r++) {
+            EXPECT_NEAR(general[c][r], affine[c][r], 1e-12);
+        }
+    }
+    EXPECT_EQ(double4(0, 0, 0, 1), transpose(affine)[3]);
+
+    // Projections are not affine and go through the general inverse.
+    const mat4 p = mat4::perspective(45.0, 1.5, 0.1, 100.0);
+    const mat4 pi = inverse(p) * p;
+    for (size_t c = 0; c < 4; c++) {
+        for (size_t r = 0; r < 4; r++) {
+            EXPECT_NEAR(c == r ? 1.0 : 0.0, pi[c][r], 1e-12);
+        }
+    }
+}
+
 TEST_F(MatTest, ElementAccess) {
     mat4 m(double4(1, 2, 3, 4), double4(5, 6, 7, 8), double4(9, 10, 11, 12), double4(13, 14, 15, 16));
     for (size_t c=0 ; c<4 ; c++) {
@@ -17,17 +17,31 @@
 #ifndef UBERZ_READABLE_ARCHIVE_H
 #define UBERZ_READABLE_ARCHIVE_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include <uberz/ArchiveEnums.h>
 
 #include <filament/MaterialEnums.h>
 
+#include <utils/FixedCapacityVector.h>
+
+struct ZSTD_DDict_s;
+
 namespace filament::uberz {
 
-// ArchiveSpec is a parse-free binary format. The client simply casts a word-aligned content blob
-// into a ReadableArchive struct pointer, then calls the following function to convert all the
-// offset fields into pointers.
+// An archive is a sequence of zstd frames:
+//
+// - The index: a ReadableArchive followed by its specs, flags and flag names, the lists of blobs
+//   that make up each package and the blob table. This is a parse-free binary format, the client
+//   simply casts the decompressed, word-aligned index into a ReadableArchive struct pointer, then
+//   calls the following function to convert all the offset fields into pointers.
+// - The dictionary, a package of the archive that the blobs are compressed against.
+// - The blobs. Each chunk of a package is a blob, and identical chunks of different packages are
+//   stored only once. Each blob is a separate frame, so that the packages can be decompressed
+//   individually.
+//
+// ArchiveReader does all of this.
 void convertOffsetsToPointers(struct ReadableArchive* archive);
 
 UTILS_WARNING_PUSH
@@ -37,6 +51,8 @@ UTILS_WARNING_ENABLE_PADDED
 // This is the readable counterpart to WriteableArchive.
 // Used by gltfio; users do not need to access this class directly.
 struct ReadableArchive {
+    static constexpr uint32_t VERSION = 1;
+
     uint32_t magic;
     uint32_t version;
     uint64_t specsCount;
@@ -44,6 +60,13 @@ struct ReadableArchive {
         struct ArchiveSpec* specs;
         uint64_t specsOffset;
     };
+    uint64_t blobsCount;
+    union {
+        struct ArchiveBlob* blobs;
+        uint64_t blobsOffset;
+    };
+    // uncompressed size of the dictionary
+    uint64_t dictionaryByteCount;
 };
 
 static constexpr Shading INVALID_SHADING_MODEL = (Shading) 0xff;
@@ -58,10 +81,19 @@ struct ArchiveSpec {
         struct ArchiveFlag* flags;
         uint64_t flagsOffset;
     };
+    // indices of the blobs that make up the package, in order
     union {
-        uint8_t* package;
-        uint64_t packageOffset;
+        uint32_t* blobIndices;
+        uint64_t blobIndicesOffset;
     };
+    uint64_t blobIndicesCount;
+};
+
+struct ArchiveBlob {
+    // offset of the compressed blob from the start of the first blob frame
+    uint64_t offset;
+    uint32_t compressedByteCount;
+    uint32_t byteCount;
 };
 
 struct ArchiveFlag {
@@ -74,6 +106,32 @@ struct ArchiveFlag {
 
 UTILS_WARNING_POP
 
+// Decompresses the index of an archive when it is created, and the packages on demand. It keeps a
+// copy of the compressed archive, which is much smaller than the packages it holds.
+class ArchiveReader {
+public:
+    // Panics if the data isn't a valid archive.
+    ArchiveReader(const void* archiveData, size_t archiveByteCount);
+    ~ArchiveReader();
+
+    ArchiveReader(ArchiveReader const&) = delete;
+    ArchiveReader& operator=(ArchiveReader const&) = delete;
+
+    ReadableArchive const& getArchive() const noexcept { return *mArchive; }
+
+    // Decompresses the package of the given spec. The dictionary is decompressed by the first
+    // call and kept until the reader is destroyed.
+    utils::FixedCapacityVector<uint8_t> getPackage(size_t specIndex);
+
+private:
+    ReadableArchive* mArchive;
+    utils::FixedCapacityVector<uint8_t> mData;
+    // offset of the dictionary frame in mData, and of the first blob frame
+    size_t mDictionaryOffset;
+    size_t mBlobsOffset;
+    ZSTD_DDict_s* mDictionary = nullptr;
+};
+
 } // namespace filament::uberz
 
 #endif // UBERZ_READABLE_ARCHIVE_H
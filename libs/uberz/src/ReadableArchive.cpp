@@ -16,16 +16,24 @@
 
 #include <uberz/ReadableArchive.h>
 
+#include <utils/Panic.h>
+#include <utils/compiler.h>
 #include <utils/debug.h>
+#include <utils/memalign.h>
+
+#include <zstd.h>
+
+#include <string.h>
 
 using namespace filament;
 using namespace utils;
 
 namespace filament::uberz {
 
-static_assert(sizeof(ReadableArchive) == 4 + 4 + 8 + 8);
-static_assert(sizeof(ArchiveSpec) == 1 + 1 + 2 + 4 + 8 + 8);
+static_assert(sizeof(ReadableArchive) == 4 + 4 + 8 + 8 + 8 + 8 + 8);
+static_assert(sizeof(ArchiveSpec) == 1 + 1 + 2 + 4 + 8 + 8 + 8);
 static_assert(sizeof(ArchiveFlag) == 8 + 8);
+static_assert(sizeof(ArchiveBlob) == 8 + 4 + 4);
 
 void convertOffsetsToPointers(ReadableArchive* archive) {
     constexpr size_t wordSize = sizeof(uint64_t);
@@ -36,12 +44,81 @@ void convertOffsetsToPointers(ReadableArchive* archive) {
         ArchiveSpec& spec = archive->specs[i];
         assert_invariant(spec.flagsOffset % wordSize == 0);
         spec.flags = (ArchiveFlag*) (basePointer + (spec.flagsOffset / wordSize));
-        spec.package = ((uint8_t*) basePointer) + spec.packageOffset;
+        spec.blobIndices = (uint32_t*) (((uint8_t*) basePointer) + spec.blobIndicesOffset);
         for (uint64_t j = 0; j < spec.flagsCount; ++j) {
             ArchiveFlag& flag = spec.flags[j];
             flag.name = ((const char*) basePointer) + flag.nameOffset;
         }
     }
+    assert_invariant(archive->blobsOffset % wordSize == 0);
+    archive->blobs = (ArchiveBlob*) (basePointer + archive->blobsOffset / wordSize);
+}
+
+ArchiveReader::ArchiveReader(const void* archiveData, size_t archiveByteCount)
+        : mData(archiveByteCount) {
+    memcpy(mData.data(), archiveData, archiveByteCount);
+
+    const uint64_t indexSize = ZSTD_getFrameContentSize(mData.data(), mData.size());
+    if (indexSize == ZSTD_CONTENTSIZE_UNKNOWN || indexSize == ZSTD_CONTENTSIZE_ERROR) {
+        PANIC_POSTCONDITION("Decompression error.");
+    }
+    mDictionaryOffset = ZSTD_findFrameCompressedSize(mData.data(), mData.size());
+    if (ZSTD_isError(mDictionaryOffset)) {
+        PANIC_POSTCONDITION("Decompression error.");
+    }
+    size_t const dictionaryFrameSize = ZSTD_findFrameCompressedSize(
+            mData.data() + mDictionaryOffset, mData.size() - mDictionaryOffset);
+    if (ZSTD_isError(dictionaryFrameSize)) {
+        PANIC_POSTCONDITION("Decompression error.");
+    }
+    mBlobsOffset = mDictionaryOffset + dictionaryFrameSize;
+
+    mArchive = (ReadableArchive*) utils::aligned_alloc(indexSize, 8);
+    ZSTD_decompress(mArchive, indexSize, mData.data(), mDictionaryOffset);
+    if (mArchive->magic != 'UBER' || mArchive->version != ReadableArchive::VERSION) {
+        utils::aligned_free(mArchive);
+        PANIC_POSTCONDITION("Unsupported archive, it must be rebuilt with this version of uberz.");
+    }
+    convertOffsetsToPointers(mArchive);
+}
+
+ArchiveReader::~ArchiveReader() {
+    ZSTD_freeDDict(mDictionary);
+    utils::aligned_free(mArchive);
+}
+
+FixedCapacityVector<uint8_t> ArchiveReader::getPackage(size_t specIndex) {
+    assert_invariant(specIndex < mArchive->specsCount);
+
+    if (UTILS_UNLIKELY(!mDictionary)) {
+        FixedCapacityVector<uint8_t> dictionary(mArchive->dictionaryByteCount);
+        size_t const result = ZSTD_decompress(dictionary.data(), dictionary.size(),
+                mData.data() + mDictionaryOffset, mBlobsOffset - mDictionaryOffset);
+        if (ZSTD_isError(result)) {
+            PANIC_POSTCONDITION("Decompression error: %s", ZSTD_getErrorName(result));
+        }
+        mDictionary = ZSTD_createDDict(dictionary.data(), dictionary.size());
+    }
+
+    ArchiveSpec const& spec = mArchive->specs[specIndex];
+    FixedCapacityVector<uint8_t> package(spec.packageByteCount);
+    ZSTD_DCtx* const context = ZSTD_createDCtx();
+    uint8_t* cursor = package.data();
+    for (uint64_t i = 0; i < spec.blobIndicesCount; ++i) {
+        ArchiveBlob const& blob = mArchive->blobs[spec.blobIndices[i]];
+        assert_invariant(cursor + blob.byteCount <= package.data() + package.size());
+        size_t const result = ZSTD_decompress_usingDDict(context, cursor, blob.byteCount,
+                mData.data() + mBlobsOffset + blob.offset, blob.compressedByteCount,
+                mDictionary);
+        if (ZSTD_isError(result)) {
+            ZSTD_freeDCtx(context);
+            PANIC_POSTCONDITION("Decompression error: %s", ZSTD_getErrorName(result));
+        }
+        cursor += blob.byteCount;
+    }
+    ZSTD_freeDCtx(context);
+    assert_invariant(cursor == package.data() + package.size());
+    return package;
 }
 
 } // namespace filament::uberz
@@ -19,8 +19,11 @@
 
 #include <zstd.h>
 
+#include <algorithm>
 #include <string_view>
+#include <vector>
 
+#include <utils/Hash.h>
 #include <utils/Log.h>
 
 using namespace utils;
@@ -226,7 +229,58 @@ void WritableArchive::addSpecLine(string_view line) {
     ++mLineNumber;
 }
 
+// Splits a package into its chunks, see filaflat::ChunkContainer, and calls the given function
+// with the range of each chunk, header included. Data that isn't a sequence of chunks is passed
+// as a single range.
+template<typename F>
+static void forEachChunk(const FixedCapacityVector<uint8_t>& package, F f) {
+    constexpr size_t headerSize = sizeof(uint64_t) + sizeof(uint32_t);
+    size_t offset = 0;
+    while (offset + headerSize <= package.size()) {
+        uint32_t size;
+        memcpy(&size, package.data() + offset + sizeof(uint64_t), sizeof(size));
+        if (size > package.size() - offset - headerSize) {
+            break;
+        }
+        offset += headerSize + size;
+    }
+    if (offset != package.size()) {
+        f(package.data(), package.size());
+        return;
+    }
+    for (offset = 0; offset < package.size(); ) {
+        uint32_t size;
+        memcpy(&size, package.data() + offset + sizeof(uint64_t), sizeof(size));
+        f(package.data() + offset, headerSize + size);
+        offset += headerSize + size;
+    }
+}
+
 FixedCapacityVector<uint8_t> WritableArchive::serialize() const {
+    // Build the blob store, identical chunks of different packages are stored once.
+    struct Blob {
+        const uint8_t* data;
+        size_t size;
+    };
+    std::vector<Blob> blobs;
+    tsl::robin_map<uint32_t, std::vector<uint32_t>> blobsByHash;
+    auto blobIndices = FixedCapacityVector<std::vector<uint32_t>>(mMaterials.size());
+    for (size_t i = 0; i < mMaterials.size(); ++i) {
+        forEachChunk(mMaterials[i].package, [&](const uint8_t* data, size_t size) {
+            uint32_t const hash = utils::hash::murmurSlow(data, size, 0);
+            std::vector<uint32_t>& candidates = blobsByHash[hash];
+            auto pos = std::find_if(candidates.begin(), candidates.end(), [&](uint32_t index) {
+                return blobs[index].size == size && !memcmp(blobs[index].data, data, size);
+            });
+            if (pos == candidates.end()) {
+                candidates.push_back(uint32_t(blobs.size()));
+                pos = candidates.end() - 1;
+                blobs.push_back({ data, size });
+            }
+            blobIndices[i].push_back(*pos);
+        });
+    }
+
     size_t byteCount = sizeof(ReadableArchive);
     for (const auto& mat : mMaterials) {
         byteCount += sizeof(ArchiveSpec);
@@ -243,29 +297,38 @@ FixedCapacityVector<uint8_t> WritableArchive::serialize() const {
             byteCount += pair.first.size() + 1;
         }
     }
-    size_t filamatOffset = byteCount;
-    for (const auto& mat : mMaterials) {
-        byteCount += mat.package.size();
+    size_t blobIndicesOffset = byteCount;
+    for (const auto& indices : blobIndices) {
+        byteCount += indices.size() * sizeof(uint32_t);
     }
+    // the blob table is made of 64-bit words
+    byteCount = (byteCount + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+    size_t const blobsOffset = byteCount;
+    byteCount += blobs.size() * sizeof(ArchiveBlob);
 
-    ReadableArchive archive;
+    ReadableArchive archive = {};
     archive.magic = 'UBER';
-    archive.version = 0;
+    archive.version = ReadableArchive::VERSION;
     archive.specsCount = mMaterials.size();
     archive.specsOffset = sizeof(ReadableArchive);
+    archive.blobsCount = blobs.size();
+    archive.blobsOffset = blobsOffset;
+    archive.dictionaryByteCount = mMaterials.empty() ? 0 : mMaterials[0].package.size();
 
     auto specs = FixedCapacityVector<ArchiveSpec>::with_capacity(mMaterials.size());
     size_t flagCount = 0;
-    for (const auto& mat : mMaterials) {
+    for (size_t i = 0; i < mMaterials.size(); ++i) {
+        const auto& mat = mMaterials[i];
         ArchiveSpec spec = {};
         spec.shadingModel = mat.shadingModel;
         spec.blendingMode = mat.blendingMode;
         spec.flagsCount = mat.flags.size();
         spec.flagsOffset = flaglistOffset + flagCount * sizeof(ArchiveFlag);
         spec.packageByteCount = mat.package.size();
-        spec.packageOffset = filamatOffset;
+        spec.blobIndicesOffset = blobIndicesOffset;
+        spec.blobIndicesCount = blobIndices[i].size();
         specs.push_back(spec);
-        filamatOffset += mat.package.size();
+        blobIndicesOffset += blobIndices[i].size() * sizeof(uint32_t);
         flagCount += mat.flags.size();
     }
 
@@ -291,6 +354,39 @@ FixedCapacityVector<uint8_t> WritableArchive::serialize() const {
     }
     assert(flagNamesPtr - flagNames.data() == flagNames.size());
 
+    // Maximum zstd compression is slow, but that's okay since uberz is invoked during the build,
+    // not at run time.  However in debug builds it is debilitatingly slow, and we're fine with
+    // larger archives, so we use minimum compression.
+#ifdef NDEBUG
+    const int compressionLevel = ZSTD_maxCLevel();
+#else
+    const int compressionLevel = ZSTD_minCLevel();
+#endif
+
+    // Each blob is compressed separately so that packages can be decompressed individually. They
+    // use the first package as a dictionary, which contains most of what the others have in
+    // common. Their offsets go in the index, so they are compressed first.
+    const uint8_t* const dictionary = mMaterials.empty() ? nullptr : mMaterials[0].package.data();
+    ZSTD_CDict* const cdict = ZSTD_createCDict(dictionary, archive.dictionaryByteCount,
+            compressionLevel);
+    ZSTD_CCtx* const cctx = ZSTD_createCCtx();
+    auto blobTable = FixedCapacityVector<ArchiveBlob>::with_capacity(blobs.size());
+    std::vector<uint8_t> compressedBlobs;
+    for (const Blob& blob : blobs) {
+        size_t const offset = compressedBlobs.size();
+        compressedBlobs.resize(offset + ZSTD_compressBound(blob.size));
+        size_t zstdResult = ZSTD_compress_usingCDict(cctx, compressedBlobs.data() + offset,
+                compressedBlobs.size() - offset, blob.data, blob.size, cdict);
+        if (ZSTD_isError(zstdResult)) {
+            PANIC_POSTCONDITION("Error during archive compression: %s",
+                    ZSTD_getErrorName(zstdResult));
+        }
+        compressedBlobs.resize(offset + zstdResult);
+        blobTable.push_back({ offset, uint32_t(zstdResult), uint32_t(blob.size) });
+    }
+    ZSTD_freeCCtx(cctx);
+    ZSTD_freeCDict(cdict);
+
     FixedCapacityVector<uint8_t> outputBuf(byteCount);
     uint8_t* writeCursor = outputBuf.data();
     memcpy(writeCursor, &archive, sizeof(archive));
@@ -301,30 +397,39 @@ FixedCapacityVector<uint8_t> WritableArchive::serialize() const {
     writeCursor += sizeof(ArchiveFlag) * flags.size();
     memcpy(writeCursor, flagNames.data(), charCount);
     writeCursor += charCount;
-    for (const auto& mat : mMaterials) {
-        memcpy(writeCursor, mat.package.data(), mat.package.size());
-        writeCursor += mat.package.size();
+    for (const auto& indices : blobIndices) {
+        memcpy(writeCursor, indices.data(), indices.size() * sizeof(uint32_t));
+        writeCursor += indices.size() * sizeof(uint32_t);
     }
+    writeCursor = outputBuf.data() + blobsOffset;
+    memcpy(writeCursor, blobTable.data(), sizeof(ArchiveBlob) * blobTable.size());
+    writeCursor += sizeof(ArchiveBlob) * blobTable.size();
     assert_invariant(writeCursor - outputBuf.data() == outputBuf.size());
 
-    FixedCapacityVector<uint8_t> compressedBuf(ZSTD_compressBound(outputBuf.size()));
+    // the archive is the compressed index, followed by the dictionary and the blobs
+    size_t const indexBound = ZSTD_compressBound(outputBuf.size());
+    size_t const dictionaryBound = ZSTD_compressBound(archive.dictionaryByteCount);
+    FixedCapacityVector<uint8_t> compressedBuf(
+            indexBound + dictionaryBound + compressedBlobs.size());
 
-    // Maximum zstd compression is slow, but that's okay since uberz is invoked during the build,
-    // not at run time.  However in debug builds it is debilitatingly slow, and we're fine with
-    // larger archives, so we use minimum compression.
-#ifdef NDEBUG
-    const int compressionLevel = ZSTD_maxCLevel();
-#else
-    const int compressionLevel = ZSTD_minCLevel();
-#endif
-
-    size_t zstdResult = ZSTD_compress(compressedBuf.data(), compressedBuf.size(), outputBuf.data(),
+    size_t zstdResult = ZSTD_compress(compressedBuf.data(), indexBound, outputBuf.data(),
             outputBuf.size(), compressionLevel);
     if (ZSTD_isError(zstdResult)) {
         PANIC_POSTCONDITION("Error during archive compression: %s", ZSTD_getErrorName(zstdResult));
     }
+    size_t compressedSize = zstdResult;
+
+    zstdResult = ZSTD_compress(compressedBuf.data() + compressedSize, dictionaryBound,
+            dictionary, archive.dictionaryByteCount, compressionLevel);
+    if (ZSTD_isError(zstdResult)) {
+        PANIC_POSTCONDITION("Error during archive compression: %s", ZSTD_getErrorName(zstdResult));
+    }
+    compressedSize += zstdResult;
+
+    memcpy(compressedBuf.data() + compressedSize, compressedBlobs.data(), compressedBlobs.size());
+    compressedSize += compressedBlobs.size();
 
-    compressedBuf.resize(zstdResult);
+    compressedBuf.resize(compressedSize);
     return compressedBuf;
 }
 
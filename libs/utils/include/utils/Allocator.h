@@ -178,11 +178,13 @@ public:
  * LinearAllocatorWithFallback
  *
  * This is a LinearAllocator that falls back to a HeapAllocator when allocation fail. The Heap
- * allocator memory is freed only when the LinearAllocator is reset or destroyed.
+ * allocator memory is freed only when the LinearAllocator is reset, destroyed or rewound to its
+ * beginning.
  * ------------------------------------------------------------------------------------------------
  */
 class LinearAllocatorWithFallback : private LinearAllocator, private HeapAllocator {
     std::vector<void*> mHeapAllocations;
+    size_t mHeapSize = 0;
 public:
     LinearAllocatorWithFallback(void* begin, void* end) noexcept
         : LinearAllocator(begin, end) {
@@ -197,20 +199,26 @@ public:
         LinearAllocatorWithFallback::reset();
     }
 
-    void* alloc(size_t size, size_t alignment = alignof(std::max_align_t));
+    void* alloc(size_t size, size_t alignment = alignof(std::max_align_t), size_t extra = 0);
 
     void *getCurrent() noexcept {
         return LinearAllocator::getCurrent();
     }
 
     void rewind(void* p) noexcept {
-        if (p >= LinearAllocator::base() && p < LinearAllocator::end()) {
+        if (UTILS_UNLIKELY(p == LinearAllocator::base())) {
+            // everything was allocated after p, including the heap allocations
+            reset();
+        } else if (p >= LinearAllocator::base() && p < LinearAllocator::end()) {
             LinearAllocator::rewind(p);
         }
     }
 
     void reset() noexcept;
 
+    // total size of the heap allocations
+    size_t getHeapSize() const noexcept { return mHeapSize; }
+
     void free(void*, size_t) noexcept { }
 
     bool isHeapAllocation(void* p) const noexcept {
@@ -635,6 +643,7 @@ struct DebugAndHighWatermark : protected HighWatermark, protected Debug {
     DebugAndHighWatermark() noexcept = default;
     DebugAndHighWatermark(const char* name, void* base, size_t size) noexcept
             : HighWatermark(name, base, size), Debug(name, base, size) { }
+    using HighWatermark::getHighWatermark;
     void onAlloc(void* p, size_t size, size_t alignment, size_t extra) noexcept {
         HighWatermark::onAlloc(p, size, alignment, extra);
         Debug::onAlloc(p, size, alignment, extra);
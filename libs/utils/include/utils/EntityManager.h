@@ -22,12 +22,21 @@
 
 #include <assert.h>
 #include <stddef.h>
+
+#include <atomic>
 #include <stdint.h>
 
 #ifndef FILAMENT_UTILS_TRACK_ENTITIES
 #define FILAMENT_UTILS_TRACK_ENTITIES false
 #endif
 
+// Number of bits of an Entity used for its index, which sets the maximum number of entities that
+// can exist at the same time to 2^FILAMENT_UTILS_ENTITY_INDEX_BITS - 1. The remaining bits hold
+// its generation. This must be the same for all the code using utils.
+#ifndef FILAMENT_UTILS_ENTITY_INDEX_BITS
+#define FILAMENT_UTILS_ENTITY_INDEX_BITS 17
+#endif
+
 #if FILAMENT_UTILS_TRACK_ENTITIES
 #include <utils/ostream.h>
 #include <vector>
@@ -80,7 +89,8 @@ public:
     // Thread safe.
     bool isAlive(Entity e) const noexcept {
         assert(getIndex(e) < RAW_INDEX_COUNT);
-        return (!e.isNull()) && (getGeneration(e) == mGens[getIndex(e)]);
+        return (!e.isNull()) &&
+                (getGeneration(e) == mGens[getIndex(e)].load(std::memory_order_relaxed));
     }
 
     // Registers a listener to be called when an entity is destroyed. Thread safe.
@@ -90,12 +100,20 @@ public:
     // unregisters a listener.
     void unregisterListener(Listener* l) noexcept;
 
+    // Reads up to `count` of the entities destroyed since `cursor`, in the order they were
+    // destroyed, and advances `cursor` past them. `count` receives the number of entities read.
+    // This lets a component manager find the components it needs to remove without a listener.
+    // A cursor starts at 0. Only the last few thousands destructions are kept: if some entities
+    // destroyed since `cursor` were dropped, this returns false and moves `cursor` to the latest
+    // destruction. Thread safe.
+    bool readDestroyedEntities(uint64_t& cursor, Entity* entities, size_t& count) const noexcept;
+
 
     /* no user serviceable parts below */
 
     // current generation of the given index. Use for debugging and testing.
     uint8_t getGenerationForIndex(size_t index) const noexcept {
-        return mGens[index];
+        return mGens[index].load(std::memory_order_relaxed);
     }
 
     // singleton, can't be copied
@@ -114,7 +132,9 @@ private:
 
     // GENERATION_SHIFT determines how many simultaneous Entities are available, the
     // minimum memory requirement is 2^GENERATION_SHIFT bytes.
-    static constexpr const int GENERATION_SHIFT = 17;
+    static constexpr const int GENERATION_SHIFT = FILAMENT_UTILS_ENTITY_INDEX_BITS;
+    static_assert(GENERATION_SHIFT >= 12 && GENERATION_SHIFT <= 24,
+            "the generation must have at least 8 bits");
     static constexpr const size_t RAW_INDEX_COUNT = (1 << GENERATION_SHIFT);
     static constexpr const Entity::Type INDEX_MASK = (1 << GENERATION_SHIFT) - 1u;
 
@@ -129,7 +149,7 @@ private:
     }
 
     // stores the generation of each index.
-    uint8_t * const mGens;
+    std::atomic<uint8_t>* const mGens;
 };
 
 } // namespace utils
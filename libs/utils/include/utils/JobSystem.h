@@ -32,6 +32,7 @@
 
 #include <atomic>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <type_traits>
 #include <thread>
@@ -44,15 +45,56 @@
 namespace utils {
 
 class JobSystem {
-    static constexpr size_t MAX_JOB_COUNT = 16384;
-    static_assert(MAX_JOB_COUNT <= 0x7FFE, "MAX_JOB_COUNT must be <= 0x7FFE");
-    using WorkQueue = WorkStealingDequeue<uint16_t, MAX_JOB_COUNT>;
+    // Jobs are allocated from segments, which are only created once the previous ones are full.
+    static constexpr size_t JOB_SEGMENT_SIZE = 16384;
+    static constexpr size_t MAX_JOB_SEGMENT_COUNT = 16;
+    static constexpr size_t MAX_JOB_COUNT = JOB_SEGMENT_SIZE * MAX_JOB_SEGMENT_COUNT;
+    static_assert(MAX_JOB_COUNT < 0x3FFFFFFF, "MAX_JOB_COUNT must be < 0x3FFFFFFF");
+
+    // A thread's queue can't hold all the jobs, when it's full jobs run immediately instead.
+    static constexpr size_t WORK_QUEUE_SIZE = 16384;
+    using WorkQueue = WorkStealingDequeue<uint32_t, WORK_QUEUE_SIZE>;
+
+    // Size of the linear part of each thread's scratch arena, larger needs fall back to the heap.
+    static constexpr size_t SCRATCH_ARENA_SIZE = 256 * 1024;
 
 public:
     class Job;
 
     using JobFunc = void(*)(void*, JobSystem&, Job*);
 
+    /*
+     * Jobs are queued in one of two lanes. Threads always pick up DEFAULT jobs (e.g. frame-critical
+     * work) before BACKGROUND jobs (e.g. texture decoding or streaming), and a thread waiting on
+     * a DEFAULT job only helps with DEFAULT jobs, so that it is never held up by background work.
+     * Jobs are created in the lane of their parent.
+     */
+    enum class Lane : uint8_t {
+        DEFAULT,
+        BACKGROUND
+    };
+
+    /*
+     * Each thread of the JobSystem (including adopted threads) has a scratch arena for temporary
+     * allocations, which avoids contending on malloc when many jobs run in parallel. Everything a
+     * job allocates from it is released when the job returns, so these allocations must not
+     * outlive the job (e.g. they can't be handed to child jobs that aren't waited on).
+     * Allocations made outside of a job should use an ArenaScope<ScratchArena>.
+     *
+     *   auto& scratch = JobSystem::getScratchArena();
+     *   ScratchVector<float> temp(scratch);
+     */
+    using ScratchArena = Arena<LinearAllocatorWithFallback, LockingPolicy::NoLock>;
+
+    template<typename T>
+    using ScratchAllocator = STLAllocator<T, ScratchArena>;
+
+    template<typename T>
+    using ScratchVector = std::vector<T, ScratchAllocator<T>>;
+
+    // Returns the scratch arena of the calling thread, which must be owned by a JobSystem.
+    static ScratchArena& getScratchArena() noexcept;
+
     class alignas(CACHELINE_SIZE) Job {
     public:
         Job() noexcept {} /* = default; */ /* clang bug */ // NOLINT(modernize-use-equals-default,cppcoreguidelines-pro-type-member-init)
@@ -74,10 +116,12 @@ public:
                                                                 // v7 | v8
         void* storage[JOB_STORAGE_SIZE_WORDS];                  // 48 | 48
         JobFunc function;                                       //  4 |  8
-        uint16_t parent;                                        //  2 |  2
+        uint32_t parent : 30;                                   //  4 |  4
+        uint32_t lane : 1;              // a Lane
+        uint32_t hasContinuation : 1;   // see runAfter()
         std::atomic<uint16_t> runningJobCount = { 1 };          //  2 |  2
         mutable std::atomic<uint16_t> refCount = { 1 };         //  2 |  2
-                                                                //  6 |  2 (padding)
+                                                                //  4 |  0 (padding)
                                                                 // 64 | 64
     };
 
@@ -93,6 +137,10 @@ public:
     // adopt more thread.
     void emancipate();
 
+    // Returns true if the current thread is part of the thread pool, i.e. if it is one of its
+    // worker threads or if it was adopted.
+    bool isThreadOwned() noexcept;
+
 
     // If a parent is not specified when creating a job, that job will automatically take the
     // root job as a parent.
@@ -255,6 +303,32 @@ public:
         run(p);
     }
 
+    // Same as run() but first moves the job to the given lane, see Lane.
+    void run(Job*& job, Lane lane) noexcept;
+    void run(Job*&& job, Lane lane) noexcept {
+        Job* p = job;
+        run(p, lane);
+    }
+
+    /*
+     * Adds job to the execution queue of the thread that completes "dependency", once it and
+     * all its children have completed. Nobody has to wait in between, so a sequence of steps can
+     * be written as a chain of jobs without blocking a thread of the pool, e.g.:
+     *
+     *   runAfter(createJob(parent, step2), step1);
+     *   run(step1);
+     *
+     * "dependency" must not have been run yet, and can only have one continuation. Until it has
+     * completed, the job counts as a child of its own parent, as usual.
+     *
+     * The job can't be used after this call.
+     */
+    void runAfter(Job*& job, Job* dependency) noexcept;
+    void runAfter(Job*&& job, Job* dependency) noexcept {
+        Job* p = job;
+        runAfter(p, dependency);
+    }
+
     void signal() noexcept;
 
     /*
@@ -264,6 +338,7 @@ public:
      * This job MUST BE waited on with wait(), or released with release().
      */
     Job* runAndRetain(Job* job) noexcept;
+    Job* runAndRetain(Job* job, Lane lane) noexcept;
 
     /*
      * Wait on a job and destroys it.
@@ -312,6 +387,16 @@ public:
 
     size_t getThreadCount() const { return mThreadCount; }
 
+    /*
+     * Returns how many jobs couldn't be created, because too many jobs were pending, or
+     * couldn't be queued, because the queue of their thread was full. The former are usually run
+     * by their creator instead (e.g. parallel_for() stops splitting), the latter are run
+     * immediately by run().
+     */
+    size_t getOverflowCount() const noexcept {
+        return mOverflowCount.load(std::memory_order_relaxed);
+    }
+
 private:
     // this is just to avoid using std::default_random_engine, since we're in a public header.
     class default_random_engine {
@@ -329,12 +414,17 @@ private:
     struct alignas(CACHELINE_SIZE) ThreadState {    // this causes 40-bytes padding
         // make sure storage is cache-line aligned
         WorkQueue workQueue;
+        alignas(CACHELINE_SIZE)         // same padding as above
+        WorkQueue backgroundQueue;
 
         // these are not accessed by the worker threads
         alignas(CACHELINE_SIZE)         // this causes 56-bytes padding
         JobSystem* js;                  // this is in fact const and always initialized
         std::thread thread;             // unused for adopted threads
         default_random_engine rndGen;
+        uint64_t cpuMask = 0;           // cores the thread runs on, 0 for no affinity
+        bool preferBackground = false;  // background jobs first, for slower cores
+        std::unique_ptr<ScratchArena> scratch;
     };
 
     static_assert(sizeof(ThreadState) % CACHELINE_SIZE == 0,
@@ -342,25 +432,42 @@ private:
 
     ThreadState& getState() noexcept;
 
+    static WorkQueue& getQueue(ThreadState& state, Lane lane) noexcept {
+        return lane == Lane::BACKGROUND ? state.backgroundQueue : state.workQueue;
+    }
+
+    static void setThreadAffinityByMask(uint64_t mask) noexcept;
+    static uint64_t getLittleCores(uint64_t* bigCores) noexcept;
+
     static void incRef(Job const* job) noexcept;
     void decRef(Job const* job) noexcept;
 
     Job* allocateJob() noexcept;
+    Job* allocateJobSlow(uint32_t segmentCount) noexcept;
+    uint32_t getJobIndex(Job const* job) const noexcept;
+    Job* getJob(uint32_t index) const noexcept {
+        return mJobSegments[index / JOB_SEGMENT_SIZE]->base + index % JOB_SEGMENT_SIZE;
+    }
     JobSystem::ThreadState* getStateToStealFrom(JobSystem::ThreadState& state) noexcept;
     static bool hasJobCompleted(Job const* job) noexcept;
 
     void requestExit() noexcept;
     bool exitRequested() const noexcept;
     bool hasActiveJobs() const noexcept;
+    bool hasActiveJobs(Lane lane) const noexcept;
 
     void loop(ThreadState* state) noexcept;
-    bool execute(JobSystem::ThreadState& state) noexcept;
-    Job* steal(JobSystem::ThreadState& state) noexcept;
+    bool execute(JobSystem::ThreadState& state, bool includeBackground = true) noexcept;
+    Job* take(JobSystem::ThreadState& state, Lane lane) noexcept;
+    Job* steal(JobSystem::ThreadState& state, Lane lane) noexcept;
+    void call(ThreadState& state, Job* job) noexcept;
     void finish(Job* job) noexcept;
+    void runContinuation(Job const* job) noexcept;
 
-    void put(WorkQueue& workQueue, Job* job) noexcept;
-    Job* pop(WorkQueue& workQueue) noexcept;
-    Job* steal(WorkQueue& workQueue) noexcept;
+    void put(ThreadState& state, Job* job) noexcept;
+    Job* pop(WorkQueue& workQueue, Lane lane) noexcept;
+    Job* steal(WorkQueue& workQueue, Lane lane) noexcept;
+    void wakeForLane(Lane lane, int32_t activeJobs) noexcept;
 
     void wait(std::unique_lock<Mutex>& lock, Job* job = nullptr) noexcept;
     void wake(size_t hint) noexcept;
@@ -370,8 +477,9 @@ private:
     utils::Mutex mWaiterLock;
     utils::Condition mWaiterCondition;
 
-    std::atomic<int32_t> mActiveJobs = { 0 };
-    utils::Arena<utils::ThreadSafeObjectPoolAllocator<Job>, LockingPolicy::NoLock> mJobPool;
+    std::atomic<int32_t> mActiveJobs[2] = { 0, 0 };         // by Lane
+    std::atomic<uint32_t> mJobSegmentCount = { 0 };
+    std::atomic<uint32_t> mOverflowCount = { 0 };
 
     template <typename T>
     using aligned_vector = std::vector<T, utils::STLAlignedAllocator<T>>;
@@ -386,11 +494,22 @@ private:
     aligned_vector<ThreadState> mThreadStates;          // actual data is stored offline
     std::atomic<bool> mExitRequested = { false };       // this one is almost never written
     std::atomic<uint16_t> mAdoptedThreads = { 0 };      // this one is almost never written
-    Job* const mJobStorageBase;                         // Base for conversion to indices
     uint16_t mThreadCount = 0;                          // total # of threads in the pool
     uint8_t mParallelSplitCount = 0;                    // # of split allowable in parallel_for
     Job* mRootJob = nullptr;
 
+    struct JobSegment {
+        explicit JobSegment(const char* name) noexcept;
+        utils::Arena<utils::ThreadSafeObjectPoolAllocator<Job>, LockingPolicy::NoLock> pool;
+        Job* const base;                                // for conversion to indices
+    };
+    // Only the first mJobSegmentCount entries are set, they never change after that.
+    std::unique_ptr<JobSegment> mJobSegments[MAX_JOB_SEGMENT_COUNT];
+    utils::Mutex mJobSegmentLock;                       // only taken to add a segment
+
+    utils::Mutex mContinuationLock;
+    tsl::robin_map<Job const*, Job*> mContinuations;    // see runAfter()
+
     utils::Mutex mThreadMapLock; // this should have very little contention
     tsl::robin_map<std::thread::id, ThreadState *> mThreadMap;
 };
@@ -23,7 +23,11 @@
 #include <utils/EntityInstance.h>
 #include <utils/SingleInstanceComponentManager.h>
 
+#include <string_view>
+#include <unordered_map>
+
 #include <stddef.h>
+#include <stdint.h>
 
 namespace utils {
 
@@ -47,7 +51,7 @@ class EntityManager;
  * printf("%s\n", names->getName(names->getInstance(myEntity));
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  */
-class UTILS_PUBLIC NameComponentManager : private SingleInstanceComponentManager<utils::CString> {
+class UTILS_PUBLIC NameComponentManager : private SingleInstanceComponentManager<const char*> {
 public:
     using Instance = EntityInstance<NameComponentManager>;
 
@@ -86,21 +90,31 @@ public:
 
     /**
      * Stores a copy of the given string and associates it with the given instance.
+     *
+     * Names are interned: entities with equal names share a single copy of the string.
      */
     void setName(Instance instance, const char* name) noexcept;
 
     /**
      * Retrieves the string associated with the given instance, or nullptr if none exists.
      *
-     * @return pointer to the copy that was made during setName()
+     * @return pointer to the copy that was made during setName(), it stays valid until the name of
+     * the instance changes or its component is removed.
      */
     const char* getName(Instance instance) const noexcept;
 
     void gc(EntityManager& em) noexcept {
-        SingleInstanceComponentManager<utils::CString>::gc(em, [this](Entity e) {
+        SingleInstanceComponentManager<const char*>::gc(em, [this](Entity e) {
             removeComponent(e);
         });
     }
+
+private:
+    const char* acquire(const char* name);
+    void release(const char* name) noexcept;
+
+    // the interned names and how many instances use them
+    std::unordered_map<std::string_view, uint32_t> mNames;
 };
 
 } // namespace utils
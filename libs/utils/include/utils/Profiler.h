@@ -32,6 +32,10 @@
 #endif
 
 #include <utils/compiler.h>
+#include <utils/CString.h>
+
+#include <atomic>
+#include <vector>
 
 namespace utils {
 
@@ -103,6 +107,16 @@ public:
             return lhs;
         }
 
+        friend Counters operator+(Counters lhs, const Counters& rhs) noexcept {
+            lhs.nr = rhs.nr;    // this is the number of counters
+            lhs.time_enabled += rhs.time_enabled;
+            lhs.time_running += rhs.time_running;
+            for (size_t i = 0; i < EVENT_COUNT; ++i) {
+                lhs.counters[i].value += rhs.counters[i].value;
+            }
+            return lhs;
+        }
+
     public:
         uint64_t getInstructions() const        { return counters[INSTRUCTIONS].value; }
         uint64_t getCpuCycles() const           { return counters[CPU_CYCLES].value; }
@@ -210,6 +224,71 @@ private:
     uint32_t mEnabledEvents = 0;
 };
 
+/*
+ * Aggregates the hardware counters and the wall time of named regions, across all threads.
+ *
+ * Regions are delimited by Scope objects, which the SYSTRACE_NAME() and SYSTRACE_CALL() macros
+ * create when FILAMENT_PROFILER_REGIONS is set (see Systrace.h). Their cost is a relaxed atomic
+ * load until enable() is called. Nested regions are included in their parent's counts.
+ *
+ * Perf counters only count the thread that opened them, so each thread opens its own the first
+ * time it enters a region. Where perf counters aren't available, only the number of times each
+ * region was entered and the wall time are reported.
+ */
+class RegionProfiler {
+public:
+    struct Region {
+        CString name;
+        uint64_t count;                                 // number of times the region was entered
+        std::chrono::duration<uint64_t, std::nano> duration;    // total wall time
+        Profiler::Counters counters;                    // totals of all the entries
+    };
+
+    // Starts aggregating regions, using the given Profiler events. Doesn't reset the regions.
+    static void enable(uint32_t eventMask = Profiler::EV_CPU_CYCLES |
+            Profiler::EV_L1D_RATES | Profiler::EV_BPU_MISSES) noexcept;
+
+    static void disable() noexcept;
+
+    static bool isEnabled() noexcept {
+        return sEnabled.load(std::memory_order_relaxed);
+    }
+
+    // Returns the regions entered since the last reset(), sorted by decreasing duration.
+    static std::vector<Region> getRegions();
+
+    static void reset() noexcept;
+
+    class Scope {
+    public:
+        explicit Scope(const char* name) noexcept : mName(isEnabled() ? name : nullptr) {
+            if (UTILS_UNLIKELY(mName)) {
+                begin();
+            }
+        }
+
+        ~Scope() noexcept {
+            if (UTILS_UNLIKELY(mName)) {
+                end();
+            }
+        }
+
+        Scope(Scope const&) = delete;
+        Scope& operator=(Scope const&) = delete;
+
+    private:
+        void begin() noexcept;
+        void end() noexcept;
+
+        const char* mName;
+        std::chrono::steady_clock::time_point mStart;
+        Profiler::Counters mCounters{};
+    };
+
+private:
+    static std::atomic_bool sEnabled;
+};
+
 } // namespace utils
 
 #endif // TNT_UTILS_PROFILER_H
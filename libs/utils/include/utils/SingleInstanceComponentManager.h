@@ -46,17 +46,6 @@ class EntityManager;
  */
 template <typename ... Elements>
 class UTILS_PUBLIC SingleInstanceComponentManager {
-private:
-
-    // this is just to avoid using std::default_random_engine, since we're in a public header.
-    class default_random_engine {
-        uint32_t mState = 1u; // must be 0 < seed < 0x7fffffff
-    public:
-        inline uint32_t operator()() noexcept {
-            return mState = uint32_t((uint64_t(mState) * 48271u) % 0x7fffffffu);
-        }
-    };
-
 protected:
     static constexpr size_t ENTITY_INDEX = sizeof ... (Elements);
 
@@ -108,6 +97,12 @@ public:
         return getComponentCount() == 0;
     }
 
+    // Returns a counter that changes whenever components are added, removed or reordered, that
+    // is, whenever an Entity's Instance may have changed.
+    uint32_t getVersion() const noexcept {
+        return mVersion;
+    }
+
     utils::Entity const* getEntities() const noexcept {
         return data<ENTITY_INDEX>() + 1;
     }
@@ -220,46 +215,56 @@ protected:
             if (ej) {
                 map[ej] = j;
             }
+            mVersion++;
         }
     }
 
+    // Calls removeComponent() for each component whose entity was destroyed since the last call.
+    // This only looks at the entities destroyed in the meantime, using the EntityManager's
+    // journal, unless there were too many of them, in which case all components are checked.
     template<typename REMOVE>
     void gc(const EntityManager& em,
             REMOVE&& removeComponent) noexcept {
-        gc(em, 4, std::forward<REMOVE>(removeComponent));
+        constexpr size_t BATCH_SIZE = 64;
+        Entity destroyed[BATCH_SIZE];
+        size_t count;
+        do {
+            count = BATCH_SIZE;
+            if (UTILS_UNLIKELY(!em.readDestroyedEntities(mDestroyedCursor, destroyed, count))) {
+                gcAll(em, removeComponent);
+                return;
+            }
+            for (size_t i = 0; i < count; i++) {
+                if (hasComponent(destroyed[i])) {
+                    removeComponent(destroyed[i]);
+                }
+            }
+        } while (count == BATCH_SIZE);
     }
 
+protected:
+    SoA mData;
+
+private:
     template<typename REMOVE>
-    void gc(const EntityManager& em, size_t ratio,
-            REMOVE&& removeComponent) noexcept {
-        Entity const* const pEntities = begin<ENTITY_INDEX>();
-        size_t count = getComponentCount();
-        size_t aliveInARow = 0;
-        default_random_engine& rng = mRng;
-        UTILS_NOUNROLL
-        while (count && aliveInARow < ratio) {
-            assert_invariant(count == getComponentCount());
-            // note: using the modulo favorizes lower number
-            size_t const i = rng() % count;
-            Entity const entity = pEntities[i];
-            assert_invariant(entity);
+    void gcAll(const EntityManager& em, REMOVE& removeComponent) noexcept {
+        Instance i = begin();
+        while (i < end()) {
+            Entity const entity = getEntity(i);
             if (UTILS_LIKELY(em.isAlive(entity))) {
-                ++aliveInARow;
+                i++;
                 continue;
             }
+            // this moves the last component to i, which we look at next
             removeComponent(entity);
-            aliveInARow = 0;
-            count--;
         }
     }
 
-protected:
-    SoA mData;
-
-private:
     // maps an entity to an instance index
     tsl::robin_map<Entity, Instance, Entity::Hasher> mInstanceMap;
-    default_random_engine mRng;
+    // position in the EntityManager's journal of destroyed entities
+    uint64_t mDestroyedCursor = 0;
+    uint32_t mVersion = 0;
 };
 
 // Keep these outside of the class because CLion has trouble parsing them
@@ -274,6 +279,7 @@ SingleInstanceComponentManager<Elements ...>::addComponent(Entity e) {
             // index 0 is used when the component doesn't exist
             ci = Instance(mData.size() - 1);
             mInstanceMap[e] = ci;
+            mVersion++;
         } else {
             // if the entity already has this component, just return its instance
             ci = mInstanceMap[e];
@@ -305,6 +311,7 @@ SingleInstanceComponentManager<Elements ... >::removeComponent(Entity e) {
         }
         mData.pop_back();
         map.erase(pos);
+        mVersion++;
         return last;
     }
     return 0;
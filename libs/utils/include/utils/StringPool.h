@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_UTILS_STRINGPOOL_H
+#define TNT_UTILS_STRINGPOOL_H
+
+#include <utils/compiler.h>
+
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include <stddef.h>
+
+namespace utils {
+
+/**
+ * \class StringPool StringPool.h utils/StringPool.h
+ * \brief An arena of interned, immutable, null-terminated strings.
+ *
+ * intern() returns the same pointer for equal strings, which can therefore be compared (and used
+ * as ids) by address. The strings are packed into large blocks and are only freed when the pool
+ * is destroyed, so StringPool is meant for data that lives as long as its owner, e.g. the names
+ * of a loaded asset shared by all its instances.
+ */
+class UTILS_PUBLIC StringPool {
+public:
+    explicit StringPool(size_t blockSize = 4096) noexcept;
+    ~StringPool() noexcept;
+
+    StringPool(StringPool const& rhs) = delete;
+    StringPool& operator=(StringPool const& rhs) = delete;
+    StringPool(StringPool&& rhs) noexcept;
+    StringPool& operator=(StringPool&& rhs) noexcept;
+
+    /**
+     * Returns the pooled copy of the given string, storing it if it's not already in the pool.
+     * The returned pointer stays valid until the pool is destroyed. Returns nullptr if str is
+     * nullptr.
+     */
+    const char* intern(const char* str);
+
+    /** Same as intern(const char*), for strings that aren't null-terminated. */
+    const char* intern(std::string_view str);
+
+    /** Number of unique strings in the pool. */
+    size_t size() const noexcept { return mStrings.size(); }
+
+    /** Total number of bytes allocated for the strings. */
+    size_t getAllocatedSize() const noexcept { return mAllocatedSize; }
+
+private:
+    char* allocate(size_t size);
+
+    std::unordered_set<std::string_view> mStrings;
+    std::vector<std::unique_ptr<char[]>> mBlocks;
+    char* mCurrent = nullptr;
+    size_t mAvailable = 0;
+    size_t mBlockSize;
+    size_t mAllocatedSize = 0;
+};
+
+} // namespace utils
+
+#endif // TNT_UTILS_STRINGPOOL_H
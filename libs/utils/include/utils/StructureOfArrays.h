@@ -19,6 +19,7 @@
 
 #include <type_traits>
 #include <utils/Allocator.h>
+#include <utils/architecture.h>
 #include <utils/compiler.h>
 #include <utils/debug.h>
 #include <utils/Slice.h>
@@ -37,13 +38,22 @@
 
 namespace utils {
 
-template <typename Allocator, typename ... Elements>
+/*
+ * BATCH_SIZE is the granularity of the capacity of the arrays, which must be a power of two. When
+ * larger than 1, each array is aligned to a cache line and its storage is padded to a multiple of
+ * BATCH_SIZE elements, so that SIMD kernels can process whole batches (see forEachBatch()) with
+ * aligned vector loads and no remainder loop. The padding elements are not constructed, so they
+ * should only be accessed for trivial types, and their content is undefined.
+ */
+template <typename Allocator, size_t BATCH_SIZE, typename ... Elements>
 class StructureOfArraysBase {
     // number of elements
     static constexpr const size_t kArrayCount = sizeof...(Elements);
 
+    static_assert(BATCH_SIZE && !(BATCH_SIZE & (BATCH_SIZE - 1)), "BATCH_SIZE must be a power of 2");
+
 public:
-    using SoA = StructureOfArraysBase<Allocator, Elements...>;
+    using SoA = StructureOfArraysBase<Allocator, BATCH_SIZE, Elements...>;
 
     using Structure = std::tuple<Elements...>;
 
@@ -54,9 +64,13 @@ public:
     // Number of arrays
     static constexpr size_t getArrayCount() noexcept { return kArrayCount; }
 
+    // Number of elements the capacity of each array is a multiple of
+    static constexpr size_t getBatchSize() noexcept { return BATCH_SIZE; }
+
     // Size needed to store "size" array elements
     static size_t getNeededSize(size_t size) noexcept {
-        return getOffset(kArrayCount - 1, size) + sizeof(TypeAt<kArrayCount - 1>) * size;
+        return getOffset(kArrayCount - 1, size) +
+                sizeof(TypeAt<kArrayCount - 1>) * getPaddedCapacity(size);
     }
 
     // --------------------------------------------------------------------------------------------
@@ -275,7 +289,7 @@ public:
         // capacity cannot change when optional storage is specified
         if (capacity >= mSize) {
             // TODO: not entirely sure if "max" of all alignments is always correct
-            constexpr size_t align = std::max({ std::max(alignof(std::max_align_t), alignof(Elements))... });
+            constexpr size_t align = std::max({ getArrayAlignment<Elements>()... });
             const size_t sizeNeeded = getNeededSize(capacity);
             void* buffer = mAllocator.alloc(sizeNeeded, align);
             auto const oldBuffer = std::get<0>(mArrays);
@@ -413,6 +427,17 @@ public:
         });
     }
 
+    // Calls f(first, count) for each batch of N consecutive elements, where count is how many of
+    // them are within size(), i.e. N except maybe for the last batch. All N elements of the last
+    // batch can still be accessed, since N must divide BATCH_SIZE.
+    template<size_t N, typename F>
+    void forEachBatch(F&& f) const {
+        static_assert(N && BATCH_SIZE % N == 0, "N must divide BATCH_SIZE");
+        for (size_t i = 0, c = mSize; i < c; i += N) {
+            f(i, std::min(N, c - i));
+        }
+    }
+
     // return a pointer to the first element of the ElementIndex]th array
     template<size_t ElementIndex>
     TypeAt<ElementIndex>* data() noexcept {
@@ -569,6 +594,17 @@ private:
         mSize = needed;
     }
 
+    static constexpr size_t getPaddedCapacity(size_t capacity) noexcept {
+        return (capacity + (BATCH_SIZE - 1)) & ~(BATCH_SIZE - 1);
+    }
+
+    template<typename T>
+    static constexpr size_t getArrayAlignment() noexcept {
+        // we align each array to at least the same alignment guaranteed by malloc, or to a cache
+        // line if the arrays are processed in batches.
+        return std::max(BATCH_SIZE > 1 ? CACHELINE_SIZE : alignof(std::max_align_t), alignof(T));
+    }
+
     // this calculates the offset adjusted for all data alignment of a given array
     static inline size_t getOffset(size_t index, size_t capacity) noexcept {
         auto offsets = getOffsets(capacity);
@@ -577,10 +613,10 @@ private:
 
     static inline std::array<size_t, kArrayCount> getOffsets(size_t capacity) noexcept {
         // compute the required size of each array
+        capacity = getPaddedCapacity(capacity);
         const size_t sizes[] = { (sizeof(Elements) * capacity)... };
 
-        // we align each array to at least the same alignment guaranteed by malloc
-        constexpr size_t const alignments[] = { std::max(alignof(std::max_align_t), alignof(Elements))... };
+        constexpr size_t const alignments[] = { getArrayAlignment<Elements>()... };
 
         // hopefully most of this gets unrolled and inlined
         std::array<size_t, kArrayCount> offsets;
@@ -667,38 +703,38 @@ private:
 };
 
 
-template<typename Allocator, typename... Elements>
+template<typename Allocator, size_t BATCH_SIZE, typename... Elements>
 inline
-typename StructureOfArraysBase<Allocator, Elements...>::IteratorValueRef&
-StructureOfArraysBase<Allocator, Elements...>::IteratorValueRef::operator=(
+typename StructureOfArraysBase<Allocator, BATCH_SIZE, Elements...>::IteratorValueRef&
+StructureOfArraysBase<Allocator, BATCH_SIZE, Elements...>::IteratorValueRef::operator=(
         StructureOfArraysBase::IteratorValueRef const& rhs) {
     return operator=(IteratorValue(rhs));
 }
 
-template<typename Allocator, typename... Elements>
+template<typename Allocator, size_t BATCH_SIZE, typename... Elements>
 inline
-typename StructureOfArraysBase<Allocator, Elements...>::IteratorValueRef&
-StructureOfArraysBase<Allocator, Elements...>::IteratorValueRef::operator=(
+typename StructureOfArraysBase<Allocator, BATCH_SIZE, Elements...>::IteratorValueRef&
+StructureOfArraysBase<Allocator, BATCH_SIZE, Elements...>::IteratorValueRef::operator=(
         StructureOfArraysBase::IteratorValueRef&& rhs) noexcept {
     return operator=(IteratorValue(rhs));
 }
 
-template<typename Allocator, typename... Elements>
+template<typename Allocator, size_t BATCH_SIZE, typename... Elements>
 template<size_t... Is>
 inline
-typename StructureOfArraysBase<Allocator, Elements...>::IteratorValueRef&
-StructureOfArraysBase<Allocator, Elements...>::IteratorValueRef::assign(
+typename StructureOfArraysBase<Allocator, BATCH_SIZE, Elements...>::IteratorValueRef&
+StructureOfArraysBase<Allocator, BATCH_SIZE, Elements...>::IteratorValueRef::assign(
         StructureOfArraysBase::IteratorValue const& rhs, std::index_sequence<Is...>) {
     // implements IteratorValueRef& IteratorValueRef::operator=(IteratorValue const& rhs)
     auto UTILS_UNUSED l = { (soa->elementAt<Is>(index) = std::get<Is>(rhs.elements), 0)... };
     return *this;
 }
 
-template<typename Allocator, typename... Elements>
+template<typename Allocator, size_t BATCH_SIZE, typename... Elements>
 template<size_t... Is>
 inline
-typename StructureOfArraysBase<Allocator, Elements...>::IteratorValueRef&
-StructureOfArraysBase<Allocator, Elements...>::IteratorValueRef::assign(
+typename StructureOfArraysBase<Allocator, BATCH_SIZE, Elements...>::IteratorValueRef&
+StructureOfArraysBase<Allocator, BATCH_SIZE, Elements...>::IteratorValueRef::assign(
         StructureOfArraysBase::IteratorValue&& rhs, std::index_sequence<Is...>) noexcept {
     // implements IteratorValueRef& IteratorValueRef::operator=(IteratorValue&& rhs) noexcept
     auto UTILS_UNUSED l = {
@@ -707,7 +743,11 @@ StructureOfArraysBase<Allocator, Elements...>::IteratorValueRef::assign(
 }
 
 template <typename ... Elements>
-using StructureOfArrays = StructureOfArraysBase<HeapArena<>, Elements ...>;
+using StructureOfArrays = StructureOfArraysBase<HeapArena<>, 1, Elements ...>;
+
+// A StructureOfArrays whose arrays can be processed in batches of up to BATCH_SIZE elements
+template <size_t BATCH_SIZE, typename ... Elements>
+using BatchedStructureOfArrays = StructureOfArraysBase<HeapArena<>, BATCH_SIZE, Elements ...>;
 
 } // namespace utils
 
@@ -37,6 +37,20 @@
 #define FILAMENT_APPLE_SYSTRACE 0
 #endif
 
+// When set, SYSTRACE_NAME() and SYSTRACE_CALL() also delimit a region of utils::RegionProfiler,
+// on all platforms.
+#ifndef FILAMENT_PROFILER_REGIONS
+#define FILAMENT_PROFILER_REGIONS 0
+#endif
+
+#if FILAMENT_PROFILER_REGIONS
+#include <utils/Profiler.h>
+#define SYSTRACE_REGION(name) \
+        ::utils::RegionProfiler::Scope ___region((SYSTRACE_TAG) ? (name) : nullptr)
+#else
+#define SYSTRACE_REGION(name)
+#endif
+
 #if defined(__ANDROID__)
 #include <utils/android/Systrace.h>
 #elif defined(__APPLE__) && FILAMENT_APPLE_SYSTRACE
@@ -46,11 +60,11 @@
 #define SYSTRACE_ENABLE()
 #define SYSTRACE_DISABLE()
 #define SYSTRACE_CONTEXT()
-#define SYSTRACE_NAME(name)
+#define SYSTRACE_NAME(name) SYSTRACE_REGION(name)
 #define SYSTRACE_FRAME_ID(frame)
 #define SYSTRACE_NAME_BEGIN(name)
 #define SYSTRACE_NAME_END()
-#define SYSTRACE_CALL()
+#define SYSTRACE_CALL() SYSTRACE_NAME(__FUNCTION__)
 #define SYSTRACE_ASYNC_BEGIN(name, cookie)
 #define SYSTRACE_ASYNC_END(name, cookie)
 #define SYSTRACE_VALUE32(name, val)
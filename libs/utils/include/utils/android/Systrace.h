@@ -43,7 +43,8 @@
 // the correct start and end times this macro should be declared first in the
 // scope body.
 // It also automatically creates a Systrace context
-#define SYSTRACE_NAME(name) ::utils::details::ScopedTrace ___tracer(SYSTRACE_TAG, name)
+#define SYSTRACE_NAME(name) ::utils::details::ScopedTrace ___tracer(SYSTRACE_TAG, name); \
+        SYSTRACE_REGION(name)
 
 // Denotes that a new frame has started processing.
 #define SYSTRACE_FRAME_ID(frame) \
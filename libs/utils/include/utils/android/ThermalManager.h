@@ -49,6 +49,11 @@ public:
 
     ThermalStatus getCurrentThermalStatus() const noexcept;
 
+    // Returns the forecast thermal headroom in forecastSeconds (0 to 10), where 0 means no
+    // throttling and 1.0 means severe throttling, or NaN if it's not supported (before Android
+    // 12). Calling this more often than once per second may return NaN.
+    float getThermalHeadroom(int forecastSeconds) const noexcept;
+
 private:
     AThermalManager* mThermalManager = nullptr;
 };
@@ -59,11 +59,20 @@ void LinearAllocator::swap(LinearAllocator& rhs) noexcept {
 // LinearAllocatorWithFallback
 // ------------------------------------------------------------------------------------------------
 
-void* LinearAllocatorWithFallback::alloc(size_t size, size_t alignment) {
-    void* p = LinearAllocator::alloc(size, alignment);
+void* LinearAllocatorWithFallback::alloc(size_t size, size_t alignment, size_t extra) {
+    void* p = LinearAllocator::alloc(size, alignment, extra);
     if (UTILS_UNLIKELY(!p)) {
-        p = HeapAllocator::alloc(size, alignment);
-        mHeapAllocations.push_back(p);
+        // rewind(base()) frees the heap allocations, so make sure a scope started after this
+        // allocation can't rewind to base()
+        if (LinearAllocator::getCurrent() == LinearAllocator::base()) {
+            LinearAllocator::alloc(1, 1);
+        }
+        // keep `extra` bytes before the returned pointer, like LinearAllocator does
+        size_t const offset = (extra + alignment - 1) & ~(alignment - 1);
+        void* const q = HeapAllocator::alloc(size + offset, alignment);
+        mHeapAllocations.push_back(q);
+        mHeapSize += size + offset;
+        p = pointermath::add(q, offset);
     }
     assert_invariant(p);
     return p;
@@ -75,6 +84,7 @@ void LinearAllocatorWithFallback::reset() noexcept {
         HeapAllocator::free(p);
     }
     mHeapAllocations.clear();
+    mHeapSize = 0;
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -160,6 +170,8 @@ void TrackingPolicy::HighWatermark::onAlloc(
 }
 
 TrackingPolicy::HighWatermark::~HighWatermark() noexcept {
+#ifndef NDEBUG
+    // the high watermark is also tracked on release builds, but only reported on debug builds
     const size_t wm = mHighWaterMark;
     if (mSize > 0) {
         size_t wmpct = wm / (mSize / 100);
@@ -170,6 +182,7 @@ TrackingPolicy::HighWatermark::~HighWatermark() noexcept {
     } else {
         slog.d << mName << " arena: High watermark " << wm / 1024 << " KiB" << io::endl;
     }
+#endif
 }
 
 void TrackingPolicy::HighWatermark::onFree(void* p, size_t size) noexcept {
@@ -25,9 +25,8 @@ namespace utils {
 EntityManager::Listener::~Listener() noexcept = default;
 
 EntityManager::EntityManager()
-        : mGens(new uint8_t[RAW_INDEX_COUNT]) {
-    // initialize all the generations to 0
-    std::fill_n(mGens, RAW_INDEX_COUNT, 0);
+        // all the generations start at 0
+        : mGens(new std::atomic<uint8_t>[RAW_INDEX_COUNT]()) {
 }
 
 EntityManager::~EntityManager() {
@@ -57,6 +56,12 @@ void EntityManager::unregisterListener(EntityManager::Listener* l) noexcept {
     static_cast<EntityManagerImpl *>(this)->unregisterListener(l);
 }
 
+bool EntityManager::readDestroyedEntities(uint64_t& cursor, Entity* entities,
+        size_t& count) const noexcept {
+    return static_cast<EntityManagerImpl const *>(this)->readDestroyedEntities(
+            cursor, entities, count);
+}
+
 size_t EntityManager::getEntityCount() const noexcept {
     return static_cast<EntityManagerImpl const *>(this)->getEntityCount();
 }
@@ -19,6 +19,7 @@
 
 #include <utils/EntityManager.h>
 
+#include <utils/architecture.h>
 #include <utils/compiler.h>
 #include <utils/Entity.h>
 #include <utils/Mutex.h>
@@ -31,7 +32,8 @@
 #include <tsl/robin_map.h>
 #endif
 
-#include <deque>
+#include <algorithm>
+#include <atomic>
 #include <mutex> // for std::lock_guard
 #include <vector>
 
@@ -48,61 +50,73 @@ public:
     using EntityManager::create;
     using EntityManager::destroy;
 
+    EntityManagerImpl() noexcept
+            : mFreeList(new FreeList::Cell[RAW_INDEX_COUNT]),
+              mJournal(new std::atomic<uint64_t>[JOURNAL_SIZE]()) {
+    }
+
+    ~EntityManagerImpl() noexcept {
+        delete [] mJournal;
+        delete [] mFreeList.cells;
+    }
+
     UTILS_NOINLINE
     size_t getEntityCount() const noexcept {
-        std::lock_guard<Mutex> const lock(mFreeListLock);
-        if (mCurrentIndex < RAW_INDEX_COUNT) {
-            return (mCurrentIndex - 1) - mFreeList.size();
-        } else {
-            return getMaxEntityCount() - mFreeList.size();
-        }
+        Entity::Type const currentIndex = mCurrentIndex.load(std::memory_order_relaxed);
+        return (currentIndex - 1) - mFreeList.size();
     }
 
     UTILS_NOINLINE
     void create(size_t n, Entity* entities) {
-        Entity::Type index{};
-        auto& freeList = mFreeList;
-        uint8_t* const gens = mGens;
+        std::atomic<uint8_t>* const gens = mGens;
+
+        // In the common case, we just grab the next indices, all at once.
+        // This works only until all indices have been used once, at which point we're always
+        // getting them from the free-list. The idea is that we have enough indices that it doesn't
+        // happen in practice.
+        // If we have more than a certain number of freed indices, we get them from the list
+        // instead, this is a trade-off between how often we recycle indices and how large the
+        // free list can grow.
+        Entity::Type next = 0;
+        Entity::Type remaining = 0;
+        if (mFreeList.size() < MIN_FREE_INDICES) {
+            remaining = reserve(n, &next);
+        }
 
-        // this must be thread-safe, acquire the free-list mutex
-        std::lock_guard<Mutex> const lock(mFreeListLock);
-        Entity::Type currentIndex = mCurrentIndex;
+#if FILAMENT_UTILS_TRACK_ENTITIES
+        std::lock_guard<Mutex> const lock(mDebugLock);
+#endif
         for (size_t i = 0; i < n; i++) {
-            // If we have more than a certain number of freed indices, get one from the list.
-            // this is a trade-off between how often we recycle indices and how large the free list
-            // can grow.
-            if (UTILS_UNLIKELY(currentIndex >= RAW_INDEX_COUNT || freeList.size() >= MIN_FREE_INDICES)) {
-
-                // this could only happen if we had gone through all the indices at least once
-                if (UTILS_UNLIKELY(freeList.empty())) {
+            Entity::Type index = 0;
+            if (UTILS_UNLIKELY(!remaining && !mFreeList.pop(&index))) {
+                // other threads could have emptied the free list since we checked its size
+                remaining = reserve(n - i, &next);
+                if (UTILS_UNLIKELY(!remaining)) {
+                    // this could only happen if we had gone through all the indices at least once
                     // return the null entity
                     entities[i] = {};
                     continue;
                 }
-
-                index = freeList.front();
-                freeList.pop_front();
-            } else {
-                // In the common case, we just grab the next index.
-                // This works only until all indices have been used once, at which point
-                // we're always in the slower case above. The idea is that we have enough indices
-                // that it doesn't happen in practice.
-                index = currentIndex++;
             }
-            entities[i] = Entity{ makeIdentity(gens[index], index) };
+            if (remaining) {
+                index = next++;
+                remaining--;
+            }
+            entities[i] = Entity{
+                    makeIdentity(gens[index].load(std::memory_order_relaxed), index) };
 #if FILAMENT_UTILS_TRACK_ENTITIES
             mDebugActiveEntities.emplace(entities[i], CallStack::unwind(5));
 #endif
         }
-        mCurrentIndex = currentIndex;
     }
 
     UTILS_NOINLINE
     void destroy(size_t n, Entity* entities) noexcept {
-        auto& freeList = mFreeList;
-        uint8_t* const gens = mGens;
+        std::atomic<uint8_t>* const gens = mGens;
 
-        std::unique_lock<Mutex> lock(mFreeListLock);
+#if FILAMENT_UTILS_TRACK_ENTITIES
+        std::unique_lock<Mutex> lock(mDebugLock);
+#endif
         for (size_t i = 0; i < n; i++) {
             if (!entities[i]) {
                 // behave like free(), ok to free null Entity.
@@ -115,38 +129,78 @@ public:
             // ... deleting a dead Entity will corrupt the internal state, so we protect ourselves
             // against it. We don't guarantee anything about external state -- e.g. the listeners
             // will be called.
-            if (isAlive(entities[i])) {
-                Entity::Type const index = getIndex(entities[i]);
-                freeList.push_back(index);
-
-                // The generation update doesn't require the lock because it's only used for isAlive()
-                // and entities work as weak references -- it just means that isAlive() could return
-                // true a little longer than expected in some other threads.
-                // We do need a memory fence though, it is provided by the mFreeListLock.unlock() below.
-                gens[index]++;
+            // The index is claimed by bumping its generation, so that if several threads destroy
+            // the same Entity, only one of them returns it to the free list. Other threads can
+            // see the old generation in isAlive() a little longer, which is fine since entities
+            // work as weak references. The next create() of this index sees the new generation
+            // because push() releases it.
+            Entity::Type const index = getIndex(entities[i]);
+            uint8_t generation = uint8_t(getGeneration(entities[i]));
+            if (gens[index].compare_exchange_strong(generation, uint8_t(generation + 1),
+                    std::memory_order_relaxed)) {
+                mFreeList.push(index);
+                journal(entities[i]);
 
 #if FILAMENT_UTILS_TRACK_ENTITIES
                 mDebugActiveEntities.erase(entities[i]);
 #endif
             }
         }
+#if FILAMENT_UTILS_TRACK_ENTITIES
         lock.unlock();
+#endif
 
-        // notify our listeners that some entities are being destroyed
-        auto listeners = getListeners();
-        for (auto const& l : listeners) {
-            l->onEntitiesDestroyed(n, entities);
+        // notify our listeners that some entities are being destroyed, most of the time there
+        // are none and we skip the lock and the copy.
+        if (UTILS_UNLIKELY(mListenerCount.load(std::memory_order_relaxed))) {
+            auto listeners = getListeners();
+            for (auto const& l : listeners) {
+                l->onEntitiesDestroyed(n, entities);
+            }
         }
     }
 
     void registerListener(EntityManager::Listener* l) noexcept {
         std::lock_guard<Mutex> const lock(mListenerLock);
         mListeners.insert(l);
+        mListenerCount.store(mListeners.size(), std::memory_order_relaxed);
     }
 
     void unregisterListener(EntityManager::Listener* l) noexcept {
         std::lock_guard<Mutex> const lock(mListenerLock);
         mListeners.erase(l);
+        mListenerCount.store(mListeners.size(), std::memory_order_relaxed);
+    }
+
+    bool readDestroyedEntities(uint64_t& cursor, Entity* entities, size_t& count) const noexcept {
+        uint64_t const head = mJournalHead.load(std::memory_order_acquire);
+        if (UTILS_UNLIKELY(head - cursor > JOURNAL_SIZE)) {
+            // the entries since cursor have been overwritten
+            cursor = head;
+            count = 0;
+            return false;
+        }
+        size_t n = 0;
+        uint64_t position = cursor;
+        while (position < head && n < count) {
+            uint64_t const cell = mJournal[position & JOURNAL_MASK].load(std::memory_order_acquire);
+            int32_t const diff = int32_t(uint32_t(cell >> 32u) - uint32_t(position + 1));
+            if (diff < 0) {
+                // this position is reserved but not written yet, we'll read it next time
+                break;
+            }
+            if (UTILS_UNLIKELY(diff > 0)) {
+                // a writer lapped us while we were reading
+                cursor = head;
+                count = 0;
+                return false;
+            }
+            entities[n++] = Entity{ Entity::Type(cell) };
+            position++;
+        }
+        cursor = position;
+        count = n;
+        return true;
     }
 
 #if FILAMENT_UTILS_TRACK_ENTITIES
@@ -169,6 +223,24 @@ public:
 #endif
 
 private:
+    void journal(Entity e) noexcept {
+        uint64_t const position = mJournalHead.fetch_add(1, std::memory_order_relaxed);
+        mJournal[position & JOURNAL_MASK].store(
+                (uint64_t(uint32_t(position + 1)) << 32u) | e.getId(), std::memory_order_release);
+    }
+
+    // Reserves up to n never used indices, returns how many were reserved.
+    Entity::Type reserve(size_t n, Entity::Type* first) noexcept {
+        Entity::Type currentIndex = mCurrentIndex.load(std::memory_order_relaxed);
+        Entity::Type count;
+        do {
+            count = Entity::Type(std::min(n, size_t(RAW_INDEX_COUNT - currentIndex)));
+        } while (count && !mCurrentIndex.compare_exchange_weak(currentIndex,
+                currentIndex + count, std::memory_order_relaxed));
+        *first = currentIndex;
+        return count;
+    }
+
     utils::FixedCapacityVector<EntityManager::Listener*> getListeners() const noexcept {
         std::lock_guard<Mutex> const lock(mListenerLock);
         tsl::robin_set<Listener*> const& listeners = mListeners;
@@ -178,11 +250,99 @@ private:
         return result; // the c++ standard guarantees a move
     }
 
-    uint32_t mCurrentIndex = 1;
+    /*
+     * Stores indices that got freed, in the order they got freed so that an index isn't reused
+     * (and its generation incremented) more often than needed.
+     * This is a lock-free bounded multi-producer multi-consumer queue, where each cell has a
+     * sequence number telling whether it's ready to be written or read at a given position.
+     * It can hold all the indices, so it can't overflow. Cells store their sequence number minus
+     * their own index, so that all of them start at zero in an empty queue.
+     */
+    struct FreeList {
+        struct Cell {
+            std::atomic<uint32_t> sequence = { 0 };
+            Entity::Type index = 0;
+        };
+        static constexpr uint32_t MASK = RAW_INDEX_COUNT - 1;
+
+        explicit FreeList(Cell* cells) noexcept : cells(cells) { }
+
+        size_t size() const noexcept {
+            // the positions are read separately and can be momentarily inconsistent
+            uint32_t const h = head.load(std::memory_order_relaxed);
+            uint32_t const t = tail.load(std::memory_order_relaxed);
+            return size_t(std::max(0, int32_t(t - h)));
+        }
 
-    // stores indices that got freed
-    mutable Mutex mFreeListLock;
-    std::deque<Entity::Type> mFreeList;
+        void push(Entity::Type index) noexcept {
+            uint32_t pos = tail.load(std::memory_order_relaxed);
+            Cell* cell;
+            while (true) {
+                cell = &cells[pos & MASK];
+                uint32_t const sequence =
+                        cell->sequence.load(std::memory_order_acquire) + (pos & MASK);
+                int32_t const diff = int32_t(sequence - pos);
+                if (diff == 0) {
+                    if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else {
+                    // there are never more free indices than cells
+                    assert(diff > 0);
+                    pos = tail.load(std::memory_order_relaxed);
+                }
+            }
+            cell->index = index;
+            cell->sequence.store(pos + 1 - (pos & MASK), std::memory_order_release);
+        }
+
+        bool pop(Entity::Type* index) noexcept {
+            uint32_t pos = head.load(std::memory_order_relaxed);
+            Cell* cell;
+            while (true) {
+                cell = &cells[pos & MASK];
+                uint32_t const sequence =
+                        cell->sequence.load(std::memory_order_acquire) + (pos & MASK);
+                int32_t const diff = int32_t(sequence - (pos + 1));
+                if (diff == 0) {
+                    if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    // empty
+                    return false;
+                } else {
+                    pos = head.load(std::memory_order_relaxed);
+                }
+            }
+            *index = cell->index;
+            cell->sequence.store(pos + MASK + 1 - (pos & MASK), std::memory_order_release);
+            return true;
+        }
+
+        Cell* const cells;
+        alignas(CACHELINE_SIZE) std::atomic<uint32_t> head = { 0 };  // next position to pop
+        alignas(CACHELINE_SIZE) std::atomic<uint32_t> tail = { 0 };  // next position to push
+    };
+
+    std::atomic<Entity::Type> mCurrentIndex = { 1 };
+    FreeList mFreeList;
+
+    /*
+     * Ring of the most recently destroyed entities, see readDestroyedEntities(). Each cell holds
+     * the low 32 bits of its position + 1 in its upper half, and the entity in its lower half, so
+     * that readers can tell whether a cell is not written yet or already overwritten.
+     * A zero-filled cell reads as not written yet.
+     */
+    static constexpr size_t JOURNAL_SIZE = 16384;
+    static constexpr uint64_t JOURNAL_MASK = JOURNAL_SIZE - 1;
+    std::atomic<uint64_t>* const mJournal;
+    alignas(CACHELINE_SIZE) std::atomic<uint64_t> mJournalHead = { 0 };
+    std::atomic<size_t> mListenerCount = { 0 };
+
+#if FILAMENT_UTILS_TRACK_ENTITIES
+    mutable Mutex mDebugLock;
+#endif
 
     mutable Mutex mListenerLock;
     tsl::robin_set<Listener*> mListeners;
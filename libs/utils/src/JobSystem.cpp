@@ -28,6 +28,7 @@ static constexpr bool DEBUG_FINISH_HANGS = false;
 
 #include <utils/JobSystem.h>
 
+#include <utils/algorithm.h>
 #include <utils/compiler.h>
 #include <utils/Log.h>
 #include <utils/memalign.h>
@@ -49,6 +50,7 @@ static constexpr bool DEBUG_FINISH_HANGS = false;
 #include <math.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
 
 #if defined(WIN32)
@@ -94,6 +96,9 @@ static constexpr bool DEBUG_FINISH_HANGS = false;
 
 namespace utils {
 
+// scratch arena of the JobSystem thread we're running on, if any
+static thread_local JobSystem::ScratchArena* sScratchArena = nullptr;
+
 void JobSystem::setThreadName(const char* name) noexcept {
 #if defined(__linux__)
     pthread_setname_np(pthread_self(), name);
@@ -148,12 +153,65 @@ void JobSystem::setThreadAffinityById(size_t id) noexcept {
 #endif
 }
 
+void JobSystem::setThreadAffinityByMask(uint64_t mask) noexcept {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t id = 0; id < 64; id++) {
+        if (mask & (uint64_t(1) << id)) {
+            CPU_SET(id, &set);
+        }
+    }
+    sched_setaffinity(gettid(), sizeof(set), &set);
+#endif
+}
+
+uint64_t JobSystem::getLittleCores(uint64_t* bigCores) noexcept {
+    *bigCores = 0;
+#if defined(__ANDROID__)
+    // On heterogeneous CPUs (e.g. big.LITTLE), the cores of the slowest class are the ones with
+    // the lowest maximum frequency. We don't do this on desktop, where cores of the same class can
+    // have slightly different maximum frequencies.
+    uint32_t frequencies[64] = {};
+    uint32_t lowest = UINT32_MAX;
+    uint32_t highest = 0;
+    for (size_t id = 0; id < 64; id++) {
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%zu/cpufreq/cpuinfo_max_freq", id);
+        FILE* const file = fopen(path, "r");
+        if (!file) {
+            continue;
+        }
+        if (fscanf(file, "%u", &frequencies[id]) == 1 && frequencies[id]) {
+            lowest = std::min(lowest, frequencies[id]);
+            highest = std::max(highest, frequencies[id]);
+        }
+        fclose(file);
+    }
+    if (highest <= lowest) {
+        return 0;
+    }
+    uint64_t littleCores = 0;
+    for (size_t id = 0; id < 64; id++) {
+        if (frequencies[id] == lowest) {
+            littleCores |= uint64_t(1) << id;
+        } else if (frequencies[id]) {
+            *bigCores |= uint64_t(1) << id;
+        }
+    }
+    return littleCores;
+#else
+    return 0;
+#endif
+}
+
 JobSystem::JobSystem(const size_t userThreadCount, const size_t adoptableThreadsCount) noexcept
-    : mJobPool("JobSystem Job pool", MAX_JOB_COUNT * sizeof(Job)),
-      mJobStorageBase(static_cast<Job *>(mJobPool.getAllocator().getCurrent()))
 {
     SYSTRACE_ENABLE();
 
+    mJobSegments[0] = std::make_unique<JobSegment>("JobSystem Job pool");
+    mJobSegmentCount.store(1, std::memory_order_release);
+
     unsigned int threadPoolCount = userThreadCount;
     if (threadPoolCount == 0) {
         // default value, system dependant
@@ -183,11 +241,24 @@ JobSystem::JobSystem(const size_t userThreadCount, const size_t adoptableThreads
     const size_t hardwareThreadCount = mThreadCount;
     auto& states = mThreadStates;
 
+    // On heterogeneous CPUs, the last threads of the pool run on the slower cores and prefer
+    // background jobs, while the others (and the user thread, presumably) use the faster cores.
+    uint64_t bigCores = 0;
+    uint64_t const littleCores = getLittleCores(&bigCores);
+    size_t const littleThreadCount = littleCores && hardwareThreadCount > 1 ?
+            std::min(size_t(details::popcount(littleCores)), hardwareThreadCount - 1) : 0;
+
     #pragma nounroll
     for (size_t i = 0, n = states.size(); i < n; i++) {
         auto& state = states[i];
         state.rndGen = default_random_engine(rd());
         state.js = this;
+        state.scratch = std::make_unique<ScratchArena>("JobSystem::scratch", SCRATCH_ARENA_SIZE);
+        if (littleThreadCount && i < hardwareThreadCount) {
+            bool const little = i >= hardwareThreadCount - littleThreadCount;
+            state.cpuMask = little ? littleCores : bigCores;
+            state.preferBackground = little;
+        }
         if (i < hardwareThreadCount) {
             // don't start a thread of adoptable thread slots
             state.thread = std::thread(&JobSystem::loop, this, &state);
@@ -228,7 +299,7 @@ void JobSystem::decRef(Job const* job) noexcept {
     assert(c > 0);
     if (c == 1) {
         // This was the last reference, it's safe to destroy the job.
-        mJobPool.destroy(job);
+        mJobSegments[getJobIndex(job) / JOB_SEGMENT_SIZE]->pool.destroy(job);
     }
 }
 
@@ -244,7 +315,11 @@ inline bool JobSystem::exitRequested() const noexcept {
 }
 
 inline bool JobSystem::hasActiveJobs() const noexcept {
-    return mActiveJobs.load(std::memory_order_relaxed) > 0;
+    return hasActiveJobs(Lane::DEFAULT) || hasActiveJobs(Lane::BACKGROUND);
+}
+
+inline bool JobSystem::hasActiveJobs(Lane lane) const noexcept {
+    return mActiveJobs[size_t(lane)].load(std::memory_order_relaxed) > 0;
 }
 
 inline bool JobSystem::hasJobCompleted(JobSystem::Job const* job) noexcept {
@@ -271,7 +346,8 @@ void JobSystem::wait(std::unique_lock<Mutex>& lock, Job* job) noexcept {
             // confidence that we're in an incorrect state.
 
             size_t const id = std::distance(mThreadStates.data(), &getState());
-            auto activeJobs = mActiveJobs.load();
+            auto activeJobs = mActiveJobs[size_t(Lane::DEFAULT)].load() +
+                    mActiveJobs[size_t(Lane::BACKGROUND)].load();
 
             if (job) {
                 auto runningJobCount = job->runningJobCount.load();
@@ -308,6 +384,28 @@ void JobSystem::wake(size_t hint) noexcept {
     }
 }
 
+void JobSystem::wakeForLane(Lane lane, int32_t activeJobs) noexcept {
+    // Threads waiting on a DEFAULT job can't pick up background jobs, so waking a single thread
+    // could pick one of them and the job would not run until something else wakes the others.
+    wake(lane == Lane::BACKGROUND ? 0 : activeJobs);
+}
+
+JobSystem::ScratchArena& JobSystem::getScratchArena() noexcept {
+    assert_invariant(sScratchArena);
+    return *sScratchArena;
+}
+
+inline void JobSystem::call(ThreadState& state, Job* job) noexcept {
+    if (UTILS_LIKELY(job->function)) {
+        // nested jobs (e.g. run by a wait() in this job) release their allocations first,
+        // the allocations of this job are released when it returns.
+        ScratchArena& scratch = *state.scratch;
+        void* const mark = scratch.getCurrent();
+        job->function(job->storage, *this, job);
+        scratch.rewind(mark);
+    }
+}
+
 inline JobSystem::ThreadState& JobSystem::getState() noexcept {
     std::lock_guard<utils::Mutex> const lock(mThreadMapLock);
     auto iter = mThreadMap.find(std::this_thread::get_id());
@@ -315,66 +413,133 @@ inline JobSystem::ThreadState& JobSystem::getState() noexcept {
     return *iter->second;
 }
 
+bool JobSystem::isThreadOwned() noexcept {
+    std::lock_guard<utils::Mutex> const lock(mThreadMapLock);
+    return mThreadMap.find(std::this_thread::get_id()) != mThreadMap.end();
+}
+
+JobSystem::JobSegment::JobSegment(const char* name) noexcept
+        : pool(name, JOB_SEGMENT_SIZE * sizeof(Job)),
+          base(static_cast<Job*>(pool.getAllocator().getCurrent())) {
+}
+
 JobSystem::Job* JobSystem::allocateJob() noexcept {
-    return mJobPool.make<Job>();
+    uint32_t const segmentCount = mJobSegmentCount.load(std::memory_order_acquire);
+    // the last segment is the most likely to have room
+    Job* const job = mJobSegments[segmentCount - 1]->pool.make<Job>();
+    return UTILS_LIKELY(job) ? job : allocateJobSlow(segmentCount);
 }
 
-void JobSystem::put(WorkQueue& workQueue, Job* job) noexcept {
+UTILS_NOINLINE
+JobSystem::Job* JobSystem::allocateJobSlow(uint32_t segmentCount) noexcept {
+    for (uint32_t i = 0; i < segmentCount - 1; i++) {
+        if (Job* const job = mJobSegments[i]->pool.make<Job>()) {
+            return job;
+        }
+    }
+
+    std::lock_guard<Mutex> const lock(mJobSegmentLock);
+    uint32_t const count = mJobSegmentCount.load(std::memory_order_relaxed);
+    if (count != segmentCount) {
+        // another thread added a segment in the meantime
+        if (Job* const job = mJobSegments[count - 1]->pool.make<Job>()) {
+            return job;
+        }
+    }
+    if (count == MAX_JOB_SEGMENT_COUNT) {
+        mOverflowCount.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    SYSTRACE_NAME("JobSystem: new segment");
+    mJobSegments[count] = std::make_unique<JobSegment>("JobSystem Job pool");
+    mJobSegmentCount.store(count + 1, std::memory_order_release);
+    return mJobSegments[count]->pool.make<Job>();
+}
+
+uint32_t JobSystem::getJobIndex(Job const* job) const noexcept {
+    uint32_t const segmentCount = mJobSegmentCount.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < segmentCount; i++) {
+        Job const* const base = mJobSegments[i]->base;
+        if (job >= base && job < base + JOB_SEGMENT_SIZE) {
+            return uint32_t(i * JOB_SEGMENT_SIZE + (job - base));
+        }
+    }
+    assert(false);
+    return 0;
+}
+
+void JobSystem::put(ThreadState& state, Job* job) noexcept {
     assert(job);
-    size_t const index = job - mJobStorageBase;
-    assert(index >= 0 && index < MAX_JOB_COUNT);
+    uint32_t const index = getJobIndex(job);
+    assert(index < MAX_JOB_COUNT);
+    Lane const lane = Lane(job->lane);
+
+    WorkQueue& workQueue = getQueue(state, lane);
+    if (UTILS_UNLIKELY(workQueue.getCount() >= WORK_QUEUE_SIZE)) {
+        // Only this thread adds jobs to its queue, so it won't have room until we pick some up,
+        // we might as well run the job now.
+        mOverflowCount.fetch_add(1, std::memory_order_relaxed);
+        call(state, job);
+        finish(job);
+        return;
+    }
 
     // put the job into the queue first
-    workQueue.push(uint16_t(index + 1));
+    workQueue.push(index + 1);
     // then increase our active job count
-    int32_t const oldActiveJobs = mActiveJobs.fetch_add(1, std::memory_order_relaxed);
+    int32_t const oldActiveJobs =
+            mActiveJobs[size_t(lane)].fetch_add(1, std::memory_order_relaxed);
     // But it's possible that the job has already been picked-up, so oldActiveJobs could be
     // negative for instance. We signal only if that's not the case.
     if (oldActiveJobs >= 0) {
-        wake(oldActiveJobs + 1); // wake-up a thread if needed...
+        wakeForLane(lane, oldActiveJobs + 1); // wake-up a thread if needed...
     }
 }
 
-JobSystem::Job* JobSystem::pop(WorkQueue& workQueue) noexcept {
+JobSystem::Job* JobSystem::pop(WorkQueue& workQueue, Lane lane) noexcept {
+    std::atomic<int32_t>& activeJobs = mActiveJobs[size_t(lane)];
+
     // decrement mActiveJobs first, this is to ensure that if there is only a single job left
     // (and we're about to pick it up), other threads don't loop trying to do the same.
-    mActiveJobs.fetch_sub(1, std::memory_order_relaxed);
+    activeJobs.fetch_sub(1, std::memory_order_relaxed);
 
     size_t const index = workQueue.pop();
     assert(index <= MAX_JOB_COUNT);
-    Job* const job = !index ? nullptr : &mJobStorageBase[index - 1];
+    Job* const job = !index ? nullptr : getJob(uint32_t(index - 1));
 
     // If our guess was wrong, i.e. we couldn't pick up a job (b/c our queue was empty), we
     // need to correct mActiveJobs.
     if (!job) {
-        int32_t const oldActiveJobs = mActiveJobs.fetch_add(1, std::memory_order_relaxed);
+        int32_t const oldActiveJobs = activeJobs.fetch_add(1, std::memory_order_relaxed);
         if (oldActiveJobs >= 0) {
             // And if there are some active jobs, then we need to wake someone up. We know it
             // can't be us, because we failed taking a job and we know another thread can't
             // have added one in our queue.
-            wake(oldActiveJobs + 1); // wake-up a thread if needed...
+            wakeForLane(lane, oldActiveJobs + 1); // wake-up a thread if needed...
         }
     }
     return job;
 }
 
-JobSystem::Job* JobSystem::steal(WorkQueue& workQueue) noexcept {
+JobSystem::Job* JobSystem::steal(WorkQueue& workQueue, Lane lane) noexcept {
+    std::atomic<int32_t>& activeJobs = mActiveJobs[size_t(lane)];
+
     // decrement mActiveJobs first, this is to ensure that if there is only a single job left
     // (and we're about to pick it up), other threads don't loop trying to do the same.
-    mActiveJobs.fetch_sub(1, std::memory_order_relaxed);
+    activeJobs.fetch_sub(1, std::memory_order_relaxed);
 
     size_t const index = workQueue.steal();
     assert(index <= MAX_JOB_COUNT);
-    Job* const job = !index ? nullptr : &mJobStorageBase[index - 1];
+    Job* const job = !index ? nullptr : getJob(uint32_t(index - 1));
 
     // If we failed taking a job, we need to correct mActiveJobs.
     if (!job) {
-        int32_t const oldActiveJobs = mActiveJobs.fetch_add(1, std::memory_order_relaxed);
+        int32_t const oldActiveJobs = activeJobs.fetch_add(1, std::memory_order_relaxed);
         if (oldActiveJobs >= 0) {
             // And if there are some active jobs, then we need to wake someone up. We know it
             // can't be us, because we failed taking a job and we know another thread can't
             // have added one in our queue.
-            wake(oldActiveJobs + 1); // wake-up a thread if needed...
+            wakeForLane(lane, oldActiveJobs + 1); // wake-up a thread if needed...
         }
     }
     return job;
@@ -402,36 +567,50 @@ inline JobSystem::ThreadState* JobSystem::getStateToStealFrom(JobSystem::ThreadS
     return stateToStealFrom;
 }
 
-JobSystem::Job* JobSystem::steal(JobSystem::ThreadState& state) noexcept {
+JobSystem::Job* JobSystem::steal(JobSystem::ThreadState& state, Lane lane) noexcept {
     HEAVY_SYSTRACE_CALL();
     Job* job = nullptr;
     do {
         ThreadState* const stateToStealFrom = getStateToStealFrom(state);
         if (UTILS_LIKELY(stateToStealFrom)) {
-            job = steal(stateToStealFrom->workQueue);
+            job = steal(getQueue(*stateToStealFrom, lane), lane);
         }
         // nullptr -> nothing to steal in that queue either, if there are active jobs,
         // continue to try stealing one.
-    } while (!job && hasActiveJobs());
+    } while (!job && hasActiveJobs(lane));
     return job;
 }
 
-bool JobSystem::execute(JobSystem::ThreadState& state) noexcept {
-    HEAVY_SYSTRACE_CALL();
-
-    Job* job = pop(state.workQueue);
+JobSystem::Job* JobSystem::take(JobSystem::ThreadState& state, Lane lane) noexcept {
+    Job* job = pop(getQueue(state, lane), lane);
     if (UTILS_UNLIKELY(job == nullptr)) {
         // our queue is empty, try to steal a job
-        job = steal(state);
+        job = steal(state, lane);
+    }
+    return job;
+}
+
+bool JobSystem::execute(JobSystem::ThreadState& state, bool includeBackground) noexcept {
+    HEAVY_SYSTRACE_CALL();
+
+    Job* job;
+    if (UTILS_UNLIKELY(includeBackground && state.preferBackground)) {
+        job = take(state, Lane::BACKGROUND);
+        if (!job) {
+            job = take(state, Lane::DEFAULT);
+        }
+    } else {
+        job = take(state, Lane::DEFAULT);
+        if (!job && includeBackground) {
+            job = take(state, Lane::BACKGROUND);
+        }
     }
 
     if (job) {
         assert(job->runningJobCount.load(std::memory_order_relaxed) >= 1);
 
-        if (UTILS_LIKELY(job->function)) {
-            HEAVY_SYSTRACE_NAME("job->function");
-            job->function(job->storage, *this, job);
-        }
+        HEAVY_SYSTRACE_NAME("job->function");
+        call(state, job);
         finish(job);
     }
     return job != nullptr;
@@ -440,12 +619,16 @@ bool JobSystem::execute(JobSystem::ThreadState& state) noexcept {
 void JobSystem::loop(ThreadState* state) noexcept {
     setThreadName("JobSystem::loop");
     setThreadPriority(Priority::DISPLAY);
+    if (state->cpuMask) {
+        setThreadAffinityByMask(state->cpuMask);
+    }
 
     // record our work queue
     mThreadMapLock.lock();
     bool const inserted = mThreadMap.emplace(std::this_thread::get_id(), state).second;
     mThreadMapLock.unlock();
     FILAMENT_CHECK_PRECONDITION(inserted) << "This thread is already in a loop.";
+    sScratchArena = state->scratch.get();
 
     // run our main loop...
     do {
@@ -465,7 +648,6 @@ void JobSystem::finish(Job* job) noexcept {
     bool notify = false;
 
     // terminate this job and notify its parent
-    Job* const storage = mJobStorageBase;
     do {
         // std::memory_order_release here is needed to synchronize with JobSystem::wait()
         // which needs to "see" all changes that happened before the job terminated.
@@ -474,7 +656,10 @@ void JobSystem::finish(Job* job) noexcept {
         if (runningJobCount == 1) {
             // no more work, destroy this job and notify its parent
             notify = true;
-            Job* const parent = job->parent == 0x7FFF ? nullptr : &storage[job->parent];
+            Job* const parent = job->parent == 0x3FFFFFFF ? nullptr : getJob(job->parent);
+            if (UTILS_UNLIKELY(job->hasContinuation)) {
+                runContinuation(job);
+            }
             decRef(job);
             job = parent;
         } else {
@@ -495,9 +680,17 @@ void JobSystem::finish(Job* job) noexcept {
 
 JobSystem::Job* JobSystem::create(JobSystem::Job* parent, JobFunc func) noexcept {
     parent = (parent == nullptr) ? mRootJob : parent;
+
+    // runningJobCount must not overflow, leave some room for threads adding children concurrently
+    if (UTILS_UNLIKELY(parent &&
+            parent->runningJobCount.load(std::memory_order_relaxed) >= 0xFF00)) {
+        mOverflowCount.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
     Job* const job = allocateJob();
     if (UTILS_LIKELY(job)) {
-        size_t index = 0x7FFF;
+        uint32_t index = 0x3FFFFFFF;
         if (parent) {
             // add a reference to the parent to make sure it can't be terminated.
             // memory_order_relaxed is safe because no action is taken at this point
@@ -507,11 +700,13 @@ JobSystem::Job* JobSystem::create(JobSystem::Job* parent, JobFunc func) noexcept
             // can't create a child job of a terminated parent
             assert(parentJobCount > 0);
 
-            index = parent - mJobStorageBase;
+            index = getJobIndex(parent);
             assert(index < MAX_JOB_COUNT);
         }
         job->function = func;
-        job->parent = uint16_t(index);
+        job->parent = index;
+        job->lane = parent ? parent->lane : uint32_t(Lane::DEFAULT);
+        job->hasContinuation = false;
     }
     return job;
 }
@@ -541,27 +736,65 @@ void JobSystem::run(Job*& job) noexcept {
 
     ThreadState& state(getState());
 
-    put(state.workQueue, job);
+    put(state, job);
 
     // after run() returns, the job is virtually invalid (it'll die on its own)
     job = nullptr;
 }
 
+void JobSystem::run(Job*& job, Lane lane) noexcept {
+    job->lane = uint32_t(lane);
+    run(job);
+}
+
+void JobSystem::runAfter(Job*& job, Job* dependency) noexcept {
+    assert(job && dependency);
+    assert(!dependency->hasContinuation);
+    {
+        std::lock_guard<Mutex> const lock(mContinuationLock);
+        mContinuations[dependency] = job;
+    }
+    // this is safe because the dependency hasn't run yet, i.e. no other thread can access it
+    dependency->hasContinuation = true;
+    job = nullptr;
+}
+
+void JobSystem::runContinuation(Job const* job) noexcept {
+    Job* continuation;
+    {
+        std::lock_guard<Mutex> const lock(mContinuationLock);
+        auto pos = mContinuations.find(job);
+        assert(pos != mContinuations.end());
+        continuation = pos->second;
+        mContinuations.erase(pos);
+    }
+    run(continuation);
+}
+
 JobSystem::Job* JobSystem::runAndRetain(Job* job) noexcept {
     JobSystem::Job* retained = retain(job);
     run(job);
     return retained;
 }
 
+JobSystem::Job* JobSystem::runAndRetain(Job* job, Lane lane) noexcept {
+    job->lane = uint32_t(lane);
+    return runAndRetain(job);
+}
+
 void JobSystem::waitAndRelease(Job*& job) noexcept {
     SYSTRACE_CALL();
 
     assert(job);
     assert(job->refCount.load(std::memory_order_relaxed) >= 1);
 
+    // Unless we're waiting on a background job, we don't pick up background jobs: they could
+    // take much longer than the job we're waiting on. This requires other threads to run them.
+    bool const includeBackground = Lane(job->lane) == Lane::BACKGROUND || mThreadCount == 0;
+
     ThreadState& state(getState());
     do {
-        if (!execute(state)) {
+        if (!execute(state, includeBackground)) {
             // test if job has completed first, to possibly avoid taking the lock
             if (hasJobCompleted(job)) {
                 break;
@@ -577,7 +810,9 @@ void JobSystem::waitAndRelease(Job*& job) noexcept {
             // continue to handle more jobs, as they get added.
 
             std::unique_lock<Mutex> lock(mWaiterLock);
-            if (!hasJobCompleted(job) && !hasActiveJobs() && !exitRequested()) {
+            bool const activeJobs = includeBackground ?
+                    hasActiveJobs() : hasActiveJobs(Lane::DEFAULT);
+            if (!hasJobCompleted(job) && !activeJobs && !exitRequested()) {
                 wait(lock, job);
             }
         }
@@ -627,6 +862,7 @@ void JobSystem::adopt() {
 
     lock.lock();
     mThreadMap[tid] = &mThreadStates[index];
+    sScratchArena = mThreadStates[index].scratch.get();
 }
 
 void JobSystem::emancipate() {
@@ -637,12 +873,14 @@ void JobSystem::emancipate() {
     FILAMENT_CHECK_PRECONDITION(state) << "this thread is not an adopted thread";
     FILAMENT_CHECK_PRECONDITION(state->js == this) << "this thread is not adopted by us";
     mThreadMap.erase(iter);
+    sScratchArena = nullptr;
 }
 
 io::ostream& operator<<(io::ostream& out, JobSystem const& js) {
     for (auto const& item : js.mThreadStates) {
         size_t const id = std::distance(js.mThreadStates.data(), &item);
-        out << id << ": " << item.workQueue.getCount() << io::endl;
+        out << id << ": " << item.workQueue.getCount()
+            << " (" << item.backgroundQueue.getCount() << " background)" << io::endl;
     }
     return out;
 }
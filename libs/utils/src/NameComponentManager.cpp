@@ -17,6 +17,10 @@
 #include <utils/NameComponentManager.h>
 #include <utils/EntityManager.h>
 
+#include <utils/debug.h>
+
+#include <string.h>
+
 namespace utils {
 
 static constexpr size_t NAME = 0;
@@ -24,16 +28,51 @@ static constexpr size_t NAME = 0;
 NameComponentManager::NameComponentManager(EntityManager&) {
 }
 
-NameComponentManager::~NameComponentManager() = default;
+NameComponentManager::~NameComponentManager() {
+    for (auto const& [name, refCount] : mNames) {
+        delete[] name.data();
+    }
+}
+
+const char* NameComponentManager::acquire(const char* name) {
+    if (!name) {
+        return nullptr;
+    }
+    std::string_view const key{ name };
+    if (auto pos = mNames.find(key); pos != mNames.end()) {
+        pos->second++;
+        return pos->first.data();
+    }
+    size_t const length = key.size();
+    char* const copy = new char[length + 1];
+    memcpy(copy, name, length + 1);
+    mNames.insert({{ copy, length }, 1 });
+    return copy;
+}
+
+void NameComponentManager::release(const char* name) noexcept {
+    if (!name) {
+        return;
+    }
+    auto pos = mNames.find(std::string_view{ name });
+    assert_invariant(pos != mNames.end() && pos->first.data() == name);
+    if (--pos->second == 0) {
+        mNames.erase(pos);
+        delete[] name;
+    }
+}
 
 void NameComponentManager::setName(Instance instance, const char* name) noexcept {
     if (instance) {
-        elementAt<NAME>(instance) = CString{ name };
+        const char*& current = elementAt<NAME>(instance);
+        const char* const interned = acquire(name);
+        release(current);
+        current = interned;
     }
 }
 
 const char* NameComponentManager::getName(Instance instance) const noexcept {
-    return elementAt<NAME>(instance).c_str();
+    return elementAt<NAME>(instance);
 }
 
 void NameComponentManager::addComponent(Entity e) {
@@ -41,6 +80,9 @@ void NameComponentManager::addComponent(Entity e) {
 }
 
 void NameComponentManager::removeComponent(Entity e) {
+    if (Instance const instance = getInstance(e); instance) {
+        release(elementAt<NAME>(instance));
+    }
     SingleInstanceComponentManager::removeComponent(e);
 }
 
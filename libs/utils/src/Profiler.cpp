@@ -16,6 +16,8 @@
 
 #include <utils/Profiler.h>
 
+#include <utils/Mutex.h>
+
 #include <stdlib.h>
 #include <string.h>
 
@@ -26,9 +28,13 @@
 #   define close _close
 #endif
 
+#include <tsl/robin_map.h>
+
 #include <algorithm>
 #include <iterator>
 #include <memory>
+#include <mutex>    // for std::lock_guard
+#include <string>
 
 #if defined(__linux__)
 
@@ -224,4 +230,98 @@ Profiler::Counters Profiler::readCounters() noexcept {
 
 #endif // __linux__
 
+// ------------------------------------------------------------------------------------------------
+
+namespace {
+
+struct RegionState {
+    struct Entry {
+        uint64_t count = 0;
+        std::chrono::duration<uint64_t, std::nano> duration{};
+        Profiler::Counters counters{};
+    };
+    Mutex lock;
+    // names can be built on the stack (e.g. SYSTRACE_FRAME_ID), so they're copied
+    tsl::robin_map<std::string, Entry> regions;
+    std::atomic<uint32_t> eventMask = { 0 };
+    std::atomic<uint32_t> generation = { 0 };   // incremented when eventMask changes
+};
+
+RegionState& getRegionState() noexcept {
+    // leaked, so that regions can end during static destruction
+    static RegionState* const state = new RegionState;
+    return *state;
+}
+
+struct ThreadProfiler {
+    Profiler profiler;
+    uint32_t generation = 0;
+};
+
+// the events only change when entering a region, so that a region's counters are consistent
+Profiler& getThreadProfiler(RegionState& state, bool entering) noexcept {
+    thread_local ThreadProfiler tp;
+    uint32_t const generation = state.generation.load(std::memory_order_acquire);
+    if (UTILS_UNLIKELY(entering && tp.generation != generation)) {
+        tp.generation = generation;
+        tp.profiler.resetEvents(state.eventMask.load(std::memory_order_relaxed));
+        tp.profiler.start();
+    }
+    return tp.profiler;
+}
+
+} // anonymous namespace
+
+std::atomic_bool RegionProfiler::sEnabled = { false };
+
+void RegionProfiler::enable(uint32_t eventMask) noexcept {
+    RegionState& state = getRegionState();
+    state.eventMask.store(eventMask, std::memory_order_relaxed);
+    state.generation.fetch_add(1, std::memory_order_release);
+    sEnabled.store(true, std::memory_order_relaxed);
+}
+
+void RegionProfiler::disable() noexcept {
+    sEnabled.store(false, std::memory_order_relaxed);
+}
+
+std::vector<RegionProfiler::Region> RegionProfiler::getRegions() {
+    RegionState& state = getRegionState();
+    std::vector<Region> result;
+    {
+        std::lock_guard<Mutex> const lock(state.lock);
+        result.reserve(state.regions.size());
+        for (auto const& [name, entry] : state.regions) {
+            result.push_back({ CString(name.data(), name.size()),
+                    entry.count, entry.duration, entry.counters });
+        }
+    }
+    std::sort(result.begin(), result.end(), [](Region const& lhs, Region const& rhs) {
+        return lhs.duration > rhs.duration;
+    });
+    return result;
+}
+
+void RegionProfiler::reset() noexcept {
+    RegionState& state = getRegionState();
+    std::lock_guard<Mutex> const lock(state.lock);
+    state.regions.clear();
+}
+
+void RegionProfiler::Scope::begin() noexcept {
+    mCounters = getThreadProfiler(getRegionState(), true).readCounters();
+    mStart = std::chrono::steady_clock::now();
+}
+
+void RegionProfiler::Scope::end() noexcept {
+    auto const duration = std::chrono::steady_clock::now() - mStart;
+    RegionState& state = getRegionState();
+    Profiler::Counters const counters = getThreadProfiler(state, false).readCounters() - mCounters;
+    std::lock_guard<Mutex> const lock(state.lock);
+    RegionState::Entry& entry = state.regions[mName];
+    entry.count++;
+    entry.duration += std::chrono::duration_cast<std::chrono::nanoseconds>(duration);
+    entry.counters = entry.counters + counters;
+}
+
 } // namespace utils
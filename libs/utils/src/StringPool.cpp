@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <utils/StringPool.h>
+
+#include <utility>
+
+#include <string.h>
+
+namespace utils {
+
+StringPool::StringPool(size_t blockSize) noexcept
+        : mBlockSize(blockSize) {
+}
+
+StringPool::~StringPool() noexcept = default;
+
+StringPool::StringPool(StringPool&& rhs) noexcept
+        : mStrings(std::move(rhs.mStrings)),
+          mBlocks(std::move(rhs.mBlocks)),
+          mCurrent(std::exchange(rhs.mCurrent, nullptr)),
+          mAvailable(std::exchange(rhs.mAvailable, 0)),
+          mBlockSize(rhs.mBlockSize),
+          mAllocatedSize(std::exchange(rhs.mAllocatedSize, 0)) {
+}
+
+StringPool& StringPool::operator=(StringPool&& rhs) noexcept {
+    if (this != &rhs) {
+        mStrings = std::move(rhs.mStrings);
+        mBlocks = std::move(rhs.mBlocks);
+        mCurrent = std::exchange(rhs.mCurrent, nullptr);
+        mAvailable = std::exchange(rhs.mAvailable, 0);
+        mBlockSize = rhs.mBlockSize;
+        mAllocatedSize = std::exchange(rhs.mAllocatedSize, 0);
+    }
+    return *this;
+}
+
+const char* StringPool::intern(const char* str) {
+    if (!str) {
+        return nullptr;
+    }
+    return intern(std::string_view{ str });
+}
+
+const char* StringPool::intern(std::string_view str) {
+    if (auto pos = mStrings.find(str); pos != mStrings.end()) {
+        return pos->data();
+    }
+    size_t const length = str.size();
+    char* const copy = allocate(length + 1);
+    memcpy(copy, str.data(), length);
+    copy[length] = '\0';
+    mStrings.insert({ copy, length });
+    return copy;
+}
+
+char* StringPool::allocate(size_t size) {
+    if (size > mAvailable) {
+        // strings that don't fit in a block get their own, the current block remains in use
+        if (size > mBlockSize / 4) {
+            mBlocks.emplace_back(new char[size]);
+            mAllocatedSize += size;
+            return mBlocks.back().get();
+        }
+        mBlocks.emplace_back(new char[mBlockSize]);
+        mAllocatedSize += mBlockSize;
+        mCurrent = mBlocks.back().get();
+        mAvailable = mBlockSize;
+    }
+    char* const p = mCurrent;
+    mCurrent += size;
+    mAvailable -= size;
+    return p;
+}
+
+} // namespace utils
@@ -330,3 +330,51 @@ TEST(AllocatorTest, STLAllocator) {
 
     EXPECT_EQ(0, arena.getListener().allocations.size());
 }
+
+TEST(AllocatorTest, LinearAllocatorWithFallback) {
+    using Arena = Arena<LinearAllocatorWithFallback, LockingPolicy::NoLock,
+            TrackingPolicy::HighWatermark>;
+    Arena arena("arena", 1024);
+    auto const& allocator = arena.getAllocator();
+
+    struct Object {
+        explicit Object(int* destroyed) : destroyed(destroyed) {}
+        ~Object() { (*destroyed)++; }
+        int* destroyed;
+    };
+    int destroyed = 0;
+
+    {
+        ArenaScope<Arena> scope(arena);
+        void* const p = scope.allocate(1016, 16);
+        EXPECT_FALSE(allocator.isHeapAllocation(p));
+        EXPECT_EQ(allocator.getHeapSize(), 0);
+
+        // doesn't fit, falls back to the heap
+        void* const q = scope.allocate(512, 16);
+        EXPECT_TRUE(allocator.isHeapAllocation(q));
+        EXPECT_EQ(uintptr_t(q) % 16, 0);
+        EXPECT_EQ(allocator.getHeapSize(), 512);
+
+        // objects with a destructor keep their finalizer in front of them
+        Object const* const o = scope.make<Object>(&destroyed);
+        EXPECT_TRUE(allocator.isHeapAllocation((void*)o));
+        EXPECT_GT(allocator.getHeapSize(), 512 + sizeof(Object));
+    }
+
+    // the scope rewound the arena to its beginning, which frees the heap allocations
+    EXPECT_EQ(destroyed, 1);
+    EXPECT_EQ(allocator.getHeapSize(), 0);
+    EXPECT_GE(arena.getListener().getHighWatermark(), 1016 + 512);
+
+    {
+        // an allocation that doesn't fit an empty arena can't be freed by a nested scope
+        ArenaScope<Arena> outer(arena);
+        outer.allocate(2048);
+        {
+            ArenaScope<Arena> inner(arena);
+        }
+        EXPECT_EQ(allocator.getHeapSize(), 2048);
+    }
+    EXPECT_EQ(allocator.getHeapSize(), 0);
+}
@@ -16,7 +16,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "../src/EntityManagerImpl.h"
 #include <utils/NameComponentManager.h>
@@ -128,6 +131,42 @@ TEST(EntityTest, Lots) {
     // at this point, we should be getting indices from the free-list exclusively
 }
 
+TEST(EntityTest, Concurrent) {
+    EntityManagerImpl em;
+    constexpr size_t THREAD_COUNT = 4;
+    constexpr size_t BATCH_SIZE = 512;
+    std::vector<Entity> results[THREAD_COUNT];
+
+    // each thread keeps every other batch, so that indices are recycled while others create them
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREAD_COUNT; t++) {
+        threads.emplace_back([&em, &result = results[t]] {
+            Entity batch[BATCH_SIZE];
+            for (size_t i = 0; i < 16; i++) {
+                em.create(BATCH_SIZE, batch);
+                if (i & 1u) {
+                    result.insert(result.end(), batch, batch + BATCH_SIZE);
+                } else {
+                    em.destroy(BATCH_SIZE, batch);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<uint32_t> indices;
+    for (auto const& result : results) {
+        for (Entity e : result) {
+            EXPECT_TRUE(em.isAlive(e));
+            indices.push_back(EntityManagerImpl::getIndex(e));
+        }
+    }
+    std::sort(indices.begin(), indices.end());
+    EXPECT_EQ(std::adjacent_find(indices.begin(), indices.end()), indices.end());
+    EXPECT_EQ(em.getEntityCount(), indices.size());
+}
 
 TEST(EntityTest, NameComponent) {
 
@@ -176,3 +215,49 @@ TEST(EntityTest, NameComponent) {
 
     cm.gc(em);
 }
+
+TEST(EntityTest, DestroyedJournal) {
+    EntityManagerImpl em;
+    NameComponentManager cm(em);
+
+    std::vector<Entity> entities(100);
+    em.create(entities.size(), entities.data());
+    for (Entity e : entities) {
+        cm.addComponent(e);
+    }
+
+    uint64_t cursor = 0;
+    Entity destroyed[16];
+    size_t count = 16;
+    em.destroy(10, entities.data());
+    EXPECT_TRUE(em.readDestroyedEntities(cursor, destroyed, count));
+    EXPECT_EQ(count, 10);
+    EXPECT_TRUE(std::equal(destroyed, destroyed + count, entities.begin()));
+    count = 16;
+    EXPECT_TRUE(em.readDestroyedEntities(cursor, destroyed, count));
+    EXPECT_EQ(count, 0);
+
+    // only the destroyed entities are removed
+    auto const componentCount = [&cm, &entities] {
+        return std::count_if(entities.begin(), entities.end(),
+                [&cm](Entity e) { return cm.hasComponent(e); });
+    };
+
+    cm.gc(em);
+    EXPECT_EQ(componentCount(), 90);
+    EXPECT_FALSE(cm.hasComponent(entities[9]));
+    EXPECT_TRUE(cm.hasComponent(entities[10]));
+
+    // destroy more entities than the journal holds, gc() falls back to checking every component
+    std::vector<Entity> others(100000);
+    em.create(others.size(), others.data());
+    em.destroy(others.size(), others.data());
+    em.destroy(10, entities.data() + 10);
+    count = 16;
+    EXPECT_FALSE(em.readDestroyedEntities(cursor, destroyed, count));
+    EXPECT_EQ(count, 0);
+    cm.gc(em);
+    EXPECT_EQ(componentCount(), 80);
+    EXPECT_FALSE(cm.hasComponent(entities[19]));
+    EXPECT_TRUE(cm.hasComponent(entities[20]));
+}
@@ -284,6 +284,97 @@ TEST(JobSystem, JobSystemParallelFor) {
     js.emancipate();
 }
 
+TEST(JobSystem, JobSystemManyPendingJobs) {
+    JobSystem js;
+    js.adopt();
+
+    // more jobs than fit in a single segment of job storage
+    std::atomic_int calls = { 0 };
+    JobSystem::Job* root = js.createJob();
+    std::vector<JobSystem::Job*> jobs(40000);
+    for (auto& job : jobs) {
+        job = jobs::createJob(js, root, [&calls] { calls++; });
+        ASSERT_NE(job, nullptr);
+    }
+    for (auto& job : jobs) {
+        js.run(job);
+    }
+    js.runAndWait(root);
+
+    EXPECT_EQ(40000, calls.load());
+
+    js.emancipate();
+}
+
+TEST(JobSystem, JobSystemBackgroundLane) {
+    JobSystem js;
+    js.adopt();
+    if (js.getThreadCount() == 0) {
+        // without worker threads, waiting threads must run background jobs
+        js.emancipate();
+        return;
+    }
+
+    std::atomic_bool released = { false };
+    JobSystem::Job* background = js.runAndRetain(jobs::createJob(js, nullptr, [&released] {
+        while (!released.load()) {
+            std::this_thread::yield();
+        }
+    }), JobSystem::Lane::BACKGROUND);
+
+    // this would never return if we picked up the background job while waiting
+    for (int i = 0; i < 64; i++) {
+        js.runAndWait(js.createJob());
+    }
+
+    released = true;
+    js.waitAndRelease(background);
+
+    js.emancipate();
+}
+
+TEST(JobSystem, JobSystemContinuations) {
+    JobSystem js;
+    js.adopt();
+
+    std::atomic_int step = { 0 };
+    std::atomic_int childCount = { 0 };
+    JobSystem::Job* root = js.createJob();
+    JobSystem::Job* self = nullptr;
+    JobSystem::Job* a = jobs::createJob(js, root, [&] {
+        // the continuation must also wait for the children of its dependency
+        for (int i = 0; i < 16; i++) {
+            js.run(jobs::createJob(js, self, [&childCount] {
+                std::this_thread::yield();
+                childCount++;
+            }));
+        }
+        int expected = 0;
+        step.compare_exchange_strong(expected, 1);
+    });
+    JobSystem::Job* b = jobs::createJob(js, root, [&] {
+        int expected = 1;
+        if (childCount == 16) {
+            step.compare_exchange_strong(expected, 2);
+        }
+    });
+    JobSystem::Job* c = jobs::createJob(js, root, [&] {
+        int expected = 2;
+        step.compare_exchange_strong(expected, 3);
+    });
+
+    js.runAfter(c, b);
+    js.runAfter(b, a);
+    EXPECT_EQ(b, nullptr);
+    self = a;
+    js.run(a);
+    js.runAndWait(root);
+
+    EXPECT_EQ(step, 3);
+
+    js.emancipate();
+}
+
 TEST(JobSystem, JobSystemDelegates) {
     JobSystem js;
     js.adopt();
@@ -342,5 +433,44 @@ TEST(JobSystem, JobSystemDelegates) {
     EXPECT_EQ(4, functor.result);
 
 
+    js.emancipate();
+}
+
+TEST(JobSystem, JobSystemScratchArena) {
+    JobSystem js;
+    js.adopt();
+
+    // allocations made by a job are released when it returns, including the ones that
+    // didn't fit in the arena
+    std::atomic_int failures = { 0 };
+    JobSystem::Job* root = js.createJob();
+    for (size_t i = 0; i < 64; i++) {
+        js.run(jobs::createJob(js, root, [&failures, i] {
+            auto& scratch = JobSystem::getScratchArena();
+            void* const start = scratch.getCurrent();
+            JobSystem::ScratchVector<uint32_t> values(scratch);
+            for (uint32_t j = 0; j < 1024 * (i + 1); j++) {
+                values.push_back(j);
+            }
+            if (values.back() != 1024 * (i + 1) - 1 || scratch.getCurrent() == start) {
+                failures++;
+            }
+        }));
+    }
+    js.runAndWait(root);
+    EXPECT_EQ(0, failures.load());
+
+    // outside of jobs, allocations are scoped explicitly
+    auto& scratch = JobSystem::getScratchArena();
+    void* const start = scratch.getCurrent();
+    {
+        ArenaScope<JobSystem::ScratchArena> scope(scratch);
+        float* data = scope.allocate<float>(1024);
+        ASSERT_NE(data, nullptr);
+        data[1023] = 1.0f;
+        EXPECT_NE(scratch.getCurrent(), start);
+    }
+    EXPECT_EQ(scratch.getCurrent(), start);
+
     js.emancipate();
 }
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <utils/Profiler.h>
+
+#include <string>
+#include <thread>
+
+using namespace utils;
+
+TEST(RegionProfilerTest, Aggregate) {
+    RegionProfiler::reset();
+    {
+        // not counted while disabled
+        RegionProfiler::Scope const scope("outer");
+    }
+
+    RegionProfiler::enable();
+    auto work = [] {
+        for (int i = 0; i < 4; i++) {
+            RegionProfiler::Scope const outer("outer");
+            char name[16] = "inner";    // names don't have to outlive their scope
+            RegionProfiler::Scope const inner(name);
+        }
+    };
+    std::thread thread(work);
+    work();
+    thread.join();
+    RegionProfiler::disable();
+
+    auto const regions = RegionProfiler::getRegions();
+    ASSERT_EQ(2, regions.size());
+    // the outer region includes the inner one
+    EXPECT_EQ(std::string("outer"), regions[0].name.c_str());
+    EXPECT_EQ(std::string("inner"), regions[1].name.c_str());
+    for (auto const& region : regions) {
+        EXPECT_EQ(8, region.count);
+    }
+    EXPECT_GE(regions[0].counters.getInstructions(), regions[1].counters.getInstructions());
+
+    RegionProfiler::reset();
+    EXPECT_TRUE(RegionProfiler::getRegions().empty());
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <utils/EntityManager.h>
+#include <utils/NameComponentManager.h>
+#include <utils/StringPool.h>
+
+#include <string>
+#include <string_view>
+
+using namespace utils;
+
+TEST(StringPool, Intern) {
+    StringPool pool(64);
+    const char* a = pool.intern("foo");
+    const char* b = pool.intern(std::string("foo").c_str());
+    const char* c = pool.intern(std::string_view("foobar", 3));
+    const char* d = pool.intern("bar");
+    EXPECT_STREQ(a, "foo");
+    EXPECT_STREQ(d, "bar");
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(a, c);
+    EXPECT_NE(a, d);
+    EXPECT_EQ(pool.size(), 2);
+    EXPECT_EQ(pool.intern(nullptr), nullptr);
+
+    // strings larger than a block get their own allocation
+    std::string const large(200, 'x');
+    const char* e = pool.intern(large.c_str());
+    EXPECT_EQ(std::string_view(e), large);
+    EXPECT_EQ(pool.intern("foo"), a);
+
+    // the pointers survive a move of the pool
+    StringPool moved(std::move(pool));
+    EXPECT_EQ(moved.intern("bar"), d);
+    EXPECT_EQ(moved.size(), 3);
+}
+
+TEST(NameComponentManager, SharedNames) {
+    EntityManager& em = EntityManager::get();
+    NameComponentManager names(em);
+    Entity e0 = em.create();
+    Entity e1 = em.create();
+    names.addComponent(e0);
+    names.addComponent(e1);
+    names.setName(names.getInstance(e0), "node");
+    names.setName(names.getInstance(e1), std::string("node").c_str());
+
+    const char* name = names.getName(names.getInstance(e0));
+    EXPECT_STREQ(name, "node");
+    EXPECT_EQ(names.getName(names.getInstance(e1)), name);
+
+    names.removeComponent(e0);
+    EXPECT_STREQ(names.getName(names.getInstance(e1)), "node");
+
+    names.setName(names.getInstance(e1), "other");
+    EXPECT_STREQ(names.getName(names.getInstance(e1)), "other");
+    names.setName(names.getInstance(e1), nullptr);
+    EXPECT_EQ(names.getName(names.getInstance(e1)), nullptr);
+
+    names.removeComponent(e1);
+    em.destroy(e0);
+    em.destroy(e1);
+}
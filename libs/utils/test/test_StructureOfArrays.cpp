@@ -183,3 +183,37 @@ TEST(StructureOfArraysTest, MoveOnly) {
     EXPECT_EQ(*soa.elementAt<1>(1).get(), 2);
 }
 
+
+TEST(StructureOfArraysTest, Batched) {
+    BatchedStructureOfArrays<16, uint8_t, float3, float> soa;
+    soa.setCapacity(17);
+    soa.resize(17);
+    EXPECT_EQ(17, soa.capacity());
+
+    // each array is aligned to a cache line and holds a whole number of batches
+    EXPECT_EQ(0, uintptr_t(soa.data<0>()) % CACHELINE_SIZE);
+    EXPECT_EQ(0, uintptr_t(soa.data<1>()) % CACHELINE_SIZE);
+    EXPECT_EQ(0, uintptr_t(soa.data<2>()) % CACHELINE_SIZE);
+    EXPECT_TRUE((void*)soa.data<1>() >= (void*)(soa.data<0>() + 32));
+    EXPECT_TRUE((void*)soa.data<2>() >= (void*)(soa.data<1>() + 32));
+
+    soa.elementAt<2>(16) = 3.0f;
+    soa.setCapacity(40);
+    EXPECT_EQ(3.0f, soa.elementAt<2>(16));
+
+    size_t batchCount = 0;
+    size_t elementCount = 0;
+    soa.forEachBatch<8>([&](size_t first, size_t count) {
+        EXPECT_EQ(batchCount * 8, first);
+        // the padding of the last batch can be written to
+        float* const UTILS_RESTRICT values = soa.data<2>() + first;
+        for (size_t i = 0; i < 8; i++) {
+            values[i] = float(first + i);
+        }
+        batchCount++;
+        elementCount += count;
+    });
+    EXPECT_EQ(3, batchCount);
+    EXPECT_EQ(17, elementCount);
+    EXPECT_EQ(16.0f, soa.elementAt<2>(16));
+}
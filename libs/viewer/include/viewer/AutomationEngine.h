@@ -82,6 +82,21 @@ public:
          * If true, the tick function writes out a settings JSON file before advancing.
          */
         bool exportSettings = false;
+
+        /**
+         * If true, each test is measured over performanceFrameCount additional frames, and the
+         * tick function writes out a JSON performance report before advancing. The report holds
+         * the median and 99th percentile of the CPU frame time, of the CPU stages reported by
+         * Renderer::getFrameTimings(), of the GPU frame time and of each GPU pass. GPU pass
+         * timings are enabled on the Renderer for the duration of the automation.
+         */
+        bool exportPerformance = false;
+
+        /**
+         * Number of frames measured for each test when exportPerformance is true, they're
+         * counted once sleepDuration and minFrameCount have elapsed.
+         */
+        int performanceFrameCount = 60;
     };
 
     /**
@@ -233,9 +248,12 @@ public:
     ~AutomationEngine();
 
 private:
+    struct PerformanceRecord;
+
     AutomationSpec const * const mSpec;
     Settings * const mSettings;
     Options mOptions;
+    PerformanceRecord* mPerformance = nullptr;
 
     Engine* mColorGradingEngine = nullptr;
     ColorGrading* mColorGrading = nullptr;
@@ -19,6 +19,7 @@
 #include <filament/Camera.h>
 #include <filament/Engine.h>
 #include <filament/Renderer.h>
+#include <filament/Scene.h>
 #include <filament/Viewport.h>
 
 #include <backend/PixelBufferDescriptor.h>
@@ -26,9 +27,15 @@
 #include <utils/Log.h>
 #include <utils/Path.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <iomanip>
 #include <fstream>
 #include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 using namespace utils;
 
@@ -97,6 +104,127 @@ static void exportScreenshot(View* view, Renderer* renderer, std::string filenam
             std::move(buffer));
 }
 
+// Samples are in milliseconds.
+struct AutomationEngine::PerformanceRecord {
+    using FrameTimings = Renderer::FrameTimings;
+    using Samples = std::vector<float>;
+
+    Samples cpuFrameTimes;
+    std::array<Samples, FrameTimings::STAGE_COUNT> cpuStageTimes;
+    Samples gpuFrameTimes;
+    std::vector<std::pair<std::string, Samples>> gpuPassTimes; // in execution order
+    uint32_t lastGpuFrameId = 0;
+    bool hasGpuFrame = false;
+    bool gpuPassTimingsWereEnabled = false;
+    size_t renderableCount = 0;
+    backend::StateChangeStats stateChanges;
+
+    void reset() {
+        cpuFrameTimes.clear();
+        for (auto& stage : cpuStageTimes) {
+            stage.clear();
+        }
+        gpuFrameTimes.clear();
+        gpuPassTimes.clear();
+        hasGpuFrame = false;
+    }
+
+    size_t getFrameCount() const { return cpuFrameTimes.size(); }
+
+    void record(Renderer const* renderer, Scene const* scene, float deltaTime) {
+        cpuFrameTimes.push_back(deltaTime * 1000.0f);
+
+        FrameTimings timings;
+        if (renderer->getFrameTimings(&timings, 1)) {
+            for (size_t i = 0; i < FrameTimings::STAGE_COUNT; i++) {
+                cpuStageTimes[i].push_back(float(timings.durations[i]) * 1e-6f);
+            }
+        }
+
+        // GPU timings are a few frames late, and are only recorded once per frame
+        Renderer::GpuPassTiming passes[Renderer::GPU_PASS_TIMINGS_MAX_COUNT];
+        uint32_t frameId = 0;
+        size_t const count = renderer->getGpuPassTimings(passes,
+                Renderer::GPU_PASS_TIMINGS_MAX_COUNT, &frameId);
+        if (count && (!hasGpuFrame || frameId != lastGpuFrameId)) {
+            hasGpuFrame = true;
+            lastGpuFrameId = frameId;
+            float total = 0.0f;
+            for (size_t i = 0; i < count; i++) {
+                float const duration = float(passes[i].duration) * 1e-6f;
+                total += duration;
+                auto pos = std::find_if(gpuPassTimes.begin(), gpuPassTimes.end(),
+                        [name = passes[i].name](auto const& pass) { return pass.first == name; });
+                if (pos == gpuPassTimes.end()) {
+                    gpuPassTimes.emplace_back(passes[i].name, Samples{});
+                    pos = gpuPassTimes.end() - 1;
+                }
+                pos->second.push_back(duration);
+            }
+            gpuFrameTimes.push_back(total);
+        }
+
+        renderableCount = scene ? scene->getRenderableCount() : 0;
+        stateChanges = renderer->getStateChangeStats();
+    }
+
+    // nearest-rank percentile
+    static float percentile(Samples samples, float p) {
+        if (samples.empty()) {
+            return 0.0f;
+        }
+        size_t const rank = size_t(std::ceil(p * float(samples.size())));
+        size_t const index = std::min(samples.size() - 1, rank ? rank - 1 : 0);
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return samples[index];
+    }
+
+    static void writeStats(std::ostream& out, Samples const& samples) {
+        out << "{ \"median\": " << percentile(samples, 0.5f)
+            << ", \"p99\": " << percentile(samples, 0.99f) << " }";
+    }
+
+    void write(std::ostream& out, std::string const& name) const {
+        static constexpr const char* STAGE_NAMES[FrameTimings::STAGE_COUNT] = {
+                "scenePrepare", "culling", "froxelization", "shadowMapUpdate",
+                "commandGeneration", "commandSorting", "frameGraphCompile", "frameGraphExecute",
+                "driverExecute" };
+        static constexpr const char* STATE_NAMES[backend::StateChangeStats::CATEGORY_COUNT] = {
+                "program", "vertexArray", "texture", "sampler", "buffer", "framebuffer",
+                "raster", "viewport", "uniform" };
+
+        out << "{\n";
+        out << "  \"name\": \"" << name << "\",\n";
+        out << "  \"units\": \"ms\",\n";
+        out << "  \"frameCount\": " << getFrameCount() << ",\n";
+        out << "  \"renderableCount\": " << renderableCount << ",\n";
+        out << "  \"cpuFrameTime\": ";
+        writeStats(out, cpuFrameTimes);
+        out << ",\n  \"cpuStages\": {";
+        for (size_t i = 0; i < FrameTimings::STAGE_COUNT; i++) {
+            out << (i ? ",\n" : "\n") << "    \"" << STAGE_NAMES[i] << "\": ";
+            writeStats(out, cpuStageTimes[i]);
+        }
+        out << "\n  },\n  \"gpuFrameTime\": ";
+        writeStats(out, gpuFrameTimes);
+        out << ",\n  \"gpuPasses\": [";
+        for (size_t i = 0; i < gpuPassTimes.size(); i++) {
+            out << (i ? ",\n" : "\n") << "    { \"name\": \"" << gpuPassTimes[i].first
+                << "\", \"time\": ";
+            writeStats(out, gpuPassTimes[i].second);
+            out << " }";
+        }
+        // the state changes of the last frame, these are only tracked by the OpenGL backend
+        out << "\n  ],\n  \"stateChanges\": {";
+        for (size_t i = 0; i < backend::StateChangeStats::CATEGORY_COUNT; i++) {
+            out << (i ? ",\n" : "\n") << "    \"" << STATE_NAMES[i] << "\": { \"issued\": "
+                << stateChanges.issued[i] << ", \"redundant\": "
+                << stateChanges.redundant[i] << " }";
+        }
+        out << "\n  }\n}" << std::endl;
+    }
+};
+
 AutomationEngine* AutomationEngine::createFromJSON(const char* jsonSpec, size_t size) {
     AutomationSpec* spec = AutomationSpec::generate(jsonSpec, size);
     if (!spec) {
@@ -120,6 +248,7 @@ AutomationEngine* AutomationEngine::createDefault() {
 }
 
 AutomationEngine::~AutomationEngine() {
+    delete mPerformance;
     if (mColorGrading) {
         mColorGradingEngine->destroy(mColorGrading);
     }
@@ -201,6 +330,9 @@ void AutomationEngine::tick(Engine* engine, const ViewerContent& content, float
     const auto activateTest = [this, engine, content]() {
         mElapsedTime = 0;
         mElapsedFrames = 0;
+        if (mPerformance) {
+            mPerformance->reset();
+        }
         mSpec->get(mCurrentTest, mSettings);
         viewer::applySettings(engine, mSettings->view, content.view);
         for (size_t i = 0; i < content.materialCount; i++) {
@@ -217,6 +349,14 @@ void AutomationEngine::tick(Engine* engine, const ViewerContent& content, float
                 mIsRunning = true;
                 mRequestStart = false;
                 mCurrentTest = 0;
+                if (mOptions.exportPerformance) {
+                    if (!mPerformance) {
+                        mPerformance = new PerformanceRecord();
+                    }
+                    mPerformance->gpuPassTimingsWereEnabled =
+                            content.renderer->isGpuPassTimingsEnabled();
+                    content.renderer->setGpuPassTimingsEnabled(true);
+                }
                 activateTest();
             }
         }
@@ -230,6 +370,14 @@ void AutomationEngine::tick(Engine* engine, const ViewerContent& content, float
         return;
     }
 
+    // the options can change while running, only measure if we were set up to
+    const bool measurePerformance = mOptions.exportPerformance && mPerformance;
+    if (measurePerformance &&
+            mPerformance->getFrameCount() < size_t(std::max(1, mOptions.performanceFrameCount))) {
+        mPerformance->record(content.renderer, content.scene, deltaTime);
+        return;
+    }
+
     const bool isLastTest = mCurrentTest == mSpec->size() - 1;
 
     const int digits = (int) log10 ((double) mSpec->size()) + 1;
@@ -243,12 +391,25 @@ void AutomationEngine::tick(Engine* engine, const ViewerContent& content, float
         exportSettings(*mSettings, filename.c_str());
     }
 
+    if (measurePerformance) {
+        std::string filename = prefix + ".perf.json";
+        std::ofstream out(filename);
+        if (out) {
+            mPerformance->write(out, prefix);
+        } else {
+            gStatus = "Failed to export performance report.";
+        }
+    }
+
     if (mOptions.exportScreenshots) {
         exportScreenshot(content.view, content.renderer, prefix + ".ppm", isLastTest, this);
     }
 
     if (isLastTest) {
         mIsRunning = false;
+        if (mPerformance) {
+            content.renderer->setGpuPassTimingsEnabled(mPerformance->gpuPassTimingsWereEnabled);
+        }
         if (mBatchModeEnabled && !mOptions.exportScreenshots) {
             mShouldClose = true;
         }
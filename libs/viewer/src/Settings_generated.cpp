@@ -794,6 +794,8 @@ int parse(jsmntok_t const* tokens, int i, const char* jsonChunk, ScreenSpaceRefl
             i = parse(tokens, i + 1, jsonChunk, &out->maxDistance);
         } else if (compare(tok, jsonChunk, "stride") == 0) {
             i = parse(tokens, i + 1, jsonChunk, &out->stride);
+        } else if (compare(tok, jsonChunk, "resolution") == 0) {
+            i = parse(tokens, i + 1, jsonChunk, &out->resolution);
         } else if (compare(tok, jsonChunk, "enabled") == 0) {
             i = parse(tokens, i + 1, jsonChunk, &out->enabled);
         } else {
@@ -814,6 +816,7 @@ std::ostream& operator<<(std::ostream& out, const ScreenSpaceReflectionsOptions&
         << "\"bias\": " << (in.bias) << ",\n"
         << "\"maxDistance\": " << (in.maxDistance) << ",\n"
         << "\"stride\": " << (in.stride) << ",\n"
+        << "\"resolution\": " << (in.resolution) << ",\n"
         << "\"enabled\": " << to_string(in.enabled) << "\n"
         << "}";
 }
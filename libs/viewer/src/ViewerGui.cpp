@@ -863,6 +863,9 @@ void ViewerGui::updateUserInterface() {
         ImGui::SliderFloat("Bias", &ssrefl.bias, 0.001f, 0.5f);
         ImGui::SliderFloat("Max distance", &ssrefl.maxDistance, 0.1, 10.0f);
         ImGui::SliderFloat("Stride", &ssrefl.stride, 1.0, 10.0f);
+        bool halfRes = ssrefl.resolution != 1.0f;
+        ImGui::Checkbox("Half resolution##ssr", &halfRes);
+        ssrefl.resolution = halfRes ? 0.5f : 1.0f;
     }
 
     if (ImGui::CollapsingHeader("Dynamic Resolution")) {
@@ -730,6 +730,7 @@ int main(int argc, char** argv) {
             options.sleepDuration = 0.0;
             options.exportScreenshots = true;
             options.exportSettings = true;
+            options.exportPerformance = true;
             app.automationEngine->setOptions(options);
             app.viewer->stopAnimation();
         }
@@ -820,6 +821,8 @@ int main(int argc, char** argv) {
 
                 ImGui::Checkbox("Export screenshot for each test", &options.exportScreenshots);
                 ImGui::Checkbox("Export settings JSON for each test", &options.exportSettings);
+                ImGui::Checkbox("Export performance report for each test",
+                        &options.exportPerformance);
 
                 automation.setOptions(options);
 
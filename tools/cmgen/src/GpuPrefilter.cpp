@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GpuPrefilter.h"
+
+#include <filament-iblprefilter/IBLPrefilterContext.h>
+
+#include <filament/Engine.h>
+#include <filament/RenderTarget.h>
+#include <filament/Renderer.h>
+#include <filament/Texture.h>
+
+#include <ibl/Image.h>
+
+#include <utils/algorithm.h>
+
+#include <math/vec3.h>
+#include <math/vec4.h>
+
+#include <algorithm>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+using namespace filament;
+using namespace filament::math;
+using namespace filament::ibl;
+
+static constexpr size_t MAX_SAMPLE_COUNT = 2048;
+
+static Cubemap::Face toCubemapFace(size_t index) {
+    // Cubemap::Face and the backend use the same order: +X, -X, +Y, -Y, +Z, -Z
+    return Cubemap::Face(index);
+}
+
+GpuPrefilter::GpuPrefilter(Cubemap const& environment) {
+    mEngine = Engine::create(Engine::Backend::OPENGL);
+    if (!mEngine) {
+        return;
+    }
+
+    // The filters generate the mipmaps of the environment, so it needs all its levels and a
+    // color-renderable format.
+    const uint32_t dim = uint32_t(environment.getDimensions());
+    mEnvironment = Texture::Builder()
+            .sampler(Texture::Sampler::SAMPLER_CUBEMAP)
+            .format(Texture::InternalFormat::RGBA16F)
+            .usage(Texture::Usage::DEFAULT | Texture::Usage::COLOR_ATTACHMENT)
+            .width(dim).height(dim).levels(utils::ctz(dim) + 1)
+            .build(*mEngine);
+
+    const size_t faceSize = size_t(dim) * dim;
+    const size_t size = faceSize * 6 * sizeof(float4);
+    float4* const data = (float4*)malloc(size);
+    for (size_t j = 0; j < 6; j++) {
+        Image const& image = environment.getImageForFace(toCubemapFace(j));
+        float4* const face = data + j * faceSize;
+        for (size_t y = 0; y < dim; y++) {
+            for (size_t x = 0; x < dim; x++) {
+                face[y * dim + x] = float4{ Cubemap::sampleAt(image.getPixelRef(x, y)), 1.0f };
+            }
+        }
+    }
+    mEnvironment->setImage(*mEngine, 0, 0, 0, 0, dim, dim, 6,
+            Texture::PixelBufferDescriptor(data, size,
+                    Texture::Format::RGBA, Texture::Type::FLOAT,
+                    [](void* buffer, size_t, void*) { free(buffer); }));
+}
+
+GpuPrefilter::~GpuPrefilter() {
+    if (mEngine) {
+        mEngine->destroy(mEnvironment);
+        Engine::destroy(&mEngine);
+    }
+}
+
+void GpuPrefilter::roughnessFilter(std::vector<Cubemap>& dst, size_t sampleCount) {
+    const uint32_t dim = uint32_t(dst[0].getDimensions());
+    const uint8_t levels = uint8_t(dst.size());
+
+    Texture* const texture = Texture::Builder()
+            .sampler(Texture::Sampler::SAMPLER_CUBEMAP)
+            .format(Texture::InternalFormat::R11F_G11F_B10F)
+            .usage(Texture::Usage::COLOR_ATTACHMENT | Texture::Usage::SAMPLEABLE)
+            .width(dim).height(dim).levels(levels)
+            .build(*mEngine);
+
+    {
+        IBLPrefilterContext context(*mEngine);
+        IBLPrefilterContext::SpecularFilter filter(context, {
+                .sampleCount = uint16_t(std::min(sampleCount, MAX_SAMPLE_COUNT)),
+                .levelCount = levels });
+        filter(mEnvironment, texture);
+        for (size_t level = 0; level < levels; level++) {
+            readCubemap(texture, level, dst[level]);
+        }
+    }
+
+    mEngine->destroy(texture);
+}
+
+void GpuPrefilter::diffuseIrradiance(Cubemap& dst, size_t sampleCount) {
+    const uint32_t dim = uint32_t(dst.getDimensions());
+
+    Texture* const texture = Texture::Builder()
+            .sampler(Texture::Sampler::SAMPLER_CUBEMAP)
+            .format(Texture::InternalFormat::R11F_G11F_B10F)
+            .usage(Texture::Usage::COLOR_ATTACHMENT | Texture::Usage::SAMPLEABLE)
+            .width(dim).height(dim)
+            .build(*mEngine);
+
+    {
+        IBLPrefilterContext context(*mEngine);
+        IBLPrefilterContext::IrradianceFilter filter(context, {
+                .sampleCount = uint16_t(std::min(sampleCount, MAX_SAMPLE_COUNT)) });
+        filter(mEnvironment, texture);
+        readCubemap(texture, 0, dst);
+    }
+
+    mEngine->destroy(texture);
+}
+
+void GpuPrefilter::readCubemap(Texture* texture, size_t level, Cubemap& dst) {
+    Renderer* const renderer = mEngine->createRenderer();
+    const uint32_t dim = uint32_t(dst.getDimensions());
+    const size_t size = size_t(dim) * dim * sizeof(float4);
+
+    for (size_t j = 0; j < 6; j++) {
+        RenderTarget* const rt = RenderTarget::Builder()
+                .texture(RenderTarget::AttachmentPoint::COLOR, texture)
+                .mipLevel(RenderTarget::AttachmentPoint::COLOR, uint8_t(level))
+                .face(RenderTarget::AttachmentPoint::COLOR, Texture::CubemapFace(j))
+                .build(*mEngine);
+
+        // The faces are read back bottom row first, i.e. y-flipped with respect to how the
+        // environment was uploaded, so we flip them again while copying them into dst.
+        struct ReadBack {
+            Image* image;
+            uint32_t dim;
+        };
+        renderer->readPixels(rt, 0, 0, dim, dim,
+                Texture::PixelBufferDescriptor(malloc(size), size,
+                        Texture::Format::RGBA, Texture::Type::FLOAT,
+                        [](void* buffer, size_t, void* user) {
+                            ReadBack* const readBack = (ReadBack*)user;
+                            float4 const* const data = (float4 const*)buffer;
+                            const uint32_t dim = readBack->dim;
+                            for (size_t y = 0; y < dim; y++) {
+                                float4 const* const row = data + (dim - 1 - y) * dim;
+                                for (size_t x = 0; x < dim; x++) {
+                                    Cubemap::writeAt(readBack->image->getPixelRef(x, y),
+                                            row[x].rgb);
+                                }
+                            }
+                            free(buffer);
+                            delete readBack;
+                        },
+                        new ReadBack{ &dst.getImageForFace(toCubemapFace(j)), dim }));
+
+        mEngine->destroy(rt);
+    }
+
+    // wait for the read-backs and run their callbacks
+    mEngine->flushAndWait();
+    mEngine->pumpMessageQueues();
+    mEngine->destroy(renderer);
+}
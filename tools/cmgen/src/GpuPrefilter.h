@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_GPU_PREFILTER_H
+#define SRC_GPU_PREFILTER_H
+
+#include <ibl/Cubemap.h>
+
+#include <stddef.h>
+
+#include <vector>
+
+namespace filament {
+class Engine;
+class Texture;
+} // namespace filament
+
+/**
+ * Runs the IBL filters of IBLPrefilterContext on a headless Filament engine and reads their
+ * results back into cmgen's cubemaps. On Linux, the engine uses PlatformEGLHeadless when Filament
+ * is built with FILAMENT_SUPPORTS_EGL_ON_LINUX.
+ */
+class GpuPrefilter {
+public:
+    /**
+     * Uploads the base level of an environment. isValid() returns false if no engine could be
+     * created, in which case the CPU filters should be used instead.
+     */
+    explicit GpuPrefilter(filament::ibl::Cubemap const& environment);
+    ~GpuPrefilter();
+
+    GpuPrefilter(GpuPrefilter const&) = delete;
+    GpuPrefilter& operator=(GpuPrefilter const&) = delete;
+
+    bool isValid() const { return mEngine != nullptr; }
+
+    /**
+     * Prefilters one roughness level per cubemap in dst, whose sizes must halve from one level
+     * to the next. Roughness levels are mapped as with CubemapIBL::roughnessFilter.
+     * sampleCount is clamped to 2048.
+     */
+    void roughnessFilter(std::vector<filament::ibl::Cubemap>& dst, size_t sampleCount);
+
+    /**
+     * Computes the diffuse irradiance into dst. sampleCount is clamped to 2048.
+     */
+    void diffuseIrradiance(filament::ibl::Cubemap& dst, size_t sampleCount);
+
+private:
+    void readCubemap(filament::Texture* texture, size_t level, filament::ibl::Cubemap& dst);
+
+    filament::Engine* mEngine = nullptr;
+    filament::Texture* mEnvironment = nullptr;
+};
+
+#endif // SRC_GPU_PREFILTER_H
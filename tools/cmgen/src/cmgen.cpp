@@ -16,6 +16,10 @@
 
 #include "ProgressUpdater.h"
 
+#if CMGEN_ENABLE_GPU
+#include "GpuPrefilter.h"
+#endif
+
 #include <ibl/Cubemap.h>
 #include <ibl/CubemapIBL.h>
 #include <ibl/CubemapSH.h>
@@ -106,6 +110,8 @@ static utils::Path g_deploy_dir;
 
 static size_t g_num_samples = 1024;
 
+static bool g_gpu = false;
+
 static bool g_mirror = false;
 
 // -----------------------------------------------------------------------------------------------
@@ -114,11 +120,12 @@ static void generateMipmaps(utils::JobSystem& js, std::vector<Cubemap>& levels,
         std::vector<Image>& images);
 static void sphericalHarmonics(utils::JobSystem& js, const utils::Path& iname,
         const Cubemap& inputCubemap);
+class GpuPrefilter;
 static void iblRoughnessPrefilter(
         utils::JobSystem& js, const utils::Path& iname, const std::vector<Cubemap>& levels,
-        bool prefilter, const utils::Path& dir);
+        bool prefilter, const utils::Path& dir, GpuPrefilter* gpu);
 static void iblDiffuseIrradiance(utils::JobSystem& js, const utils::Path& iname,
-        const std::vector<Cubemap>& levels, const utils::Path& dir);
+        const std::vector<Cubemap>& levels, const utils::Path& dir, GpuPrefilter* gpu);
 static void iblMipmapPrefilter(utils::JobSystem& js, const utils::Path& iname,
         const std::vector<Image>& images, const std::vector<Cubemap>& levels,
         const utils::Path& dir);
@@ -196,6 +203,11 @@ static void printUsage(char* name) {
             "       Number of samples to use for IBL integrations (default 1024)\n\n"
             "   --ibl-ld=dir\n"
             "       Roughness pre-filter into <dir>\n\n"
+#if CMGEN_ENABLE_GPU
+            "   --gpu\n"
+            "       Roughness pre-filter and diffuse irradiance on the GPU, using a headless\n"
+            "       OpenGL engine. At most 2048 samples are used per level\n\n"
+#endif
             "   --sh-shader\n"
             "       Generate irradiance SH for shader code\n\n"
             "\n"
@@ -273,6 +285,9 @@ static int handleCommandLineArgments(int argc, char* argv[]) {
             { "deploy",               required_argument, nullptr, 'x' },
             { "no-mirror",                  no_argument, nullptr, 'm' },
             { "debug",                      no_argument, nullptr, 'd' },
+#if CMGEN_ENABLE_GPU
+            { "gpu",                        no_argument, nullptr, 'G' },
+#endif
             { nullptr, 0, nullptr, 0 }  // termination of the option list
     };
     int opt;
@@ -452,6 +467,9 @@ static int handleCommandLineArgments(int argc, char* argv[]) {
             case 'm':
                 g_mirror = true;
                 break;
+            case 'G':
+                g_gpu = true;
+                break;
         }
     }
 
@@ -655,18 +673,31 @@ int main(int argc, char* argv[]) {
         iblMipmapPrefilter(js, iname, images, levels, g_is_mipmap_dir);
     }
 
+    GpuPrefilter* gpu = nullptr;
+#if CMGEN_ENABLE_GPU
+    std::unique_ptr<GpuPrefilter> gpuPrefilter;
+    if (g_gpu && (g_prefilter || g_ibl_irradiance)) {
+        gpuPrefilter = std::make_unique<GpuPrefilter>(levels[0]);
+        if (gpuPrefilter->isValid()) {
+            gpu = gpuPrefilter.get();
+        } else {
+            std::cerr << "Unable to create a GPU context, filtering on the CPU." << std::endl;
+        }
+    }
+#endif
+
     if (g_prefilter) {
         if (!g_quiet) {
             std::cout << "IBL prefiltering..." << std::endl;
         }
-        iblRoughnessPrefilter(js, iname, levels, !g_ibl_no_prefilter, g_prefilter_dir);
+        iblRoughnessPrefilter(js, iname, levels, !g_ibl_no_prefilter, g_prefilter_dir, gpu);
     }
 
     if (g_ibl_irradiance) {
         if (!g_quiet) {
             std::cout << "IBL diffuse irradiance..." << std::endl;
         }
-        iblDiffuseIrradiance(js, iname, levels, g_ibl_irradiance_dir);
+        iblDiffuseIrradiance(js, iname, levels, g_ibl_irradiance_dir, gpu);
     }
 
     if (g_extract_faces) {
@@ -920,7 +951,7 @@ static float lodToPerceptualRoughness(float lod) noexcept {
 
 void iblRoughnessPrefilter(
         utils::JobSystem& js, const utils::Path& iname, const std::vector<Cubemap>& levels,
-        bool prefilter, const utils::Path& dir) {
+        bool prefilter, const utils::Path& dir, GpuPrefilter* gpu) {
     utils::Path outputDir = dir.getAbsolutePath();
     if (g_type != OutputType::KTX) {
         outputDir += iname.getNameWithoutExtension();
@@ -958,6 +989,20 @@ void iblRoughnessPrefilter(
         .pixelDepth = 0,
     };
 
+    // On the GPU, all levels are filtered at once, with the same number of samples.
+    std::vector<Image> gpuImages;
+    std::vector<Cubemap> gpuLevels;
+#if CMGEN_ENABLE_GPU
+    if (gpu) {
+        for (size_t level = 0; level < numLevels; level++) {
+            Image image;
+            gpuLevels.push_back(CubemapUtils::create(image, 1U << (baseExp - level)));
+            gpuImages.push_back(std::move(image));
+        }
+        gpu->roughnessFilter(gpuLevels, numSamples);
+    }
+#endif
+
     for (ssize_t i = baseExp; i >= ssize_t((baseExp + 1) - numLevels) ; --i) {
         const size_t dim = 1U << (DEBUG_FULL_RESOLUTION ? baseExp : i); // NOLINT
         const size_t level = baseExp - i;
@@ -981,21 +1026,25 @@ void iblRoughnessPrefilter(
                     << std::endl;
         }
         Image image;
-        Cubemap dst = CubemapUtils::create(image, dim);
+        Cubemap dst = gpu ? std::move(gpuLevels[level]) : CubemapUtils::create(image, dim);
 
-        ProgressUpdater updater(1);
-        if (!g_quiet) {
-            updater.start();
-        }
-        CubemapIBL::roughnessFilter(js, dst, levels, roughness, numSamples,
-                float3{ 1, 1, 1 }, prefilter,
-                [](size_t index, float v, void* userdata) {
-                    if (!g_quiet) {
-                        ((ProgressUpdater*) userdata)->update(index, v);
-                    }
-                }, &updater);
-        if (!g_quiet) {
-            updater.stop();
+        if (gpu) {
+            image = std::move(gpuImages[level]);
+        } else {
+            ProgressUpdater updater(1);
+            if (!g_quiet) {
+                updater.start();
+            }
+            CubemapIBL::roughnessFilter(js, dst, levels, roughness, numSamples,
+                    float3{ 1, 1, 1 }, prefilter,
+                    [](size_t index, float v, void* userdata) {
+                        if (!g_quiet) {
+                            ((ProgressUpdater*) userdata)->update(index, v);
+                        }
+                    }, &updater);
+            if (!g_quiet) {
+                updater.stop();
+            }
         }
 
         dst.makeSeamless();
@@ -1061,7 +1110,7 @@ void iblRoughnessPrefilter(
 }
 
 void iblDiffuseIrradiance(utils::JobSystem& js, const utils::Path& iname,
-        const std::vector<Cubemap>& levels, const utils::Path& dir) {
+        const std::vector<Cubemap>& levels, const utils::Path& dir, GpuPrefilter* gpu) {
     utils::Path outputDir(dir.getAbsolutePath() + iname.getNameWithoutExtension());
     if (!outputDir.exists()) {
         outputDir.mkdirRecursive();
@@ -1077,12 +1126,19 @@ void iblDiffuseIrradiance(utils::JobSystem& js, const utils::Path& iname,
     if (!g_quiet) {
         updater.start();
     }
-    CubemapIBL::diffuseIrradiance(js, dst, levels, numSamples,
-            [](size_t index, float v, void* userdata) {
-                if (!g_quiet) {
-                    ((ProgressUpdater*) userdata)->update(index, v);
-                }
-            }, &updater);
+#if CMGEN_ENABLE_GPU
+    if (gpu) {
+        gpu->diffuseIrradiance(dst, numSamples);
+    } else
+#endif
+    {
+        CubemapIBL::diffuseIrradiance(js, dst, levels, numSamples,
+                [](size_t index, float v, void* userdata) {
+                    if (!g_quiet) {
+                        ((ProgressUpdater*) userdata)->update(index, v);
+                    }
+                }, &updater);
+    }
     if (!g_quiet) {
         updater.stop();
     }
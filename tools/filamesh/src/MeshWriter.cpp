@@ -20,6 +20,8 @@
 
 #include <meshoptimizer.h>
 
+#include <algorithm>
+
 using namespace filamesh;
 using namespace filament::math;
 using namespace std;
@@ -51,8 +53,19 @@ void MeshWriter::optimize(Mesh& mesh) {
     // First, re-order triangles to improve cache locality and reduce the number of VS invocations.
     // Note that assimp already has aiProcess_ImproveCacheLocality, but MeshWriter doesn't know
     // about assimp, and it doesn't hurt to do it again here since this generally runs offline.
-    meshopt_optimizeVertexCache(mesh.indices.data(), mesh.indices.data(), mesh.indices.size(),
-                mesh.vertexCount);
+    // Triangles are then re-ordered to reduce overdraw, without undoing most of the cache gains.
+    // Each part is optimized on its own since its triangles must stay within its index range.
+    vector<float3> positions(mesh.vertexCount);
+    for (uint32_t i = 0; i < mesh.vertexCount; ++i) {
+        const half4 p = (mFlags & INTERLEAVED) ? mesh.vertices[i].position : mesh.positions[i];
+        positions[i] = float3{ p.x, p.y, p.z };
+    }
+    for (Part const& part : mesh.parts) {
+        uint32_t* indices = mesh.indices.data() + part.offset;
+        meshopt_optimizeVertexCache(indices, indices, part.indexCount, mesh.vertexCount);
+        meshopt_optimizeOverdraw(indices, indices, part.indexCount, &positions.data()->x,
+                mesh.vertexCount, sizeof(float3), 1.05f);
+    }
 
     // At this point, triangle order has been established but we still need to shuffle vertices to
     // optimize the fetch. This makes it so that lower-numbered indices generally come before
@@ -90,6 +103,16 @@ void MeshWriter::optimize(Mesh& mesh) {
         }
     }
 
+    // Vertices have been renumbered, so the index range of each part needs to be updated.
+    for (Part& part : mesh.parts) {
+        const uint32_t* indices = mesh.indices.data() + part.offset;
+        if (part.indexCount > 0) {
+            auto [minIndex, maxIndex] = minmax_element(indices, indices + part.indexCount);
+            part.minIndex = *minIndex;
+            part.maxIndex = *maxIndex;
+        }
+    }
+
     // As a last step, the meshoptimizer README recommends applying individual meshopt_quantize*
     // functions as needed, but we actually already quantized the data according to our constraints
     // e.g. we already (potentially) use snorm16 for uvs, half-floats for tangents, etc.
@@ -17,6 +17,7 @@
 #include "matc/CommandlineConfig.h"
 #include "matc/MaterialCompiler.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include <stdlib.h>
@@ -30,9 +31,16 @@ int main(int argc, char** argv) {
         return EXIT_FAILURE;
     }
 
+    // All the input files are compiled by the same compiler, which initializes the shader
+    // compilers and its JobSystem once.
     MaterialCompiler compiler;
-    if (!compiler.compile(config)) {
-        return EXIT_FAILURE;
+    for (size_t i = 0, n = config.getInputCount(); i < std::max(n, size_t(1)); i++) {
+        if (i > 0) {
+            config.selectInput(i);
+        }
+        if (!compiler.compile(config)) {
+            return EXIT_FAILURE;
+        }
     }
     return EXIT_SUCCESS;
 }
@@ -22,6 +22,8 @@
 
 #include <utils/Path.h>
 
+#include <assert.h>
+
 #include <istream>
 #include <sstream>
 #include <string>
@@ -41,6 +43,7 @@ static void usage(char* name) {
             "\n"
             "Usages:\n"
             "    MATC [options] <input-file>\n"
+            "    MATC [options] -o <output-directory> <input-file> [<input-file>...]\n"
             "\n"
             "Supported input formats:\n"
             "    Filament material definition (.mat)\n"
@@ -51,7 +54,14 @@ static void usage(char* name) {
             "   --license\n"
             "       Print copyright and license information\n\n"
             "   --output, -o\n"
-            "       Specify path to output file\n\n"
+            "       Specify path to output file\n"
+            "       With several input files, specify the directory where each output file is\n"
+            "       written, named after its input file\n\n"
+            "   --cache, -C <directory>\n"
+            "       Reuse the packages compiled by previous invocations when neither the material,\n"
+            "       the files it includes, nor the options changed. The cache is kept in the\n"
+            "       specified directory, which can be shared by concurrent invocations.\n"
+            "       Clear it when updating MATC\n\n"
             "   --platform, -p\n"
             "       Shader family to generate: desktop, mobile or all (default)\n\n"
             "   --optimize-size, -S\n"
@@ -179,7 +189,7 @@ static void parseDefine(std::string defineString, Config::StringReplacementMap&
 }
 
 bool CommandlineConfig::parse() {
-    static constexpr const char* OPTSTR = "hLxo:f:dm:a:l:p:D:T:P:OSEr:vV:gtwF1";
+    static constexpr const char* OPTSTR = "hLxo:f:dm:a:l:p:D:T:P:OSEr:vV:gtwF1C:";
     static const struct option OPTIONS[] = {
             { "help",                    no_argument, nullptr, 'h' },
             { "license",                 no_argument, nullptr, 'L' },
@@ -204,6 +214,7 @@ bool CommandlineConfig::parse() {
             { "version",                 no_argument, nullptr, 'v' },
             { "raw",                     no_argument, nullptr, 'w' },
             { "no-sampler-validation",   no_argument, nullptr, 'F' },
+            { "cache",             required_argument, nullptr, 'C' },
             { nullptr, 0, nullptr, 0 }  // termination of the option list
     };
 
@@ -223,7 +234,7 @@ bool CommandlineConfig::parse() {
                 exit(0);
                 break;
             case 'o':
-                mOutput = new FilesystemOutput(arg.c_str());
+                mOutputPath = arg;
                 break;
             case 'f':
                 if (arg == "blob") {
@@ -327,18 +338,49 @@ bool CommandlineConfig::parse() {
             case 'F':
                 mNoSamplerValidation = true;
                 break;
+            case 'C':
+                mCacheDirectory = arg;
+                break;
         }
     }
 
-    if (mArgc - optind > 1) {
-        std::cerr << "Only one input file should be specified on the command line." << std::endl;
+    for (int i = optind; i < mArgc; i++) {
+        mInputPaths.emplace_back(mArgv[i]);
+    }
+
+    if (mInputPaths.size() > 1 && !mOutputPath.empty() &&
+            !utils::Path(mOutputPath).isDirectory()) {
+        std::cerr << "With several input files, the output must be an existing directory."
+                << std::endl;
         return false;
     }
-    if (mArgc - optind > 0) {
-        mInput = new FilesystemInput(mArgv[optind]);
+
+    if (!mInputPaths.empty()) {
+        selectInput(0);
+    } else if (!mOutputPath.empty()) {
+        mOutput = new FilesystemOutput(mOutputPath.c_str());
     }
 
     return true;
 }
 
+void CommandlineConfig::selectInput(size_t index) {
+    assert(index < mInputPaths.size());
+    delete mInput;
+    delete mOutput;
+    mInput = new FilesystemInput(mInputPaths[index].c_str());
+    mOutput = nullptr;
+    if (mOutputPath.empty()) {
+        return;
+    }
+    if (mInputPaths.size() == 1) {
+        mOutput = new FilesystemOutput(mOutputPath.c_str());
+        return;
+    }
+    const char* const extension = mOutputFormat == OutputFormat::C_HEADER ? ".inc" : ".filamat";
+    utils::Path const output = utils::Path(mOutputPath).concat(
+            utils::Path(mInputPaths[index]).getNameWithoutExtension() + extension);
+    mOutput = new FilesystemOutput(output.c_str());
+}
+
 } // namespace matc
@@ -20,6 +20,7 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "Config.h"
 
@@ -114,6 +115,17 @@ public:
         return mInput;
     }
 
+    // Number of input files given on the command line. Each of them is compiled in turn after
+    // being selected with selectInput().
+    size_t getInputCount() const noexcept {
+        return mInputPaths.size();
+    }
+
+    // Makes the given input file, and its output, the ones returned by getInput() and
+    // getOutput(). With several inputs, the output is a file named after the input in the
+    // directory given by --output.
+    void selectInput(size_t index);
+
     std::string toString() const noexcept override {
         std::string parameters;
         for (size_t i = 0 ; i < mArgc; i++) {
@@ -131,6 +143,8 @@ private:
 
     FilesystemInput* mInput = nullptr;
     FilesystemOutput* mOutput = nullptr;
+    std::vector<std::string> mInputPaths;
+    std::string mOutputPath;
 };
 
 } // namespace matc
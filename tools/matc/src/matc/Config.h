@@ -25,6 +25,7 @@
 #include <map>
 #include <memory>
 #include <ostream>
+#include <string>
 
 #include <utils/compiler.h>
 
@@ -143,6 +144,11 @@ public:
         return mFeatureLevel;
     }
 
+    // Directory of the package cache, empty if packages aren't cached.
+    const std::string& getCacheDirectory() const noexcept {
+        return mCacheDirectory;
+    }
+
 protected:
     bool mDebug = false;
     bool mIsValid = true;
@@ -160,6 +166,7 @@ protected:
     StringReplacementMap mMaterialParameters;
     filament::UserVariantFilterMask mVariantFilter = 0;
     bool mIncludeEssl1 = true;
+    std::string mCacheDirectory;
 };
 
 }
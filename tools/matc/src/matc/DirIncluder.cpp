@@ -63,6 +63,10 @@ bool DirIncluder::operator()(const utils::CString& includedBy, filamat::IncludeR
     result.text = utils::CString(contents.c_str());
     result.name = utils::CString(headerPath.c_str());
 
+    if (mIncludes) {
+        mIncludes->push_back(headerPath);
+    }
+
     return true;
 }
 
@@ -21,6 +21,8 @@
 
 #include <utils/Path.h>
 
+#include <vector>
+
 namespace matc {
 
 // Functor callback handler used to resolve includes relative to a root include directory.
@@ -31,10 +33,17 @@ public:
         mIncludeDirectory = dir;
     }
 
+    // Appends the path of every included file to the given list, which must outlive this object
+    // and its copies.
+    void recordIncludes(std::vector<utils::Path>* includes) noexcept {
+        mIncludes = includes;
+    }
+
     bool operator()(const utils::CString& includedBy, filamat::IncludeResult& result);
 
 private:
     utils::Path mIncludeDirectory;
+    std::vector<utils::Path>* mIncludes = nullptr;
 
 };
 
@@ -31,6 +31,7 @@
 #include "MaterialLexer.h"
 #include "JsonishLexer.h"
 #include "JsonishParser.h"
+#include "PackageCache.h"
 #include "ParametersProcessor.h"
 
 #include <GlslangToSpv.h>
@@ -52,6 +53,28 @@ static constexpr const char* CONFIG_KEY_FRAGMENT_SHADER = "fragment";
 static constexpr const char* CONFIG_KEY_COMPUTE_SHADER = "compute";
 static constexpr const char* CONFIG_KEY_TOOL = "tool";
 
+// Hashes the options that change the package compiled from a material.
+static uint64_t hashOptions(const Config& config, uint64_t seed) {
+    auto value = [&seed](auto v) {
+        seed = PackageCache::hash(&v, sizeof(v), seed);
+    };
+    value(config.getPlatform());
+    value(config.getTargetApi());
+    value(config.getOptimizationLevel());
+    value(config.getFeatureLevel());
+    value(config.getVariantFilter());
+    value(config.isDebug());
+    value(config.noSamplerValidation());
+    value(config.includeEssl1());
+    for (auto const& map : { &config.getDefines(), &config.getMaterialParameters() }) {
+        value(uint64_t(map->size()));
+        for (auto const& [key, v] : *map) {
+            seed = PackageCache::hash(v, PackageCache::hash(key, seed));
+        }
+    }
+    return seed;
+}
+
 MaterialCompiler::MaterialCompiler() {
     mConfigProcessor[CONFIG_KEY_MATERIAL] = &MaterialCompiler::processMaterial;
     mConfigProcessor[CONFIG_KEY_VERTEX_SHADER] = &MaterialCompiler::processVertexShader;
@@ -66,6 +89,14 @@ MaterialCompiler::MaterialCompiler() {
     mConfigProcessorJSON[CONFIG_KEY_TOOL] = &MaterialCompiler::ignoreLexemeJSON;
 }
 
+MaterialCompiler::~MaterialCompiler() {
+    if (mJobSystem) {
+        mJobSystem->emancipate();
+        mJobSystem.reset();
+        MaterialBuilder::shutdown();
+    }
+}
+
 bool MaterialCompiler::processMaterial(const MaterialLexeme& jsonLexeme,
         MaterialBuilder& builder) const noexcept  {
 
@@ -368,7 +399,7 @@ bool MaterialCompiler::run(const Config& config) {
         return success;
     }
 
-    MaterialBuilder::init();
+    initialize();
     MaterialBuilder builder;
     // Before attempting an expensive lex, let's find out if we were sent pure JSON.
     bool parsed;
@@ -399,6 +430,20 @@ bool MaterialCompiler::run(const Config& config) {
     DirIncluder includer;
     includer.setIncludeDirectory(materialFilePath.getParent());
 
+    std::unique_ptr<PackageCache> cache;
+    std::vector<Path> includes;
+    uint64_t cacheKey = 0;
+    if (!config.getCacheDirectory().empty()) {
+        cache = std::make_unique<PackageCache>(Path(config.getCacheDirectory()).getAbsolutePath());
+        cacheKey = hashOptions(config, PackageCache::hash(materialFilePath.getPath(),
+                PackageCache::hash(buffer.get(), size_t(size))));
+        Package cached = cache->load(cacheKey);
+        if (cached.isValid()) {
+            return writePackage(cached, config);
+        }
+        includer.recordIncludes(&includes);
+    }
+
     builder
         .noSamplerValidation(config.noSamplerValidation())
         .includeEssl1(config.includeEssl1())
@@ -420,22 +465,27 @@ bool MaterialCompiler::run(const Config& config) {
         return false;
     }
 
-    JobSystem js;
-    js.adopt();
-
     // Write builder.build() to output.
-    Package const package = builder.build(js);
-
-    js.emancipate();
-    MaterialBuilder::shutdown();
+    Package const package = builder.build(*mJobSystem);
 
     if (!package.isValid()) {
         std::cerr << "Could not compile material " << input->getName() << std::endl;
         return false;
     }
+    if (cache && !cache->store(cacheKey, includes, package)) {
+        std::cerr << "Unable to cache material " << input->getName() << std::endl;
+    }
     return writePackage(package, config);
 }
 
+void MaterialCompiler::initialize() {
+    if (!mJobSystem) {
+        MaterialBuilder::init();
+        mJobSystem = std::make_unique<JobSystem>();
+        mJobSystem->adopt();
+    }
+}
+
 bool MaterialCompiler::checkParameters(const Config& config) {
     // Check for input file.
     if (config.getInput() == nullptr) {
@@ -17,6 +17,7 @@
 #ifndef TNT_MATERIALCOMPILER_H
 #define TNT_MATERIALCOMPILER_H
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -26,6 +27,9 @@
 namespace filamat {
 class MaterialBuilder;
 }
+namespace utils {
+class JobSystem;
+}
 class TestMaterialCompiler;
 
 namespace matc {
@@ -34,7 +38,10 @@ class JsonishValue;
 class MaterialCompiler final: public Compiler {
 public:
     MaterialCompiler();
+    ~MaterialCompiler() override;
 
+    // Materials compiled by the same MaterialCompiler share its JobSystem and the initialization
+    // of the shader compilers.
     bool run(const Config& config) override;
 
     bool checkParameters(const Config& config) override;
@@ -72,6 +79,10 @@ private:
 
     bool processMaterialParameters(filamat::MaterialBuilder& builder, const Config& config) const;
 
+    void initialize();
+
+    std::unique_ptr<utils::JobSystem> mJobSystem;
+
     // Member function pointer type, this is used to implement a Command design
     // pattern.
     using MaterialConfigProcessor = bool (MaterialCompiler::*)
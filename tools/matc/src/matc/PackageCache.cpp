@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PackageCache.h"
+
+#include <filament/MaterialEnums.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+namespace matc {
+
+// An entry is a header followed by the path and content hash of each included file, and by the
+// package itself.
+static constexpr uint32_t ENTRY_MAGIC = 0x4354414d; // 'MATC'
+static constexpr uint32_t ENTRY_VERSION = 1;
+
+static bool readFile(const utils::Path& path, std::string& contents) {
+    std::ifstream stream(path.getPath(), std::ios::binary);
+    if (!stream) {
+        return false;
+    }
+    contents.assign((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    return !stream.bad();
+}
+
+template<typename T>
+static bool readValue(std::istream& in, T& value) {
+    return bool(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+template<typename T>
+static void writeValue(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+PackageCache::PackageCache(utils::Path directory) noexcept : mDirectory(std::move(directory)) {
+}
+
+uint64_t PackageCache::hash(const void* data, size_t size, uint64_t seed) noexcept {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t h = seed;
+    for (size_t i = 0; i < size; i++) {
+        h = (h ^ p[i]) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+utils::Path PackageCache::getEntryPath(uint64_t key) const {
+    std::ostringstream name;
+    name << std::hex << key << ".matc";
+    return mDirectory.concat(name.str());
+}
+
+filamat::Package PackageCache::load(uint64_t key) const {
+    std::ifstream in(getEntryPath(key).getPath(), std::ios::binary);
+    if (!in) {
+        return filamat::Package::invalidPackage();
+    }
+
+    uint32_t magic = 0, version = 0, materialVersion = 0, includeCount = 0;
+    if (!readValue(in, magic) || !readValue(in, version) || !readValue(in, materialVersion) ||
+            magic != ENTRY_MAGIC || version != ENTRY_VERSION ||
+            materialVersion != filament::MATERIAL_VERSION || !readValue(in, includeCount)) {
+        return filamat::Package::invalidPackage();
+    }
+
+    std::string contents;
+    for (uint32_t i = 0; i < includeCount; i++) {
+        uint32_t length = 0;
+        uint64_t includeHash = 0;
+        if (!readValue(in, length)) {
+            return filamat::Package::invalidPackage();
+        }
+        std::string path(length, '\0');
+        if (!in.read(path.data(), length) || !readValue(in, includeHash)) {
+            return filamat::Package::invalidPackage();
+        }
+        if (!readFile(utils::Path(path), contents) || hash(contents) != includeHash) {
+            // an included file changed, the material must be compiled again
+            return filamat::Package::invalidPackage();
+        }
+    }
+
+    uint64_t size = 0;
+    if (!readValue(in, size) || size == 0) {
+        return filamat::Package::invalidPackage();
+    }
+    filamat::Package package(size);
+    if (!in.read(reinterpret_cast<char*>(package.getData()), std::streamsize(size))) {
+        return filamat::Package::invalidPackage();
+    }
+    package.setValid(true);
+    return package;
+}
+
+bool PackageCache::store(uint64_t key, const std::vector<utils::Path>& includes,
+        const filamat::Package& package) const {
+    if (!mDirectory.isDirectory() && !mDirectory.mkdirRecursive()) {
+        std::cerr << "Unable to create cache directory '" << mDirectory << "'" << std::endl;
+        return false;
+    }
+
+    // write to a temporary file first, so that concurrent invocations never see partial entries
+    utils::Path const path = getEntryPath(key);
+    utils::Path const temporary(path.getPath() + ".tmp");
+    bool ok = false;
+    {
+        std::ofstream out(temporary.getPath(), std::ios::binary);
+        if (!out) {
+            return false;
+        }
+        writeValue(out, ENTRY_MAGIC);
+        writeValue(out, ENTRY_VERSION);
+        writeValue(out, uint32_t(filament::MATERIAL_VERSION));
+        writeValue(out, uint32_t(includes.size()));
+        std::string contents;
+        for (const auto& include : includes) {
+            if (!readFile(include, contents)) {
+                out.setstate(std::ios::failbit);
+                break;
+            }
+            const std::string& name = include.getPath();
+            writeValue(out, uint32_t(name.size()));
+            out.write(name.data(), std::streamsize(name.size()));
+            writeValue(out, hash(contents));
+        }
+        if (out) {
+            writeValue(out, uint64_t(package.getSize()));
+            out.write(reinterpret_cast<const char*>(package.getData()),
+                    std::streamsize(package.getSize()));
+        }
+        ok = bool(out);
+    }
+    if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace matc
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_PACKAGECACHE_H
+#define TNT_PACKAGECACHE_H
+
+#include <filamat/Package.h>
+
+#include <utils/Path.h>
+
+#include <string>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace matc {
+
+// On-disk cache of compiled packages, used when matc compiles the same materials again. Entries
+// are keyed by a hash of the material source and of the options it's compiled with, and remember
+// the files the material included, so that an entry is only used if none of them changed.
+class PackageCache {
+public:
+    explicit PackageCache(utils::Path directory) noexcept;
+
+    // 64-bits FNV-1a, seeded to chain several hashes
+    static constexpr uint64_t HASH_SEED = 0xcbf29ce484222325ull;
+    static uint64_t hash(const void* data, size_t size, uint64_t seed = HASH_SEED) noexcept;
+    static uint64_t hash(const std::string& s, uint64_t seed = HASH_SEED) noexcept {
+        // the length is included, so that consecutive strings can't alias each other
+        uint64_t const length = s.size();
+        return hash(s.data(), s.size(), hash(&length, sizeof(length), seed));
+    }
+
+    // Returns the package cached with the given key, or an invalid package if there is none or
+    // if one of the files it included has changed.
+    filamat::Package load(uint64_t key) const;
+
+    // Caches a package along with the current content of the files it included.
+    bool store(uint64_t key, const std::vector<utils::Path>& includes,
+            const filamat::Package& package) const;
+
+private:
+    utils::Path getEntryPath(uint64_t key) const;
+
+    utils::Path mDirectory;
+};
+
+} // namespace matc
+
+#endif // TNT_PACKAGECACHE_H
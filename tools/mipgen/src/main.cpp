@@ -24,6 +24,7 @@
 #include <imageio/ImageDecoder.h>
 #include <imageio/ImageEncoder.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Path.h>
 
 #include <getopt/getopt.h>
@@ -324,7 +325,10 @@ int main(int argc, char* argv[]) {
     uint32_t count = getMipmapCount(sourceImage);
     count = g_mipLevelCount == 0 ? count : min(g_mipLevelCount - 1, count);
     vector<LinearImage> miplevels(count);
-    generateMipmaps(sourceImage, g_filter, miplevels.data(), count);
+    JobSystem js;
+    js.adopt();
+    generateMipmaps(sourceImage, g_filter, miplevels.data(), count, &js);
+    js.emancipate();
 
     if (g_ktx1Container) {
         if (!g_quietMode) {
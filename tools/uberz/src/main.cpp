@@ -20,18 +20,16 @@
 
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 
 #include <tsl/robin_map.h>
 
 #include <utils/FixedCapacityVector.h>
-#include <utils/memalign.h>
 
 #include <uberz/ReadableArchive.h>
 #include <uberz/WritableArchive.h>
 
-#include <zstd.h>
-
 using namespace std;
 using namespace utils;
 using namespace filament::uberz;
@@ -171,7 +169,7 @@ int main(int argc, char* argv[]) {
     }
 
     size_t existingMaterialsCount = 0;
-    ReadableArchive* existingArchive = nullptr;
+    std::unique_ptr<ArchiveReader> existingArchive;
 
     // In append mode, the first step is to consume the output file.
     if (g_appendMode) {
@@ -183,15 +181,8 @@ int main(int argc, char* argv[]) {
             cerr << "Unable to consume " << g_outputFile << endl;
             exit(1);
         }
-        const uint64_t decompSize = ZSTD_getFrameContentSize(archiveData, archiveSize);
-        if (decompSize == ZSTD_CONTENTSIZE_UNKNOWN || decompSize == ZSTD_CONTENTSIZE_ERROR) {
-            PANIC_POSTCONDITION("Decompression error.");
-        }
-        uint64_t* basePointer = (uint64_t*) utils::aligned_alloc(decompSize, 8);
-        ZSTD_decompress(basePointer, decompSize, archiveData, archiveSize);
-        existingArchive = (ReadableArchive*) basePointer;
-        convertOffsetsToPointers(existingArchive);
-        existingMaterialsCount = existingArchive->specsCount;
+        existingArchive = std::make_unique<ArchiveReader>(archiveData, archiveSize);
+        existingMaterialsCount = existingArchive->getArchive().specsCount;
     }
 
     WritableArchive outputArchive(existingMaterialsCount + additionalMaterialsCount);
@@ -202,8 +193,9 @@ int main(int argc, char* argv[]) {
             // We do not know where this material was originally consumed from, so just use
             // a made-up string (it is only used for error messages).
             std::string materialName = "mat" + to_string(specIndex);
-            const ArchiveSpec& spec = existingArchive->specs[specIndex];
-            outputArchive.addMaterial(materialName.c_str(), spec.package, spec.packageByteCount);
+            const ArchiveSpec& spec = existingArchive->getArchive().specs[specIndex];
+            FixedCapacityVector<uint8_t> const package = existingArchive->getPackage(specIndex);
+            outputArchive.addMaterial(materialName.c_str(), package.data(), package.size());
             outputArchive.setShadingModel(spec.shadingModel);
             outputArchive.setBlendingModel(spec.blendingMode);
             for (uint16_t flagIndex = 0; flagIndex < spec.flagsCount; ++flagIndex) {
@@ -211,7 +203,7 @@ int main(int argc, char* argv[]) {
                 outputArchive.setFeatureFlag(flag.name, flag.value);
             }
         }
-        utils::aligned_free(existingArchive);
+        existingArchive.reset();
     }
 
     for (int argIndex = optionIndex; argIndex < argc; ++argIndex) {
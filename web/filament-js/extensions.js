@@ -447,6 +447,18 @@ Filament.loadClassExtensions = function() {
         return this._getLevels(engine);
     }
 
+    // Sets the local transform of each entity from a Float32Array of column-major mat4s. The
+    // entities are given as a Uint32Array of ids (see Entity.getId) or as an array of Entity.
+    Filament.TransformManager.prototype.setTransforms = function(entities, matrices) {
+        if (!(entities instanceof Uint32Array)) {
+            entities = Uint32Array.from(entities, (entity) => entity.getId());
+        }
+        const count = Math.min(entities.length, Math.floor(matrices.length / 16));
+        Filament._withHeapView(entities, (ids) => {
+            Filament._withHeapView(matrices, (xforms) => this._setTransforms(ids, xforms, count));
+        });
+    };
+
     Filament.SurfaceOrientation$Builder.prototype.normals = function(buffer, stride = 0) {
         buffer = new Uint8Array(buffer.buffer, buffer.byteOffset, buffer.byteLength);
         this.norPointer = Filament._malloc(buffer.byteLength);
@@ -673,6 +685,12 @@ Filament.loadClassExtensions = function() {
         return Filament.vectorToArray(this._getAssetInstances());
     }
 
+    // Expects a Float32Array of (instance index, animation index, time) triples.
+    Filament.gltfio$FilamentAsset.prototype.applyAnimations = function(states) {
+        const count = Math.floor(states.length / 3);
+        Filament._withHeapView(states, (ptr) => this._applyAnimations(ptr, count));
+    }
+
     Filament.gltfio$FilamentInstance.prototype.getMaterialVariantNames = function() {
         return Filament.vectorToArray(this._getMaterialVariantNames());
     }
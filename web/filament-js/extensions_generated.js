@@ -163,6 +163,7 @@ Filament.loadGeneratedExtensions = function() {
             bias: 0.01,
             maxDistance: 3.0,
             stride: 2.0,
+            resolution: 1.0,
             enabled: false,
         };
         return Object.assign(options, overrides);
@@ -523,6 +523,7 @@ export class TransformManager {
     public destroy(entity: Entity): void;
     public setParent(instance: TransformManager$Instance, parent: TransformManager$Instance): void;
     public setTransform(instance: TransformManager$Instance, xform: mat4): void;
+    public setTransforms(entities: Uint32Array|Entity[], matrices: Float32Array): void;
     public getTransform(instance: TransformManager$Instance): mat4;
     public getWorldTransform(instance: TransformManager$Instance): mat4;
     public openLocalTransformTransaction(): void;
@@ -613,6 +614,8 @@ export class gltfio$FilamentAsset {
     public popRenderable(): Entity;
     public getInstance(): gltfio$FilamentInstance;
     public geAssetInstances(): gltfio$FilamentInstance[];
+    public applyAnimations(states: Float32Array): void;
+    public updateBoneMatrices(): void;
     public getResourceUris(): string[];
     public getBoundingBox(): Aabb;
     public getName(entity: Entity): string;
@@ -1693,7 +1696,7 @@ export interface View$TemporalAntiAliasingOptions {
      */
     enabled?: boolean;
     /**
-     * 4x TAA upscaling. Disables Dynamic Resolution. [BETA]
+     * 4x TAA upscaling, combined with Dynamic Resolution if enabled. [BETA]
      */
     upscaling?: boolean;
     /**
@@ -1749,6 +1752,10 @@ export interface View$ScreenSpaceReflectionsOptions {
      * stride, in texels, for samples along the ray.
      */
     stride?: number;
+    /**
+     * reflections resolution, 0.5 (a quarter of the pixels) or 1.0
+     */
+    resolution?: number;
     enabled?: boolean;
 }
 
@@ -181,6 +181,12 @@ struct BufferDescriptor {
     BufferDescriptor(uint8_t* data, uint32_t size) {
         this->bd.reset(new backend::BufferDescriptor(data, size));
     }
+    // This form adopts a block that JavaScript obtained from _malloc and filled in place, which
+    // avoids a copy. The block is freed by the release callback once the backend is done with it.
+    BufferDescriptor(intptr_t data, uint32_t byteLength) {
+        this->bd.reset(new backend::BufferDescriptor((void*) data, byteLength,
+                [](void* buffer, size_t size, void* user) { free(buffer); }));
+    }
     val getBytes() {
         unsigned char *byteBuffer = (unsigned char*) bd->buffer;
         size_t bufferLength = bd->size;
@@ -1154,6 +1160,29 @@ class_<TransformManager>("TransformManager")
             (TransformManager* self, TransformManager::Instance instance), {
         return flatmat4 { self->getWorldTransform(instance) } ; }), allow_raw_pointers())
 
+    // Sets the local transforms of many entities in a single call. Both pointers reference the
+    // WASM heap: "entities" holds count entity ids and "matrices" holds count column-major mat4s.
+    // Entities without a transform component are skipped. If a local transform transaction is
+    // open, the updates are deferred to its commit.
+    .function("_setTransforms", EMBIND_LAMBDA(void,
+            (TransformManager* self, intptr_t entities, intptr_t matrices, size_t count), {
+        uint32_t const* ids = (uint32_t const*) entities;
+        filament::math::mat4f const* m = (filament::math::mat4f const*) matrices;
+        std::vector<TransformManager::Instance> instances;
+        std::vector<filament::math::mat4f> transforms;
+        instances.reserve(count);
+        transforms.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            TransformManager::Instance const ti =
+                    self->getInstance(utils::Entity::import((int) ids[i]));
+            if (ti) {
+                instances.push_back(ti);
+                transforms.push_back(m[i]);
+            }
+        }
+        self->setTransforms(instances.data(), transforms.data(), instances.size());
+    }), allow_raw_pointers())
+
     .function("openLocalTransformTransaction", &TransformManager::openLocalTransformTransaction)
     .function("commitLocalTransformTransaction",
             &TransformManager::commitLocalTransformTransaction);
@@ -1599,6 +1628,7 @@ class_<utils::EntityManager>("EntityManager")
 /// Clients should use the [Buffer] helper function to contruct BufferDescriptor objects.
 class_<BufferDescriptor>("driver$BufferDescriptor")
     .constructor<uint32_t>()
+    .constructor<intptr_t, uint32_t>()
     /// getBytes ::method:: Gets a view of the WASM heap referenced by the buffer descriptor.
     /// ::retval:: Uint8Array
     .function("getBytes", &BufferDescriptor::getBytes);
@@ -1936,6 +1966,35 @@ class_<FilamentAsset>("gltfio$FilamentAsset")
         return std::vector<FilamentInstance*>(ptr, ptr + self->getAssetInstanceCount());
     }), allow_raw_pointers())
 
+    // Applies one animation to each of several instances in a single call. The pointer references
+    // count float triples in the WASM heap: instance index, animation index and time in seconds.
+    .function("_applyAnimations", EMBIND_LAMBDA(void,
+            (FilamentAsset* self, intptr_t data, size_t count), {
+        float const* triples = (float const*) data;
+        FilamentInstance* const* instances = self->getAssetInstances();
+        size_t const instanceCount = self->getAssetInstanceCount();
+        std::vector<Animator::AnimationState> states;
+        states.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            size_t const instance = (size_t) triples[i * 3 + 0];
+            if (instance < instanceCount) {
+                states.push_back({ instances[instance]->getAnimator(),
+                        (size_t) triples[i * 3 + 1], triples[i * 3 + 2] });
+            }
+        }
+        Animator::applyAnimations(states.data(), states.size());
+    }), allow_raw_pointers())
+
+    /// updateBoneMatrices ::method:: Updates the bone matrices of every instance of the asset.
+    .function("updateBoneMatrices", EMBIND_LAMBDA(void, (FilamentAsset* self), {
+        FilamentInstance* const* instances = self->getAssetInstances();
+        std::vector<Animator*> animators(self->getAssetInstanceCount());
+        for (size_t i = 0; i < animators.size(); i++) {
+            animators[i] = instances[i]->getAnimator();
+        }
+        Animator::updateBoneMatrices(animators.data(), animators.size());
+    }), allow_raw_pointers())
+
     .function("_getResourceUris", EMBIND_LAMBDA(std::vector<std::string>, (FilamentAsset* self), {
         std::vector<std::string> retval;
         auto uris = self->getResourceUris();
@@ -140,6 +140,7 @@ value_object<View::ScreenSpaceReflectionsOptions>("View$ScreenSpaceReflectionsOp
     .field("bias", &View::ScreenSpaceReflectionsOptions::bias)
     .field("maxDistance", &View::ScreenSpaceReflectionsOptions::maxDistance)
     .field("stride", &View::ScreenSpaceReflectionsOptions::stride)
+    .field("resolution", &View::ScreenSpaceReflectionsOptions::resolution)
     .field("enabled", &View::ScreenSpaceReflectionsOptions::enabled)
     ;
 
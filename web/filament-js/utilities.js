@@ -45,6 +45,33 @@ Filament.Buffer = function(typedarray) {
     return bd;
 };
 
+/// HeapBuffer ::function:: Constructs a [BufferDescriptor] that adopts a block of the WASM heap.
+/// ptr ::argument:: Address returned by `Filament._malloc`, already filled in by the client
+/// byteLength ::argument:: Size of the block in bytes
+/// ::retval:: [BufferDescriptor]
+/// The data is not copied; the block is freed once the backend has consumed it, so the client
+/// must not free it or keep views into it after passing the descriptor to Filament.
+Filament.HeapBuffer = function(ptr, byteLength) {
+    console.assert(byteLength > 0);
+    return new Filament.driver$BufferDescriptor(ptr, byteLength);
+};
+
+// Invokes fn with the heap address of the given typed array. Arrays that are already views into
+// the WASM heap are passed through as-is; others are copied into a temporary block.
+Filament._withHeapView = function(typedarray, fn) {
+    if (typedarray.buffer === Filament.HEAPU8.buffer) {
+        return fn(typedarray.byteOffset);
+    }
+    const ptr = Filament._malloc(typedarray.byteLength);
+    try {
+        Filament.HEAPU8.set(new Uint8Array(typedarray.buffer, typedarray.byteOffset,
+                typedarray.byteLength), ptr);
+        return fn(ptr);
+    } finally {
+        Filament._free(ptr);
+    }
+};
+
 /// PixelBuffer ::function:: Constructs a [PixelBufferDescriptor] by copying a typed array into \
 /// the WASM heap.
 /// typedarray ::argument:: Data to consume (e.g. Uint8Array, Uint16Array, Float32Array)